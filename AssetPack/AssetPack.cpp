@@ -0,0 +1,71 @@
+// Packs every file under a directory into one asset archive (see
+// AssetArchive.h); assets are named by their '/'-separated path relative to
+// the directory. Portable; outside Visual Studio it builds with e.g.
+//     g++ -std=c++17 -O2 -I../DX12-Practice AssetPack.cpp
+//         ../DX12-Practice/AssetArchive.cpp ../DX12-Practice/AsyncFileReader.cpp
+//         ../DX12-Practice/LzCodec.cpp ../DX12-Practice/MappedFile.cpp
+
+#include "AssetArchive.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <system_error>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        printf("usage: AssetPack <directory> <output.pak>\n");
+        return 1;
+    }
+
+    std::filesystem::path root = argv[1];
+    std::error_code error;
+    std::vector<std::filesystem::path> files;
+    for (std::filesystem::recursive_directory_iterator it(root, error), end; !error && it != end; it.increment(error))
+    {
+        if (it->is_regular_file(error))
+        {
+            files.push_back(it->path());
+        }
+    }
+    if (error)
+    {
+        fprintf(stderr, "AssetPack: cannot list %s\n", argv[1]);
+        return 1;
+    }
+    // Directory order varies; sorting keeps the output reproducible.
+    std::sort(files.begin(), files.end());
+
+    AssetArchiveWriter writer;
+    for (const std::filesystem::path& path : files)
+    {
+        std::string name = path.lexically_relative(root).generic_string();
+        MappedFile file;
+        bool empty = std::filesystem::file_size(path, error) == 0 && !error;
+        if (!empty && !file.Open(path))
+        {
+            fprintf(stderr, "AssetPack: cannot read %s\n", name.c_str());
+            return 1;
+        }
+        if (!writer.Add(name, file.GetData(), file.GetSize()))
+        {
+            fprintf(stderr, "AssetPack: cannot add %s (name hash collision or too large)\n", name.c_str());
+            return 1;
+        }
+    }
+
+    std::string message;
+    if (!writer.Write(argv[2], &message))
+    {
+        fprintf(stderr, "AssetPack: %s\n", message.c_str());
+        return 1;
+    }
+
+    printf("%s: %u assets (%u duplicates), %.1f MB -> %.1f MB\n", argv[2], writer.GetEntryCount(),
+        writer.GetDuplicateCount(), writer.GetSize() / 1048576.0, writer.GetStoredSize() / 1048576.0);
+    return 0;
+}
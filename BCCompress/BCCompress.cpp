@@ -0,0 +1,280 @@
+// Offline block compressor: reads a TGA, builds the mip chain and writes a
+// BC-compressed DDS (DX10 header). Shares BCEncoder with the renderer and is
+// portable; outside Visual Studio it builds with e.g.
+//     g++ -std=c++17 -O2 -mavx2 -I../DX12-Practice BCCompress.cpp
+//         ../DX12-Practice/BCEncoder.cpp ../DX12-Practice/JobSystem.cpp
+//         ../DX12-Practice/MappedFile.cpp -pthread
+
+#include "BCEncoder.h"
+#include "DdsFormat.h"
+#include "FormatInfo.h"
+#include "JobSystem.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Image
+    {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint8_t> pixels;    // RGBA8
+    };
+
+    struct Options
+    {
+        const char* input = nullptr;
+        const char* output = nullptr;
+        BCFormat format = BCFormat::BC7;
+        BCQuality quality = BCQuality::Normal;
+        bool srgb = false;
+        bool mips = true;
+    };
+
+    void PrintUsage()
+    {
+        printf("usage: BCCompress <input.tga> <output.dds> [--format bc1|bc3|bc4|bc5|bc7]\n"
+               "                  [--quality fast|normal|high] [--srgb] [--no-mips]\n");
+    }
+
+    bool ParseOptions(int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string argument = argv[i];
+            if (argument == "--format" && i + 1 < argc)
+            {
+                std::string value = argv[++i];
+                if (value == "bc1") options.format = BCFormat::BC1;
+                else if (value == "bc3") options.format = BCFormat::BC3;
+                else if (value == "bc4") options.format = BCFormat::BC4;
+                else if (value == "bc5") options.format = BCFormat::BC5;
+                else if (value == "bc7") options.format = BCFormat::BC7;
+                else return false;
+            }
+            else if (argument == "--quality" && i + 1 < argc)
+            {
+                std::string value = argv[++i];
+                if (value == "fast") options.quality = BCQuality::Fast;
+                else if (value == "normal") options.quality = BCQuality::Normal;
+                else if (value == "high") options.quality = BCQuality::High;
+                else return false;
+            }
+            else if (argument == "--srgb")
+            {
+                options.srgb = true;
+            }
+            else if (argument == "--no-mips")
+            {
+                options.mips = false;
+            }
+            else if (!options.input)
+            {
+                options.input = argv[i];
+            }
+            else if (!options.output)
+            {
+                options.output = argv[i];
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return options.input && options.output;
+    }
+
+    // Uncompressed (type 2) or RLE (type 10) true-colour TGA, 24 or 32 bpp.
+    bool LoadTga(const char* path, Image& image)
+    {
+        MappedFile file;
+        if (!file.Open(path) || file.GetSize() < 18)
+        {
+            return false;
+        }
+
+        const uint8_t* header = file.GetData();
+        uint32_t imageType = header[2];
+        uint32_t bytesPerPixel = header[16] / 8;
+        if (header[1] != 0 || (imageType != 2 && imageType != 10) || (bytesPerPixel != 3 && bytesPerPixel != 4))
+        {
+            return false;
+        }
+        image.width = header[12] | (header[13] << 8);
+        image.height = header[14] | (header[15] << 8);
+        bool topDown = (header[17] & 0x20) != 0;
+        image.pixels.resize(size_t(image.width) * image.height * 4);
+
+        const uint8_t* data = header + 18 + header[0];
+        const uint8_t* end = file.GetData() + file.GetSize();
+        size_t pixelCount = size_t(image.width) * image.height;
+        auto store = [&](size_t index, const uint8_t* bgra)
+        {
+            size_t x = index % image.width;
+            size_t y = index / image.width;
+            uint8_t* pixel = &image.pixels[((topDown ? y : image.height - 1 - y) * image.width + x) * 4];
+            pixel[0] = bgra[2];
+            pixel[1] = bgra[1];
+            pixel[2] = bgra[0];
+            pixel[3] = bytesPerPixel == 4 ? bgra[3] : 255;
+        };
+
+        for (size_t index = 0; index < pixelCount;)
+        {
+            uint32_t count = 1;
+            bool repeat = false;
+            if (imageType == 10)
+            {
+                if (data >= end)
+                {
+                    return false;
+                }
+                count = (*data & 0x7f) + 1;
+                repeat = (*data & 0x80) != 0;
+                ++data;
+            }
+            count = static_cast<uint32_t>(std::min<size_t>(count, pixelCount - index));
+
+            size_t needed = repeat ? bytesPerPixel : size_t(count) * bytesPerPixel;
+            if (size_t(end - data) < needed)
+            {
+                return false;
+            }
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                store(index++, repeat ? data : data + i * bytesPerPixel);
+            }
+            data += needed;
+        }
+        return true;
+    }
+
+    float SrgbToLinear(float value)
+    {
+        return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    float LinearToSrgb(float value)
+    {
+        return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    }
+
+    // 2x2 box filter; sRGB colour channels are averaged in linear space.
+    Image Downsample(const Image& source, bool srgb)
+    {
+        Image result;
+        result.width = std::max(1u, source.width / 2);
+        result.height = std::max(1u, source.height / 2);
+        result.pixels.resize(size_t(result.width) * result.height * 4);
+
+        for (uint32_t y = 0; y < result.height; ++y)
+        {
+            for (uint32_t x = 0; x < result.width; ++x)
+            {
+                for (uint32_t c = 0; c < 4; ++c)
+                {
+                    bool linearize = srgb && c < 3;
+                    float sum = 0.0f;
+                    for (uint32_t sample = 0; sample < 4; ++sample)
+                    {
+                        uint32_t sourceX = std::min(x * 2 + (sample & 1), source.width - 1);
+                        uint32_t sourceY = std::min(y * 2 + (sample >> 1), source.height - 1);
+                        float value = source.pixels[(size_t(sourceY) * source.width + sourceX) * 4 + c] / 255.0f;
+                        sum += linearize ? SrgbToLinear(value) : value;
+                    }
+                    float average = sum * 0.25f;
+                    if (linearize)
+                    {
+                        average = LinearToSrgb(average);
+                    }
+                    result.pixels[(size_t(y) * result.width + x) * 4 + c] = static_cast<uint8_t>(average * 255.0f + 0.5f);
+                }
+            }
+        }
+        return result;
+    }
+
+    DXGI_FORMAT GetDxgiFormat(BCFormat format, bool srgb)
+    {
+        constexpr DXGI_FORMAT formats[] = { DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC3_UNORM, DXGI_FORMAT_BC4_UNORM,
+            DXGI_FORMAT_BC5_UNORM, DXGI_FORMAT_BC7_UNORM };
+        DXGI_FORMAT linear = formats[static_cast<uint32_t>(format)];
+        return srgb ? GetSrgbFormat(linear) : linear;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    Image image;
+    if (!LoadTga(options.input, image) || image.width == 0 || image.height == 0)
+    {
+        fprintf(stderr, "BCCompress: cannot read %s\n", options.input);
+        return 1;
+    }
+
+    std::vector<Image> mips;
+    mips.push_back(std::move(image));
+    while (options.mips && (mips.back().width > 1 || mips.back().height > 1))
+    {
+        mips.push_back(Downsample(mips.back(), options.srgb));
+    }
+
+    DdsHeader header = {};
+    header.size = sizeof(DdsHeader);
+    header.flags = c_DdsFlagCaps | c_DdsFlagHeight | c_DdsFlagWidth | c_DdsFlagPixelFormat | c_DdsFlagMipMapCount | c_DdsFlagLinearSize;
+    header.width = mips[0].width;
+    header.height = mips[0].height;
+    header.pitchOrLinearSize = static_cast<uint32_t>(GetBCCompressedSize(options.format, header.width, header.height));
+    header.mipMapCount = static_cast<uint32_t>(mips.size());
+    header.pixelFormat.size = sizeof(DdsPixelFormat);
+    header.pixelFormat.flags = c_DdsPixelFourCC;
+    header.pixelFormat.fourCC = MakeDdsFourCC('D', 'X', '1', '0');
+    header.caps = c_DdsCapsTexture | (mips.size() > 1 ? c_DdsCapsComplex | c_DdsCapsMipMap : 0);
+
+    DdsHeaderDxt10 dxt10 = {};
+    dxt10.dxgiFormat = GetDxgiFormat(options.format, options.srgb);
+    dxt10.resourceDimension = c_DdsDimensionTexture2D;
+    dxt10.arraySize = 1;
+
+    std::vector<uint8_t> output(sizeof(c_DdsMagic) + sizeof(header) + sizeof(dxt10));
+    memcpy(output.data(), &c_DdsMagic, sizeof(c_DdsMagic));
+    memcpy(output.data() + sizeof(c_DdsMagic), &header, sizeof(header));
+    memcpy(output.data() + sizeof(c_DdsMagic) + sizeof(header), &dxt10, sizeof(dxt10));
+
+    JobSystem jobs;
+    double pixelCount = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (const Image& mip : mips)
+    {
+        pixelCount += double(mip.width) * mip.height;
+        size_t offset = output.size();
+        output.resize(offset + GetBCCompressedSize(options.format, mip.width, mip.height));
+        BCImage source = { mip.pixels.data(), mip.width, mip.height, size_t(mip.width) * 4 };
+        CompressImage(source, options.format, options.quality, &jobs, output.data() + offset);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!WriteFileAtomic(options.output, output.data(), output.size()))
+    {
+        fprintf(stderr, "BCCompress: cannot write %s\n", options.output);
+        return 1;
+    }
+
+    printf("%s: %ux%u, %zu mips, %.1f MPixel/s\n", options.output, header.width, header.height, mips.size(),
+        pixelCount / seconds / 1e6);
+    return 0;
+}
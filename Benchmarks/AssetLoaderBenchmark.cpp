@@ -0,0 +1,198 @@
+// Asset streaming through AssetLoader: every asset of an archive is loaded
+// at background priority while Update() runs once per simulated frame, and
+// a few visible-priority requests arrive once the pipeline is full. Reports
+// throughput and the load latency of each priority, first with the archive
+// in the page cache and then behind a simulated slow disk (serial seeks and
+// limited bandwidth), where the priority queues have to earn their keep.
+
+#include "Check.h"
+#include "Measure.h"
+
+#include "AssetArchive.h"
+#include "AssetLoader.h"
+#include "JobSystem.h"
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Copies finish as soon as they are submitted.
+    class ImmediateUploadQueue : public UploadQueue
+    {
+    public:
+        uint64_t Submit() override { return ++m_FenceValue; }
+        bool IsComplete(uint64_t fenceValue) const override { return fenceValue <= m_FenceValue; }
+
+    private:
+        uint64_t m_FenceValue = 0;
+    };
+
+    struct DeviceDesc
+    {
+        const char* name;
+        std::chrono::microseconds latency;
+        uint64_t bytesPerSecond;
+    };
+
+    // Random bytes with repeats of earlier runs mixed in, so LZ compresses
+    // them about as well as typical mesh or texture data.
+    std::vector<uint8_t> MakeAssetData(uint32_t size, uint32_t seed)
+    {
+        std::mt19937 random(seed);
+        std::vector<uint8_t> data(size);
+        for (uint32_t i = 0; i < size;)
+        {
+            uint32_t run = std::min<uint32_t>(size - i, 8 + random() % 24);
+            if (i >= 256 && random() % 2)
+            {
+                uint32_t from = i - 1 - random() % 256;
+                for (uint32_t j = 0; j < run; ++j)
+                {
+                    data[i + j] = data[from + j];
+                }
+            }
+            else
+            {
+                for (uint32_t j = 0; j < run; ++j)
+                {
+                    data[i + j] = static_cast<uint8_t>(random());
+                }
+            }
+            i += run;
+        }
+        return data;
+    }
+
+    double Percentile(std::vector<double> values, double fraction)
+    {
+        if (values.empty())
+        {
+            return 0.0;
+        }
+        std::sort(values.begin(), values.end());
+        return values[static_cast<size_t>(fraction * (values.size() - 1) + 0.5)];
+    }
+
+    bool Run(const std::filesystem::path& path, const DeviceDesc& device, uint32_t assetCount, uint32_t visibleCount,
+        JobSystem& jobs)
+    {
+        AssetArchive archive;
+        std::string error;
+        if (!archive.Open(path, &error))
+        {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return false;
+        }
+        archive.GetReader().SetSimulatedDevice(device.latency, device.bytesPerSecond);
+
+        ImmediateUploadQueue uploads;
+        AssetLoader loader(archive, jobs, uploads);
+        std::vector<uint8_t> staging;
+        uint64_t uploadedBytes = 0;
+        AssetUploader uploader = [&](std::vector<uint8_t>& data)
+        {
+            staging.assign(data.begin(), data.end());
+            uploadedBytes += data.size();
+            return true;
+        };
+
+        struct Load
+        {
+            AssetLoadHandle handle;
+            Clock::time_point start;
+            bool visible;
+            bool done;
+        };
+        std::vector<Load> loads;
+        Clock::time_point start = Clock::now();
+        for (uint32_t i = 0; i < assetCount; ++i)
+        {
+            std::string name = "asset" + std::to_string(i);
+            loads.push_back({ loader.Load(name.c_str(), AssetPriority::Background, uploader), start, false, false });
+        }
+
+        // Visible requests for assets near the end of the background queue
+        // arrive a few frames in, when reads are already in flight.
+        const auto frameTime = std::chrono::milliseconds(1);
+        std::vector<double> backgroundMs;
+        std::vector<double> visibleMs;
+        uint32_t failed = 0;
+        uint32_t remaining = assetCount + visibleCount;
+        for (uint32_t frame = 0; remaining; ++frame)
+        {
+            if (frame == 5)
+            {
+                for (uint32_t i = 0; i < visibleCount; ++i)
+                {
+                    std::string name = "asset" + std::to_string(assetCount - 1 - i);
+                    loads.push_back({ loader.Load(name.c_str(), AssetPriority::Visible, uploader), Clock::now(), true, false });
+                }
+            }
+            loader.Update();
+
+            Clock::time_point now = Clock::now();
+            for (Load& load : loads)
+            {
+                AssetLoadState state = load.done ? AssetLoadState::Invalid : loader.GetState(load.handle);
+                if (state == AssetLoadState::Complete || state == AssetLoadState::Failed)
+                {
+                    double ms = std::chrono::duration<double, std::milli>(now - load.start).count();
+                    (load.visible ? visibleMs : backgroundMs).push_back(ms);
+                    failed += state == AssetLoadState::Failed ? 1 : 0;
+                    load.done = true;
+                    --remaining;
+                }
+            }
+            std::this_thread::sleep_for(frameTime);
+        }
+        double totalMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        std::printf("%s: %u assets, %.1f MB unpacked\n", device.name, assetCount, uploadedBytes / 1048576.0);
+        std::printf("  total %10.1fms %8.1f MB/s\n", totalMs, uploadedBytes / 1048576.0 / (totalMs / 1000.0));
+        std::printf("  background latency p50 %8.1fms p99 %8.1fms max %8.1fms\n", Percentile(backgroundMs, 0.5),
+            Percentile(backgroundMs, 0.99), Percentile(backgroundMs, 1.0));
+        std::printf("  visible    latency p50 %8.1fms p99 %8.1fms max %8.1fms\n", Percentile(visibleMs, 0.5),
+            Percentile(visibleMs, 0.99), Percentile(visibleMs, 1.0));
+        return failed == 0 && visibleMs.size() == visibleCount;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick = IsQuickRun(argc, argv);
+    const uint32_t assetCount = quick ? 64 : 2048;
+    const uint32_t assetSize = 64 * 1024;
+
+    std::filesystem::path path = MakeTestDirectory("AssetLoaderBenchmark") / "assets.pak";
+    AssetArchiveWriter writer;
+    for (uint32_t i = 0; i < assetCount; ++i)
+    {
+        std::vector<uint8_t> data = MakeAssetData(assetSize, i);
+        writer.Add("asset" + std::to_string(i), data.data(), data.size());
+    }
+    std::string error;
+    if (!writer.Write(path, &error))
+    {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    std::printf("archive: %.1f MB stored for %.1f MB\n", writer.GetStoredSize() / 1048576.0, writer.GetSize() / 1048576.0);
+
+    JobSystem jobs;
+    // A hard disk: a few milliseconds to seek, one read at a time.
+    const DeviceDesc pageCache = { "page cache", std::chrono::microseconds(0), 0 };
+    const DeviceDesc slowDisk = { "slow disk (4ms, 150 MB/s)", std::chrono::microseconds(4000), 150ull << 20 };
+    bool ok = Run(path, pageCache, assetCount, 8, jobs);
+    ok = Run(path, slowDisk, quick ? 16 : 256, 8, jobs) && ok;
+
+    if (!ok)
+    {
+        std::fprintf(stderr, "assets failed to load\n");
+    }
+    return ok ? 0 : 1;
+}
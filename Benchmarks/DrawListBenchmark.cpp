@@ -0,0 +1,69 @@
+// Radix sort of draw items against std::sort and std::stable_sort, single
+// threaded and on the job system, for scene-like keys (few layers and
+// pipelines, many materials, random depth).
+
+#include "Measure.h"
+
+#include "DrawList.h"
+#include "JobSystem.h"
+
+#include <random>
+
+namespace
+{
+    std::vector<DrawItem> MakeItems(uint32_t count)
+    {
+        std::mt19937 random(count);
+        std::uniform_real_distribution<float> depth(0.0f, 1.0f);
+        std::vector<DrawItem> items(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            items[i] = { DrawKey::Make(random() % 4, random() % 64, random() % 4096, depth(random)), i };
+        }
+        return items;
+    }
+
+    bool IsSorted(const std::vector<DrawItem>& items)
+    {
+        return std::is_sorted(items.begin(), items.end(), [](const DrawItem& a, const DrawItem& b) { return a.key < b.key; });
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick = IsQuickRun(argc, argv);
+    const uint32_t repeats = quick ? 1 : 9;
+
+    JobSystem jobs;
+    std::printf("%10s %12s %12s %12s %12s\n", "items", "std::sort", "stable_sort", "radix", "radix+jobs");
+
+    bool ok = true;
+    for (uint32_t count : { 10000u, 100000u, 1000000u })
+    {
+        if (quick && count > 10000)
+        {
+            break;
+        }
+
+        const std::vector<DrawItem> input = MakeItems(count);
+        std::vector<DrawItem> items;
+        std::vector<DrawItem> scratch;
+        auto reset = [&]() { items = input; };
+        auto less = [](const DrawItem& a, const DrawItem& b) { return a.key < b.key; };
+
+        double sortMs = MeasureMs(repeats, reset, [&]() { std::sort(items.begin(), items.end(), less); });
+        double stableMs = MeasureMs(repeats, reset, [&]() { std::stable_sort(items.begin(), items.end(), less); });
+        double radixMs = MeasureMs(repeats, reset, [&]() { RadixSortDrawItems(items, scratch, nullptr); });
+        ok = ok && IsSorted(items);
+        double jobsMs = MeasureMs(repeats, reset, [&]() { RadixSortDrawItems(items, scratch, &jobs); });
+        ok = ok && IsSorted(items);
+
+        std::printf("%10u %10.3fms %10.3fms %10.3fms %10.3fms\n", count, sortMs, stableMs, radixMs, jobsMs);
+    }
+
+    if (!ok)
+    {
+        std::fprintf(stderr, "radix sort produced unsorted output\n");
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,170 @@
+// Per-frame transform integration over 1M entities: chunked structure-of-
+// arrays iteration through EntityStore::ForEach (single threaded and on the
+// job system) against per-entity lookups and against a heap-allocated
+// object per entity, the layout the store replaces. Also times creating
+// and destroying entities, and adding and removing a component, which moves
+// the entity to another archetype.
+
+#include "Measure.h"
+
+#include "EntityStore.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+
+namespace
+{
+    struct Position
+    {
+        float x, y, z;
+    };
+
+    struct Velocity
+    {
+        float x, y, z;
+    };
+
+    struct Health
+    {
+        float value;
+    };
+
+    // Object-per-entity baseline: components next to unrelated state, each
+    // object a separate allocation.
+    struct GameObject
+    {
+        Position position;
+        float name[16];
+        Velocity velocity;
+        Health health;
+    };
+
+    const float c_TimeStep = 1.0f / 60.0f;
+}
+
+int main(int argc, char** argv)
+{
+    bool quick = IsQuickRun(argc, argv);
+    const uint32_t count = quick ? 20000 : 1000000;
+    const uint32_t repeats = quick ? 1 : 11;
+
+    std::mt19937 random(5);
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+
+    EntityStore store;
+    std::vector<Entity> entities;
+    std::vector<std::unique_ptr<GameObject>> objects;
+    double createMs = MeasureMs(1, [&]()
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            // A third of the entities also have Health, so two archetypes match.
+            Position position = { value(random), value(random), value(random) };
+            Velocity velocity = { value(random), value(random), value(random) };
+            entities.push_back(i % 3 ? store.Create(position, velocity) : store.Create(position, velocity, Health{ 1.0f }));
+        }
+    });
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        objects.push_back(std::make_unique<GameObject>());
+        objects.back()->position = *store.Get<Position>(entities[i]);
+        objects.back()->velocity = *store.Get<Velocity>(entities[i]);
+    }
+    // Allocation order no longer matches iteration order after churn.
+    std::shuffle(objects.begin(), objects.end(), random);
+
+    JobSystem jobs;
+    auto integrate = [](ChunkView& chunk)
+    {
+        Position* positions = chunk.GetMutable<Position>();
+        const Velocity* velocities = chunk.Get<Velocity>();
+        for (uint32_t i = 0; i < chunk.GetCount(); ++i)
+        {
+            positions[i].x += velocities[i].x * c_TimeStep;
+            positions[i].y += velocities[i].y * c_TimeStep;
+            positions[i].z += velocities[i].z * c_TimeStep;
+        }
+    };
+
+    double chunkMs = MeasureMs(repeats, [&]() { store.ForEach<Position, Velocity>(nullptr, integrate); });
+    double chunkJobsMs = MeasureMs(repeats, [&]() { store.ForEach<Position, Velocity>(&jobs, integrate); });
+    double lookupMs = MeasureMs(repeats, [&]()
+    {
+        for (Entity entity : entities)
+        {
+            Position* position = store.GetMutable<Position>(entity);
+            const Velocity* velocity = store.Get<Velocity>(entity);
+            position->x += velocity->x * c_TimeStep;
+            position->y += velocity->y * c_TimeStep;
+            position->z += velocity->z * c_TimeStep;
+        }
+    });
+    double objectMs = MeasureMs(repeats, [&]()
+    {
+        for (auto& object : objects)
+        {
+            object->position.x += object->velocity.x * c_TimeStep;
+            object->position.y += object->velocity.y * c_TimeStep;
+            object->position.z += object->velocity.z * c_TimeStep;
+        }
+    });
+
+    // Entities without Health gain it and lose it again.
+    uint32_t moved = 0;
+    double addMs = MeasureMs(1, [&]()
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (i % 3)
+            {
+                store.Add(entities[i], Health{ 1.0f });
+                ++moved;
+            }
+        }
+    });
+    uint32_t withHealth = 0;
+    store.ForEach<Health>(nullptr, [&](ChunkView& chunk) { withHealth += chunk.GetCount(); });
+    double removeMs = MeasureMs(1, [&]()
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (i % 3)
+            {
+                store.Remove<Health>(entities[i]);
+            }
+        }
+    });
+
+    uint32_t chunkCount = store.GetChunkCount();
+    double destroyMs = MeasureMs(1, [&]()
+    {
+        for (Entity entity : entities)
+        {
+            store.Destroy(entity);
+        }
+    });
+
+    std::printf("%u entities in %u chunks\n", count, chunkCount);
+    std::printf("%-24s %10.3fms\n", "create", createMs);
+    std::printf("%-24s %10.3fms\n", "ForEach", chunkMs);
+    std::printf("%-24s %10.3fms\n", "ForEach + jobs", chunkJobsMs);
+    std::printf("%-24s %10.3fms\n", "per-entity lookup", lookupMs);
+    std::printf("%-24s %10.3fms\n", "object per entity", objectMs);
+    std::printf("%-24s %10.3fms %8.1f Mentities/s\n", "add component", addMs, moved / addMs / 1000.0);
+    std::printf("%-24s %10.3fms %8.1f Mentities/s\n", "remove component", removeMs, moved / removeMs / 1000.0);
+    std::printf("%-24s %10.3fms\n", "destroy", destroyMs);
+
+    bool ok = withHealth == count;
+    if (!ok)
+    {
+        std::fprintf(stderr, "%u of %u entities have Health after adding it to all\n", withHealth, count);
+    }
+    if (store.GetEntityCount() != 0)
+    {
+        std::fprintf(stderr, "entities left after destroying all of them\n");
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+// Frustum culling of 1M objects: the scalar reference loop against the
+// SSE2 and AVX2 paths (whichever the CPU has), single threaded and on the
+// job system. The camera sees about a sixth of the scene.
+
+#include "Measure.h"
+
+#include "FrustumCulling.h"
+#include "JobSystem.h"
+
+#include <random>
+#include <string>
+
+namespace
+{
+    const char* GetName(CullingSimd simd)
+    {
+        switch (simd)
+        {
+        case CullingSimd::Sse2: return "sse2";
+        case CullingSimd::Avx2: return "avx2";
+        default: return "none";
+        }
+    }
+
+    // Perspective looking down +z with a 90 degree field of view, near 1,
+    // far 1000, in DirectXMath's row-vector convention.
+    Frustum MakeCamera()
+    {
+        const float n = 1.0f;
+        const float f = 1000.0f;
+        const float projection[4][4] = {
+            { 1, 0, 0, 0 },
+            { 0, 1, 0, 0 },
+            { 0, 0, f / (f - n), 1 },
+            { 0, 0, -n * f / (f - n), 0 },
+        };
+        return Frustum::FromViewProjection(projection);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick = IsQuickRun(argc, argv);
+    const uint32_t count = quick ? 20000 : 1000000;
+    const uint32_t repeats = quick ? 1 : 15;
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> position(-1000.0f, 1000.0f);
+    std::uniform_real_distribution<float> size(0.5f, 5.0f);
+    CullingScene scene;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        float center[3] = { position(random), position(random), position(random) };
+        float half = size(random);
+        float boxMin[3] = { center[0] - half, center[1] - half, center[2] - half };
+        float boxMax[3] = { center[0] + half, center[1] + half, center[2] + half };
+        scene.Add(center, half * 1.7320508f, boxMin, boxMax);
+    }
+
+    Frustum frustum = MakeCamera();
+    JobSystem jobs;
+    std::vector<uint32_t> expected;
+    std::vector<uint32_t> visible;
+
+    double scalarMs = MeasureMs(repeats, [&]() { scene.CullScalar(frustum, expected); });
+    std::printf("%u objects, %zu visible, best instruction set %s\n", count, expected.size(), GetName(GetCullingSimd()));
+    std::printf("%-12s %10.3fms %8.1f Mobjects/s\n", "scalar", scalarMs, count / scalarMs / 1000.0);
+
+    bool ok = true;
+    CullingSimd best = GetCullingSimd();
+    for (CullingSimd simd : { CullingSimd::None, CullingSimd::Sse2, CullingSimd::Avx2 })
+    {
+        if (simd > best)
+        {
+            break;
+        }
+        SetCullingSimd(simd);
+
+        double ms = MeasureMs(repeats, [&]() { scene.Cull(frustum, nullptr, visible); });
+        ok = ok && visible == expected;
+        double jobsMs = MeasureMs(repeats, [&]() { scene.Cull(frustum, &jobs, visible); });
+        ok = ok && visible == expected;
+
+        std::printf("%-12s %10.3fms %8.1f Mobjects/s  %5.2fx\n", GetName(simd), ms, count / ms / 1000.0, scalarMs / ms);
+        std::printf("%-12s %10.3fms %8.1f Mobjects/s  %5.2fx\n", (std::string(GetName(simd)) + "+jobs").c_str(), jobsMs,
+            count / jobsMs / 1000.0, scalarMs / jobsMs);
+    }
+    SetCullingSimd(CullingSimd::Best);
+
+    if (!ok)
+    {
+        std::fprintf(stderr, "SIMD culling differs from the scalar loop\n");
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// --quick shrinks the problem sizes so that ctest can run every benchmark.
+inline bool IsQuickRun(int argc, char** argv)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--quick") == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Runs setup() and then func() repeats times and returns the median time
+// of func in milliseconds; setup is not timed.
+template<typename Setup, typename Func>
+double MeasureMs(uint32_t repeats, Setup&& setup, Func&& func)
+{
+    std::vector<double> times;
+    for (uint32_t i = 0; i < std::max<uint32_t>(1, repeats); ++i)
+    {
+        setup();
+        auto start = std::chrono::steady_clock::now();
+        func();
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+template<typename Func>
+double MeasureMs(uint32_t repeats, Func&& func)
+{
+    return MeasureMs(repeats, []() {}, func);
+}
+
+// Keeps the compiler from dropping a computation whose result is unused.
+template<typename T>
+inline void KeepResult(const T& value)
+{
+#if defined(__GNUC__)
+    // An empty asm that claims to read value; costs no instructions.
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile T s_Sink;
+    s_Sink = value;
+#endif
+}
@@ -0,0 +1,92 @@
+// Mesh simplification of a dense sphere and a bumpy grid: time to reach
+// half and a tenth of the triangles on one thread and split into chunks on
+// the job system, the geometric error reached, a full LOD chain, and LOD
+// selection for many instances.
+
+#include "Measure.h"
+#include "TestMeshes.h"
+
+#include "JobSystem.h"
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <thread>
+
+namespace
+{
+    bool Run(const char* name, const TestMesh& mesh, JobSystem& jobs, uint32_t repeats)
+    {
+        SimplifyInput input;
+        input.vertices = mesh.positions.data();
+        input.vertexStride = 12;
+        input.vertexCount = mesh.GetVertexCount();
+
+        bool ok = true;
+        std::printf("%s: %u triangles, %u vertices\n", name, mesh.GetTriangleCount(), mesh.GetVertexCount());
+        for (uint32_t divisor : { 2u, 10u })
+        {
+            uint32_t target = static_cast<uint32_t>(mesh.indices.size() / divisor) / 3 * 3;
+            for (JobSystem* pool : { static_cast<JobSystem*>(nullptr), &jobs })
+            {
+                std::vector<uint32_t> result;
+                float error = 0.0f;
+                double ms = MeasureMs(repeats, [&]()
+                {
+                    SimplifyMesh(input, mesh.indices, target, FLT_MAX, pool, result, &error);
+                });
+                std::printf("  1/%-2u %-7s %10.3fms %8.2f Mtriangles/s, %u triangles left, error %.5f\n", divisor,
+                    pool ? "jobs" : "single", ms, mesh.GetTriangleCount() / ms / 1000.0,
+                    static_cast<uint32_t>(result.size() / 3), error);
+                ok = ok && !result.empty() && result.size() <= target;
+            }
+        }
+
+        std::vector<MeshLod> lods;
+        double chainMs = MeasureMs(repeats, [&]() { BuildLodChain(input, mesh.indices, 8, 0.5f, &jobs, lods); });
+        std::printf("  LOD chain  %10.3fms, %zu levels:", chainMs, lods.size());
+        for (const MeshLod& lod : lods)
+        {
+            std::printf(" %zu", lod.indices.size() / 3);
+        }
+        std::printf(" triangles\n");
+        ok = ok && lods.size() > 1;
+
+        std::vector<float> errors;
+        for (const MeshLod& lod : lods)
+        {
+            errors.push_back(lod.error);
+        }
+        const uint32_t instanceCount = repeats > 1 ? 1000000 : 10000;
+        std::vector<float> distances(instanceCount);
+        for (uint32_t i = 0; i < instanceCount; ++i)
+        {
+            distances[i] = 1.0f + 0.001f * static_cast<float>((i * 2654435761u) % 100000);
+        }
+        std::vector<uint8_t> selected(instanceCount);
+        double selectMs = MeasureMs(repeats, [&]()
+        {
+            SelectLods(errors.data(), static_cast<uint32_t>(errors.size()), distances.data(), instanceCount,
+                GetLodProjectionScale(1.0f, 1080.0f), 1.0f, selected.data());
+            KeepResult(selected[instanceCount / 2]);
+        });
+        std::printf("  select LOD %10.3fms for %u instances\n", selectMs, instanceCount);
+        return ok;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick = IsQuickRun(argc, argv);
+    const uint32_t repeats = quick ? 1 : 3;
+
+    JobSystem jobs(std::max(1u, std::thread::hardware_concurrency() - 1));
+    bool ok = Run("sphere", quick ? MakeSphereMesh(32, 64) : MakeSphereMesh(256, 512), jobs, repeats);
+    ok = Run("grid", quick ? MakeGridMesh(32, 0.05f) : MakeGridMesh(320, 0.05f), jobs, repeats) && ok;
+
+    if (!ok)
+    {
+        std::fprintf(stderr, "simplification missed its target\n");
+    }
+    return ok ? 0 : 1;
+}
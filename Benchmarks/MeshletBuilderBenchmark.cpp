@@ -0,0 +1,63 @@
+// Meshlet building for a dense sphere and a bumpy grid: build time and
+// throughput, how full the meshlets are, how many vertices they duplicate
+// across meshlet borders, and how many meshlets the normal cone rejects for
+// a camera outside the mesh.
+
+#include "Measure.h"
+#include "TestMeshes.h"
+
+#include "MeshletBuilder.h"
+
+#include <cmath>
+
+namespace
+{
+    double GetConeCulledFraction(const MeshletData& data, const float camera[3])
+    {
+        uint32_t culled = 0;
+        for (const Meshlet& meshlet : data.meshlets)
+        {
+            float v[3] = { meshlet.sphere[0] - camera[0], meshlet.sphere[1] - camera[1], meshlet.sphere[2] - camera[2] };
+            float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+            float along = v[0] * meshlet.coneAxis[0] + v[1] * meshlet.coneAxis[1] + v[2] * meshlet.coneAxis[2];
+            culled += along >= meshlet.coneCutoff * length + meshlet.sphere[3] ? 1 : 0;
+        }
+        return data.meshlets.empty() ? 0.0 : static_cast<double>(culled) / data.meshlets.size();
+    }
+
+    bool Run(const char* name, const TestMesh& mesh, const float camera[3], uint32_t repeats)
+    {
+        MeshletData data;
+        double ms = MeasureMs(repeats, [&]()
+        {
+            BuildMeshlets(mesh.positions.data(), 12, mesh.GetVertexCount(), mesh.indices.data(),
+                static_cast<uint32_t>(mesh.indices.size()), data);
+        });
+
+        double meshletCount = static_cast<double>(data.meshlets.size());
+        std::printf("%s: %u triangles, %u vertices\n", name, mesh.GetTriangleCount(), mesh.GetVertexCount());
+        std::printf("  build %10.3fms %8.2f Mtriangles/s\n", ms, mesh.GetTriangleCount() / ms / 1000.0);
+        std::printf("  %zu meshlets, %.1f vertices (of %u) and %.1f triangles (of %u) on average\n", data.meshlets.size(),
+            data.vertices.size() / meshletCount, c_MeshletMaxVertices, data.primitives.size() / meshletCount, c_MeshletMaxTriangles);
+        std::printf("  %.3f meshlet vertices per mesh vertex, %.1f%% of meshlets cone-culled\n",
+            static_cast<double>(data.vertices.size()) / mesh.GetVertexCount(), 100.0 * GetConeCulledFraction(data, camera));
+        return data.primitives.size() == mesh.GetTriangleCount();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick = IsQuickRun(argc, argv);
+    const uint32_t repeats = quick ? 1 : 5;
+
+    const float sphereCamera[3] = { 0.0f, 0.0f, -3.0f };
+    const float gridCamera[3] = { 0.5f, -2.0f, 0.5f };     // below, sees the back
+    bool ok = Run("sphere", quick ? MakeSphereMesh(32, 64) : MakeSphereMesh(256, 512), sphereCamera, repeats);
+    ok = Run("grid", quick ? MakeGridMesh(32, 0.05f) : MakeGridMesh(320, 0.05f), gridCamera, repeats) && ok;
+
+    if (!ok)
+    {
+        std::fprintf(stderr, "meshlets lost triangles\n");
+    }
+    return ok ? 0 : 1;
+}
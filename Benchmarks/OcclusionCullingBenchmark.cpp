@@ -0,0 +1,130 @@
+// CPU occlusion culling in a city: a grid of buildings is rasterized as
+// occluders from street level, then the objects that survive frustum
+// culling are tested against the depth buffer. Reports the cost of each
+// stage, single threaded and on the job system, and how much is culled.
+
+#include "Measure.h"
+
+#include "FrustumCulling.h"
+#include "JobSystem.h"
+#include "OcclusionCulling.h"
+
+#include <cstring>
+#include <random>
+
+namespace
+{
+    struct Box
+    {
+        float min[3];
+        float max[3];
+    };
+
+    // 8 corners, 12 triangles.
+    void AddBoxOccluder(OcclusionBuffer& buffer, const Box& box)
+    {
+        float corners[8][3];
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            corners[corner][0] = (corner & 1) ? box.max[0] : box.min[0];
+            corners[corner][1] = (corner & 2) ? box.max[1] : box.min[1];
+            corners[corner][2] = (corner & 4) ? box.max[2] : box.min[2];
+        }
+        static const uint32_t indices[36] = {
+            0, 1, 3, 0, 3, 2,   4, 6, 7, 4, 7, 5,   0, 4, 5, 0, 5, 1,
+            2, 3, 7, 2, 7, 6,   0, 2, 6, 0, 6, 4,   1, 5, 7, 1, 7, 3,
+        };
+        buffer.AddOccluder(corners, sizeof(corners[0]), indices, 36);
+    }
+
+    // Eye at (0, 2, -10) looking down +z; 90 degree field of view, near 1,
+    // far 2000.
+    void MakeCamera(float viewProjection[4][4])
+    {
+        const float n = 1.0f;
+        const float f = 2000.0f;
+        const float a = f / (f - n);
+        const float matrix[4][4] = {
+            { 1, 0, 0, 0 },
+            { 0, 1, 0, 0 },
+            { 0, 0, a, 1 },
+            { 0, -2.0f, -n * a + 10.0f * a, 10.0f },
+        };
+        memcpy(viewProjection, matrix, sizeof(matrix));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool quick = IsQuickRun(argc, argv);
+    const uint32_t objectCount = quick ? 10000 : 200000;
+    const uint32_t repeats = quick ? 1 : 15;
+
+    // 24 x 24 blocks of 30 x 30 with 10-wide streets, heights 10 to 80.
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> height(10.0f, 80.0f);
+    std::vector<Box> buildings;
+    for (int row = 0; row < 24; ++row)
+    {
+        for (int column = 0; column < 24; ++column)
+        {
+            float x = -480.0f + column * 40.0f + 5.0f;
+            float z = 10.0f + row * 40.0f;
+            buildings.push_back({ { x, 0.0f, z }, { x + 30.0f, height(random), z + 30.0f } });
+        }
+    }
+
+    std::uniform_real_distribution<float> x(-480.0f, 480.0f);
+    std::uniform_real_distribution<float> z(0.0f, 960.0f);
+    std::uniform_real_distribution<float> size(0.5f, 3.0f);
+    CullingScene scene;
+    for (uint32_t i = 0; i < objectCount; ++i)
+    {
+        float half = size(random);
+        float center[3] = { x(random), half, z(random) };
+        float boxMin[3] = { center[0] - half, 0.0f, center[2] - half };
+        float boxMax[3] = { center[0] + half, 2.0f * half, center[2] + half };
+        scene.Add(center, half * 1.7320508f, boxMin, boxMax);
+    }
+
+    float viewProjection[4][4];
+    MakeCamera(viewProjection);
+    Frustum frustum = Frustum::FromViewProjection(viewProjection);
+    std::vector<uint32_t> inFrustum;
+    scene.Cull(frustum, nullptr, inFrustum);
+
+    JobSystem jobs;
+    OcclusionBuffer buffer;
+    auto addOccluders = [&]()
+    {
+        buffer.Begin(viewProjection);
+        for (const Box& building : buildings)
+        {
+            AddBoxOccluder(buffer, building);
+        }
+    };
+
+    double setupMs = MeasureMs(repeats, addOccluders);
+    double rasterMs = MeasureMs(repeats, addOccluders, [&]() { buffer.Rasterize(nullptr); });
+    double rasterJobsMs = MeasureMs(repeats, addOccluders, [&]() { buffer.Rasterize(&jobs); });
+
+    std::vector<uint32_t> visible;
+    double filterMs = MeasureMs(repeats, [&]() { visible = inFrustum; }, [&]() { buffer.FilterVisible(scene, visible, nullptr); });
+    std::vector<uint32_t> visibleJobs;
+    double filterJobsMs = MeasureMs(repeats, [&]() { visibleJobs = inFrustum; }, [&]() { buffer.FilterVisible(scene, visibleJobs, &jobs); });
+
+    std::printf("%u objects, %zu in the frustum, %zu visible (%.1f%% occluded), %zu occluders at %ux%u\n",
+        objectCount, inFrustum.size(), visible.size(),
+        inFrustum.empty() ? 0.0 : 100.0 * (inFrustum.size() - visible.size()) / inFrustum.size(),
+        buildings.size(), buffer.GetWidth(), buffer.GetHeight());
+    std::printf("%-24s %10.3fms\n", "transform occluders", setupMs);
+    std::printf("%-24s %10.3fms %10.3fms (jobs)\n", "rasterize", rasterMs, rasterJobsMs);
+    std::printf("%-24s %10.3fms %10.3fms (jobs)\n", "test occludees", filterMs, filterJobsMs);
+
+    bool ok = visible == visibleJobs && visible.size() < inFrustum.size();
+    if (!ok)
+    {
+        std::fprintf(stderr, "unexpected occlusion results\n");
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,271 @@
+// Replays a render capture (see RenderCapture.h) and reports how long each
+// frame took to issue. The null backend measures the CPU cost of the command
+// stream alone and runs anywhere; outside Visual Studio it builds with e.g.
+//     g++ -std=c++17 -O2 -I../DX12-Practice CaptureReplay.cpp
+//         ../DX12-Practice/RenderCapture.cpp ../DX12-Practice/RenderInterface.cpp
+//         ../DX12-Practice/IndirectArguments.cpp ../DX12-Practice/LzCodec.cpp
+//         ../DX12-Practice/MappedFile.cpp
+// On Windows the d3d12 and warp backends record into a command list and wait
+// for the GPU after every frame, so their times include execution.
+
+#include "RenderCapture.h"
+
+#if defined(_WIN32)
+#include "D3D12RenderInterface.h"
+#include <dxgi1_6.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Wraps a backend in whatever a frame needs around BeginFrame/EndFrame.
+    struct Backend
+    {
+        RenderInterface* render = nullptr;
+        std::function<void()> beginFrame;
+        std::function<void()> endFrame;
+    };
+
+#if defined(_WIN32)
+    using Microsoft::WRL::ComPtr;
+
+    class D3D12Backend
+    {
+    public:
+        bool Create(bool useWarp)
+        {
+            ComPtr<IDXGIFactory4> factory;
+            ComPtr<IDXGIAdapter1> adapter;
+            if (FAILED(CreateDXGIFactory2(0, IID_PPV_ARGS(&factory))))
+            {
+                return false;
+            }
+            if (useWarp)
+            {
+                factory->EnumWarpAdapter(IID_PPV_ARGS(&adapter));
+            }
+            else
+            {
+                factory->EnumAdapters1(0, &adapter);
+            }
+            if (!adapter || FAILED(D3D12CreateDevice(adapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&m_Device))))
+            {
+                return false;
+            }
+
+            D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+            queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+            m_Device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_Queue));
+            m_Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&m_Allocator));
+            m_Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_Allocator.Get(), nullptr, IID_PPV_ARGS(&m_CommandList));
+            m_CommandList->Close();
+            m_Device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_Fence));
+            m_FenceEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+            m_Render = std::make_unique<D3D12RenderInterface>(m_Device);
+            return true;
+        }
+
+        ~D3D12Backend()
+        {
+            if (m_FenceEvent)
+            {
+                CloseHandle(m_FenceEvent);
+            }
+        }
+
+        Backend Get()
+        {
+            Backend backend;
+            backend.render = m_Render.get();
+            backend.beginFrame = [this]
+            {
+                m_Allocator->Reset();
+                m_CommandList->Reset(m_Allocator.Get(), nullptr);
+                m_Render->SetFrame(m_CommandList.Get(), m_FenceValue + 1, m_Fence->GetCompletedValue());
+            };
+            backend.endFrame = [this]
+            {
+                m_CommandList->Close();
+                ID3D12CommandList* const commandLists[] = { m_CommandList.Get() };
+                m_Queue->ExecuteCommandLists(_countof(commandLists), commandLists);
+                m_Queue->Signal(m_Fence.Get(), ++m_FenceValue);
+                if (m_Fence->GetCompletedValue() < m_FenceValue)
+                {
+                    m_Fence->SetEventOnCompletion(m_FenceValue, m_FenceEvent);
+                    WaitForSingleObject(m_FenceEvent, INFINITE);
+                }
+            };
+            return backend;
+        }
+
+    private:
+        ComPtr<ID3D12Device2> m_Device;
+        ComPtr<ID3D12CommandQueue> m_Queue;
+        ComPtr<ID3D12CommandAllocator> m_Allocator;
+        ComPtr<ID3D12GraphicsCommandList> m_CommandList;
+        ComPtr<ID3D12Fence> m_Fence;
+        uint64_t m_FenceValue = 0;
+        HANDLE m_FenceEvent = nullptr;
+        std::unique_ptr<D3D12RenderInterface> m_Render;
+    };
+#endif
+
+    double Percentile(const std::vector<double>& sorted, double fraction)
+    {
+        size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* path = nullptr;
+    std::string backendName = "null";
+    uint32_t loops = 10;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strncmp(argv[i], "--backend=", 10) == 0)
+        {
+            backendName = argv[i] + 10;
+        }
+        else if (std::strncmp(argv[i], "--loops=", 8) == 0)
+        {
+            loops = std::max(1, std::atoi(argv[i] + 8));
+        }
+        else if (!path && argv[i][0] != '-')
+        {
+            path = argv[i];
+        }
+        else
+        {
+            path = nullptr;
+            break;
+        }
+    }
+    if (!path)
+    {
+        printf("usage: CaptureReplay <capture> [--backend=null|d3d12|warp] [--loops=N]\n");
+        return 1;
+    }
+
+    std::string error;
+    RenderCaptureReplayer replayer;
+    if (!replayer.Open(path, &error))
+    {
+        fprintf(stderr, "CaptureReplay: %s\n", error.c_str());
+        return 1;
+    }
+
+    Backend backend;
+    NullRenderInterface null;
+#if defined(_WIN32)
+    D3D12Backend d3d12;
+#endif
+    if (backendName == "null")
+    {
+        backend.render = &null;
+    }
+#if defined(_WIN32)
+    else if (backendName == "d3d12" || backendName == "warp")
+    {
+        if (!d3d12.Create(backendName == "warp"))
+        {
+            fprintf(stderr, "CaptureReplay: cannot create a %s device\n", backendName.c_str());
+            return 1;
+        }
+        backend = d3d12.Get();
+    }
+#endif
+    else
+    {
+        fprintf(stderr, "CaptureReplay: backend %s is not available\n", backendName.c_str());
+        return 1;
+    }
+
+    auto replay = [&](const std::function<bool()>& issue)
+    {
+        if (backend.beginFrame)
+        {
+            backend.beginFrame();
+        }
+        bool ok = issue();
+        if (backend.endFrame)
+        {
+            backend.endFrame();
+        }
+        return ok;
+    };
+
+    if (!replay([&] { return replayer.ReplaySetup(*backend.render, &error); }))
+    {
+        fprintf(stderr, "CaptureReplay: setup: %s\n", error.c_str());
+        return 1;
+    }
+
+    // Every frame of every loop is timed on its own; the first loop warms
+    // caches and is left out unless it is the only one.
+    std::vector<double> frameMs;
+    using Clock = std::chrono::high_resolution_clock;
+    for (uint32_t loop = 0; loop < loops; ++loop)
+    {
+        for (uint32_t frame = 0; frame < replayer.GetFrameCount(); ++frame)
+        {
+            auto t0 = Clock::now();
+            if (!replay([&] { return replayer.ReplayFrame(frame, *backend.render, &error); }))
+            {
+                fprintf(stderr, "CaptureReplay: frame %u: %s\n", frame, error.c_str());
+                return 1;
+            }
+            double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+            if (loop != 0 || loops == 1)
+            {
+                frameMs.push_back(ms);
+            }
+        }
+    }
+    if (frameMs.empty())
+    {
+        fprintf(stderr, "CaptureReplay: capture has no frames\n");
+        return 1;
+    }
+
+    uint64_t streamBytes = 0;
+    for (uint32_t frame = 0; frame < replayer.GetFrameCount(); ++frame)
+    {
+        streamBytes += replayer.GetFrameSize(frame);
+    }
+    double totalMs = 0.0;
+    for (double ms : frameMs)
+    {
+        totalMs += ms;
+    }
+    std::sort(frameMs.begin(), frameMs.end());
+
+    printf("%s on %s: %u frames x %u loops, setup %.1f KB, frames %.1f KB\n", path, backend.render->GetName(),
+        replayer.GetFrameCount(), loops, replayer.GetSetupSize() / 1024.0, streamBytes / 1024.0);
+    printf("frame ms: mean %.3f, min %.3f, median %.3f, p95 %.3f, p99 %.3f, max %.3f\n", totalMs / frameMs.size(),
+        frameMs.front(), Percentile(frameMs, 0.5), Percentile(frameMs, 0.95), Percentile(frameMs, 0.99), frameMs.back());
+    if (backend.render == &null)
+    {
+        const NullRenderInterface::Stats& stats = null.GetStats();
+        printf("commands %llu, draws %llu, dispatches %llu, indirect %llu, upload %.1f KB, errors %u\n",
+            static_cast<unsigned long long>(stats.commands), static_cast<unsigned long long>(stats.draws),
+            static_cast<unsigned long long>(stats.dispatches), static_cast<unsigned long long>(stats.indirectCommands),
+            stats.uploadBytes / 1024.0, stats.errors);
+        if (stats.errors)
+        {
+            fprintf(stderr, "CaptureReplay: %s\n", null.GetFirstError().c_str());
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,241 @@
+#include "AssetArchive.h"
+#include "LzCodec.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    bool Fail(std::string* error, const char* message)
+    {
+        if (error)
+        {
+            *error = message;
+        }
+        return false;
+    }
+
+    uint64_t AlignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // Used while opening, before any other reads are queued.
+    bool ReadBlocking(AsyncFileReader& reader, uint64_t offset, uint32_t size, void* buffer, uint32_t needed)
+    {
+        reader.Read(offset, size, buffer, 0);
+        AsyncReadResult result;
+        while (reader.Poll(&result, 1, true) == 0)
+        {
+            if (reader.GetOutstandingCount() == 0)
+            {
+                return false;
+            }
+        }
+        return result.ok && result.bytesRead >= needed;
+    }
+}
+
+bool AssetArchiveWriter::Add(const std::string& name, const void* data, size_t size)
+{
+    uint64_t nameHash = GetAssetNameHash(name.c_str());
+    if (size > UINT32_MAX - c_AssetArchiveAlignment || !m_NameHashes.insert(nameHash).second)
+    {
+        return false;
+    }
+
+    auto bytes = static_cast<const uint8_t*>(data);
+    Blob blob;
+    blob.contentHash = HashBytes(bytes, size);
+    blob.size = static_cast<uint32_t>(size);
+    blob.flags = 0;
+
+    // Compressed data is only kept if it saves at least 1/16 of the size;
+    // below that the decompression costs more than the read it saves.
+    if (size >= 64)
+    {
+        blob.stored.resize(size - size / 16);
+        size_t compressedSize = LzCompress(bytes, size, blob.stored.data(), blob.stored.size());
+        if (compressedSize)
+        {
+            blob.stored.resize(compressedSize);
+            blob.flags = c_AssetEntryCompressed;
+        }
+    }
+    if (!(blob.flags & c_AssetEntryCompressed))
+    {
+        blob.stored.assign(bytes, bytes + size);
+    }
+
+    // Compression is deterministic, so equal stored bytes mean equal contents
+    // even if two different assets collide on the hash.
+    uint32_t index = static_cast<uint32_t>(m_Blobs.size());
+    auto range = m_BlobsByHash.equal_range(blob.contentHash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        const Blob& existing = m_Blobs[it->second];
+        if (existing.size == blob.size && existing.flags == blob.flags && existing.stored == blob.stored)
+        {
+            index = it->second;
+            break;
+        }
+    }
+    if (index == m_Blobs.size())
+    {
+        m_StoredSize += blob.stored.size();
+        m_BlobsByHash.emplace(blob.contentHash, index);
+        m_Blobs.push_back(std::move(blob));
+    }
+
+    m_Entries.emplace_back(nameHash, index);
+    m_Size += size;
+    return true;
+}
+
+bool AssetArchiveWriter::Write(const std::filesystem::path& path, std::string* error) const
+{
+    std::vector<uint64_t> offsets(m_Blobs.size());
+    uint64_t offset = c_AssetArchiveAlignment;
+    for (size_t i = 0; i < m_Blobs.size(); ++i)
+    {
+        offsets[i] = offset;
+        offset = AlignUp(offset + m_Blobs[i].stored.size(), c_AssetArchiveAlignment);
+    }
+
+    std::vector<AssetArchiveEntry> table;
+    table.reserve(m_Entries.size());
+    for (const auto& [nameHash, blobIndex] : m_Entries)
+    {
+        const Blob& blob = m_Blobs[blobIndex];
+        AssetArchiveEntry entry = {};
+        entry.nameHash = nameHash;
+        entry.contentHash = blob.contentHash;
+        entry.offset = offsets[blobIndex];
+        entry.storedSize = static_cast<uint32_t>(blob.stored.size());
+        entry.size = blob.size;
+        entry.flags = blob.flags;
+        table.push_back(entry);
+    }
+    std::sort(table.begin(), table.end(),
+        [](const AssetArchiveEntry& a, const AssetArchiveEntry& b) { return a.nameHash < b.nameHash; });
+
+    AssetArchiveHeader header = {};
+    header.magic = c_AssetArchiveMagic;
+    header.version = c_AssetArchiveVersion;
+    header.entryCount = static_cast<uint32_t>(table.size());
+    header.tableOffset = offset;
+    header.tableSize = table.size() * sizeof(AssetArchiveEntry);
+
+    // Padding the end lets the table be read with an aligned size too.
+    std::vector<uint8_t> file(AlignUp(offset + header.tableSize, c_AssetArchiveAlignment), 0);
+    memcpy(file.data(), &header, sizeof(header));
+    for (size_t i = 0; i < m_Blobs.size(); ++i)
+    {
+        if (!m_Blobs[i].stored.empty())
+        {
+            memcpy(file.data() + offsets[i], m_Blobs[i].stored.data(), m_Blobs[i].stored.size());
+        }
+    }
+    if (!table.empty())
+    {
+        memcpy(file.data() + offset, table.data(), header.tableSize);
+    }
+
+    if (!WriteFileAtomic(path, file.data(), file.size()))
+    {
+        return Fail(error, "cannot write asset archive");
+    }
+    return true;
+}
+
+bool AssetArchive::Open(const std::filesystem::path& path, std::string* error)
+{
+    Close();
+    if (!m_Reader.Open(path))
+    {
+        return Fail(error, "cannot open asset archive");
+    }
+
+    AlignedBuffer block = AllocateAlignedBuffer(c_AssetArchiveAlignment);
+    AssetArchiveHeader header;
+    if (!ReadBlocking(m_Reader, 0, c_AssetArchiveAlignment, block.get(), sizeof(header)))
+    {
+        Close();
+        return Fail(error, "asset archive is truncated");
+    }
+    memcpy(&header, block.get(), sizeof(header));
+
+    uint64_t fileSize = m_Reader.GetFileSize();
+    if (header.magic != c_AssetArchiveMagic || header.version != c_AssetArchiveVersion)
+    {
+        Close();
+        return Fail(error, "not an asset archive");
+    }
+    if (header.tableOffset % c_AssetArchiveAlignment != 0 ||
+        header.tableSize != uint64_t(header.entryCount) * sizeof(AssetArchiveEntry) ||
+        header.tableOffset > fileSize || header.tableSize > fileSize - header.tableOffset ||
+        AlignUp(header.tableSize, c_AssetArchiveAlignment) > UINT32_MAX)
+    {
+        Close();
+        return Fail(error, "asset archive table out of range");
+    }
+
+    m_Entries.resize(header.entryCount);
+    if (header.entryCount)
+    {
+        auto readSize = static_cast<uint32_t>(AlignUp(header.tableSize, c_AssetArchiveAlignment));
+        AlignedBuffer table = AllocateAlignedBuffer(readSize);
+        if (!ReadBlocking(m_Reader, header.tableOffset, readSize, table.get(), static_cast<uint32_t>(header.tableSize)))
+        {
+            Close();
+            return Fail(error, "asset archive is truncated");
+        }
+        memcpy(m_Entries.data(), table.get(), header.tableSize);
+    }
+
+    for (uint32_t i = 0; i < header.entryCount; ++i)
+    {
+        const AssetArchiveEntry& entry = m_Entries[i];
+        bool compressed = (entry.flags & c_AssetEntryCompressed) != 0;
+        if (entry.offset % c_AssetArchiveAlignment != 0 || entry.offset > header.tableOffset ||
+            entry.storedSize > header.tableOffset - entry.offset || (!compressed && entry.storedSize != entry.size) ||
+            (i > 0 && m_Entries[i - 1].nameHash >= entry.nameHash))
+        {
+            Close();
+            return Fail(error, "invalid asset archive entry");
+        }
+    }
+    return true;
+}
+
+void AssetArchive::Close()
+{
+    m_Reader.Close();
+    m_Entries.clear();
+}
+
+const AssetArchiveEntry* AssetArchive::Find(uint64_t nameHash) const
+{
+    auto it = std::lower_bound(m_Entries.begin(), m_Entries.end(), nameHash,
+        [](const AssetArchiveEntry& entry, uint64_t hash) { return entry.nameHash < hash; });
+    return it != m_Entries.end() && it->nameHash == nameHash ? &*it : nullptr;
+}
+
+uint32_t AssetArchive::GetReadSize(const AssetArchiveEntry& entry)
+{
+    return static_cast<uint32_t>(AlignUp(entry.storedSize, c_AssetArchiveAlignment));
+}
+
+bool AssetArchive::Unpack(const AssetArchiveEntry& entry, const void* stored, void* output)
+{
+    if (entry.flags & c_AssetEntryCompressed)
+    {
+        return LzDecompress(stored, entry.storedSize, output, entry.size);
+    }
+    if (entry.size)
+    {
+        memcpy(output, stored, entry.size);
+    }
+    return true;
+}
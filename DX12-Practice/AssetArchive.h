@@ -0,0 +1,124 @@
+#pragma once
+#include "AsyncFileReader.h"
+#include "Hash.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Single-file asset archive:
+//     header          one c_AssetArchiveAlignment block
+//     entry data      each entry starts on an aligned offset
+//     table           AssetArchiveEntry[entryCount], sorted by nameHash
+// Entries are looked up by the hash of their name (a '/'-separated path
+// relative to the packed directory), stored LZ-compressed when that saves
+// space, and entries with identical contents share their data. Everything is
+// aligned so entries can be read unbuffered, straight into aligned buffers.
+constexpr uint32_t c_AssetArchiveMagic = 0x314b4150; // "PAK1"
+constexpr uint32_t c_AssetArchiveVersion = 1;
+constexpr uint32_t c_AssetArchiveAlignment = c_AsyncReadAlignment;
+
+struct AssetArchiveHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+    uint64_t tableOffset;
+    uint64_t tableSize;
+};
+
+enum AssetEntryFlags : uint32_t
+{
+    c_AssetEntryCompressed = 0x1,   // LzCodec stream
+};
+
+struct AssetArchiveEntry
+{
+    uint64_t nameHash;          // HashString(name)
+    uint64_t contentHash;       // HashBytes of the unpacked data
+    uint64_t offset;            // multiple of c_AssetArchiveAlignment
+    uint32_t storedSize;        // bytes in the archive
+    uint32_t size;              // bytes once unpacked
+    uint32_t flags;
+    uint32_t reserved;
+};
+static_assert(sizeof(AssetArchiveEntry) == 40, "archive table layout");
+
+inline uint64_t GetAssetNameHash(const char* name)
+{
+    return HashString(name);
+}
+
+// Builds an archive in memory and writes it in one go.
+class AssetArchiveWriter
+{
+public:
+    // False if an asset with the same name hash was already added, or the
+    // asset does not fit in 32 bits once aligned.
+    bool Add(const std::string& name, const void* data, size_t size);
+
+    bool Write(const std::filesystem::path& path, std::string* error = nullptr) const;
+
+    uint32_t GetEntryCount() const { return static_cast<uint32_t>(m_Entries.size()); }
+    // Entries whose data was already in the archive.
+    uint32_t GetDuplicateCount() const { return static_cast<uint32_t>(m_Entries.size() - m_Blobs.size()); }
+    uint64_t GetSize() const { return m_Size; }
+    uint64_t GetStoredSize() const { return m_StoredSize; }
+
+private:
+    struct Blob
+    {
+        uint64_t contentHash;
+        uint32_t size;
+        uint32_t flags;
+        std::vector<uint8_t> stored;
+    };
+
+    std::vector<Blob> m_Blobs;
+    std::unordered_multimap<uint64_t, uint32_t> m_BlobsByHash;
+    std::vector<std::pair<uint64_t, uint32_t>> m_Entries;   // name hash, blob
+    std::unordered_set<uint64_t> m_NameHashes;
+    uint64_t m_Size = 0;
+    uint64_t m_StoredSize = 0;
+};
+
+// Reads entries asynchronously through an AsyncFileReader: Read() queues the
+// entry's stored bytes, GetReader().Submit()/Poll() move them, and Unpack()
+// turns them into the asset.
+class AssetArchive
+{
+public:
+    explicit AssetArchive(uint32_t queueDepth = 64) : m_Reader(queueDepth) {}
+
+    bool Open(const std::filesystem::path& path, std::string* error = nullptr);
+    void Close();
+
+    bool IsOpen() const { return m_Reader.IsOpen(); }
+    uint32_t GetEntryCount() const { return static_cast<uint32_t>(m_Entries.size()); }
+    const AssetArchiveEntry& GetEntry(uint32_t index) const { return m_Entries[index]; }
+
+    const AssetArchiveEntry* Find(uint64_t nameHash) const;
+    const AssetArchiveEntry* Find(const char* name) const { return Find(GetAssetNameHash(name)); }
+
+    // Stored size rounded up to c_AssetArchiveAlignment; read buffers must
+    // be this large and aligned (see AllocateAlignedBuffer).
+    static uint32_t GetReadSize(const AssetArchiveEntry& entry);
+
+    void Read(const AssetArchiveEntry& entry, void* buffer, uint64_t userData)
+    {
+        m_Reader.Read(entry.offset, GetReadSize(entry), buffer, userData);
+    }
+
+    // Decompresses or copies entry.size bytes of stored data into output.
+    static bool Unpack(const AssetArchiveEntry& entry, const void* stored, void* output);
+
+    AsyncFileReader& GetReader() { return m_Reader; }
+
+private:
+    AsyncFileReader m_Reader;
+    std::vector<AssetArchiveEntry> m_Entries;
+};
@@ -0,0 +1,484 @@
+#include "AssetLoader.h"
+
+#include <algorithm>
+
+namespace
+{
+    constexpr uint32_t c_ReadResultBatch = 32;
+
+    bool IsFinished(AssetLoadState state)
+    {
+        return state == AssetLoadState::Complete || state == AssetLoadState::Failed || state == AssetLoadState::Cancelled;
+    }
+}
+
+AssetLoader::AssetLoader(AssetArchive& archive, JobSystem& jobs, UploadQueue& uploads, const Limits& limits)
+    : m_Archive(archive)
+    , m_Jobs(jobs)
+    , m_Uploads(uploads)
+    , m_Limits(limits)
+{
+    m_Limits.maxReads = std::max(1u, m_Limits.maxReads);
+    m_Limits.maxJobs = std::max(1u, m_Limits.maxJobs);
+}
+
+AssetLoader::~AssetLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (uint32_t i = 0; i < m_Requests.size(); ++i)
+        {
+            CancelLocked(i);
+        }
+    }
+
+    // Reads in flight still write into request buffers, and jobs may still
+    // be queued on the job system.
+    AsyncReadResult results[c_ReadResultBatch];
+    while (m_ReadsInFlight)
+    {
+        uint32_t count = m_Archive.GetReader().Poll(results, c_ReadResultBatch, true);
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            CompleteRead(results[i]);
+        }
+    }
+    m_Jobs.Wait(m_JobCounter);
+}
+
+AssetLoadHandle AssetLoader::Load(uint64_t nameHash, AssetPriority priority, AssetUploader uploader, AssetTranscoder transcoder)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    uint32_t index;
+    if (!m_FreeRequests.empty())
+    {
+        index = m_FreeRequests.back();
+        m_FreeRequests.pop_back();
+    }
+    else
+    {
+        index = static_cast<uint32_t>(m_Requests.size());
+        m_Requests.emplace_back();
+    }
+
+    Request& request = m_Requests[index];
+    request.state = AssetLoadState::Queued;
+    request.priority = priority;
+    request.sequence = m_Sequence++;
+    request.entry = m_Archive.Find(nameHash);
+    request.uploader = std::move(uploader);
+    request.transcoder = std::move(transcoder);
+    if (request.entry)
+    {
+        Enqueue(index, c_StageRead);
+    }
+    else
+    {
+        Fail(index);
+    }
+    return { index, request.generation };
+}
+
+void AssetLoader::SetPriority(AssetLoadHandle handle, AssetPriority priority)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    Request* request = Find(handle);
+    if (!request || request->priority == priority)
+    {
+        return;
+    }
+
+    Stage stage = request->queue;
+    if (stage != c_StageNone)
+    {
+        Dequeue(handle.index);
+    }
+    request->priority = priority;
+    if (stage != c_StageNone)
+    {
+        Enqueue(handle.index, stage);
+    }
+}
+
+void AssetLoader::Cancel(AssetLoadHandle handle)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (Find(handle))
+    {
+        CancelLocked(handle.index);
+    }
+}
+
+void AssetLoader::Release(AssetLoadHandle handle)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (Request* request = Find(handle))
+    {
+        CancelLocked(handle.index);
+        request->released = true;
+        TryRecycle(handle.index);
+    }
+}
+
+AssetLoadState AssetLoader::GetState(AssetLoadHandle handle) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    const Request* request = Find(handle);
+    return request ? request->state : AssetLoadState::Invalid;
+}
+
+uint64_t AssetLoader::GetFenceValue(AssetLoadHandle handle) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    const Request* request = Find(handle);
+    return request ? request->fenceValue : 0;
+}
+
+AssetLoader::Request* AssetLoader::Find(AssetLoadHandle handle)
+{
+    return const_cast<Request*>(static_cast<const AssetLoader*>(this)->Find(handle));
+}
+
+const AssetLoader::Request* AssetLoader::Find(AssetLoadHandle handle) const
+{
+    if (handle.index >= m_Requests.size())
+    {
+        return nullptr;
+    }
+    const Request& request = m_Requests[handle.index];
+    bool live = request.generation == handle.generation && request.state != AssetLoadState::Invalid && !request.released;
+    return live ? &request : nullptr;
+}
+
+void AssetLoader::Enqueue(uint32_t index, Stage stage)
+{
+    Request& request = m_Requests[index];
+    request.queue = stage;
+    m_Queues[stage].insert({ (uint64_t(request.priority) << 56) | request.sequence, index });
+}
+
+void AssetLoader::Dequeue(uint32_t index)
+{
+    Request& request = m_Requests[index];
+    m_Queues[request.queue].erase({ (uint64_t(request.priority) << 56) | request.sequence, index });
+    request.queue = c_StageNone;
+}
+
+void AssetLoader::Fail(uint32_t index)
+{
+    Request& request = m_Requests[index];
+    request.state = AssetLoadState::Failed;
+    DropData(request);
+    TryRecycle(index);
+}
+
+void AssetLoader::CancelLocked(uint32_t index)
+{
+    Request& request = m_Requests[index];
+    if (request.cancelled || IsFinished(request.state) || request.state == AssetLoadState::Invalid)
+    {
+        return;
+    }
+
+    request.cancelled = true;
+    request.state = AssetLoadState::Cancelled;
+    if (request.queue != c_StageNone)
+    {
+        Dequeue(index);
+    }
+    // Otherwise whoever holds it drops it at the next stage boundary.
+    if (!request.busy)
+    {
+        DropData(request);
+    }
+}
+
+void AssetLoader::DropData(Request& request)
+{
+    if (request.readBuffer)
+    {
+        m_ReadBytes -= AssetArchive::GetReadSize(*request.entry);
+        request.readBuffer.reset();
+    }
+    m_ProcessedBytes -= request.data.size();
+    std::vector<uint8_t>().swap(request.data);
+    request.uploader = nullptr;
+    request.transcoder = nullptr;
+}
+
+void AssetLoader::TryRecycle(uint32_t index)
+{
+    Request& request = m_Requests[index];
+    if (!request.released || request.busy)
+    {
+        return;
+    }
+
+    uint32_t generation = request.generation + 1;
+    request = Request();
+    request.generation = generation;
+    m_FreeRequests.push_back(index);
+}
+
+void AssetLoader::CompleteRead(const AsyncReadResult& result)
+{
+    auto index = static_cast<uint32_t>(result.userData);
+    Request& request = m_Requests[index];
+    request.busy = false;
+    --m_ReadsInFlight;
+
+    if (request.cancelled)
+    {
+        DropData(request);
+        TryRecycle(index);
+    }
+    else if (!result.ok || result.bytesRead < request.entry->storedSize)
+    {
+        Fail(index);
+    }
+    else
+    {
+        request.state = AssetLoadState::Decompressing;
+        Enqueue(index, c_StageDecompress);
+    }
+}
+
+void AssetLoader::StartReads()
+{
+    // Reads handed to the OS can no longer be reordered, so only a few are
+    // in flight and the rest wait here where priorities still apply.
+    auto& queue = m_Queues[c_StageRead];
+    while (m_ReadsInFlight < m_Limits.maxReads && !queue.empty())
+    {
+        uint32_t index = queue.begin()->second;
+        Request& request = m_Requests[index];
+        uint32_t readSize = AssetArchive::GetReadSize(*request.entry);
+        if (m_ReadBytes > 0 && m_ReadBytes + readSize > m_Limits.maxReadBytes)
+        {
+            break;
+        }
+
+        request.readBuffer = AllocateAlignedBuffer(readSize);
+        if (!request.readBuffer)
+        {
+            break;
+        }
+        Dequeue(index);
+        m_ReadBytes += readSize;
+        ++m_ReadsInFlight;
+        request.state = AssetLoadState::Reading;
+        request.busy = true;
+        m_Archive.Read(*request.entry, request.readBuffer.get(), index);
+    }
+}
+
+void AssetLoader::StartJobs()
+{
+    // Jobs take the best waiting request when they run rather than when they
+    // are submitted, so the job system's FIFO does not defeat priorities.
+    size_t waiting = m_Queues[c_StageDecompress].size() + m_Queues[c_StageTranscode].size();
+    while (m_RunningJobs < m_Limits.maxJobs && m_RunningJobs < waiting)
+    {
+        ++m_RunningJobs;
+        m_Jobs.Submit([this] { RunJobs(); }, &m_JobCounter);
+    }
+}
+
+void AssetLoader::RunJobs()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    for (;;)
+    {
+        // Decompression also needs room for its output; transcoding only
+        // changes the size of data already counted.
+        auto& decompress = m_Queues[c_StageDecompress];
+        auto& transcode = m_Queues[c_StageTranscode];
+        bool canDecompress = !decompress.empty() && (m_ProcessedBytes == 0 ||
+            m_ProcessedBytes + m_Requests[decompress.begin()->second].entry->size <= m_Limits.maxProcessedBytes);
+
+        Stage stage;
+        if (!transcode.empty() && (!canDecompress || *transcode.begin() < *decompress.begin()))
+        {
+            stage = c_StageTranscode;
+        }
+        else if (canDecompress)
+        {
+            stage = c_StageDecompress;
+        }
+        else
+        {
+            break;
+        }
+
+        uint32_t index = m_Queues[stage].begin()->second;
+        Request& request = m_Requests[index];
+        Dequeue(index);
+        request.busy = true;
+        ++m_ProcessingCount;
+        size_t previousSize = request.data.size();
+        if (stage == c_StageDecompress)
+        {
+            previousSize = request.entry->size;
+            m_ProcessedBytes += previousSize;
+        }
+
+        lock.unlock();
+        bool ok;
+        if (stage == c_StageDecompress)
+        {
+            request.data.resize(request.entry->size);
+            ok = AssetArchive::Unpack(*request.entry, request.readBuffer.get(), request.data.data());
+        }
+        else
+        {
+            ok = request.transcoder(request.data);
+        }
+        lock.lock();
+
+        --m_ProcessingCount;
+        request.busy = false;
+        m_ProcessedBytes = m_ProcessedBytes - previousSize + request.data.size();
+        if (stage == c_StageDecompress)
+        {
+            m_ReadBytes -= AssetArchive::GetReadSize(*request.entry);
+            request.readBuffer.reset();
+        }
+
+        if (request.cancelled)
+        {
+            DropData(request);
+            TryRecycle(index);
+        }
+        else if (!ok)
+        {
+            Fail(index);
+        }
+        else if (stage == c_StageDecompress && request.transcoder)
+        {
+            request.state = AssetLoadState::Transcoding;
+            Enqueue(index, c_StageTranscode);
+        }
+        else
+        {
+            request.state = AssetLoadState::Uploading;
+            Enqueue(index, c_StageUpload);
+        }
+    }
+    --m_RunningJobs;
+}
+
+void AssetLoader::Update()
+{
+    AsyncFileReader& reader = m_Archive.GetReader();
+    AsyncReadResult results[c_ReadResultBatch];
+    std::vector<uint32_t> uploads;
+    std::vector<Request*> uploadRequests;   // m_Requests may grow while unlocked
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        for (;;)
+        {
+            lock.unlock();
+            uint32_t count = reader.Poll(results, c_ReadResultBatch, false);
+            lock.lock();
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                CompleteRead(results[i]);
+            }
+            if (count < c_ReadResultBatch)
+            {
+                break;
+            }
+        }
+
+        // Upload fences that passed free their requests first.
+        auto retired = std::remove_if(m_Uploading.begin(), m_Uploading.end(), [this](uint32_t index)
+        {
+            Request& request = m_Requests[index];
+            if (!m_Uploads.IsComplete(request.fenceValue))
+            {
+                return false;
+            }
+            request.busy = false;
+            if (!request.cancelled)
+            {
+                request.state = AssetLoadState::Complete;
+            }
+            TryRecycle(index);
+            return true;
+        });
+        m_Uploading.erase(retired, m_Uploading.end());
+
+        StartReads();
+
+        uint64_t budget = m_Limits.uploadBytesPerUpdate;
+        auto& queue = m_Queues[c_StageUpload];
+        while (!queue.empty())
+        {
+            uint32_t index = queue.begin()->second;
+            Request& request = m_Requests[index];
+            if (!uploads.empty() && request.data.size() > budget)
+            {
+                break;
+            }
+            budget -= std::min<uint64_t>(budget, request.data.size());
+            Dequeue(index);
+            request.busy = true;
+            uploads.push_back(index);
+            uploadRequests.push_back(&request);
+        }
+    }
+    reader.Submit();
+
+    // Uploaders copy into staging memory; run them without holding the lock.
+    std::vector<uint8_t> succeeded(uploads.size());
+    for (size_t i = 0; i < uploads.size(); ++i)
+    {
+        Request& request = *uploadRequests[i];
+        succeeded[i] = request.uploader(request.data);
+    }
+    uint64_t fenceValue = uploads.empty() ? 0 : m_Uploads.Submit();
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (size_t i = 0; i < uploads.size(); ++i)
+    {
+        uint32_t index = uploads[i];
+        Request& request = *uploadRequests[i];
+        request.busy = false;
+        if (request.cancelled)
+        {
+            DropData(request);
+            TryRecycle(index);
+        }
+        else if (!succeeded[i])
+        {
+            Fail(index);
+        }
+        else
+        {
+            DropData(request);
+            request.fenceValue = fenceValue;
+            request.busy = true;
+            m_Uploading.push_back(index);
+        }
+    }
+    StartJobs();
+}
+
+AssetLoader::Stats AssetLoader::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    Stats stats = {};
+    for (const QueueKey& key : m_Queues[c_StageRead])
+    {
+        ++stats.queued[key.first >> 56];
+    }
+    stats.reading = m_ReadsInFlight;
+    stats.processing = static_cast<uint32_t>(m_Queues[c_StageDecompress].size() + m_Queues[c_StageTranscode].size()) +
+        m_ProcessingCount;
+    stats.uploading = static_cast<uint32_t>(m_Queues[c_StageUpload].size() + m_Uploading.size());
+    stats.readBytes = m_ReadBytes;
+    stats.processedBytes = m_ProcessedBytes;
+    return stats;
+}
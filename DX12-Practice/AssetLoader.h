@@ -0,0 +1,191 @@
+#pragma once
+#include "AssetArchive.h"
+#include "JobSystem.h"
+#include "UploadQueue.h"
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <vector>
+
+enum class AssetPriority : uint8_t
+{
+    Visible,        // needed by the frame being built
+    Prefetch,       // likely to be needed soon
+    Background,
+};
+constexpr uint32_t c_AssetPriorityCount = 3;
+
+enum class AssetLoadState : uint8_t
+{
+    Invalid,        // unknown or released handle
+    Queued,
+    Reading,
+    Decompressing,
+    Transcoding,
+    Uploading,      // waiting for upload budget or for the upload fence
+    Complete,
+    Failed,
+    Cancelled,
+};
+
+struct AssetLoadHandle
+{
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool IsValid() const { return index != UINT32_MAX; }
+};
+
+// Converts unpacked file data in place into what gets uploaded (parsing,
+// BC encoding, ...). Runs on a job.
+using AssetTranscoder = std::function<bool(std::vector<uint8_t>& data)>;
+// Records the copies for an asset on the loader's upload queue, e.g. through
+// UploadBatcher::CreateBuffer or UploadTexture, and keeps the resources it
+// creates. Runs inside Update().
+using AssetUploader = std::function<bool(std::vector<uint8_t>& data)>;
+
+// Streams assets out of an AssetArchive through four stages:
+//     read        async file reads, pumped by Update()
+//     decompress  on the job system
+//     transcode   on the job system (optional per asset)
+//     upload      recorded in Update(), done once the upload fence passes
+// Every stage takes the highest-priority request waiting for it (oldest
+// first within a priority) when it has room, so SetPriority() and Cancel()
+// affect anything not yet in the stage that is working on it. The stages are
+// bounded by the limits below, which keeps low-priority work from filling
+// the reader or memory ahead of requests that arrive later.
+//
+// Load/SetPriority/Cancel/Release/GetState may be called from any thread.
+// Update() must be called from one thread, typically once per frame. The
+// loader owns the archive's reader while it exists.
+class AssetLoader
+{
+public:
+    struct Limits
+    {
+        uint32_t maxReads = 16;                         // reads handed to the OS
+        uint64_t maxReadBytes = 64ull << 20;            // read buffers waiting for decompression
+        uint32_t maxJobs = 4;                           // decompress/transcode jobs
+        uint64_t maxProcessedBytes = 128ull << 20;      // unpacked data waiting for upload
+        uint64_t uploadBytesPerUpdate = 32ull << 20;
+    };
+
+    struct Stats
+    {
+        uint32_t queued[c_AssetPriorityCount];
+        uint32_t reading;
+        uint32_t processing;        // waiting for or running a job
+        uint32_t uploading;
+        uint64_t readBytes;
+        uint64_t processedBytes;
+    };
+
+    AssetLoader(AssetArchive& archive, JobSystem& jobs, UploadQueue& uploads, const Limits& limits);
+    AssetLoader(AssetArchive& archive, JobSystem& jobs, UploadQueue& uploads)
+        : AssetLoader(archive, jobs, uploads, Limits())
+    {
+    }
+    // Cancels everything and waits for reads and jobs in flight.
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // Unknown names return a handle in the Failed state.
+    AssetLoadHandle Load(uint64_t nameHash, AssetPriority priority, AssetUploader uploader,
+        AssetTranscoder transcoder = nullptr);
+    AssetLoadHandle Load(const char* name, AssetPriority priority, AssetUploader uploader,
+        AssetTranscoder transcoder = nullptr)
+    {
+        return Load(GetAssetNameHash(name), priority, std::move(uploader), std::move(transcoder));
+    }
+
+    void SetPriority(AssetLoadHandle handle, AssetPriority priority);
+
+    // Stops a load at the next stage boundary. Copies that are being recorded
+    // or already submitted still execute.
+    void Cancel(AssetLoadHandle handle);
+
+    // Cancels the load if it has not finished and invalidates the handle.
+    void Release(AssetLoadHandle handle);
+
+    AssetLoadState GetState(AssetLoadHandle handle) const;
+
+    // Upload fence value for the asset's copies once it reaches Uploading
+    // with its copies recorded, otherwise 0. Queues that use the asset wait
+    // for it with UploadBatcher::WaitOnQueue.
+    uint64_t GetFenceValue(AssetLoadHandle handle) const;
+
+    void Update();
+
+    Stats GetStats() const;
+
+private:
+    enum Stage : uint8_t
+    {
+        c_StageRead,
+        c_StageDecompress,
+        c_StageTranscode,
+        c_StageUpload,
+        c_StageCount,
+        c_StageNone = c_StageCount,
+    };
+
+    struct Request
+    {
+        uint32_t generation = 0;
+        AssetLoadState state = AssetLoadState::Invalid;
+        AssetPriority priority = AssetPriority::Background;
+        Stage queue = c_StageNone;  // stage queue the request waits in
+        bool busy = false;          // owned by a read, job, upload or fence in flight
+        bool released = false;
+        bool cancelled = false;
+        uint64_t sequence = 0;
+        const AssetArchiveEntry* entry = nullptr;
+        AssetUploader uploader;
+        AssetTranscoder transcoder;
+        AlignedBuffer readBuffer;
+        std::vector<uint8_t> data;
+        uint64_t fenceValue = 0;
+    };
+
+    using QueueKey = std::pair<uint64_t, uint32_t>;     // priority and sequence, request index
+
+    Request* Find(AssetLoadHandle handle);
+    const Request* Find(AssetLoadHandle handle) const;
+
+    // Called with m_Mutex held.
+    void Enqueue(uint32_t index, Stage stage);
+    void Dequeue(uint32_t index);
+    void Fail(uint32_t index);
+    void CancelLocked(uint32_t index);
+    void DropData(Request& request);
+    void TryRecycle(uint32_t index);
+    void CompleteRead(const AsyncReadResult& result);
+    void StartReads();
+    void StartJobs();
+
+    void RunJobs();
+
+    AssetArchive& m_Archive;
+    JobSystem& m_Jobs;
+    UploadQueue& m_Uploads;
+    Limits m_Limits;
+
+    mutable std::mutex m_Mutex;
+    JobCounter m_JobCounter;
+    std::deque<Request> m_Requests;             // stable addresses for jobs
+    std::vector<uint32_t> m_FreeRequests;
+    std::set<QueueKey> m_Queues[c_StageCount];
+    std::vector<uint32_t> m_Uploading;          // recorded, waiting for the fence
+    uint64_t m_Sequence = 0;
+
+    uint32_t m_ReadsInFlight = 0;
+    uint64_t m_ReadBytes = 0;
+    uint32_t m_RunningJobs = 0;
+    uint32_t m_ProcessingCount = 0;             // requests inside a job
+    uint64_t m_ProcessedBytes = 0;
+};
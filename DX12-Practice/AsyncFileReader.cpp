@@ -0,0 +1,560 @@
+#include "AsyncFileReader.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#if defined(_WIN32)
+#include "Win.h"
+#include <vector>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+AsyncFileReader::AsyncFileReader(uint32_t queueDepth)
+    : m_QueueDepth(std::max(1u, queueDepth))
+{
+}
+
+AsyncFileReader::~AsyncFileReader()
+{
+    Close();
+}
+
+bool AsyncFileReader::Open(const std::filesystem::path& path, bool unbuffered)
+{
+    Close();
+    m_Platform = std::make_unique<Platform>();
+    if (!OpenFile(path, unbuffered))
+    {
+        m_Platform.reset();
+        return false;
+    }
+    return true;
+}
+
+void AsyncFileReader::Close()
+{
+    if (!m_Platform)
+    {
+        return;
+    }
+
+    // The kernel may still be writing into caller buffers.
+    m_Queued.clear();
+    AsyncReadResult results[32];
+    while (m_InFlight)
+    {
+        Poll(results, 32, true);
+    }
+    CloseFile();
+    m_Platform.reset();
+    m_FileSize = 0;
+    m_Unbuffered = false;
+}
+
+bool AsyncFileReader::IsOpen() const
+{
+    return m_Platform != nullptr;
+}
+
+void AsyncFileReader::Read(uint64_t offset, uint32_t size, void* buffer, uint64_t userData)
+{
+    assert(!m_Unbuffered || (offset % c_AsyncReadAlignment == 0 && size % c_AsyncReadAlignment == 0 &&
+        reinterpret_cast<uintptr_t>(buffer) % c_AsyncReadAlignment == 0));
+    m_Queued.push_back({ offset, size, buffer, userData });
+}
+
+uint32_t AsyncFileReader::Submit()
+{
+    uint32_t started = 0;
+    while (!m_Queued.empty() && m_InFlight < m_QueueDepth && Start(m_Queued.front()))
+    {
+        m_Queued.pop_front();
+        ++m_InFlight;
+        ++started;
+    }
+    if (started)
+    {
+        Flush();
+    }
+    return started;
+}
+
+void AsyncFileReader::SetSimulatedDevice(std::chrono::microseconds latency, uint64_t bytesPerSecond)
+{
+    m_SimulatedLatency = latency;
+    m_SimulatedBytesPerSecond = bytesPerSecond;
+}
+
+uint32_t AsyncFileReader::Poll(AsyncReadResult* results, uint32_t maxResults, bool wait)
+{
+    if (m_SimulatedLatency.count() || m_SimulatedBytesPerSecond || !m_Delayed.empty())
+    {
+        return PollSimulated(results, maxResults, wait);
+    }
+    Submit();
+
+    uint32_t count = 0;
+    for (; count < maxResults && !m_Completed.empty(); ++count)
+    {
+        results[count] = m_Completed.front();
+        m_Completed.pop_front();
+    }
+    if (count < maxResults)
+    {
+        count += Reap(results + count, maxResults - count, wait && count == 0 && m_InFlight > 0);
+    }
+    m_InFlight -= count;
+
+    // Completions freed ring slots for reads queued behind them.
+    Submit();
+    return count;
+}
+
+uint32_t AsyncFileReader::PollSimulated(AsyncReadResult* results, uint32_t maxResults, bool wait)
+{
+    using Clock = std::chrono::steady_clock;
+    Submit();
+
+    // Everything the kernel has finished joins the device's queue; block
+    // for a real completion only if nothing is waiting there either.
+    AsyncReadResult batch[32];
+    for (;;)
+    {
+        uint32_t count = 0;
+        for (; count < 32 && !m_Completed.empty(); ++count)
+        {
+            batch[count] = m_Completed.front();
+            m_Completed.pop_front();
+        }
+        uint32_t waiting = static_cast<uint32_t>(m_Delayed.size()) + count;
+        count += Reap(batch + count, 32 - count, wait && waiting == 0 && m_InFlight > waiting);
+
+        Clock::time_point now = Clock::now();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            auto transfer = m_SimulatedBytesPerSecond ? std::chrono::microseconds(
+                batch[i].bytesRead * 1000000ull / m_SimulatedBytesPerSecond) : std::chrono::microseconds(0);
+            m_SimulatedDeviceFree = std::max(now, m_SimulatedDeviceFree) + m_SimulatedLatency + transfer;
+            m_Delayed.push_back({ m_SimulatedDeviceFree, batch[i] });
+        }
+        if (count < 32)
+        {
+            break;
+        }
+    }
+
+    if (wait && !m_Delayed.empty())
+    {
+        std::this_thread::sleep_until(m_Delayed.front().due);
+    }
+    uint32_t count = 0;
+    Clock::time_point now = Clock::now();
+    for (; count < maxResults && !m_Delayed.empty() && m_Delayed.front().due <= now; ++count)
+    {
+        results[count] = m_Delayed.front().result;
+        m_Delayed.pop_front();
+    }
+    m_InFlight -= count;
+
+    Submit();
+    return count;
+}
+
+#if defined(_WIN32)
+
+void AlignedFree::operator()(uint8_t* data) const
+{
+    _aligned_free(data);
+}
+
+AlignedBuffer AllocateAlignedBuffer(size_t size)
+{
+    return AlignedBuffer(static_cast<uint8_t*>(_aligned_malloc(std::max<size_t>(size, 1), c_AsyncReadAlignment)));
+}
+
+struct AsyncFileReader::Platform
+{
+    struct Slot
+    {
+        OVERLAPPED overlapped;
+        uint64_t userData;
+    };
+
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE port = nullptr;
+    std::unique_ptr<Slot[]> slots;
+    std::vector<Slot*> freeSlots;
+};
+
+bool AsyncFileReader::OpenFile(const std::filesystem::path& path, bool unbuffered)
+{
+    DWORD flags = FILE_FLAG_OVERLAPPED | (unbuffered ? FILE_FLAG_NO_BUFFERING : 0);
+    HANDLE file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr);
+    if (file == INVALID_HANDLE_VALUE && unbuffered)
+    {
+        unbuffered = false;
+        file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_OVERLAPPED, nullptr);
+    }
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER size = {};
+    HANDLE port = ::GetFileSizeEx(file, &size) ? ::CreateIoCompletionPort(file, nullptr, 0, 1) : nullptr;
+    if (!port)
+    {
+        ::CloseHandle(file);
+        return false;
+    }
+
+    m_Platform->file = file;
+    m_Platform->port = port;
+    m_Platform->slots = std::make_unique<Platform::Slot[]>(m_QueueDepth);
+    for (uint32_t i = 0; i < m_QueueDepth; ++i)
+    {
+        m_Platform->freeSlots.push_back(&m_Platform->slots[i]);
+    }
+    m_FileSize = static_cast<uint64_t>(size.QuadPart);
+    m_Unbuffered = unbuffered;
+    return true;
+}
+
+void AsyncFileReader::CloseFile()
+{
+    ::CloseHandle(m_Platform->port);
+    ::CloseHandle(m_Platform->file);
+}
+
+bool AsyncFileReader::Start(const Request& request)
+{
+    if (m_Platform->freeSlots.empty())
+    {
+        return false;
+    }
+    Platform::Slot* slot = m_Platform->freeSlots.back();
+    m_Platform->freeSlots.pop_back();
+
+    memset(&slot->overlapped, 0, sizeof(slot->overlapped));
+    slot->overlapped.Offset = static_cast<DWORD>(request.offset);
+    slot->overlapped.OffsetHigh = static_cast<DWORD>(request.offset >> 32);
+    slot->userData = request.userData;
+
+    // A read that completes synchronously still posts a completion packet;
+    // one that fails does not.
+    if (!::ReadFile(m_Platform->file, request.buffer, request.size, nullptr, &slot->overlapped))
+    {
+        DWORD error = ::GetLastError();
+        if (error != ERROR_IO_PENDING)
+        {
+            m_Completed.push_back({ request.userData, 0, error == ERROR_HANDLE_EOF });
+            m_Platform->freeSlots.push_back(slot);
+        }
+    }
+    return true;
+}
+
+void AsyncFileReader::Flush()
+{
+}
+
+uint32_t AsyncFileReader::Reap(AsyncReadResult* results, uint32_t maxResults, bool wait)
+{
+    OVERLAPPED_ENTRY entries[64];
+    ULONG removed = 0;
+    ULONG count = static_cast<ULONG>(std::min<uint32_t>(maxResults, _countof(entries)));
+    if (!::GetQueuedCompletionStatusEx(m_Platform->port, entries, count, &removed, wait ? INFINITE : 0, FALSE))
+    {
+        return 0;
+    }
+
+    for (ULONG i = 0; i < removed; ++i)
+    {
+        auto slot = CONTAINING_RECORD(entries[i].lpOverlapped, Platform::Slot, overlapped);
+        DWORD bytes = 0;
+        bool ok = ::GetOverlappedResult(m_Platform->file, &slot->overlapped, &bytes, FALSE) ||
+            ::GetLastError() == ERROR_HANDLE_EOF;
+        results[i] = { slot->userData, static_cast<uint32_t>(bytes), ok };
+        m_Platform->freeSlots.push_back(slot);
+    }
+    return removed;
+}
+
+#else
+
+void AlignedFree::operator()(uint8_t* data) const
+{
+    free(data);
+}
+
+AlignedBuffer AllocateAlignedBuffer(size_t size)
+{
+    size_t alignedSize = (std::max<size_t>(size, 1) + c_AsyncReadAlignment - 1) / c_AsyncReadAlignment * c_AsyncReadAlignment;
+    return AlignedBuffer(static_cast<uint8_t*>(aligned_alloc(c_AsyncReadAlignment, alignedSize)));
+}
+
+namespace
+{
+    int SetupRing(uint32_t entries, io_uring_params* params)
+    {
+        return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    int EnterRing(int ring, uint32_t submit, uint32_t minComplete, uint32_t flags)
+    {
+        return static_cast<int>(syscall(__NR_io_uring_enter, ring, submit, minComplete, flags, nullptr, 0));
+    }
+
+    // IORING_OP_READ needs Linux 5.6; before that io_uring_setup succeeds
+    // but every read fails with EINVAL. The probe is 5.6 too, so a failing
+    // probe also means no read.
+    bool IsReadSupported(int ring)
+    {
+        const uint32_t c_ProbeOps = 256;
+        alignas(io_uring_probe) uint8_t storage[sizeof(io_uring_probe) + c_ProbeOps * sizeof(io_uring_probe_op)] = {};
+        auto probe = reinterpret_cast<io_uring_probe*>(storage);
+        if (syscall(__NR_io_uring_register, ring, IORING_REGISTER_PROBE, probe, c_ProbeOps) < 0)
+        {
+            return false;
+        }
+        return probe->last_op >= IORING_OP_READ && (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) != 0;
+    }
+
+    // The kernel reads and writes the ring indices concurrently.
+    uint32_t LoadAcquire(const uint32_t* value)
+    {
+        return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+    }
+
+    void StoreRelease(uint32_t* value, uint32_t newValue)
+    {
+        __atomic_store_n(value, newValue, __ATOMIC_RELEASE);
+    }
+}
+
+struct AsyncFileReader::Platform
+{
+    int file = -1;
+    int ring = -1;              // -1: pread fallback
+
+    void* sqRing = MAP_FAILED;
+    size_t sqRingSize = 0;
+    void* cqRing = MAP_FAILED;
+    size_t cqRingSize = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqesSize = 0;
+
+    uint32_t* sqHead;
+    uint32_t* sqTail;
+    uint32_t sqMask;
+    uint32_t sqEntries;
+    uint32_t* sqArray;
+    uint32_t* cqHead;
+    uint32_t* cqTail;
+    uint32_t cqMask;
+    io_uring_cqe* cqes;
+
+    uint32_t unsubmitted = 0;   // SQEs written but not yet passed to io_uring_enter
+
+    bool CreateRing(uint32_t queueDepth);
+    void DestroyRing();
+};
+
+bool AsyncFileReader::Platform::CreateRing(uint32_t queueDepth)
+{
+    io_uring_params params = {};
+    ring = SetupRing(queueDepth, &params);
+    if (ring < 0)
+    {
+        return false;
+    }
+    if (!IsReadSupported(ring))
+    {
+        DestroyRing();
+        return false;
+    }
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap)
+    {
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+    }
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+
+    sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING);
+    cqRing = singleMap ? sqRing :
+        mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_CQ_RING);
+    sqes = static_cast<io_uring_sqe*>(
+        mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES));
+    if (sqRing == MAP_FAILED || cqRing == MAP_FAILED || sqes == MAP_FAILED)
+    {
+        DestroyRing();
+        return false;
+    }
+
+    auto sq = static_cast<uint8_t*>(sqRing);
+    sqHead = reinterpret_cast<uint32_t*>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+    sqMask = *reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+    sqEntries = *reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_entries);
+    sqArray = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+
+    auto cq = static_cast<uint8_t*>(cqRing);
+    cqHead = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+    cqMask = *reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+}
+
+void AsyncFileReader::Platform::DestroyRing()
+{
+    if (sqes != MAP_FAILED)
+    {
+        munmap(sqes, sqesSize);
+    }
+    if (cqRing != MAP_FAILED && cqRing != sqRing)
+    {
+        munmap(cqRing, cqRingSize);
+    }
+    if (sqRing != MAP_FAILED)
+    {
+        munmap(sqRing, sqRingSize);
+    }
+    if (ring >= 0)
+    {
+        close(ring);
+    }
+    sqRing = cqRing = MAP_FAILED;
+    sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    ring = -1;
+}
+
+bool AsyncFileReader::OpenFile(const std::filesystem::path& path, bool unbuffered)
+{
+    // tmpfs and some network file systems reject O_DIRECT.
+    int file = unbuffered ? open(path.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT) : -1;
+    m_Unbuffered = file >= 0;
+    if (file < 0)
+    {
+        file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+
+    struct stat info = {};
+    if (file < 0 || fstat(file, &info) != 0)
+    {
+        if (file >= 0)
+        {
+            close(file);
+        }
+        m_Unbuffered = false;
+        return false;
+    }
+
+    m_Platform->file = file;
+    m_Platform->CreateRing(m_QueueDepth);
+    m_FileSize = static_cast<uint64_t>(info.st_size);
+    return true;
+}
+
+void AsyncFileReader::CloseFile()
+{
+    m_Platform->DestroyRing();
+    close(m_Platform->file);
+}
+
+bool AsyncFileReader::Start(const Request& request)
+{
+    Platform& platform = *m_Platform;
+    if (platform.ring < 0)
+    {
+        ssize_t bytes;
+        do
+        {
+            bytes = pread(platform.file, request.buffer, request.size, static_cast<off_t>(request.offset));
+        } while (bytes < 0 && errno == EINTR);
+        m_Completed.push_back({ request.userData, bytes > 0 ? static_cast<uint32_t>(bytes) : 0, bytes >= 0 });
+        return true;
+    }
+
+    uint32_t tail = *platform.sqTail;
+    if (tail - LoadAcquire(platform.sqHead) >= platform.sqEntries)
+    {
+        return false;
+    }
+
+    uint32_t index = tail & platform.sqMask;
+    io_uring_sqe& sqe = platform.sqes[index];
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = IORING_OP_READ;
+    sqe.fd = platform.file;
+    sqe.off = request.offset;
+    sqe.addr = reinterpret_cast<uintptr_t>(request.buffer);
+    sqe.len = request.size;
+    sqe.user_data = request.userData;
+    platform.sqArray[index] = index;
+    StoreRelease(platform.sqTail, tail + 1);
+    ++platform.unsubmitted;
+    return true;
+}
+
+void AsyncFileReader::Flush()
+{
+    Platform& platform = *m_Platform;
+    while (platform.ring >= 0 && platform.unsubmitted)
+    {
+        int submitted = EnterRing(platform.ring, platform.unsubmitted, 0, 0);
+        if (submitted < 0 && errno != EINTR)
+        {
+            break; // retried by the next Flush or Reap
+        }
+        platform.unsubmitted -= std::max(submitted, 0);
+    }
+}
+
+uint32_t AsyncFileReader::Reap(AsyncReadResult* results, uint32_t maxResults, bool wait)
+{
+    Platform& platform = *m_Platform;
+    if (platform.ring < 0)
+    {
+        return 0;
+    }
+
+    for (;;)
+    {
+        uint32_t count = 0;
+        uint32_t head = *platform.cqHead;
+        uint32_t tail = LoadAcquire(platform.cqTail);
+        for (; head != tail && count < maxResults; ++head, ++count)
+        {
+            const io_uring_cqe& cqe = platform.cqes[head & platform.cqMask];
+            results[count] = { cqe.user_data, cqe.res > 0 ? static_cast<uint32_t>(cqe.res) : 0, cqe.res >= 0 };
+        }
+        StoreRelease(platform.cqHead, head);
+        if (count || !wait)
+        {
+            return count;
+        }
+
+        int submitted = EnterRing(platform.ring, platform.unsubmitted, 1, IORING_ENTER_GETEVENTS);
+        if (submitted < 0 && errno != EINTR)
+        {
+            return 0;
+        }
+        platform.unsubmitted -= std::max(submitted, 0);
+    }
+}
+
+#endif
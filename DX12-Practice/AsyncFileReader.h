@@ -0,0 +1,115 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+
+// Offsets, sizes and buffers of unbuffered reads must be multiples of this
+// (the largest sector size in common use).
+constexpr uint32_t c_AsyncReadAlignment = 4096;
+
+struct AlignedFree
+{
+    void operator()(uint8_t* data) const;
+};
+using AlignedBuffer = std::unique_ptr<uint8_t[], AlignedFree>;
+
+// Returns size bytes aligned to c_AsyncReadAlignment, or null.
+AlignedBuffer AllocateAlignedBuffer(size_t size);
+
+struct AsyncReadResult
+{
+    uint64_t userData;
+    uint32_t bytesRead;         // may be short at the end of the file
+    bool ok;
+};
+
+// Reads one file with many requests in flight: io_uring on Linux (raw
+// syscalls, no liburing), overlapped ReadFile on an I/O completion port on
+// Windows. Read() only queues; Submit() hands the queue to the kernel in one
+// batch and Poll() collects completions. Not thread-safe: one thread owns
+// the reader and fans results out.
+//
+// Unbuffered reads (O_DIRECT / FILE_FLAG_NO_BUFFERING) bypass the page cache,
+// which is what a streaming load wants; if the file system refuses them the
+// file is opened buffered instead. Where io_uring is unavailable or cannot
+// read (kernels before 5.6, seccomp filters) reads fall back to pread inside
+// Submit().
+class AsyncFileReader
+{
+public:
+    explicit AsyncFileReader(uint32_t queueDepth = 64);
+    ~AsyncFileReader();
+
+    AsyncFileReader(const AsyncFileReader&) = delete;
+    AsyncFileReader& operator=(const AsyncFileReader&) = delete;
+
+    bool Open(const std::filesystem::path& path, bool unbuffered = true);
+    // Waits for reads in flight, then closes the file.
+    void Close();
+
+    bool IsOpen() const;
+    bool IsUnbuffered() const { return m_Unbuffered; }
+    uint64_t GetFileSize() const { return m_FileSize; }
+
+    void Read(uint64_t offset, uint32_t size, void* buffer, uint64_t userData);
+
+    // Starts as many queued reads as the queue depth allows; returns how many.
+    uint32_t Submit();
+
+    // Copies up to maxResults completions into results; with wait set, blocks
+    // until at least one is available unless nothing is outstanding. Reads
+    // still queued behind a full ring are submitted as slots free up.
+    uint32_t Poll(AsyncReadResult* results, uint32_t maxResults, bool wait);
+
+    // Reads queued or in flight.
+    uint32_t GetOutstandingCount() const { return static_cast<uint32_t>(m_Queued.size()) + m_InFlight; }
+
+    // Makes the file look like it sits on a slower device, for benchmarking
+    // streaming: each read completes latency plus size / bytesPerSecond after
+    // the previous one, counted from when the real read finished, and keeps
+    // its queue slot until then. Zero for both turns it off (the default).
+    void SetSimulatedDevice(std::chrono::microseconds latency, uint64_t bytesPerSecond);
+
+private:
+    struct Request
+    {
+        uint64_t offset;
+        uint32_t size;
+        void* buffer;
+        uint64_t userData;
+    };
+
+    struct DelayedResult
+    {
+        std::chrono::steady_clock::time_point due;
+        AsyncReadResult result;
+    };
+
+    struct Platform;
+
+    // Implemented per platform.
+    bool OpenFile(const std::filesystem::path& path, bool unbuffered);
+    void CloseFile();
+    // Starts one read; false if the kernel queue is full. Reads that finish
+    // (or fail) immediately go to m_Completed.
+    bool Start(const Request& request);
+    void Flush();
+    uint32_t Reap(AsyncReadResult* results, uint32_t maxResults, bool wait);
+    uint32_t PollSimulated(AsyncReadResult* results, uint32_t maxResults, bool wait);
+
+    uint32_t m_QueueDepth;
+    std::unique_ptr<Platform> m_Platform;
+    std::deque<Request> m_Queued;
+    std::deque<AsyncReadResult> m_Completed;
+    uint32_t m_InFlight = 0;    // started and not yet returned by Poll
+    uint64_t m_FileSize = 0;
+    bool m_Unbuffered = false;
+
+    std::chrono::microseconds m_SimulatedLatency{ 0 };
+    uint64_t m_SimulatedBytesPerSecond = 0;
+    std::chrono::steady_clock::time_point m_SimulatedDeviceFree;
+    std::deque<DelayedResult> m_Delayed;    // due in order
+};
@@ -0,0 +1,766 @@
+#include "BCEncoder.h"
+#include "CpuFeatures.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+// SSE2 is part of every x64 target; AVX2 is picked at run time (see
+// CpuFeatures.h).
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BC_SSE2 1
+#endif
+#if defined(PRACTICE_X86)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    const uint32_t c_BlocksPerJob = 256;
+
+    // BC7 4-bit index interpolation weights (out of 64).
+    const uint32_t c_BC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    // One block as planar floats in [0, 255], so the palette search can run
+    // over 8 (AVX2) or 4 (SSE2) pixels at a time.
+    struct BlockPixels
+    {
+        alignas(32) float channels[4][16];
+    };
+
+    // Palette entries, planar and indexed by the same channel as the pixels.
+    struct Palette
+    {
+        alignas(32) float channels[4][16];
+        uint32_t count;
+    };
+
+    // Writes bit fields LSB first, as all BC formats are laid out.
+    struct BitWriter
+    {
+        uint8_t* data;
+        uint32_t position;
+
+        void Write(uint32_t value, uint32_t bits)
+        {
+            for (uint32_t i = 0; i < bits; ++i, ++position)
+            {
+                data[position >> 3] |= static_cast<uint8_t>(((value >> i) & 1) << (position & 7));
+            }
+        }
+    };
+
+    float Clamp255(float value)
+    {
+        return std::min(std::max(value, 0.0f), 255.0f);
+    }
+
+    BCSimd GetBestBCSimd()
+    {
+        static const BCSimd s_Best = IsAvx2Supported() ? BCSimd::Avx2 :
+#if defined(BC_SSE2)
+            BCSimd::Sse2;
+#else
+            BCSimd::None;
+#endif
+        return s_Best;
+    }
+
+    std::atomic<BCSimd> g_BCSimd{ BCSimd::Best };
+
+    // The palette searches: for every pixel, the nearest palette entry over
+    // channels [first, first + count); returns the summed squared error.
+    // All of them pick the same entries and add up the errors in the same
+    // order, so they produce identical blocks.
+#if defined(PRACTICE_X86)
+    PRACTICE_AVX2_TARGET float FindNearestAvx2(const BlockPixels& pixels, uint32_t first, uint32_t count,
+        const Palette& palette, uint8_t indices[16])
+    {
+        float total = 0.0f;
+        for (uint32_t base = 0; base < 16; base += 8)
+        {
+            __m256 values[4];
+            for (uint32_t c = 0; c < count; ++c)
+            {
+                values[c] = _mm256_load_ps(&pixels.channels[first + c][base]);
+            }
+
+            __m256 bestError = _mm256_set1_ps(FLT_MAX);
+            __m256 bestIndex = _mm256_setzero_ps();
+            for (uint32_t i = 0; i < palette.count; ++i)
+            {
+                __m256 error = _mm256_setzero_ps();
+                for (uint32_t c = 0; c < count; ++c)
+                {
+                    __m256 delta = _mm256_sub_ps(values[c], _mm256_set1_ps(palette.channels[first + c][i]));
+                    error = _mm256_add_ps(error, _mm256_mul_ps(delta, delta));
+                }
+                __m256 better = _mm256_cmp_ps(error, bestError, _CMP_LT_OQ);
+                bestError = _mm256_min_ps(error, bestError);
+                bestIndex = _mm256_blendv_ps(bestIndex, _mm256_set1_ps(static_cast<float>(i)), better);
+            }
+
+            alignas(32) int32_t laneIndices[8];
+            alignas(32) float laneErrors[8];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(laneIndices), _mm256_cvttps_epi32(bestIndex));
+            _mm256_store_ps(laneErrors, bestError);
+            for (uint32_t lane = 0; lane < 8; ++lane)
+            {
+                indices[base + lane] = static_cast<uint8_t>(laneIndices[lane]);
+                total += laneErrors[lane];
+            }
+        }
+        return total;
+    }
+#endif
+
+#if defined(BC_SSE2)
+    float FindNearestSse2(const BlockPixels& pixels, uint32_t first, uint32_t count, const Palette& palette, uint8_t indices[16])
+    {
+        float total = 0.0f;
+        for (uint32_t base = 0; base < 16; base += 4)
+        {
+            __m128 values[4];
+            for (uint32_t c = 0; c < count; ++c)
+            {
+                values[c] = _mm_load_ps(&pixels.channels[first + c][base]);
+            }
+
+            __m128 bestError = _mm_set1_ps(FLT_MAX);
+            __m128 bestIndex = _mm_setzero_ps();
+            for (uint32_t i = 0; i < palette.count; ++i)
+            {
+                __m128 error = _mm_setzero_ps();
+                for (uint32_t c = 0; c < count; ++c)
+                {
+                    __m128 delta = _mm_sub_ps(values[c], _mm_set1_ps(palette.channels[first + c][i]));
+                    error = _mm_add_ps(error, _mm_mul_ps(delta, delta));
+                }
+                __m128 better = _mm_cmplt_ps(error, bestError);
+                bestError = _mm_min_ps(error, bestError);
+                bestIndex = _mm_or_ps(_mm_and_ps(better, _mm_set1_ps(static_cast<float>(i))), _mm_andnot_ps(better, bestIndex));
+            }
+
+            alignas(16) int32_t laneIndices[4];
+            alignas(16) float laneErrors[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(laneIndices), _mm_cvttps_epi32(bestIndex));
+            _mm_store_ps(laneErrors, bestError);
+            for (uint32_t lane = 0; lane < 4; ++lane)
+            {
+                indices[base + lane] = static_cast<uint8_t>(laneIndices[lane]);
+                total += laneErrors[lane];
+            }
+        }
+        return total;
+    }
+#endif
+
+    float FindNearestScalar(const BlockPixels& pixels, uint32_t first, uint32_t count, const Palette& palette, uint8_t indices[16])
+    {
+        float total = 0.0f;
+        for (uint32_t pixel = 0; pixel < 16; ++pixel)
+        {
+            float bestError = FLT_MAX;
+            for (uint32_t i = 0; i < palette.count; ++i)
+            {
+                float error = 0.0f;
+                for (uint32_t c = first; c < first + count; ++c)
+                {
+                    float delta = pixels.channels[c][pixel] - palette.channels[c][i];
+                    error += delta * delta;
+                }
+                if (error < bestError)
+                {
+                    bestError = error;
+                    indices[pixel] = static_cast<uint8_t>(i);
+                }
+            }
+            total += bestError;
+        }
+        return total;
+    }
+
+    float FindNearest(const BlockPixels& pixels, uint32_t first, uint32_t count, const Palette& palette, uint8_t indices[16])
+    {
+        switch (GetBCSimd())
+        {
+#if defined(PRACTICE_X86)
+        case BCSimd::Avx2:
+            return FindNearestAvx2(pixels, first, count, palette, indices);
+#endif
+#if defined(BC_SSE2)
+        case BCSimd::Sse2:
+            return FindNearestSse2(pixels, first, count, palette, indices);
+#endif
+        default:
+            return FindNearestScalar(pixels, first, count, palette, indices);
+        }
+    }
+
+    // Initial endpoints: the bounding box for Fast, otherwise the extent of
+    // the block along its principal axis.
+    void FitEndpoints(const BlockPixels& pixels, uint32_t first, uint32_t count, BCQuality quality, float e0[4], float e1[4])
+    {
+        float minimum[4], maximum[4], mean[4];
+        for (uint32_t c = first; c < first + count; ++c)
+        {
+            const float* values = pixels.channels[c];
+            minimum[c] = *std::min_element(values, values + 16);
+            maximum[c] = *std::max_element(values, values + 16);
+            mean[c] = 0.0f;
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                mean[c] += values[i];
+            }
+            mean[c] /= 16.0f;
+            e0[c] = minimum[c];
+            e1[c] = maximum[c];
+        }
+        if (quality == BCQuality::Fast || count == 1)
+        {
+            return;
+        }
+
+        float covariance[4][4] = {};
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            for (uint32_t a = first; a < first + count; ++a)
+            {
+                for (uint32_t b = first; b < first + count; ++b)
+                {
+                    covariance[a][b] += (pixels.channels[a][i] - mean[a]) * (pixels.channels[b][i] - mean[b]);
+                }
+            }
+        }
+
+        // Power iteration from the box diagonal.
+        float axis[4];
+        for (uint32_t c = first; c < first + count; ++c)
+        {
+            axis[c] = maximum[c] - minimum[c];
+        }
+        for (uint32_t iteration = 0; iteration < 8; ++iteration)
+        {
+            float next[4] = {};
+            float length = 0.0f;
+            for (uint32_t a = first; a < first + count; ++a)
+            {
+                for (uint32_t b = first; b < first + count; ++b)
+                {
+                    next[a] += covariance[a][b] * axis[b];
+                }
+                length = std::max(length, std::fabs(next[a]));
+            }
+            if (length < 1e-6f)
+            {
+                return;     // flat block: keep the box
+            }
+            for (uint32_t c = first; c < first + count; ++c)
+            {
+                axis[c] = next[c] / length;
+            }
+        }
+
+        float lengthSquared = 0.0f;
+        for (uint32_t c = first; c < first + count; ++c)
+        {
+            lengthSquared += axis[c] * axis[c];
+        }
+        float lowest = FLT_MAX;
+        float highest = -FLT_MAX;
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            float projection = 0.0f;
+            for (uint32_t c = first; c < first + count; ++c)
+            {
+                projection += (pixels.channels[c][i] - mean[c]) * axis[c];
+            }
+            lowest = std::min(lowest, projection);
+            highest = std::max(highest, projection);
+        }
+        for (uint32_t c = first; c < first + count; ++c)
+        {
+            e0[c] = Clamp255(mean[c] + axis[c] * lowest / lengthSquared);
+            e1[c] = Clamp255(mean[c] + axis[c] * highest / lengthSquared);
+        }
+    }
+
+    // Least-squares endpoints for fixed interpolation weights (0 selects e0,
+    // 1 selects e1; negative excludes the pixel). False if degenerate.
+    bool RefineEndpoints(const BlockPixels& pixels, uint32_t first, uint32_t count, const float weights[16], float e0[4], float e1[4])
+    {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float rhs0[4] = {}, rhs1[4] = {};
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            float t = weights[i];
+            if (t < 0.0f)
+            {
+                continue;
+            }
+            float s = 1.0f - t;
+            aa += s * s;
+            ab += s * t;
+            bb += t * t;
+            for (uint32_t c = first; c < first + count; ++c)
+            {
+                rhs0[c] += s * pixels.channels[c][i];
+                rhs1[c] += t * pixels.channels[c][i];
+            }
+        }
+
+        float determinant = aa * bb - ab * ab;
+        if (std::fabs(determinant) < 1e-6f)
+        {
+            return false;
+        }
+        for (uint32_t c = first; c < first + count; ++c)
+        {
+            e0[c] = Clamp255((bb * rhs0[c] - ab * rhs1[c]) / determinant);
+            e1[c] = Clamp255((aa * rhs1[c] - ab * rhs0[c]) / determinant);
+        }
+        return true;
+    }
+
+    uint32_t GetIterationCount(BCQuality quality)
+    {
+        return quality == BCQuality::Fast ? 1 : quality == BCQuality::Normal ? 2 : 4;
+    }
+
+    uint16_t QuantizeRGB565(const float color[4])
+    {
+        uint32_t r = static_cast<uint32_t>(color[0] * 31.0f / 255.0f + 0.5f);
+        uint32_t g = static_cast<uint32_t>(color[1] * 63.0f / 255.0f + 0.5f);
+        uint32_t b = static_cast<uint32_t>(color[2] * 31.0f / 255.0f + 0.5f);
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    void ExpandRGB565(uint16_t color, float out[3])
+    {
+        uint32_t r = (color >> 11) & 31;
+        uint32_t g = (color >> 5) & 63;
+        uint32_t b = color & 31;
+        out[0] = static_cast<float>((r << 3) | (r >> 2));
+        out[1] = static_cast<float>((g << 2) | (g >> 4));
+        out[2] = static_cast<float>((b << 3) | (b >> 2));
+    }
+
+    void EncodeBC1(const BlockPixels& pixels, BCQuality quality, uint8_t* output)
+    {
+        // Palette index -> position between color0 and color1.
+        const float c_Weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+        float e0[4], e1[4];
+        FitEndpoints(pixels, 0, 3, quality, e0, e1);
+
+        float bestError = FLT_MAX;
+        uint16_t bestColors[2] = {};
+        uint8_t bestIndices[16] = {};
+        for (uint32_t iteration = 0, count = GetIterationCount(quality); iteration < count; ++iteration)
+        {
+            // Four-colour mode needs color0 > color1; equal endpoints decode
+            // as three-colour mode, where only index 0 is the same colour.
+            uint16_t color0 = QuantizeRGB565(e0);
+            uint16_t color1 = QuantizeRGB565(e1);
+            if (color0 < color1)
+            {
+                std::swap(color0, color1);
+                std::swap(e0, e1);
+            }
+
+            Palette palette = {};
+            float endpoint0[3], endpoint1[3];
+            ExpandRGB565(color0, endpoint0);
+            ExpandRGB565(color1, endpoint1);
+            palette.count = color0 == color1 ? 1 : 4;
+            for (uint32_t c = 0; c < 3; ++c)
+            {
+                palette.channels[c][0] = endpoint0[c];
+                palette.channels[c][1] = endpoint1[c];
+                palette.channels[c][2] = std::floor((2.0f * endpoint0[c] + endpoint1[c]) / 3.0f);
+                palette.channels[c][3] = std::floor((endpoint0[c] + 2.0f * endpoint1[c]) / 3.0f);
+            }
+
+            uint8_t indices[16];
+            float error = FindNearest(pixels, 0, 3, palette, indices);
+            if (error < bestError)
+            {
+                bestError = error;
+                bestColors[0] = color0;
+                bestColors[1] = color1;
+                memcpy(bestIndices, indices, sizeof(indices));
+            }
+
+            float weights[16];
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                weights[i] = c_Weights[indices[i]];
+            }
+            if (bestError == 0.0f || !RefineEndpoints(pixels, 0, 3, weights, e0, e1))
+            {
+                break;
+            }
+        }
+
+        memset(output, 0, 8);
+        BitWriter writer = { output, 0 };
+        writer.Write(bestColors[0], 16);
+        writer.Write(bestColors[1], 16);
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            writer.Write(bestIndices[i], 2);
+        }
+    }
+
+    // Eight-value (e0 > e1) or six-value (e0 <= e1, plus 0 and 255) palette.
+    void MakeBC4Palette(uint32_t e0, uint32_t e1, uint32_t channel, Palette& palette)
+    {
+        float* values = palette.channels[channel];
+        values[0] = static_cast<float>(e0);
+        values[1] = static_cast<float>(e1);
+        if (e0 > e1)
+        {
+            for (uint32_t i = 2; i < 8; ++i)
+            {
+                values[i] = ((8 - i) * values[0] + (i - 1) * values[1]) / 7.0f;
+            }
+        }
+        else
+        {
+            for (uint32_t i = 2; i < 6; ++i)
+            {
+                values[i] = ((6 - i) * values[0] + (i - 1) * values[1]) / 5.0f;
+            }
+            values[6] = 0.0f;
+            values[7] = 255.0f;
+        }
+        palette.count = 8;
+    }
+
+    float EncodeBC4Mode(const BlockPixels& pixels, uint32_t channel, BCQuality quality, bool sixValues,
+        uint8_t endpoints[2], uint8_t bestIndices[16])
+    {
+        const float* values = pixels.channels[channel];
+        float e0[4], e1[4];
+        if (sixValues)
+        {
+            // The extremes come for free; fit the rest.
+            e0[channel] = 255.0f;
+            e1[channel] = 0.0f;
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                if (values[i] > 0.0f && values[i] < 255.0f)
+                {
+                    e0[channel] = std::min(e0[channel], values[i]);
+                    e1[channel] = std::max(e1[channel], values[i]);
+                }
+            }
+            if (e0[channel] > e1[channel])
+            {
+                e0[channel] = e1[channel] = 0.0f;
+            }
+        }
+        else
+        {
+            FitEndpoints(pixels, channel, 1, quality, e1, e0);
+        }
+
+        float bestError = FLT_MAX;
+        for (uint32_t iteration = 0, count = GetIterationCount(quality); iteration < count; ++iteration)
+        {
+            uint32_t q0 = static_cast<uint32_t>(Clamp255(e0[channel]) + 0.5f);
+            uint32_t q1 = static_cast<uint32_t>(Clamp255(e1[channel]) + 0.5f);
+            if (sixValues ? q0 > q1 : q0 < q1)
+            {
+                std::swap(q0, q1);
+                std::swap(e0[channel], e1[channel]);
+            }
+
+            Palette palette = {};
+            MakeBC4Palette(q0, q1, channel, palette);
+            uint8_t indices[16];
+            float error = FindNearest(pixels, channel, 1, palette, indices);
+            if (error < bestError)
+            {
+                bestError = error;
+                endpoints[0] = static_cast<uint8_t>(q0);
+                endpoints[1] = static_cast<uint8_t>(q1);
+                memcpy(bestIndices, indices, sizeof(indices));
+            }
+
+            float weights[16];
+            uint32_t steps = sixValues ? 5 : 7;
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                uint32_t index = indices[i];
+                weights[i] = index == 0 ? 0.0f : index == 1 ? 1.0f : index - 1 < steps ? (index - 1) / float(steps) : -1.0f;
+            }
+            if (bestError == 0.0f || !RefineEndpoints(pixels, channel, 1, weights, e0, e1))
+            {
+                break;
+            }
+        }
+        return bestError;
+    }
+
+    void EncodeBC4(const BlockPixels& pixels, uint32_t channel, BCQuality quality, uint8_t* output)
+    {
+        uint8_t endpoints[2];
+        uint8_t indices[16];
+        float error = EncodeBC4Mode(pixels, channel, quality, false, endpoints, indices);
+        if (quality == BCQuality::High && error > 0.0f)
+        {
+            uint8_t sixEndpoints[2];
+            uint8_t sixIndices[16];
+            if (EncodeBC4Mode(pixels, channel, quality, true, sixEndpoints, sixIndices) < error)
+            {
+                memcpy(endpoints, sixEndpoints, sizeof(endpoints));
+                memcpy(indices, sixIndices, sizeof(indices));
+            }
+        }
+
+        memset(output, 0, 8);
+        BitWriter writer = { output, 0 };
+        writer.Write(endpoints[0], 8);
+        writer.Write(endpoints[1], 8);
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            writer.Write(indices[i], 3);
+        }
+    }
+
+    // Mode 6 endpoints are 7 bits per channel plus a shared p-bit as LSB.
+    uint32_t QuantizeBC7Mode6(float value, uint32_t pBit)
+    {
+        int32_t quantized = static_cast<int32_t>(std::floor((value - pBit) * 0.5f + 0.5f));
+        return static_cast<uint32_t>(std::min(std::max(quantized, 0), 127));
+    }
+
+    float EvaluateBC7Mode6(const BlockPixels& pixels, const uint32_t endpoints[2][4], uint8_t indices[16])
+    {
+        Palette palette;
+        palette.count = 16;
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                uint32_t weight = c_BC7Weights[i];
+                palette.channels[c][i] = static_cast<float>(((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] + 32) >> 6);
+            }
+        }
+        return FindNearest(pixels, 0, 4, palette, indices);
+    }
+
+    void EncodeBC7(const BlockPixels& pixels, BCQuality quality, uint8_t* output)
+    {
+        float e[2][4];
+        FitEndpoints(pixels, 0, 4, quality, e[0], e[1]);
+
+        float bestError = FLT_MAX;
+        uint32_t bestQuantized[2][4] = {};
+        uint32_t bestPBits[2] = {};
+        uint8_t bestIndices[16] = {};
+        for (uint32_t iteration = 0, count = GetIterationCount(quality); iteration < count; ++iteration)
+        {
+            // High tries every p-bit pair; otherwise each endpoint takes the
+            // p-bit that quantizes it best.
+            uint32_t candidates[4][2];
+            uint32_t candidateCount = 0;
+            if (quality == BCQuality::High)
+            {
+                for (uint32_t pair = 0; pair < 4; ++pair)
+                {
+                    candidates[candidateCount][0] = pair & 1;
+                    candidates[candidateCount][1] = pair >> 1;
+                    ++candidateCount;
+                }
+            }
+            else
+            {
+                for (uint32_t endpoint = 0; endpoint < 2; ++endpoint)
+                {
+                    float errors[2] = {};
+                    for (uint32_t pBit = 0; pBit < 2; ++pBit)
+                    {
+                        for (uint32_t c = 0; c < 4; ++c)
+                        {
+                            float delta = float((QuantizeBC7Mode6(e[endpoint][c], pBit) << 1) | pBit) - e[endpoint][c];
+                            errors[pBit] += delta * delta;
+                        }
+                    }
+                    candidates[0][endpoint] = errors[1] < errors[0] ? 1 : 0;
+                }
+                candidateCount = 1;
+            }
+
+            uint8_t iterationIndices[16] = {};
+            float iterationError = FLT_MAX;
+            for (uint32_t candidate = 0; candidate < candidateCount; ++candidate)
+            {
+                uint32_t quantized[2][4];
+                uint32_t endpoints[2][4];
+                for (uint32_t endpoint = 0; endpoint < 2; ++endpoint)
+                {
+                    for (uint32_t c = 0; c < 4; ++c)
+                    {
+                        quantized[endpoint][c] = QuantizeBC7Mode6(e[endpoint][c], candidates[candidate][endpoint]);
+                        endpoints[endpoint][c] = (quantized[endpoint][c] << 1) | candidates[candidate][endpoint];
+                    }
+                }
+
+                uint8_t indices[16];
+                float error = EvaluateBC7Mode6(pixels, endpoints, indices);
+                if (error < iterationError)
+                {
+                    iterationError = error;
+                    memcpy(iterationIndices, indices, sizeof(indices));
+                }
+                if (error < bestError)
+                {
+                    bestError = error;
+                    memcpy(bestQuantized, quantized, sizeof(quantized));
+                    bestPBits[0] = candidates[candidate][0];
+                    bestPBits[1] = candidates[candidate][1];
+                    memcpy(bestIndices, indices, sizeof(indices));
+                }
+            }
+
+            float weights[16];
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                weights[i] = c_BC7Weights[iterationIndices[i]] / 64.0f;
+            }
+            if (bestError == 0.0f || !RefineEndpoints(pixels, 0, 4, weights, e[0], e[1]))
+            {
+                break;
+            }
+        }
+
+        // The anchor (pixel 0) index has an implicit zero high bit.
+        if (bestIndices[0] & 8)
+        {
+            std::swap(bestQuantized[0], bestQuantized[1]);
+            std::swap(bestPBits[0], bestPBits[1]);
+            for (uint8_t& index : bestIndices)
+            {
+                index = static_cast<uint8_t>(15 - index);
+            }
+        }
+
+        memset(output, 0, 16);
+        BitWriter writer = { output, 0 };
+        writer.Write(1 << 6, 7);
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            writer.Write(bestQuantized[0][c], 7);
+            writer.Write(bestQuantized[1][c], 7);
+        }
+        writer.Write(bestPBits[0], 1);
+        writer.Write(bestPBits[1], 1);
+        writer.Write(bestIndices[0], 3);
+        for (uint32_t i = 1; i < 16; ++i)
+        {
+            writer.Write(bestIndices[i], 4);
+        }
+    }
+}
+
+BCSimd GetBCSimd()
+{
+    BCSimd simd = g_BCSimd.load(std::memory_order_relaxed);
+    return simd == BCSimd::Best ? GetBestBCSimd() : simd;
+}
+
+void SetBCSimd(BCSimd simd)
+{
+    BCSimd best = GetBestBCSimd();
+    g_BCSimd.store(simd == BCSimd::Best || simd > best ? best : simd, std::memory_order_relaxed);
+}
+
+uint32_t GetBCBlockSize(BCFormat format)
+{
+    return format == BCFormat::BC1 || format == BCFormat::BC4 ? 8 : 16;
+}
+
+size_t GetBCCompressedSize(BCFormat format, uint32_t width, uint32_t height)
+{
+    size_t blocksX = std::max(1u, (width + 3) / 4);
+    size_t blocksY = std::max(1u, (height + 3) / 4);
+    return blocksX * blocksY * GetBCBlockSize(format);
+}
+
+void CompressBlock(BCFormat format, BCQuality quality, const uint8_t block[64], uint8_t* output)
+{
+    BlockPixels pixels;
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            pixels.channels[c][i] = block[i * 4 + c];
+        }
+    }
+
+    switch (format)
+    {
+    case BCFormat::BC1:
+        EncodeBC1(pixels, quality, output);
+        break;
+    case BCFormat::BC3:
+        EncodeBC4(pixels, 3, quality, output);
+        EncodeBC1(pixels, quality, output + 8);
+        break;
+    case BCFormat::BC4:
+        EncodeBC4(pixels, 0, quality, output);
+        break;
+    case BCFormat::BC5:
+        EncodeBC4(pixels, 0, quality, output);
+        EncodeBC4(pixels, 1, quality, output + 8);
+        break;
+    case BCFormat::BC7:
+        EncodeBC7(pixels, quality, output);
+        break;
+    }
+}
+
+void CompressImage(const BCImage& image, BCFormat format, BCQuality quality, JobSystem* jobs, uint8_t* output)
+{
+    assert(image.width > 0 && image.height > 0);
+    uint32_t blocksX = (image.width + 3) / 4;
+    uint32_t blocksY = (image.height + 3) / 4;
+    uint32_t blockSize = GetBCBlockSize(format);
+
+    auto compressRange = [&](uint32_t begin, uint32_t end)
+    {
+        uint8_t block[64];
+        for (uint32_t index = begin; index < end; ++index)
+        {
+            uint32_t blockX = index % blocksX;
+            uint32_t blockY = index / blocksX;
+            for (uint32_t y = 0; y < 4; ++y)
+            {
+                uint32_t sourceY = std::min(blockY * 4 + y, image.height - 1);
+                const uint8_t* row = image.pixels + sourceY * image.rowPitch;
+                for (uint32_t x = 0; x < 4; ++x)
+                {
+                    uint32_t sourceX = std::min(blockX * 4 + x, image.width - 1);
+                    memcpy(block + (y * 4 + x) * 4, row + sourceX * 4, 4);
+                }
+            }
+            CompressBlock(format, quality, block, output + size_t(index) * blockSize);
+        }
+    };
+
+    uint32_t blockCount = blocksX * blocksY;
+    if (jobs)
+    {
+        jobs->ParallelFor(blockCount, c_BlocksPerJob, compressRange);
+    }
+    else
+    {
+        compressRange(0, blockCount);
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+class JobSystem;
+
+// Block compression encoder for offline texture cooking. Portable; the
+// per-block palette search uses AVX2 or SSE2, whichever the CPU supports.
+//
+// BC1 and the colour half of BC3 always use four-colour mode; BC4/BC5 use
+// the eight-value mode (High also tries the six-value mode); BC7 uses mode 6
+// (one subset, RGBA 7.7.7.7 + p-bit, 4-bit indices) for every block.
+enum class BCFormat
+{
+    BC1,    // RGB, 4 bpp
+    BC3,    // RGBA, 8 bpp
+    BC4,    // R, 4 bpp
+    BC5,    // RG, 8 bpp
+    BC7,    // RGBA, 8 bpp
+};
+
+enum class BCQuality
+{
+    Fast,   // bounding box endpoints, no refinement
+    Normal, // principal axis endpoints, one least-squares pass
+    High,   // several refinement passes and exhaustive p-bit / mode choices
+};
+
+// 8-bit RGBA pixels, rows rowPitch bytes apart.
+struct BCImage
+{
+    const uint8_t* pixels;
+    uint32_t width;
+    uint32_t height;
+    size_t rowPitch;
+};
+
+// Instruction set of the palette search. Best, the default, is the widest
+// one the CPU supports (checked once at run time). Every set produces the
+// same blocks.
+enum class BCSimd : uint32_t
+{
+    None,
+    Sse2,
+    Avx2,
+    Best,
+};
+
+// The instruction set in use, never Best.
+BCSimd GetBCSimd();
+// For comparisons and tests; sets wider than the CPU supports fall back to
+// the best supported one.
+void SetBCSimd(BCSimd simd);
+
+uint32_t GetBCBlockSize(BCFormat format);
+size_t GetBCCompressedSize(BCFormat format, uint32_t width, uint32_t height);
+
+// block: 4x4 RGBA pixels, row by row (64 bytes). output: GetBCBlockSize bytes.
+void CompressBlock(BCFormat format, BCQuality quality, const uint8_t block[64], uint8_t* output);
+
+// Compresses a whole image; partial edge blocks replicate the last row and
+// column. Blocks are spread over jobs when given. output holds
+// GetBCCompressedSize bytes, block rows tightly packed.
+void CompressImage(const BCImage& image, BCFormat format, BCQuality quality, JobSystem* jobs, uint8_t* output);
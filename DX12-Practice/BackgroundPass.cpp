@@ -0,0 +1,47 @@
+#include "BackgroundPass.h"
+#include "HlslLayout.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    constexpr HlslField c_BackgroundConstantFields[] = { HlslFloat3, HlslFloat, HlslFloat3, HlslFloat, HlslFloat3 };
+    static_assert(VerifyHlslLayout<BackgroundConstants>(c_BackgroundConstantFields, {
+        HLSL_MEMBER(BackgroundConstants, cameraRight),
+        HLSL_MEMBER(BackgroundConstants, inverseViewportWidth),
+        HLSL_MEMBER(BackgroundConstants, cameraUp),
+        HLSL_MEMBER(BackgroundConstants, inverseViewportHeight),
+        HLSL_MEMBER(BackgroundConstants, cameraForward) }), "BackgroundConstants does not match Background.hlsl");
+}
+
+BackgroundConstants GetBackgroundConstants(const float view[4][4], float verticalFov, uint32_t width, uint32_t height)
+{
+    // The camera axes are the columns of the view matrix.
+    float tanHalfHeight = std::tan(verticalFov * 0.5f);
+    float tanHalfWidth = tanHalfHeight * width / height;
+    BackgroundConstants constants = {};
+    for (int i = 0; i < 3; ++i)
+    {
+        constants.cameraRight[i] = view[i][0] * tanHalfWidth;
+        constants.cameraUp[i] = view[i][1] * tanHalfHeight;
+        constants.cameraForward[i] = view[i][2];
+    }
+    constants.inverseViewportWidth = 1.0f / width;
+    constants.inverseViewportHeight = 1.0f / height;
+    return constants;
+}
+
+void RecordBackgroundPass(RenderInterface& render, uint32_t pipeline, uint32_t renderTarget, uint32_t width, uint32_t height,
+    uint32_t constantsIndex, const BackgroundConstants& constants)
+{
+    uint32_t values[sizeof(BackgroundConstants) / 4];
+    memcpy(values, &constants, sizeof(values));
+
+    render.SetRenderTargets(1, &renderTarget, c_RenderNoResource);
+    render.SetViewport(0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f, 1.0f);
+    render.SetPipeline(pipeline);
+    render.SetRootConstants(constantsIndex, sizeof(values) / 4, values, 0);
+    render.SetPrimitiveTopology(c_RenderTopologyTriangleList);
+    render.Draw(3, 1, 0, 0);
+}
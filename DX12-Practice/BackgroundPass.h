@@ -0,0 +1,25 @@
+#pragma once
+#include "RenderInterface.h"
+
+#include <cstdint>
+
+// Root constants of shaders/Background.hlsl: the camera axes scaled to the
+// edges of the viewport, so the pixel shader can rebuild each pixel's view ray.
+struct BackgroundConstants
+{
+    float cameraRight[3];       // scaled by tan(horizontal fov / 2)
+    float inverseViewportWidth;
+    float cameraUp[3];          // scaled by tan(vertical fov / 2)
+    float inverseViewportHeight;
+    float cameraForward[3];
+};
+
+// view: row-major view matrix in DirectXMath convention; verticalFov in
+// radians.
+BackgroundConstants GetBackgroundConstants(const float view[4][4], float verticalFov, uint32_t width, uint32_t height);
+
+// Draws the sky over the whole render target, without depth. pipeline is
+// built from shaders/Background.hlsl; constantsIndex is the root parameter of
+// its BackgroundConstants.
+void RecordBackgroundPass(RenderInterface& render, uint32_t pipeline, uint32_t renderTarget, uint32_t width, uint32_t height,
+    uint32_t constantsIndex, const BackgroundConstants& constants);
@@ -0,0 +1,278 @@
+#include "Benchmark.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+    constexpr float c_Pi = 3.14159265f;
+
+    bool Fail(std::string* error, const std::string& message)
+    {
+        if (error)
+        {
+            *error = message;
+        }
+        return false;
+    }
+
+    // Splits at whitespace; double quotes group, as in a Windows command line.
+    std::vector<std::string> SplitCommandLine(const std::string& commandLine)
+    {
+        std::vector<std::string> tokens;
+        std::string token;
+        bool quoted = false;
+        bool inToken = false;
+        for (char c : commandLine)
+        {
+            if (c == '"')
+            {
+                quoted = !quoted;
+                inToken = true;
+            }
+            else if (!quoted && (c == ' ' || c == '\t' || c == '\r' || c == '\n'))
+            {
+                if (inToken)
+                {
+                    tokens.push_back(token);
+                    token.clear();
+                    inToken = false;
+                }
+            }
+            else
+            {
+                token += c;
+                inToken = true;
+            }
+        }
+        if (inToken)
+        {
+            tokens.push_back(token);
+        }
+        return tokens;
+    }
+
+    bool ParseUInt(const std::string& text, uint32_t& value)
+    {
+        if (text.empty() || text.size() > 9 || text.find_first_not_of("0123456789") != std::string::npos)
+        {
+            return false;
+        }
+        value = static_cast<uint32_t>(std::strtoul(text.c_str(), nullptr, 10));
+        return true;
+    }
+
+    double Percentile(const std::vector<double>& sorted, double fraction)
+    {
+        size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+
+    void AppendJsonString(std::string& json, const std::string& text)
+    {
+        json += '"';
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                json += '\\';
+                json += c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char escape[8];
+                snprintf(escape, sizeof(escape), "\\u%04x", c);
+                json += escape;
+            }
+            else
+            {
+                json += c;
+            }
+        }
+        json += '"';
+    }
+
+    void AppendTimes(std::string& json, const char* name, std::vector<double> times)
+    {
+        json += "  \"";
+        json += name;
+        json += "\": ";
+        if (times.empty())
+        {
+            json += "null,\n";
+            return;
+        }
+
+        double total = 0.0;
+        for (double time : times)
+        {
+            total += time;
+        }
+        std::sort(times.begin(), times.end());
+
+        char text[512];
+        snprintf(text, sizeof(text),
+            "{ \"count\": %zu, \"mean\": %.4f, \"min\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p95\": %.4f, "
+            "\"p99\": %.4f, \"max\": %.4f },\n",
+            times.size(), total / times.size(), times.front(), Percentile(times, 0.5), Percentile(times, 0.9),
+            Percentile(times, 0.95), Percentile(times, 0.99), times.back());
+        json += text;
+    }
+}
+
+bool ParseBenchmarkOptions(const std::string& commandLine, BenchmarkOptions& options, std::string* error)
+{
+    for (const std::string& token : SplitCommandLine(commandLine))
+    {
+        std::string option = token.compare(0, 2, "--") == 0 ? token.substr(2) : token;
+        size_t equals = option.find('=');
+        std::string name = option.substr(0, equals);
+        std::string value = equals != std::string::npos ? option.substr(equals + 1) : std::string();
+
+        bool valid = true;
+        if (name == "bench" && equals == std::string::npos)
+        {
+            options.enabled = true;
+        }
+        else if (name == "frames")
+        {
+            valid = ParseUInt(value, options.frames) && options.frames != 0;
+        }
+        else if (name == "warmup")
+        {
+            valid = ParseUInt(value, options.warmup);
+        }
+        else if (name == "vsync")
+        {
+            valid = value == "0" || value == "1";
+            options.vsync = value == "1";
+        }
+        else if (name == "res")
+        {
+            size_t x = value.find('x');
+            valid = x != std::string::npos && ParseUInt(value.substr(0, x), options.width) &&
+                ParseUInt(value.substr(x + 1), options.height) && options.width != 0 && options.height != 0;
+        }
+        else if (name == "backend")
+        {
+            // d3d12 is what CaptureReplay calls the hardware device.
+            valid = value == "hardware" || value == "d3d12" || value == "warp";
+            options.backend = value == "d3d12" ? "hardware" : value;
+        }
+        else if (name == "report")
+        {
+            valid = !value.empty();
+            options.report = value;
+        }
+        else
+        {
+            return Fail(error, "unknown option " + token);
+        }
+
+        if (!valid)
+        {
+            return Fail(error, "invalid value in " + token);
+        }
+    }
+    return true;
+}
+
+CameraPose GetBenchmarkCamera(uint32_t frame, uint32_t frameCount)
+{
+    float t = frameCount ? static_cast<float>(frame % frameCount) / frameCount : 0.0f;
+    float angle = 2.0f * c_Pi * t;
+    float radius = 12.0f + 6.0f * std::cos(2.0f * angle);
+
+    CameraPose pose;
+    pose.position[0] = radius * std::sin(angle);
+    pose.position[1] = 4.0f + 3.0f * std::sin(4.0f * angle);
+    pose.position[2] = -radius * std::cos(angle);
+    pose.target[0] = 0.0f;
+    pose.target[1] = 1.0f;
+    pose.target[2] = 0.0f;
+    return pose;
+}
+
+void Benchmark::EndFrame(double frameMs)
+{
+    if (!IsWarmingUp() && !IsDone())
+    {
+        m_FrameMs.push_back(frameMs);
+    }
+    ++m_Frame;
+}
+
+void Benchmark::AddGpuTime(uint32_t frame, double milliseconds)
+{
+    if (frame >= m_Options.warmup && frame < m_Options.warmup + m_Options.frames)
+    {
+        m_GpuMs.push_back(milliseconds);
+    }
+}
+
+void Benchmark::SampleMemory(const MemorySample& sample)
+{
+    m_Peak.videoMemory = std::max(m_Peak.videoMemory, sample.videoMemory);
+    m_Peak.videoBudget = std::max(m_Peak.videoBudget, sample.videoBudget);
+    m_Peak.workingSet = std::max(m_Peak.workingSet, sample.workingSet);
+    m_Peak.privateBytes = std::max(m_Peak.privateBytes, sample.privateBytes);
+}
+
+void Benchmark::SetInfo(const std::string& key, const std::string& value)
+{
+    for (auto& info : m_Info)
+    {
+        if (info.first == key)
+        {
+            info.second = value;
+            return;
+        }
+    }
+    m_Info.emplace_back(key, value);
+}
+
+std::string Benchmark::GetReport() const
+{
+    std::string json = "{\n";
+    char text[256];
+    snprintf(text, sizeof(text),
+        "  \"frames\": %u,\n  \"warmup\": %u,\n  \"width\": %u,\n  \"height\": %u,\n  \"vsync\": %s,\n",
+        m_Options.frames, m_Options.warmup, m_Options.width, m_Options.height, m_Options.vsync ? "true" : "false");
+    json += text;
+    json += "  \"backend\": ";
+    AppendJsonString(json, m_Options.backend);
+    json += ",\n";
+    for (const auto& info : m_Info)
+    {
+        json += "  ";
+        AppendJsonString(json, info.first);
+        json += ": ";
+        AppendJsonString(json, info.second);
+        json += ",\n";
+    }
+
+    AppendTimes(json, "cpuFrameMs", m_FrameMs);
+    AppendTimes(json, "gpuFrameMs", m_GpuMs);
+
+    snprintf(text, sizeof(text),
+        "  \"memory\": { \"videoPeakBytes\": %llu, \"videoBudgetBytes\": %llu, \"workingSetPeakBytes\": %llu, "
+        "\"privatePeakBytes\": %llu }\n",
+        static_cast<unsigned long long>(m_Peak.videoMemory), static_cast<unsigned long long>(m_Peak.videoBudget),
+        static_cast<unsigned long long>(m_Peak.workingSet), static_cast<unsigned long long>(m_Peak.privateBytes));
+    json += text;
+    json += "}\n";
+    return json;
+}
+
+bool Benchmark::WriteReport(std::string* error) const
+{
+    std::string report = GetReport();
+    if (!WriteFileAtomic(m_Options.report, report.data(), report.size()))
+    {
+        return Fail(error, "cannot write " + m_Options.report.string());
+    }
+    return true;
+}
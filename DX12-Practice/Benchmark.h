@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Command line of a benchmark run:
+//     --bench frames=N --warmup=M --vsync=0 --res=WxH --backend=hardware|warp
+//         --report=path
+// Options may be given with or without the leading "--" and in any order;
+// values may be quoted. Without --bench the options are still checked but
+// the run is interactive.
+struct BenchmarkOptions
+{
+    bool enabled = false;
+    uint32_t frames = 1000;         // measured frames, after the warmup
+    uint32_t warmup = 100;
+    bool vsync = false;
+    uint32_t width = 0;             // 0 keeps the window size
+    uint32_t height = 0;
+    std::string backend = "hardware";
+    std::filesystem::path report = "benchmark.json";
+};
+
+bool ParseBenchmarkOptions(const std::string& commandLine, BenchmarkOptions& options, std::string* error = nullptr);
+
+struct CameraPose
+{
+    float position[3];
+    float target[3];
+};
+
+// The scripted camera: one orbit around the origin over frameCount frames,
+// bobbing up and down and moving in and out twice per orbit so that both
+// near and far views are covered. Depends only on its arguments, so every
+// run sees the same frames.
+CameraPose GetBenchmarkCamera(uint32_t frame, uint32_t frameCount);
+
+// Collects the measurements of a run and writes them as JSON. Frames are
+// numbered from 0 including the warmup; samples of warmup frames are dropped.
+class Benchmark
+{
+public:
+    struct MemorySample
+    {
+        uint64_t videoMemory = 0;       // local segment usage of the process
+        uint64_t videoBudget = 0;
+        uint64_t workingSet = 0;
+        uint64_t privateBytes = 0;
+    };
+
+    explicit Benchmark(const BenchmarkOptions& options) : m_Options(options) {}
+
+    const BenchmarkOptions& GetOptions() const { return m_Options; }
+    // Frames ended so far, warmup included.
+    uint32_t GetFrame() const { return m_Frame; }
+    bool IsWarmingUp() const { return m_Frame < m_Options.warmup; }
+    bool IsDone() const { return m_Frame >= m_Options.warmup + m_Options.frames; }
+
+    // Ends the current frame; frameMs is the time since the previous one.
+    void EndFrame(double frameMs);
+    // GPU times arrive a few frames late, tagged with the frame they belong to.
+    void AddGpuTime(uint32_t frame, double milliseconds);
+    // Peaks are kept over every sample, warmup included.
+    void SampleMemory(const MemorySample& sample);
+    // Extra string fields for the report, such as the adapter name.
+    void SetInfo(const std::string& key, const std::string& value);
+
+    std::string GetReport() const;
+    bool WriteReport(std::string* error = nullptr) const;
+
+private:
+    BenchmarkOptions m_Options;
+    uint32_t m_Frame = 0;
+    std::vector<double> m_FrameMs;
+    std::vector<double> m_GpuMs;
+    MemorySample m_Peak;
+    std::vector<std::pair<std::string, std::string>> m_Info;
+};
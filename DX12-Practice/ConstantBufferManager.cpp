@@ -0,0 +1,218 @@
+#include "ConstantBufferManager.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    constexpr uint64_t c_Alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+
+    // Handing out memory the GPU may still read would corrupt frames
+    // silently, so running out stops the program in every build.
+    [[noreturn]] void Exhausted(const char* what, uint64_t size)
+    {
+        std::string text = std::string("ConstantBufferManager: ") + what + " exhausted allocating " +
+            std::to_string(size) + " bytes\n";
+        OutputDebugStringA(text.c_str());
+        std::abort();
+    }
+}
+
+ConstantBufferManager::ConstantBufferManager(ComPtr<ID3D12Device2> device, uint32_t versionCount, uint64_t heapSize,
+    uint64_t transientSize)
+    : m_HeapSize(heapSize)
+    , m_VersionCount(versionCount)
+    , m_TransientBase((heapSize - std::min(transientSize, heapSize)) & ~(c_Alignment - 1))
+{
+    CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_UPLOAD);
+    CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(heapSize);
+    device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &bufferDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&m_Buffer));
+
+    // Upload heaps stay mapped for their whole lifetime; the CPU never reads them.
+    CD3DX12_RANGE readRange(0, 0);
+    void* cpuAddress = nullptr;
+    m_Buffer->Map(0, &readRange, &cpuAddress);
+    m_CpuAddress = static_cast<uint8_t*>(cpuAddress);
+    m_GpuAddress = m_Buffer->GetGPUVirtualAddress();
+}
+
+ConstantBufferManager::~ConstantBufferManager()
+{
+    m_Buffer->Unmap(0, nullptr);
+}
+
+void ConstantBufferManager::BeginFrame(uint64_t frameFenceValue, uint64_t completedFenceValue)
+{
+    m_FrameFenceValue = frameFenceValue;
+    m_CompletedFenceValue = completedFenceValue;
+
+    auto retired = std::partition(m_PendingFrees.begin(), m_PendingFrees.end(), [=](const PendingFree& pending) {
+        return pending.fenceValue > completedFenceValue;
+    });
+    for (auto it = retired; it != m_PendingFrees.end(); ++it)
+    {
+        m_FreeLists[it->size].push_back(it->offset);
+    }
+    m_PendingFrees.erase(retired, m_PendingFrees.end());
+
+    while (!m_TransientFrames.empty() && m_TransientFrames.front().fenceValue <= completedFenceValue)
+    {
+        m_TransientTail = m_TransientFrames.front().head;
+        m_TransientFrames.pop_front();
+    }
+}
+
+uint64_t ConstantBufferManager::Allocate(uint64_t slotSize)
+{
+    uint64_t size = slotSize * m_VersionCount;
+
+    auto& freeList = m_FreeLists[size];
+    if (!freeList.empty())
+    {
+        uint64_t offset = freeList.back();
+        freeList.pop_back();
+        return offset;
+    }
+
+    if (m_Head + size > m_TransientBase)
+    {
+        Exhausted("heap", size);
+    }
+    uint64_t offset = m_Head;
+    m_Head += size;
+    return offset;
+}
+
+void ConstantBufferManager::Free(uint64_t offset, uint64_t slotSize, uint64_t lastUseFenceValue)
+{
+    m_PendingFrees.push_back({ offset, slotSize * m_VersionCount, lastUseFenceValue });
+}
+
+uint64_t ConstantBufferManager::AllocateTransient(uint64_t size)
+{
+    size = (size + c_Alignment - 1) & ~(c_Alignment - 1);
+    uint64_t ringSize = m_HeapSize - m_TransientBase;
+
+    // Allocations never wrap; the rest of the ring is skipped instead.
+    uint64_t position = m_TransientHead % ringSize;
+    uint64_t head = position + size > ringSize ? m_TransientHead + ringSize - position : m_TransientHead;
+    if (size > ringSize || head + size - m_TransientTail > ringSize)
+    {
+        Exhausted("transient memory", size);
+    }
+    m_TransientHead = head + size;
+
+    if (m_TransientFrames.empty() || m_TransientFrames.back().fenceValue != m_FrameFenceValue)
+    {
+        m_TransientFrames.push_back({ m_FrameFenceValue, m_TransientHead });
+    }
+    m_TransientFrames.back().head = m_TransientHead;
+    return m_TransientBase + head % ringSize;
+}
+
+ConstantBlock::ConstantBlock(ConstantBufferManager& manager, uint32_t size)
+    : m_Manager(manager)
+    , m_Size(size)
+{
+    assert(manager.GetVersionCount() <= c_MaxVersions);
+
+    // One dirty bit per chunk; chunks are whole 16-byte registers.
+    uint32_t chunkSize = (size + 63) / 64;
+    m_ChunkSize = std::max<uint32_t>(16, (chunkSize + 15) & ~15u);
+    m_SlotSize = (static_cast<uint64_t>(size) + c_Alignment - 1) & ~(c_Alignment - 1);
+    m_Offset = manager.Allocate(m_SlotSize);
+
+    for (auto& mask : m_DirtyChunks)
+    {
+        mask = ~0ull;
+    }
+}
+
+ConstantBlock::~ConstantBlock()
+{
+    uint64_t lastUse = *std::max_element(m_LastUse, m_LastUse + c_MaxVersions);
+    m_Manager.Free(m_Offset, m_SlotSize, lastUse);
+}
+
+void ConstantBlock::MarkDirty(uint32_t offset, uint32_t size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    uint32_t first = offset / m_ChunkSize;
+    uint32_t last = (offset + size - 1) / m_ChunkSize;
+    uint64_t bits = (last >= 63 ? ~0ull : ((1ull << (last + 1)) - 1)) & ~((1ull << first) - 1);
+
+    for (auto& mask : m_DirtyChunks)
+    {
+        mask |= bits;
+    }
+    m_Changed = true;
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS ConstantBlock::Commit(const void* data)
+{
+    uint32_t versionCount = m_Manager.GetVersionCount();
+
+    if (m_Changed || m_Transient)
+    {
+        // The next version in turn is the least recently used one. If the
+        // GPU may still read it, this frame gets a transient copy of the
+        // whole buffer and the versions catch up in a later frame.
+        uint32_t next = (m_Current + 1) % versionCount;
+        if (m_LastUse[next] > m_Manager.GetCompletedFenceValue())
+        {
+            if (m_Changed || m_TransientFence != m_Manager.GetFrameFenceValue())
+            {
+                uint64_t offset = m_Manager.AllocateTransient(m_Size);
+                memcpy(m_Manager.GetCpuAddress(offset), data, m_Size);
+                m_Manager.AddBytesWritten(m_Size);
+                m_Transient = m_Manager.GetGpuAddress(offset);
+                m_TransientFence = m_Manager.GetFrameFenceValue();
+                m_Changed = false;
+            }
+            return m_Transient;
+        }
+
+        // Only the chunks changed since this version was last written.
+        uint64_t mask = m_DirtyChunks[next];
+        uint8_t* destination = m_Manager.GetCpuAddress(m_Offset + next * m_SlotSize);
+        auto source = static_cast<const uint8_t*>(data);
+        while (mask)
+        {
+            uint32_t begin = 0;
+            while ((mask & (1ull << begin)) == 0)
+            {
+                ++begin;
+            }
+            uint32_t end = begin;
+            while (end < 64 && (mask & (1ull << end)))
+            {
+                ++end;
+            }
+            mask &= end >= 64 ? 0 : ~((1ull << end) - 1);
+
+            uint32_t byteBegin = begin * m_ChunkSize;
+            uint32_t byteEnd = std::min(end * m_ChunkSize, m_Size);
+            if (byteBegin < byteEnd)
+            {
+                memcpy(destination + byteBegin, source + byteBegin, byteEnd - byteBegin);
+                m_Manager.AddBytesWritten(byteEnd - byteBegin);
+            }
+        }
+
+        m_DirtyChunks[next] = 0;
+        m_Current = next;
+        m_Changed = false;
+        m_Transient = 0;
+    }
+
+    m_LastUse[m_Current] = std::max(m_LastUse[m_Current], m_Manager.GetFrameFenceValue());
+    return m_Manager.GetGpuAddress(m_Offset + m_Current * m_SlotSize);
+}
@@ -0,0 +1,186 @@
+#pragma once
+#include "Win.h"
+#include <wrl/client.h>
+
+#include "directx/d3dx12.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// Persistently mapped upload heap that backs every ConstantBuffer<T>. Each
+// buffer gets one 256-byte aligned slot per frame in flight ("versions").
+// Changing a buffer writes the next free version; an unchanged buffer keeps
+// binding the version it wrote last, which stays alive because nothing else
+// writes to that slot. A buffer that changes more often than that within
+// the frames in flight writes to per-frame transient memory at the end of
+// the heap instead. Running out of either part of the heap is fatal.
+class ConstantBufferManager
+{
+public:
+    ConstantBufferManager(Microsoft::WRL::ComPtr<ID3D12Device2> device, uint32_t versionCount,
+        uint64_t heapSize = 4 * 1024 * 1024, uint64_t transientSize = 256 * 1024);
+    ~ConstantBufferManager();
+
+    ConstantBufferManager(const ConstantBufferManager&) = delete;
+    ConstantBufferManager& operator=(const ConstantBufferManager&) = delete;
+
+    // frameFenceValue is what the queue will signal when this frame is done,
+    // completedFenceValue what the fence has reached so far.
+    void BeginFrame(uint64_t frameFenceValue, uint64_t completedFenceValue);
+
+    uint64_t GetFrameFenceValue() const { return m_FrameFenceValue; }
+    uint64_t GetCompletedFenceValue() const { return m_CompletedFenceValue; }
+    uint32_t GetVersionCount() const { return m_VersionCount; }
+
+    // Returns the offset of versionCount consecutive slots of slotSize bytes.
+    uint64_t Allocate(uint64_t slotSize);
+    // The slots are recycled once lastUseFenceValue has completed.
+    void Free(uint64_t offset, uint64_t slotSize, uint64_t lastUseFenceValue);
+    // Returns the offset of size bytes that stay valid until the current
+    // frame's fence value has completed.
+    uint64_t AllocateTransient(uint64_t size);
+
+    uint8_t* GetCpuAddress(uint64_t offset) const { return m_CpuAddress + offset; }
+    D3D12_GPU_VIRTUAL_ADDRESS GetGpuAddress(uint64_t offset) const { return m_GpuAddress + offset; }
+
+    uint64_t GetBytesWritten() const { return m_BytesWritten; }
+    void AddBytesWritten(uint64_t bytes) { m_BytesWritten += bytes; }
+
+    // Root CBV for a buffer bound through ConstantBuffer<T>::Bind. The data
+    // does not change while the command list executes.
+    static void InitRootParameter(CD3DX12_ROOT_PARAMETER1& parameter, UINT shaderRegister, UINT registerSpace = 0,
+        D3D12_SHADER_VISIBILITY visibility = D3D12_SHADER_VISIBILITY_ALL)
+    {
+        parameter.InitAsConstantBufferView(shaderRegister, registerSpace, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE, visibility);
+    }
+
+private:
+    struct PendingFree
+    {
+        uint64_t offset;
+        uint64_t size;
+        uint64_t fenceValue;
+    };
+
+    struct TransientFrame
+    {
+        uint64_t fenceValue;
+        uint64_t head;                  // end of the frame's allocations
+    };
+
+    Microsoft::WRL::ComPtr<ID3D12Resource> m_Buffer;
+    uint8_t* m_CpuAddress = nullptr;
+    D3D12_GPU_VIRTUAL_ADDRESS m_GpuAddress = 0;
+    uint64_t m_HeapSize;
+    uint64_t m_Head = 0;
+    uint32_t m_VersionCount;
+
+    // Ring of transient memory in [m_TransientBase, m_HeapSize); head and
+    // tail count bytes ever allocated and retired.
+    uint64_t m_TransientBase;
+    uint64_t m_TransientHead = 0;
+    uint64_t m_TransientTail = 0;
+    std::deque<TransientFrame> m_TransientFrames;
+
+    std::unordered_map<uint64_t, std::vector<uint64_t>> m_FreeLists; // by allocation size
+    std::vector<PendingFree> m_PendingFrees;
+
+    uint64_t m_FrameFenceValue = 0;
+    uint64_t m_CompletedFenceValue = 0;
+    uint64_t m_BytesWritten = 0;
+};
+
+// Type-erased part of ConstantBuffer<T>: dirty tracking in 16-byte-aligned
+// chunks (at most 64 per buffer) and version selection.
+class ConstantBlock
+{
+public:
+    ConstantBlock(ConstantBufferManager& manager, uint32_t size);
+    ~ConstantBlock();
+
+    ConstantBlock(const ConstantBlock&) = delete;
+    ConstantBlock& operator=(const ConstantBlock&) = delete;
+
+    void MarkDirty(uint32_t offset, uint32_t size);
+    void MarkAllDirty() { MarkDirty(0, m_Size); }
+
+    // Writes pending changes (if any) and returns the address to bind.
+    D3D12_GPU_VIRTUAL_ADDRESS Commit(const void* data);
+
+private:
+    static const uint32_t c_MaxVersions = 8;
+
+    ConstantBufferManager& m_Manager;
+    uint32_t m_Size;
+    uint32_t m_ChunkSize;
+    uint64_t m_SlotSize;
+    uint64_t m_Offset;
+
+    uint32_t m_Current = 0;
+    bool m_Changed = true;
+    // Chunks each version is missing relative to the CPU copy.
+    uint64_t m_DirtyChunks[c_MaxVersions];
+    uint64_t m_LastUse[c_MaxVersions] = {};
+    // Set while the latest data lives only in transient memory because every
+    // version was still in use when it changed.
+    D3D12_GPU_VIRTUAL_ADDRESS m_Transient = 0;
+    uint64_t m_TransientFence = 0;
+};
+
+template<typename T>
+class ConstantBuffer
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Constant buffer data must be trivially copyable");
+
+public:
+    explicit ConstantBuffer(ConstantBufferManager& manager, const T& initial = T())
+        : m_Block(manager, sizeof(T))
+        , m_Data(initial)
+    {
+    }
+
+    const T& Get() const { return m_Data; }
+
+    // Marks the field dirty only if its value actually changes.
+    template<typename F>
+    void Set(F T::* field, const F& value)
+    {
+        F& target = m_Data.*field;
+        if (memcmp(&target, &value, sizeof(F)) != 0)
+        {
+            target = value;
+            auto offset = reinterpret_cast<const uint8_t*>(&target) - reinterpret_cast<const uint8_t*>(&m_Data);
+            m_Block.MarkDirty(static_cast<uint32_t>(offset), sizeof(F));
+        }
+    }
+
+    void Set(const T& data)
+    {
+        if (memcmp(&m_Data, &data, sizeof(T)) != 0)
+        {
+            m_Data = data;
+            m_Block.MarkAllDirty();
+        }
+    }
+
+    D3D12_GPU_VIRTUAL_ADDRESS Commit() { return m_Block.Commit(&m_Data); }
+
+    void Bind(ID3D12GraphicsCommandList* commandList, UINT rootParameterIndex)
+    {
+        commandList->SetGraphicsRootConstantBufferView(rootParameterIndex, Commit());
+    }
+
+    void BindCompute(ID3D12GraphicsCommandList* commandList, UINT rootParameterIndex)
+    {
+        commandList->SetComputeRootConstantBufferView(rootParameterIndex, Commit());
+    }
+
+private:
+    ConstantBlock m_Block;
+    T m_Data;
+};
@@ -0,0 +1,16 @@
+#pragma once
+
+// SIMD code paths compiled into every x86 build and picked at run time, so
+// builds without /arch:AVX2 or -mavx2 still use AVX2 where the CPU has it.
+// Functions using it are marked PRACTICE_AVX2_TARGET.
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PRACTICE_X86 1
+#if defined(_MSC_VER) || defined(__AVX2__)
+#define PRACTICE_AVX2_TARGET
+#else
+#define PRACTICE_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+// AVX2 instructions, and YMM state saved by the OS. Checked once.
+bool IsAvx2Supported();
@@ -0,0 +1,796 @@
+#include "D3D12RenderInterface.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    constexpr UINT64 c_UploadPageSize = 4 * 1024 * 1024;
+
+    // Pipeline blob: header, the description with its pointers cleared, the
+    // shaders in header order, then the input elements, each preceded by its
+    // semantic name (length, characters).
+    struct PipelineBlobHeader
+    {
+        uint32_t compute;
+        uint32_t inputElementCount;
+        uint64_t shaderSizes[5];    // VS, PS, DS, HS, GS; CS first for compute
+    };
+
+    void Append(std::vector<uint8_t>& blob, const void* data, size_t size)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        blob.insert(blob.end(), bytes, bytes + size);
+    }
+
+    class BlobReader
+    {
+    public:
+        BlobReader(const void* data, size_t size) : m_Data(static_cast<const uint8_t*>(data)), m_Size(size) {}
+
+        const uint8_t* Bytes(size_t size)
+        {
+            if (size > m_Size - m_Offset)
+            {
+                m_Offset = m_Size;
+                m_Ok = false;
+                return nullptr;
+            }
+            const uint8_t* bytes = m_Data + m_Offset;
+            m_Offset += size;
+            return bytes;
+        }
+
+        template<typename T>
+        bool Get(T& value)
+        {
+            const uint8_t* bytes = Bytes(sizeof(T));
+            if (bytes)
+            {
+                std::memcpy(&value, bytes, sizeof(T));
+            }
+            return bytes != nullptr;
+        }
+
+        bool IsOk() const { return m_Ok; }
+
+    private:
+        const uint8_t* m_Data;
+        size_t m_Size;
+        size_t m_Offset = 0;
+        bool m_Ok = true;
+    };
+
+    D3D12_SHADER_BYTECODE ReadShader(BlobReader& reader, uint64_t size)
+    {
+        D3D12_SHADER_BYTECODE shader = {};
+        if (size != 0)
+        {
+            shader.pShaderBytecode = reader.Bytes(static_cast<size_t>(size));
+            shader.BytecodeLength = shader.pShaderBytecode ? static_cast<SIZE_T>(size) : 0;
+        }
+        return shader;
+    }
+
+    void Report(const char* command, uint32_t id, const char* message)
+    {
+        std::string text = std::string("D3D12RenderInterface::") + command + "(" + std::to_string(id) + "): " + message + "\n";
+        OutputDebugStringA(text.c_str());
+    }
+}
+
+D3D12RenderInterface::D3D12RenderInterface(ComPtr<ID3D12Device2> device, uint32_t maxRenderTargets)
+    : m_Device(device)
+{
+    D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+    heapDesc.NumDescriptors = maxRenderTargets;
+    heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+    m_Device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&m_RtvHeap));
+    heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
+    m_Device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&m_DsvHeap));
+    m_RtvSize = m_Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+    m_DsvSize = m_Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
+
+    // Hand out low slots first.
+    for (UINT i = maxRenderTargets; i-- > 0;)
+    {
+        m_FreeRtvs.push_back(i);
+        m_FreeDsvs.push_back(i);
+    }
+}
+
+void D3D12RenderInterface::SetFrame(ID3D12GraphicsCommandList* commandList, uint64_t frameFenceValue, uint64_t completedFenceValue)
+{
+    m_CommandList = commandList;
+    m_FrameFenceValue = frameFenceValue;
+    m_CompletedFenceValue = completedFenceValue;
+
+    while (!m_UsedPages.empty() && m_UsedPages.front().fenceValue <= completedFenceValue)
+    {
+        m_FreePages.push_back(std::move(m_UsedPages.front()));
+        m_UsedPages.pop_front();
+    }
+    while (!m_Retired.empty() && m_Retired.front().fenceValue <= completedFenceValue)
+    {
+        m_Retired.pop_front();
+    }
+}
+
+ID3D12Resource* D3D12RenderInterface::GetResource(uint32_t id) const
+{
+    const Resource* resource = Find(id);
+    return resource ? resource->resource.Get() : nullptr;
+}
+
+std::vector<uint8_t> D3D12RenderInterface::SerializePipeline(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+{
+    const D3D12_SHADER_BYTECODE* shaders[] = { &desc.VS, &desc.PS, &desc.DS, &desc.HS, &desc.GS };
+
+    PipelineBlobHeader header = {};
+    header.compute = 0;
+    header.inputElementCount = desc.InputLayout.NumElements;
+    for (size_t i = 0; i < 5; ++i)
+    {
+        header.shaderSizes[i] = shaders[i]->pShaderBytecode ? shaders[i]->BytecodeLength : 0;
+    }
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC stripped = desc;
+    stripped.pRootSignature = nullptr;
+    stripped.VS = stripped.PS = stripped.DS = stripped.HS = stripped.GS = {};
+    stripped.StreamOutput = {};
+    stripped.InputLayout = {};
+    stripped.CachedPSO = {};
+
+    std::vector<uint8_t> blob;
+    Append(blob, &header, sizeof(header));
+    Append(blob, &stripped, sizeof(stripped));
+    for (size_t i = 0; i < 5; ++i)
+    {
+        Append(blob, shaders[i]->pShaderBytecode, static_cast<size_t>(header.shaderSizes[i]));
+    }
+    for (UINT i = 0; i < desc.InputLayout.NumElements; ++i)
+    {
+        D3D12_INPUT_ELEMENT_DESC element = desc.InputLayout.pInputElementDescs[i];
+        uint32_t nameLength = static_cast<uint32_t>(std::strlen(element.SemanticName));
+        Append(blob, &nameLength, sizeof(nameLength));
+        Append(blob, element.SemanticName, nameLength);
+        element.SemanticName = nullptr;
+        Append(blob, &element, sizeof(element));
+    }
+    return blob;
+}
+
+std::vector<uint8_t> D3D12RenderInterface::SerializePipeline(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc)
+{
+    PipelineBlobHeader header = {};
+    header.compute = 1;
+    header.shaderSizes[0] = desc.CS.pShaderBytecode ? desc.CS.BytecodeLength : 0;
+
+    D3D12_COMPUTE_PIPELINE_STATE_DESC stripped = desc;
+    stripped.pRootSignature = nullptr;
+    stripped.CS = {};
+    stripped.CachedPSO = {};
+
+    std::vector<uint8_t> blob;
+    Append(blob, &header, sizeof(header));
+    Append(blob, &stripped, sizeof(stripped));
+    Append(blob, desc.CS.pShaderBytecode, static_cast<size_t>(header.shaderSizes[0]));
+    return blob;
+}
+
+void D3D12RenderInterface::BeginFrame()
+{
+    m_Compute = false;
+}
+
+void D3D12RenderInterface::EndFrame()
+{
+    // Pages are not shared between frames, so each retires with the last
+    // frame that copied from it.
+    if (m_UploadPage.buffer && m_UploadOffset != 0)
+    {
+        m_UploadPage.fenceValue = m_FrameFenceValue;
+        m_UsedPages.push_back(std::move(m_UploadPage));
+        m_UploadPage = {};
+        m_UploadOffset = 0;
+    }
+    m_CommandList = nullptr;
+}
+
+const D3D12RenderInterface::Resource* D3D12RenderInterface::Find(uint32_t id) const
+{
+    auto it = m_Resources.find(id);
+    return it != m_Resources.end() ? &it->second : nullptr;
+}
+
+void D3D12RenderInterface::AddResource(uint32_t id, ComPtr<ID3D12Resource> resource, uint32_t flags)
+{
+    Release(id);
+    if (!resource)
+    {
+        return;
+    }
+
+    Resource& entry = m_Resources[id];
+    entry.resource = resource;
+    if ((flags & c_RenderResourceRenderTarget) && !m_FreeRtvs.empty())
+    {
+        entry.rtv = m_FreeRtvs.back();
+        m_FreeRtvs.pop_back();
+        CD3DX12_CPU_DESCRIPTOR_HANDLE rtv(m_RtvHeap->GetCPUDescriptorHandleForHeapStart(), entry.rtv, m_RtvSize);
+        m_Device->CreateRenderTargetView(resource.Get(), nullptr, rtv);
+    }
+    if ((flags & c_RenderResourceDepthStencil) && !m_FreeDsvs.empty())
+    {
+        entry.dsv = m_FreeDsvs.back();
+        m_FreeDsvs.pop_back();
+        CD3DX12_CPU_DESCRIPTOR_HANDLE dsv(m_DsvHeap->GetCPUDescriptorHandleForHeapStart(), entry.dsv, m_DsvSize);
+        m_Device->CreateDepthStencilView(resource.Get(), nullptr, dsv);
+    }
+    if (((flags & c_RenderResourceRenderTarget) && entry.rtv == UINT_MAX) ||
+        ((flags & c_RenderResourceDepthStencil) && entry.dsv == UINT_MAX))
+    {
+        Report("AddResource", id, "out of view descriptors");
+    }
+}
+
+void D3D12RenderInterface::Release(uint32_t id)
+{
+    auto resource = m_Resources.find(id);
+    if (resource != m_Resources.end())
+    {
+        if (resource->second.rtv != UINT_MAX)
+        {
+            m_FreeRtvs.push_back(resource->second.rtv);
+        }
+        if (resource->second.dsv != UINT_MAX)
+        {
+            m_FreeDsvs.push_back(resource->second.dsv);
+        }
+        Retire(resource->second.resource);
+        m_Resources.erase(resource);
+    }
+
+    auto rootSignature = m_RootSignatures.find(id);
+    if (rootSignature != m_RootSignatures.end())
+    {
+        Retire(rootSignature->second);
+        m_RootSignatures.erase(rootSignature);
+    }
+
+    auto pipeline = m_Pipelines.find(id);
+    if (pipeline != m_Pipelines.end())
+    {
+        Retire(pipeline->second.state);
+        Retire(pipeline->second.rootSignature);
+        m_Pipelines.erase(pipeline);
+    }
+
+    auto commandSignature = m_CommandSignatures.find(id);
+    if (commandSignature != m_CommandSignatures.end())
+    {
+        Retire(commandSignature->second);
+        m_CommandSignatures.erase(commandSignature);
+    }
+}
+
+void D3D12RenderInterface::Retire(ComPtr<ID3D12Object> object)
+{
+    if (object)
+    {
+        m_Retired.push_back({ m_FrameFenceValue, std::move(object) });
+    }
+}
+
+uint8_t* D3D12RenderInterface::AllocateUpload(UINT64 size, UINT64 alignment, ID3D12Resource** buffer, UINT64* offset)
+{
+    UINT64 aligned = (m_UploadOffset + alignment - 1) / alignment * alignment;
+    if (!m_UploadPage.buffer || aligned + size > m_UploadPage.size)
+    {
+        if (m_UploadPage.buffer)
+        {
+            m_UploadPage.fenceValue = m_FrameFenceValue;
+            m_UsedPages.push_back(std::move(m_UploadPage));
+        }
+
+        // Oversized requests get a page of their own, which is recycled like
+        // the others.
+        auto free = std::find_if(m_FreePages.begin(), m_FreePages.end(),
+            [size](const UploadPage& page) { return page.size >= size; });
+        if (free != m_FreePages.end())
+        {
+            m_UploadPage = std::move(*free);
+            m_FreePages.erase(free);
+        }
+        else
+        {
+            m_UploadPage = {};
+            m_UploadPage.size = std::max(size, c_UploadPageSize);
+            CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_UPLOAD);
+            CD3DX12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(m_UploadPage.size);
+            if (FAILED(m_Device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &desc,
+                D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&m_UploadPage.buffer))))
+            {
+                m_UploadPage = {};
+                return nullptr;
+            }
+
+            // Upload pages stay mapped for their whole lifetime.
+            CD3DX12_RANGE readRange(0, 0);
+            m_UploadPage.buffer->Map(0, &readRange, reinterpret_cast<void**>(&m_UploadPage.data));
+        }
+        aligned = 0;
+    }
+
+    *buffer = m_UploadPage.buffer.Get();
+    *offset = aligned;
+    m_UploadOffset = aligned + size;
+    return m_UploadPage.data + aligned;
+}
+
+void D3D12RenderInterface::CreateBuffer(uint32_t id, uint64_t size, uint32_t flags)
+{
+    CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
+    CD3DX12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(size,
+        (flags & c_RenderResourceUnordered) ? D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS : D3D12_RESOURCE_FLAG_NONE);
+
+    ComPtr<ID3D12Resource> buffer;
+    if (FAILED(m_Device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &desc,
+        D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&buffer))))
+    {
+        Report("CreateBuffer", id, "CreateCommittedResource failed");
+    }
+    AddResource(id, buffer, 0);
+}
+
+void D3D12RenderInterface::CreateTexture(uint32_t id, const RenderTextureDesc& desc)
+{
+    // RenderResourceFlags are the D3D12_RESOURCE_FLAGS bits.
+    CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
+    CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(static_cast<DXGI_FORMAT>(desc.format),
+        desc.width, desc.height, desc.arraySize, desc.mipLevels, 1, 0, static_cast<D3D12_RESOURCE_FLAGS>(desc.flags));
+
+    ComPtr<ID3D12Resource> texture;
+    if (FAILED(m_Device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &resourceDesc,
+        D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&texture))))
+    {
+        Report("CreateTexture", id, "CreateCommittedResource failed");
+    }
+    AddResource(id, texture, desc.flags);
+}
+
+void D3D12RenderInterface::ImportTexture(uint32_t id, const RenderTextureDesc& desc, void* native)
+{
+    if (!native)
+    {
+        CreateTexture(id, desc);
+        return;
+    }
+    AddResource(id, static_cast<ID3D12Resource*>(native), desc.flags);
+}
+
+void D3D12RenderInterface::CreateRootSignature(uint32_t id, const void* blob, size_t size)
+{
+    Release(id);
+    ComPtr<ID3D12RootSignature> rootSignature;
+    if (FAILED(m_Device->CreateRootSignature(0, blob, size, IID_PPV_ARGS(&rootSignature))))
+    {
+        Report("CreateRootSignature", id, "CreateRootSignature failed");
+        return;
+    }
+    m_RootSignatures[id] = rootSignature;
+}
+
+void D3D12RenderInterface::CreatePipeline(uint32_t id, uint32_t rootSignature, const void* blob, size_t size)
+{
+    Release(id);
+    auto signature = m_RootSignatures.find(rootSignature);
+    if (signature == m_RootSignatures.end())
+    {
+        Report("CreatePipeline", id, "unknown root signature");
+        return;
+    }
+
+    BlobReader reader(blob, size);
+    PipelineBlobHeader header = {};
+    reader.Get(header);
+
+    Pipeline pipeline;
+    pipeline.rootSignature = signature->second;
+    pipeline.compute = header.compute != 0;
+    HRESULT result = E_INVALIDARG;
+    if (pipeline.compute)
+    {
+        D3D12_COMPUTE_PIPELINE_STATE_DESC desc = {};
+        reader.Get(desc);
+        desc.CS = ReadShader(reader, header.shaderSizes[0]);
+        desc.pRootSignature = signature->second.Get();
+        if (reader.IsOk())
+        {
+            result = m_Device->CreateComputePipelineState(&desc, IID_PPV_ARGS(&pipeline.state));
+        }
+    }
+    else
+    {
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = {};
+        reader.Get(desc);
+        D3D12_SHADER_BYTECODE* shaders[] = { &desc.VS, &desc.PS, &desc.DS, &desc.HS, &desc.GS };
+        for (size_t i = 0; i < 5; ++i)
+        {
+            *shaders[i] = ReadShader(reader, header.shaderSizes[i]);
+        }
+
+        // Semantic names in the blob are not terminated.
+        std::vector<D3D12_INPUT_ELEMENT_DESC> elements(reader.IsOk() ? header.inputElementCount : 0);
+        std::vector<std::string> names(elements.size());
+        for (size_t i = 0; i < elements.size() && reader.IsOk(); ++i)
+        {
+            uint32_t nameLength = 0;
+            reader.Get(nameLength);
+            const uint8_t* name = reader.Bytes(nameLength);
+            reader.Get(elements[i]);
+            if (name)
+            {
+                names[i].assign(reinterpret_cast<const char*>(name), nameLength);
+            }
+            elements[i].SemanticName = names[i].c_str();
+        }
+        desc.InputLayout = { elements.data(), static_cast<UINT>(elements.size()) };
+        desc.pRootSignature = signature->second.Get();
+        if (reader.IsOk())
+        {
+            result = m_Device->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pipeline.state));
+        }
+    }
+
+    if (FAILED(result))
+    {
+        Report("CreatePipeline", id, reader.IsOk() ? "pipeline creation failed" : "truncated blob");
+        return;
+    }
+    m_Pipelines[id] = pipeline;
+}
+
+void D3D12RenderInterface::CreateCommandSignature(uint32_t id, const std::vector<IndirectArgument>& arguments,
+    uint32_t byteStride, uint32_t rootSignature)
+{
+    Release(id);
+
+    std::vector<D3D12_INDIRECT_ARGUMENT_DESC> descs(arguments.size());
+    for (size_t i = 0; i < arguments.size(); ++i)
+    {
+        const IndirectArgument& argument = arguments[i];
+        D3D12_INDIRECT_ARGUMENT_DESC& desc = descs[i];
+        desc.Type = static_cast<D3D12_INDIRECT_ARGUMENT_TYPE>(argument.type);
+        switch (argument.type)
+        {
+        case IndirectArgumentType::VertexBufferView:
+            desc.VertexBuffer.Slot = argument.slot;
+            break;
+        case IndirectArgumentType::Constant:
+            desc.Constant.RootParameterIndex = argument.slot;
+            desc.Constant.DestOffsetIn32BitValues = argument.destOffsetIn32BitValues;
+            desc.Constant.Num32BitValuesToSet = argument.num32BitValues;
+            break;
+        case IndirectArgumentType::ConstantBufferView:
+            desc.ConstantBufferView.RootParameterIndex = argument.slot;
+            break;
+        case IndirectArgumentType::ShaderResourceView:
+            desc.ShaderResourceView.RootParameterIndex = argument.slot;
+            break;
+        case IndirectArgumentType::UnorderedAccessView:
+            desc.UnorderedAccessView.RootParameterIndex = argument.slot;
+            break;
+        default:
+            break;
+        }
+    }
+
+    ID3D12RootSignature* signature = nullptr;
+    if (rootSignature != c_RenderNoResource)
+    {
+        auto it = m_RootSignatures.find(rootSignature);
+        if (it == m_RootSignatures.end())
+        {
+            Report("CreateCommandSignature", id, "unknown root signature");
+            return;
+        }
+        signature = it->second.Get();
+    }
+
+    D3D12_COMMAND_SIGNATURE_DESC signatureDesc = {};
+    signatureDesc.ByteStride = byteStride;
+    signatureDesc.NumArgumentDescs = static_cast<UINT>(descs.size());
+    signatureDesc.pArgumentDescs = descs.data();
+
+    ComPtr<ID3D12CommandSignature> commandSignature;
+    if (FAILED(m_Device->CreateCommandSignature(&signatureDesc, signature, IID_PPV_ARGS(&commandSignature))))
+    {
+        Report("CreateCommandSignature", id, "CreateCommandSignature failed");
+        return;
+    }
+    m_CommandSignatures[id] = commandSignature;
+}
+
+void D3D12RenderInterface::Destroy(uint32_t id)
+{
+    Release(id);
+}
+
+void D3D12RenderInterface::UpdateBuffer(uint32_t id, uint64_t offset, const void* data, uint64_t size)
+{
+    const Resource* destination = Find(id);
+    ID3D12Resource* upload = nullptr;
+    UINT64 uploadOffset = 0;
+    uint8_t* mapped = destination && size != 0 ? AllocateUpload(size, 4, &upload, &uploadOffset) : nullptr;
+    if (!mapped)
+    {
+        return;
+    }
+
+    std::memcpy(mapped, data, static_cast<size_t>(size));
+    m_CommandList->CopyBufferRegion(destination->resource.Get(), offset, upload, uploadOffset, size);
+}
+
+void D3D12RenderInterface::UpdateTexture(uint32_t id, uint32_t subresource, const void* data, uint64_t rowPitch,
+    uint64_t slicePitch)
+{
+    const Resource* destination = Find(id);
+    if (!destination)
+    {
+        return;
+    }
+
+    D3D12_RESOURCE_DESC desc = destination->resource->GetDesc();
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
+    UINT rowCount = 0;
+    UINT64 rowSize = 0;
+    UINT64 totalSize = 0;
+    m_Device->GetCopyableFootprints(&desc, subresource, 1, 0, &footprint, &rowCount, &rowSize, &totalSize);
+
+    ID3D12Resource* upload = nullptr;
+    UINT64 uploadOffset = 0;
+    uint8_t* mapped = AllocateUpload(totalSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, &upload, &uploadOffset);
+    if (!mapped)
+    {
+        return;
+    }
+
+    // The caller's pitch need not match the footprint's.
+    const uint8_t* source = static_cast<const uint8_t*>(data);
+    UINT64 copySize = std::min<UINT64>(rowSize, rowPitch);
+    for (UINT z = 0; z < footprint.Footprint.Depth; ++z)
+    {
+        for (UINT row = 0; row < rowCount; ++row)
+        {
+            std::memcpy(mapped + (z * rowCount + row) * static_cast<UINT64>(footprint.Footprint.RowPitch),
+                source + z * slicePitch + row * rowPitch, static_cast<size_t>(copySize));
+        }
+    }
+
+    footprint.Offset = uploadOffset;
+    CD3DX12_TEXTURE_COPY_LOCATION dst(destination->resource.Get(), subresource);
+    CD3DX12_TEXTURE_COPY_LOCATION src(upload, footprint);
+    m_CommandList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+}
+
+void D3D12RenderInterface::Barrier(uint32_t id, uint32_t before, uint32_t after)
+{
+    const Resource* resource = Find(id);
+    if (!resource)
+    {
+        return;
+    }
+
+    CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(resource->resource.Get(),
+        static_cast<D3D12_RESOURCE_STATES>(before), static_cast<D3D12_RESOURCE_STATES>(after));
+    m_CommandList->ResourceBarrier(1, &barrier);
+}
+
+void D3D12RenderInterface::UnorderedBarrier(uint32_t id)
+{
+    const Resource* resource = Find(id);
+    CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::UAV(resource ? resource->resource.Get() : nullptr);
+    m_CommandList->ResourceBarrier(1, &barrier);
+}
+
+void D3D12RenderInterface::SetRenderTargets(uint32_t count, const uint32_t* renderTargets, uint32_t depthStencil)
+{
+    D3D12_CPU_DESCRIPTOR_HANDLE rtvs[c_RenderMaxRenderTargets];
+    count = std::min(count, c_RenderMaxRenderTargets);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const Resource* resource = Find(renderTargets[i]);
+        if (!resource || resource->rtv == UINT_MAX)
+        {
+            Report("SetRenderTargets", renderTargets[i], "not a render target");
+            return;
+        }
+        rtvs[i] = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_RtvHeap->GetCPUDescriptorHandleForHeapStart(), resource->rtv, m_RtvSize);
+    }
+
+    D3D12_CPU_DESCRIPTOR_HANDLE dsv = {};
+    if (depthStencil != c_RenderNoResource)
+    {
+        const Resource* resource = Find(depthStencil);
+        if (!resource || resource->dsv == UINT_MAX)
+        {
+            Report("SetRenderTargets", depthStencil, "not a depth stencil");
+            return;
+        }
+        dsv = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_DsvHeap->GetCPUDescriptorHandleForHeapStart(), resource->dsv, m_DsvSize);
+    }
+
+    m_CommandList->OMSetRenderTargets(count, rtvs, FALSE, depthStencil != c_RenderNoResource ? &dsv : nullptr);
+}
+
+void D3D12RenderInterface::SetViewport(float x, float y, float width, float height, float minDepth, float maxDepth)
+{
+    CD3DX12_VIEWPORT viewport(x, y, width, height, minDepth, maxDepth);
+    CD3DX12_RECT scissor(static_cast<LONG>(x), static_cast<LONG>(y),
+        static_cast<LONG>(x + width), static_cast<LONG>(y + height));
+    m_CommandList->RSSetViewports(1, &viewport);
+    m_CommandList->RSSetScissorRects(1, &scissor);
+}
+
+void D3D12RenderInterface::ClearRenderTarget(uint32_t id, const float color[4])
+{
+    const Resource* resource = Find(id);
+    if (!resource || resource->rtv == UINT_MAX)
+    {
+        Report("ClearRenderTarget", id, "not a render target");
+        return;
+    }
+    CD3DX12_CPU_DESCRIPTOR_HANDLE rtv(m_RtvHeap->GetCPUDescriptorHandleForHeapStart(), resource->rtv, m_RtvSize);
+    m_CommandList->ClearRenderTargetView(rtv, color, 0, nullptr);
+}
+
+void D3D12RenderInterface::ClearDepthStencil(uint32_t id, float depth, uint8_t stencil)
+{
+    const Resource* resource = Find(id);
+    if (!resource || resource->dsv == UINT_MAX)
+    {
+        Report("ClearDepthStencil", id, "not a depth stencil");
+        return;
+    }
+    CD3DX12_CPU_DESCRIPTOR_HANDLE dsv(m_DsvHeap->GetCPUDescriptorHandleForHeapStart(), resource->dsv, m_DsvSize);
+    m_CommandList->ClearDepthStencilView(dsv, D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, depth, stencil, 0, nullptr);
+}
+
+void D3D12RenderInterface::SetPipeline(uint32_t id)
+{
+    auto pipeline = m_Pipelines.find(id);
+    if (pipeline == m_Pipelines.end())
+    {
+        Report("SetPipeline", id, "unknown pipeline");
+        return;
+    }
+
+    ID3D12RootSignature* rootSignature = pipeline->second.rootSignature.Get();
+    m_Compute = pipeline->second.compute;
+    m_CommandList->SetPipelineState(pipeline->second.state.Get());
+    if (m_Compute)
+    {
+        m_CommandList->SetComputeRootSignature(rootSignature);
+    }
+    else
+    {
+        m_CommandList->SetGraphicsRootSignature(rootSignature);
+    }
+}
+
+void D3D12RenderInterface::SetPrimitiveTopology(uint32_t topology)
+{
+    m_CommandList->IASetPrimitiveTopology(static_cast<D3D_PRIMITIVE_TOPOLOGY>(topology));
+}
+
+void D3D12RenderInterface::SetRootConstants(uint32_t parameter, uint32_t count, const uint32_t* values, uint32_t destOffset)
+{
+    if (m_Compute)
+    {
+        m_CommandList->SetComputeRoot32BitConstants(parameter, count, values, destOffset);
+    }
+    else
+    {
+        m_CommandList->SetGraphicsRoot32BitConstants(parameter, count, values, destOffset);
+    }
+}
+
+void D3D12RenderInterface::SetRootView(uint32_t parameter, RenderRootView type, uint32_t id, uint64_t offset)
+{
+    const Resource* resource = Find(id);
+    if (!resource)
+    {
+        return;
+    }
+
+    D3D12_GPU_VIRTUAL_ADDRESS address = resource->resource->GetGPUVirtualAddress() + offset;
+    switch (type)
+    {
+    case RenderRootView::ConstantBuffer:
+        m_Compute ? m_CommandList->SetComputeRootConstantBufferView(parameter, address)
+                  : m_CommandList->SetGraphicsRootConstantBufferView(parameter, address);
+        break;
+    case RenderRootView::ShaderResource:
+        m_Compute ? m_CommandList->SetComputeRootShaderResourceView(parameter, address)
+                  : m_CommandList->SetGraphicsRootShaderResourceView(parameter, address);
+        break;
+    case RenderRootView::UnorderedAccess:
+        m_Compute ? m_CommandList->SetComputeRootUnorderedAccessView(parameter, address)
+                  : m_CommandList->SetGraphicsRootUnorderedAccessView(parameter, address);
+        break;
+    }
+}
+
+void D3D12RenderInterface::SetVertexBuffer(uint32_t slot, uint32_t id, uint64_t offset, uint32_t size, uint32_t stride)
+{
+    const Resource* resource = Find(id);
+    D3D12_VERTEX_BUFFER_VIEW view = {};
+    if (resource)
+    {
+        view.BufferLocation = resource->resource->GetGPUVirtualAddress() + offset;
+        view.SizeInBytes = size;
+        view.StrideInBytes = stride;
+    }
+    m_CommandList->IASetVertexBuffers(slot, 1, &view);
+}
+
+void D3D12RenderInterface::SetIndexBuffer(uint32_t id, uint64_t offset, uint32_t size, bool index32)
+{
+    const Resource* resource = Find(id);
+    D3D12_INDEX_BUFFER_VIEW view = {};
+    if (resource)
+    {
+        view.BufferLocation = resource->resource->GetGPUVirtualAddress() + offset;
+        view.SizeInBytes = size;
+        view.Format = index32 ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
+    }
+    m_CommandList->IASetIndexBuffer(&view);
+}
+
+void D3D12RenderInterface::Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+{
+    m_CommandList->DrawInstanced(vertexCount, instanceCount, firstVertex, firstInstance);
+}
+
+void D3D12RenderInterface::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex,
+    uint32_t firstInstance)
+{
+    m_CommandList->DrawIndexedInstanced(indexCount, instanceCount, firstIndex, baseVertex, firstInstance);
+}
+
+void D3D12RenderInterface::Dispatch(uint32_t x, uint32_t y, uint32_t z)
+{
+    m_CommandList->Dispatch(x, y, z);
+}
+
+void D3D12RenderInterface::ExecuteIndirect(uint32_t signature, uint32_t maxCount, uint32_t argumentBuffer,
+    uint64_t argumentOffset, uint32_t countBuffer, uint64_t countOffset)
+{
+    auto commandSignature = m_CommandSignatures.find(signature);
+    const Resource* arguments = Find(argumentBuffer);
+    const Resource* count = countBuffer != c_RenderNoResource ? Find(countBuffer) : nullptr;
+    if (commandSignature == m_CommandSignatures.end() || !arguments ||
+        (countBuffer != c_RenderNoResource && !count))
+    {
+        Report("ExecuteIndirect", signature, "unknown signature or buffer");
+        return;
+    }
+
+    m_CommandList->ExecuteIndirect(commandSignature->second.Get(), maxCount, arguments->resource.Get(), argumentOffset,
+        count ? count->resource.Get() : nullptr, countOffset);
+}
+
+void D3D12RenderInterface::CopyBuffer(uint32_t destination, uint64_t destinationOffset, uint32_t source,
+    uint64_t sourceOffset, uint64_t size)
+{
+    const Resource* dst = Find(destination);
+    const Resource* src = Find(source);
+    if (dst && src)
+    {
+        m_CommandList->CopyBufferRegion(dst->resource.Get(), destinationOffset, src->resource.Get(), sourceOffset, size);
+    }
+}
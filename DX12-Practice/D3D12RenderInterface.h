@@ -0,0 +1,147 @@
+#pragma once
+#include "Win.h"
+#include <wrl/client.h>
+
+#include "directx/d3dx12.h"
+
+#include "RenderInterface.h"
+
+#include <climits>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+// RenderInterface on a D3D12 device. The owner keeps the queue, allocators
+// and fences: before each BeginFrame() it hands over an open command list
+// with SetFrame(), and after EndFrame() closes and executes it. Updates are
+// staged in upload pages and copied on that list, in order with the other
+// commands. Destroyed objects and used upload pages are released once the
+// fence reaches the frame that last referenced them.
+//
+// Render target and depth stencil views are created with the resource, so
+// their formats must not be typeless. Root arguments are set as graphics or
+// compute arguments depending on the bound pipeline.
+class D3D12RenderInterface : public RenderInterface
+{
+public:
+    explicit D3D12RenderInterface(Microsoft::WRL::ComPtr<ID3D12Device2> device, uint32_t maxRenderTargets = 256);
+
+    D3D12RenderInterface(const D3D12RenderInterface&) = delete;
+    D3D12RenderInterface& operator=(const D3D12RenderInterface&) = delete;
+
+    // frameFenceValue is what the queue will signal when this frame is done,
+    // completedFenceValue what the fence has reached so far.
+    void SetFrame(ID3D12GraphicsCommandList* commandList, uint64_t frameFenceValue, uint64_t completedFenceValue);
+
+    ID3D12Resource* GetResource(uint32_t id) const;
+
+    // Pipeline blobs for CreatePipeline: the description with its shaders and
+    // input layout inlined. Stream output and cached blobs are not kept.
+    static std::vector<uint8_t> SerializePipeline(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+    static std::vector<uint8_t> SerializePipeline(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc);
+
+    const char* GetName() const override { return "d3d12"; }
+
+    void BeginFrame() override;
+    void EndFrame() override;
+
+    void CreateBuffer(uint32_t id, uint64_t size, uint32_t flags) override;
+    void CreateTexture(uint32_t id, const RenderTextureDesc& desc) override;
+    void ImportTexture(uint32_t id, const RenderTextureDesc& desc, void* native) override;
+    void CreateRootSignature(uint32_t id, const void* blob, size_t size) override;
+    void CreatePipeline(uint32_t id, uint32_t rootSignature, const void* blob, size_t size) override;
+    void CreateCommandSignature(uint32_t id, const std::vector<IndirectArgument>& arguments, uint32_t byteStride,
+        uint32_t rootSignature) override;
+    void Destroy(uint32_t id) override;
+
+    void UpdateBuffer(uint32_t id, uint64_t offset, const void* data, uint64_t size) override;
+    void UpdateTexture(uint32_t id, uint32_t subresource, const void* data, uint64_t rowPitch, uint64_t slicePitch) override;
+
+    void Barrier(uint32_t id, uint32_t before, uint32_t after) override;
+    void UnorderedBarrier(uint32_t id) override;
+
+    void SetRenderTargets(uint32_t count, const uint32_t* renderTargets, uint32_t depthStencil) override;
+    void SetViewport(float x, float y, float width, float height, float minDepth, float maxDepth) override;
+    void ClearRenderTarget(uint32_t id, const float color[4]) override;
+    void ClearDepthStencil(uint32_t id, float depth, uint8_t stencil) override;
+
+    void SetPipeline(uint32_t id) override;
+    void SetPrimitiveTopology(uint32_t topology) override;
+    void SetRootConstants(uint32_t parameter, uint32_t count, const uint32_t* values, uint32_t destOffset) override;
+    void SetRootView(uint32_t parameter, RenderRootView type, uint32_t id, uint64_t offset) override;
+    void SetVertexBuffer(uint32_t slot, uint32_t id, uint64_t offset, uint32_t size, uint32_t stride) override;
+    void SetIndexBuffer(uint32_t id, uint64_t offset, uint32_t size, bool index32) override;
+
+    void Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) override;
+    void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex,
+        uint32_t firstInstance) override;
+    void Dispatch(uint32_t x, uint32_t y, uint32_t z) override;
+    void ExecuteIndirect(uint32_t signature, uint32_t maxCount, uint32_t argumentBuffer, uint64_t argumentOffset,
+        uint32_t countBuffer, uint64_t countOffset) override;
+
+    void CopyBuffer(uint32_t destination, uint64_t destinationOffset, uint32_t source, uint64_t sourceOffset,
+        uint64_t size) override;
+
+private:
+    struct Resource
+    {
+        Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+        UINT rtv = UINT_MAX;
+        UINT dsv = UINT_MAX;
+    };
+
+    struct Pipeline
+    {
+        Microsoft::WRL::ComPtr<ID3D12PipelineState> state;
+        Microsoft::WRL::ComPtr<ID3D12RootSignature> rootSignature;
+        bool compute;
+    };
+
+    struct UploadPage
+    {
+        Microsoft::WRL::ComPtr<ID3D12Resource> buffer;
+        uint8_t* data = nullptr;
+        UINT64 size = 0;
+        uint64_t fenceValue = 0;    // last frame that copies from it
+    };
+
+    struct Retired
+    {
+        uint64_t fenceValue;
+        Microsoft::WRL::ComPtr<ID3D12Object> object;
+    };
+
+    const Resource* Find(uint32_t id) const;
+    void AddResource(uint32_t id, Microsoft::WRL::ComPtr<ID3D12Resource> resource, uint32_t flags);
+    // Removes every object under id, retiring it until this frame completes.
+    void Release(uint32_t id);
+    void Retire(Microsoft::WRL::ComPtr<ID3D12Object> object);
+    uint8_t* AllocateUpload(UINT64 size, UINT64 alignment, ID3D12Resource** buffer, UINT64* offset);
+
+    Microsoft::WRL::ComPtr<ID3D12Device2> m_Device;
+    ID3D12GraphicsCommandList* m_CommandList = nullptr;
+    uint64_t m_FrameFenceValue = 0;
+    uint64_t m_CompletedFenceValue = 0;
+
+    std::unordered_map<uint32_t, Resource> m_Resources;
+    std::unordered_map<uint32_t, Microsoft::WRL::ComPtr<ID3D12RootSignature>> m_RootSignatures;
+    std::unordered_map<uint32_t, Pipeline> m_Pipelines;
+    std::unordered_map<uint32_t, Microsoft::WRL::ComPtr<ID3D12CommandSignature>> m_CommandSignatures;
+    bool m_Compute = false;                     // type of the bound pipeline
+
+    // Views are copied into the command list when recorded, so freed slots
+    // can be reused right away.
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_RtvHeap;
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_DsvHeap;
+    UINT m_RtvSize = 0;
+    UINT m_DsvSize = 0;
+    std::vector<UINT> m_FreeRtvs;
+    std::vector<UINT> m_FreeDsvs;
+
+    UploadPage m_UploadPage;
+    UINT64 m_UploadOffset = 0;
+    std::deque<UploadPage> m_UsedPages;         // in fence order
+    std::vector<UploadPage> m_FreePages;
+    std::deque<Retired> m_Retired;              // in fence order
+};
@@ -0,0 +1,87 @@
+#pragma once
+#include "directx/dxgiformat.h"
+
+#include <cstdint>
+
+// On-disk DDS layout: the magic, DdsHeader, an optional DdsHeaderDxt10 (when
+// the pixel format's fourCC is "DX10"), then every subresource tightly
+// packed, mips of the first array slice first.
+constexpr uint32_t MakeDdsFourCC(char a, char b, char c, char d)
+{
+    return uint32_t(uint8_t(a)) | (uint32_t(uint8_t(b)) << 8) | (uint32_t(uint8_t(c)) << 16) | (uint32_t(uint8_t(d)) << 24);
+}
+
+constexpr uint32_t c_DdsMagic = MakeDdsFourCC('D', 'D', 'S', ' ');
+
+// DdsHeader::flags
+constexpr uint32_t c_DdsFlagCaps = 0x1;
+constexpr uint32_t c_DdsFlagHeight = 0x2;
+constexpr uint32_t c_DdsFlagWidth = 0x4;
+constexpr uint32_t c_DdsFlagPitch = 0x8;
+constexpr uint32_t c_DdsFlagPixelFormat = 0x1000;
+constexpr uint32_t c_DdsFlagMipMapCount = 0x20000;
+constexpr uint32_t c_DdsFlagLinearSize = 0x80000;
+constexpr uint32_t c_DdsFlagDepth = 0x800000;
+
+// DdsPixelFormat::flags
+constexpr uint32_t c_DdsPixelAlpha = 0x1;
+constexpr uint32_t c_DdsPixelFourCC = 0x4;
+constexpr uint32_t c_DdsPixelRGB = 0x40;
+constexpr uint32_t c_DdsPixelLuminance = 0x20000;
+
+// DdsHeader::caps / caps2
+constexpr uint32_t c_DdsCapsComplex = 0x8;
+constexpr uint32_t c_DdsCapsTexture = 0x1000;
+constexpr uint32_t c_DdsCapsMipMap = 0x400000;
+constexpr uint32_t c_DdsCaps2Cubemap = 0x200;
+constexpr uint32_t c_DdsCaps2CubemapAllFaces = 0xfc00;
+constexpr uint32_t c_DdsCaps2Volume = 0x200000;
+
+// DdsHeaderDxt10::resourceDimension / miscFlag
+constexpr uint32_t c_DdsDimensionTexture1D = 2;
+constexpr uint32_t c_DdsDimensionTexture2D = 3;
+constexpr uint32_t c_DdsDimensionTexture3D = 4;
+constexpr uint32_t c_DdsMiscTextureCube = 0x4;
+
+struct DdsPixelFormat
+{
+    uint32_t size;
+    uint32_t flags;
+    uint32_t fourCC;
+    uint32_t rgbBitCount;
+    uint32_t rBitMask;
+    uint32_t gBitMask;
+    uint32_t bBitMask;
+    uint32_t aBitMask;
+};
+
+struct DdsHeader
+{
+    uint32_t size;
+    uint32_t flags;
+    uint32_t height;
+    uint32_t width;
+    uint32_t pitchOrLinearSize;
+    uint32_t depth;
+    uint32_t mipMapCount;
+    uint32_t reserved1[11];
+    DdsPixelFormat pixelFormat;
+    uint32_t caps;
+    uint32_t caps2;
+    uint32_t caps3;
+    uint32_t caps4;
+    uint32_t reserved2;
+};
+
+struct DdsHeaderDxt10
+{
+    DXGI_FORMAT dxgiFormat;
+    uint32_t resourceDimension;
+    uint32_t miscFlag;
+    uint32_t arraySize;
+    uint32_t miscFlags2;
+};
+
+static_assert(sizeof(DdsPixelFormat) == 32, "DDS pixel format layout");
+static_assert(sizeof(DdsHeader) == 124, "DDS header layout");
+static_assert(sizeof(DdsHeaderDxt10) == 20, "DDS DX10 header layout");
@@ -0,0 +1,174 @@
+#include "DrawList.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace
+{
+    const uint32_t c_RadixBits = 8;
+    const uint32_t c_RadixSize = 1u << c_RadixBits;
+    const uint32_t c_RadixPasses = 64 / c_RadixBits;
+    // Below this, one chunk; parallel histograms don't pay off.
+    const uint32_t c_MinChunkSize = 16 * 1024;
+
+    void RunChunks(JobSystem* jobSystem, uint32_t chunkCount, const std::function<void(uint32_t, uint32_t)>& func)
+    {
+        if (jobSystem && chunkCount > 1)
+        {
+            jobSystem->ParallelFor(chunkCount, 1, func);
+        }
+        else
+        {
+            func(0, chunkCount);
+        }
+    }
+}
+
+void RadixSortDrawItems(std::vector<DrawItem>& items, std::vector<DrawItem>& scratch, JobSystem* jobSystem)
+{
+    const uint32_t count = static_cast<uint32_t>(items.size());
+    if (count < 64)
+    {
+        std::stable_sort(items.begin(), items.end(), [](const DrawItem& a, const DrawItem& b) { return a.key < b.key; });
+        return;
+    }
+
+    scratch.resize(count);
+
+    uint32_t workers = jobSystem ? jobSystem->GetWorkerCount() + 1 : 1;
+    uint32_t chunkCount = std::max<uint32_t>(1, std::min(workers * 2, count / c_MinChunkSize));
+    uint32_t chunkSize = (count + chunkCount - 1) / chunkCount;
+
+    // A digit is skippable when every key has the same value; the XOR of all
+    // keys against the first one has zero bits there.
+    std::vector<uint64_t> chunkDiffs(chunkCount, 0);
+    const uint64_t firstKey = items[0].key;
+    RunChunks(jobSystem, chunkCount, [&](uint32_t beginChunk, uint32_t endChunk) {
+        for (uint32_t chunk = beginChunk; chunk < endChunk; ++chunk)
+        {
+            uint32_t begin = chunk * chunkSize;
+            uint32_t end = std::min(count, begin + chunkSize);
+            uint64_t diff = 0;
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                diff |= items[i].key ^ firstKey;
+            }
+            chunkDiffs[chunk] = diff;
+        }
+    });
+    uint64_t diff = 0;
+    for (auto chunkDiff : chunkDiffs)
+    {
+        diff |= chunkDiff;
+    }
+
+    std::vector<uint32_t> histograms(static_cast<size_t>(chunkCount) * c_RadixSize);
+    DrawItem* source = items.data();
+    DrawItem* destination = scratch.data();
+
+    for (uint32_t pass = 0; pass < c_RadixPasses; ++pass)
+    {
+        const uint32_t shift = pass * c_RadixBits;
+        if (((diff >> shift) & (c_RadixSize - 1)) == 0)
+        {
+            continue;
+        }
+
+        RunChunks(jobSystem, chunkCount, [&](uint32_t beginChunk, uint32_t endChunk) {
+            for (uint32_t chunk = beginChunk; chunk < endChunk; ++chunk)
+            {
+                uint32_t* histogram = &histograms[static_cast<size_t>(chunk) * c_RadixSize];
+                memset(histogram, 0, sizeof(uint32_t) * c_RadixSize);
+                uint32_t begin = chunk * chunkSize;
+                uint32_t end = std::min(count, begin + chunkSize);
+                for (uint32_t i = begin; i < end; ++i)
+                {
+                    ++histogram[(source[i].key >> shift) & (c_RadixSize - 1)];
+                }
+            }
+        });
+
+        // Exclusive prefix over (digit, chunk) so that the scatter is stable.
+        uint32_t offset = 0;
+        for (uint32_t digit = 0; digit < c_RadixSize; ++digit)
+        {
+            for (uint32_t chunk = 0; chunk < chunkCount; ++chunk)
+            {
+                uint32_t& bucket = histograms[static_cast<size_t>(chunk) * c_RadixSize + digit];
+                uint32_t bucketCount = bucket;
+                bucket = offset;
+                offset += bucketCount;
+            }
+        }
+
+        RunChunks(jobSystem, chunkCount, [&](uint32_t beginChunk, uint32_t endChunk) {
+            for (uint32_t chunk = beginChunk; chunk < endChunk; ++chunk)
+            {
+                uint32_t* offsets = &histograms[static_cast<size_t>(chunk) * c_RadixSize];
+                uint32_t begin = chunk * chunkSize;
+                uint32_t end = std::min(count, begin + chunkSize);
+                for (uint32_t i = begin; i < end; ++i)
+                {
+                    destination[offsets[(source[i].key >> shift) & (c_RadixSize - 1)]++] = source[i];
+                }
+            }
+        });
+
+        std::swap(source, destination);
+    }
+
+    if (source != items.data())
+    {
+        items.swap(scratch);
+    }
+}
+
+DrawQueue::DrawQueue(uint32_t threadCount)
+    : m_Lists(std::max<uint32_t>(1, threadCount))
+{
+}
+
+void DrawQueue::Reset()
+{
+    for (auto& list : m_Lists)
+    {
+        list.clear();
+    }
+    m_Sorted.clear();
+}
+
+void DrawQueue::Sort(JobSystem* jobSystem)
+{
+    size_t total = 0;
+    for (const auto& list : m_Lists)
+    {
+        total += list.size();
+    }
+
+    m_Sorted.clear();
+    m_Sorted.reserve(total);
+    for (const auto& list : m_Lists)
+    {
+        m_Sorted.insert(m_Sorted.end(), list.begin(), list.end());
+    }
+
+    RadixSortDrawItems(m_Sorted, m_Scratch, jobSystem);
+}
+
+DrawQueue::StateChanges DrawQueue::CountStateChanges() const
+{
+    StateChanges changes = { 0, 0 };
+    const uint64_t pipelineMask = ~0ull << DrawKey::c_PipelineShift;
+    const uint64_t materialMask = ~0ull << DrawKey::c_MaterialShift;
+
+    for (size_t i = 0; i < m_Sorted.size(); ++i)
+    {
+        uint64_t key = m_Sorted[i].key;
+        uint64_t previous = i ? m_Sorted[i - 1].key : ~key;
+        changes.pipelines += ((key ^ previous) & pipelineMask) ? 1 : 0;
+        changes.materials += ((key ^ previous) & materialMask) ? 1 : 0;
+    }
+    return changes;
+}
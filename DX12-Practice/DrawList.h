@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+// 64-bit draw sort key, most significant field first:
+//   layer:4 | pipeline:16 | material:20 | depth:24
+// Sorting by key groups draws by layer, then pipeline state (PSO and root
+// signature), then material (descriptor tables), then depth.
+namespace DrawKey
+{
+    const uint32_t c_LayerBits = 4;
+    const uint32_t c_PipelineBits = 16;
+    const uint32_t c_MaterialBits = 20;
+    const uint32_t c_DepthBits = 24;
+
+    const uint32_t c_DepthShift = 0;
+    const uint32_t c_MaterialShift = c_DepthShift + c_DepthBits;
+    const uint32_t c_PipelineShift = c_MaterialShift + c_MaterialBits;
+    const uint32_t c_LayerShift = c_PipelineShift + c_PipelineBits;
+
+    // depth is view depth normalized to [0, 1]. Opaque layers sort front to
+    // back; pass backToFront for translucent layers.
+    inline uint64_t Make(uint32_t layer, uint32_t pipeline, uint32_t material, float depth, bool backToFront = false)
+    {
+        depth = depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth);
+        const uint32_t maxDepth = (1u << c_DepthBits) - 1;
+        uint32_t quantized = static_cast<uint32_t>(depth * maxDepth);
+        if (backToFront)
+        {
+            quantized = maxDepth - quantized;
+        }
+
+        return (static_cast<uint64_t>(layer & ((1u << c_LayerBits) - 1)) << c_LayerShift) |
+            (static_cast<uint64_t>(pipeline & ((1u << c_PipelineBits) - 1)) << c_PipelineShift) |
+            (static_cast<uint64_t>(material & ((1u << c_MaterialBits) - 1)) << c_MaterialShift) |
+            (static_cast<uint64_t>(quantized) << c_DepthShift);
+    }
+
+    inline uint32_t GetLayer(uint64_t key) { return static_cast<uint32_t>(key >> c_LayerShift) & ((1u << c_LayerBits) - 1); }
+    inline uint32_t GetPipeline(uint64_t key) { return static_cast<uint32_t>(key >> c_PipelineShift) & ((1u << c_PipelineBits) - 1); }
+    inline uint32_t GetMaterial(uint64_t key) { return static_cast<uint32_t>(key >> c_MaterialShift) & ((1u << c_MaterialBits) - 1); }
+}
+
+struct DrawItem
+{
+    uint64_t key;
+    uint32_t payload;   // index into the caller's draw data
+};
+
+// Stable LSD radix sort on DrawItem::key, 8 bits per pass. Histograms and
+// scatters run in parallel chunks on the job system; passes whose digit is
+// the same for every key are skipped. scratch is resized as needed.
+void RadixSortDrawItems(std::vector<DrawItem>& items, std::vector<DrawItem>& scratch, JobSystem* jobSystem);
+
+// Draw submission queue. Each recording thread appends to its own list;
+// Sort() merges the lists and sorts the result by key.
+class DrawQueue
+{
+public:
+    explicit DrawQueue(uint32_t threadCount = 1);
+
+    void Reset();
+
+    // Not thread-safe across threads for the same index.
+    void Add(uint32_t threadIndex, uint64_t key, uint32_t payload) { m_Lists[threadIndex].push_back({ key, payload }); }
+    std::vector<DrawItem>& GetList(uint32_t threadIndex) { return m_Lists[threadIndex]; }
+    uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_Lists.size()); }
+
+    void Sort(JobSystem* jobSystem);
+
+    const std::vector<DrawItem>& GetSorted() const { return m_Sorted; }
+
+    struct StateChanges
+    {
+        uint32_t pipelines;
+        uint32_t materials;
+    };
+    // Number of pipeline and material switches recording the sorted list costs.
+    StateChanges CountStateChanges() const;
+
+private:
+    std::vector<std::vector<DrawItem>> m_Lists;
+    std::vector<DrawItem> m_Sorted;
+    std::vector<DrawItem> m_Scratch;
+};
@@ -0,0 +1,320 @@
+#include "EntityStore.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+namespace
+{
+    const size_t c_ColumnAlignment = 64;
+
+    struct ComponentInfo
+    {
+        uint32_t size;
+        uint32_t alignment;
+    };
+
+    std::mutex g_ComponentMutex;
+    std::vector<ComponentInfo> g_Components;
+
+    ComponentInfo GetComponentInfo(ComponentTypeId id)
+    {
+        std::lock_guard<std::mutex> lock(g_ComponentMutex);
+        return g_Components[id];
+    }
+
+    uint32_t AlignUp(uint32_t value, uint32_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+ComponentTypeId RegisterComponentType(uint32_t size, uint32_t alignment)
+{
+    std::lock_guard<std::mutex> lock(g_ComponentMutex);
+    assert(g_Components.size() < c_MaxComponentTypes);
+    assert(alignment <= c_ColumnAlignment);
+    g_Components.push_back({ size, alignment });
+    return static_cast<ComponentTypeId>(g_Components.size() - 1);
+}
+
+EntityStore::~EntityStore()
+{
+    for (auto& archetype : m_Archetypes)
+    {
+        for (auto& chunk : archetype->chunks)
+        {
+            FreeChunkMemory(chunk->data);
+        }
+    }
+    for (uint8_t* data : m_FreeChunkMemory)
+    {
+        ::operator delete(data, std::align_val_t(c_ColumnAlignment));
+    }
+}
+
+uint8_t* EntityStore::AllocateChunkMemory()
+{
+    if (!m_FreeChunkMemory.empty())
+    {
+        uint8_t* data = m_FreeChunkMemory.back();
+        m_FreeChunkMemory.pop_back();
+        return data;
+    }
+    return static_cast<uint8_t*>(::operator new(c_EntityChunkSize, std::align_val_t(c_ColumnAlignment)));
+}
+
+void EntityStore::FreeChunkMemory(uint8_t* data)
+{
+    m_FreeChunkMemory.push_back(data);
+}
+
+Archetype& EntityStore::GetArchetype(ComponentMask mask)
+{
+    auto found = m_ArchetypeByMask.find(mask);
+    if (found != m_ArchetypeByMask.end())
+    {
+        return *found->second;
+    }
+
+    auto archetype = std::make_unique<Archetype>();
+    archetype->mask = mask;
+    memset(archetype->columns, -1, sizeof(archetype->columns));
+
+    uint32_t bytesPerEntity = sizeof(Entity);
+    for (ComponentTypeId id = 0; id < c_MaxComponentTypes; ++id)
+    {
+        if ((mask >> id) & 1)
+        {
+            archetype->columns[id] = static_cast<int8_t>(archetype->types.size());
+            archetype->types.push_back(id);
+            archetype->sizes.push_back(GetComponentInfo(id).size);
+            bytesPerEntity += archetype->sizes.back();
+        }
+    }
+
+    // Start from the unpadded capacity and shrink until the aligned columns fit.
+    uint32_t capacity = c_EntityChunkSize / bytesPerEntity;
+    for (;;)
+    {
+        archetype->offsets.clear();
+        uint32_t offset = AlignUp(capacity * sizeof(Entity), c_ColumnAlignment);
+        for (uint32_t size : archetype->sizes)
+        {
+            archetype->offsets.push_back(offset);
+            offset = AlignUp(offset + capacity * size, c_ColumnAlignment);
+        }
+        if (offset <= c_EntityChunkSize)
+        {
+            break;
+        }
+        --capacity;
+    }
+    assert(capacity > 0);
+    archetype->capacity = capacity;
+
+    Archetype* result = archetype.get();
+    m_Archetypes.push_back(std::move(archetype));
+    m_ArchetypeByMask[mask] = result;
+    return *result;
+}
+
+void EntityStore::AllocateRow(Archetype& archetype, Entity entity, uint32_t& chunkIndex, uint32_t& row)
+{
+    if (archetype.chunks.empty() || archetype.chunks.back()->count == archetype.capacity)
+    {
+        auto chunk = std::make_unique<EntityChunk>();
+        chunk->data = AllocateChunkMemory();
+        chunk->versions.assign(archetype.types.size(), m_Version);
+        archetype.chunks.push_back(std::move(chunk));
+    }
+
+    chunkIndex = static_cast<uint32_t>(archetype.chunks.size() - 1);
+    EntityChunk& chunk = *archetype.chunks.back();
+    row = chunk.count++;
+
+    reinterpret_cast<Entity*>(chunk.data)[row] = entity;
+    for (size_t column = 0; column < archetype.types.size(); ++column)
+    {
+        memset(chunk.data + archetype.offsets[column] + row * archetype.sizes[column], 0, archetype.sizes[column]);
+        chunk.versions[column] = m_Version;
+    }
+}
+
+void EntityStore::FreeRow(Archetype& archetype, uint32_t chunkIndex, uint32_t row)
+{
+    // Fill the hole with the archetype's last entity, so only the last chunk
+    // is ever partially filled.
+    EntityChunk& chunk = *archetype.chunks[chunkIndex];
+    EntityChunk& last = *archetype.chunks.back();
+    uint32_t lastRow = last.count - 1;
+
+    if (&chunk != &last || row != lastRow)
+    {
+        Entity moved = reinterpret_cast<Entity*>(last.data)[lastRow];
+        reinterpret_cast<Entity*>(chunk.data)[row] = moved;
+        for (size_t column = 0; column < archetype.types.size(); ++column)
+        {
+            uint32_t size = archetype.sizes[column];
+            memcpy(chunk.data + archetype.offsets[column] + row * size, last.data + archetype.offsets[column] + lastRow * size, size);
+            chunk.versions[column] = m_Version;
+        }
+
+        m_Records[moved.index].chunk = chunkIndex;
+        m_Records[moved.index].row = row;
+    }
+
+    for (auto& version : last.versions)
+    {
+        version = m_Version;
+    }
+    if (--last.count == 0)
+    {
+        FreeChunkMemory(last.data);
+        archetype.chunks.pop_back();
+    }
+}
+
+Entity EntityStore::CreateEntity(ComponentMask mask)
+{
+    Entity entity;
+    if (!m_FreeRecords.empty())
+    {
+        entity.index = m_FreeRecords.back();
+        m_FreeRecords.pop_back();
+    }
+    else
+    {
+        entity.index = static_cast<uint32_t>(m_Records.size());
+        m_Records.emplace_back();
+    }
+
+    EntityRecord& record = m_Records[entity.index];
+    entity.generation = record.generation;
+    record.archetype = &GetArchetype(mask);
+    AllocateRow(*record.archetype, entity, record.chunk, record.row);
+    ++m_AliveCount;
+    return entity;
+}
+
+void EntityStore::Destroy(Entity entity)
+{
+    assert(IsAlive(entity));
+    EntityRecord& record = m_Records[entity.index];
+    FreeRow(*record.archetype, record.chunk, record.row);
+    record.archetype = nullptr;
+    ++record.generation;
+    m_FreeRecords.push_back(entity.index);
+    --m_AliveCount;
+}
+
+bool EntityStore::IsAlive(Entity entity) const
+{
+    return entity.index < m_Records.size() && m_Records[entity.index].archetype &&
+        m_Records[entity.index].generation == entity.generation;
+}
+
+ComponentMask EntityStore::GetMask(Entity entity) const
+{
+    assert(IsAlive(entity));
+    return m_Records[entity.index].archetype->mask;
+}
+
+void EntityStore::SetMask(Entity entity, ComponentMask mask)
+{
+    assert(IsAlive(entity));
+    EntityRecord& record = m_Records[entity.index];
+    Archetype& source = *record.archetype;
+    if (source.mask == mask)
+    {
+        return;
+    }
+
+    Archetype& target = GetArchetype(mask);
+    uint32_t chunkIndex, row;
+    AllocateRow(target, entity, chunkIndex, row);
+
+    // Copy the components both archetypes share; new ones stay zeroed.
+    EntityChunk& from = *source.chunks[record.chunk];
+    EntityChunk& to = *target.chunks[chunkIndex];
+    for (size_t column = 0; column < target.types.size(); ++column)
+    {
+        int sourceColumn = source.columns[target.types[column]];
+        if (sourceColumn >= 0)
+        {
+            uint32_t size = target.sizes[column];
+            memcpy(to.data + target.offsets[column] + row * size, from.data + source.offsets[sourceColumn] + record.row * size, size);
+        }
+    }
+
+    FreeRow(source, record.chunk, record.row);
+    record.archetype = &target;
+    record.chunk = chunkIndex;
+    record.row = row;
+}
+
+void* EntityStore::GetComponent(Entity entity, ComponentTypeId id, bool write) const
+{
+    assert(IsAlive(entity));
+    const EntityRecord& record = m_Records[entity.index];
+    const Archetype& archetype = *record.archetype;
+    int column = archetype.columns[id];
+    if (column < 0)
+    {
+        return nullptr;
+    }
+
+    EntityChunk& chunk = *archetype.chunks[record.chunk];
+    if (write)
+    {
+        chunk.versions[column] = m_Version;
+    }
+    return chunk.data + archetype.offsets[column] + record.row * archetype.sizes[column];
+}
+
+void EntityStore::ForEachChunk(ComponentMask required, JobSystem* jobSystem, const std::function<void(ChunkView&)>& func)
+{
+    std::vector<std::pair<Archetype*, EntityChunk*>> chunks;
+    for (auto& archetype : m_Archetypes)
+    {
+        if ((archetype->mask & required) == required)
+        {
+            for (auto& chunk : archetype->chunks)
+            {
+                chunks.emplace_back(archetype.get(), chunk.get());
+            }
+        }
+    }
+
+    auto run = [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            ChunkView view(*chunks[i].first, *chunks[i].second, m_Version);
+            func(view);
+        }
+    };
+
+    uint32_t count = static_cast<uint32_t>(chunks.size());
+    if (jobSystem)
+    {
+        jobSystem->ParallelFor(count, 1, run);
+    }
+    else
+    {
+        run(0, count);
+    }
+}
+
+uint32_t EntityStore::GetChunkCount() const
+{
+    uint32_t count = 0;
+    for (auto& archetype : m_Archetypes)
+    {
+        count += static_cast<uint32_t>(archetype->chunks.size());
+    }
+    return count;
+}
@@ -0,0 +1,217 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+class JobSystem;
+
+// Archetype-based entity-component store. Entities with the same set of
+// component types share an archetype, whose data lives in 16 KB chunks laid
+// out as structure-of-arrays (one 64-byte aligned array per component), so
+// queries iterate contiguous component arrays instead of objects.
+//
+// Every chunk keeps a change version per component: writes through
+// GetMutable() and structural changes stamp the store's current version, so
+// consumers such as render extraction can skip chunks that have not changed
+// since they last looked.
+//
+// Components must be trivially copyable; they are moved with memcpy when an
+// entity changes archetype. Structural changes (Create/Destroy/Add/Remove)
+// must not overlap a ForEach.
+
+using ComponentTypeId = uint32_t;
+using ComponentMask = uint64_t;
+
+const uint32_t c_MaxComponentTypes = 64;
+const uint32_t c_EntityChunkSize = 16 * 1024;
+
+ComponentTypeId RegisterComponentType(uint32_t size, uint32_t alignment);
+
+template<typename T>
+ComponentTypeId GetComponentTypeId()
+{
+    static_assert(std::is_trivially_copyable<T>::value, "components are moved with memcpy");
+    static const ComponentTypeId id = RegisterComponentType(sizeof(T), alignof(T));
+    return id;
+}
+
+template<typename... Ts>
+ComponentMask GetComponentMask()
+{
+    const ComponentMask bits[] = { 0, (ComponentMask(1) << GetComponentTypeId<Ts>())... };
+    ComponentMask mask = 0;
+    for (ComponentMask bit : bits)
+    {
+        mask |= bit;
+    }
+    return mask;
+}
+
+struct Entity
+{
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool IsValid() const { return index != UINT32_MAX; }
+    bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+};
+
+struct EntityChunk
+{
+    uint8_t* data = nullptr;            // c_EntityChunkSize bytes, 64-byte aligned
+    uint32_t count = 0;
+    std::vector<uint32_t> versions;     // per archetype column
+};
+
+struct Archetype
+{
+    ComponentMask mask = 0;
+    std::vector<ComponentTypeId> types;     // ascending
+    std::vector<uint32_t> sizes;
+    std::vector<uint32_t> offsets;          // column offsets; entities at 0
+    int8_t columns[c_MaxComponentTypes];    // type id -> column, or -1
+    uint32_t capacity = 0;
+    std::vector<std::unique_ptr<EntityChunk>> chunks;
+};
+
+// One chunk as seen by a query.
+class ChunkView
+{
+public:
+    ChunkView(Archetype& archetype, EntityChunk& chunk, uint32_t version)
+        : m_Archetype(archetype)
+        , m_Chunk(chunk)
+        , m_Version(version)
+    {}
+
+    uint32_t GetCount() const { return m_Chunk.count; }
+    const Entity* GetEntities() const { return reinterpret_cast<const Entity*>(m_Chunk.data); }
+
+    // Components outside the query may be missing from the chunk: Get and
+    // GetMutable then return nullptr and HasChanged false.
+    template<typename T>
+    const T* Get() const
+    {
+        int column = m_Archetype.columns[GetComponentTypeId<T>()];
+        return column < 0 ? nullptr : reinterpret_cast<const T*>(m_Chunk.data + m_Archetype.offsets[column]);
+    }
+
+    // Stamps the component's chunk version.
+    template<typename T>
+    T* GetMutable()
+    {
+        int column = m_Archetype.columns[GetComponentTypeId<T>()];
+        if (column < 0)
+        {
+            return nullptr;
+        }
+        m_Chunk.versions[column] = m_Version;
+        return reinterpret_cast<T*>(m_Chunk.data + m_Archetype.offsets[column]);
+    }
+
+    template<typename T>
+    bool HasChanged(uint32_t sinceVersion) const
+    {
+        int column = m_Archetype.columns[GetComponentTypeId<T>()];
+        return column >= 0 && m_Chunk.versions[column] > sinceVersion;
+    }
+
+private:
+
+    Archetype& m_Archetype;
+    EntityChunk& m_Chunk;
+    uint32_t m_Version;
+};
+
+class EntityStore
+{
+public:
+    EntityStore() = default;
+    ~EntityStore();
+
+    EntityStore(const EntityStore&) = delete;
+    EntityStore& operator=(const EntityStore&) = delete;
+
+    template<typename... Ts>
+    Entity Create(const Ts&... components)
+    {
+        Entity entity = CreateEntity(GetComponentMask<Ts...>());
+        int expand[] = { 0, (*GetMutable<Ts>(entity) = components, 0)... };
+        (void)expand;
+        return entity;
+    }
+
+    void Destroy(Entity entity);
+    bool IsAlive(Entity entity) const;
+
+    template<typename T>
+    void Add(Entity entity, const T& component)
+    {
+        SetMask(entity, GetMask(entity) | (ComponentMask(1) << GetComponentTypeId<T>()));
+        *GetMutable<T>(entity) = component;
+    }
+
+    template<typename T>
+    void Remove(Entity entity) { SetMask(entity, GetMask(entity) & ~(ComponentMask(1) << GetComponentTypeId<T>())); }
+
+    template<typename T>
+    bool Has(Entity entity) const { return (GetMask(entity) >> GetComponentTypeId<T>()) & 1; }
+
+    template<typename T>
+    const T* Get(Entity entity) const { return static_cast<const T*>(GetComponent(entity, GetComponentTypeId<T>(), false)); }
+
+    template<typename T>
+    T* GetMutable(Entity entity) { return static_cast<T*>(GetComponent(entity, GetComponentTypeId<T>(), true)); }
+
+    // Calls func(ChunkView&) for every chunk holding all of Ts..., one job per
+    // chunk when a job system is given.
+    template<typename... Ts>
+    void ForEach(JobSystem* jobSystem, const std::function<void(ChunkView&)>& func)
+    {
+        ForEachChunk(GetComponentMask<Ts...>(), jobSystem, func);
+    }
+
+    // Writes stamp the current version. Advance once per frame; a consumer
+    // that remembers GetVersion() before advancing can pass it to
+    // ChunkView::HasChanged later.
+    uint32_t GetVersion() const { return m_Version; }
+    void AdvanceVersion() { ++m_Version; }
+
+    uint32_t GetEntityCount() const { return m_AliveCount; }
+    uint32_t GetChunkCount() const;
+
+private:
+    struct EntityRecord
+    {
+        Archetype* archetype = nullptr;
+        uint32_t chunk = 0;
+        uint32_t row = 0;
+        uint32_t generation = 0;
+    };
+
+    Entity CreateEntity(ComponentMask mask);
+    ComponentMask GetMask(Entity entity) const;
+    void SetMask(Entity entity, ComponentMask mask);
+    void* GetComponent(Entity entity, ComponentTypeId id, bool write) const;
+    void ForEachChunk(ComponentMask required, JobSystem* jobSystem, const std::function<void(ChunkView&)>& func);
+
+    Archetype& GetArchetype(ComponentMask mask);
+    // Reserves a zeroed row in the archetype and returns (chunk, row).
+    void AllocateRow(Archetype& archetype, Entity entity, uint32_t& chunkIndex, uint32_t& row);
+    // Swap-removes the row, fixing up the record of the entity moved into it.
+    void FreeRow(Archetype& archetype, uint32_t chunkIndex, uint32_t row);
+
+    uint8_t* AllocateChunkMemory();
+    void FreeChunkMemory(uint8_t* data);
+
+    std::vector<std::unique_ptr<Archetype>> m_Archetypes;
+    std::unordered_map<ComponentMask, Archetype*> m_ArchetypeByMask;
+    std::vector<EntityRecord> m_Records;
+    std::vector<uint32_t> m_FreeRecords;
+    std::vector<uint8_t*> m_FreeChunkMemory;
+    uint32_t m_AliveCount = 0;
+    uint32_t m_Version = 1;
+};
@@ -0,0 +1,274 @@
+#include "FileWatcher.h"
+
+#include <cstdint>
+
+#if defined(_WIN32)
+#include "Win.h"
+#else
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    std::filesystem::path NormalizeDirectory(const std::filesystem::path& directory)
+    {
+        std::error_code error;
+        auto path = std::filesystem::absolute(directory, error).lexically_normal();
+        // "shaders/" normalizes with a trailing separator.
+        return path.has_filename() ? path : path.parent_path();
+    }
+}
+
+FileWatcher::FileWatcher(std::chrono::milliseconds settleTime)
+    : m_SettleTime(settleTime)
+    , m_Platform(std::make_unique<Platform>())
+{
+}
+
+FileWatcher::~FileWatcher() = default;
+
+bool FileWatcher::Watch(const std::filesystem::path& directory)
+{
+    std::error_code error;
+    auto path = NormalizeDirectory(directory);
+    return std::filesystem::is_directory(path, error) && AddWatch(path);
+}
+
+uint32_t FileWatcher::Poll(std::vector<std::filesystem::path>& changed)
+{
+    ReadEvents();
+
+    uint32_t count = 0;
+    auto now = std::chrono::steady_clock::now();
+    for (auto it = m_Pending.begin(); it != m_Pending.end();)
+    {
+        if (now - it->second < m_SettleTime)
+        {
+            ++it;
+            continue;
+        }
+
+        // Temporary files of editors are usually gone by now (renamed over
+        // the original or deleted), and Windows also reports directories
+        // whose contents changed; only files that still exist are reported.
+        std::error_code error;
+        std::filesystem::path path(it->first);
+        if (std::filesystem::is_regular_file(path, error))
+        {
+            changed.push_back(std::move(path));
+            ++count;
+        }
+        it = m_Pending.erase(it);
+    }
+    return count;
+}
+
+void FileWatcher::Touch(const std::filesystem::path& path)
+{
+    m_Pending[path.lexically_normal().generic_string()] = std::chrono::steady_clock::now();
+}
+
+#if defined(_WIN32)
+
+struct FileWatcher::Platform
+{
+    struct Directory
+    {
+        std::filesystem::path path;
+        HANDLE handle = INVALID_HANDLE_VALUE;
+        OVERLAPPED overlapped = {};
+        DWORD buffer[16384];        // 64 KB, the limit for network shares; DWORD aligned
+
+        ~Directory()
+        {
+            if (handle != INVALID_HANDLE_VALUE)
+            {
+                DWORD bytes;
+                CancelIoEx(handle, &overlapped);
+                GetOverlappedResult(handle, &overlapped, &bytes, TRUE);
+                CloseHandle(handle);
+            }
+        }
+
+        bool Issue()
+        {
+            overlapped = {};
+            return ReadDirectoryChangesW(handle, buffer, sizeof(buffer), TRUE,
+                FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE, nullptr, &overlapped, nullptr) != FALSE;
+        }
+    };
+
+    // Watches are recursive, so new subdirectories need nothing extra.
+    std::vector<std::unique_ptr<Directory>> directories;
+};
+
+bool FileWatcher::AddWatch(const std::filesystem::path& directory)
+{
+    auto watch = std::make_unique<Platform::Directory>();
+    watch->path = directory;
+    watch->handle = CreateFileW(directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    if (watch->handle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    if (!watch->Issue())
+    {
+        return false;
+    }
+
+    m_Platform->directories.push_back(std::move(watch));
+    return true;
+}
+
+void FileWatcher::ReadEvents()
+{
+    auto& directories = m_Platform->directories;
+    for (auto it = directories.begin(); it != directories.end();)
+    {
+        Platform::Directory& directory = **it;
+
+        DWORD bytes = 0;
+        if (!GetOverlappedResult(directory.handle, &directory.overlapped, &bytes, FALSE))
+        {
+            if (GetLastError() == ERROR_IO_INCOMPLETE)
+            {
+                ++it;
+            }
+            else
+            {
+                // The directory was deleted or its volume went away.
+                it = directories.erase(it);
+            }
+            continue;
+        }
+
+        // Zero bytes means the buffer overflowed and the changes are lost.
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(directory.buffer);
+        for (DWORD offset = 0; bytes != 0;)
+        {
+            auto info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(data + offset);
+            if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED ||
+                info->Action == FILE_ACTION_RENAMED_NEW_NAME)
+            {
+                Touch(directory.path / std::wstring(info->FileName, info->FileNameLength / sizeof(WCHAR)));
+            }
+            if (info->NextEntryOffset == 0)
+            {
+                break;
+            }
+            offset += info->NextEntryOffset;
+        }
+
+        if (directory.Issue())
+        {
+            ++it;
+        }
+        else
+        {
+            it = directories.erase(it);
+        }
+    }
+}
+
+#else
+
+struct FileWatcher::Platform
+{
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    std::unordered_map<int, std::filesystem::path> directories;     // by watch descriptor
+
+    ~Platform()
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+    }
+};
+
+bool FileWatcher::AddWatch(const std::filesystem::path& directory)
+{
+    // inotify is not recursive; every directory in the tree gets a watch.
+    int wd = m_Platform->fd >= 0 ?
+        inotify_add_watch(m_Platform->fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR) : -1;
+    if (wd < 0)
+    {
+        return false;
+    }
+    m_Platform->directories[wd] = directory;
+
+    std::error_code error;
+    for (std::filesystem::directory_iterator it(directory, error), end; !error && it != end; it.increment(error))
+    {
+        if (it->is_directory(error) && !it->is_symlink(error))
+        {
+            AddWatch(it->path());
+        }
+    }
+    return true;
+}
+
+void FileWatcher::ReadEvents()
+{
+    if (m_Platform->fd < 0)
+    {
+        return;
+    }
+
+    alignas(inotify_event) char buffer[16384];
+    for (;;)
+    {
+        ssize_t size = read(m_Platform->fd, buffer, sizeof(buffer));
+        if (size <= 0)
+        {
+            // EAGAIN once the queue is drained.
+            break;
+        }
+
+        for (const char* event = buffer; event < buffer + size;)
+        {
+            auto info = reinterpret_cast<const inotify_event*>(event);
+            event += sizeof(inotify_event) + info->len;
+
+            if (info->mask & IN_IGNORED)
+            {
+                m_Platform->directories.erase(info->wd);
+                continue;
+            }
+            auto found = m_Platform->directories.find(info->wd);
+            if (found == m_Platform->directories.end() || info->len == 0)
+            {
+                continue;
+            }
+
+            std::filesystem::path path = found->second / info->name;
+            if (!(info->mask & IN_ISDIR))
+            {
+                if (info->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+                {
+                    Touch(path);
+                }
+                continue;
+            }
+
+            // Files may have landed in a new directory before its watch
+            // existed (mkdir -p && cp, or a moved-in tree).
+            if (info->mask & (IN_CREATE | IN_MOVED_TO))
+            {
+                AddWatch(path);
+                std::error_code error;
+                for (std::filesystem::recursive_directory_iterator it(path, error), end; !error && it != end; it.increment(error))
+                {
+                    if (it->is_regular_file(error))
+                    {
+                        Touch(it->path());
+                    }
+                }
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,45 @@
+#pragma once
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Reports files written under watched directory trees: inotify on Linux,
+// overlapped ReadDirectoryChangesW on Windows. Nothing blocks and no thread
+// is involved; Poll() drains whatever the kernel has queued since the last
+// call.
+//
+// Editors save in several steps (truncate and write, or write a temporary
+// and rename it over the original), so a file is only reported once it has
+// been quiet for the settle time, and then only once per burst of writes.
+class FileWatcher
+{
+public:
+    explicit FileWatcher(std::chrono::milliseconds settleTime = std::chrono::milliseconds(100));
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Watches directory and everything below it, including subdirectories
+    // created later.
+    bool Watch(const std::filesystem::path& directory);
+
+    // Appends absolute, normalized paths of files that changed, have settled
+    // and still exist; returns how many were added.
+    uint32_t Poll(std::vector<std::filesystem::path>& changed);
+
+private:
+    struct Platform;
+
+    // Implemented per platform; ReadEvents calls Touch for every write.
+    bool AddWatch(const std::filesystem::path& directory);
+    void ReadEvents();
+    void Touch(const std::filesystem::path& path);
+
+    std::chrono::milliseconds m_SettleTime;
+    std::unique_ptr<Platform> m_Platform;
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> m_Pending;    // by generic path
+};
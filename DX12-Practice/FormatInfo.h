@@ -0,0 +1,235 @@
+#pragma once
+#include "directx/dxgiformat.h"
+
+#include <cstdint>
+
+// Compile-time properties of every DXGI format, so footprint math, plane
+// counts and view formats need neither a device nor a switch statement.
+// Block-compressed and packed formats describe one block; planar video
+// formats describe their first plane.
+enum FormatFlags : uint8_t
+{
+    c_FormatDepth = 0x1,
+    c_FormatStencil = 0x2,
+    c_FormatSrgb = 0x4,
+    c_FormatTypeless = 0x8,
+    c_FormatCompressed = 0x10,  // BC1-BC7
+    c_FormatVideo = 0x20,       // YUV and palettized
+};
+
+struct FormatInfo
+{
+    DXGI_FORMAT format;
+    uint8_t bitsPerPixel;
+    uint8_t blockWidth;
+    uint8_t blockHeight;
+    uint8_t bytesPerBlock;
+    uint8_t planeCount;         // as D3D12GetFormatPlaneCount; 0 if unknown
+    uint8_t flags;
+    DXGI_FORMAT typeless;       // family this format can be cast within
+    DXGI_FORMAT srgbPair;       // UNORM <-> UNORM_SRGB counterpart, or UNKNOWN
+};
+
+namespace FormatTableDetail
+{
+    constexpr FormatInfo c_ReservedFormat = { DXGI_FORMAT_UNKNOWN, 0, 0, 0, 0, 0, 0, DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_UNKNOWN };
+
+    // Indexed by DXGI_FORMAT value; the sampler feedback formats past the end
+    // are opaque and report as unknown.
+    constexpr FormatInfo c_Formats[] =
+    {
+        { DXGI_FORMAT_UNKNOWN, 0, 0, 0, 0, 0, 0, DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R32G32B32A32_TYPELESS, 128, 1, 1, 16, 1, c_FormatTypeless, DXGI_FORMAT_R32G32B32A32_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R32G32B32A32_FLOAT, 128, 1, 1, 16, 1, 0, DXGI_FORMAT_R32G32B32A32_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R32G32B32A32_UINT, 128, 1, 1, 16, 1, 0, DXGI_FORMAT_R32G32B32A32_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R32G32B32A32_SINT, 128, 1, 1, 16, 1, 0, DXGI_FORMAT_R32G32B32A32_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R32G32B32_TYPELESS, 96, 1, 1, 12, 1, c_FormatTypeless, DXGI_FORMAT_R32G32B32_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R32G32B32_FLOAT, 96, 1, 1, 12, 1, 0, DXGI_FORMAT_R32G32B32_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R32G32B32_UINT, 96, 1, 1, 12, 1, 0, DXGI_FORMAT_R32G32B32_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R32G32B32_SINT, 96, 1, 1, 12, 1, 0, DXGI_FORMAT_R32G32B32_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R16G16B16A16_TYPELESS, 64, 1, 1, 8, 1, c_FormatTypeless, DXGI_FORMAT_R16G16B16A16_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R16G16B16A16_FLOAT, 64, 1, 1, 8, 1, 0, DXGI_FORMAT_R16G16B16A16_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R16G16B16A16_UNORM, 64, 1, 1, 8, 1, 0, DXGI_FORMAT_R16G16B16A16_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R16G16B16A16_UINT, 64, 1, 1, 8, 1, 0, DXGI_FORMAT_R16G16B16A16_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R16G16B16A16_SNORM, 64, 1, 1, 8, 1, 0, DXGI_FORMAT_R16G16B16A16_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R16G16B16A16_SINT, 64, 1, 1, 8, 1, 0, DXGI_FORMAT_R16G16B16A16_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R32G32_TYPELESS, 64, 1, 1, 8, 1, c_FormatTypeless, DXGI_FORMAT_R32G32_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R32G32_FLOAT, 64, 1, 1, 8, 1, 0, DXGI_FORMAT_R32G32_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R32G32_UINT, 64, 1, 1, 8, 1, 0, DXGI_FORMAT_R32G32_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R32G32_SINT, 64, 1, 1, 8, 1, 0, DXGI_FORMAT_R32G32_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R32G8X24_TYPELESS, 64, 1, 1, 8, 2, c_FormatTypeless, DXGI_FORMAT_R32G8X24_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_D32_FLOAT_S8X24_UINT, 64, 1, 1, 8, 2, c_FormatDepth | c_FormatStencil, DXGI_FORMAT_R32G8X24_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS, 64, 1, 1, 8, 2, 0, DXGI_FORMAT_R32G8X24_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_X32_TYPELESS_G8X24_UINT, 64, 1, 1, 8, 2, 0, DXGI_FORMAT_R32G8X24_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R10G10B10A2_TYPELESS, 32, 1, 1, 4, 1, c_FormatTypeless, DXGI_FORMAT_R10G10B10A2_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R10G10B10A2_UNORM, 32, 1, 1, 4, 1, 0, DXGI_FORMAT_R10G10B10A2_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R10G10B10A2_UINT, 32, 1, 1, 4, 1, 0, DXGI_FORMAT_R10G10B10A2_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R11G11B10_FLOAT, 32, 1, 1, 4, 1, 0, DXGI_FORMAT_R11G11B10_FLOAT, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R8G8B8A8_TYPELESS, 32, 1, 1, 4, 1, c_FormatTypeless, DXGI_FORMAT_R8G8B8A8_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R8G8B8A8_UNORM, 32, 1, 1, 4, 1, 0, DXGI_FORMAT_R8G8B8A8_TYPELESS, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB },
+        { DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, 32, 1, 1, 4, 1, c_FormatSrgb, DXGI_FORMAT_R8G8B8A8_TYPELESS, DXGI_FORMAT_R8G8B8A8_UNORM },
+        { DXGI_FORMAT_R8G8B8A8_UINT, 32, 1, 1, 4, 1, 0, DXGI_FORMAT_R8G8B8A8_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R8G8B8A8_SNORM, 32, 1, 1, 4, 1, 0, DXGI_FORMAT_R8G8B8A8_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R8G8B8A8_SINT, 32, 1, 1, 4, 1, 0, DXGI_FORMAT_R8G8B8A8_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R16G16_TYPELESS, 32, 1, 1, 4, 1, c_FormatTypeless, DXGI_FORMAT_R16G16_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R16G16_FLOAT, 32, 1, 1, 4, 1, 0, DXGI_FORMAT_R16G16_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R16G16_UNORM, 32, 1, 1, 4, 1, 0, DXGI_FORMAT_R16G16_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R16G16_UINT, 32, 1, 1, 4, 1, 0, DXGI_FORMAT_R16G16_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R16G16_SNORM, 32, 1, 1, 4, 1, 0, DXGI_FORMAT_R16G16_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R16G16_SINT, 32, 1, 1, 4, 1, 0, DXGI_FORMAT_R16G16_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R32_TYPELESS, 32, 1, 1, 4, 1, c_FormatTypeless, DXGI_FORMAT_R32_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_D32_FLOAT, 32, 1, 1, 4, 1, c_FormatDepth, DXGI_FORMAT_R32_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R32_FLOAT, 32, 1, 1, 4, 1, 0, DXGI_FORMAT_R32_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R32_UINT, 32, 1, 1, 4, 1, 0, DXGI_FORMAT_R32_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R32_SINT, 32, 1, 1, 4, 1, 0, DXGI_FORMAT_R32_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R24G8_TYPELESS, 32, 1, 1, 4, 2, c_FormatTypeless, DXGI_FORMAT_R24G8_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_D24_UNORM_S8_UINT, 32, 1, 1, 4, 2, c_FormatDepth | c_FormatStencil, DXGI_FORMAT_R24G8_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R24_UNORM_X8_TYPELESS, 32, 1, 1, 4, 2, 0, DXGI_FORMAT_R24G8_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_X24_TYPELESS_G8_UINT, 32, 1, 1, 4, 2, 0, DXGI_FORMAT_R24G8_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R8G8_TYPELESS, 16, 1, 1, 2, 1, c_FormatTypeless, DXGI_FORMAT_R8G8_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R8G8_UNORM, 16, 1, 1, 2, 1, 0, DXGI_FORMAT_R8G8_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R8G8_UINT, 16, 1, 1, 2, 1, 0, DXGI_FORMAT_R8G8_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R8G8_SNORM, 16, 1, 1, 2, 1, 0, DXGI_FORMAT_R8G8_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R8G8_SINT, 16, 1, 1, 2, 1, 0, DXGI_FORMAT_R8G8_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R16_TYPELESS, 16, 1, 1, 2, 1, c_FormatTypeless, DXGI_FORMAT_R16_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R16_FLOAT, 16, 1, 1, 2, 1, 0, DXGI_FORMAT_R16_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_D16_UNORM, 16, 1, 1, 2, 1, c_FormatDepth, DXGI_FORMAT_R16_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R16_UNORM, 16, 1, 1, 2, 1, 0, DXGI_FORMAT_R16_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R16_UINT, 16, 1, 1, 2, 1, 0, DXGI_FORMAT_R16_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R16_SNORM, 16, 1, 1, 2, 1, 0, DXGI_FORMAT_R16_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R16_SINT, 16, 1, 1, 2, 1, 0, DXGI_FORMAT_R16_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R8_TYPELESS, 8, 1, 1, 1, 1, c_FormatTypeless, DXGI_FORMAT_R8_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R8_UNORM, 8, 1, 1, 1, 1, 0, DXGI_FORMAT_R8_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R8_UINT, 8, 1, 1, 1, 1, 0, DXGI_FORMAT_R8_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R8_SNORM, 8, 1, 1, 1, 1, 0, DXGI_FORMAT_R8_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R8_SINT, 8, 1, 1, 1, 1, 0, DXGI_FORMAT_R8_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_A8_UNORM, 8, 1, 1, 1, 1, 0, DXGI_FORMAT_A8_UNORM, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R1_UNORM, 1, 8, 1, 1, 1, 0, DXGI_FORMAT_R1_UNORM, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R9G9B9E5_SHAREDEXP, 32, 1, 1, 4, 1, 0, DXGI_FORMAT_R9G9B9E5_SHAREDEXP, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_R8G8_B8G8_UNORM, 32, 2, 1, 4, 1, 0, DXGI_FORMAT_R8G8_B8G8_UNORM, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_G8R8_G8B8_UNORM, 32, 2, 1, 4, 1, 0, DXGI_FORMAT_G8R8_G8B8_UNORM, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_BC1_TYPELESS, 4, 4, 4, 8, 1, c_FormatTypeless | c_FormatCompressed, DXGI_FORMAT_BC1_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_BC1_UNORM, 4, 4, 4, 8, 1, c_FormatCompressed, DXGI_FORMAT_BC1_TYPELESS, DXGI_FORMAT_BC1_UNORM_SRGB },
+        { DXGI_FORMAT_BC1_UNORM_SRGB, 4, 4, 4, 8, 1, c_FormatSrgb | c_FormatCompressed, DXGI_FORMAT_BC1_TYPELESS, DXGI_FORMAT_BC1_UNORM },
+        { DXGI_FORMAT_BC2_TYPELESS, 8, 4, 4, 16, 1, c_FormatTypeless | c_FormatCompressed, DXGI_FORMAT_BC2_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_BC2_UNORM, 8, 4, 4, 16, 1, c_FormatCompressed, DXGI_FORMAT_BC2_TYPELESS, DXGI_FORMAT_BC2_UNORM_SRGB },
+        { DXGI_FORMAT_BC2_UNORM_SRGB, 8, 4, 4, 16, 1, c_FormatSrgb | c_FormatCompressed, DXGI_FORMAT_BC2_TYPELESS, DXGI_FORMAT_BC2_UNORM },
+        { DXGI_FORMAT_BC3_TYPELESS, 8, 4, 4, 16, 1, c_FormatTypeless | c_FormatCompressed, DXGI_FORMAT_BC3_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_BC3_UNORM, 8, 4, 4, 16, 1, c_FormatCompressed, DXGI_FORMAT_BC3_TYPELESS, DXGI_FORMAT_BC3_UNORM_SRGB },
+        { DXGI_FORMAT_BC3_UNORM_SRGB, 8, 4, 4, 16, 1, c_FormatSrgb | c_FormatCompressed, DXGI_FORMAT_BC3_TYPELESS, DXGI_FORMAT_BC3_UNORM },
+        { DXGI_FORMAT_BC4_TYPELESS, 4, 4, 4, 8, 1, c_FormatTypeless | c_FormatCompressed, DXGI_FORMAT_BC4_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_BC4_UNORM, 4, 4, 4, 8, 1, c_FormatCompressed, DXGI_FORMAT_BC4_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_BC4_SNORM, 4, 4, 4, 8, 1, c_FormatCompressed, DXGI_FORMAT_BC4_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_BC5_TYPELESS, 8, 4, 4, 16, 1, c_FormatTypeless | c_FormatCompressed, DXGI_FORMAT_BC5_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_BC5_UNORM, 8, 4, 4, 16, 1, c_FormatCompressed, DXGI_FORMAT_BC5_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_BC5_SNORM, 8, 4, 4, 16, 1, c_FormatCompressed, DXGI_FORMAT_BC5_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_B5G6R5_UNORM, 16, 1, 1, 2, 1, 0, DXGI_FORMAT_B5G6R5_UNORM, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_B5G5R5A1_UNORM, 16, 1, 1, 2, 1, 0, DXGI_FORMAT_B5G5R5A1_UNORM, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_B8G8R8A8_UNORM, 32, 1, 1, 4, 1, 0, DXGI_FORMAT_B8G8R8A8_TYPELESS, DXGI_FORMAT_B8G8R8A8_UNORM_SRGB },
+        { DXGI_FORMAT_B8G8R8X8_UNORM, 32, 1, 1, 4, 1, 0, DXGI_FORMAT_B8G8R8X8_TYPELESS, DXGI_FORMAT_B8G8R8X8_UNORM_SRGB },
+        { DXGI_FORMAT_R10G10B10_XR_BIAS_A2_UNORM, 32, 1, 1, 4, 1, 0, DXGI_FORMAT_R10G10B10_XR_BIAS_A2_UNORM, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_B8G8R8A8_TYPELESS, 32, 1, 1, 4, 1, c_FormatTypeless, DXGI_FORMAT_B8G8R8A8_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_B8G8R8A8_UNORM_SRGB, 32, 1, 1, 4, 1, c_FormatSrgb, DXGI_FORMAT_B8G8R8A8_TYPELESS, DXGI_FORMAT_B8G8R8A8_UNORM },
+        { DXGI_FORMAT_B8G8R8X8_TYPELESS, 32, 1, 1, 4, 1, c_FormatTypeless, DXGI_FORMAT_B8G8R8X8_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_B8G8R8X8_UNORM_SRGB, 32, 1, 1, 4, 1, c_FormatSrgb, DXGI_FORMAT_B8G8R8X8_TYPELESS, DXGI_FORMAT_B8G8R8X8_UNORM },
+        { DXGI_FORMAT_BC6H_TYPELESS, 8, 4, 4, 16, 1, c_FormatTypeless | c_FormatCompressed, DXGI_FORMAT_BC6H_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_BC6H_UF16, 8, 4, 4, 16, 1, c_FormatCompressed, DXGI_FORMAT_BC6H_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_BC6H_SF16, 8, 4, 4, 16, 1, c_FormatCompressed, DXGI_FORMAT_BC6H_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_BC7_TYPELESS, 8, 4, 4, 16, 1, c_FormatTypeless | c_FormatCompressed, DXGI_FORMAT_BC7_TYPELESS, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_BC7_UNORM, 8, 4, 4, 16, 1, c_FormatCompressed, DXGI_FORMAT_BC7_TYPELESS, DXGI_FORMAT_BC7_UNORM_SRGB },
+        { DXGI_FORMAT_BC7_UNORM_SRGB, 8, 4, 4, 16, 1, c_FormatSrgb | c_FormatCompressed, DXGI_FORMAT_BC7_TYPELESS, DXGI_FORMAT_BC7_UNORM },
+        { DXGI_FORMAT_AYUV, 32, 1, 1, 4, 1, c_FormatVideo, DXGI_FORMAT_AYUV, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_Y410, 32, 1, 1, 4, 1, c_FormatVideo, DXGI_FORMAT_Y410, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_Y416, 64, 1, 1, 8, 1, c_FormatVideo, DXGI_FORMAT_Y416, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_NV12, 12, 1, 1, 1, 2, c_FormatVideo, DXGI_FORMAT_NV12, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_P010, 24, 1, 1, 2, 2, c_FormatVideo, DXGI_FORMAT_P010, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_P016, 24, 1, 1, 2, 2, c_FormatVideo, DXGI_FORMAT_P016, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_420_OPAQUE, 12, 1, 1, 1, 2, c_FormatVideo, DXGI_FORMAT_420_OPAQUE, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_YUY2, 32, 2, 1, 4, 1, c_FormatVideo, DXGI_FORMAT_YUY2, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_Y210, 64, 2, 1, 8, 1, c_FormatVideo, DXGI_FORMAT_Y210, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_Y216, 64, 2, 1, 8, 1, c_FormatVideo, DXGI_FORMAT_Y216, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_NV11, 12, 1, 1, 1, 2, c_FormatVideo, DXGI_FORMAT_NV11, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_AI44, 8, 1, 1, 1, 1, c_FormatVideo, DXGI_FORMAT_AI44, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_IA44, 8, 1, 1, 1, 1, c_FormatVideo, DXGI_FORMAT_IA44, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_P8, 8, 1, 1, 1, 1, c_FormatVideo, DXGI_FORMAT_P8, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_A8P8, 16, 1, 1, 2, 1, c_FormatVideo, DXGI_FORMAT_A8P8, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_B4G4R4A4_UNORM, 16, 1, 1, 2, 1, 0, DXGI_FORMAT_B4G4R4A4_UNORM, DXGI_FORMAT_UNKNOWN },
+        c_ReservedFormat, // 116
+        c_ReservedFormat, // 117
+        c_ReservedFormat, // 118
+        c_ReservedFormat, // 119
+        c_ReservedFormat, // 120
+        c_ReservedFormat, // 121
+        c_ReservedFormat, // 122
+        c_ReservedFormat, // 123
+        c_ReservedFormat, // 124
+        c_ReservedFormat, // 125
+        c_ReservedFormat, // 126
+        c_ReservedFormat, // 127
+        c_ReservedFormat, // 128
+        c_ReservedFormat, // 129
+        { DXGI_FORMAT_P208, 16, 1, 1, 1, 2, c_FormatVideo, DXGI_FORMAT_P208, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_V208, 16, 1, 1, 1, 3, c_FormatVideo, DXGI_FORMAT_V208, DXGI_FORMAT_UNKNOWN },
+        { DXGI_FORMAT_V408, 24, 1, 1, 1, 3, c_FormatVideo, DXGI_FORMAT_V408, DXGI_FORMAT_UNKNOWN },
+    };
+
+    constexpr bool IsTableOrdered()
+    {
+        for (uint32_t i = 0; i < sizeof(c_Formats) / sizeof(c_Formats[0]); ++i)
+        {
+            if (c_Formats[i].format != DXGI_FORMAT(i) && c_Formats[i].format != DXGI_FORMAT_UNKNOWN)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static_assert(IsTableOrdered(), "format table must be indexed by DXGI_FORMAT");
+}
+
+constexpr const FormatInfo& GetFormatInfo(DXGI_FORMAT format)
+{
+    return uint32_t(format) < sizeof(FormatTableDetail::c_Formats) / sizeof(FormatTableDetail::c_Formats[0]) ?
+        FormatTableDetail::c_Formats[format] : FormatTableDetail::c_ReservedFormat;
+}
+
+constexpr uint32_t GetFormatBitsPerPixel(DXGI_FORMAT format) { return GetFormatInfo(format).bitsPerPixel; }
+constexpr uint32_t GetFormatPlaneCount(DXGI_FORMAT format) { return GetFormatInfo(format).planeCount; }
+constexpr bool IsCompressedFormat(DXGI_FORMAT format) { return (GetFormatInfo(format).flags & c_FormatCompressed) != 0; }
+constexpr bool IsSrgbFormat(DXGI_FORMAT format) { return (GetFormatInfo(format).flags & c_FormatSrgb) != 0; }
+constexpr bool IsTypelessFormat(DXGI_FORMAT format) { return (GetFormatInfo(format).flags & c_FormatTypeless) != 0; }
+constexpr bool IsDepthFormat(DXGI_FORMAT format) { return (GetFormatInfo(format).flags & c_FormatDepth) != 0; }
+constexpr bool IsStencilFormat(DXGI_FORMAT format) { return (GetFormatInfo(format).flags & c_FormatStencil) != 0; }
+
+constexpr DXGI_FORMAT GetTypelessFormat(DXGI_FORMAT format) { return GetFormatInfo(format).typeless; }
+
+// The sRGB / linear variant of format, or format itself if there is none.
+constexpr DXGI_FORMAT GetSrgbFormat(DXGI_FORMAT format)
+{
+    return IsSrgbFormat(format) || GetFormatInfo(format).srgbPair == DXGI_FORMAT_UNKNOWN ? format : GetFormatInfo(format).srgbPair;
+}
+
+constexpr DXGI_FORMAT GetLinearFormat(DXGI_FORMAT format)
+{
+    return IsSrgbFormat(format) ? GetFormatInfo(format).srgbPair : format;
+}
+
+// Formats to create a depth buffer as (typeless, so it can also be sampled)
+// and to view its depth plane through in a shader.
+constexpr DXGI_FORMAT GetDepthResourceFormat(DXGI_FORMAT format)
+{
+    return IsDepthFormat(format) ? GetTypelessFormat(format) : format;
+}
+
+constexpr DXGI_FORMAT GetDepthShaderResourceFormat(DXGI_FORMAT format)
+{
+    return GetTypelessFormat(format) == DXGI_FORMAT_R32_TYPELESS ? DXGI_FORMAT_R32_FLOAT :
+        GetTypelessFormat(format) == DXGI_FORMAT_R16_TYPELESS ? DXGI_FORMAT_R16_UNORM :
+        GetTypelessFormat(format) == DXGI_FORMAT_R24G8_TYPELESS ? DXGI_FORMAT_R24_UNORM_X8_TYPELESS :
+        GetTypelessFormat(format) == DXGI_FORMAT_R32G8X24_TYPELESS ? DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS : format;
+}
+
+static_assert(GetFormatPlaneCount(DXGI_FORMAT_D24_UNORM_S8_UINT) == 2, "depth-stencil has two planes");
+static_assert(GetSrgbFormat(DXGI_FORMAT_BC7_UNORM) == DXGI_FORMAT_BC7_UNORM_SRGB, "sRGB pairs");
+static_assert(GetDepthShaderResourceFormat(DXGI_FORMAT_D32_FLOAT) == DXGI_FORMAT_R32_FLOAT, "depth views");
@@ -0,0 +1,413 @@
+#include "FrustumCulling.h"
+#include "CpuFeatures.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+
+// SSE2 is part of every x64 target; AVX2 is picked at run time (see
+// CpuFeatures.h).
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CULLING_SSE2 1
+#endif
+#if defined(PRACTICE_X86)
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+    const uint32_t c_WordsPerJob = 64;     // 4096 objects
+
+    uint32_t PopCount64(uint64_t value)
+    {
+#if defined(_MSC_VER) && defined(_M_X64)
+        return static_cast<uint32_t>(__popcnt64(value));
+#elif defined(_MSC_VER)
+        return __popcnt(static_cast<uint32_t>(value)) + __popcnt(static_cast<uint32_t>(value >> 32));
+#else
+        return static_cast<uint32_t>(__builtin_popcountll(value));
+#endif
+    }
+
+    uint32_t CountTrailingZeros64(uint64_t value)
+    {
+        assert(value != 0);
+#if defined(_MSC_VER) && defined(_M_X64)
+        unsigned long index;
+        _BitScanForward64(&index, value);
+        return index;
+#elif defined(_MSC_VER)
+        unsigned long index;
+        if (_BitScanForward(&index, static_cast<uint32_t>(value)))
+        {
+            return index;
+        }
+        _BitScanForward(&index, static_cast<uint32_t>(value >> 32));
+        return index + 32;
+#else
+        return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+    }
+
+    void AppendIndices(const uint64_t* bits, uint32_t wordBegin, uint32_t wordEnd, uint32_t* out)
+    {
+        for (uint32_t word = wordBegin; word < wordEnd; ++word)
+        {
+            uint64_t mask = bits[word];
+            while (mask)
+            {
+                *out++ = word * 64 + CountTrailingZeros64(mask);
+                mask &= mask - 1;
+            }
+        }
+    }
+
+    // Stream pointers of a CullingScene, in the layout the kernels read.
+    struct CullStreams
+    {
+        const float* sphere[3];
+        const float* radius;
+        const float* center[3];
+        const float* extent[3];
+    };
+
+    // The kernels test objects [begin, end) in groups of 8 or 4 and return
+    // where they stopped; the caller finishes any remainder one by one.
+#if defined(PRACTICE_X86)
+    PRACTICE_AVX2_TARGET uint32_t CullAvx2(const CullStreams& streams, const Frustum& frustum, uint32_t begin, uint32_t end, uint64_t* bits)
+    {
+        __m256 planes[6][4];
+        for (int p = 0; p < 6; ++p)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                planes[p][c] = _mm256_set1_ps(frustum.planes[p][c]);
+            }
+        }
+        const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+
+        uint32_t i = begin;
+        for (; i < end; i += 8)
+        {
+            __m256 sx = _mm256_loadu_ps(streams.sphere[0] + i);
+            __m256 sy = _mm256_loadu_ps(streams.sphere[1] + i);
+            __m256 sz = _mm256_loadu_ps(streams.sphere[2] + i);
+            __m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(streams.radius + i));
+            __m256 cx = _mm256_loadu_ps(streams.center[0] + i);
+            __m256 cy = _mm256_loadu_ps(streams.center[1] + i);
+            __m256 cz = _mm256_loadu_ps(streams.center[2] + i);
+            __m256 ex = _mm256_loadu_ps(streams.extent[0] + i);
+            __m256 ey = _mm256_loadu_ps(streams.extent[1] + i);
+            __m256 ez = _mm256_loadu_ps(streams.extent[2] + i);
+
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (int p = 0; p < 6; ++p)
+            {
+                __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planes[p][0], sx), _mm256_mul_ps(planes[p][1], sy)),
+                    _mm256_add_ps(_mm256_mul_ps(planes[p][2], sz), planes[p][3]));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, negRadius, _CMP_GE_OQ));
+
+                __m256 b = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planes[p][0], cx), _mm256_mul_ps(planes[p][1], cy)),
+                    _mm256_add_ps(_mm256_mul_ps(planes[p][2], cz), planes[p][3]));
+                __m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_and_ps(planes[p][0], absMask), ex),
+                    _mm256_mul_ps(_mm256_and_ps(planes[p][1], absMask), ey)), _mm256_mul_ps(_mm256_and_ps(planes[p][2], absMask), ez));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(b, r), _mm256_setzero_ps(), _CMP_GE_OQ));
+            }
+
+            uint32_t local = i - begin;
+            bits[local / 64] |= static_cast<uint64_t>(_mm256_movemask_ps(inside)) << (local % 64);
+        }
+        return i;
+    }
+#endif
+
+#if defined(CULLING_SSE2)
+    uint32_t CullSse2(const CullStreams& streams, const Frustum& frustum, uint32_t begin, uint32_t end, uint64_t* bits)
+    {
+        __m128 planes[6][4];
+        for (int p = 0; p < 6; ++p)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                planes[p][c] = _mm_set1_ps(frustum.planes[p][c]);
+            }
+        }
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+        uint32_t i = begin;
+        for (; i < end; i += 4)
+        {
+            __m128 sx = _mm_loadu_ps(streams.sphere[0] + i);
+            __m128 sy = _mm_loadu_ps(streams.sphere[1] + i);
+            __m128 sz = _mm_loadu_ps(streams.sphere[2] + i);
+            __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(streams.radius + i));
+            __m128 cx = _mm_loadu_ps(streams.center[0] + i);
+            __m128 cy = _mm_loadu_ps(streams.center[1] + i);
+            __m128 cz = _mm_loadu_ps(streams.center[2] + i);
+            __m128 ex = _mm_loadu_ps(streams.extent[0] + i);
+            __m128 ey = _mm_loadu_ps(streams.extent[1] + i);
+            __m128 ez = _mm_loadu_ps(streams.extent[2] + i);
+
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int p = 0; p < 6; ++p)
+            {
+                __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planes[p][0], sx), _mm_mul_ps(planes[p][1], sy)),
+                    _mm_add_ps(_mm_mul_ps(planes[p][2], sz), planes[p][3]));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(d, negRadius));
+
+                __m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planes[p][0], cx), _mm_mul_ps(planes[p][1], cy)),
+                    _mm_add_ps(_mm_mul_ps(planes[p][2], cz), planes[p][3]));
+                __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(planes[p][0], absMask), ex),
+                    _mm_mul_ps(_mm_and_ps(planes[p][1], absMask), ey)), _mm_mul_ps(_mm_and_ps(planes[p][2], absMask), ez));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(b, r), _mm_setzero_ps()));
+            }
+
+            uint32_t local = i - begin;
+            bits[local / 64] |= static_cast<uint64_t>(_mm_movemask_ps(inside)) << (local % 64);
+        }
+        return i;
+    }
+#endif
+
+    CullingSimd GetBestCullingSimd()
+    {
+        static const CullingSimd s_Best = IsAvx2Supported() ? CullingSimd::Avx2 :
+#if defined(CULLING_SSE2)
+            CullingSimd::Sse2;
+#else
+            CullingSimd::None;
+#endif
+        return s_Best;
+    }
+
+    std::atomic<CullingSimd> g_CullingSimd{ CullingSimd::Best };
+}
+
+CullingSimd GetCullingSimd()
+{
+    CullingSimd simd = g_CullingSimd.load(std::memory_order_relaxed);
+    return simd == CullingSimd::Best ? GetBestCullingSimd() : simd;
+}
+
+void SetCullingSimd(CullingSimd simd)
+{
+    CullingSimd best = GetBestCullingSimd();
+    g_CullingSimd.store(simd == CullingSimd::Best || simd > best ? best : simd, std::memory_order_relaxed);
+}
+
+Frustum Frustum::FromViewProjection(const float m[4][4])
+{
+    // Gribb/Hartmann: with row vectors clip = v * M, so each plane is a sum
+    // of matrix columns.
+    auto column = [&](int c, int row) { return m[row][c]; };
+
+    Frustum frustum;
+    for (int row = 0; row < 4; ++row)
+    {
+        float x = column(0, row), y = column(1, row), z = column(2, row), w = column(3, row);
+        frustum.planes[0][row] = w + x;     // left
+        frustum.planes[1][row] = w - x;     // right
+        frustum.planes[2][row] = w + y;     // bottom
+        frustum.planes[3][row] = w - y;     // top
+        frustum.planes[4][row] = z;         // near
+        frustum.planes[5][row] = w - z;     // far
+    }
+
+    for (auto& plane : frustum.planes)
+    {
+        float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        for (float& value : plane)
+        {
+            value /= length;
+        }
+    }
+    return frustum;
+}
+
+uint32_t CullingScene::Add(const float sphereCenter[3], float radius, const float boxMin[3], const float boxMax[3])
+{
+    uint32_t index = m_Count++;
+    size_t padded = (m_Count + 7) & ~size_t(7);
+    for (auto& stream : m_Streams)
+    {
+        stream.resize(padded, 0.0f);
+    }
+    Set(index, sphereCenter, radius, boxMin, boxMax);
+    return index;
+}
+
+void CullingScene::Set(uint32_t index, const float sphereCenter[3], float radius, const float boxMin[3], const float boxMax[3])
+{
+    assert(index < m_Count);
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        m_Streams[SphereX + axis][index] = sphereCenter[axis];
+        m_Streams[BoxCenterX + axis][index] = (boxMin[axis] + boxMax[axis]) * 0.5f;
+        m_Streams[BoxExtentX + axis][index] = (boxMax[axis] - boxMin[axis]) * 0.5f;
+    }
+    m_Streams[Radius][index] = radius;
+}
+
+void CullingScene::GetBox(uint32_t index, float boxMin[3], float boxMax[3]) const
+{
+    assert(index < m_Count);
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        boxMin[axis] = m_Streams[BoxCenterX + axis][index] - m_Streams[BoxExtentX + axis][index];
+        boxMax[axis] = m_Streams[BoxCenterX + axis][index] + m_Streams[BoxExtentX + axis][index];
+    }
+}
+
+void CullingScene::Clear()
+{
+    for (auto& stream : m_Streams)
+    {
+        stream.clear();
+    }
+    m_Count = 0;
+}
+
+bool CullingScene::IsVisible(const Frustum& frustum, uint32_t index) const
+{
+    for (const auto& plane : frustum.planes)
+    {
+        // Sphere: dot(n, c) + w >= -r.
+        float d = plane[0] * m_Streams[SphereX][index] + plane[1] * m_Streams[SphereY][index] + plane[2] * m_Streams[SphereZ][index] + plane[3];
+        if (d < -m_Streams[Radius][index])
+        {
+            return false;
+        }
+
+        // Box: dot(n, c) + w >= -dot(|n|, e).
+        float b = plane[0] * m_Streams[BoxCenterX][index] + plane[1] * m_Streams[BoxCenterY][index] + plane[2] * m_Streams[BoxCenterZ][index] + plane[3];
+        float r = std::fabs(plane[0]) * m_Streams[BoxExtentX][index] + std::fabs(plane[1]) * m_Streams[BoxExtentY][index]
+            + std::fabs(plane[2]) * m_Streams[BoxExtentZ][index];
+        if (b + r < 0.0f)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void CullingScene::CullRange(const Frustum& frustum, uint32_t begin, uint32_t end, uint64_t* bits) const
+{
+    assert(begin % 64 == 0);
+
+    CullStreams streams;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        streams.sphere[axis] = m_Streams[SphereX + axis].data();
+        streams.center[axis] = m_Streams[BoxCenterX + axis].data();
+        streams.extent[axis] = m_Streams[BoxExtentX + axis].data();
+    }
+    streams.radius = m_Streams[Radius].data();
+
+    uint32_t i = begin;
+    switch (GetCullingSimd())
+    {
+#if defined(PRACTICE_X86)
+    case CullingSimd::Avx2:
+        i = CullAvx2(streams, frustum, begin, end, bits);
+        break;
+#endif
+#if defined(CULLING_SSE2)
+    case CullingSimd::Sse2:
+        i = CullSse2(streams, frustum, begin, end, bits);
+        break;
+#endif
+    default:
+        break;
+    }
+
+    for (; i < end; ++i)
+    {
+        if (IsVisible(frustum, i))
+        {
+            uint32_t local = i - begin;
+            bits[local / 64] |= uint64_t(1) << (local % 64);
+        }
+    }
+}
+
+void CullingScene::Cull(const Frustum& frustum, JobSystem* jobSystem, std::vector<uint32_t>& visible,
+    std::vector<uint64_t>* visibleBits) const
+{
+    uint32_t wordCount = (m_Count + 63) / 64;
+    std::vector<uint64_t> localBits;
+    std::vector<uint64_t>& bits = visibleBits ? *visibleBits : localBits;
+    bits.assign(wordCount, 0);
+
+    // Pass 1: each job tests whole 64-bit words, so no two jobs share a word,
+    // and counts its visible objects.
+    uint32_t jobCount = (wordCount + c_WordsPerJob - 1) / c_WordsPerJob;
+    std::vector<uint32_t> offsets(jobCount + 1, 0);
+    auto cullWords = [&](uint32_t wordBegin, uint32_t wordEnd)
+    {
+        // Padding past m_Count is tested too, then masked off below.
+        uint32_t end = std::min<uint32_t>(wordEnd * 64, static_cast<uint32_t>(m_Streams[Radius].size()));
+        CullRange(frustum, wordBegin * 64, end, &bits[wordBegin]);
+        if (wordEnd == wordCount && m_Count % 64)
+        {
+            bits[wordCount - 1] &= (uint64_t(1) << (m_Count % 64)) - 1;
+        }
+
+        uint32_t count = 0;
+        for (uint32_t word = wordBegin; word < wordEnd; ++word)
+        {
+            count += PopCount64(bits[word]);
+        }
+        offsets[wordBegin / c_WordsPerJob + 1] = count;
+    };
+
+    // Pass 2: prefix sum, then each job writes its indices to its own slice.
+    auto writeIndices = [&](uint32_t wordBegin, uint32_t wordEnd)
+    {
+        AppendIndices(bits.data(), wordBegin, wordEnd, visible.data() + offsets[wordBegin / c_WordsPerJob]);
+    };
+
+    if (jobSystem)
+    {
+        jobSystem->ParallelFor(wordCount, c_WordsPerJob, cullWords);
+    }
+    else
+    {
+        for (uint32_t word = 0; word < wordCount; word += c_WordsPerJob)
+        {
+            cullWords(word, std::min(wordCount, word + c_WordsPerJob));
+        }
+    }
+
+    for (uint32_t job = 0; job < jobCount; ++job)
+    {
+        offsets[job + 1] += offsets[job];
+    }
+    visible.resize(offsets[jobCount]);
+
+    if (jobSystem)
+    {
+        jobSystem->ParallelFor(wordCount, c_WordsPerJob, writeIndices);
+    }
+    else
+    {
+        writeIndices(0, wordCount);
+    }
+}
+
+void CullingScene::CullScalar(const Frustum& frustum, std::vector<uint32_t>& visible) const
+{
+    visible.clear();
+    for (uint32_t i = 0; i < m_Count; ++i)
+    {
+        if (IsVisible(frustum, i))
+        {
+            visible.push_back(i);
+        }
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+// Six planes (xyz normal pointing inwards, w distance); a point p is inside
+// when dot(n, p) + w >= 0 for every plane.
+struct Frustum
+{
+    float planes[6][4];
+
+    // Extracts normalized planes from a row-major view-projection matrix in
+    // DirectXMath convention (row vectors, clip z in [0, w]).
+    static Frustum FromViewProjection(const float viewProjection[4][4]);
+};
+
+// Instruction set of CullingScene::Cull. Best, the default, is the widest
+// one the CPU supports (checked once at run time).
+enum class CullingSimd : uint32_t
+{
+    None,
+    Sse2,
+    Avx2,
+    Best,
+};
+
+// The instruction set in use, never Best.
+CullingSimd GetCullingSimd();
+// For comparisons and tests; sets wider than the CPU supports fall back to
+// the best supported one. Applies to every scene.
+void SetCullingSimd(CullingSimd simd);
+
+// Bounds of every cullable object stored as structure-of-arrays so the
+// frustum test runs over 4 (SSE2) or 8 (AVX2) objects per instruction. Each
+// object has a bounding sphere for the cheap rejection and an AABB for the
+// final test; an object is visible when both intersect the frustum.
+class CullingScene
+{
+public:
+    uint32_t Add(const float sphereCenter[3], float radius, const float boxMin[3], const float boxMax[3]);
+    void Set(uint32_t index, const float sphereCenter[3], float radius, const float boxMin[3], const float boxMax[3]);
+    void Clear();
+
+    uint32_t GetCount() const { return m_Count; }
+    void GetBox(uint32_t index, float boxMin[3], float boxMax[3]) const;
+
+    // Writes the indices of visible objects in ascending order and, if
+    // visibleBits is given, a bitset with one bit per object. Work is split
+    // across the job system when one is passed.
+    void Cull(const Frustum& frustum, JobSystem* jobSystem, std::vector<uint32_t>& visible,
+        std::vector<uint64_t>* visibleBits = nullptr) const;
+
+    // Plain per-object loop with the same results; kept as a reference.
+    void CullScalar(const Frustum& frustum, std::vector<uint32_t>& visible) const;
+
+private:
+    enum Stream
+    {
+        SphereX, SphereY, SphereZ, Radius,
+        BoxCenterX, BoxCenterY, BoxCenterZ,
+        BoxExtentX, BoxExtentY, BoxExtentZ,
+        NumStreams
+    };
+
+    bool IsVisible(const Frustum& frustum, uint32_t index) const;
+
+    // Tests objects [begin, end), begin a multiple of 64, into bits[0..].
+    void CullRange(const Frustum& frustum, uint32_t begin, uint32_t end, uint64_t* bits) const;
+
+    // Sized to a multiple of 8 so SIMD loads never run past the end.
+    std::vector<float> m_Streams[NumStreams];
+    uint32_t m_Count = 0;
+};
@@ -0,0 +1,64 @@
+#include "GpuFrameTimer.h"
+
+using Microsoft::WRL::ComPtr;
+
+GpuFrameTimer::GpuFrameTimer(ComPtr<ID3D12Device2> device, ID3D12CommandQueue* queue, uint32_t slotCount)
+    : m_Frames(slotCount, 0)
+    , m_Pending(slotCount, false)
+{
+    D3D12_QUERY_HEAP_DESC heapDesc = {};
+    heapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+    heapDesc.Count = slotCount * 2;
+    device->CreateQueryHeap(&heapDesc, IID_PPV_ARGS(&m_QueryHeap));
+
+    CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_READBACK);
+    CD3DX12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(heapDesc.Count * sizeof(uint64_t));
+    device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &desc,
+        D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&m_Readback));
+
+    UINT64 frequency = 0;
+    if (SUCCEEDED(queue->GetTimestampFrequency(&frequency)) && frequency != 0)
+    {
+        m_TicksPerMillisecond = frequency / 1000.0;
+    }
+}
+
+void GpuFrameTimer::Begin(ID3D12GraphicsCommandList* commandList, uint32_t slot, uint32_t frame)
+{
+    m_Frames[slot] = frame;
+    commandList->EndQuery(m_QueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, slot * 2);
+}
+
+void GpuFrameTimer::End(ID3D12GraphicsCommandList* commandList, uint32_t slot)
+{
+    commandList->EndQuery(m_QueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, slot * 2 + 1);
+    commandList->ResolveQueryData(m_QueryHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, slot * 2, 2,
+        m_Readback.Get(), slot * 2 * sizeof(uint64_t));
+    m_Pending[slot] = true;
+}
+
+bool GpuFrameTimer::Read(uint32_t slot, uint32_t* frame, double* milliseconds)
+{
+    if (!m_Pending[slot] || m_TicksPerMillisecond == 0.0)
+    {
+        return false;
+    }
+    m_Pending[slot] = false;
+
+    // Only this slot's pair is read; the GPU may be writing the others.
+    SIZE_T begin = slot * 2 * sizeof(uint64_t);
+    CD3DX12_RANGE readRange(begin, begin + 2 * sizeof(uint64_t));
+    uint8_t* data = nullptr;
+    if (FAILED(m_Readback->Map(0, &readRange, reinterpret_cast<void**>(&data))))
+    {
+        return false;
+    }
+    const uint64_t* timestamps = reinterpret_cast<const uint64_t*>(data + begin);
+    uint64_t ticks = timestamps[1] - timestamps[0];
+    CD3DX12_RANGE writtenRange(0, 0);
+    m_Readback->Unmap(0, &writtenRange);
+
+    *frame = m_Frames[slot];
+    *milliseconds = ticks / m_TicksPerMillisecond;
+    return true;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "Win.h"
+#include <wrl/client.h>
+
+#include "directx/d3dx12.h"
+
+#include <cstdint>
+#include <vector>
+
+// Measures how long the GPU spends on each frame with a pair of timestamps
+// around its command list. Results are read back per frame slot once the
+// fence of that slot has completed, i.e. a few frames late, so every frame
+// carries a tag (its number) to match results to frames.
+class GpuFrameTimer
+{
+public:
+    GpuFrameTimer(Microsoft::WRL::ComPtr<ID3D12Device2> device, ID3D12CommandQueue* queue, uint32_t slotCount);
+
+    void Begin(ID3D12GraphicsCommandList* commandList, uint32_t slot, uint32_t frame);
+    // Writes the end timestamp and resolves the pair for readback.
+    void End(ID3D12GraphicsCommandList* commandList, uint32_t slot);
+
+    // The result recorded in slot, if any not yet read; the caller has waited
+    // for the slot's fence.
+    bool Read(uint32_t slot, uint32_t* frame, double* milliseconds);
+
+private:
+    Microsoft::WRL::ComPtr<ID3D12QueryHeap> m_QueryHeap;
+    Microsoft::WRL::ComPtr<ID3D12Resource> m_Readback;
+    double m_TicksPerMillisecond = 0.0;
+    std::vector<uint32_t> m_Frames;
+    std::vector<bool> m_Pending;
+};
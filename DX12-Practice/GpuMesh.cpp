@@ -0,0 +1,42 @@
+#include "GpuMesh.h"
+#include "MeshFile.h"
+#include "UploadBatcher.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    ComPtr<ID3D12Resource> UploadSection(UploadBatcher& batcher, const MeshFile& file, MeshSection section)
+    {
+        UINT64 size = file.GetSectionSize(section);
+        return size ? batcher.CreateBuffer(file.GetSection(section), size) : nullptr;
+    }
+}
+
+bool UploadMeshFile(UploadBatcher& batcher, const MeshFile& file, GpuMesh& mesh)
+{
+    const MeshFileHeader& header = file.GetHeader();
+
+    mesh.vertexBuffer = UploadSection(batcher, file, MeshSectionVertices);
+    mesh.indexBuffer = UploadSection(batcher, file, MeshSectionIndices);
+    mesh.meshletBuffer = UploadSection(batcher, file, MeshSectionMeshlets);
+    mesh.meshletVertexBuffer = UploadSection(batcher, file, MeshSectionMeshletVertices);
+    mesh.meshletPrimitiveBuffer = UploadSection(batcher, file, MeshSectionMeshletPrimitives);
+    if (!mesh.vertexBuffer || !mesh.indexBuffer)
+    {
+        return false;
+    }
+
+    mesh.vertexBufferView.BufferLocation = mesh.vertexBuffer->GetGPUVirtualAddress();
+    mesh.vertexBufferView.SizeInBytes = static_cast<UINT>(file.GetSectionSize(MeshSectionVertices));
+    mesh.vertexBufferView.StrideInBytes = header.vertexStride;
+
+    mesh.indexBufferView.BufferLocation = mesh.indexBuffer->GetGPUVirtualAddress();
+    mesh.indexBufferView.SizeInBytes = static_cast<UINT>(file.GetSectionSize(MeshSectionIndices));
+    mesh.indexBufferView.Format = header.indexSize == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+
+    mesh.indexCount = header.indexCount;
+    mesh.meshletCount = header.meshletCount;
+    mesh.uploadFenceValue = batcher.Submit();
+    return true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "Win.h"
+#include <wrl/client.h>
+
+#include "directx/d3dx12.h"
+
+#include <cstdint>
+
+class MeshFile;
+class UploadBatcher;
+
+// GPU buffers for a cooked mesh. Usable once uploadFenceValue has been
+// reached on the batcher's fence.
+struct GpuMesh
+{
+    Microsoft::WRL::ComPtr<ID3D12Resource> vertexBuffer;
+    Microsoft::WRL::ComPtr<ID3D12Resource> indexBuffer;
+    Microsoft::WRL::ComPtr<ID3D12Resource> meshletBuffer;
+    Microsoft::WRL::ComPtr<ID3D12Resource> meshletVertexBuffer;
+    Microsoft::WRL::ComPtr<ID3D12Resource> meshletPrimitiveBuffer;
+    D3D12_VERTEX_BUFFER_VIEW vertexBufferView = {};
+    D3D12_INDEX_BUFFER_VIEW indexBufferView = {};
+    uint32_t indexCount = 0;
+    uint32_t meshletCount = 0;
+    uint64_t uploadFenceValue = 0;
+};
+
+// Records copies of every section straight from the mapped file and submits
+// them. The file must stay open until the call returns.
+bool UploadMeshFile(UploadBatcher& batcher, const MeshFile& file, GpuMesh& mesh);
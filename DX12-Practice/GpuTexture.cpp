@@ -0,0 +1,96 @@
+#include "GpuTexture.h"
+#include "FormatInfo.h"
+#include "UploadBatcher.h"
+
+#include <vector>
+
+D3D12_RESOURCE_DESC GetResourceDesc(const TextureDesc& desc, D3D12_RESOURCE_FLAGS flags)
+{
+    switch (desc.dimension)
+    {
+    case TextureDimension::Texture1D:
+        return CD3DX12_RESOURCE_DESC::Tex1D(desc.format, desc.width, static_cast<UINT16>(desc.arraySize),
+            static_cast<UINT16>(desc.mipCount), flags);
+    case TextureDimension::Texture3D:
+        return CD3DX12_RESOURCE_DESC::Tex3D(desc.format, desc.width, desc.height, static_cast<UINT16>(desc.depth),
+            static_cast<UINT16>(desc.mipCount), flags);
+    default:
+        return CD3DX12_RESOURCE_DESC::Tex2D(desc.format, desc.width, desc.height, static_cast<UINT16>(desc.arraySize),
+            static_cast<UINT16>(desc.mipCount), 1, 0, flags);
+    }
+}
+
+D3D12_SHADER_RESOURCE_VIEW_DESC GetShaderResourceViewDesc(const TextureDesc& desc)
+{
+    D3D12_SHADER_RESOURCE_VIEW_DESC view = {};
+    // Depth formats are read through their depth plane.
+    view.Format = GetDepthShaderResourceFormat(desc.format);
+    view.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+
+    switch (desc.dimension)
+    {
+    case TextureDimension::Texture1D:
+        if (desc.arraySize > 1)
+        {
+            view.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE1DARRAY;
+            view.Texture1DArray.MipLevels = desc.mipCount;
+            view.Texture1DArray.ArraySize = desc.arraySize;
+        }
+        else
+        {
+            view.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE1D;
+            view.Texture1D.MipLevels = desc.mipCount;
+        }
+        break;
+    case TextureDimension::Texture3D:
+        view.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE3D;
+        view.Texture3D.MipLevels = desc.mipCount;
+        break;
+    default:
+        if (desc.cube && desc.arraySize > 6)
+        {
+            view.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBEARRAY;
+            view.TextureCubeArray.MipLevels = desc.mipCount;
+            view.TextureCubeArray.NumCubes = desc.arraySize / 6;
+        }
+        else if (desc.cube)
+        {
+            view.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
+            view.TextureCube.MipLevels = desc.mipCount;
+        }
+        else if (desc.arraySize > 1)
+        {
+            view.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+            view.Texture2DArray.MipLevels = desc.mipCount;
+            view.Texture2DArray.ArraySize = desc.arraySize;
+        }
+        else
+        {
+            view.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+            view.Texture2D.MipLevels = desc.mipCount;
+        }
+        break;
+    }
+    return view;
+}
+
+bool UploadTextureFile(UploadBatcher& batcher, const TextureFile& file, GpuTexture& texture)
+{
+    std::vector<D3D12_SUBRESOURCE_DATA> subresources(file.GetSubresourceCount());
+    for (uint32_t i = 0; i < file.GetSubresourceCount(); ++i)
+    {
+        const TextureSubresourceData& data = file.GetSubresource(i);
+        subresources[i].pData = data.data;
+        subresources[i].RowPitch = static_cast<LONG_PTR>(data.rowPitch);
+        subresources[i].SlicePitch = static_cast<LONG_PTR>(data.slicePitch);
+    }
+
+    texture.desc = file.GetDesc();
+    texture.resource = batcher.CreateTexture(GetResourceDesc(texture.desc), subresources.data());
+    if (!texture.resource)
+    {
+        return false;
+    }
+    texture.uploadFenceValue = batcher.Submit();
+    return true;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "Win.h"
+#include <wrl/client.h>
+
+#include "directx/d3dx12.h"
+
+#include "TextureFile.h"
+
+#include <cstdint>
+
+class UploadBatcher;
+
+// GPU texture for a DDS/KTX2 file. Usable once uploadFenceValue has been
+// reached on the batcher's fence.
+struct GpuTexture
+{
+    Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+    TextureDesc desc;
+    uint64_t uploadFenceValue = 0;
+};
+
+D3D12_RESOURCE_DESC GetResourceDesc(const TextureDesc& desc, D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE);
+// Views the whole texture (cube maps as TextureCube or TextureCubeArray).
+D3D12_SHADER_RESOURCE_VIEW_DESC GetShaderResourceViewDesc(const TextureDesc& desc);
+
+// Records copies of every subresource straight from the mapped file and
+// submits them. The file must stay open until the call returns.
+bool UploadTextureFile(UploadBatcher& batcher, const TextureFile& file, GpuTexture& texture);
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 64-bit FNV-1a. Used for cache keys (PSOs, root signatures, shader blobs), so
+// the result must be stable across runs and platforms.
+const uint64_t g_HashSeed = 0xcbf29ce484222325ull;
+
+inline uint64_t HashBytes(const void* data, size_t size, uint64_t hash = g_HashSeed)
+{
+    auto bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+template<typename T>
+inline uint64_t HashValue(const T& value, uint64_t hash = g_HashSeed)
+{
+    return HashBytes(&value, sizeof(T), hash);
+}
+
+inline uint64_t HashString(const char* str, uint64_t hash = g_HashSeed)
+{
+    // Include the terminator so "ab"+"c" and "a"+"bc" hash differently.
+    return str ? HashBytes(str, std::char_traits<char>::length(str) + 1, hash) : HashValue<uint8_t>(0, hash);
+}
+
+inline std::string HashToString(uint64_t hash)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string text(16, '0');
+    for (int i = 15; i >= 0; --i, hash >>= 4)
+    {
+        text[i] = digits[hash & 0xf];
+    }
+    return text;
+}
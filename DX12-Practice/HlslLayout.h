@@ -0,0 +1,165 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_WIN32)
+#include "Win.h"
+#include "directx/d3dx12.h"
+#endif
+
+// Compile-time HLSL constant buffer packing.
+//
+// Describe the HLSL declaration once as an array of HlslField, compute its
+// packed layout with ComputeHlslLayout, and static_assert that the C++ struct
+// uploaded into it has the same offsets:
+//
+//     struct PerDraw { XMFLOAT4X4 world; XMFLOAT3 tint; float alpha; };
+//     constexpr HlslField c_PerDrawFields[] = { HlslFloat4x4, HlslFloat3, HlslFloat };
+//     static_assert(VerifyHlslLayout<PerDraw>(c_PerDrawFields,
+//         { HLSL_MEMBER(PerDraw, world), HLSL_MEMBER(PerDraw, tint), HLSL_MEMBER(PerDraw, alpha) }));
+//
+// Packing rules (cbuffer, column_major matrices):
+//  - scalars and vectors pack into 16-byte registers and never straddle one;
+//  - matrices and array elements start a new register, every element but the
+//    last occupies whole registers;
+//  - the buffer size is rounded up to 16 bytes.
+struct HlslField
+{
+    uint32_t components;    // used components of the last register of one element
+    uint32_t registers;     // registers per element (matrix columns)
+    uint32_t arraySize;     // 0 when not an array
+};
+
+constexpr HlslField HlslFloat = { 1, 1, 0 };
+constexpr HlslField HlslFloat2 = { 2, 1, 0 };
+constexpr HlslField HlslFloat3 = { 3, 1, 0 };
+constexpr HlslField HlslFloat4 = { 4, 1, 0 };
+constexpr HlslField HlslFloat3x3 = { 3, 3, 0 };
+constexpr HlslField HlslFloat4x3 = { 4, 3, 0 };    // 4 rows, 3 columns
+constexpr HlslField HlslFloat3x4 = { 3, 4, 0 };
+constexpr HlslField HlslFloat4x4 = { 4, 4, 0 };
+// int/uint/bool variants pack exactly like their float counterparts.
+constexpr HlslField HlslInt = HlslFloat;
+constexpr HlslField HlslInt2 = HlslFloat2;
+constexpr HlslField HlslInt3 = HlslFloat3;
+constexpr HlslField HlslInt4 = HlslFloat4;
+constexpr HlslField HlslUint = HlslFloat;
+constexpr HlslField HlslUint2 = HlslFloat2;
+constexpr HlslField HlslUint3 = HlslFloat3;
+constexpr HlslField HlslUint4 = HlslFloat4;
+
+constexpr HlslField HlslArray(HlslField element, uint32_t count)
+{
+    return { element.components, element.registers, count };
+}
+
+// Bytes the field covers from its first byte to its last used byte.
+constexpr uint32_t HlslFieldSize(HlslField field)
+{
+    uint32_t elementSize = (field.registers - 1) * 16 + field.components * 4;
+    uint32_t elements = field.arraySize ? field.arraySize : 1;
+    return (elements - 1) * field.registers * 16 + elementSize;
+}
+
+constexpr bool HlslStartsRegister(HlslField field)
+{
+    return field.registers > 1 || field.arraySize > 0;
+}
+
+template<size_t N>
+struct HlslLayout
+{
+    uint32_t offsets[N];
+    uint32_t size;          // end of the last field
+    uint32_t paddedSize;    // size rounded to a whole register
+};
+
+template<size_t N>
+constexpr HlslLayout<N> ComputeHlslLayout(const HlslField (&fields)[N])
+{
+    HlslLayout<N> layout = {};
+    uint32_t offset = 0;
+    for (size_t i = 0; i < N; ++i)
+    {
+        uint32_t size = HlslFieldSize(fields[i]);
+        uint32_t registerEnd = (offset + 15) / 16 * 16;
+        bool straddles = offset / 16 != (offset + size - 1) / 16;
+        if (HlslStartsRegister(fields[i]) || straddles)
+        {
+            offset = registerEnd;
+        }
+        layout.offsets[i] = offset;
+        offset += size;
+    }
+    layout.size = offset;
+    layout.paddedSize = (offset + 15) / 16 * 16;
+    return layout;
+}
+
+struct HlslCppMember
+{
+    size_t offset;
+    size_t size;
+};
+
+#define HLSL_MEMBER(Type, member) HlslCppMember{ offsetof(Type, member), sizeof(Type::member) }
+
+template<typename T, size_t N>
+constexpr bool VerifyHlslLayout(const HlslField (&fields)[N], const HlslCppMember (&members)[N])
+{
+    auto layout = ComputeHlslLayout(fields);
+    for (size_t i = 0; i < N; ++i)
+    {
+        if (members[i].offset != layout.offsets[i])
+        {
+            return false;
+        }
+
+        // C++ arrays have no short last element, so they may cover whole registers.
+        uint32_t size = HlslFieldSize(fields[i]);
+        uint32_t elements = fields[i].arraySize ? fields[i].arraySize : 1;
+        uint32_t arraySize = elements * fields[i].registers * 16;
+        if (members[i].size != size && !(fields[i].arraySize && members[i].size == arraySize))
+        {
+            return false;
+        }
+    }
+    return sizeof(T) >= layout.size && sizeof(T) <= layout.paddedSize;
+}
+
+// Root constants are not rounded to a whole register; only the DWORDs the
+// declaration actually uses are set.
+template<size_t N>
+constexpr uint32_t HlslRootConstantCount(const HlslField (&fields)[N])
+{
+    return (ComputeHlslLayout(fields).size + 3) / 4;
+}
+
+// Packed block of root constants laid out like the HLSL declaration.
+template<typename T, uint32_t Num32BitValues = sizeof(T) / 4>
+struct RootConstantBlock
+{
+    static_assert(sizeof(T) % 4 == 0, "Root constants are set in 32-bit values");
+    static_assert(Num32BitValues * 4 <= sizeof(T), "Root constant count exceeds the struct");
+    static_assert(Num32BitValues <= 64, "A root signature holds at most 64 DWORDs");
+
+    static constexpr uint32_t c_Num32BitValues = Num32BitValues;
+
+#if defined(_WIN32)
+    static void InitRootParameter(CD3DX12_ROOT_PARAMETER1& parameter, UINT shaderRegister, UINT registerSpace = 0,
+        D3D12_SHADER_VISIBILITY visibility = D3D12_SHADER_VISIBILITY_ALL)
+    {
+        parameter.InitAsConstants(Num32BitValues, shaderRegister, registerSpace, visibility);
+    }
+
+    static void SetGraphics(ID3D12GraphicsCommandList* commandList, UINT rootParameterIndex, const T& data)
+    {
+        commandList->SetGraphicsRoot32BitConstants(rootParameterIndex, Num32BitValues, &data, 0);
+    }
+
+    static void SetCompute(ID3D12GraphicsCommandList* commandList, UINT rootParameterIndex, const T& data)
+    {
+        commandList->SetComputeRoot32BitConstants(rootParameterIndex, Num32BitValues, &data, 0);
+    }
+#endif
+};
@@ -0,0 +1,145 @@
+#include "HotReload.h"
+
+#include <algorithm>
+
+namespace
+{
+    std::string NormalizePath(const std::filesystem::path& path)
+    {
+        std::error_code error;
+        return std::filesystem::absolute(path, error).lexically_normal().generic_string();
+    }
+}
+
+HotReloader::HotReloader(JobSystem& jobs)
+    : m_Jobs(jobs)
+{
+}
+
+HotReloader::~HotReloader()
+{
+    m_Jobs.Wait(m_Builds);
+}
+
+bool HotReloader::Watch(const std::filesystem::path& directory)
+{
+    return m_Watcher.Watch(directory);
+}
+
+void HotReloader::AddObject(std::unique_ptr<ReloadableObject> object)
+{
+    StartBuild(*object);
+    m_Objects.push_back(std::move(object));
+}
+
+void HotReloader::StartBuild(ReloadableObject& object)
+{
+    object.m_Building = true;
+    m_Jobs.Submit([&object]
+    {
+        ReloadContext context;
+        auto result = object.m_Builder(context);
+
+        std::lock_guard<std::mutex> lock(object.m_Mutex);
+        object.m_Result = std::move(result);
+        object.m_Context = std::move(context);
+        object.m_Finished = true;
+    }, &m_Builds);
+}
+
+void HotReloader::FinishBuild(ReloadableObject& object, uint64_t frameFenceValue)
+{
+    std::shared_ptr<void> result;
+    ReloadContext context;
+    {
+        std::lock_guard<std::mutex> lock(object.m_Mutex);
+        if (!object.m_Finished)
+        {
+            return;
+        }
+        object.m_Finished = false;
+        result = std::move(object.m_Result);
+        context = std::move(object.m_Context);
+    }
+
+    object.m_Building = false;
+    object.m_Errors = std::move(context.errors);
+    // A build that failed before finding its files keeps watching the old ones.
+    if (!context.dependencies.empty())
+    {
+        object.m_Dependencies.clear();
+        for (const auto& dependency : context.dependencies)
+        {
+            object.m_Dependencies.push_back(NormalizePath(dependency));
+        }
+    }
+
+    bool succeeded = result != nullptr;
+    if (succeeded)
+    {
+        // Frames up to the previous one may still reference the old version.
+        if (object.m_Current)
+        {
+            m_Retired.push_back({ frameFenceValue - 1, std::move(object.m_Current) });
+        }
+        object.m_Current = std::move(result);
+        ++object.m_Version;
+    }
+
+    if (m_Callback)
+    {
+        m_Callback(object, succeeded);
+    }
+
+    if (object.m_Dirty)
+    {
+        object.m_Dirty = false;
+        StartBuild(object);
+    }
+}
+
+void HotReloader::BeginFrame(uint64_t frameFenceValue, uint64_t completedFenceValue)
+{
+    while (!m_Retired.empty() && m_Retired.front().fenceValue <= completedFenceValue)
+    {
+        m_Retired.pop_front();
+    }
+
+    m_Changed.clear();
+    m_Watcher.Poll(m_Changed);
+    for (const auto& path : m_Changed)
+    {
+        std::string name = path.generic_string();
+        for (auto& object : m_Objects)
+        {
+            const auto& dependencies = object->m_Dependencies;
+            if (std::find(dependencies.begin(), dependencies.end(), name) == dependencies.end())
+            {
+                continue;
+            }
+
+            if (object->m_Building)
+            {
+                object->m_Dirty = true;
+            }
+            else
+            {
+                StartBuild(*object);
+            }
+        }
+    }
+
+    for (auto& object : m_Objects)
+    {
+        if (object->m_Building)
+        {
+            FinishBuild(*object, frameFenceValue);
+        }
+    }
+}
+
+uint32_t HotReloader::GetBuildingCount() const
+{
+    return static_cast<uint32_t>(std::count_if(m_Objects.begin(), m_Objects.end(),
+        [](const std::unique_ptr<ReloadableObject>& object) { return object->m_Building; }));
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include "FileWatcher.h"
+#include "JobSystem.h"
+
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Filled in by a builder while it runs.
+struct ReloadContext
+{
+    std::vector<std::filesystem::path> dependencies;    // files whose changes trigger a rebuild
+    std::string errors;
+};
+
+// Builds a new version of an object from its source files, or returns null
+// on failure. Runs on the job system.
+template<typename T>
+using ReloadBuilder = std::function<std::shared_ptr<T>(ReloadContext& context)>;
+
+// An object owned by a HotReloader. The installed version only changes inside
+// HotReloader::BeginFrame, so whatever Get() returns while a frame is being
+// recorded stays alive until the GPU has finished that frame.
+class ReloadableObject
+{
+public:
+    const std::string& GetName() const { return m_Name; }
+    // 0 until the first build succeeds, then incremented per new version.
+    uint32_t GetVersion() const { return m_Version; }
+    // Errors of the last build; a failed build keeps the previous version.
+    const std::string& GetErrors() const { return m_Errors; }
+
+protected:
+    void* GetObject() const { return m_Current.get(); }
+
+private:
+    friend class HotReloader;
+
+    std::string m_Name;
+    std::function<std::shared_ptr<void>(ReloadContext&)> m_Builder;
+    std::shared_ptr<void> m_Current;
+    uint32_t m_Version = 0;
+    std::string m_Errors;
+    std::vector<std::string> m_Dependencies;    // absolute generic paths
+    bool m_Building = false;
+    bool m_Dirty = false;                       // changed again during the build
+
+    // Handed over from the build job.
+    std::mutex m_Mutex;
+    bool m_Finished = false;
+    std::shared_ptr<void> m_Result;
+    ReloadContext m_Context;
+};
+
+template<typename T>
+class Reloadable : public ReloadableObject
+{
+public:
+    T* Get() const { return static_cast<T*>(GetObject()); }
+};
+
+// Rebuilds objects in the background when the files they were built from
+// change, and swaps them in at frame boundaries:
+//     watch       FileWatcher events, polled in BeginFrame
+//     rebuild     the object's builder on the job system; the frame goes on
+//                 with the current version meanwhile
+//     install     the next BeginFrame after the build finishes
+//     release     the replaced version once the last frame that could use
+//                 it has completed on the GPU
+// A file that changes during a build queues one more build of the objects
+// that depend on it. Everything except the builders runs on the thread that
+// calls BeginFrame.
+class HotReloader
+{
+public:
+    // Called after each finished build, with whether it produced a version.
+    using Callback = std::function<void(const ReloadableObject& object, bool succeeded)>;
+
+    explicit HotReloader(JobSystem& jobs);
+    // Waits for builds in flight. Replaced versions are dropped without
+    // waiting for their fence, so flush the queue first.
+    ~HotReloader();
+
+    HotReloader(const HotReloader&) = delete;
+    HotReloader& operator=(const HotReloader&) = delete;
+
+    bool Watch(const std::filesystem::path& directory);
+
+    void SetCallback(Callback callback) { m_Callback = std::move(callback); }
+
+    // Starts the first build right away; Get() returns null until the first
+    // BeginFrame after it succeeds.
+    template<typename T>
+    Reloadable<T>* Add(std::string name, ReloadBuilder<T> builder)
+    {
+        auto object = std::make_unique<Reloadable<T>>();
+        Reloadable<T>* result = object.get();
+        object->m_Name = std::move(name);
+        object->m_Builder = [builder = std::move(builder)](ReloadContext& context) -> std::shared_ptr<void>
+        {
+            return builder(context);
+        };
+        AddObject(std::move(object));
+        return result;
+    }
+
+    // frameFenceValue is what the queue will signal when the frame about to
+    // be recorded is done, completedFenceValue what the fence has reached.
+    void BeginFrame(uint64_t frameFenceValue, uint64_t completedFenceValue);
+
+    uint32_t GetBuildingCount() const;
+    // Replaced versions still waiting for their fence.
+    uint32_t GetRetiredCount() const { return static_cast<uint32_t>(m_Retired.size()); }
+
+private:
+    struct Retired
+    {
+        uint64_t fenceValue;
+        std::shared_ptr<void> object;
+    };
+
+    void AddObject(std::unique_ptr<ReloadableObject> object);
+    void StartBuild(ReloadableObject& object);
+    void FinishBuild(ReloadableObject& object, uint64_t frameFenceValue);
+
+    JobSystem& m_Jobs;
+    JobCounter m_Builds;
+    FileWatcher m_Watcher;
+    Callback m_Callback;
+    std::vector<std::unique_ptr<ReloadableObject>> m_Objects;
+    std::deque<Retired> m_Retired;              // in fence order
+    std::vector<std::filesystem::path> m_Changed;
+};
@@ -0,0 +1,173 @@
+#include "IndirectArguments.h"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace
+{
+    bool Fail(std::string* error, const std::string& message)
+    {
+        if (error)
+        {
+            *error = message;
+        }
+        return false;
+    }
+
+    bool IsDrawOrDispatch(IndirectArgumentType type)
+    {
+        return type == IndirectArgumentType::Draw ||
+            type == IndirectArgumentType::DrawIndexed ||
+            type == IndirectArgumentType::Dispatch ||
+            type == IndirectArgumentType::DispatchMesh;
+    }
+
+    bool IsRootArgument(IndirectArgumentType type)
+    {
+        return type == IndirectArgumentType::Constant ||
+            type == IndirectArgumentType::ConstantBufferView ||
+            type == IndirectArgumentType::ShaderResourceView ||
+            type == IndirectArgumentType::UnorderedAccessView;
+    }
+}
+
+uint32_t GetIndirectArgumentSize(const IndirectArgument& argument)
+{
+    switch (argument.type)
+    {
+    case IndirectArgumentType::Draw: return sizeof(IndirectDrawArgs);
+    case IndirectArgumentType::DrawIndexed: return sizeof(IndirectDrawIndexedArgs);
+    case IndirectArgumentType::Dispatch: return sizeof(IndirectDispatchArgs);
+    case IndirectArgumentType::DispatchMesh: return sizeof(IndirectDispatchArgs);
+    case IndirectArgumentType::VertexBufferView: return 16;   // address, size, stride
+    case IndirectArgumentType::IndexBufferView: return 16;    // address, size, format
+    case IndirectArgumentType::Constant: return 4 * argument.num32BitValues;
+    default: return 8;                                          // root descriptor address
+    }
+}
+
+std::vector<IndirectArgument> GetIndirectDrawArguments(IndirectDrawType type, uint32_t instanceRootIndex)
+{
+    IndirectArgument command = {};
+    switch (type)
+    {
+    case IndirectDrawType::Draw: command.type = IndirectArgumentType::Draw; break;
+    case IndirectDrawType::DrawIndexed: command.type = IndirectArgumentType::DrawIndexed; break;
+    case IndirectDrawType::Dispatch: command.type = IndirectArgumentType::Dispatch; break;
+    case IndirectDrawType::DispatchMesh: command.type = IndirectArgumentType::DispatchMesh; break;
+    }
+    return {
+        { IndirectArgumentType::Constant, instanceRootIndex, 0, 1 },
+        command,
+    };
+}
+
+bool ValidateIndirectDrawCommand(IndirectDrawType type, uint32_t instanceRootIndex, std::string* error)
+{
+    // The union members all start at the same offset.
+    return ValidateIndirectCommandStruct(GetIndirectDrawArguments(type, instanceRootIndex),
+        { static_cast<uint32_t>(offsetof(IndirectDrawCommand, instanceIndex)), static_cast<uint32_t>(offsetof(IndirectDrawCommand, draw)) },
+        sizeof(IndirectDrawCommand), error);
+}
+
+IndirectLayout ComputeIndirectLayout(const std::vector<IndirectArgument>& arguments)
+{
+    IndirectLayout layout;
+    for (const auto& argument : arguments)
+    {
+        layout.offsets.push_back(layout.packedSize);
+        layout.packedSize += GetIndirectArgumentSize(argument);
+    }
+    return layout;
+}
+
+bool ValidateIndirectArguments(const std::vector<IndirectArgument>& arguments, uint32_t byteStride, bool hasRootSignature, std::string* error)
+{
+    if (arguments.empty())
+    {
+        return Fail(error, "No indirect arguments");
+    }
+
+    const auto& last = arguments.back();
+    if (!IsDrawOrDispatch(last.type))
+    {
+        return Fail(error, "The last argument must be a draw or dispatch");
+    }
+
+    bool isDraw = last.type == IndirectArgumentType::Draw || last.type == IndirectArgumentType::DrawIndexed;
+    std::vector<uint32_t> rootParameters;
+    std::vector<uint32_t> vertexSlots;
+
+    for (size_t i = 0; i + 1 < arguments.size(); ++i)
+    {
+        const auto& argument = arguments[i];
+        if (IsDrawOrDispatch(argument.type))
+        {
+            return Fail(error, "Only one draw or dispatch argument is allowed");
+        }
+
+        if (IsRootArgument(argument.type))
+        {
+            if (!hasRootSignature)
+            {
+                return Fail(error, "Root arguments require a root signature");
+            }
+            if (std::find(rootParameters.begin(), rootParameters.end(), argument.slot) != rootParameters.end())
+            {
+                return Fail(error, "Root parameter " + std::to_string(argument.slot) + " is changed twice");
+            }
+            rootParameters.push_back(argument.slot);
+
+            if (argument.type == IndirectArgumentType::Constant && argument.num32BitValues == 0)
+            {
+                return Fail(error, "Constant argument sets no values");
+            }
+        }
+        else if (argument.type == IndirectArgumentType::VertexBufferView)
+        {
+            if (!isDraw || argument.slot >= 32)
+            {
+                return Fail(error, "Vertex buffer views need a draw and a slot below 32");
+            }
+            if (std::find(vertexSlots.begin(), vertexSlots.end(), argument.slot) != vertexSlots.end())
+            {
+                return Fail(error, "Vertex buffer slot " + std::to_string(argument.slot) + " is changed twice");
+            }
+            vertexSlots.push_back(argument.slot);
+        }
+        else if (argument.type == IndirectArgumentType::IndexBufferView && last.type != IndirectArgumentType::DrawIndexed)
+        {
+            return Fail(error, "Index buffer views need an indexed draw");
+        }
+    }
+
+    uint32_t packedSize = ComputeIndirectLayout(arguments).packedSize;
+    if (byteStride % 4 != 0)
+    {
+        return Fail(error, "ByteStride must be a multiple of 4");
+    }
+    if (byteStride < packedSize)
+    {
+        return Fail(error, "ByteStride " + std::to_string(byteStride) + " is smaller than the arguments (" + std::to_string(packedSize) + ")");
+    }
+    return true;
+}
+
+bool ValidateIndirectCommandStruct(const std::vector<IndirectArgument>& arguments, const std::vector<uint32_t>& memberOffsets,
+    uint32_t structSize, std::string* error)
+{
+    auto layout = ComputeIndirectLayout(arguments);
+    if (memberOffsets.size() != arguments.size())
+    {
+        return Fail(error, "One member offset per argument expected");
+    }
+    for (size_t i = 0; i < arguments.size(); ++i)
+    {
+        if (memberOffsets[i] != layout.offsets[i])
+        {
+            return Fail(error, "Argument " + std::to_string(i) + " is at offset " + std::to_string(memberOffsets[i]) +
+                ", the command signature expects " + std::to_string(layout.offsets[i]));
+        }
+    }
+    return ValidateIndirectArguments(arguments, structSize, true, error);
+}
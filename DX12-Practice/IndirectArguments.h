@@ -0,0 +1,107 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Platform-neutral mirror of D3D12_INDIRECT_ARGUMENT_DESC so command
+// signature layouts can be built and validated without a device (values
+// match D3D12_INDIRECT_ARGUMENT_TYPE).
+enum class IndirectArgumentType : uint32_t
+{
+    Draw = 0,
+    DrawIndexed = 1,
+    Dispatch = 2,
+    VertexBufferView = 3,
+    IndexBufferView = 4,
+    Constant = 5,
+    ConstantBufferView = 6,
+    ShaderResourceView = 7,
+    UnorderedAccessView = 8,
+    DispatchMesh = 10,
+};
+
+struct IndirectArgument
+{
+    IndirectArgumentType type;
+    uint32_t slot = 0;              // vertex buffer slot or root parameter index
+    uint32_t destOffsetIn32BitValues = 0;
+    uint32_t num32BitValues = 0;    // Constant only
+};
+
+// GPU-side argument structures, laid out like D3D12_DRAW_ARGUMENTS etc.
+struct IndirectDrawArgs
+{
+    uint32_t vertexCountPerInstance;
+    uint32_t instanceCount;
+    uint32_t startVertexLocation;
+    uint32_t startInstanceLocation;
+};
+
+struct IndirectDrawIndexedArgs
+{
+    uint32_t indexCountPerInstance;
+    uint32_t instanceCount;
+    uint32_t startIndexLocation;
+    int32_t baseVertexLocation;
+    uint32_t startInstanceLocation;
+};
+
+struct IndirectDispatchArgs
+{
+    uint32_t threadGroupCountX;
+    uint32_t threadGroupCountY;
+    uint32_t threadGroupCountZ;
+};
+
+// Draw types of GPU-driven passes; each gets its own command signature.
+enum class IndirectDrawType : uint32_t
+{
+    Draw,
+    DrawIndexed,
+    Dispatch,
+    DispatchMesh,
+};
+constexpr uint32_t c_IndirectDrawTypeCount = 4;
+
+// Command written per visible instance by GPU culling: the instance index as
+// a root constant, then the arguments of the draw type. Every type uses the
+// same stride, so one buffer layout serves all of them.
+struct IndirectDrawCommand
+{
+    uint32_t instanceIndex;
+    union
+    {
+        IndirectDrawArgs draw;
+        IndirectDrawIndexedArgs drawIndexed;
+        IndirectDispatchArgs dispatch;      // Dispatch and DispatchMesh
+    };
+};
+
+// Command signature arguments of IndirectDrawCommand for a draw type.
+std::vector<IndirectArgument> GetIndirectDrawArguments(IndirectDrawType type, uint32_t instanceRootIndex);
+
+// Checks GetIndirectDrawArguments(type, ...) against IndirectDrawCommand.
+bool ValidateIndirectDrawCommand(IndirectDrawType type, uint32_t instanceRootIndex, std::string* error = nullptr);
+
+struct IndirectLayout
+{
+    std::vector<uint32_t> offsets;  // byte offset of each argument
+    uint32_t packedSize = 0;        // minimum ByteStride
+};
+
+uint32_t GetIndirectArgumentSize(const IndirectArgument& argument);
+
+IndirectLayout ComputeIndirectLayout(const std::vector<IndirectArgument>& arguments);
+
+// Applies the rules the D3D12 runtime enforces in CreateCommandSignature:
+// exactly one draw/dispatch argument and it comes last, a 4-byte aligned
+// stride that fits every argument, a root signature whenever root arguments
+// are changed, each root parameter changed at most once, buffer views only
+// with draws (index buffers only with indexed draws).
+bool ValidateIndirectArguments(const std::vector<IndirectArgument>& arguments, uint32_t byteStride, bool hasRootSignature,
+    std::string* error = nullptr);
+
+// Checks a C++ command struct against the layout: memberOffsets[i] must be
+// where argument i starts, and sizeof the struct the stride.
+bool ValidateIndirectCommandStruct(const std::vector<IndirectArgument>& arguments, const std::vector<uint32_t>& memberOffsets,
+    uint32_t structSize, std::string* error = nullptr);
@@ -0,0 +1,213 @@
+#include "IndirectDrawPass.h"
+#include "RootSignatureCache.h"
+
+#include <cassert>
+#include <cstring>
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    enum CullRootParameters
+    {
+        CullConstants,      // 6 planes + instance count
+        CullInstances,      // t0
+        CullCommands,       // u0
+        CullCommandCount,   // u1
+        NumCullRootParameters
+    };
+
+    const UINT c_CullConstantCount = 6 * 4 + 2;
+
+    ComPtr<ID3D12Resource> CreateBuffer(ID3D12Device2* device, UINT64 size, D3D12_HEAP_TYPE heapType,
+        D3D12_RESOURCE_FLAGS flags, D3D12_RESOURCE_STATES state)
+    {
+        ComPtr<ID3D12Resource> buffer;
+        CD3DX12_HEAP_PROPERTIES heapProperties(heapType);
+        CD3DX12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(size, flags);
+        device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &desc, state, nullptr, IID_PPV_ARGS(&buffer));
+        return buffer;
+    }
+}
+
+bool IndirectDrawPass::Init(ComPtr<ID3D12Device2> device, ShaderCache& shaderCache, PipelineStateCache& pipelineStateCache,
+    RootSignatureCache& rootSignatureCache, ID3D12RootSignature* const rootSignatures[c_IndirectDrawTypeCount], UINT instanceRootIndex,
+    uint32_t maxInstances, uint32_t frameCount)
+{
+    m_PipelineStateCache = &pipelineStateCache;
+    m_MaxInstances = maxInstances;
+
+    for (uint32_t i = 0; i < c_IndirectDrawTypeCount; ++i)
+    {
+        // The same checks the runtime applies, plus the C++ command layout.
+        auto type = static_cast<IndirectDrawType>(i);
+        if (!rootSignatures[i])
+        {
+            continue;
+        }
+        std::string error;
+        if (!ValidateIndirectDrawCommand(type, instanceRootIndex, &error))
+        {
+            OutputDebugStringA(error.c_str());
+            return false;
+        }
+
+        auto arguments = GetIndirectDrawArguments(type, instanceRootIndex);
+        D3D12_INDIRECT_ARGUMENT_DESC argumentDescs[2] = {};
+        argumentDescs[0].Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+        argumentDescs[0].Constant.RootParameterIndex = arguments[0].slot;
+        argumentDescs[0].Constant.DestOffsetIn32BitValues = arguments[0].destOffsetIn32BitValues;
+        argumentDescs[0].Constant.Num32BitValuesToSet = arguments[0].num32BitValues;
+        argumentDescs[1].Type = static_cast<D3D12_INDIRECT_ARGUMENT_TYPE>(arguments[1].type);
+
+        D3D12_COMMAND_SIGNATURE_DESC signatureDesc = {};
+        signatureDesc.ByteStride = sizeof(IndirectDrawCommand);
+        signatureDesc.NumArgumentDescs = _countof(argumentDescs);
+        signatureDesc.pArgumentDescs = argumentDescs;
+        HRESULT result = device->CreateCommandSignature(&signatureDesc, rootSignatures[i], IID_PPV_ARGS(&m_CommandSignatures[i]));
+        // Without mesh shaders, DispatchMesh signatures fail; that type is then unsupported.
+        if (FAILED(result) && type != IndirectDrawType::DispatchMesh)
+        {
+            return false;
+        }
+    }
+
+    UINT64 instanceBytes = sizeof(IndirectInstance) * static_cast<UINT64>(maxInstances);
+    m_InstanceBuffer = CreateBuffer(device.Get(), instanceBytes, D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_FLAG_NONE, D3D12_RESOURCE_STATE_COPY_DEST);
+    for (uint32_t i = 0; i < frameCount; ++i)
+    {
+        m_InstanceUploads.push_back(CreateBuffer(device.Get(), instanceBytes, D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_FLAG_NONE, D3D12_RESOURCE_STATE_GENERIC_READ));
+    }
+    // One region of maxInstances commands and one count per draw type.
+    m_CommandBuffer = CreateBuffer(device.Get(), sizeof(IndirectDrawCommand) * static_cast<UINT64>(maxInstances) * c_IndirectDrawTypeCount,
+        D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+    m_CountBuffer = CreateBuffer(device.Get(), sizeof(uint32_t) * c_IndirectDrawTypeCount, D3D12_HEAP_TYPE_DEFAULT,
+        D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+
+    m_ZeroBuffer = CreateBuffer(device.Get(), sizeof(uint32_t) * c_IndirectDrawTypeCount, D3D12_HEAP_TYPE_UPLOAD,
+        D3D12_RESOURCE_FLAG_NONE, D3D12_RESOURCE_STATE_GENERIC_READ);
+    void* zero = nullptr;
+    CD3DX12_RANGE readRange(0, 0);
+    m_ZeroBuffer->Map(0, &readRange, &zero);
+    memset(zero, 0, sizeof(uint32_t) * c_IndirectDrawTypeCount);
+    m_ZeroBuffer->Unmap(0, nullptr);
+
+    CD3DX12_ROOT_PARAMETER1 rootParameters[NumCullRootParameters];
+    rootParameters[CullConstants].InitAsConstants(c_CullConstantCount, 0);
+    rootParameters[CullInstances].InitAsShaderResourceView(0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC_WHILE_SET_AT_EXECUTE);
+    rootParameters[CullCommands].InitAsUnorderedAccessView(0);
+    rootParameters[CullCommandCount].InitAsUnorderedAccessView(1);
+    CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
+    rootSignatureDesc.Init_1_1(_countof(rootParameters), rootParameters);
+    m_CullRootSignature = rootSignatureCache.Get(rootSignatureDesc);
+    if (!m_CullRootSignature)
+    {
+        return false;
+    }
+
+    ShaderDesc shaderDesc;
+    shaderDesc.path = "shaders/CullInstances.hlsl";
+    shaderDesc.target = "cs_5_1";
+    auto shader = shaderCache.Request(shaderDesc);
+    shaderCache.Wait(shader);
+    auto bytecode = shaderCache.GetBytecode(shader);
+    if (!bytecode)
+    {
+        OutputDebugStringA(shaderCache.GetErrors(shader).c_str());
+        return false;
+    }
+
+    struct CullPipelineStream
+    {
+        CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE rootSignature;
+        CD3DX12_PIPELINE_STATE_STREAM_CS cs;
+    } stream;
+    stream.rootSignature = m_CullRootSignature;
+    stream.cs = CD3DX12_SHADER_BYTECODE(bytecode->data(), bytecode->size());
+    m_CullPipeline = pipelineStateCache.Request(stream);
+    return true;
+}
+
+void IndirectDrawPass::UpdateInstances(ID3D12GraphicsCommandList* commandList, uint32_t frameIndex, const IndirectInstance* instances, uint32_t count)
+{
+    assert(count <= m_MaxInstances);
+    m_InstanceCount = count;
+    if (count == 0)
+    {
+        return;
+    }
+
+    auto& upload = m_InstanceUploads[frameIndex];
+    void* data = nullptr;
+    CD3DX12_RANGE readRange(0, 0);
+    upload->Map(0, &readRange, &data);
+    memcpy(data, instances, sizeof(IndirectInstance) * count);
+    upload->Unmap(0, nullptr);
+
+    commandList->CopyBufferRegion(m_InstanceBuffer.Get(), 0, upload.Get(), 0, sizeof(IndirectInstance) * count);
+}
+
+void IndirectDrawPass::Cull(ID3D12GraphicsCommandList* commandList, const float frustumPlanes[6][4])
+{
+    // Until the culling pipeline has compiled, Execute() draws nothing.
+    m_Culled = false;
+    auto pipelineState = m_PipelineStateCache->Get(m_CullPipeline);
+    if (!pipelineState || m_InstanceCount == 0)
+    {
+        return;
+    }
+
+    {
+        CD3DX12_RESOURCE_BARRIER barriers[] = {
+            CD3DX12_RESOURCE_BARRIER::Transition(m_InstanceBuffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+            CD3DX12_RESOURCE_BARRIER::Transition(m_CountBuffer.Get(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_COPY_DEST),
+            CD3DX12_RESOURCE_BARRIER::Transition(m_CommandBuffer.Get(), D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT, D3D12_RESOURCE_STATE_UNORDERED_ACCESS),
+        };
+        commandList->ResourceBarrier(_countof(barriers), barriers);
+    }
+
+    commandList->CopyBufferRegion(m_CountBuffer.Get(), 0, m_ZeroBuffer.Get(), 0, sizeof(uint32_t) * c_IndirectDrawTypeCount);
+
+    {
+        CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_CountBuffer.Get(),
+            D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+        commandList->ResourceBarrier(1, &barrier);
+    }
+
+    uint32_t constants[c_CullConstantCount];
+    memcpy(constants, frustumPlanes, sizeof(float) * 6 * 4);
+    constants[6 * 4] = m_InstanceCount;
+    constants[6 * 4 + 1] = m_MaxInstances;
+
+    commandList->SetPipelineState(pipelineState);
+    commandList->SetComputeRootSignature(m_CullRootSignature);
+    commandList->SetComputeRoot32BitConstants(CullConstants, c_CullConstantCount, constants, 0);
+    commandList->SetComputeRootShaderResourceView(CullInstances, m_InstanceBuffer->GetGPUVirtualAddress());
+    commandList->SetComputeRootUnorderedAccessView(CullCommands, m_CommandBuffer->GetGPUVirtualAddress());
+    commandList->SetComputeRootUnorderedAccessView(CullCommandCount, m_CountBuffer->GetGPUVirtualAddress());
+    commandList->Dispatch((m_InstanceCount + 63) / 64, 1, 1);
+
+    {
+        CD3DX12_RESOURCE_BARRIER barriers[] = {
+            CD3DX12_RESOURCE_BARRIER::Transition(m_InstanceBuffer.Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST),
+            CD3DX12_RESOURCE_BARRIER::Transition(m_CountBuffer.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT),
+            CD3DX12_RESOURCE_BARRIER::Transition(m_CommandBuffer.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT),
+        };
+        commandList->ResourceBarrier(_countof(barriers), barriers);
+    }
+
+    m_Culled = true;
+}
+
+void IndirectDrawPass::Execute(ID3D12GraphicsCommandList* commandList, IndirectDrawType type)
+{
+    uint32_t index = static_cast<uint32_t>(type);
+    if (!m_Culled || !m_CommandSignatures[index])
+    {
+        return;
+    }
+
+    commandList->ExecuteIndirect(m_CommandSignatures[index].Get(), m_InstanceCount,
+        m_CommandBuffer.Get(), sizeof(IndirectDrawCommand) * static_cast<UINT64>(m_MaxInstances) * index,
+        m_CountBuffer.Get(), sizeof(uint32_t) * index);
+}
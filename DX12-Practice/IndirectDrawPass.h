@@ -0,0 +1,72 @@
+#pragma once
+#include "Win.h"
+#include <wrl/client.h>
+
+#include "directx/d3dx12.h"
+
+#include "IndirectArguments.h"
+#include "PipelineStateCache.h"
+#include "ShaderCache.h"
+
+#include <cstdint>
+#include <vector>
+
+class RootSignatureCache;
+
+// Per-instance data read by the culling shader (shaders/CullInstances.hlsl).
+struct IndirectInstance
+{
+    float sphere[4];        // world-space center, radius
+    uint32_t indexCount;    // vertex count for Draw, thread groups (x) for the dispatches
+    uint32_t startIndex;    // start vertex for Draw
+    int32_t baseVertex;
+    IndirectDrawType drawType = IndirectDrawType::DrawIndexed;
+};
+
+// GPU-driven draw path. Instances live in a GPU buffer; a compute pass culls
+// them against the frustum and compacts visible draws into an argument
+// buffer plus a count buffer, and one ExecuteIndirect per draw type issues
+// them all. CPU cost no longer depends on the number of objects.
+//
+// Visible commands are grouped by IndirectDrawType, one command signature
+// each, built against the root signature the commands of that type execute
+// with: graphics for the draws and DispatchMesh, compute for Dispatch. Each
+// must have the instance index as a single 32-bit root constant at parameter
+// instanceRootIndex. A null root signature leaves the type unsupported, as
+// does a device without mesh shaders for DispatchMesh.
+class IndirectDrawPass
+{
+public:
+    bool Init(Microsoft::WRL::ComPtr<ID3D12Device2> device, ShaderCache& shaderCache, PipelineStateCache& pipelineStateCache,
+        RootSignatureCache& rootSignatureCache, ID3D12RootSignature* const rootSignatures[c_IndirectDrawTypeCount], UINT instanceRootIndex,
+        uint32_t maxInstances, uint32_t frameCount);
+
+    // Copies this frame's instances to the GPU buffer.
+    void UpdateInstances(ID3D12GraphicsCommandList* commandList, uint32_t frameIndex, const IndirectInstance* instances, uint32_t count);
+
+    // frustumPlanes: 6 planes (xyz normal pointing inwards, w distance).
+    void Cull(ID3D12GraphicsCommandList* commandList, const float frustumPlanes[6][4]);
+
+    // Issues the visible commands of one draw type. Expects the matching
+    // pipeline (graphics, compute or mesh) and root signature to be bound,
+    // and for DrawIndexed the index buffer.
+    void Execute(ID3D12GraphicsCommandList* commandList, IndirectDrawType type = IndirectDrawType::DrawIndexed);
+
+    bool IsSupported(IndirectDrawType type) const { return m_CommandSignatures[static_cast<uint32_t>(type)] != nullptr; }
+
+private:
+    Microsoft::WRL::ComPtr<ID3D12CommandSignature> m_CommandSignatures[c_IndirectDrawTypeCount];
+    Microsoft::WRL::ComPtr<ID3D12Resource> m_InstanceBuffer;
+    std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> m_InstanceUploads;
+    Microsoft::WRL::ComPtr<ID3D12Resource> m_CommandBuffer;
+    Microsoft::WRL::ComPtr<ID3D12Resource> m_CountBuffer;
+    Microsoft::WRL::ComPtr<ID3D12Resource> m_ZeroBuffer;
+
+    PipelineStateCache* m_PipelineStateCache = nullptr;
+    PipelineStateHandle m_CullPipeline;
+    ID3D12RootSignature* m_CullRootSignature = nullptr;
+
+    uint32_t m_MaxInstances = 0;
+    uint32_t m_InstanceCount = 0;
+    bool m_Culled = false;
+};
@@ -0,0 +1,127 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+JobSystem::JobSystem(uint32_t workerCount)
+{
+    if (workerCount == 0)
+    {
+        uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = std::max<uint32_t>(1, hardwareThreads > 1 ? hardwareThreads - 1 : 1);
+    }
+
+    m_Workers.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; ++i)
+    {
+        m_Workers.emplace_back([this] { WorkerLoop(); });
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Quit = true;
+    }
+    m_Condition.notify_all();
+
+    for (auto& worker : m_Workers)
+    {
+        worker.join();
+    }
+}
+
+void JobSystem::Submit(std::function<void()> job, JobCounter* counter)
+{
+    if (counter)
+    {
+        counter->m_Pending.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Queue.push_back({ std::move(job), counter });
+    }
+    m_Condition.notify_one();
+}
+
+void JobSystem::ParallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t, uint32_t)>& func)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    grainSize = std::max<uint32_t>(1, grainSize);
+    if (count <= grainSize)
+    {
+        func(0, count);
+        return;
+    }
+
+    JobCounter counter;
+    for (uint32_t begin = grainSize; begin < count; begin += grainSize)
+    {
+        uint32_t end = std::min(count, begin + grainSize);
+        Submit([&func, begin, end] { func(begin, end); }, &counter);
+    }
+
+    // The first range runs on the calling thread.
+    func(0, grainSize);
+    Wait(counter);
+}
+
+void JobSystem::Wait(const JobCounter& counter)
+{
+    while (!counter.IsDone())
+    {
+        if (!TryRunOne())
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::WorkerLoop()
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Condition.wait(lock, [this] { return m_Quit || !m_Queue.empty(); });
+            if (m_Quit && m_Queue.empty())
+            {
+                return;
+            }
+            job = std::move(m_Queue.front());
+            m_Queue.pop_front();
+        }
+        Run(job);
+    }
+}
+
+bool JobSystem::TryRunOne()
+{
+    Job job;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Queue.empty())
+        {
+            return false;
+        }
+        job = std::move(m_Queue.front());
+        m_Queue.pop_front();
+    }
+    Run(job);
+    return true;
+}
+
+void JobSystem::Run(Job& job)
+{
+    job.func();
+    if (job.counter)
+    {
+        job.counter->m_Pending.fetch_sub(1, std::memory_order_release);
+    }
+}
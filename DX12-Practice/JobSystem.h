@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed pool of worker threads fed from a single FIFO queue. Jobs may be
+// grouped under a JobCounter so the caller can wait for a batch to finish;
+// the waiting thread helps execute queued jobs instead of blocking.
+class JobCounter
+{
+public:
+    bool IsDone() const { return m_Pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+    std::atomic<uint32_t> m_Pending{ 0 };
+};
+
+class JobSystem
+{
+public:
+    // workerCount == 0 uses hardware_concurrency - 1 (the main thread also helps).
+    explicit JobSystem(uint32_t workerCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    void Submit(std::function<void()> job, JobCounter* counter = nullptr);
+
+    // Splits [0, count) into ranges of at most grainSize and runs
+    // func(begin, end) on the pool; returns once every range is done.
+    void ParallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t, uint32_t)>& func);
+
+    void Wait(const JobCounter& counter);
+
+    // Runs one queued job on the calling thread; false if the queue is empty.
+    bool TryRunOne();
+
+    uint32_t GetWorkerCount() const { return static_cast<uint32_t>(m_Workers.size()); }
+
+private:
+    struct Job
+    {
+        std::function<void()> func;
+        JobCounter* counter = nullptr;
+    };
+
+    void WorkerLoop();
+    static void Run(Job& job);
+
+    std::vector<std::thread> m_Workers;
+    std::deque<Job> m_Queue;
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    bool m_Quit = false;
+};
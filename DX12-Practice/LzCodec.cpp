@@ -0,0 +1,217 @@
+#include "LzCodec.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    constexpr size_t c_MinMatch = 4;
+    constexpr size_t c_MaxOffset = 65535;
+    constexpr uint32_t c_HashBits = 14;
+
+    uint32_t Load32(const uint8_t* data)
+    {
+        uint32_t value;
+        memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    uint32_t HashSequence(uint32_t value)
+    {
+        return (value * 2654435761u) >> (32 - c_HashBits);
+    }
+
+    uint8_t* WriteLength(uint8_t* output, size_t length)
+    {
+        for (; length >= 255; length -= 255)
+        {
+            *output++ = 255;
+        }
+        *output++ = static_cast<uint8_t>(length);
+        return output;
+    }
+
+    bool ReadLength(const uint8_t*& input, const uint8_t* end, size_t& length)
+    {
+        uint8_t value;
+        do
+        {
+            if (input == end)
+            {
+                return false;
+            }
+            value = *input++;
+            length += value;
+        } while (value == 255);
+        return true;
+    }
+
+    // matchLength == 0 writes the final, literal-only sequence.
+    bool WriteSequence(uint8_t*& output, const uint8_t* outputEnd, const uint8_t* literals, size_t literalCount,
+        size_t offset, size_t matchLength)
+    {
+        size_t matchCode = matchLength ? matchLength - c_MinMatch : 0;
+        size_t needed = 1 + literalCount / 255 + 1 + literalCount + (matchLength ? 2 + matchCode / 255 + 1 : 0);
+        if (size_t(outputEnd - output) < needed)
+        {
+            return false;
+        }
+
+        *output++ = static_cast<uint8_t>((std::min<size_t>(literalCount, 15) << 4) | std::min<size_t>(matchCode, 15));
+        if (literalCount >= 15)
+        {
+            output = WriteLength(output, literalCount - 15);
+        }
+        if (literalCount)
+        {
+            memcpy(output, literals, literalCount);
+            output += literalCount;
+        }
+
+        if (matchLength)
+        {
+            *output++ = static_cast<uint8_t>(offset);
+            *output++ = static_cast<uint8_t>(offset >> 8);
+            if (matchCode >= 15)
+            {
+                output = WriteLength(output, matchCode - 15);
+            }
+        }
+        return true;
+    }
+}
+
+size_t LzCompress(const void* input, size_t size, void* output, size_t capacity)
+{
+    const uint8_t* begin = static_cast<const uint8_t*>(input);
+    const uint8_t* end = begin + size;
+    uint8_t* out = static_cast<uint8_t*>(output);
+    const uint8_t* outEnd = out + capacity;
+
+    // Most recent position of each hashed 4-byte sequence; greedy parse.
+    std::vector<uint32_t> table(size_t(1) << c_HashBits, 0);
+    const uint8_t* anchor = begin;
+    const uint8_t* position = begin + 1;
+    const uint8_t* matchLimit = size > c_MinMatch ? end - c_MinMatch : begin;
+
+    while (position < matchLimit)
+    {
+        uint32_t sequence = Load32(position);
+        uint32_t& slot = table[HashSequence(sequence)];
+        const uint8_t* candidate = begin + slot;
+        slot = static_cast<uint32_t>(position - begin);
+
+        if (size_t(position - candidate) > c_MaxOffset || Load32(candidate) != sequence)
+        {
+            // Step faster through data that has not matched for a while.
+            position += 1 + ((position - anchor) >> 6);
+            continue;
+        }
+
+        const uint8_t* matchEnd = position + c_MinMatch;
+        const uint8_t* reference = candidate + c_MinMatch;
+        while (matchEnd < end && *matchEnd == *reference)
+        {
+            ++matchEnd;
+            ++reference;
+        }
+        while (position > anchor && candidate > begin && position[-1] == candidate[-1])
+        {
+            --position;
+            --candidate;
+        }
+
+        if (!WriteSequence(out, outEnd, anchor, position - anchor, position - candidate, matchEnd - position))
+        {
+            return 0;
+        }
+        anchor = position = matchEnd;
+    }
+
+    if (!WriteSequence(out, outEnd, anchor, end - anchor, 0, 0))
+    {
+        return 0;
+    }
+    return out - static_cast<uint8_t*>(output);
+}
+
+bool LzDecompress(const void* input, size_t size, void* output, size_t outputSize)
+{
+    const uint8_t* in = static_cast<const uint8_t*>(input);
+    const uint8_t* inEnd = in + size;
+    uint8_t* begin = static_cast<uint8_t*>(output);
+    uint8_t* out = begin;
+    uint8_t* outEnd = begin + outputSize;
+
+    for (;;)
+    {
+        if (in == inEnd)
+        {
+            return false;
+        }
+        uint32_t token = *in++;
+
+        size_t literalCount = token >> 4;
+        if (literalCount == 15 && !ReadLength(in, inEnd, literalCount))
+        {
+            return false;
+        }
+        if (literalCount > size_t(inEnd - in) || literalCount > size_t(outEnd - out))
+        {
+            return false;
+        }
+        if (literalCount)
+        {
+            memcpy(out, in, literalCount);
+            in += literalCount;
+            out += literalCount;
+        }
+
+        if (in == inEnd)
+        {
+            return out == outEnd;
+        }
+
+        if (inEnd - in < 2)
+        {
+            return false;
+        }
+        size_t offset = in[0] | (size_t(in[1]) << 8);
+        in += 2;
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !ReadLength(in, inEnd, matchLength))
+        {
+            return false;
+        }
+        matchLength += c_MinMatch;
+        if (offset == 0 || offset > size_t(out - begin) || matchLength > size_t(outEnd - out))
+        {
+            return false;
+        }
+
+        // Overlapping matches repeat the last offset bytes; copy in steps no
+        // larger than the offset so every source byte is written first.
+        const uint8_t* match = out - offset;
+        if (offset >= matchLength)
+        {
+            memcpy(out, match, matchLength);
+        }
+        else
+        {
+            size_t i = 0;
+            if (offset >= 8)
+            {
+                for (; i + 8 <= matchLength; i += 8)
+                {
+                    memcpy(out + i, match + i, 8);
+                }
+            }
+            for (; i < matchLength; ++i)
+            {
+                out[i] = match[i];
+            }
+        }
+        out += matchLength;
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Byte-oriented LZ77 codec for asset payloads, tuned for decode speed rather
+// than ratio. A stream is a sequence of
+//     token        literal count (high nibble), match length - 4 (low nibble);
+//                  a nibble of 15 continues in bytes of 255 until a smaller one
+//     literals
+//     offset       2 bytes little-endian, 1..65535 back into the output
+// and ends with a sequence that has literals only. The decoded size is not
+// stored; callers keep it next to the stream.
+
+// Worst-case compressed size of size input bytes.
+inline size_t GetLzCompressBound(size_t size)
+{
+    return size + size / 255 + 16;
+}
+
+// Compresses input into output; returns the compressed size, or 0 if it
+// does not fit in capacity (so passing less than the input size rejects
+// data that does not compress).
+size_t LzCompress(const void* input, size_t size, void* output, size_t capacity);
+
+// Decompresses exactly outputSize bytes. Returns false for corrupt input,
+// without reading or writing outside either buffer.
+bool LzDecompress(const void* input, size_t size, void* output, size_t outputSize);
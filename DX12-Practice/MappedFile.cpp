@@ -0,0 +1,215 @@
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <utility>
+
+#if defined(_WIN32)
+#include "Win.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // Unique per process and call, so concurrent writers of the same path
+    // never share (and truncate) each other's temporary file.
+    std::filesystem::path MakeTempPath(const std::filesystem::path& path, unsigned long processId)
+    {
+        static std::atomic<uint32_t> s_Counter{0};
+        std::filesystem::path tempPath = path;
+        tempPath += "." + std::to_string(processId) + "." + std::to_string(s_Counter.fetch_add(1)) + ".tmp";
+        return tempPath;
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        Close();
+        std::swap(m_Data, other.m_Data);
+        std::swap(m_Size, other.m_Size);
+#if defined(_WIN32)
+        std::swap(m_File, other.m_File);
+        std::swap(m_Mapping, other.m_Mapping);
+#endif
+    }
+    return *this;
+}
+
+#if defined(_WIN32)
+
+bool MappedFile::Open(const std::filesystem::path& path)
+{
+    Close();
+
+    HANDLE file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER size = {};
+    if (!::GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        ::CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+    {
+        ::CloseHandle(file);
+        return false;
+    }
+
+    void* view = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view)
+    {
+        ::CloseHandle(mapping);
+        ::CloseHandle(file);
+        return false;
+    }
+
+    m_File = file;
+    m_Mapping = mapping;
+    m_Data = static_cast<const uint8_t*>(view);
+    m_Size = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (m_Data)
+    {
+        ::UnmapViewOfFile(m_Data);
+        ::CloseHandle(m_Mapping);
+        ::CloseHandle(m_File);
+    }
+    m_Data = nullptr;
+    m_Size = 0;
+    m_File = nullptr;
+    m_Mapping = nullptr;
+}
+
+bool WriteFileAtomic(const std::filesystem::path& path, const void* data, size_t size)
+{
+    std::filesystem::path tempPath = MakeTempPath(path, ::GetCurrentProcessId());
+
+    HANDLE file = ::CreateFileW(tempPath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    auto bytes = static_cast<const uint8_t*>(data);
+    bool ok = true;
+    while (ok && size > 0)
+    {
+        DWORD chunk = static_cast<DWORD>(std::min<size_t>(size, 1u << 30));
+        DWORD written = 0;
+        ok = ::WriteFile(file, bytes, chunk, &written, nullptr) && written == chunk;
+        bytes += written;
+        size -= written;
+    }
+    ok = ok && ::FlushFileBuffers(file);
+    ::CloseHandle(file);
+
+    if (!ok || !::MoveFileExW(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+    {
+        ::DeleteFileW(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+#else
+
+bool MappedFile::Open(const std::filesystem::path& path)
+{
+    Close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat info = {};
+    if (::fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void* view = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps the file referenced
+    if (view == MAP_FAILED)
+    {
+        return false;
+    }
+
+    m_Data = static_cast<const uint8_t*>(view);
+    m_Size = static_cast<size_t>(info.st_size);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (m_Data)
+    {
+        ::munmap(const_cast<uint8_t*>(m_Data), m_Size);
+    }
+    m_Data = nullptr;
+    m_Size = 0;
+}
+
+bool WriteFileAtomic(const std::filesystem::path& path, const void* data, size_t size)
+{
+    std::filesystem::path tempPath = MakeTempPath(path, static_cast<unsigned long>(::getpid()));
+
+    int fd = ::open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    auto bytes = static_cast<const uint8_t*>(data);
+    bool ok = true;
+    while (ok && size > 0)
+    {
+        ssize_t written = ::write(fd, bytes, size);
+        ok = written > 0;
+        if (ok)
+        {
+            bytes += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+    ok = ok && ::fsync(fd) == 0;
+    ::close(fd);
+
+    if (!ok || ::rename(tempPath.c_str(), path.c_str()) != 0)
+    {
+        ::unlink(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,135 @@
+#include "MeshFile.h"
+#include "Hash.h"
+
+#include <cstring>
+
+namespace
+{
+    uint64_t AlignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    uint64_t HashHeader(MeshFileHeader header)
+    {
+        header.headerHash = 0;
+        return HashValue(header);
+    }
+
+    bool Fail(std::string* error, const char* message)
+    {
+        if (error)
+        {
+            *error = message;
+        }
+        return false;
+    }
+}
+
+bool WriteMeshFile(const std::filesystem::path& path, const MeshFileData& data)
+{
+    MeshFileHeader header = {};
+    header.magic = MeshFileHeader::c_Magic;
+    header.version = MeshFileHeader::c_Version;
+    header.headerSize = sizeof(MeshFileHeader);
+    header.vertexStride = data.vertexStride;
+    header.vertexCount = data.vertexCount;
+    header.indexCount = data.indexCount;
+    header.indexSize = data.indexSize;
+    header.boundsCount = static_cast<uint32_t>(data.bounds.size());
+    header.meshletCount = static_cast<uint32_t>(data.meshlets.size());
+    header.meshletVertexCount = static_cast<uint32_t>(data.meshletVertices.size());
+    header.meshletPrimitiveCount = static_cast<uint32_t>(data.meshletPrimitives.size());
+
+    const void* sources[NumMeshSections] = {
+        data.vertices, data.indices, data.bounds.data(), data.meshlets.data(),
+        data.meshletVertices.data(), data.meshletPrimitives.data(),
+    };
+    header.sectionSizes[MeshSectionVertices] = uint64_t(data.vertexStride) * data.vertexCount;
+    header.sectionSizes[MeshSectionIndices] = uint64_t(data.indexSize) * data.indexCount;
+    header.sectionSizes[MeshSectionBounds] = sizeof(MeshBounds) * data.bounds.size();
+    header.sectionSizes[MeshSectionMeshlets] = sizeof(Meshlet) * data.meshlets.size();
+    header.sectionSizes[MeshSectionMeshletVertices] = sizeof(uint32_t) * data.meshletVertices.size();
+    header.sectionSizes[MeshSectionMeshletPrimitives] = sizeof(uint32_t) * data.meshletPrimitives.size();
+
+    uint64_t offset = AlignUp(sizeof(MeshFileHeader), c_MeshSectionAlignment);
+    for (int section = 0; section < NumMeshSections; ++section)
+    {
+        header.sectionOffsets[section] = offset;
+        offset = AlignUp(offset + header.sectionSizes[section], c_MeshSectionAlignment);
+    }
+    header.fileSize = offset;
+    header.headerHash = HashHeader(header);
+
+    std::vector<uint8_t> file(static_cast<size_t>(header.fileSize), 0);
+    memcpy(file.data(), &header, sizeof(header));
+    for (int section = 0; section < NumMeshSections; ++section)
+    {
+        if (header.sectionSizes[section])
+        {
+            memcpy(file.data() + header.sectionOffsets[section], sources[section], static_cast<size_t>(header.sectionSizes[section]));
+        }
+    }
+    return WriteFileAtomic(path, file.data(), file.size());
+}
+
+bool ValidateMeshFileHeader(const MeshFileHeader& header, uint64_t fileSize, std::string* error)
+{
+    if (header.magic != MeshFileHeader::c_Magic)
+    {
+        return Fail(error, "not a mesh file");
+    }
+    if (header.version != MeshFileHeader::c_Version || header.headerSize != sizeof(MeshFileHeader))
+    {
+        return Fail(error, "unsupported mesh file version");
+    }
+    if (header.headerHash != HashHeader(header))
+    {
+        return Fail(error, "mesh file header is corrupt");
+    }
+    if (header.fileSize != fileSize)
+    {
+        return Fail(error, "mesh file is truncated");
+    }
+    if (header.indexSize != 2 && header.indexSize != 4)
+    {
+        return Fail(error, "invalid index size");
+    }
+
+    const uint64_t expectedSizes[NumMeshSections] = {
+        uint64_t(header.vertexStride) * header.vertexCount,
+        uint64_t(header.indexSize) * header.indexCount,
+        sizeof(MeshBounds) * uint64_t(header.boundsCount),
+        sizeof(Meshlet) * uint64_t(header.meshletCount),
+        sizeof(uint32_t) * uint64_t(header.meshletVertexCount),
+        sizeof(uint32_t) * uint64_t(header.meshletPrimitiveCount),
+    };
+    for (int section = 0; section < NumMeshSections; ++section)
+    {
+        uint64_t offset = header.sectionOffsets[section];
+        uint64_t size = header.sectionSizes[section];
+        if (size != expectedSizes[section] || offset % c_MeshSectionAlignment != 0 ||
+            offset < sizeof(MeshFileHeader) || offset > fileSize || size > fileSize - offset)
+        {
+            return Fail(error, "mesh file section out of range");
+        }
+    }
+    return true;
+}
+
+bool MeshFile::Open(const std::filesystem::path& path, std::string* error)
+{
+    if (!m_File.Open(path))
+    {
+        return Fail(error, "cannot open mesh file");
+    }
+
+    // Only the header page is touched; section pages fault in when used.
+    bool valid = m_File.GetSize() >= sizeof(MeshFileHeader) ?
+        ValidateMeshFileHeader(GetHeader(), m_File.GetSize(), error) : Fail(error, "mesh file is truncated");
+    if (!valid)
+    {
+        m_File.Close();
+    }
+    return valid;
+}
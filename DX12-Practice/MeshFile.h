@@ -0,0 +1,112 @@
+#pragma once
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Cooked binary mesh (.mesh). Everything after the header is a section at a
+// c_MeshSectionAlignment aligned offset, stored exactly as the GPU consumes
+// it, so a memory-mapped file is handed to the upload path as-is:
+//
+//   header | vertices | indices | bounds | meshlets | meshlet vertices | meshlet primitives
+//
+// Open() validates only the header (magic, version, header hash, section
+// ranges and sizes against the counts); section contents are not read.
+
+const uint32_t c_MeshSectionAlignment = 256;
+
+enum MeshSection
+{
+    MeshSectionVertices,
+    MeshSectionIndices,
+    MeshSectionBounds,
+    MeshSectionMeshlets,
+    MeshSectionMeshletVertices,     // uint32 vertex indices
+    MeshSectionMeshletPrimitives,   // uint32 per triangle: i0 | i1 << 10 | i2 << 20
+    NumMeshSections
+};
+
+// One entry per submesh.
+struct MeshBounds
+{
+    float sphere[4];        // center, radius
+    float boxMin[3];
+    uint32_t indexOffset;
+    float boxMax[3];
+    uint32_t indexCount;
+};
+
+struct Meshlet
+{
+    uint32_t vertexOffset;      // into the meshlet vertex section
+    uint32_t vertexCount;
+    uint32_t primitiveOffset;   // into the meshlet primitive section
+    uint32_t primitiveCount;
+    float sphere[4];            // center, radius
+    float coneAxis[3];          // back-facing from camera c when, with v = center - c,
+    float coneCutoff;           // dot(v, coneAxis) >= coneCutoff * length(v) + radius
+};
+
+struct MeshFileHeader
+{
+    static const uint32_t c_Magic = 0x534d5844; // 'DXMS'
+    static const uint32_t c_Version = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t vertexStride;
+    uint64_t fileSize;
+    uint64_t headerHash;        // of this header with headerHash = 0
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t indexSize;         // 2 or 4
+    uint32_t boundsCount;
+    uint32_t meshletCount;
+    uint32_t meshletVertexCount;
+    uint32_t meshletPrimitiveCount;
+    uint32_t reserved;
+    uint64_t sectionOffsets[NumMeshSections];
+    uint64_t sectionSizes[NumMeshSections];
+};
+
+// Input for the offline cooker.
+struct MeshFileData
+{
+    const void* vertices = nullptr;
+    uint32_t vertexStride = 0;
+    uint32_t vertexCount = 0;
+    const void* indices = nullptr;
+    uint32_t indexSize = 4;
+    uint32_t indexCount = 0;
+    std::vector<MeshBounds> bounds;
+    std::vector<Meshlet> meshlets;
+    std::vector<uint32_t> meshletVertices;
+    std::vector<uint32_t> meshletPrimitives;
+};
+
+bool WriteMeshFile(const std::filesystem::path& path, const MeshFileData& data);
+
+// Checks a header against the size of the file it came from.
+bool ValidateMeshFileHeader(const MeshFileHeader& header, uint64_t fileSize, std::string* error);
+
+class MeshFile
+{
+public:
+    bool Open(const std::filesystem::path& path, std::string* error = nullptr);
+    void Close() { m_File.Close(); }
+
+    bool IsOpen() const { return m_File.IsOpen(); }
+    const MeshFileHeader& GetHeader() const { return *reinterpret_cast<const MeshFileHeader*>(m_File.GetData()); }
+
+    const void* GetSection(MeshSection section) const { return m_File.GetData() + GetHeader().sectionOffsets[section]; }
+    uint64_t GetSectionSize(MeshSection section) const { return GetHeader().sectionSizes[section]; }
+
+    const MeshBounds* GetBounds() const { return static_cast<const MeshBounds*>(GetSection(MeshSectionBounds)); }
+    const Meshlet* GetMeshlets() const { return static_cast<const Meshlet*>(GetSection(MeshSectionMeshlets)); }
+
+private:
+    MappedFile m_File;
+};
@@ -0,0 +1,552 @@
+#include "MeshSimplifier.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace
+{
+    const uint32_t c_ChunkTriangles = 16 * 1024;
+    const double c_BorderWeight = 10.0;
+    const double c_MaxTurnCosine = 0.5;
+
+    struct Vector3
+    {
+        double x, y, z;
+
+        Vector3 operator+(const Vector3& o) const { return { x + o.x, y + o.y, z + o.z }; }
+        Vector3 operator-(const Vector3& o) const { return { x - o.x, y - o.y, z - o.z }; }
+        Vector3 operator*(double s) const { return { x * s, y * s, z * s }; }
+    };
+
+    double Dot(const Vector3& a, const Vector3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    Vector3 Cross(const Vector3& a, const Vector3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+    double Length(const Vector3& a) { return std::sqrt(Dot(a, a)); }
+
+    // Symmetric 4x4 plane quadric plus the total weight it was built from, so
+    // Evaluate() returns a weighted mean squared distance.
+    struct Quadric
+    {
+        double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+        double a11 = 0, a12 = 0, a13 = 0;
+        double a22 = 0, a23 = 0;
+        double a33 = 0;
+        double weight = 0;
+
+        void AddPlane(const Vector3& n, double d, double w)
+        {
+            a00 += w * n.x * n.x; a01 += w * n.x * n.y; a02 += w * n.x * n.z; a03 += w * n.x * d;
+            a11 += w * n.y * n.y; a12 += w * n.y * n.z; a13 += w * n.y * d;
+            a22 += w * n.z * n.z; a23 += w * n.z * d;
+            a33 += w * d * d;
+            weight += w;
+        }
+
+        void Add(const Quadric& q)
+        {
+            a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+            a11 += q.a11; a12 += q.a12; a13 += q.a13;
+            a22 += q.a22; a23 += q.a23;
+            a33 += q.a33;
+            weight += q.weight;
+        }
+
+        double Evaluate(const Vector3& p) const
+        {
+            double error = a00 * p.x * p.x + 2 * a01 * p.x * p.y + 2 * a02 * p.x * p.z + 2 * a03 * p.x +
+                a11 * p.y * p.y + 2 * a12 * p.y * p.z + 2 * a13 * p.y +
+                a22 * p.z * p.z + 2 * a23 * p.z + a33;
+            return weight > 0 ? std::max(0.0, error) / weight : 0.0;
+        }
+    };
+
+    // Vertex data shared by all chunks; read-only during simplification.
+    struct Mesh
+    {
+        const SimplifyInput& input;
+        std::vector<uint8_t> seams;     // vertex shares its position with another
+
+        explicit Mesh(const SimplifyInput& in) : input(in) {}
+
+        Vector3 GetPosition(uint32_t vertex) const
+        {
+            const float* p = reinterpret_cast<const float*>(static_cast<const uint8_t*>(input.vertices) + static_cast<size_t>(vertex) * input.vertexStride);
+            return { p[0], p[1], p[2] };
+        }
+
+        double GetAttributeDistance(uint32_t a, uint32_t b) const
+        {
+            auto base = static_cast<const uint8_t*>(input.vertices) + input.attributeOffset;
+            const float* attributesA = reinterpret_cast<const float*>(base + static_cast<size_t>(a) * input.vertexStride);
+            const float* attributesB = reinterpret_cast<const float*>(base + static_cast<size_t>(b) * input.vertexStride);
+            double distance = 0;
+            for (uint32_t i = 0; i < input.attributeCount; ++i)
+            {
+                double weight = input.attributeWeights ? input.attributeWeights[i] : 1.0;
+                double delta = (attributesA[i] - attributesB[i]) * weight;
+                distance += delta * delta;
+            }
+            return distance;
+        }
+    };
+
+    uint64_t EdgeKey(uint32_t a, uint32_t b)
+    {
+        return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+    }
+
+    // Simplifies one triangle set in place. Vertices flagged in `locked`
+    // (indexed by mesh vertex) never move.
+    class Simplifier
+    {
+    public:
+        Simplifier(const Mesh& mesh, const std::vector<uint8_t>& locked, std::vector<uint32_t>& indices)
+            : m_Mesh(mesh)
+            , m_Indices(indices)
+        {
+            // Work on compact local vertex ids.
+            std::unordered_map<uint32_t, uint32_t> localIds;
+            localIds.reserve(indices.size());
+            for (uint32_t& index : m_Indices)
+            {
+                auto inserted = localIds.emplace(index, static_cast<uint32_t>(m_Vertices.size()));
+                if (inserted.second)
+                {
+                    m_Vertices.push_back(index);
+                }
+                index = inserted.first->second;
+            }
+
+            uint32_t vertexCount = static_cast<uint32_t>(m_Vertices.size());
+            m_Positions.resize(vertexCount);
+            m_Locked.resize(vertexCount);
+            m_Border.assign(vertexCount, 0);
+            m_Quadrics.resize(vertexCount);
+            for (uint32_t v = 0; v < vertexCount; ++v)
+            {
+                m_Positions[v] = mesh.GetPosition(m_Vertices[v]);
+                m_Locked[v] = locked[m_Vertices[v]] || mesh.seams[m_Vertices[v]];
+            }
+
+            std::unordered_map<uint64_t, uint32_t> edgeUses;
+            edgeUses.reserve(m_Indices.size());
+            for (size_t i = 0; i < m_Indices.size(); i += 3)
+            {
+                for (int e = 0; e < 3; ++e)
+                {
+                    ++edgeUses[EdgeKey(m_Indices[i + e], m_Indices[i + (e + 1) % 3])];
+                }
+            }
+
+            for (size_t i = 0; i < m_Indices.size(); i += 3)
+            {
+                const Vector3& p0 = m_Positions[m_Indices[i]];
+                const Vector3& p1 = m_Positions[m_Indices[i + 1]];
+                const Vector3& p2 = m_Positions[m_Indices[i + 2]];
+                Vector3 normal = Cross(p1 - p0, p2 - p0);
+                double area = Length(normal);
+                if (area == 0)
+                {
+                    continue;
+                }
+                normal = normal * (1.0 / area);
+
+                Quadric face;
+                face.AddPlane(normal, -Dot(normal, p0), area);
+                for (int v = 0; v < 3; ++v)
+                {
+                    m_Quadrics[m_Indices[i + v]].Add(face);
+                }
+
+                // Border edges get a plane through the edge, perpendicular to
+                // the face, which pulls collapses back onto the border.
+                for (int e = 0; e < 3; ++e)
+                {
+                    uint32_t a = m_Indices[i + e];
+                    uint32_t b = m_Indices[i + (e + 1) % 3];
+                    if (edgeUses[EdgeKey(a, b)] != 1)
+                    {
+                        continue;
+                    }
+
+                    m_Border[a] = m_Border[b] = 1;
+                    m_BorderEdges.push_back(EdgeKey(a, b));
+
+                    Vector3 edge = m_Positions[b] - m_Positions[a];
+                    double length = Length(edge);
+                    Vector3 borderNormal = Cross(edge, normal);
+                    double borderLength = Length(borderNormal);
+                    if (borderLength > 0)
+                    {
+                        borderNormal = borderNormal * (1.0 / borderLength);
+                        Quadric border;
+                        border.AddPlane(borderNormal, -Dot(borderNormal, m_Positions[a]), length * length * c_BorderWeight);
+                        m_Quadrics[a].Add(border);
+                        m_Quadrics[b].Add(border);
+                    }
+                }
+            }
+            std::sort(m_BorderEdges.begin(), m_BorderEdges.end());
+        }
+
+        // Collapses until indexCount <= target or no collapse under maxError
+        // remains; writes mesh vertex ids back to the index list. Returns the
+        // largest geometric error of any collapse.
+        float Run(uint32_t targetIndexCount, float maxError)
+        {
+            double maxCost = double(maxError) * maxError;
+            double reached = 0;
+            uint32_t vertexCount = static_cast<uint32_t>(m_Vertices.size());
+            std::vector<uint32_t> remap(vertexCount);
+            std::vector<uint8_t> touched(vertexCount);
+
+            while (m_Indices.size() > targetIndexCount)
+            {
+                BuildAdjacency();
+
+                struct Collapse
+                {
+                    uint32_t source, target;
+                    double cost;        // geometric + attribute
+                    double distance;    // geometric only, squared
+                };
+                std::vector<Collapse> best(vertexCount, Collapse{ UINT32_MAX, UINT32_MAX, 0, 0 });
+                for (size_t i = 0; i < m_Indices.size(); i += 3)
+                {
+                    for (int e = 0; e < 3; ++e)
+                    {
+                        uint32_t a = m_Indices[i + e];
+                        uint32_t b = m_Indices[i + (e + 1) % 3];
+                        Consider(a, b, best[a]);
+                        Consider(b, a, best[b]);
+                    }
+                }
+
+                std::vector<Collapse> candidates;
+                for (const auto& collapse : best)
+                {
+                    if (collapse.source != UINT32_MAX && collapse.cost <= maxCost)
+                    {
+                        candidates.push_back(collapse);
+                    }
+                }
+                std::sort(candidates.begin(), candidates.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+                for (uint32_t v = 0; v < vertexCount; ++v)
+                {
+                    remap[v] = v;
+                }
+                std::fill(touched.begin(), touched.end(), 0);
+
+                // Independent collapses only: a vertex whose one-ring changed
+                // this pass is not touched again until adjacency is rebuilt.
+                size_t removeGoal = (m_Indices.size() - targetIndexCount) / 3;
+                size_t removed = 0;
+                for (const auto& collapse : candidates)
+                {
+                    if (removed >= removeGoal)
+                    {
+                        break;
+                    }
+                    if (touched[collapse.source] || touched[collapse.target] || !IsValid(collapse.source, collapse.target))
+                    {
+                        continue;
+                    }
+
+                    remap[collapse.source] = collapse.target;
+                    m_Quadrics[collapse.target].Add(m_Quadrics[collapse.source]);
+                    reached = std::max(reached, collapse.distance);
+                    for (uint32_t a = m_AdjacencyOffsets[collapse.source]; a < m_AdjacencyOffsets[collapse.source + 1]; ++a)
+                    {
+                        const uint32_t* triangle = &m_Indices[m_Adjacency[a] * 3];
+                        bool shared = triangle[0] == collapse.target || triangle[1] == collapse.target || triangle[2] == collapse.target;
+                        removed += shared;
+                        touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = 1;
+                    }
+                }
+
+                if (removed == 0)
+                {
+                    break;
+                }
+
+                size_t write = 0;
+                for (size_t i = 0; i < m_Indices.size(); i += 3)
+                {
+                    uint32_t a = remap[m_Indices[i]], b = remap[m_Indices[i + 1]], c = remap[m_Indices[i + 2]];
+                    if (a != b && b != c && a != c)
+                    {
+                        m_Indices[write++] = a;
+                        m_Indices[write++] = b;
+                        m_Indices[write++] = c;
+                    }
+                }
+                m_Indices.resize(write);
+            }
+
+            for (uint32_t& index : m_Indices)
+            {
+                index = m_Vertices[index];
+            }
+            return static_cast<float>(std::sqrt(reached));
+        }
+
+    private:
+        bool IsBorderEdge(uint32_t a, uint32_t b) const
+        {
+            return std::binary_search(m_BorderEdges.begin(), m_BorderEdges.end(), EdgeKey(a, b));
+        }
+
+        template<typename Collapse>
+        void Consider(uint32_t source, uint32_t target, Collapse& best) const
+        {
+            if (m_Locked[source] || (m_Border[source] && !IsBorderEdge(source, target)))
+            {
+                return;
+            }
+
+            double distance = m_Quadrics[source].Evaluate(m_Positions[target]);
+            double cost = distance;
+            if (m_Mesh.input.attributeCount)
+            {
+                cost += m_Mesh.GetAttributeDistance(m_Vertices[source], m_Vertices[target]);
+            }
+            if (best.source == UINT32_MAX || cost < best.cost)
+            {
+                best = { source, target, cost, distance };
+            }
+        }
+
+        bool IsValid(uint32_t source, uint32_t target) const
+        {
+            for (uint32_t a = m_AdjacencyOffsets[source]; a < m_AdjacencyOffsets[source + 1]; ++a)
+            {
+                const uint32_t* triangle = &m_Indices[m_Adjacency[a] * 3];
+                if (triangle[0] == target || triangle[1] == target || triangle[2] == target)
+                {
+                    continue;   // collapses away
+                }
+
+                Vector3 p[3], moved[3];
+                for (int v = 0; v < 3; ++v)
+                {
+                    p[v] = m_Positions[triangle[v]];
+                    moved[v] = triangle[v] == source ? m_Positions[target] : p[v];
+                }
+                // Turning a triangle by more than about 60 degrees is a fold,
+                // even short of flipping it; small turns add up over passes.
+                Vector3 before = Cross(p[1] - p[0], p[2] - p[0]);
+                Vector3 after = Cross(moved[1] - moved[0], moved[2] - moved[0]);
+                if (Dot(before, after) <= c_MaxTurnCosine * Length(before) * Length(after))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void BuildAdjacency()
+        {
+            uint32_t vertexCount = static_cast<uint32_t>(m_Vertices.size());
+            m_AdjacencyOffsets.assign(vertexCount + 1, 0);
+            for (uint32_t index : m_Indices)
+            {
+                ++m_AdjacencyOffsets[index + 1];
+            }
+            for (uint32_t v = 0; v < vertexCount; ++v)
+            {
+                m_AdjacencyOffsets[v + 1] += m_AdjacencyOffsets[v];
+            }
+            m_Adjacency.resize(m_Indices.size());
+            std::vector<uint32_t> cursor(m_AdjacencyOffsets.begin(), m_AdjacencyOffsets.end() - 1);
+            for (size_t i = 0; i < m_Indices.size(); ++i)
+            {
+                m_Adjacency[cursor[m_Indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        const Mesh& m_Mesh;
+        std::vector<uint32_t>& m_Indices;   // local ids while running
+
+        std::vector<uint32_t> m_Vertices;   // local -> mesh vertex id
+        std::vector<Vector3> m_Positions;
+        std::vector<uint8_t> m_Locked;
+        std::vector<uint8_t> m_Border;
+        std::vector<Quadric> m_Quadrics;
+        std::vector<uint64_t> m_BorderEdges;
+
+        std::vector<uint32_t> m_AdjacencyOffsets;
+        std::vector<uint32_t> m_Adjacency;
+    };
+
+    void FindSeams(Mesh& mesh)
+    {
+        const SimplifyInput& input = mesh.input;
+        mesh.seams.assign(input.vertexCount, 0);
+
+        struct PositionHash
+        {
+            size_t operator()(const std::array<uint32_t, 3>& p) const { return p[0] * 73856093u ^ p[1] * 19349663u ^ p[2] * 83492791u; }
+        };
+        std::unordered_map<std::array<uint32_t, 3>, uint32_t, PositionHash> first;
+        first.reserve(input.vertexCount);
+        for (uint32_t v = 0; v < input.vertexCount; ++v)
+        {
+            std::array<uint32_t, 3> key;
+            memcpy(key.data(), static_cast<const uint8_t*>(input.vertices) + static_cast<size_t>(v) * input.vertexStride, sizeof(key));
+            auto inserted = first.emplace(key, v);
+            if (!inserted.second)
+            {
+                mesh.seams[v] = 1;
+                mesh.seams[inserted.first->second] = 1;
+            }
+        }
+    }
+}
+
+uint32_t SimplifyMesh(const SimplifyInput& input, const std::vector<uint32_t>& indices, uint32_t targetIndexCount,
+    float maxError, JobSystem* jobSystem, std::vector<uint32_t>& result, float* error)
+{
+    Mesh mesh(input);
+    FindSeams(mesh);
+
+    std::vector<uint8_t> noLocks(input.vertexCount, 0);
+    uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    float reached = 0.0f;
+    result = indices;
+
+    if (jobSystem && triangleCount >= c_ChunkTriangles * 2)
+    {
+        // Grid of roughly c_ChunkTriangles per cell over triangle centers.
+        Vector3 boxMin = mesh.GetPosition(indices[0]), boxMax = boxMin;
+        for (uint32_t index : indices)
+        {
+            Vector3 p = mesh.GetPosition(index);
+            boxMin = { std::min(boxMin.x, p.x), std::min(boxMin.y, p.y), std::min(boxMin.z, p.z) };
+            boxMax = { std::max(boxMax.x, p.x), std::max(boxMax.y, p.y), std::max(boxMax.z, p.z) };
+        }
+        uint32_t cellsPerAxis = std::max(1u, static_cast<uint32_t>(std::cbrt(double(triangleCount) / c_ChunkTriangles)));
+        Vector3 extent = boxMax - boxMin;
+
+        std::vector<std::vector<uint32_t>> chunks(cellsPerAxis * cellsPerAxis * cellsPerAxis);
+        std::vector<uint32_t> owner(input.vertexCount, UINT32_MAX);
+        std::vector<uint8_t> shared(input.vertexCount, 0);
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            Vector3 center = (mesh.GetPosition(indices[i]) + mesh.GetPosition(indices[i + 1]) + mesh.GetPosition(indices[i + 2])) * (1.0 / 3.0);
+            auto cell = [&](double value, double low, double size)
+            {
+                return size > 0 ? std::min(cellsPerAxis - 1, static_cast<uint32_t>((value - low) / size * cellsPerAxis)) : 0u;
+            };
+            uint32_t chunk = cell(center.x, boxMin.x, extent.x) +
+                cellsPerAxis * (cell(center.y, boxMin.y, extent.y) + cellsPerAxis * cell(center.z, boxMin.z, extent.z));
+            chunks[chunk].insert(chunks[chunk].end(), &indices[i], &indices[i] + 3);
+
+            for (int v = 0; v < 3; ++v)
+            {
+                uint32_t& vertexOwner = owner[indices[i + v]];
+                if (vertexOwner != UINT32_MAX && vertexOwner != chunk)
+                {
+                    shared[indices[i + v]] = 1;
+                }
+                vertexOwner = chunk;
+            }
+        }
+
+        // Chunks only touch their own triangles; shared vertices are locked
+        // so the pieces still meet.
+        double ratio = double(targetIndexCount) / indices.size();
+        std::vector<float> chunkErrors(chunks.size(), 0.0f);
+        jobSystem->ParallelFor(static_cast<uint32_t>(chunks.size()), 1, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t chunk = begin; chunk < end; ++chunk)
+            {
+                if (chunks[chunk].empty())
+                {
+                    continue;
+                }
+                uint32_t target = static_cast<uint32_t>(chunks[chunk].size() * ratio) / 3 * 3;
+                Simplifier simplifier(mesh, shared, chunks[chunk]);
+                chunkErrors[chunk] = simplifier.Run(target, maxError);
+            }
+        });
+
+        result.clear();
+        for (size_t chunk = 0; chunk < chunks.size(); ++chunk)
+        {
+            result.insert(result.end(), chunks[chunk].begin(), chunks[chunk].end());
+            reached = std::max(reached, chunkErrors[chunk]);
+        }
+    }
+
+    // Whole mesh (or the joined chunks, with their seams now free).
+    if (result.size() > targetIndexCount)
+    {
+        Simplifier simplifier(mesh, noLocks, result);
+        reached = std::max(reached, simplifier.Run(targetIndexCount, maxError));
+    }
+
+    if (error)
+    {
+        *error = reached;
+    }
+    return static_cast<uint32_t>(result.size());
+}
+
+void BuildLodChain(const SimplifyInput& input, const std::vector<uint32_t>& indices, uint32_t maxLods, float reduction,
+    JobSystem* jobSystem, std::vector<MeshLod>& lods)
+{
+    lods.clear();
+    lods.push_back({ indices, 0.0f });
+
+    while (lods.size() < maxLods)
+    {
+        const MeshLod& previous = lods.back();
+        uint32_t target = static_cast<uint32_t>(previous.indices.size() * reduction) / 3 * 3;
+
+        MeshLod lod;
+        float error = 0.0f;
+        SimplifyMesh(input, previous.indices, target, FLT_MAX, jobSystem, lod.indices, &error);
+
+        // Stop once a level no longer shrinks meaningfully.
+        if (lod.indices.empty() || lod.indices.size() > previous.indices.size() * (1.0f + reduction) * 0.5f)
+        {
+            break;
+        }
+
+        // Errors are measured against the previous level; accumulate them so
+        // each level's value bounds its deviation from LOD 0.
+        lod.error = previous.error + error;
+        lods.push_back(std::move(lod));
+    }
+}
+
+float GetLodProjectionScale(float fovY, float viewportHeight)
+{
+    return viewportHeight / (2.0f * std::tan(fovY * 0.5f));
+}
+
+uint32_t SelectLod(const float* errors, uint32_t lodCount, float distance, float projectionScale, float maxPixelError)
+{
+    // error * scale / distance <= maxPixelError, without the division.
+    float limit = maxPixelError * std::max(distance, 1e-6f) / projectionScale;
+    uint32_t lod = 0;
+    while (lod + 1 < lodCount && errors[lod + 1] <= limit)
+    {
+        ++lod;
+    }
+    return lod;
+}
+
+void SelectLods(const float* errors, uint32_t lodCount, const float* distances, uint32_t instanceCount,
+    float projectionScale, float maxPixelError, uint8_t* lods)
+{
+    for (uint32_t i = 0; i < instanceCount; ++i)
+    {
+        lods[i] = static_cast<uint8_t>(SelectLod(errors, lodCount, distances[i], projectionScale, maxPixelError));
+    }
+}
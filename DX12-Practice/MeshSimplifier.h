@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+// Vertex data for the simplifier: a float3 position at the start of each
+// vertex and, optionally, attributeCount floats at attributeOffset (normals,
+// UVs, ...) that are weighted into the collapse cost.
+struct SimplifyInput
+{
+    const void* vertices = nullptr;
+    uint32_t vertexStride = 0;
+    uint32_t vertexCount = 0;
+    uint32_t attributeOffset = 0;           // bytes
+    uint32_t attributeCount = 0;
+    const float* attributeWeights = nullptr; // attributeCount entries; 1 if null
+};
+
+// Quadric error metric simplification by edge collapse onto existing
+// vertices, so every LOD indexes the same vertex buffer. Open borders only
+// collapse along themselves and attribute seams (vertices sharing a position)
+// are kept, so the silhouette and UV/normal splits survive. Collapses that
+// would flip a triangle are rejected.
+//
+// Large meshes are split into spatial chunks simplified in parallel with
+// their shared vertices locked, followed by a pass over the joined result.
+//
+// maxError bounds the collapse cost (geometric distance plus weighted
+// attribute distance). Returns the reached index count; error receives the
+// largest geometric collapse error as an object-space distance.
+uint32_t SimplifyMesh(const SimplifyInput& input, const std::vector<uint32_t>& indices, uint32_t targetIndexCount,
+    float maxError, JobSystem* jobSystem, std::vector<uint32_t>& result, float* error = nullptr);
+
+struct MeshLod
+{
+    std::vector<uint32_t> indices;
+    float error;    // object-space deviation from LOD 0
+};
+
+// LOD 0 is the input; each further level targets `reduction` of the previous
+// index count until maxLods levels exist or simplification stalls.
+void BuildLodChain(const SimplifyInput& input, const std::vector<uint32_t>& indices, uint32_t maxLods, float reduction,
+    JobSystem* jobSystem, std::vector<MeshLod>& lods);
+
+// Pixels per object-space unit at distance 1 for a perspective projection.
+float GetLodProjectionScale(float fovY, float viewportHeight);
+
+// Coarsest level whose error, projected at distance, stays within
+// maxPixelError. errors must be ascending (as produced by BuildLodChain).
+uint32_t SelectLod(const float* errors, uint32_t lodCount, float distance, float projectionScale, float maxPixelError = 1.0f);
+
+// Per-instance selection: lods[i] for distances[i].
+void SelectLods(const float* errors, uint32_t lodCount, const float* distances, uint32_t instanceCount,
+    float projectionScale, float maxPixelError, uint8_t* lods);
@@ -0,0 +1,305 @@
+#include "MeshletBuilder.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+    struct Float3
+    {
+        float x, y, z;
+
+        Float3 operator+(const Float3& o) const { return { x + o.x, y + o.y, z + o.z }; }
+        Float3 operator-(const Float3& o) const { return { x - o.x, y - o.y, z - o.z }; }
+        Float3 operator*(float s) const { return { x * s, y * s, z * s }; }
+    };
+
+    float Dot(const Float3& a, const Float3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+    float Length(const Float3& a) { return std::sqrt(Dot(a, a)); }
+    Float3 Cross(const Float3& a, const Float3& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+
+    class Builder
+    {
+    public:
+        Builder(const void* positions, uint32_t stride, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount,
+            uint32_t maxVertices, uint32_t maxTriangles, MeshletData& result)
+            : m_Positions(static_cast<const uint8_t*>(positions))
+            , m_Stride(stride)
+            , m_Indices(indices)
+            , m_TriangleCount(indexCount / 3)
+            , m_MaxVertices(maxVertices)
+            , m_MaxTriangles(maxTriangles)
+            , m_Result(result)
+            , m_LocalIndex(vertexCount, -1)
+            , m_Emitted(m_TriangleCount, 0)
+        {
+            // Vertex -> triangle adjacency in compressed rows.
+            m_AdjacencyOffsets.assign(vertexCount + 1, 0);
+            for (uint32_t i = 0; i < m_TriangleCount * 3; ++i)
+            {
+                ++m_AdjacencyOffsets[indices[i] + 1];
+            }
+            for (uint32_t v = 0; v < vertexCount; ++v)
+            {
+                m_AdjacencyOffsets[v + 1] += m_AdjacencyOffsets[v];
+            }
+            m_Adjacency.resize(m_TriangleCount * 3);
+            m_TriangleCenters.resize(m_TriangleCount);
+            std::vector<uint32_t> cursor(m_AdjacencyOffsets.begin(), m_AdjacencyOffsets.end() - 1);
+            for (uint32_t i = 0; i < m_TriangleCount * 3; ++i)
+            {
+                m_Adjacency[cursor[indices[i]]++] = i / 3;
+            }
+            for (uint32_t triangle = 0; triangle < m_TriangleCount; ++triangle)
+            {
+                m_TriangleCenters[triangle] = (GetPosition(indices[triangle * 3]) + GetPosition(indices[triangle * 3 + 1]) +
+                    GetPosition(indices[triangle * 3 + 2])) * (1.0f / 3.0f);
+            }
+        }
+
+        void Build()
+        {
+            uint32_t seedCursor = 0;
+            for (;;)
+            {
+                uint32_t triangle = FindCandidate();
+                if (triangle == UINT32_MAX)
+                {
+                    // Nothing adjacent fits: continue from the next unused
+                    // triangle in index order, in a new meshlet if needed.
+                    while (seedCursor < m_TriangleCount && m_Emitted[seedCursor])
+                    {
+                        ++seedCursor;
+                    }
+                    if (seedCursor == m_TriangleCount)
+                    {
+                        break;
+                    }
+                    triangle = seedCursor;
+                    if (!Fits(triangle))
+                    {
+                        Flush();
+                    }
+                }
+                Append(triangle);
+            }
+            Flush();
+        }
+
+    private:
+        Float3 GetPosition(uint32_t vertex) const
+        {
+            const float* p = reinterpret_cast<const float*>(m_Positions + static_cast<size_t>(vertex) * m_Stride);
+            return { p[0], p[1], p[2] };
+        }
+
+        uint32_t CountNewVertices(uint32_t triangle) const
+        {
+            uint32_t count = 0;
+            for (int i = 0; i < 3; ++i)
+            {
+                count += m_LocalIndex[m_Indices[triangle * 3 + i]] < 0;
+            }
+            return count;
+        }
+
+        bool Fits(uint32_t triangle) const
+        {
+            return m_Triangles.size() < m_MaxTriangles && m_Vertices.size() + CountNewVertices(triangle) <= m_MaxVertices;
+        }
+
+        uint32_t FindCandidate() const
+        {
+            if (m_Triangles.empty())
+            {
+                return UINT32_MAX;
+            }
+
+            Float3 center = m_CenterSum * (1.0f / m_Vertices.size());
+            uint32_t best = UINT32_MAX;
+            uint32_t bestNew = 4;
+            float bestDistance = FLT_MAX;
+            for (uint32_t vertex : m_Vertices)
+            {
+                for (uint32_t a = m_AdjacencyOffsets[vertex]; a < m_AdjacencyOffsets[vertex + 1]; ++a)
+                {
+                    uint32_t triangle = m_Adjacency[a];
+                    if (m_Emitted[triangle] || !Fits(triangle))
+                    {
+                        continue;
+                    }
+
+                    uint32_t newVertices = CountNewVertices(triangle);
+                    if (newVertices > bestNew)
+                    {
+                        continue;
+                    }
+
+                    Float3 offset = m_TriangleCenters[triangle] - center;
+                    float distance = Dot(offset, offset);
+                    if (newVertices < bestNew || distance < bestDistance)
+                    {
+                        best = triangle;
+                        bestNew = newVertices;
+                        bestDistance = distance;
+                    }
+                }
+            }
+            return best;
+        }
+
+        void Append(uint32_t triangle)
+        {
+            uint32_t local[3];
+            for (int i = 0; i < 3; ++i)
+            {
+                uint32_t vertex = m_Indices[triangle * 3 + i];
+                if (m_LocalIndex[vertex] < 0)
+                {
+                    m_LocalIndex[vertex] = static_cast<int32_t>(m_Vertices.size());
+                    m_Vertices.push_back(vertex);
+                    m_CenterSum = m_CenterSum + GetPosition(vertex);
+                }
+                local[i] = static_cast<uint32_t>(m_LocalIndex[vertex]);
+            }
+            m_Triangles.push_back(local[0] | (local[1] << 10) | (local[2] << 20));
+            m_Emitted[triangle] = 1;
+        }
+
+        void Flush()
+        {
+            if (m_Triangles.empty())
+            {
+                return;
+            }
+
+            Meshlet meshlet = {};
+            meshlet.vertexOffset = static_cast<uint32_t>(m_Result.vertices.size());
+            meshlet.vertexCount = static_cast<uint32_t>(m_Vertices.size());
+            meshlet.primitiveOffset = static_cast<uint32_t>(m_Result.primitives.size());
+            meshlet.primitiveCount = static_cast<uint32_t>(m_Triangles.size());
+            ComputeBounds(meshlet);
+
+            m_Result.meshlets.push_back(meshlet);
+            m_Result.vertices.insert(m_Result.vertices.end(), m_Vertices.begin(), m_Vertices.end());
+            m_Result.primitives.insert(m_Result.primitives.end(), m_Triangles.begin(), m_Triangles.end());
+
+            for (uint32_t vertex : m_Vertices)
+            {
+                m_LocalIndex[vertex] = -1;
+            }
+            m_Vertices.clear();
+            m_Triangles.clear();
+            m_CenterSum = { 0.0f, 0.0f, 0.0f };
+        }
+
+        void ComputeBounds(Meshlet& meshlet) const
+        {
+            // Sphere around the box center; cheap and close enough for culling.
+            Float3 boxMin = { FLT_MAX, FLT_MAX, FLT_MAX };
+            Float3 boxMax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+            for (uint32_t vertex : m_Vertices)
+            {
+                Float3 p = GetPosition(vertex);
+                boxMin = { std::min(boxMin.x, p.x), std::min(boxMin.y, p.y), std::min(boxMin.z, p.z) };
+                boxMax = { std::max(boxMax.x, p.x), std::max(boxMax.y, p.y), std::max(boxMax.z, p.z) };
+            }
+            Float3 center = (boxMin + boxMax) * 0.5f;
+            float radius = 0.0f;
+            for (uint32_t vertex : m_Vertices)
+            {
+                radius = std::max(radius, Length(GetPosition(vertex) - center));
+            }
+
+            // Normal cone: the axis is the average face normal and the spread
+            // is the smallest cosine between the axis and any face normal.
+            std::vector<Float3> normals;
+            normals.reserve(m_Triangles.size());
+            Float3 axis = { 0.0f, 0.0f, 0.0f };
+            for (uint32_t packed : m_Triangles)
+            {
+                Float3 a = GetPosition(m_Vertices[packed & 1023]);
+                Float3 b = GetPosition(m_Vertices[(packed >> 10) & 1023]);
+                Float3 c = GetPosition(m_Vertices[(packed >> 20) & 1023]);
+                Float3 normal = Cross(b - a, c - a);
+                float length = Length(normal);
+                if (length > 0.0f)
+                {
+                    normals.push_back(normal * (1.0f / length));
+                    axis = axis + normals.back();
+                }
+            }
+
+            float axisLength = Length(axis);
+            float minDot = 1.0f;
+            if (axisLength > 0.0f)
+            {
+                axis = axis * (1.0f / axisLength);
+                for (const auto& normal : normals)
+                {
+                    minDot = std::min(minDot, Dot(normal, axis));
+                }
+            }
+            else
+            {
+                minDot = -1.0f;
+            }
+
+            meshlet.sphere[0] = center.x;
+            meshlet.sphere[1] = center.y;
+            meshlet.sphere[2] = center.z;
+            meshlet.sphere[3] = radius;
+            meshlet.coneAxis[0] = axis.x;
+            meshlet.coneAxis[1] = axis.y;
+            meshlet.coneAxis[2] = axis.z;
+
+            // Cone wider than a hemisphere (or nearly): never cull. Otherwise
+            // the cluster is back-facing when the view direction lies within
+            // 90 - halfAngle degrees of the axis: cutoff = sin(halfAngle).
+            meshlet.coneCutoff = minDot <= 0.1f ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+            if (minDot <= 0.1f)
+            {
+                meshlet.coneAxis[0] = meshlet.coneAxis[1] = meshlet.coneAxis[2] = 0.0f;
+            }
+        }
+
+        const uint8_t* m_Positions;
+        uint32_t m_Stride;
+        const uint32_t* m_Indices;
+        uint32_t m_TriangleCount;
+        uint32_t m_MaxVertices;
+        uint32_t m_MaxTriangles;
+        MeshletData& m_Result;
+
+        std::vector<uint32_t> m_AdjacencyOffsets;
+        std::vector<uint32_t> m_Adjacency;
+        std::vector<Float3> m_TriangleCenters;
+        std::vector<int32_t> m_LocalIndex;      // vertex -> index in the open meshlet
+        std::vector<uint8_t> m_Emitted;
+
+        std::vector<uint32_t> m_Vertices;       // open meshlet
+        std::vector<uint32_t> m_Triangles;
+        Float3 m_CenterSum = { 0.0f, 0.0f, 0.0f };
+    };
+}
+
+void BuildMeshlets(const void* positions, uint32_t vertexStride, uint32_t vertexCount,
+    const uint32_t* indices, uint32_t indexCount, MeshletData& result, uint32_t maxVertices, uint32_t maxTriangles)
+{
+    assert(maxVertices <= 1024 && maxTriangles > 0 && maxVertices >= 3);
+    result.meshlets.clear();
+    result.vertices.clear();
+    result.primitives.clear();
+
+    Builder builder(positions, vertexStride, vertexCount, indices, indexCount, maxVertices, maxTriangles, result);
+    builder.Build();
+}
+
+void SetMeshFileMeshlets(MeshFileData& fileData, const MeshletData& data)
+{
+    fileData.meshlets = data.meshlets;
+    fileData.meshletVertices = data.vertices;
+    fileData.meshletPrimitives = data.primitives;
+}
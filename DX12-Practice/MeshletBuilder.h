@@ -0,0 +1,31 @@
+#pragma once
+#include "MeshFile.h"
+
+#include <cstdint>
+#include <vector>
+
+// Meshlet limits; 124 triangles keeps the primitive output of a 128-thread
+// mesh shader group within one wave-friendly block.
+const uint32_t c_MeshletMaxVertices = 64;
+const uint32_t c_MeshletMaxTriangles = 124;
+
+struct MeshletData
+{
+    std::vector<Meshlet> meshlets;
+    std::vector<uint32_t> vertices;     // per meshlet: indices into the vertex buffer
+    std::vector<uint32_t> primitives;   // per triangle: local i0 | i1 << 10 | i2 << 20
+};
+
+// Splits an indexed triangle list into meshlets. Each meshlet grows from a
+// seed triangle by repeatedly adding the adjacent triangle that brings in
+// the fewest new vertices (ties go to the one nearest the meshlet center),
+// so meshlets stay spatially compact and share few vertices. Bounding
+// spheres and normal cones are computed for cluster culling.
+//
+// positions: float3 at the start of each vertex, vertexStride bytes apart.
+void BuildMeshlets(const void* positions, uint32_t vertexStride, uint32_t vertexCount,
+    const uint32_t* indices, uint32_t indexCount, MeshletData& result,
+    uint32_t maxVertices = c_MeshletMaxVertices, uint32_t maxTriangles = c_MeshletMaxTriangles);
+
+// Copies the meshlet tables into the cooker's input.
+void SetMeshFileMeshlets(MeshFileData& fileData, const MeshletData& data);
@@ -0,0 +1,124 @@
+#include "MeshletPass.h"
+#include "GpuMesh.h"
+#include "HlslLayout.h"
+#include "RootSignatureCache.h"
+#include "ShaderCache.h"
+#include "ShaderReflection.h"
+
+namespace
+{
+    // Root parameter indices come from the reflected layout, by binding name.
+    const char* const c_BindingNames[MeshletPass::NumBindings] = {
+        "ViewConstants", "DrawConstants", "g_Vertices", "g_Meshlets", "g_MeshletVertices", "g_MeshletPrimitives",
+    };
+
+    const uint32_t c_MeshletsPerGroup = 32;
+
+    constexpr HlslField c_ViewConstantFields[] = { HlslFloat4x4, HlslArray(HlslFloat4, 6), HlslFloat3 };
+    static_assert(VerifyHlslLayout<MeshletViewConstants>(c_ViewConstantFields, {
+        HLSL_MEMBER(MeshletViewConstants, viewProjection),
+        HLSL_MEMBER(MeshletViewConstants, planes),
+        HLSL_MEMBER(MeshletViewConstants, cameraPosition) }), "MeshletViewConstants does not match ViewConstants");
+}
+
+bool MeshletPass::IsSupported(ID3D12Device2* device)
+{
+    D3D12_FEATURE_DATA_D3D12_OPTIONS7 options = {};
+    return SUCCEEDED(device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS7, &options, sizeof(options))) &&
+        options.MeshShaderTier != D3D12_MESH_SHADER_TIER_NOT_SUPPORTED;
+}
+
+bool MeshletPass::Init(ShaderCache& shaderCache, PipelineStateCache& pipelineStateCache, RootSignatureCache& rootSignatureCache,
+    DXGI_FORMAT renderTargetFormat, DXGI_FORMAT depthStencilFormat)
+{
+    ShaderDesc shaderDescs[3];
+    const char* entryPoints[3] = { "ASMain", "MSMain", "PSMain" };
+    const char* targets[3] = { "as_6_5", "ms_6_5", "ps_6_5" };
+    ShaderHandle shaders[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        shaderDescs[i].path = "shaders/MeshletRender.hlsl";
+        shaderDescs[i].entryPoint = entryPoints[i];
+        shaderDescs[i].target = targets[i];
+        shaders[i] = shaderCache.Request(shaderDescs[i]);
+    }
+
+    const std::vector<uint8_t>* bytecode[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        shaderCache.Wait(shaders[i]);
+        bytecode[i] = shaderCache.GetBytecode(shaders[i]);
+        if (!bytecode[i])
+        {
+            OutputDebugStringA(shaderCache.GetErrors(shaders[i]).c_str());
+            return false;
+        }
+    }
+
+    // Buffers are bound by address, so they become root descriptors.
+    ShaderLayoutPolicy policy;
+    policy.rootDescriptors = true;
+    ShaderBindingLayout layout;
+    if (!GetShaderBindingLayout(shaderCache,
+        { { shaders[0], ShaderStageAmplification }, { shaders[1], ShaderStageMesh }, { shaders[2], ShaderStagePixel } },
+        layout, policy))
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < NumBindings; ++i)
+    {
+        const ShaderBindingLocation* location = layout.Find(c_BindingNames[i]);
+        if (!location)
+        {
+            OutputDebugStringA((std::string("MeshletRender.hlsl does not use ") + c_BindingNames[i] + "\n").c_str());
+            return false;
+        }
+        m_RootIndices[i] = location->rootIndex;
+    }
+    m_RootSignature = CreateRootSignature(rootSignatureCache, layout);
+    if (!m_RootSignature)
+    {
+        return false;
+    }
+
+    D3DX12_MESH_SHADER_PIPELINE_STATE_DESC pipelineDesc = {};
+    pipelineDesc.pRootSignature = m_RootSignature;
+    pipelineDesc.AS = CD3DX12_SHADER_BYTECODE(bytecode[0]->data(), bytecode[0]->size());
+    pipelineDesc.MS = CD3DX12_SHADER_BYTECODE(bytecode[1]->data(), bytecode[1]->size());
+    pipelineDesc.PS = CD3DX12_SHADER_BYTECODE(bytecode[2]->data(), bytecode[2]->size());
+    pipelineDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+    pipelineDesc.SampleMask = UINT_MAX;
+    pipelineDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+    pipelineDesc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+    pipelineDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    pipelineDesc.NumRenderTargets = 1;
+    pipelineDesc.RTVFormats[0] = renderTargetFormat;
+    pipelineDesc.DSVFormat = depthStencilFormat;
+    pipelineDesc.SampleDesc = DefaultSampleDesc();
+
+    CD3DX12_PIPELINE_MESH_STATE_STREAM stream(pipelineDesc);
+    m_PipelineStateCache = &pipelineStateCache;
+    m_Pipeline = pipelineStateCache.Request(stream);
+    return true;
+}
+
+void MeshletPass::Draw(ID3D12GraphicsCommandList6* commandList, const GpuMesh& mesh, uint32_t vertexStride,
+    D3D12_GPU_VIRTUAL_ADDRESS viewConstants)
+{
+    auto pipelineState = m_PipelineStateCache->Get(m_Pipeline);
+    if (!pipelineState || mesh.meshletCount == 0)
+    {
+        return;
+    }
+
+    commandList->SetPipelineState(pipelineState);
+    commandList->SetGraphicsRootSignature(m_RootSignature);
+    commandList->SetGraphicsRootConstantBufferView(m_RootIndices[ViewConstants], viewConstants);
+    uint32_t drawConstants[2] = { mesh.meshletCount, vertexStride };
+    commandList->SetGraphicsRoot32BitConstants(m_RootIndices[DrawConstants], _countof(drawConstants), drawConstants, 0);
+    commandList->SetGraphicsRootShaderResourceView(m_RootIndices[Vertices], mesh.vertexBuffer->GetGPUVirtualAddress());
+    commandList->SetGraphicsRootShaderResourceView(m_RootIndices[Meshlets], mesh.meshletBuffer->GetGPUVirtualAddress());
+    commandList->SetGraphicsRootShaderResourceView(m_RootIndices[MeshletVertices], mesh.meshletVertexBuffer->GetGPUVirtualAddress());
+    commandList->SetGraphicsRootShaderResourceView(m_RootIndices[MeshletPrimitives], mesh.meshletPrimitiveBuffer->GetGPUVirtualAddress());
+    commandList->DispatchMesh((mesh.meshletCount + c_MeshletsPerGroup - 1) / c_MeshletsPerGroup, 1, 1);
+}
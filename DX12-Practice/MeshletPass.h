@@ -0,0 +1,64 @@
+#pragma once
+#include "Win.h"
+#include <wrl/client.h>
+
+#include "directx/d3dx12.h"
+
+#include "PipelineStateCache.h"
+
+#include <cstdint>
+
+class RootSignatureCache;
+class ShaderCache;
+struct GpuMesh;
+
+// Constant buffer bound at b0 (shaders/MeshletRender.hlsl). viewProjection is
+// row-major in DirectXMath convention (declared row_major in HLSL); planes
+// can be copied from Frustum::FromViewProjection.
+struct MeshletViewConstants
+{
+    float viewProjection[4][4];
+    float planes[6][4];         // normals pointing inwards
+    float cameraPosition[3];
+    float padding;
+};
+
+// Mesh-shader draw path for meshlet meshes (see MeshletBuilder). An
+// amplification shader culls 32 meshlets per group against the frustum and
+// their normal cones; the mesh shader expands the survivors. Requires mesh
+// shader support (D3D12_FEATURE_D3D12_OPTIONS7) and a shader model 6.5
+// compiler; callers keep their vertex shader path otherwise. The root
+// signature is generated from the shaders (see ShaderReflection).
+class MeshletPass
+{
+public:
+    // Bindings of shaders/MeshletRender.hlsl.
+    enum Binding
+    {
+        ViewConstants,      // b0
+        DrawConstants,      // b1: meshlet count, vertex stride
+        Vertices,           // t0
+        Meshlets,           // t1
+        MeshletVertices,    // t2
+        MeshletPrimitives,  // t3
+        NumBindings
+    };
+
+    static bool IsSupported(ID3D12Device2* device);
+
+    bool Init(ShaderCache& shaderCache, PipelineStateCache& pipelineStateCache, RootSignatureCache& rootSignatureCache,
+        DXGI_FORMAT renderTargetFormat, DXGI_FORMAT depthStencilFormat);
+
+    // False until the pipeline has compiled.
+    bool IsReady() const { return m_PipelineStateCache && m_PipelineStateCache->IsReady(m_Pipeline); }
+
+    // viewConstants: GPU address of a MeshletViewConstants buffer.
+    void Draw(ID3D12GraphicsCommandList6* commandList, const GpuMesh& mesh, uint32_t vertexStride,
+        D3D12_GPU_VIRTUAL_ADDRESS viewConstants);
+
+private:
+    PipelineStateCache* m_PipelineStateCache = nullptr;
+    PipelineStateHandle m_Pipeline;
+    ID3D12RootSignature* m_RootSignature = nullptr;     // generated from the shaders' bindings
+    UINT m_RootIndices[NumBindings] = {};
+};
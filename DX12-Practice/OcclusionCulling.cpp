@@ -0,0 +1,370 @@
+#include "OcclusionCulling.h"
+#include "FrustumCulling.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OCCLUSION_SSE2 1
+#endif
+
+namespace
+{
+    const float c_MinW = 1e-4f;
+
+    void Transform(const float v[3], const float m[4][4], float out[4])
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            out[c] = v[0] * m[0][c] + v[1] * m[1][c] + v[2] * m[2][c] + m[3][c];
+        }
+    }
+
+    void Multiply(const float a[4][4], const float b[4][4], float out[4][4])
+    {
+        for (int r = 0; r < 4; ++r)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                out[r][c] = a[r][0] * b[0][c] + a[r][1] * b[1][c] + a[r][2] * b[2][c] + a[r][3] * b[3][c];
+            }
+        }
+    }
+
+    // Edge function coefficients: e(p) = a * p.x + b * p.y + c, positive
+    // inside for a triangle with positive area.
+    struct Edge
+    {
+        float a, b, c;
+    };
+
+    Edge MakeEdge(float x0, float y0, float x1, float y1)
+    {
+        Edge edge;
+        edge.a = -(y1 - y0);
+        edge.b = x1 - x0;
+        edge.c = -(edge.a * x0 + edge.b * y0);
+        return edge;
+    }
+}
+
+OcclusionBuffer::OcclusionBuffer(uint32_t width, uint32_t height)
+    : m_Width((width + c_BinSize - 1) / c_BinSize * c_BinSize)
+    , m_Height((height + c_BinSize - 1) / c_BinSize * c_BinSize)
+{
+    m_TilesX = m_Width / c_TileSize;
+    m_TilesY = m_Height / c_TileSize;
+    m_Depth.resize(m_Width * m_Height, 1.0f);
+    m_TileMaxDepth.resize(m_TilesX * m_TilesY, 1.0f);
+    memset(m_ViewProjection, 0, sizeof(m_ViewProjection));
+}
+
+void OcclusionBuffer::Begin(const float viewProjection[4][4])
+{
+    memcpy(m_ViewProjection, viewProjection, sizeof(m_ViewProjection));
+    m_Triangles.clear();
+}
+
+void OcclusionBuffer::AddOccluder(const void* positions, uint32_t stride, const uint32_t* indices, uint32_t indexCount,
+    const float world[4][4])
+{
+    float matrix[4][4];
+    if (world)
+    {
+        Multiply(world, m_ViewProjection, matrix);
+    }
+    else
+    {
+        memcpy(matrix, m_ViewProjection, sizeof(matrix));
+    }
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(positions);
+    float halfWidth = m_Width * 0.5f;
+    float halfHeight = m_Height * 0.5f;
+
+    for (uint32_t i = 0; i + 2 < indexCount; i += 3)
+    {
+        Triangle triangle;
+        bool clipped = false;
+        for (int v = 0; v < 3; ++v)
+        {
+            const float* position = reinterpret_cast<const float*>(bytes + static_cast<size_t>(indices[i + v]) * stride);
+            float clip[4];
+            Transform(position, matrix, clip);
+            if (clip[3] < c_MinW || clip[2] < 0.0f)
+            {
+                clipped = true;
+                break;
+            }
+
+            float invW = 1.0f / clip[3];
+            triangle.x[v] = (clip[0] * invW + 1.0f) * halfWidth;
+            triangle.y[v] = (1.0f - clip[1] * invW) * halfHeight;
+            triangle.z[v] = clip[2] * invW;
+        }
+        if (clipped)
+        {
+            continue;
+        }
+
+        // Occluders are treated as double sided; wind everything one way.
+        float area = (triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0])
+            - (triangle.y[1] - triangle.y[0]) * (triangle.x[2] - triangle.x[0]);
+        if (area == 0.0f)
+        {
+            continue;
+        }
+        if (area < 0.0f)
+        {
+            std::swap(triangle.x[1], triangle.x[2]);
+            std::swap(triangle.y[1], triangle.y[2]);
+            std::swap(triangle.z[1], triangle.z[2]);
+        }
+
+        triangle.minX = std::min({ triangle.x[0], triangle.x[1], triangle.x[2] });
+        triangle.maxX = std::max({ triangle.x[0], triangle.x[1], triangle.x[2] });
+        triangle.minY = std::min({ triangle.y[0], triangle.y[1], triangle.y[2] });
+        triangle.maxY = std::max({ triangle.y[0], triangle.y[1], triangle.y[2] });
+        if (triangle.maxX < 0.0f || triangle.maxY < 0.0f || triangle.minX >= m_Width || triangle.minY >= m_Height)
+        {
+            continue;
+        }
+        m_Triangles.push_back(triangle);
+    }
+}
+
+void OcclusionBuffer::Rasterize(JobSystem* jobSystem)
+{
+    uint32_t binsX = m_Width / c_BinSize;
+    uint32_t binCount = binsX * (m_Height / c_BinSize);
+
+    // Bins own disjoint pixels and tiles, so they need no synchronization.
+    // Occluder sets are small; each bin scans every triangle's bounds.
+    auto rasterizeBins = [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t bin = begin; bin < end; ++bin)
+        {
+            RasterizeBin(bin % binsX, bin / binsX);
+        }
+    };
+
+    if (jobSystem)
+    {
+        jobSystem->ParallelFor(binCount, 1, rasterizeBins);
+    }
+    else
+    {
+        rasterizeBins(0, binCount);
+    }
+}
+
+void OcclusionBuffer::RasterizeBin(uint32_t binX, uint32_t binY)
+{
+    int x0 = static_cast<int>(binX * c_BinSize);
+    int y0 = static_cast<int>(binY * c_BinSize);
+    int x1 = x0 + static_cast<int>(c_BinSize);
+    int y1 = y0 + static_cast<int>(c_BinSize);
+
+    for (int y = y0; y < y1; ++y)
+    {
+        std::fill_n(&m_Depth[y * m_Width + x0], c_BinSize, 1.0f);
+    }
+
+    for (const auto& triangle : m_Triangles)
+    {
+        if (triangle.maxX < x0 || triangle.minX >= x1 || triangle.maxY < y0 || triangle.minY >= y1)
+        {
+            continue;
+        }
+
+        // Pixel rows/columns whose centers may be covered, clamped to the bin;
+        // the column start is aligned to 4 for the SIMD loop.
+        int minX = std::max(x0, static_cast<int>(std::floor(triangle.minX - 0.5f))) & ~3;
+        int maxX = std::min(x1, static_cast<int>(std::ceil(triangle.maxX + 0.5f)));
+        int minY = std::max(y0, static_cast<int>(std::floor(triangle.minY - 0.5f)));
+        int maxY = std::min(y1, static_cast<int>(std::ceil(triangle.maxY + 0.5f)));
+        RasterizeTriangle(triangle, minX, minY, maxX, maxY);
+    }
+
+    for (uint32_t tileY = y0 / c_TileSize; tileY < y1 / c_TileSize; ++tileY)
+    {
+        for (uint32_t tileX = x0 / c_TileSize; tileX < x1 / c_TileSize; ++tileX)
+        {
+            float maxDepth = 0.0f;
+            for (uint32_t y = 0; y < c_TileSize; ++y)
+            {
+                const float* row = &m_Depth[(tileY * c_TileSize + y) * m_Width + tileX * c_TileSize];
+                for (uint32_t x = 0; x < c_TileSize; ++x)
+                {
+                    maxDepth = std::max(maxDepth, row[x]);
+                }
+            }
+            m_TileMaxDepth[tileY * m_TilesX + tileX] = maxDepth;
+        }
+    }
+}
+
+void OcclusionBuffer::RasterizeTriangle(const Triangle& t, int x0, int y0, int x1, int y1)
+{
+    Edge e0 = MakeEdge(t.x[1], t.y[1], t.x[2], t.y[2]);    // weight of vertex 0
+    Edge e1 = MakeEdge(t.x[2], t.y[2], t.x[0], t.y[0]);    // weight of vertex 1
+    Edge e2 = MakeEdge(t.x[0], t.y[0], t.x[1], t.y[1]);    // weight of vertex 2
+
+    // Depth is linear in screen space: z = sum(z_i * e_i) / area.
+    float invArea = 1.0f / (e2.a * t.x[2] + e2.b * t.y[2] + e2.c);
+    Edge z;
+    z.a = (t.z[0] * e0.a + t.z[1] * e1.a + t.z[2] * e2.a) * invArea;
+    z.b = (t.z[0] * e0.b + t.z[1] * e1.b + t.z[2] * e2.b) * invArea;
+    z.c = (t.z[0] * e0.c + t.z[1] * e1.c + t.z[2] * e2.c) * invArea;
+
+#if defined(OCCLUSION_SSE2)
+    const __m128 pixelOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 zero = _mm_setzero_ps();
+    for (int y = y0; y < y1; ++y)
+    {
+        float py = y + 0.5f;
+        __m128 row0 = _mm_set1_ps(e0.b * py + e0.c);
+        __m128 row1 = _mm_set1_ps(e1.b * py + e1.c);
+        __m128 row2 = _mm_set1_ps(e2.b * py + e2.c);
+        __m128 rowZ = _mm_set1_ps(z.b * py + z.c);
+        float* depthRow = &m_Depth[y * m_Width];
+
+        for (int x = x0; x < x1; x += 4)
+        {
+            __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), pixelOffsets);
+            __m128 w0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(e0.a), px), row0);
+            __m128 w1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(e1.a), px), row1);
+            __m128 w2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(e2.a), px), row2);
+            __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(w0, zero), _mm_cmpge_ps(w1, zero)), _mm_cmpge_ps(w2, zero));
+            if (_mm_movemask_ps(inside) == 0)
+            {
+                continue;
+            }
+
+            __m128 depth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(z.a), px), rowZ);
+            __m128 current = _mm_loadu_ps(depthRow + x);
+            __m128 nearest = _mm_min_ps(current, depth);
+            _mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+        }
+    }
+#else
+    for (int y = y0; y < y1; ++y)
+    {
+        float py = y + 0.5f;
+        float* depthRow = &m_Depth[y * m_Width];
+        for (int x = x0; x < x1; ++x)
+        {
+            float px = x + 0.5f;
+            if (e0.a * px + e0.b * py + e0.c >= 0.0f && e1.a * px + e1.b * py + e1.c >= 0.0f && e2.a * px + e2.b * py + e2.c >= 0.0f)
+            {
+                depthRow[x] = std::min(depthRow[x], z.a * px + z.b * py + z.c);
+            }
+        }
+    }
+#endif
+}
+
+bool OcclusionBuffer::IsBoxVisible(const float boxMin[3], const float boxMax[3]) const
+{
+    float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, minZ = FLT_MAX;
+    for (int corner = 0; corner < 8; ++corner)
+    {
+        float position[3] = {
+            (corner & 1) ? boxMax[0] : boxMin[0],
+            (corner & 2) ? boxMax[1] : boxMin[1],
+            (corner & 4) ? boxMax[2] : boxMin[2],
+        };
+        float clip[4];
+        Transform(position, m_ViewProjection, clip);
+        if (clip[3] < c_MinW)
+        {
+            return true;
+        }
+
+        float invW = 1.0f / clip[3];
+        float x = (clip[0] * invW + 1.0f) * m_Width * 0.5f;
+        float y = (1.0f - clip[1] * invW) * m_Height * 0.5f;
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        minZ = std::min(minZ, clip[2] * invW);
+    }
+
+    if (maxX < 0.0f || maxY < 0.0f || minX >= m_Width || minY >= m_Height || minZ > 1.0f)
+    {
+        return false;
+    }
+
+    int x0 = std::max(0, static_cast<int>(minX));
+    int y0 = std::max(0, static_cast<int>(minY));
+    int x1 = std::min(static_cast<int>(m_Width) - 1, static_cast<int>(maxX));
+    int y1 = std::min(static_cast<int>(m_Height) - 1, static_cast<int>(maxY));
+
+    for (int tileY = y0 / static_cast<int>(c_TileSize); tileY <= y1 / static_cast<int>(c_TileSize); ++tileY)
+    {
+        for (int tileX = x0 / static_cast<int>(c_TileSize); tileX <= x1 / static_cast<int>(c_TileSize); ++tileX)
+        {
+            // Every pixel in the tile is nearer than the box.
+            if (minZ > m_TileMaxDepth[tileY * m_TilesX + tileX])
+            {
+                continue;
+            }
+
+            int px0 = std::max(x0, tileX * static_cast<int>(c_TileSize));
+            int px1 = std::min(x1, tileX * static_cast<int>(c_TileSize) + static_cast<int>(c_TileSize) - 1);
+            int py0 = std::max(y0, tileY * static_cast<int>(c_TileSize));
+            int py1 = std::min(y1, tileY * static_cast<int>(c_TileSize) + static_cast<int>(c_TileSize) - 1);
+            for (int y = py0; y <= py1; ++y)
+            {
+                const float* row = &m_Depth[y * m_Width];
+                for (int x = px0; x <= px1; ++x)
+                {
+                    if (minZ <= row[x])
+                    {
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+    return false;
+}
+
+void OcclusionBuffer::FilterVisible(const CullingScene& scene, std::vector<uint32_t>& visible, JobSystem* jobSystem) const
+{
+    std::vector<uint8_t> keep(visible.size());
+    auto testBoxes = [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            float boxMin[3], boxMax[3];
+            scene.GetBox(visible[i], boxMin, boxMax);
+            keep[i] = IsBoxVisible(boxMin, boxMax);
+        }
+    };
+
+    uint32_t count = static_cast<uint32_t>(visible.size());
+    if (jobSystem)
+    {
+        jobSystem->ParallelFor(count, 1024, testBoxes);
+    }
+    else
+    {
+        testBoxes(0, count);
+    }
+
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (keep[i])
+        {
+            visible[kept++] = visible[i];
+        }
+    }
+    visible.resize(kept);
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+class CullingScene;
+class JobSystem;
+
+// Low-resolution software depth buffer for CPU occlusion culling. A small set
+// of occluder meshes is rasterized (nearest depth per pixel, 0 near / 1 far),
+// then occludee boxes are tested against it before draws are submitted. Each
+// 8x8 tile also keeps its farthest depth, so a box behind a whole tile is
+// rejected without touching its pixels.
+//
+// Typical frame:
+//   buffer.Begin(viewProjection);
+//   buffer.AddOccluder(...);            // for each occluder
+//   buffer.Rasterize(&jobSystem);
+//   buffer.FilterVisible(scene, visible, &jobSystem);
+class OcclusionBuffer
+{
+public:
+    static const uint32_t c_TileSize = 8;
+    static const uint32_t c_BinSize = 32;  // raster job granularity in pixels
+
+    // Width and height are rounded up to multiples of c_BinSize.
+    explicit OcclusionBuffer(uint32_t width = 256, uint32_t height = 128);
+
+    // Row-major view-projection in DirectXMath convention (row vectors).
+    void Begin(const float viewProjection[4][4]);
+
+    // positions: world-space float3 at the given stride; world: optional
+    // row-major object-to-world matrix. Triangles that cross the near plane
+    // are dropped, which only makes the result more conservative.
+    void AddOccluder(const void* positions, uint32_t stride, const uint32_t* indices, uint32_t indexCount,
+        const float world[4][4] = nullptr);
+
+    // Rasterizes all occluders, one job per c_BinSize square.
+    void Rasterize(JobSystem* jobSystem);
+
+    // False only if the box is entirely behind rasterized occluders or off
+    // screen. Boxes crossing the near plane are always visible.
+    bool IsBoxVisible(const float boxMin[3], const float boxMax[3]) const;
+
+    // Removes occluded objects from a visible-index list (e.g. the output of
+    // CullingScene::Cull), keeping the order.
+    void FilterVisible(const CullingScene& scene, std::vector<uint32_t>& visible, JobSystem* jobSystem) const;
+
+    uint32_t GetWidth() const { return m_Width; }
+    uint32_t GetHeight() const { return m_Height; }
+    const float* GetDepth() const { return m_Depth.data(); }
+
+private:
+    struct Triangle
+    {
+        float x[3], y[3], z[3];
+        float minX, minY, maxX, maxY;
+    };
+
+    void RasterizeBin(uint32_t binX, uint32_t binY);
+    void RasterizeTriangle(const Triangle& triangle, int x0, int y0, int x1, int y1);
+
+    uint32_t m_Width;
+    uint32_t m_Height;
+    uint32_t m_TilesX;
+    uint32_t m_TilesY;
+    float m_ViewProjection[4][4];
+    std::vector<float> m_Depth;
+    std::vector<float> m_TileMaxDepth;
+    std::vector<Triangle> m_Triangles;
+};
@@ -0,0 +1,193 @@
+#include "PipelineLibrary.h"
+#include "Hash.h"
+
+#include <chrono>
+#include <cstring>
+
+using Microsoft::WRL::ComPtr;
+
+struct PipelineLibrary::FileHeader
+{
+    static const uint32_t c_Magic = 0x4c505844; // 'DXPL'
+    static const uint32_t c_Version = 2;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vendorId;
+    uint32_t deviceId;
+    uint32_t subSysId;
+    uint32_t revision;
+    uint64_t driverVersion;
+    uint64_t blobSize;
+};
+
+PipelineLibrary::~PipelineLibrary()
+{
+    // The library reads from the mapped file; release it first.
+    m_Library.Reset();
+    m_File.Close();
+}
+
+bool PipelineLibrary::Open(ComPtr<ID3D12Device2> device, ComPtr<IDXGIAdapter4> adapter, const std::filesystem::path& path)
+{
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    m_Device = device;
+    m_Path = path;
+
+    DXGI_ADAPTER_DESC1 adapterDesc = {};
+    adapter->GetDesc1(&adapterDesc);
+    m_VendorId = adapterDesc.VendorId;
+    m_DeviceId = adapterDesc.DeviceId;
+    m_SubSysId = adapterDesc.SubSysId;
+    m_Revision = adapterDesc.Revision;
+
+    LARGE_INTEGER umdVersion = {};
+    if (SUCCEEDED(adapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &umdVersion)))
+    {
+        m_DriverVersion = static_cast<uint64_t>(umdVersion.QuadPart);
+    }
+
+    bool warm = false;
+    if (m_File.Open(path) && m_File.GetSize() >= sizeof(FileHeader))
+    {
+        FileHeader header;
+        memcpy(&header, m_File.GetData(), sizeof(header));
+        const uint8_t* blob = m_File.GetData() + sizeof(FileHeader);
+
+        // Reject stale or truncated files before the driver sees them. The
+        // blob is not hashed: that would read the whole file on every warm
+        // start, and CreatePipelineLibrary validates it anyway.
+        warm = header.magic == FileHeader::c_Magic &&
+            header.version == FileHeader::c_Version &&
+            header.vendorId == m_VendorId &&
+            header.deviceId == m_DeviceId &&
+            header.subSysId == m_SubSysId &&
+            header.revision == m_Revision &&
+            header.driverVersion == m_DriverVersion &&
+            header.blobSize == m_File.GetSize() - sizeof(FileHeader);
+
+        // The driver may still refuse the blob (D3D12_ERROR_DRIVER_VERSION_MISMATCH,
+        // D3D12_ERROR_ADAPTER_NOT_FOUND, E_INVALIDARG for a damaged one).
+        warm = warm && CreateLibrary(blob, static_cast<size_t>(header.blobSize));
+    }
+
+    if (!warm)
+    {
+        m_File.Close();
+        if (!CreateLibrary(nullptr, 0))
+        {
+            return false;
+        }
+        // Nothing useful on disk; make sure the next Save() replaces it.
+        m_Dirty = true;
+    }
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Stats.warmStart = warm;
+    m_Stats.openMilliseconds = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    return true;
+}
+
+bool PipelineLibrary::CreateLibrary(const void* blob, size_t size)
+{
+    m_Library.Reset();
+    return SUCCEEDED(m_Device->CreatePipelineLibrary(blob, size, IID_PPV_ARGS(&m_Library)));
+}
+
+HRESULT PipelineLibrary::LoadOrCreate(uint64_t hash, const D3D12_PIPELINE_STATE_STREAM_DESC& streamDesc, ID3D12PipelineState** pipelineState)
+{
+    std::wstring name = L"pso_";
+    for (char c : HashToString(hash))
+    {
+        name += static_cast<wchar_t>(c);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Library && SUCCEEDED(m_Library->LoadPipeline(name.c_str(), &streamDesc, IID_PPV_ARGS(pipelineState))))
+        {
+            ++m_Stats.hits;
+            return S_OK;
+        }
+    }
+
+    // Compile outside the lock so other workers can keep loading.
+    HRESULT hr = m_Device->CreatePipelineState(&streamDesc, IID_PPV_ARGS(pipelineState));
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    ++m_Stats.misses;
+    // E_INVALIDARG here means another worker stored the same name first.
+    if (m_Library && SUCCEEDED(m_Library->StorePipeline(name.c_str(), *pipelineState)))
+    {
+        m_Dirty = true;
+    }
+    return S_OK;
+}
+
+bool PipelineLibrary::Save()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (!m_Library || !m_Dirty)
+    {
+        return true;
+    }
+
+    size_t blobSize = m_Library->GetSerializedSize();
+    std::vector<uint8_t> data(sizeof(FileHeader) + blobSize);
+    if (FAILED(m_Library->Serialize(data.data() + sizeof(FileHeader), blobSize)))
+    {
+        return false;
+    }
+
+    FileHeader header = {};
+    header.magic = FileHeader::c_Magic;
+    header.version = FileHeader::c_Version;
+    header.vendorId = m_VendorId;
+    header.deviceId = m_DeviceId;
+    header.subSysId = m_SubSysId;
+    header.revision = m_Revision;
+    header.driverVersion = m_DriverVersion;
+    header.blobSize = blobSize;
+    memcpy(data.data(), &header, sizeof(header));
+
+    // The current library reads from the mapping, and Windows will not replace
+    // a mapped file, so release both before the rename.
+    m_Library.Reset();
+    m_File.Close();
+    m_Unsaved.clear();
+
+    bool written = WriteFileAtomic(m_Path, data.data(), data.size());
+    if (written && m_File.Open(m_Path) && m_File.GetSize() == data.size())
+    {
+        written = CreateLibrary(m_File.GetData() + sizeof(FileHeader), blobSize);
+    }
+    else
+    {
+        m_File.Close();
+        written = false;
+    }
+
+    if (!written)
+    {
+        // Keep what was stored this session alive from memory.
+        m_Unsaved = std::move(data);
+        CreateLibrary(m_Unsaved.data() + sizeof(FileHeader), blobSize);
+        return false;
+    }
+
+    m_Dirty = false;
+    return true;
+}
+
+PipelineLibraryStats PipelineLibrary::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Stats;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "Win.h"
+#include <wrl/client.h>
+
+#include "directx/d3dx12.h"
+#include <dxgi1_6.h>
+
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <vector>
+
+struct PipelineLibraryStats
+{
+    bool warmStart = false;     // a valid cache file was found and accepted
+    double openMilliseconds = 0.0;
+    uint64_t hits = 0;          // pipelines loaded from the library
+    uint64_t misses = 0;        // pipelines compiled and stored
+};
+
+// Disk-backed ID3D12PipelineLibrary. The cache file is memory-mapped and
+// handed to CreatePipelineLibrary without a copy. The file header records the
+// adapter and user-mode driver version; a mismatch discards the file and the
+// library starts empty. Save() writes the file atomically.
+class PipelineLibrary
+{
+public:
+    PipelineLibrary() = default;
+    ~PipelineLibrary();
+
+    PipelineLibrary(const PipelineLibrary&) = delete;
+    PipelineLibrary& operator=(const PipelineLibrary&) = delete;
+
+    bool Open(Microsoft::WRL::ComPtr<ID3D12Device2> device, Microsoft::WRL::ComPtr<IDXGIAdapter4> adapter, const std::filesystem::path& path);
+
+    // Loads the pipeline stored under hash, or creates it and stores it.
+    // Safe to call from worker threads.
+    HRESULT LoadOrCreate(uint64_t hash, const D3D12_PIPELINE_STATE_STREAM_DESC& streamDesc, ID3D12PipelineState** pipelineState);
+
+    // Serializes the library if anything was stored since it was opened.
+    // Pipelines must not be created while this runs.
+    bool Save();
+
+    PipelineLibraryStats GetStats() const;
+
+private:
+    struct FileHeader;
+
+    bool CreateLibrary(const void* blob, size_t size);
+
+    Microsoft::WRL::ComPtr<ID3D12Device2> m_Device;
+    Microsoft::WRL::ComPtr<ID3D12PipelineLibrary1> m_Library;
+    MappedFile m_File;
+    std::vector<uint8_t> m_Unsaved;
+    std::filesystem::path m_Path;
+
+    uint32_t m_VendorId = 0;
+    uint32_t m_DeviceId = 0;
+    uint32_t m_SubSysId = 0;
+    uint32_t m_Revision = 0;
+    uint64_t m_DriverVersion = 0;
+
+    mutable std::mutex m_Mutex;
+    bool m_Dirty = false;
+    PipelineLibraryStats m_Stats;
+};
@@ -0,0 +1,401 @@
+#include "PipelineStateCache.h"
+#include "Hash.h"
+#include "JobSystem.h"
+#include "PipelineLibrary.h"
+#include "RootSignatureCache.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    // Holds copies of everything the stream points at so that a queued compile
+    // does not depend on the caller's memory.
+    struct StreamStorage
+    {
+        std::vector<uint8_t> stream;
+        std::vector<std::vector<uint8_t>> bytecodes;
+        std::vector<D3D12_INPUT_ELEMENT_DESC> inputElements;
+        std::vector<std::string> semanticNames;
+    };
+
+    // Builds a hash over the pipeline state with every subobject normalized:
+    // defaults filled in, pointers followed, padding skipped.
+    class StreamNormalizer : public ID3DX12PipelineParserCallbacks
+    {
+    public:
+        explicit StreamNormalizer(StreamStorage* storage = nullptr)
+            : m_Storage(storage)
+        {
+            for (auto& hash : m_Shaders)
+            {
+                hash = 0;
+            }
+        }
+
+        uint64_t Finish() const
+        {
+            uint64_t hash = g_HashSeed;
+            hash = HashValue(m_Flags, hash);
+            hash = HashValue(m_NodeMask, hash);
+            hash = HashValue(m_RootSignatureHash, hash);
+            hash = HashValue(m_InputLayout, hash);
+            hash = HashValue(m_StripCut, hash);
+            hash = HashValue(m_Topology, hash);
+            for (auto shader : m_Shaders)
+            {
+                hash = HashValue(shader, hash);
+            }
+            hash = HashValue(m_StreamOutput, hash);
+            hash = HashValue(m_ViewInstancing, hash);
+
+            hash = HashValue<BOOL>(m_Blend.AlphaToCoverageEnable, hash);
+            hash = HashValue<BOOL>(m_Blend.IndependentBlendEnable, hash);
+            UINT blendTargets = m_Blend.IndependentBlendEnable ? D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT : 1;
+            for (UINT i = 0; i < blendTargets; ++i)
+            {
+                const auto& rt = m_Blend.RenderTarget[i];
+                uint32_t fields[] = {
+                    uint32_t(rt.BlendEnable), uint32_t(rt.LogicOpEnable),
+                    uint32_t(rt.SrcBlend), uint32_t(rt.DestBlend), uint32_t(rt.BlendOp),
+                    uint32_t(rt.SrcBlendAlpha), uint32_t(rt.DestBlendAlpha), uint32_t(rt.BlendOpAlpha),
+                    uint32_t(rt.LogicOp), uint32_t(rt.RenderTargetWriteMask),
+                };
+                hash = HashBytes(fields, sizeof(fields), hash);
+            }
+
+            const auto& ds = m_DepthStencil;
+            uint32_t depthFields[] = {
+                uint32_t(ds.DepthEnable), uint32_t(ds.DepthWriteMask), uint32_t(ds.DepthFunc),
+                uint32_t(ds.StencilEnable), uint32_t(ds.StencilReadMask), uint32_t(ds.StencilWriteMask),
+                uint32_t(ds.FrontFace.StencilFailOp), uint32_t(ds.FrontFace.StencilDepthFailOp),
+                uint32_t(ds.FrontFace.StencilPassOp), uint32_t(ds.FrontFace.StencilFunc),
+                uint32_t(ds.BackFace.StencilFailOp), uint32_t(ds.BackFace.StencilDepthFailOp),
+                uint32_t(ds.BackFace.StencilPassOp), uint32_t(ds.BackFace.StencilFunc),
+                uint32_t(ds.DepthBoundsTestEnable),
+            };
+            hash = HashBytes(depthFields, sizeof(depthFields), hash);
+            hash = HashValue(m_DSVFormat, hash);
+
+            // D3D12_RASTERIZER_DESC and DXGI_SAMPLE_DESC are all 32-bit fields.
+            hash = HashValue(m_Rasterizer, hash);
+            hash = HashValue(m_SampleDesc, hash);
+            hash = HashValue(m_SampleMask, hash);
+
+            // The count comes from the caller; the runtime rejects more than 8,
+            // but the array must not be read past its end before that.
+            UINT renderTargets = std::min<UINT>(m_RTVFormats.NumRenderTargets, D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT);
+            hash = HashValue(m_RTVFormats.NumRenderTargets, hash);
+            hash = HashBytes(m_RTVFormats.RTFormats, sizeof(DXGI_FORMAT) * renderTargets, hash);
+            return hash;
+        }
+
+        bool HasError() const { return m_Error; }
+        ID3D12RootSignature* GetRootSignature() const { return m_RootSignature; }
+        // False if the hash depends on this run (a root signature from outside
+        // a RootSignatureCache, hashed by pointer), so it must not name a
+        // pipeline on disk.
+        bool IsPersistent() const { return m_Persistent; }
+
+        void FlagsCb(D3D12_PIPELINE_STATE_FLAGS flags) override { m_Flags = flags; }
+        void NodeMaskCb(UINT nodeMask) override { m_NodeMask = nodeMask; }
+        void RootSignatureCb(ID3D12RootSignature* rootSignature) override
+        {
+            m_RootSignature = rootSignature;
+            m_RootSignatureHash = GetRootSignatureBlobHash(rootSignature);
+            m_Persistent = !rootSignature || m_RootSignatureHash != 0;
+            if (!m_Persistent)
+            {
+                m_RootSignatureHash = HashValue(rootSignature);
+            }
+        }
+        void IBStripCutValueCb(D3D12_INDEX_BUFFER_STRIP_CUT_VALUE value) override { m_StripCut = value; }
+        void PrimitiveTopologyTypeCb(D3D12_PRIMITIVE_TOPOLOGY_TYPE topology) override { m_Topology = topology; }
+
+        void InputLayoutCb(const D3D12_INPUT_LAYOUT_DESC& inputLayout) override
+        {
+            uint64_t hash = HashValue(inputLayout.NumElements);
+            for (UINT i = 0; i < inputLayout.NumElements; ++i)
+            {
+                const auto& element = inputLayout.pInputElementDescs[i];
+                hash = HashString(element.SemanticName, hash);
+                uint32_t fields[] = {
+                    element.SemanticIndex, uint32_t(element.Format), element.InputSlot,
+                    element.AlignedByteOffset, uint32_t(element.InputSlotClass), element.InstanceDataStepRate,
+                };
+                hash = HashBytes(fields, sizeof(fields), hash);
+            }
+            m_InputLayout = hash;
+
+            if (m_Storage && inputLayout.NumElements > 0)
+            {
+                m_Storage->inputElements.assign(inputLayout.pInputElementDescs, inputLayout.pInputElementDescs + inputLayout.NumElements);
+                m_Storage->semanticNames.reserve(inputLayout.NumElements);
+                for (auto& element : m_Storage->inputElements)
+                {
+                    m_Storage->semanticNames.emplace_back(element.SemanticName);
+                    element.SemanticName = m_Storage->semanticNames.back().c_str();
+                }
+                const_cast<D3D12_INPUT_LAYOUT_DESC&>(inputLayout).pInputElementDescs = m_Storage->inputElements.data();
+            }
+        }
+
+        void VSCb(const D3D12_SHADER_BYTECODE& bytecode) override { Shader(0, bytecode); }
+        void PSCb(const D3D12_SHADER_BYTECODE& bytecode) override { Shader(1, bytecode); }
+        void DSCb(const D3D12_SHADER_BYTECODE& bytecode) override { Shader(2, bytecode); }
+        void HSCb(const D3D12_SHADER_BYTECODE& bytecode) override { Shader(3, bytecode); }
+        void GSCb(const D3D12_SHADER_BYTECODE& bytecode) override { Shader(4, bytecode); }
+        void CSCb(const D3D12_SHADER_BYTECODE& bytecode) override { Shader(5, bytecode); }
+        void ASCb(const D3D12_SHADER_BYTECODE& bytecode) override { Shader(6, bytecode); }
+        void MSCb(const D3D12_SHADER_BYTECODE& bytecode) override { Shader(7, bytecode); }
+
+        void StreamOutputCb(const D3D12_STREAM_OUTPUT_DESC& desc) override
+        {
+            uint64_t hash = HashValue(desc.NumEntries);
+            for (UINT i = 0; i < desc.NumEntries; ++i)
+            {
+                const auto& entry = desc.pSODeclaration[i];
+                hash = HashString(entry.SemanticName, hash);
+                uint32_t fields[] = {
+                    entry.Stream, entry.SemanticIndex, entry.StartComponent, entry.ComponentCount, entry.OutputSlot,
+                };
+                hash = HashBytes(fields, sizeof(fields), hash);
+            }
+            hash = HashBytes(desc.pBufferStrides, sizeof(UINT) * desc.NumStrides, hash);
+            m_StreamOutput = HashValue(desc.RasterizedStream, hash);
+        }
+
+        void BlendStateCb(const D3D12_BLEND_DESC& desc) override { m_Blend = desc; }
+        void DepthStencilStateCb(const D3D12_DEPTH_STENCIL_DESC& desc) override { m_DepthStencil = CD3DX12_DEPTH_STENCIL_DESC1(desc); }
+        void DepthStencilState1Cb(const D3D12_DEPTH_STENCIL_DESC1& desc) override { m_DepthStencil = desc; }
+        void DSVFormatCb(DXGI_FORMAT format) override { m_DSVFormat = format; }
+        void RasterizerStateCb(const D3D12_RASTERIZER_DESC& desc) override { m_Rasterizer = desc; }
+        void RTVFormatsCb(const D3D12_RT_FORMAT_ARRAY& formats) override { m_RTVFormats = formats; }
+        void SampleDescCb(const DXGI_SAMPLE_DESC& desc) override { m_SampleDesc = desc; }
+        void SampleMaskCb(UINT mask) override { m_SampleMask = mask; }
+
+        void ViewInstancingCb(const D3D12_VIEW_INSTANCING_DESC& desc) override
+        {
+            uint64_t hash = HashValue(desc.ViewInstanceCount);
+            hash = HashBytes(desc.pViewInstanceLocations, sizeof(D3D12_VIEW_INSTANCE_LOCATION) * desc.ViewInstanceCount, hash);
+            m_ViewInstancing = HashValue(desc.Flags, hash);
+        }
+
+        // Cached blobs only speed up creation; they do not change the result.
+        void CachedPSOCb(const D3D12_CACHED_PIPELINE_STATE&) override {}
+
+        void ErrorBadInputParameter(UINT) override { m_Error = true; }
+        void ErrorDuplicateSubobject(D3D12_PIPELINE_STATE_SUBOBJECT_TYPE) override { m_Error = true; }
+        void ErrorUnknownSubobject(UINT) override { m_Error = true; }
+
+    private:
+        void Shader(int stage, const D3D12_SHADER_BYTECODE& bytecode)
+        {
+            m_Shaders[stage] = bytecode.BytecodeLength ? HashBytes(bytecode.pShaderBytecode, bytecode.BytecodeLength) : 0;
+
+            if (m_Storage && bytecode.BytecodeLength)
+            {
+                auto data = static_cast<const uint8_t*>(bytecode.pShaderBytecode);
+                m_Storage->bytecodes.emplace_back(data, data + bytecode.BytecodeLength);
+                const_cast<D3D12_SHADER_BYTECODE&>(bytecode).pShaderBytecode = m_Storage->bytecodes.back().data();
+            }
+        }
+
+        StreamStorage* m_Storage;
+        bool m_Error = false;
+
+        D3D12_PIPELINE_STATE_FLAGS m_Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
+        UINT m_NodeMask = 0;
+        ID3D12RootSignature* m_RootSignature = nullptr;
+        uint64_t m_RootSignatureHash = 0;
+        bool m_Persistent = true;
+        uint64_t m_InputLayout = 0;
+        D3D12_INDEX_BUFFER_STRIP_CUT_VALUE m_StripCut = D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_DISABLED;
+        D3D12_PRIMITIVE_TOPOLOGY_TYPE m_Topology = D3D12_PRIMITIVE_TOPOLOGY_TYPE_UNDEFINED;
+        uint64_t m_Shaders[8];
+        uint64_t m_StreamOutput = 0;
+        uint64_t m_ViewInstancing = 0;
+        D3D12_BLEND_DESC m_Blend = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+        D3D12_DEPTH_STENCIL_DESC1 m_DepthStencil = CD3DX12_DEPTH_STENCIL_DESC1(D3D12_DEFAULT);
+        DXGI_FORMAT m_DSVFormat = DXGI_FORMAT_UNKNOWN;
+        D3D12_RASTERIZER_DESC m_Rasterizer = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+        D3D12_RT_FORMAT_ARRAY m_RTVFormats = {};
+        DXGI_SAMPLE_DESC m_SampleDesc = { 1, 0 };
+        UINT m_SampleMask = UINT_MAX;
+    };
+}
+
+struct PipelineStateCache::Entry
+{
+    uint64_t hash = 0;
+    bool persistent = true;     // hash is stable across runs
+    StreamStorage storage;
+    ComPtr<ID3D12RootSignature> rootSignature;
+    ComPtr<ID3D12PipelineState> pipelineState;
+    std::atomic<PipelineStateStatus> status{ PipelineStateStatus::Pending };
+};
+
+PipelineStateCache::PipelineStateCache(ComPtr<ID3D12Device2> device, JobSystem& jobSystem, PipelineLibrary* library)
+    : m_Device(device)
+    , m_JobSystem(jobSystem)
+    , m_Library(library)
+{
+}
+
+PipelineStateCache::~PipelineStateCache()
+{
+    // Jobs hold raw pointers to entries.
+    WaitAll();
+}
+
+uint64_t PipelineStateCache::HashStream(const D3D12_PIPELINE_STATE_STREAM_DESC& streamDesc)
+{
+    StreamNormalizer normalizer;
+    if (FAILED(D3DX12ParsePipelineStream(streamDesc, &normalizer)) || normalizer.HasError())
+    {
+        return 0;
+    }
+    return normalizer.Finish();
+}
+
+PipelineStateHandle PipelineStateCache::Request(const D3D12_PIPELINE_STATE_STREAM_DESC& streamDesc)
+{
+    uint64_t hash = HashStream(streamDesc);
+    if (hash == 0)
+    {
+        assert(false && "Invalid pipeline state stream");
+        return {};
+    }
+
+    Entry* entry = nullptr;
+    PipelineStateHandle handle;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        ++m_Stats.requests;
+
+        auto found = m_Lookup.find(hash);
+        if (found != m_Lookup.end())
+        {
+            ++m_Stats.duplicates;
+            handle.index = found->second;
+            return handle;
+        }
+
+        handle.index = static_cast<uint32_t>(m_Entries.size());
+        m_Entries.emplace_back(std::make_unique<Entry>());
+        m_Lookup.emplace(hash, handle.index);
+        entry = m_Entries.back().get();
+        entry->hash = hash;
+        // Counted before the lock is released, so a WaitAll() that sees this
+        // entry's handle also sees it pending.
+        m_PendingCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Deep-copy outside the lock; the entry is not visible to the worker yet.
+    auto& storage = entry->storage;
+    auto bytes = static_cast<const uint8_t*>(streamDesc.pPipelineStateSubobjectStream);
+    storage.stream.assign(bytes, bytes + streamDesc.SizeInBytes);
+    storage.bytecodes.reserve(8);
+
+    StreamNormalizer copier(&storage);
+    D3D12_PIPELINE_STATE_STREAM_DESC copyDesc = { storage.stream.size(), storage.stream.data() };
+    D3DX12ParsePipelineStream(copyDesc, &copier);
+    entry->rootSignature = copier.GetRootSignature();
+    entry->persistent = copier.IsPersistent();
+
+    m_JobSystem.Submit([this, entry] { Compile(*entry); });
+    return handle;
+}
+
+void PipelineStateCache::Compile(Entry& entry)
+{
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    D3D12_PIPELINE_STATE_STREAM_DESC streamDesc = { entry.storage.stream.size(), entry.storage.stream.data() };
+    HRESULT hr = m_Library && entry.persistent
+        ? m_Library->LoadOrCreate(entry.hash, streamDesc, &entry.pipelineState)
+        : m_Device->CreatePipelineState(&streamDesc, IID_PPV_ARGS(&entry.pipelineState));
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stats.compileMilliseconds += std::chrono::duration<double, std::milli>(t1 - t0).count();
+        if (SUCCEEDED(hr))
+        {
+            ++m_Stats.compiled;
+        }
+        else
+        {
+            ++m_Stats.failed;
+        }
+    }
+
+    entry.status.store(SUCCEEDED(hr) ? PipelineStateStatus::Ready : PipelineStateStatus::Failed, std::memory_order_release);
+    m_PendingCount.fetch_sub(1, std::memory_order_release);
+}
+
+PipelineStateStatus PipelineStateCache::GetStatus(PipelineStateHandle handle) const
+{
+    if (!handle.IsValid())
+    {
+        return PipelineStateStatus::Failed;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Entries[handle.index]->status.load(std::memory_order_acquire);
+}
+
+ID3D12PipelineState* PipelineStateCache::Get(PipelineStateHandle handle) const
+{
+    if (!handle.IsValid())
+    {
+        return nullptr;
+    }
+
+    Entry* entry;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        entry = m_Entries[handle.index].get();
+    }
+    return entry->status.load(std::memory_order_acquire) == PipelineStateStatus::Ready ? entry->pipelineState.Get() : nullptr;
+}
+
+ID3D12PipelineState* PipelineStateCache::Wait(PipelineStateHandle handle)
+{
+    while (GetStatus(handle) == PipelineStateStatus::Pending)
+    {
+        if (!m_JobSystem.TryRunOne())
+        {
+            std::this_thread::yield();
+        }
+    }
+    return Get(handle);
+}
+
+void PipelineStateCache::WaitAll()
+{
+    while (m_PendingCount.load(std::memory_order_acquire) != 0)
+    {
+        if (!m_JobSystem.TryRunOne())
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+uint64_t PipelineStateCache::GetHash(PipelineStateHandle handle) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return handle.IsValid() ? m_Entries[handle.index]->hash : 0;
+}
+
+PipelineStateCacheStats PipelineStateCache::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Stats;
+}
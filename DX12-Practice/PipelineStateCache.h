@@ -0,0 +1,112 @@
+#pragma once
+#include "Win.h"
+#include <wrl/client.h>
+
+#include "directx/d3dx12.h"
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class JobSystem;
+class PipelineLibrary;
+
+// Handle to a cached pipeline state. Cheap to copy; stays valid for the
+// lifetime of the cache that returned it.
+struct PipelineStateHandle
+{
+    uint32_t index = UINT32_MAX;
+
+    bool IsValid() const { return index != UINT32_MAX; }
+};
+
+enum class PipelineStateStatus : uint32_t
+{
+    Pending,
+    Ready,
+    Failed,
+};
+
+struct PipelineStateCacheStats
+{
+    uint64_t requests = 0;
+    uint64_t duplicates = 0;
+    uint64_t compiled = 0;
+    uint64_t failed = 0;
+    double compileMilliseconds = 0.0;
+};
+
+// Pipeline state objects keyed by a normalized hash of their stream
+// description. Request() never blocks: the first request for a given state
+// queues a CreatePipelineState on the job system, later requests for an
+// identical state return the same handle.
+//
+// The stream is parsed with D3DX12ParsePipelineStream. Subobjects are hashed
+// by value (shader bytecode and input layouts by content, missing subobjects
+// as their D3D12 defaults), so two streams that describe the same pipeline
+// map to the same entry regardless of subobject order. Shader bytecode and
+// input layouts are deep-copied, the root signature is AddRef'ed; any other
+// pointer in the stream (stream output, view instancing) must outlive the
+// pending compile.
+//
+// With a PipelineLibrary attached, compiles first try to load the pipeline
+// from the library under its hash and store it there on a miss. The root
+// signature enters that hash through its blob (GetRootSignatureBlobHash);
+// pipelines whose root signature did not come from a RootSignatureCache are
+// compiled without the library.
+class PipelineStateCache
+{
+public:
+    PipelineStateCache(Microsoft::WRL::ComPtr<ID3D12Device2> device, JobSystem& jobSystem, PipelineLibrary* library = nullptr);
+    ~PipelineStateCache();
+
+    PipelineStateCache(const PipelineStateCache&) = delete;
+    PipelineStateCache& operator=(const PipelineStateCache&) = delete;
+
+    PipelineStateHandle Request(const D3D12_PIPELINE_STATE_STREAM_DESC& streamDesc);
+
+    template<typename Stream>
+    PipelineStateHandle Request(const Stream& stream)
+    {
+        D3D12_PIPELINE_STATE_STREAM_DESC streamDesc = { sizeof(Stream), const_cast<Stream*>(&stream) };
+        return Request(streamDesc);
+    }
+
+    PipelineStateStatus GetStatus(PipelineStateHandle handle) const;
+    bool IsReady(PipelineStateHandle handle) const { return GetStatus(handle) == PipelineStateStatus::Ready; }
+
+    // Returns nullptr while the state is still compiling (or failed).
+    ID3D12PipelineState* Get(PipelineStateHandle handle) const;
+
+    // Blocks until the state leaves Pending, running queued jobs meanwhile.
+    ID3D12PipelineState* Wait(PipelineStateHandle handle);
+
+    // Blocks until every queued compile has finished.
+    void WaitAll();
+    uint32_t GetPendingCount() const { return m_PendingCount.load(std::memory_order_acquire); }
+
+    uint64_t GetHash(PipelineStateHandle handle) const;
+    PipelineStateCacheStats GetStats() const;
+
+    static uint64_t HashStream(const D3D12_PIPELINE_STATE_STREAM_DESC& streamDesc);
+
+private:
+    struct Entry;
+
+    void Compile(Entry& entry);
+
+    Microsoft::WRL::ComPtr<ID3D12Device2> m_Device;
+    JobSystem& m_JobSystem;
+    PipelineLibrary* m_Library;
+
+    mutable std::mutex m_Mutex;
+    std::deque<std::unique_ptr<Entry>> m_Entries;
+    std::unordered_map<uint64_t, uint32_t> m_Lookup;
+    std::atomic<uint32_t> m_PendingCount{ 0 };
+    PipelineStateCacheStats m_Stats;
+};
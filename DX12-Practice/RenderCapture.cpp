@@ -0,0 +1,986 @@
+#include "RenderCapture.h"
+#include "LzCodec.h"
+#include "MappedFile.h"
+
+#include <cstring>
+#include <type_traits>
+
+namespace
+{
+    struct CaptureHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t frameCount;
+        uint32_t reserved;
+    };
+
+    struct ChunkHeader
+    {
+        uint32_t size;              // stream bytes
+        uint32_t storedSize;        // bytes that follow
+        uint32_t flags;
+        uint32_t reserved;
+    };
+
+    enum ChunkFlags : uint32_t
+    {
+        c_ChunkCompressed = 0x1,    // LzCodec stream
+    };
+
+    enum class CaptureOp : uint32_t
+    {
+        CreateBuffer,
+        CreateTexture,
+        CreateRootSignature,
+        CreatePipeline,
+        CreateCommandSignature,
+        Destroy,
+        UpdateBuffer,
+        UpdateTexture,
+        Barrier,
+        UnorderedBarrier,
+        SetRenderTargets,
+        SetViewport,
+        ClearRenderTarget,
+        ClearDepthStencil,
+        SetPipeline,
+        SetPrimitiveTopology,
+        SetRootConstants,
+        SetRootView,
+        SetVertexBuffer,
+        SetIndexBuffer,
+        Draw,
+        DrawIndexed,
+        Dispatch,
+        ExecuteIndirect,
+        CopyBuffer,
+    };
+
+    bool Fail(std::string* error, const std::string& message)
+    {
+        if (error)
+        {
+            *error = message;
+        }
+        return false;
+    }
+
+    // Appends one command: op, payload size (patched when the writer goes
+    // away), payload.
+    class CommandWriter
+    {
+    public:
+        CommandWriter(std::vector<uint8_t>& stream, CaptureOp op)
+            : m_Stream(stream)
+            , m_Start(stream.size())
+        {
+            Put(op).Put(uint32_t(0));
+        }
+
+        ~CommandWriter()
+        {
+            auto size = static_cast<uint32_t>(m_Stream.size() - m_Start - 2 * sizeof(uint32_t));
+            memcpy(&m_Stream[m_Start + sizeof(uint32_t)], &size, sizeof(size));
+        }
+
+        template<typename T>
+        CommandWriter& Put(const T& value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "commands hold plain values");
+            return Bytes(&value, sizeof(value));
+        }
+
+        CommandWriter& Bytes(const void* data, size_t size)
+        {
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            m_Stream.insert(m_Stream.end(), bytes, bytes + size);
+            return *this;
+        }
+
+    private:
+        std::vector<uint8_t>& m_Stream;
+        size_t m_Start;
+    };
+
+    // Bounds-checked reads; any read past the end clears ok and returns zeros.
+    class CommandReader
+    {
+    public:
+        CommandReader(const uint8_t* data, size_t size) : m_Data(data), m_End(data + size) {}
+
+        template<typename T>
+        T Get()
+        {
+            T value = {};
+            const uint8_t* bytes = Bytes(sizeof(value));
+            if (bytes)
+            {
+                memcpy(&value, bytes, sizeof(value));
+            }
+            return value;
+        }
+
+        const uint8_t* Bytes(uint64_t size)
+        {
+            if (!m_Ok || size > uint64_t(m_End - m_Data))
+            {
+                m_Ok = false;
+                return nullptr;
+            }
+            const uint8_t* bytes = m_Data;
+            m_Data += size;
+            return bytes;
+        }
+
+        bool IsOk() const { return m_Ok; }
+        bool IsEnd() const { return m_Data == m_End; }
+        // True if everything was read, exactly.
+        bool IsComplete() const { return m_Ok && m_Data == m_End; }
+
+    private:
+        const uint8_t* m_Data;
+        const uint8_t* m_End;
+        bool m_Ok = true;
+    };
+
+    void AppendChunk(std::vector<uint8_t>& file, const std::vector<uint8_t>& stream)
+    {
+        ChunkHeader header = {};
+        header.size = static_cast<uint32_t>(stream.size());
+
+        std::vector<uint8_t> compressed(stream.size());
+        size_t storedSize = stream.empty() ? 0 : LzCompress(stream.data(), stream.size(), compressed.data(), compressed.size());
+        const std::vector<uint8_t>& stored = storedSize ? compressed : stream;
+        header.storedSize = static_cast<uint32_t>(storedSize ? storedSize : stream.size());
+        if (storedSize)
+        {
+            header.flags = c_ChunkCompressed;
+        }
+
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&header);
+        file.insert(file.end(), bytes, bytes + sizeof(header));
+        file.insert(file.end(), stored.begin(), stored.begin() + header.storedSize);
+    }
+
+    bool ReadChunk(CommandReader& file, std::vector<uint8_t>& stream)
+    {
+        auto header = file.Get<ChunkHeader>();
+        const uint8_t* stored = file.Bytes(header.storedSize);
+        if (!stored)
+        {
+            return false;
+        }
+        stream.resize(header.size);
+        if (header.flags & c_ChunkCompressed)
+        {
+            return LzDecompress(stored, header.storedSize, stream.data(), stream.size());
+        }
+        if (header.storedSize != header.size)
+        {
+            return false;
+        }
+        if (header.size)
+        {
+            memcpy(stream.data(), stored, header.size);
+        }
+        return true;
+    }
+
+    bool ExecuteCommand(CaptureOp op, CommandReader& in, RenderInterface& target)
+    {
+        switch (op)
+        {
+        case CaptureOp::CreateBuffer:
+        {
+            auto id = in.Get<uint32_t>();
+            auto size = in.Get<uint64_t>();
+            auto flags = in.Get<uint32_t>();
+            if (in.IsComplete())
+            {
+                target.CreateBuffer(id, size, flags);
+            }
+            break;
+        }
+        case CaptureOp::CreateTexture:
+        {
+            auto id = in.Get<uint32_t>();
+            auto desc = in.Get<RenderTextureDesc>();
+            if (in.IsComplete())
+            {
+                target.CreateTexture(id, desc);
+            }
+            break;
+        }
+        case CaptureOp::CreateRootSignature:
+        {
+            auto id = in.Get<uint32_t>();
+            auto size = in.Get<uint32_t>();
+            const uint8_t* blob = in.Bytes(size);
+            if (in.IsComplete())
+            {
+                target.CreateRootSignature(id, blob, size);
+            }
+            break;
+        }
+        case CaptureOp::CreatePipeline:
+        {
+            auto id = in.Get<uint32_t>();
+            auto rootSignature = in.Get<uint32_t>();
+            auto size = in.Get<uint32_t>();
+            const uint8_t* blob = in.Bytes(size);
+            if (in.IsComplete())
+            {
+                target.CreatePipeline(id, rootSignature, blob, size);
+            }
+            break;
+        }
+        case CaptureOp::CreateCommandSignature:
+        {
+            auto id = in.Get<uint32_t>();
+            auto byteStride = in.Get<uint32_t>();
+            auto rootSignature = in.Get<uint32_t>();
+            auto count = in.Get<uint32_t>();
+            std::vector<IndirectArgument> arguments;
+            const uint8_t* data = in.Bytes(uint64_t(count) * sizeof(IndirectArgument));
+            if (in.IsComplete())
+            {
+                arguments.resize(count);
+                if (count)
+                {
+                    memcpy(arguments.data(), data, count * sizeof(IndirectArgument));
+                }
+                target.CreateCommandSignature(id, arguments, byteStride, rootSignature);
+            }
+            break;
+        }
+        case CaptureOp::Destroy:
+        {
+            auto id = in.Get<uint32_t>();
+            if (in.IsComplete())
+            {
+                target.Destroy(id);
+            }
+            break;
+        }
+        case CaptureOp::UpdateBuffer:
+        {
+            auto id = in.Get<uint32_t>();
+            auto offset = in.Get<uint64_t>();
+            auto size = in.Get<uint64_t>();
+            const uint8_t* data = in.Bytes(size);
+            if (in.IsComplete())
+            {
+                target.UpdateBuffer(id, offset, data, size);
+            }
+            break;
+        }
+        case CaptureOp::UpdateTexture:
+        {
+            auto id = in.Get<uint32_t>();
+            auto subresource = in.Get<uint32_t>();
+            auto rowPitch = in.Get<uint64_t>();
+            auto slicePitch = in.Get<uint64_t>();
+            const uint8_t* data = in.Bytes(slicePitch);
+            if (in.IsComplete())
+            {
+                target.UpdateTexture(id, subresource, data, rowPitch, slicePitch);
+            }
+            break;
+        }
+        case CaptureOp::Barrier:
+        {
+            auto id = in.Get<uint32_t>();
+            auto before = in.Get<uint32_t>();
+            auto after = in.Get<uint32_t>();
+            if (in.IsComplete())
+            {
+                target.Barrier(id, before, after);
+            }
+            break;
+        }
+        case CaptureOp::UnorderedBarrier:
+        {
+            auto id = in.Get<uint32_t>();
+            if (in.IsComplete())
+            {
+                target.UnorderedBarrier(id);
+            }
+            break;
+        }
+        case CaptureOp::SetRenderTargets:
+        {
+            auto count = in.Get<uint32_t>();
+            uint32_t renderTargets[c_RenderMaxRenderTargets] = {};
+            for (uint32_t i = 0; i < count && i < c_RenderMaxRenderTargets; ++i)
+            {
+                renderTargets[i] = in.Get<uint32_t>();
+            }
+            auto depthStencil = in.Get<uint32_t>();
+            if (count <= c_RenderMaxRenderTargets && in.IsComplete())
+            {
+                target.SetRenderTargets(count, renderTargets, depthStencil);
+            }
+            break;
+        }
+        case CaptureOp::SetViewport:
+        {
+            float values[6];
+            for (float& value : values)
+            {
+                value = in.Get<float>();
+            }
+            if (in.IsComplete())
+            {
+                target.SetViewport(values[0], values[1], values[2], values[3], values[4], values[5]);
+            }
+            break;
+        }
+        case CaptureOp::ClearRenderTarget:
+        {
+            auto id = in.Get<uint32_t>();
+            float color[4];
+            for (float& value : color)
+            {
+                value = in.Get<float>();
+            }
+            if (in.IsComplete())
+            {
+                target.ClearRenderTarget(id, color);
+            }
+            break;
+        }
+        case CaptureOp::ClearDepthStencil:
+        {
+            auto id = in.Get<uint32_t>();
+            auto depth = in.Get<float>();
+            auto stencil = in.Get<uint8_t>();
+            if (in.IsComplete())
+            {
+                target.ClearDepthStencil(id, depth, stencil);
+            }
+            break;
+        }
+        case CaptureOp::SetPipeline:
+        {
+            auto id = in.Get<uint32_t>();
+            if (in.IsComplete())
+            {
+                target.SetPipeline(id);
+            }
+            break;
+        }
+        case CaptureOp::SetPrimitiveTopology:
+        {
+            auto topology = in.Get<uint32_t>();
+            if (in.IsComplete())
+            {
+                target.SetPrimitiveTopology(topology);
+            }
+            break;
+        }
+        case CaptureOp::SetRootConstants:
+        {
+            auto parameter = in.Get<uint32_t>();
+            auto destOffset = in.Get<uint32_t>();
+            auto count = in.Get<uint32_t>();
+            const uint8_t* data = in.Bytes(uint64_t(count) * sizeof(uint32_t));
+            if (in.IsComplete())
+            {
+                std::vector<uint32_t> values(count);
+                if (count)
+                {
+                    memcpy(values.data(), data, count * sizeof(uint32_t));
+                }
+                target.SetRootConstants(parameter, count, values.data(), destOffset);
+            }
+            break;
+        }
+        case CaptureOp::SetRootView:
+        {
+            auto parameter = in.Get<uint32_t>();
+            auto type = in.Get<RenderRootView>();
+            auto id = in.Get<uint32_t>();
+            auto offset = in.Get<uint64_t>();
+            if (in.IsComplete())
+            {
+                target.SetRootView(parameter, type, id, offset);
+            }
+            break;
+        }
+        case CaptureOp::SetVertexBuffer:
+        {
+            auto slot = in.Get<uint32_t>();
+            auto id = in.Get<uint32_t>();
+            auto offset = in.Get<uint64_t>();
+            auto size = in.Get<uint32_t>();
+            auto stride = in.Get<uint32_t>();
+            if (in.IsComplete())
+            {
+                target.SetVertexBuffer(slot, id, offset, size, stride);
+            }
+            break;
+        }
+        case CaptureOp::SetIndexBuffer:
+        {
+            auto id = in.Get<uint32_t>();
+            auto offset = in.Get<uint64_t>();
+            auto size = in.Get<uint32_t>();
+            auto index32 = in.Get<uint8_t>();
+            if (in.IsComplete())
+            {
+                target.SetIndexBuffer(id, offset, size, index32 != 0);
+            }
+            break;
+        }
+        case CaptureOp::Draw:
+        {
+            auto args = in.Get<IndirectDrawArgs>();
+            if (in.IsComplete())
+            {
+                target.Draw(args.vertexCountPerInstance, args.instanceCount, args.startVertexLocation, args.startInstanceLocation);
+            }
+            break;
+        }
+        case CaptureOp::DrawIndexed:
+        {
+            auto args = in.Get<IndirectDrawIndexedArgs>();
+            if (in.IsComplete())
+            {
+                target.DrawIndexed(args.indexCountPerInstance, args.instanceCount, args.startIndexLocation,
+                    args.baseVertexLocation, args.startInstanceLocation);
+            }
+            break;
+        }
+        case CaptureOp::Dispatch:
+        {
+            auto args = in.Get<IndirectDispatchArgs>();
+            if (in.IsComplete())
+            {
+                target.Dispatch(args.threadGroupCountX, args.threadGroupCountY, args.threadGroupCountZ);
+            }
+            break;
+        }
+        case CaptureOp::ExecuteIndirect:
+        {
+            auto signature = in.Get<uint32_t>();
+            auto maxCount = in.Get<uint32_t>();
+            auto argumentBuffer = in.Get<uint32_t>();
+            auto argumentOffset = in.Get<uint64_t>();
+            auto countBuffer = in.Get<uint32_t>();
+            auto countOffset = in.Get<uint64_t>();
+            if (in.IsComplete())
+            {
+                target.ExecuteIndirect(signature, maxCount, argumentBuffer, argumentOffset, countBuffer, countOffset);
+            }
+            break;
+        }
+        case CaptureOp::CopyBuffer:
+        {
+            auto destination = in.Get<uint32_t>();
+            auto destinationOffset = in.Get<uint64_t>();
+            auto source = in.Get<uint32_t>();
+            auto sourceOffset = in.Get<uint64_t>();
+            auto size = in.Get<uint64_t>();
+            if (in.IsComplete())
+            {
+                target.CopyBuffer(destination, destinationOffset, source, sourceOffset, size);
+            }
+            break;
+        }
+        default:
+            return false;
+        }
+        return in.IsComplete();
+    }
+
+    bool ExecuteStream(const std::vector<uint8_t>& stream, RenderInterface& target, std::string* error)
+    {
+        CommandReader in(stream.data(), stream.size());
+        target.BeginFrame();
+        while (!in.IsEnd())
+        {
+            auto op = in.Get<CaptureOp>();
+            auto size = in.Get<uint32_t>();
+            const uint8_t* payload = in.Bytes(size);
+            CommandReader command(payload, size);
+            if (!in.IsOk() || !ExecuteCommand(op, command, target))
+            {
+                target.EndFrame();
+                return Fail(error, "corrupt command " + std::to_string(static_cast<uint32_t>(op)));
+            }
+        }
+        target.EndFrame();
+        return true;
+    }
+}
+
+RenderCapture::Object& RenderCapture::Add(uint32_t id, std::vector<uint8_t> create)
+{
+    Object& object = m_Objects[id];
+    object = Object();
+    object.create = std::move(create);
+    // Created during the capture: the frame stream creates it.
+    if (m_Recording)
+    {
+        object.captured = true;
+        m_Frame.insert(m_Frame.end(), object.create.begin(), object.create.end());
+    }
+    return object;
+}
+
+void RenderCapture::Use(uint32_t id)
+{
+    if (!m_Recording)
+    {
+        return;
+    }
+    auto found = m_Objects.find(id);
+    if (found == m_Objects.end() || found->second.captured)
+    {
+        return;
+    }
+
+    Object& object = found->second;
+    object.captured = true;
+    if (object.dependency != c_RenderNoResource)
+    {
+        Use(object.dependency);
+    }
+    m_Setup.insert(m_Setup.end(), object.create.begin(), object.create.end());
+    if (!object.resource)
+    {
+        return;
+    }
+
+    bool uploaded = !object.contents.empty() || !object.subresources.empty();
+    if (!object.contents.empty())
+    {
+        CommandWriter(m_Setup, CaptureOp::UpdateBuffer).Put(id).Put(uint64_t(0)).Put(uint64_t(object.contents.size()))
+            .Bytes(object.contents.data(), object.contents.size());
+    }
+    for (const auto& subresource : object.subresources)
+    {
+        const Subresource& data = subresource.second;
+        CommandWriter(m_Setup, CaptureOp::UpdateTexture).Put(id).Put(subresource.first).Put(data.rowPitch)
+            .Put(uint64_t(data.data.size())).Bytes(data.data.data(), data.data.size());
+    }
+
+    // Leave it in the state the frames expect.
+    uint32_t state = uploaded ? c_RenderStateCopyDest : c_RenderStateCommon;
+    if (object.state != state)
+    {
+        CommandWriter(m_Setup, CaptureOp::Barrier).Put(id).Put(state).Put(object.state);
+    }
+}
+
+bool RenderCapture::Start(const std::filesystem::path& path, uint32_t frameCount)
+{
+    if (IsCapturing() || frameCount == 0)
+    {
+        return false;
+    }
+
+    m_Path = path;
+    m_FrameCount = frameCount;
+    m_FramesLeft = frameCount;
+    m_Setup.clear();
+    m_Frame.clear();
+    m_Frames.clear();
+    for (auto& object : m_Objects)
+    {
+        object.second.captured = false;
+    }
+    return true;
+}
+
+void RenderCapture::Finish()
+{
+    std::vector<uint8_t> file;
+    CaptureHeader header = { c_RenderCaptureMagic, c_RenderCaptureVersion, m_FrameCount, 0 };
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&header);
+    file.insert(file.end(), bytes, bytes + sizeof(header));
+    AppendChunk(file, m_Setup);
+    for (const auto& frame : m_Frames)
+    {
+        file.insert(file.end(), frame.begin(), frame.end());
+    }
+
+    m_LastError = WriteFileAtomic(m_Path, file.data(), file.size()) ? std::string() : "cannot write " + m_Path.string();
+
+    m_Recording = false;
+    m_Setup = std::vector<uint8_t>();
+    m_Frame = std::vector<uint8_t>();
+    m_Frames = std::vector<std::vector<uint8_t>>();
+}
+
+void RenderCapture::BeginFrame()
+{
+    m_Target.BeginFrame();
+    if (m_FramesLeft)
+    {
+        m_Recording = true;
+    }
+}
+
+void RenderCapture::EndFrame()
+{
+    m_Target.EndFrame();
+    if (!m_Recording)
+    {
+        return;
+    }
+
+    std::vector<uint8_t> chunk;
+    AppendChunk(chunk, m_Frame);
+    m_Frames.push_back(std::move(chunk));
+    m_Frame.clear();
+    if (--m_FramesLeft == 0)
+    {
+        Finish();
+    }
+}
+
+void RenderCapture::CreateBuffer(uint32_t id, uint64_t size, uint32_t flags)
+{
+    m_Target.CreateBuffer(id, size, flags);
+    std::vector<uint8_t> create;
+    CommandWriter(create, CaptureOp::CreateBuffer).Put(id).Put(size).Put(flags);
+    Object& object = Add(id, std::move(create));
+    object.resource = true;
+    object.size = size;
+}
+
+void RenderCapture::CreateTexture(uint32_t id, const RenderTextureDesc& desc)
+{
+    m_Target.CreateTexture(id, desc);
+    std::vector<uint8_t> create;
+    CommandWriter(create, CaptureOp::CreateTexture).Put(id).Put(desc);
+    Add(id, std::move(create)).resource = true;
+}
+
+void RenderCapture::ImportTexture(uint32_t id, const RenderTextureDesc& desc, void* native)
+{
+    m_Target.ImportTexture(id, desc, native);
+    std::vector<uint8_t> create;
+    CommandWriter(create, CaptureOp::CreateTexture).Put(id).Put(desc);
+    Add(id, std::move(create)).resource = true;
+}
+
+void RenderCapture::CreateRootSignature(uint32_t id, const void* blob, size_t size)
+{
+    m_Target.CreateRootSignature(id, blob, size);
+    std::vector<uint8_t> create;
+    CommandWriter(create, CaptureOp::CreateRootSignature).Put(id).Put(uint32_t(size)).Bytes(blob, size);
+    Add(id, std::move(create));
+}
+
+void RenderCapture::CreatePipeline(uint32_t id, uint32_t rootSignature, const void* blob, size_t size)
+{
+    m_Target.CreatePipeline(id, rootSignature, blob, size);
+    Use(rootSignature);
+    std::vector<uint8_t> create;
+    CommandWriter(create, CaptureOp::CreatePipeline).Put(id).Put(rootSignature).Put(uint32_t(size)).Bytes(blob, size);
+    Add(id, std::move(create)).dependency = rootSignature;
+}
+
+void RenderCapture::CreateCommandSignature(uint32_t id, const std::vector<IndirectArgument>& arguments,
+    uint32_t byteStride, uint32_t rootSignature)
+{
+    m_Target.CreateCommandSignature(id, arguments, byteStride, rootSignature);
+    Use(rootSignature);
+    std::vector<uint8_t> create;
+    CommandWriter(create, CaptureOp::CreateCommandSignature).Put(id).Put(byteStride).Put(rootSignature)
+        .Put(uint32_t(arguments.size())).Bytes(arguments.data(), arguments.size() * sizeof(IndirectArgument));
+    Add(id, std::move(create)).dependency = rootSignature;
+}
+
+void RenderCapture::Destroy(uint32_t id)
+{
+    m_Target.Destroy(id);
+    auto found = m_Objects.find(id);
+    if (found == m_Objects.end())
+    {
+        return;
+    }
+    if (m_Recording && found->second.captured)
+    {
+        CommandWriter(m_Frame, CaptureOp::Destroy).Put(id);
+    }
+    m_Objects.erase(found);
+}
+
+void RenderCapture::UpdateBuffer(uint32_t id, uint64_t offset, const void* data, uint64_t size)
+{
+    m_Target.UpdateBuffer(id, offset, data, size);
+    Use(id);
+    if (m_Recording)
+    {
+        CommandWriter(m_Frame, CaptureOp::UpdateBuffer).Put(id).Put(offset).Put(size).Bytes(data, size);
+    }
+
+    auto found = m_Objects.find(id);
+    if (found == m_Objects.end() || offset > found->second.size || size > found->second.size - offset)
+    {
+        return;
+    }
+    Object& object = found->second;
+    if (object.contents.empty())
+    {
+        object.contents.resize(object.size);
+    }
+    memcpy(object.contents.data() + offset, data, size);
+}
+
+void RenderCapture::UpdateTexture(uint32_t id, uint32_t subresource, const void* data, uint64_t rowPitch, uint64_t slicePitch)
+{
+    m_Target.UpdateTexture(id, subresource, data, rowPitch, slicePitch);
+    Use(id);
+    if (m_Recording)
+    {
+        CommandWriter(m_Frame, CaptureOp::UpdateTexture).Put(id).Put(subresource).Put(rowPitch).Put(slicePitch)
+            .Bytes(data, slicePitch);
+    }
+
+    auto found = m_Objects.find(id);
+    if (found != m_Objects.end())
+    {
+        Subresource& shadow = found->second.subresources[subresource];
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        shadow.rowPitch = rowPitch;
+        shadow.data.assign(bytes, bytes + slicePitch);
+    }
+}
+
+void RenderCapture::Barrier(uint32_t id, uint32_t before, uint32_t after)
+{
+    m_Target.Barrier(id, before, after);
+    Use(id);
+    if (m_Recording)
+    {
+        CommandWriter(m_Frame, CaptureOp::Barrier).Put(id).Put(before).Put(after);
+    }
+
+    auto found = m_Objects.find(id);
+    if (found != m_Objects.end())
+    {
+        found->second.state = after;
+    }
+}
+
+void RenderCapture::UnorderedBarrier(uint32_t id)
+{
+    m_Target.UnorderedBarrier(id);
+    Use(id);
+    if (m_Recording)
+    {
+        CommandWriter(m_Frame, CaptureOp::UnorderedBarrier).Put(id);
+    }
+}
+
+void RenderCapture::SetRenderTargets(uint32_t count, const uint32_t* renderTargets, uint32_t depthStencil)
+{
+    m_Target.SetRenderTargets(count, renderTargets, depthStencil);
+    if (!m_Recording)
+    {
+        return;
+    }
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        Use(renderTargets[i]);
+    }
+    Use(depthStencil);
+    CommandWriter command(m_Frame, CaptureOp::SetRenderTargets);
+    command.Put(count).Bytes(renderTargets, count * sizeof(uint32_t)).Put(depthStencil);
+}
+
+void RenderCapture::SetViewport(float x, float y, float width, float height, float minDepth, float maxDepth)
+{
+    m_Target.SetViewport(x, y, width, height, minDepth, maxDepth);
+    if (m_Recording)
+    {
+        CommandWriter(m_Frame, CaptureOp::SetViewport).Put(x).Put(y).Put(width).Put(height).Put(minDepth).Put(maxDepth);
+    }
+}
+
+void RenderCapture::ClearRenderTarget(uint32_t id, const float color[4])
+{
+    m_Target.ClearRenderTarget(id, color);
+    Use(id);
+    if (m_Recording)
+    {
+        CommandWriter(m_Frame, CaptureOp::ClearRenderTarget).Put(id).Bytes(color, 4 * sizeof(float));
+    }
+}
+
+void RenderCapture::ClearDepthStencil(uint32_t id, float depth, uint8_t stencil)
+{
+    m_Target.ClearDepthStencil(id, depth, stencil);
+    Use(id);
+    if (m_Recording)
+    {
+        CommandWriter(m_Frame, CaptureOp::ClearDepthStencil).Put(id).Put(depth).Put(stencil);
+    }
+}
+
+void RenderCapture::SetPipeline(uint32_t id)
+{
+    m_Target.SetPipeline(id);
+    Use(id);
+    if (m_Recording)
+    {
+        CommandWriter(m_Frame, CaptureOp::SetPipeline).Put(id);
+    }
+}
+
+void RenderCapture::SetPrimitiveTopology(uint32_t topology)
+{
+    m_Target.SetPrimitiveTopology(topology);
+    if (m_Recording)
+    {
+        CommandWriter(m_Frame, CaptureOp::SetPrimitiveTopology).Put(topology);
+    }
+}
+
+void RenderCapture::SetRootConstants(uint32_t parameter, uint32_t count, const uint32_t* values, uint32_t destOffset)
+{
+    m_Target.SetRootConstants(parameter, count, values, destOffset);
+    if (m_Recording)
+    {
+        CommandWriter(m_Frame, CaptureOp::SetRootConstants).Put(parameter).Put(destOffset).Put(count)
+            .Bytes(values, count * sizeof(uint32_t));
+    }
+}
+
+void RenderCapture::SetRootView(uint32_t parameter, RenderRootView type, uint32_t id, uint64_t offset)
+{
+    m_Target.SetRootView(parameter, type, id, offset);
+    Use(id);
+    if (m_Recording)
+    {
+        CommandWriter(m_Frame, CaptureOp::SetRootView).Put(parameter).Put(type).Put(id).Put(offset);
+    }
+}
+
+void RenderCapture::SetVertexBuffer(uint32_t slot, uint32_t id, uint64_t offset, uint32_t size, uint32_t stride)
+{
+    m_Target.SetVertexBuffer(slot, id, offset, size, stride);
+    Use(id);
+    if (m_Recording)
+    {
+        CommandWriter(m_Frame, CaptureOp::SetVertexBuffer).Put(slot).Put(id).Put(offset).Put(size).Put(stride);
+    }
+}
+
+void RenderCapture::SetIndexBuffer(uint32_t id, uint64_t offset, uint32_t size, bool index32)
+{
+    m_Target.SetIndexBuffer(id, offset, size, index32);
+    Use(id);
+    if (m_Recording)
+    {
+        CommandWriter(m_Frame, CaptureOp::SetIndexBuffer).Put(id).Put(offset).Put(size).Put(uint8_t(index32));
+    }
+}
+
+void RenderCapture::Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+{
+    m_Target.Draw(vertexCount, instanceCount, firstVertex, firstInstance);
+    if (m_Recording)
+    {
+        CommandWriter(m_Frame, CaptureOp::Draw).Put(IndirectDrawArgs{ vertexCount, instanceCount, firstVertex, firstInstance });
+    }
+}
+
+void RenderCapture::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex,
+    uint32_t firstInstance)
+{
+    m_Target.DrawIndexed(indexCount, instanceCount, firstIndex, baseVertex, firstInstance);
+    if (m_Recording)
+    {
+        CommandWriter(m_Frame, CaptureOp::DrawIndexed)
+            .Put(IndirectDrawIndexedArgs{ indexCount, instanceCount, firstIndex, baseVertex, firstInstance });
+    }
+}
+
+void RenderCapture::Dispatch(uint32_t x, uint32_t y, uint32_t z)
+{
+    m_Target.Dispatch(x, y, z);
+    if (m_Recording)
+    {
+        CommandWriter(m_Frame, CaptureOp::Dispatch).Put(IndirectDispatchArgs{ x, y, z });
+    }
+}
+
+void RenderCapture::ExecuteIndirect(uint32_t signature, uint32_t maxCount, uint32_t argumentBuffer, uint64_t argumentOffset,
+    uint32_t countBuffer, uint64_t countOffset)
+{
+    m_Target.ExecuteIndirect(signature, maxCount, argumentBuffer, argumentOffset, countBuffer, countOffset);
+    Use(signature);
+    Use(argumentBuffer);
+    Use(countBuffer);
+    if (m_Recording)
+    {
+        CommandWriter(m_Frame, CaptureOp::ExecuteIndirect).Put(signature).Put(maxCount).Put(argumentBuffer)
+            .Put(argumentOffset).Put(countBuffer).Put(countOffset);
+    }
+}
+
+void RenderCapture::CopyBuffer(uint32_t destination, uint64_t destinationOffset, uint32_t source, uint64_t sourceOffset,
+    uint64_t size)
+{
+    m_Target.CopyBuffer(destination, destinationOffset, source, sourceOffset, size);
+    Use(destination);
+    Use(source);
+    if (m_Recording)
+    {
+        CommandWriter(m_Frame, CaptureOp::CopyBuffer).Put(destination).Put(destinationOffset).Put(source)
+            .Put(sourceOffset).Put(size);
+    }
+}
+
+bool RenderCaptureReplayer::Open(const std::filesystem::path& path, std::string* error)
+{
+    m_Setup.clear();
+    m_Frames.clear();
+
+    MappedFile file;
+    if (!file.Open(path))
+    {
+        return Fail(error, "cannot open capture");
+    }
+
+    CommandReader in(file.GetData(), file.GetSize());
+    auto header = in.Get<CaptureHeader>();
+    if (!in.IsOk() || header.magic != c_RenderCaptureMagic || header.version != c_RenderCaptureVersion)
+    {
+        return Fail(error, "not a render capture");
+    }
+
+    m_Frames.resize(header.frameCount);
+    bool ok = ReadChunk(in, m_Setup);
+    for (uint32_t i = 0; ok && i < header.frameCount; ++i)
+    {
+        ok = ReadChunk(in, m_Frames[i]);
+    }
+    if (!ok || !in.IsEnd())
+    {
+        m_Setup.clear();
+        m_Frames.clear();
+        return Fail(error, "render capture is corrupt");
+    }
+    return true;
+}
+
+bool RenderCaptureReplayer::ReplaySetup(RenderInterface& target, std::string* error) const
+{
+    return ExecuteStream(m_Setup, target, error);
+}
+
+bool RenderCaptureReplayer::ReplayFrame(uint32_t frame, RenderInterface& target, std::string* error) const
+{
+    if (frame >= m_Frames.size())
+    {
+        return Fail(error, "no frame " + std::to_string(frame));
+    }
+    return ExecuteStream(m_Frames[frame], target, error);
+}
@@ -0,0 +1,140 @@
+#pragma once
+#include "RenderInterface.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Capture file:
+//     header          magic, version, frame count
+//     setup chunk     objects the frames use, with their contents and states
+//                     as they were when first used
+//     frame chunks    one per frame, every call between BeginFrame/EndFrame
+// Chunks are command streams (op, payload size, payload), LZ-compressed
+// when that makes them smaller.
+constexpr uint32_t c_RenderCaptureMagic = 0x31504352; // "RCP1"
+constexpr uint32_t c_RenderCaptureVersion = 1;
+
+// Capture layer: forwards every call to the target and, while a capture is
+// running, records it. Objects are written on first use, so a capture holds
+// only what its frames touch, however long the layer has been running. To
+// have contents for resources filled before the capture started, the layer
+// keeps a CPU copy of everything written through UpdateBuffer/UpdateTexture;
+// contents the GPU produced are not captured and start undefined in a
+// replay. The state a resource is captured in is the last one a Barrier()
+// left it in.
+class RenderCapture : public RenderInterface
+{
+public:
+    explicit RenderCapture(RenderInterface& target) : m_Target(target) {}
+
+    // Records the next frameCount frames, starting at the next BeginFrame,
+    // and writes them to path after the last one. False if a capture is
+    // already running.
+    bool Start(const std::filesystem::path& path, uint32_t frameCount);
+    bool IsCapturing() const { return m_FramesLeft != 0; }
+    // Result of the last capture written.
+    const std::string& GetLastError() const { return m_LastError; }
+
+    const char* GetName() const override { return m_Target.GetName(); }
+
+    void BeginFrame() override;
+    void EndFrame() override;
+
+    void CreateBuffer(uint32_t id, uint64_t size, uint32_t flags) override;
+    void CreateTexture(uint32_t id, const RenderTextureDesc& desc) override;
+    void ImportTexture(uint32_t id, const RenderTextureDesc& desc, void* native) override;
+    void CreateRootSignature(uint32_t id, const void* blob, size_t size) override;
+    void CreatePipeline(uint32_t id, uint32_t rootSignature, const void* blob, size_t size) override;
+    void CreateCommandSignature(uint32_t id, const std::vector<IndirectArgument>& arguments, uint32_t byteStride,
+        uint32_t rootSignature) override;
+    void Destroy(uint32_t id) override;
+
+    void UpdateBuffer(uint32_t id, uint64_t offset, const void* data, uint64_t size) override;
+    void UpdateTexture(uint32_t id, uint32_t subresource, const void* data, uint64_t rowPitch, uint64_t slicePitch) override;
+
+    void Barrier(uint32_t id, uint32_t before, uint32_t after) override;
+    void UnorderedBarrier(uint32_t id) override;
+
+    void SetRenderTargets(uint32_t count, const uint32_t* renderTargets, uint32_t depthStencil) override;
+    void SetViewport(float x, float y, float width, float height, float minDepth, float maxDepth) override;
+    void ClearRenderTarget(uint32_t id, const float color[4]) override;
+    void ClearDepthStencil(uint32_t id, float depth, uint8_t stencil) override;
+
+    void SetPipeline(uint32_t id) override;
+    void SetPrimitiveTopology(uint32_t topology) override;
+    void SetRootConstants(uint32_t parameter, uint32_t count, const uint32_t* values, uint32_t destOffset) override;
+    void SetRootView(uint32_t parameter, RenderRootView type, uint32_t id, uint64_t offset) override;
+    void SetVertexBuffer(uint32_t slot, uint32_t id, uint64_t offset, uint32_t size, uint32_t stride) override;
+    void SetIndexBuffer(uint32_t id, uint64_t offset, uint32_t size, bool index32) override;
+
+    void Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) override;
+    void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex,
+        uint32_t firstInstance) override;
+    void Dispatch(uint32_t x, uint32_t y, uint32_t z) override;
+    void ExecuteIndirect(uint32_t signature, uint32_t maxCount, uint32_t argumentBuffer, uint64_t argumentOffset,
+        uint32_t countBuffer, uint64_t countOffset) override;
+
+    void CopyBuffer(uint32_t destination, uint64_t destinationOffset, uint32_t source, uint64_t sourceOffset,
+        uint64_t size) override;
+
+private:
+    struct Subresource
+    {
+        uint64_t rowPitch;
+        std::vector<uint8_t> data;
+    };
+
+    struct Object
+    {
+        std::vector<uint8_t> create;                // encoded create command
+        uint32_t dependency = c_RenderNoResource;   // root signature of a pipeline or command signature
+        bool resource = false;
+        bool captured = false;                      // written to the current capture
+        uint32_t state = c_RenderStateCommon;
+        uint64_t size = 0;                          // buffers
+        std::vector<uint8_t> contents;              // buffers, allocated on the first update
+        std::map<uint32_t, Subresource> subresources;   // textures, by subresource index
+    };
+
+    // Writes the object to the setup chunk if this capture has not seen it yet.
+    void Use(uint32_t id);
+    Object& Add(uint32_t id, std::vector<uint8_t> create);
+    void Finish();
+
+    RenderInterface& m_Target;
+    std::unordered_map<uint32_t, Object> m_Objects;
+
+    std::filesystem::path m_Path;
+    uint32_t m_FrameCount = 0;
+    uint32_t m_FramesLeft = 0;
+    bool m_Recording = false;                   // inside a captured frame
+    std::vector<uint8_t> m_Setup;
+    std::vector<uint8_t> m_Frame;
+    std::vector<std::vector<uint8_t>> m_Frames; // finished chunks, compressed
+    std::string m_LastError;
+};
+
+// Loads a capture into memory and re-issues it against any RenderInterface.
+// The setup replays as a frame of its own. Frames may be replayed any number
+// of times; each run starts from the state the previous one left.
+class RenderCaptureReplayer
+{
+public:
+    bool Open(const std::filesystem::path& path, std::string* error = nullptr);
+
+    uint32_t GetFrameCount() const { return static_cast<uint32_t>(m_Frames.size()); }
+    // Uncompressed size of the setup and frame streams.
+    uint64_t GetSetupSize() const { return m_Setup.size(); }
+    uint64_t GetFrameSize(uint32_t frame) const { return m_Frames[frame].size(); }
+
+    bool ReplaySetup(RenderInterface& target, std::string* error = nullptr) const;
+    bool ReplayFrame(uint32_t frame, RenderInterface& target, std::string* error = nullptr) const;
+
+private:
+    std::vector<uint8_t> m_Setup;
+    std::vector<std::vector<uint8_t>> m_Frames;
+};
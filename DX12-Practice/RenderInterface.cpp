@@ -0,0 +1,399 @@
+#include "RenderInterface.h"
+
+#include <algorithm>
+
+namespace
+{
+    uint32_t GetMipCount(const RenderTextureDesc& desc)
+    {
+        if (desc.mipLevels)
+        {
+            return desc.mipLevels;
+        }
+        // 0 asks for the full chain.
+        uint32_t count = 1;
+        for (uint32_t size = std::max(desc.width, desc.height); size > 1; size >>= 1)
+        {
+            ++count;
+        }
+        return count;
+    }
+}
+
+void NullRenderInterface::Error(const char* command, const std::string& message)
+{
+    if (m_Stats.errors++ == 0)
+    {
+        m_FirstError = std::string(command) + ": " + message;
+    }
+}
+
+void NullRenderInterface::Record(const char* command)
+{
+    ++m_Stats.commands;
+    if (!m_InFrame)
+    {
+        Error(command, "outside a frame");
+    }
+}
+
+const NullRenderInterface::Object* NullRenderInterface::Find(uint32_t id, ObjectType type, const char* command)
+{
+    const Object* object = FindObject(id, command);
+    if (object && object->type != type)
+    {
+        Error(command, "id " + std::to_string(id) + " has the wrong type");
+        return nullptr;
+    }
+    return object;
+}
+
+const NullRenderInterface::Object* NullRenderInterface::FindObject(uint32_t id, const char* command)
+{
+    auto found = m_Objects.find(id);
+    if (found == m_Objects.end())
+    {
+        Error(command, "unknown id " + std::to_string(id));
+        return nullptr;
+    }
+    return &found->second;
+}
+
+void NullRenderInterface::CheckRange(uint32_t id, uint64_t offset, uint64_t size, const char* command)
+{
+    const Object* buffer = Find(id, ObjectType::Buffer, command);
+    if (buffer && (offset > buffer->size || size > buffer->size - offset))
+    {
+        Error(command, "range exceeds buffer " + std::to_string(id));
+    }
+}
+
+void NullRenderInterface::BeginFrame()
+{
+    if (m_InFrame)
+    {
+        Error("BeginFrame", "frame already open");
+    }
+    m_InFrame = true;
+    m_HasPipeline = false;
+}
+
+void NullRenderInterface::EndFrame()
+{
+    if (!m_InFrame)
+    {
+        Error("EndFrame", "no frame open");
+    }
+    m_InFrame = false;
+    ++m_Stats.frames;
+}
+
+void NullRenderInterface::CreateBuffer(uint32_t id, uint64_t size, uint32_t flags)
+{
+    ++m_Stats.commands;
+    if (size == 0)
+    {
+        Error("CreateBuffer", "empty buffer");
+    }
+    Object object = { ObjectType::Buffer };
+    object.size = size;
+    object.flags = flags;
+    m_Objects[id] = object;
+}
+
+void NullRenderInterface::CreateTexture(uint32_t id, const RenderTextureDesc& desc)
+{
+    ++m_Stats.commands;
+    if (desc.width == 0 || desc.height == 0 || desc.arraySize == 0)
+    {
+        Error("CreateTexture", "empty texture");
+    }
+    if ((desc.flags & c_RenderResourceRenderTarget) && (desc.flags & c_RenderResourceDepthStencil))
+    {
+        Error("CreateTexture", "render target and depth stencil flags are exclusive");
+    }
+    Object object = { ObjectType::Texture };
+    object.flags = desc.flags;
+    object.subresources = GetMipCount(desc) * desc.arraySize;
+    m_Objects[id] = object;
+}
+
+void NullRenderInterface::ImportTexture(uint32_t id, const RenderTextureDesc& desc, void*)
+{
+    CreateTexture(id, desc);
+}
+
+void NullRenderInterface::CreateRootSignature(uint32_t id, const void*, size_t size)
+{
+    ++m_Stats.commands;
+    if (size == 0)
+    {
+        Error("CreateRootSignature", "empty blob");
+    }
+    m_Objects[id] = { ObjectType::RootSignature };
+}
+
+void NullRenderInterface::CreatePipeline(uint32_t id, uint32_t rootSignature, const void*, size_t size)
+{
+    ++m_Stats.commands;
+    Find(rootSignature, ObjectType::RootSignature, "CreatePipeline");
+    if (size == 0)
+    {
+        Error("CreatePipeline", "empty blob");
+    }
+    m_Objects[id] = { ObjectType::Pipeline };
+}
+
+void NullRenderInterface::CreateCommandSignature(uint32_t id, const std::vector<IndirectArgument>& arguments,
+    uint32_t byteStride, uint32_t rootSignature)
+{
+    ++m_Stats.commands;
+    bool hasRootSignature = rootSignature != c_RenderNoResource;
+    if (hasRootSignature)
+    {
+        Find(rootSignature, ObjectType::RootSignature, "CreateCommandSignature");
+    }
+    std::string message;
+    if (!ValidateIndirectArguments(arguments, byteStride, hasRootSignature, &message))
+    {
+        Error("CreateCommandSignature", message);
+    }
+    Object object = { ObjectType::CommandSignature };
+    object.byteStride = byteStride;
+    m_Objects[id] = object;
+}
+
+void NullRenderInterface::Destroy(uint32_t id)
+{
+    ++m_Stats.commands;
+    if (!m_Objects.erase(id))
+    {
+        Error("Destroy", "unknown id " + std::to_string(id));
+    }
+}
+
+void NullRenderInterface::UpdateBuffer(uint32_t id, uint64_t offset, const void*, uint64_t size)
+{
+    Record("UpdateBuffer");
+    m_Stats.uploadBytes += size;
+    CheckRange(id, offset, size, "UpdateBuffer");
+}
+
+void NullRenderInterface::UpdateTexture(uint32_t id, uint32_t subresource, const void*, uint64_t rowPitch, uint64_t slicePitch)
+{
+    Record("UpdateTexture");
+    m_Stats.uploadBytes += slicePitch;
+    const Object* texture = Find(id, ObjectType::Texture, "UpdateTexture");
+    if (texture && subresource >= texture->subresources)
+    {
+        Error("UpdateTexture", "subresource out of range");
+    }
+    if (rowPitch == 0 || slicePitch < rowPitch)
+    {
+        Error("UpdateTexture", "bad pitch");
+    }
+}
+
+void NullRenderInterface::Barrier(uint32_t id, uint32_t before, uint32_t after)
+{
+    Record("Barrier");
+    const Object* resource = FindObject(id, "Barrier");
+    if (resource && resource->type != ObjectType::Buffer && resource->type != ObjectType::Texture)
+    {
+        Error("Barrier", "id " + std::to_string(id) + " is not a resource");
+    }
+    if (before == after)
+    {
+        Error("Barrier", "before and after states are the same");
+    }
+}
+
+void NullRenderInterface::UnorderedBarrier(uint32_t id)
+{
+    Record("UnorderedBarrier");
+    const Object* resource = FindObject(id, "UnorderedBarrier");
+    if (resource && !(resource->flags & c_RenderResourceUnordered))
+    {
+        Error("UnorderedBarrier", "resource has no unordered access");
+    }
+}
+
+void NullRenderInterface::SetRenderTargets(uint32_t count, const uint32_t* renderTargets, uint32_t depthStencil)
+{
+    Record("SetRenderTargets");
+    if (count > c_RenderMaxRenderTargets)
+    {
+        Error("SetRenderTargets", "too many render targets");
+        count = c_RenderMaxRenderTargets;
+    }
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const Object* target = Find(renderTargets[i], ObjectType::Texture, "SetRenderTargets");
+        if (target && !(target->flags & c_RenderResourceRenderTarget))
+        {
+            Error("SetRenderTargets", "not a render target");
+        }
+    }
+    if (depthStencil != c_RenderNoResource)
+    {
+        const Object* depth = Find(depthStencil, ObjectType::Texture, "SetRenderTargets");
+        if (depth && !(depth->flags & c_RenderResourceDepthStencil))
+        {
+            Error("SetRenderTargets", "not a depth stencil");
+        }
+    }
+}
+
+void NullRenderInterface::SetViewport(float, float, float width, float height, float minDepth, float maxDepth)
+{
+    Record("SetViewport");
+    if (width <= 0.0f || height <= 0.0f || minDepth > maxDepth)
+    {
+        Error("SetViewport", "empty viewport");
+    }
+}
+
+void NullRenderInterface::ClearRenderTarget(uint32_t id, const float*)
+{
+    Record("ClearRenderTarget");
+    const Object* target = Find(id, ObjectType::Texture, "ClearRenderTarget");
+    if (target && !(target->flags & c_RenderResourceRenderTarget))
+    {
+        Error("ClearRenderTarget", "not a render target");
+    }
+}
+
+void NullRenderInterface::ClearDepthStencil(uint32_t id, float, uint8_t)
+{
+    Record("ClearDepthStencil");
+    const Object* target = Find(id, ObjectType::Texture, "ClearDepthStencil");
+    if (target && !(target->flags & c_RenderResourceDepthStencil))
+    {
+        Error("ClearDepthStencil", "not a depth stencil");
+    }
+}
+
+void NullRenderInterface::SetPipeline(uint32_t id)
+{
+    Record("SetPipeline");
+    m_HasPipeline = Find(id, ObjectType::Pipeline, "SetPipeline") != nullptr;
+}
+
+void NullRenderInterface::SetPrimitiveTopology(uint32_t)
+{
+    Record("SetPrimitiveTopology");
+}
+
+void NullRenderInterface::SetRootConstants(uint32_t, uint32_t count, const uint32_t*, uint32_t)
+{
+    Record("SetRootConstants");
+    if (!m_HasPipeline)
+    {
+        Error("SetRootConstants", "no pipeline set");
+    }
+    if (count == 0)
+    {
+        Error("SetRootConstants", "no constants");
+    }
+}
+
+void NullRenderInterface::SetRootView(uint32_t, RenderRootView type, uint32_t id, uint64_t offset)
+{
+    Record("SetRootView");
+    if (!m_HasPipeline)
+    {
+        Error("SetRootView", "no pipeline set");
+    }
+    // Root descriptors only address buffers.
+    const Object* buffer = Find(id, ObjectType::Buffer, "SetRootView");
+    if (buffer && offset >= buffer->size)
+    {
+        Error("SetRootView", "offset past the end of the buffer");
+    }
+    if (buffer && type == RenderRootView::ConstantBuffer && offset % 256 != 0)
+    {
+        Error("SetRootView", "constant buffer offset not 256-byte aligned");
+    }
+}
+
+void NullRenderInterface::SetVertexBuffer(uint32_t, uint32_t id, uint64_t offset, uint32_t size, uint32_t)
+{
+    Record("SetVertexBuffer");
+    CheckRange(id, offset, size, "SetVertexBuffer");
+}
+
+void NullRenderInterface::SetIndexBuffer(uint32_t id, uint64_t offset, uint32_t size, bool)
+{
+    Record("SetIndexBuffer");
+    CheckRange(id, offset, size, "SetIndexBuffer");
+}
+
+void NullRenderInterface::Draw(uint32_t, uint32_t, uint32_t, uint32_t)
+{
+    Record("Draw");
+    ++m_Stats.draws;
+    if (!m_HasPipeline)
+    {
+        Error("Draw", "no pipeline set");
+    }
+}
+
+void NullRenderInterface::DrawIndexed(uint32_t, uint32_t, uint32_t, int32_t, uint32_t)
+{
+    Record("DrawIndexed");
+    ++m_Stats.draws;
+    if (!m_HasPipeline)
+    {
+        Error("DrawIndexed", "no pipeline set");
+    }
+}
+
+void NullRenderInterface::Dispatch(uint32_t x, uint32_t y, uint32_t z)
+{
+    Record("Dispatch");
+    ++m_Stats.dispatches;
+    if (!m_HasPipeline)
+    {
+        Error("Dispatch", "no pipeline set");
+    }
+    if (x > 65535 || y > 65535 || z > 65535)
+    {
+        Error("Dispatch", "more than 65535 groups in a dimension");
+    }
+}
+
+void NullRenderInterface::ExecuteIndirect(uint32_t signature, uint32_t maxCount, uint32_t argumentBuffer,
+    uint64_t argumentOffset, uint32_t countBuffer, uint64_t countOffset)
+{
+    Record("ExecuteIndirect");
+    m_Stats.indirectCommands += maxCount;
+    if (!m_HasPipeline)
+    {
+        Error("ExecuteIndirect", "no pipeline set");
+    }
+    const Object* layout = Find(signature, ObjectType::CommandSignature, "ExecuteIndirect");
+    if (layout && maxCount)
+    {
+        CheckRange(argumentBuffer, argumentOffset, uint64_t(layout->byteStride) * maxCount, "ExecuteIndirect");
+    }
+    if (argumentOffset % 4 != 0)
+    {
+        Error("ExecuteIndirect", "argument offset not 4-byte aligned");
+    }
+    if (countBuffer != c_RenderNoResource)
+    {
+        CheckRange(countBuffer, countOffset, sizeof(uint32_t), "ExecuteIndirect");
+    }
+}
+
+void NullRenderInterface::CopyBuffer(uint32_t destination, uint64_t destinationOffset, uint32_t source,
+    uint64_t sourceOffset, uint64_t size)
+{
+    Record("CopyBuffer");
+    CheckRange(destination, destinationOffset, size, "CopyBuffer");
+    CheckRange(source, sourceOffset, size, "CopyBuffer");
+    if (destination == source)
+    {
+        Error("CopyBuffer", "source and destination are the same buffer");
+    }
+}
@@ -0,0 +1,227 @@
+#pragma once
+#include "IndirectArguments.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Platform-neutral command interface the renderer records through, so the
+// same frame can go to D3D12, to a capture file or to a backend without a
+// GPU. Objects are named by caller-chosen ids; creating an id that exists
+// replaces the object. Enum values match their D3D12 counterparts, as in
+// IndirectArguments.h.
+
+constexpr uint32_t c_RenderNoResource = UINT32_MAX;
+constexpr uint32_t c_RenderMaxRenderTargets = 8;
+
+// D3D12_RESOURCE_FLAGS.
+enum RenderResourceFlags : uint32_t
+{
+    c_RenderResourceRenderTarget = 0x1,
+    c_RenderResourceDepthStencil = 0x2,
+    c_RenderResourceUnordered = 0x4,
+};
+
+// D3D12_RESOURCE_STATES.
+enum RenderResourceStates : uint32_t
+{
+    c_RenderStateCommon = 0,
+    c_RenderStatePresent = 0,
+    c_RenderStateVertexAndConstantBuffer = 0x1,
+    c_RenderStateIndexBuffer = 0x2,
+    c_RenderStateRenderTarget = 0x4,
+    c_RenderStateUnorderedAccess = 0x8,
+    c_RenderStateDepthWrite = 0x10,
+    c_RenderStateDepthRead = 0x20,
+    c_RenderStateNonPixelShaderResource = 0x40,
+    c_RenderStatePixelShaderResource = 0x80,
+    c_RenderStateIndirectArgument = 0x200,
+    c_RenderStateCopyDest = 0x400,
+    c_RenderStateCopySource = 0x800,
+};
+
+// D3D_PRIMITIVE_TOPOLOGY.
+enum RenderPrimitiveTopology : uint32_t
+{
+    c_RenderTopologyTriangleList = 4,
+    c_RenderTopologyTriangleStrip = 5,
+};
+
+enum class RenderRootView : uint32_t
+{
+    ConstantBuffer,
+    ShaderResource,
+    UnorderedAccess,
+};
+
+struct RenderTextureDesc
+{
+    uint32_t width;
+    uint32_t height;
+    uint16_t arraySize;
+    uint16_t mipLevels;
+    uint32_t format;        // DXGI_FORMAT
+    uint32_t flags;         // RenderResourceFlags
+};
+
+class RenderInterface
+{
+public:
+    virtual ~RenderInterface() = default;
+
+    virtual const char* GetName() const = 0;
+
+    virtual void BeginFrame() = 0;
+    virtual void EndFrame() = 0;
+
+    // Resources start in the common state.
+    virtual void CreateBuffer(uint32_t id, uint64_t size, uint32_t flags) = 0;
+    virtual void CreateTexture(uint32_t id, const RenderTextureDesc& desc) = 0;
+    // Adopts a resource created elsewhere (a swap chain back buffer); backends
+    // that cannot use native, and captures, treat it as CreateTexture.
+    virtual void ImportTexture(uint32_t id, const RenderTextureDesc& desc, void* native) = 0;
+    // A serialized root signature.
+    virtual void CreateRootSignature(uint32_t id, const void* blob, size_t size) = 0;
+    // The blob layout belongs to the backend (see D3D12RenderInterface); the
+    // root signature is bound with the pipeline.
+    virtual void CreatePipeline(uint32_t id, uint32_t rootSignature, const void* blob, size_t size) = 0;
+    // rootSignature is c_RenderNoResource unless arguments change root parameters.
+    virtual void CreateCommandSignature(uint32_t id, const std::vector<IndirectArgument>& arguments, uint32_t byteStride,
+        uint32_t rootSignature) = 0;
+    // Resources, root signatures, pipelines and command signatures share the id space.
+    virtual void Destroy(uint32_t id) = 0;
+
+    // Copies CPU data in order with the other commands; the destination must
+    // be in the common or copy-dest state. Texture data is rowPitch bytes per
+    // row and slicePitch per depth slice, like D3D12_SUBRESOURCE_DATA.
+    virtual void UpdateBuffer(uint32_t id, uint64_t offset, const void* data, uint64_t size) = 0;
+    virtual void UpdateTexture(uint32_t id, uint32_t subresource, const void* data, uint64_t rowPitch, uint64_t slicePitch) = 0;
+
+    virtual void Barrier(uint32_t id, uint32_t before, uint32_t after) = 0;
+    virtual void UnorderedBarrier(uint32_t id) = 0;
+
+    virtual void SetRenderTargets(uint32_t count, const uint32_t* renderTargets, uint32_t depthStencil) = 0;
+    // Sets the scissor rectangle to the viewport too.
+    virtual void SetViewport(float x, float y, float width, float height, float minDepth, float maxDepth) = 0;
+    virtual void ClearRenderTarget(uint32_t id, const float color[4]) = 0;
+    virtual void ClearDepthStencil(uint32_t id, float depth, uint8_t stencil) = 0;
+
+    // Also binds the pipeline's root signature; root arguments below go to
+    // the graphics or compute slots depending on the pipeline.
+    virtual void SetPipeline(uint32_t id) = 0;
+    virtual void SetPrimitiveTopology(uint32_t topology) = 0;   // D3D_PRIMITIVE_TOPOLOGY
+    virtual void SetRootConstants(uint32_t parameter, uint32_t count, const uint32_t* values, uint32_t destOffset) = 0;
+    virtual void SetRootView(uint32_t parameter, RenderRootView type, uint32_t id, uint64_t offset) = 0;
+    virtual void SetVertexBuffer(uint32_t slot, uint32_t id, uint64_t offset, uint32_t size, uint32_t stride) = 0;
+    virtual void SetIndexBuffer(uint32_t id, uint64_t offset, uint32_t size, bool index32) = 0;
+
+    virtual void Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) = 0;
+    virtual void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex,
+        uint32_t firstInstance) = 0;
+    virtual void Dispatch(uint32_t x, uint32_t y, uint32_t z) = 0;
+    // countBuffer is c_RenderNoResource to always run maxCount commands.
+    virtual void ExecuteIndirect(uint32_t signature, uint32_t maxCount, uint32_t argumentBuffer, uint64_t argumentOffset,
+        uint32_t countBuffer, uint64_t countOffset) = 0;
+
+    virtual void CopyBuffer(uint32_t destination, uint64_t destinationOffset, uint32_t source, uint64_t sourceOffset,
+        uint64_t size) = 0;
+};
+
+// Executes nothing, but checks every call the way the runtime would (known
+// ids of the right kind, ranges inside their buffers, command signatures via
+// ValidateIndirectArguments) and counts the work. Replaying a capture into it
+// measures the CPU cost of the command stream alone, anywhere.
+class NullRenderInterface : public RenderInterface
+{
+public:
+    struct Stats
+    {
+        uint64_t commands = 0;
+        uint64_t draws = 0;
+        uint64_t dispatches = 0;
+        uint64_t indirectCommands = 0;   // maxCount summed over ExecuteIndirect
+        uint64_t uploadBytes = 0;
+        uint32_t frames = 0;
+        uint32_t errors = 0;
+    };
+
+    const char* GetName() const override { return "null"; }
+
+    void BeginFrame() override;
+    void EndFrame() override;
+
+    void CreateBuffer(uint32_t id, uint64_t size, uint32_t flags) override;
+    void CreateTexture(uint32_t id, const RenderTextureDesc& desc) override;
+    void ImportTexture(uint32_t id, const RenderTextureDesc& desc, void* native) override;
+    void CreateRootSignature(uint32_t id, const void* blob, size_t size) override;
+    void CreatePipeline(uint32_t id, uint32_t rootSignature, const void* blob, size_t size) override;
+    void CreateCommandSignature(uint32_t id, const std::vector<IndirectArgument>& arguments, uint32_t byteStride,
+        uint32_t rootSignature) override;
+    void Destroy(uint32_t id) override;
+
+    void UpdateBuffer(uint32_t id, uint64_t offset, const void* data, uint64_t size) override;
+    void UpdateTexture(uint32_t id, uint32_t subresource, const void* data, uint64_t rowPitch, uint64_t slicePitch) override;
+
+    void Barrier(uint32_t id, uint32_t before, uint32_t after) override;
+    void UnorderedBarrier(uint32_t id) override;
+
+    void SetRenderTargets(uint32_t count, const uint32_t* renderTargets, uint32_t depthStencil) override;
+    void SetViewport(float x, float y, float width, float height, float minDepth, float maxDepth) override;
+    void ClearRenderTarget(uint32_t id, const float color[4]) override;
+    void ClearDepthStencil(uint32_t id, float depth, uint8_t stencil) override;
+
+    void SetPipeline(uint32_t id) override;
+    void SetPrimitiveTopology(uint32_t topology) override;
+    void SetRootConstants(uint32_t parameter, uint32_t count, const uint32_t* values, uint32_t destOffset) override;
+    void SetRootView(uint32_t parameter, RenderRootView type, uint32_t id, uint64_t offset) override;
+    void SetVertexBuffer(uint32_t slot, uint32_t id, uint64_t offset, uint32_t size, uint32_t stride) override;
+    void SetIndexBuffer(uint32_t id, uint64_t offset, uint32_t size, bool index32) override;
+
+    void Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) override;
+    void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t baseVertex,
+        uint32_t firstInstance) override;
+    void Dispatch(uint32_t x, uint32_t y, uint32_t z) override;
+    void ExecuteIndirect(uint32_t signature, uint32_t maxCount, uint32_t argumentBuffer, uint64_t argumentOffset,
+        uint32_t countBuffer, uint64_t countOffset) override;
+
+    void CopyBuffer(uint32_t destination, uint64_t destinationOffset, uint32_t source, uint64_t sourceOffset,
+        uint64_t size) override;
+
+    const Stats& GetStats() const { return m_Stats; }
+    // The first problem found, empty if there was none.
+    const std::string& GetFirstError() const { return m_FirstError; }
+
+private:
+    enum class ObjectType : uint8_t
+    {
+        Buffer,
+        Texture,
+        RootSignature,
+        Pipeline,
+        CommandSignature,
+    };
+
+    struct Object
+    {
+        ObjectType type;
+        uint64_t size = 0;          // buffers
+        uint32_t flags = 0;         // resources
+        uint32_t subresources = 0;  // textures
+        uint32_t byteStride = 0;    // command signatures
+    };
+
+    void Error(const char* command, const std::string& message);
+    // Counts a command recorded into the frame.
+    void Record(const char* command);
+    const Object* Find(uint32_t id, ObjectType type, const char* command);
+    // Any type; the caller checks it.
+    const Object* FindObject(uint32_t id, const char* command);
+    void CheckRange(uint32_t id, uint64_t offset, uint64_t size, const char* command);
+
+    std::unordered_map<uint32_t, Object> m_Objects;
+    bool m_InFrame = false;
+    bool m_HasPipeline = false;
+    Stats m_Stats;
+    std::string m_FirstError;
+};
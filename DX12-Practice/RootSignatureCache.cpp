@@ -0,0 +1,102 @@
+#include "RootSignatureCache.h"
+#include "Hash.h"
+
+#include <cstring>
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    // Private data key of the blob hash.
+    const GUID c_BlobHashGuid = { 0x6c2f4a1e, 0x93b7, 0x4d05, { 0x8e, 0x21, 0x5a, 0xf0, 0x3c, 0x9d, 0x47, 0xb6 } };
+}
+
+uint64_t GetRootSignatureBlobHash(ID3D12RootSignature* rootSignature)
+{
+    uint64_t hash = 0;
+    UINT size = sizeof(hash);
+    if (!rootSignature || FAILED(rootSignature->GetPrivateData(c_BlobHashGuid, &size, &hash)) || size != sizeof(hash))
+    {
+        return 0;
+    }
+    return hash;
+}
+
+RootSignatureCache::RootSignatureCache(ComPtr<ID3D12Device2> device)
+    : m_Device(device)
+{
+    D3D12_FEATURE_DATA_ROOT_SIGNATURE featureData = {};
+    featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_1;
+    if (SUCCEEDED(m_Device->CheckFeatureSupport(D3D12_FEATURE_ROOT_SIGNATURE, &featureData, sizeof(featureData))))
+    {
+        m_HighestVersion = featureData.HighestVersion;
+    }
+}
+
+ID3D12RootSignature* RootSignatureCache::Get(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& desc)
+{
+    ComPtr<ID3DBlob> blob;
+    ComPtr<ID3DBlob> error;
+    if (FAILED(D3DX12SerializeVersionedRootSignature(&desc, m_HighestVersion, &blob, &error)))
+    {
+        if (error)
+        {
+            OutputDebugStringA(static_cast<const char*>(error->GetBufferPointer()));
+        }
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        ++m_Stats.requests;
+        ++m_Stats.failed;
+        return nullptr;
+    }
+
+    return Get(blob->GetBufferPointer(), blob->GetBufferSize());
+}
+
+ID3D12RootSignature* RootSignatureCache::Get(const void* blob, size_t size)
+{
+    uint64_t hash = HashBytes(blob, size);
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    ++m_Stats.requests;
+
+    if (auto rootSignature = Find(blob, size, hash))
+    {
+        return rootSignature;
+    }
+
+    Entry entry;
+    if (FAILED(m_Device->CreateRootSignature(0, blob, size, IID_PPV_ARGS(&entry.rootSignature))))
+    {
+        ++m_Stats.failed;
+        return nullptr;
+    }
+
+    entry.rootSignature->SetPrivateData(c_BlobHashGuid, sizeof(hash), &hash);
+    auto bytes = static_cast<const uint8_t*>(blob);
+    entry.blob.assign(bytes, bytes + size);
+    ++m_Stats.unique;
+
+    return m_Entries.emplace(hash, std::move(entry))->second.rootSignature.Get();
+}
+
+ID3D12RootSignature* RootSignatureCache::Find(const void* blob, size_t size, uint64_t hash) const
+{
+    // Compare the blobs too; a hash collision must not alias two layouts.
+    auto range = m_Entries.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        const auto& entry = it->second;
+        if (entry.blob.size() == size && memcmp(entry.blob.data(), blob, size) == 0)
+        {
+            return entry.rootSignature.Get();
+        }
+    }
+    return nullptr;
+}
+
+RootSignatureCacheStats RootSignatureCache::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Stats;
+}
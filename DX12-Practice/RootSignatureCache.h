@@ -0,0 +1,106 @@
+#pragma once
+#include "Win.h"
+#include <wrl/client.h>
+
+#include "directx/d3dx12.h"
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct RootSignatureCacheStats
+{
+    uint64_t requests = 0;
+    uint64_t unique = 0;
+    uint64_t failed = 0;
+};
+
+// Shares root signatures between pipelines. Descriptions are serialized with
+// D3DX12SerializeVersionedRootSignature and keyed by the serialized blob, so
+// layouts that serialize identically return the same ID3D12RootSignature and
+// command lists can skip rebinding it (see RootSignatureBinder).
+class RootSignatureCache
+{
+public:
+    explicit RootSignatureCache(Microsoft::WRL::ComPtr<ID3D12Device2> device);
+
+    RootSignatureCache(const RootSignatureCache&) = delete;
+    RootSignatureCache& operator=(const RootSignatureCache&) = delete;
+
+    // The cache keeps the returned root signature alive. Returns nullptr if the
+    // description fails to serialize.
+    ID3D12RootSignature* Get(const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& desc);
+
+    // Already-serialized blobs (e.g. embedded in a shader) go through the same table.
+    ID3D12RootSignature* Get(const void* blob, size_t size);
+
+    D3D_ROOT_SIGNATURE_VERSION GetHighestVersion() const { return m_HighestVersion; }
+    RootSignatureCacheStats GetStats() const;
+
+private:
+    struct Entry
+    {
+        std::vector<uint8_t> blob;
+        Microsoft::WRL::ComPtr<ID3D12RootSignature> rootSignature;
+    };
+
+    ID3D12RootSignature* Find(const void* blob, size_t size, uint64_t hash) const;
+
+    Microsoft::WRL::ComPtr<ID3D12Device2> m_Device;
+    D3D_ROOT_SIGNATURE_VERSION m_HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_0;
+
+    mutable std::mutex m_Mutex;
+    std::unordered_multimap<uint64_t, Entry> m_Entries;
+    RootSignatureCacheStats m_Stats;
+};
+
+// Root signatures from a RootSignatureCache carry the hash of their serialized
+// blob, which unlike the pointer is the same in every run; pipeline hashes
+// that outlive the process use it. 0 for root signatures created elsewhere.
+uint64_t GetRootSignatureBlobHash(ID3D12RootSignature* rootSignature);
+
+// Tracks the root signatures last bound on a command list and drops redundant
+// Set*RootSignature calls, which would otherwise invalidate every root
+// binding. Reset() whenever the command list is reset.
+class RootSignatureBinder
+{
+public:
+    void Reset()
+    {
+        m_Graphics = nullptr;
+        m_Compute = nullptr;
+    }
+
+    // Returns true if the root signature changed, meaning root arguments must be set again.
+    bool SetGraphics(ID3D12GraphicsCommandList* commandList, ID3D12RootSignature* rootSignature)
+    {
+        if (m_Graphics == rootSignature)
+        {
+            ++m_Skipped;
+            return false;
+        }
+        commandList->SetGraphicsRootSignature(rootSignature);
+        m_Graphics = rootSignature;
+        return true;
+    }
+
+    bool SetCompute(ID3D12GraphicsCommandList* commandList, ID3D12RootSignature* rootSignature)
+    {
+        if (m_Compute == rootSignature)
+        {
+            ++m_Skipped;
+            return false;
+        }
+        commandList->SetComputeRootSignature(rootSignature);
+        m_Compute = rootSignature;
+        return true;
+    }
+
+    uint64_t GetSkippedCount() const { return m_Skipped; }
+
+private:
+    ID3D12RootSignature* m_Graphics = nullptr;
+    ID3D12RootSignature* m_Compute = nullptr;
+    uint64_t m_Skipped = 0;
+};
@@ -0,0 +1,376 @@
+#include "ShaderBindingLayout.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <set>
+#include <tuple>
+
+namespace
+{
+    const uint32_t c_LayoutVersion = 3;
+
+    class Writer
+    {
+    public:
+        template<typename T>
+        void Write(const T& value)
+        {
+            auto bytes = reinterpret_cast<const uint8_t*>(&value);
+            m_Data.insert(m_Data.end(), bytes, bytes + sizeof(T));
+        }
+
+        void WriteString(const std::string& text)
+        {
+            Write(static_cast<uint32_t>(text.size()));
+            m_Data.insert(m_Data.end(), text.begin(), text.end());
+        }
+
+        std::vector<uint8_t> Take() { return std::move(m_Data); }
+
+    private:
+        std::vector<uint8_t> m_Data;
+    };
+
+    class Reader
+    {
+    public:
+        explicit Reader(const std::vector<uint8_t>& data)
+            : m_Data(data)
+        {
+        }
+
+        template<typename T>
+        bool Read(T& value)
+        {
+            if (m_Offset + sizeof(T) > m_Data.size())
+            {
+                return false;
+            }
+            memcpy(&value, m_Data.data() + m_Offset, sizeof(T));
+            m_Offset += sizeof(T);
+            return true;
+        }
+
+        bool ReadString(std::string& text)
+        {
+            uint32_t size = 0;
+            if (!Read(size) || m_Offset + size > m_Data.size())
+            {
+                return false;
+            }
+            text.assign(reinterpret_cast<const char*>(m_Data.data() + m_Offset), size);
+            m_Offset += size;
+            return true;
+        }
+
+        bool AtEnd() const { return m_Offset == m_Data.size(); }
+
+    private:
+        const std::vector<uint8_t>& m_Data;
+        size_t m_Offset = 0;
+    };
+}
+
+std::vector<ShaderBinding> ShaderBindingLayout::MergeStages(const std::vector<std::vector<ShaderBinding>>& stages)
+{
+    std::vector<ShaderBinding> merged;
+    for (const auto& stage : stages)
+    {
+        for (const auto& binding : stage)
+        {
+            auto same = std::find_if(merged.begin(), merged.end(), [&](const ShaderBinding& other) {
+                return other.type == binding.type && other.space == binding.space && other.bindPoint == binding.bindPoint;
+            });
+
+            if (same == merged.end())
+            {
+                merged.push_back(binding);
+                continue;
+            }
+
+            same->stages |= binding.stages;
+            same->bindCount = std::max(same->bindCount, binding.bindCount);
+            same->size = std::max(same->size, binding.size);
+            same->buffer |= binding.buffer;
+        }
+    }
+    return merged;
+}
+
+ShaderBindingLayout ShaderBindingLayout::Build(const std::vector<ShaderBinding>& bindings, const ShaderLayoutPolicy& policy)
+{
+    ShaderBindingLayout layout;
+    for (const auto& binding : bindings)
+    {
+        layout.m_Stages |= binding.stages;
+    }
+
+    // Smallest constant buffers first so as many as possible fit in the budget.
+    std::vector<const ShaderBinding*> constants;
+    for (const auto& binding : bindings)
+    {
+        if (binding.type == ShaderBindingType::ConstantBuffer && binding.bindCount == 1 &&
+            binding.size > 0 && binding.size <= policy.maxRootConstantBytes)
+        {
+            constants.push_back(&binding);
+        }
+    }
+    std::sort(constants.begin(), constants.end(), [](const ShaderBinding* a, const ShaderBinding* b) {
+        return std::tie(a->size, a->space, a->bindPoint) < std::tie(b->size, b->space, b->bindPoint);
+    });
+
+    // Tables are keyed by (is sampler, visibility, unbounded array index + 1
+    // or 0 for the table of bounded bindings).
+    auto getTableKey = [&](const ShaderBinding& binding)
+    {
+        uint32_t unbounded = binding.bindCount == c_ShaderBindingUnbounded
+            ? static_cast<uint32_t>(&binding - bindings.data()) + 1 : 0;
+        return std::make_tuple(binding.type == ShaderBindingType::Sampler, binding.stages, unbounded);
+    };
+    using TableKey = decltype(getTableKey(bindings.front()));
+
+    // Reserve one DWORD for every table the bindings could end up in.
+    std::set<TableKey> possibleTables;
+    for (const auto& binding : bindings)
+    {
+        possibleTables.insert(getTableKey(binding));
+    }
+    uint32_t tableReserve = static_cast<uint32_t>(possibleTables.size());
+    uint32_t budget = policy.rootSignatureDwords > tableReserve ? policy.rootSignatureDwords - tableReserve : 0;
+
+    std::vector<const ShaderBinding*> rootConstants;
+    for (const auto* binding : constants)
+    {
+        uint32_t dwords = (binding->size + 3) / 4;
+        if (dwords > budget)
+        {
+            break;
+        }
+        budget -= dwords;
+        rootConstants.push_back(binding);
+
+        ShaderRootParameter parameter;
+        parameter.kind = ShaderRootParameter::Kind::Constants;
+        parameter.stages = binding->stages;
+        parameter.shaderRegister = binding->bindPoint;
+        parameter.space = binding->space;
+        parameter.num32BitValues = dwords;
+        layout.m_Locations.push_back({ binding->name, static_cast<uint32_t>(layout.m_Parameters.size()), 0 });
+        layout.m_Parameters.push_back(std::move(parameter));
+    }
+
+    // Root descriptors in register order; arrays and samplers cannot be one.
+    std::vector<const ShaderBinding*> rootDescriptors;
+    if (policy.rootDescriptors)
+    {
+        for (const auto& binding : bindings)
+        {
+            if (binding.buffer && binding.bindCount == 1 && binding.type != ShaderBindingType::Sampler &&
+                std::find(rootConstants.begin(), rootConstants.end(), &binding) == rootConstants.end())
+            {
+                rootDescriptors.push_back(&binding);
+            }
+        }
+        std::sort(rootDescriptors.begin(), rootDescriptors.end(), [](const ShaderBinding* a, const ShaderBinding* b) {
+            return std::tie(a->type, a->space, a->bindPoint) < std::tie(b->type, b->space, b->bindPoint);
+        });
+        if (rootDescriptors.size() > budget / 2)
+        {
+            rootDescriptors.resize(budget / 2);
+        }
+    }
+    for (const auto* binding : rootDescriptors)
+    {
+        ShaderRootParameter parameter;
+        parameter.kind = ShaderRootParameter::Kind::Descriptor;
+        parameter.stages = binding->stages;
+        parameter.shaderRegister = binding->bindPoint;
+        parameter.space = binding->space;
+        parameter.descriptorType = binding->type;
+        layout.m_Locations.push_back({ binding->name, static_cast<uint32_t>(layout.m_Parameters.size()), 0 });
+        layout.m_Parameters.push_back(std::move(parameter));
+    }
+
+    // Group the rest into tables. Inside a table, bindings are ordered by
+    // type, space and register so that neighbouring registers collapse into a
+    // single range.
+    std::map<TableKey, std::vector<const ShaderBinding*>> tables;
+    for (const auto& binding : bindings)
+    {
+        if (std::find(rootConstants.begin(), rootConstants.end(), &binding) != rootConstants.end() ||
+            std::find(rootDescriptors.begin(), rootDescriptors.end(), &binding) != rootDescriptors.end())
+        {
+            continue;
+        }
+        tables[getTableKey(binding)].push_back(&binding);
+    }
+
+    for (auto& table : tables)
+    {
+        auto& members = table.second;
+        std::sort(members.begin(), members.end(), [](const ShaderBinding* a, const ShaderBinding* b) {
+            return std::tie(a->type, a->space, a->bindPoint) < std::tie(b->type, b->space, b->bindPoint);
+        });
+
+        ShaderRootParameter parameter;
+        parameter.kind = ShaderRootParameter::Kind::DescriptorTable;
+        parameter.stages = std::get<1>(table.first);
+        uint32_t rootIndex = static_cast<uint32_t>(layout.m_Parameters.size());
+
+        for (const auto* binding : members)
+        {
+            auto& ranges = parameter.ranges;
+            bool extends = !ranges.empty() &&
+                ranges.back().type == binding->type &&
+                ranges.back().space == binding->space &&
+                ranges.back().baseRegister + ranges.back().count == binding->bindPoint;
+
+            if (extends)
+            {
+                ranges.back().count += binding->bindCount;
+            }
+            else
+            {
+                ranges.push_back({ binding->type, binding->bindPoint, binding->space, binding->bindCount, parameter.tableSize });
+            }
+
+            layout.m_Locations.push_back({ binding->name, rootIndex, parameter.tableSize });
+            parameter.tableSize = binding->bindCount == c_ShaderBindingUnbounded
+                ? c_ShaderBindingUnbounded : parameter.tableSize + binding->bindCount;
+        }
+
+        layout.m_Parameters.push_back(std::move(parameter));
+    }
+
+    return layout;
+}
+
+const ShaderBindingLocation* ShaderBindingLayout::Find(const std::string& name) const
+{
+    for (const auto& location : m_Locations)
+    {
+        if (location.name == name)
+        {
+            return &location;
+        }
+    }
+    return nullptr;
+}
+
+uint32_t ShaderBindingLayout::GetCostInDwords() const
+{
+    uint32_t cost = 0;
+    for (const auto& parameter : m_Parameters)
+    {
+        switch (parameter.kind)
+        {
+        case ShaderRootParameter::Kind::Constants:
+            cost += parameter.num32BitValues;
+            break;
+        case ShaderRootParameter::Kind::Descriptor:
+            cost += 2;
+            break;
+        default:
+            cost += 1;
+            break;
+        }
+    }
+    return cost;
+}
+
+std::vector<uint8_t> ShaderBindingLayout::Serialize() const
+{
+    Writer writer;
+    writer.Write(c_LayoutVersion);
+    writer.Write(m_Stages);
+
+    writer.Write(static_cast<uint32_t>(m_Parameters.size()));
+    for (const auto& parameter : m_Parameters)
+    {
+        writer.Write(parameter.kind);
+        writer.Write(parameter.stages);
+        writer.Write(parameter.shaderRegister);
+        writer.Write(parameter.space);
+        writer.Write(parameter.num32BitValues);
+        writer.Write(parameter.descriptorType);
+        writer.Write(parameter.tableSize);
+        writer.Write(static_cast<uint32_t>(parameter.ranges.size()));
+        for (const auto& range : parameter.ranges)
+        {
+            writer.Write(range.type);
+            writer.Write(range.baseRegister);
+            writer.Write(range.space);
+            writer.Write(range.count);
+            writer.Write(range.tableOffset);
+        }
+    }
+
+    writer.Write(static_cast<uint32_t>(m_Locations.size()));
+    for (const auto& location : m_Locations)
+    {
+        writer.WriteString(location.name);
+        writer.Write(location.rootIndex);
+        writer.Write(location.tableOffset);
+    }
+    return writer.Take();
+}
+
+bool ShaderBindingLayout::Deserialize(const std::vector<uint8_t>& data)
+{
+    Reader reader(data);
+    ShaderBindingLayout layout;
+
+    uint32_t version = 0;
+    uint32_t count = 0;
+    if (!reader.Read(version) || version != c_LayoutVersion || !reader.Read(layout.m_Stages) ||
+        !reader.Read(count) || count > data.size())
+    {
+        return false;
+    }
+
+    layout.m_Parameters.resize(count);
+    for (auto& parameter : layout.m_Parameters)
+    {
+        uint32_t rangeCount = 0;
+        if (!reader.Read(parameter.kind) || !reader.Read(parameter.stages) ||
+            !reader.Read(parameter.shaderRegister) || !reader.Read(parameter.space) ||
+            !reader.Read(parameter.num32BitValues) || !reader.Read(parameter.descriptorType) ||
+            !reader.Read(parameter.tableSize) ||
+            !reader.Read(rangeCount) || rangeCount > data.size())
+        {
+            return false;
+        }
+
+        parameter.ranges.resize(rangeCount);
+        for (auto& range : parameter.ranges)
+        {
+            if (!reader.Read(range.type) || !reader.Read(range.baseRegister) || !reader.Read(range.space) ||
+                !reader.Read(range.count) || !reader.Read(range.tableOffset))
+            {
+                return false;
+            }
+        }
+    }
+
+    if (!reader.Read(count) || count > data.size())
+    {
+        return false;
+    }
+    layout.m_Locations.resize(count);
+    for (auto& location : layout.m_Locations)
+    {
+        if (!reader.ReadString(location.name) || !reader.Read(location.rootIndex) || !reader.Read(location.tableOffset))
+        {
+            return false;
+        }
+    }
+
+    if (!reader.AtEnd())
+    {
+        return false;
+    }
+
+    *this = std::move(layout);
+    return true;
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class ShaderBindingType : uint8_t
+{
+    ConstantBuffer,
+    ShaderResource,
+    UnorderedAccess,
+    Sampler,
+};
+
+enum ShaderStageMask : uint8_t
+{
+    ShaderStageVertex = 1 << 0,
+    ShaderStagePixel = 1 << 1,
+    ShaderStageCompute = 1 << 2,
+    ShaderStageAmplification = 1 << 3,
+    ShaderStageMesh = 1 << 4,
+};
+
+// bindCount of an unbounded array (Texture2D t[] : register(t0)); its range
+// is unbounded too (D3D12 uses the same value).
+const uint32_t c_ShaderBindingUnbounded = UINT32_MAX;
+
+// One resource binding as reported by shader reflection.
+struct ShaderBinding
+{
+    std::string name;
+    ShaderBindingType type = ShaderBindingType::ConstantBuffer;
+    uint32_t bindPoint = 0;
+    uint32_t bindCount = 1;  // or c_ShaderBindingUnbounded
+    uint32_t space = 0;
+    uint32_t size = 0;      // constant buffers only, in bytes
+    uint8_t stages = 0;
+    bool buffer = false;    // constant, raw or structured buffer: may be a root descriptor
+};
+
+struct ShaderDescriptorRange
+{
+    ShaderBindingType type;
+    uint32_t baseRegister;
+    uint32_t space;
+    uint32_t count;
+    uint32_t tableOffset;   // in descriptors from the start of the table
+};
+
+struct ShaderRootParameter
+{
+    enum class Kind : uint8_t
+    {
+        Constants,
+        Descriptor,
+        DescriptorTable,
+    };
+
+    Kind kind = Kind::Constants;
+    uint8_t stages = 0;     // visibility; more than one stage means ALL
+
+    // Constants and Descriptor
+    uint32_t shaderRegister = 0;
+    uint32_t space = 0;
+    uint32_t num32BitValues = 0;
+    ShaderBindingType descriptorType = ShaderBindingType::ConstantBuffer;
+
+    // Descriptor table; a table holds either samplers or CBV/SRV/UAVs.
+    std::vector<ShaderDescriptorRange> ranges;
+    uint32_t tableSize = 0;     // c_ShaderBindingUnbounded for an unbounded array
+};
+
+// Where a named binding lives in the generated root signature.
+struct ShaderBindingLocation
+{
+    std::string name;
+    uint32_t rootIndex;
+    uint32_t tableOffset;   // descriptor offset in the table; 0 for root constants
+};
+
+struct ShaderLayoutPolicy
+{
+    // Constant buffers up to this size become root constants.
+    uint32_t maxRootConstantBytes = 64;
+    // D3D12 allows 64 DWORDs per root signature; tables cost 1.
+    uint32_t rootSignatureDwords = 64;
+    // Buffers that are not root constants become root descriptors (2 DWORDs
+    // each) while the budget lasts, for passes that bind GPU addresses
+    // instead of descriptor tables.
+    bool rootDescriptors = false;
+};
+
+// Compact root signature layout generated from the merged bindings of all
+// stages in a pipeline: small constant buffers first as root constants, then
+// root descriptors if the policy asks for them, then one CBV/SRV/UAV table
+// and one sampler table per visibility. An unbounded array gets a table of
+// its own, as nothing can follow it in a table.
+// Independent of D3D12 so it can be generated, cached and inspected anywhere.
+class ShaderBindingLayout
+{
+public:
+    // Merges per-stage binding lists; the same register in several stages is
+    // one binding visible to all of them.
+    static std::vector<ShaderBinding> MergeStages(const std::vector<std::vector<ShaderBinding>>& stages);
+
+    static ShaderBindingLayout Build(const std::vector<ShaderBinding>& bindings, const ShaderLayoutPolicy& policy = {});
+
+    const std::vector<ShaderRootParameter>& GetParameters() const { return m_Parameters; }
+    const std::vector<ShaderBindingLocation>& GetLocations() const { return m_Locations; }
+    const ShaderBindingLocation* Find(const std::string& name) const;
+    uint8_t GetStages() const { return m_Stages; }
+    uint32_t GetCostInDwords() const;
+
+    std::vector<uint8_t> Serialize() const;
+    bool Deserialize(const std::vector<uint8_t>& data);
+
+private:
+    std::vector<ShaderRootParameter> m_Parameters;
+    std::vector<ShaderBindingLocation> m_Locations;
+    uint8_t m_Stages = 0;
+};
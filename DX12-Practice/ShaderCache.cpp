@@ -0,0 +1,418 @@
+#include "ShaderCache.h"
+#include "Hash.h"
+#include "JobSystem.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
+
+namespace
+{
+    struct CacheFileHeader
+    {
+        static const uint32_t c_Magic = 0x43535844; // 'DXSC'
+        static const uint32_t c_Version = 1;
+
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        uint64_t payloadSize;
+        uint64_t payloadHash;
+    };
+
+    bool ReadTextFile(const std::filesystem::path& path, std::string& text)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            return false;
+        }
+        std::ostringstream contents;
+        contents << file.rdbuf();
+        text = contents.str();
+        return true;
+    }
+
+    // Pulls the file name out of an #include line, or returns false.
+    bool ParseInclude(const std::string& line, std::string& name)
+    {
+        size_t pos = line.find_first_not_of(" \t");
+        if (pos == std::string::npos || line[pos] != '#')
+        {
+            return false;
+        }
+        pos = line.find_first_not_of(" \t", pos + 1);
+        if (pos == std::string::npos || line.compare(pos, 7, "include") != 0)
+        {
+            return false;
+        }
+        pos = line.find_first_of("\"<", pos + 7);
+        if (pos == std::string::npos)
+        {
+            return false;
+        }
+        size_t end = line.find(line[pos] == '"' ? '"' : '>', pos + 1);
+        if (end == std::string::npos)
+        {
+            return false;
+        }
+        name = line.substr(pos + 1, end - pos - 1);
+        return true;
+    }
+
+    // Hashes every include reachable from text. Conditional includes are
+    // hashed too; a few extra files in the key only cost a spurious rebuild.
+    uint64_t HashIncludes(const std::string& text, const std::filesystem::path& dir, const ShaderDesc& desc,
+        std::unordered_set<std::string>& visited, uint64_t hash)
+    {
+        std::istringstream lines(text);
+        std::string line;
+        std::string name;
+        while (std::getline(lines, line))
+        {
+            if (!ParseInclude(line, name))
+            {
+                continue;
+            }
+
+            std::vector<std::filesystem::path> searchDirs = { dir };
+            searchDirs.insert(searchDirs.end(), desc.includeDirs.begin(), desc.includeDirs.end());
+
+            bool found = false;
+            for (const auto& searchDir : searchDirs)
+            {
+                auto path = (searchDir / name).lexically_normal();
+                std::string include;
+                if (!ReadTextFile(path, include))
+                {
+                    continue;
+                }
+
+                found = true;
+                hash = HashString(name.c_str(), hash);
+                if (visited.insert(path.generic_string()).second)
+                {
+                    hash = HashBytes(include.data(), include.size(), hash);
+                    hash = HashIncludes(include, path.parent_path(), desc, visited, hash);
+                }
+                break;
+            }
+
+            if (!found)
+            {
+                // Still part of the key; the compile will report the error.
+                hash = HashString(name.c_str(), HashValue<uint32_t>(0xdeadbeef, hash));
+            }
+        }
+        return hash;
+    }
+
+    uint64_t HashDesc(const ShaderDesc& desc)
+    {
+        uint64_t hash = HashString(desc.path.generic_string().c_str());
+        hash = HashString(desc.entryPoint.c_str(), hash);
+        hash = HashString(desc.target.c_str(), hash);
+        for (const auto& define : desc.defines)
+        {
+            hash = HashString(define.name.c_str(), hash);
+            hash = HashString(define.value.c_str(), hash);
+        }
+        for (const auto& dir : desc.includeDirs)
+        {
+            hash = HashString(dir.generic_string().c_str(), hash);
+        }
+        return HashValue(desc.debug, hash);
+    }
+}
+
+struct ShaderCache::Entry
+{
+    ShaderDesc desc;
+    uint64_t key = 0;
+    std::vector<uint8_t> bytecode;
+    std::string errors;
+    std::atomic<ShaderStatus> status{ ShaderStatus::Pending };
+};
+
+ShaderCache::ShaderCache(std::unique_ptr<ShaderCompiler> compiler, JobSystem& jobSystem, const std::filesystem::path& cacheDir)
+    : m_Compiler(std::move(compiler))
+    , m_JobSystem(jobSystem)
+    , m_CacheDir(cacheDir)
+{
+    std::error_code error;
+    std::filesystem::create_directories(m_CacheDir, error);
+}
+
+ShaderCache::~ShaderCache()
+{
+    WaitAll();
+}
+
+uint64_t ShaderCache::ComputeKey(const ShaderDesc& desc, const std::string& compilerVersion, std::string* source,
+    std::vector<std::filesystem::path>* dependencies)
+{
+    std::string text;
+    if (!ReadTextFile(desc.path, text))
+    {
+        if (dependencies)
+        {
+            dependencies->assign(1, desc.path.lexically_normal());
+        }
+        return 0;
+    }
+
+    uint64_t hash = HashString(compilerVersion.c_str());
+    hash = HashBytes(text.data(), text.size(), hash);
+
+    std::unordered_set<std::string> visited;
+    visited.insert(desc.path.lexically_normal().generic_string());
+    hash = HashIncludes(text, desc.path.parent_path(), desc, visited, hash);
+
+    // Define order does not change the result unless a macro is defined twice.
+    auto defines = desc.defines;
+    std::sort(defines.begin(), defines.end(), [](const ShaderDefine& a, const ShaderDefine& b) { return a.name < b.name; });
+    for (const auto& define : defines)
+    {
+        hash = HashString(define.name.c_str(), hash);
+        hash = HashString(define.value.c_str(), hash);
+    }
+
+    hash = HashString(desc.entryPoint.c_str(), hash);
+    hash = HashString(desc.target.c_str(), hash);
+    hash = HashValue(desc.debug, hash);
+
+    if (source)
+    {
+        *source = std::move(text);
+    }
+    if (dependencies)
+    {
+        dependencies->assign(visited.begin(), visited.end());
+    }
+    return hash ? hash : 1;
+}
+
+bool ShaderCache::ReadCacheFile(const std::filesystem::path& cacheDir, uint64_t key, const char* extension, std::vector<uint8_t>& payload)
+{
+    MappedFile file;
+    if (!file.Open(cacheDir / (HashToString(key) + "." + extension)) || file.GetSize() < sizeof(CacheFileHeader))
+    {
+        return false;
+    }
+
+    CacheFileHeader header;
+    memcpy(&header, file.GetData(), sizeof(header));
+    const uint8_t* data = file.GetData() + sizeof(header);
+    if (header.magic != CacheFileHeader::c_Magic ||
+        header.version != CacheFileHeader::c_Version ||
+        header.key != key ||
+        header.payloadSize != file.GetSize() - sizeof(header) ||
+        header.payloadHash != HashBytes(data, static_cast<size_t>(header.payloadSize)))
+    {
+        return false;
+    }
+
+    payload.assign(data, data + header.payloadSize);
+    return true;
+}
+
+bool ShaderCache::WriteCacheFile(const std::filesystem::path& cacheDir, uint64_t key, const char* extension, const std::vector<uint8_t>& payload)
+{
+    CacheFileHeader header = {};
+    header.magic = CacheFileHeader::c_Magic;
+    header.version = CacheFileHeader::c_Version;
+    header.key = key;
+    header.payloadSize = payload.size();
+    header.payloadHash = HashBytes(payload.data(), payload.size());
+
+    std::vector<uint8_t> data(sizeof(header) + payload.size());
+    memcpy(data.data(), &header, sizeof(header));
+    if (!payload.empty())
+    {
+        memcpy(data.data() + sizeof(header), payload.data(), payload.size());
+    }
+
+    // Concurrent writers of the same key produce identical files, so the
+    // atomic rename makes the race harmless.
+    return WriteFileAtomic(cacheDir / (HashToString(key) + "." + extension), data.data(), data.size());
+}
+
+ShaderHandle ShaderCache::Request(const ShaderDesc& desc)
+{
+    uint64_t descHash = HashDesc(desc);
+
+    Entry* entry = nullptr;
+    ShaderHandle handle;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        ++m_Stats.requests;
+
+        auto found = m_Lookup.find(descHash);
+        if (found != m_Lookup.end())
+        {
+            ++m_Stats.duplicates;
+            handle.index = found->second;
+            return handle;
+        }
+
+        handle.index = static_cast<uint32_t>(m_Entries.size());
+        m_Entries.emplace_back(std::make_unique<Entry>());
+        m_Lookup.emplace(descHash, handle.index);
+        entry = m_Entries.back().get();
+        entry->desc = desc;
+    }
+
+    m_PendingCount.fetch_add(1, std::memory_order_relaxed);
+    m_JobSystem.Submit([this, entry] { Build(*entry); });
+    return handle;
+}
+
+void ShaderCache::Build(Entry& entry)
+{
+    std::vector<uint8_t> bytecode;
+    std::string errors;
+    uint64_t key = 0;
+    bool ready = Compile(entry.desc, bytecode, errors, nullptr, &key);
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        entry.key = key;
+        entry.bytecode = std::move(bytecode);
+        entry.errors = std::move(errors);
+    }
+
+    entry.status.store(ready ? ShaderStatus::Ready : ShaderStatus::Failed, std::memory_order_release);
+    m_PendingCount.fetch_sub(1, std::memory_order_release);
+}
+
+bool ShaderCache::Compile(const ShaderDesc& desc, std::vector<uint8_t>& bytecode, std::string& errors,
+    std::vector<std::filesystem::path>* dependencies, uint64_t* key)
+{
+    std::string version = GetCompilerVersion();
+    std::string source;
+    uint64_t contentKey = ComputeKey(desc, version, &source, dependencies);
+
+    bool diskHit = false;
+    bool compiled = false;
+    double milliseconds = 0.0;
+    bytecode.clear();
+    errors.clear();
+
+    if (contentKey == 0)
+    {
+        errors = "Cannot read " + desc.path.string();
+    }
+    else if (ReadCacheFile(m_CacheDir, contentKey, "cso", bytecode))
+    {
+        diskHit = true;
+    }
+    else if (!m_Compiler)
+    {
+        errors = "No shader compiler available for " + desc.path.string();
+    }
+    else
+    {
+        auto t0 = std::chrono::high_resolution_clock::now();
+        compiled = m_Compiler->Compile(desc, source, bytecode, errors);
+        milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - t0).count();
+        if (compiled)
+        {
+            WriteCacheFile(m_CacheDir, contentKey, "cso", bytecode);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stats.compileMilliseconds += milliseconds;
+        if (diskHit)
+        {
+            ++m_Stats.diskHits;
+        }
+        else if (compiled)
+        {
+            ++m_Stats.compiled;
+        }
+        else
+        {
+            ++m_Stats.failed;
+        }
+    }
+
+    if (key)
+    {
+        *key = contentKey;
+    }
+    return diskHit || compiled;
+}
+
+ShaderStatus ShaderCache::GetStatus(ShaderHandle handle) const
+{
+    if (!handle.IsValid())
+    {
+        return ShaderStatus::Failed;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Entries[handle.index]->status.load(std::memory_order_acquire);
+}
+
+const std::vector<uint8_t>* ShaderCache::GetBytecode(ShaderHandle handle) const
+{
+    if (GetStatus(handle) != ShaderStatus::Ready)
+    {
+        return nullptr;
+    }
+
+    // Bytecode is immutable once Ready.
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return &m_Entries[handle.index]->bytecode;
+}
+
+std::string ShaderCache::GetErrors(ShaderHandle handle) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return handle.IsValid() ? m_Entries[handle.index]->errors : std::string();
+}
+
+uint64_t ShaderCache::GetKey(ShaderHandle handle) const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return handle.IsValid() ? m_Entries[handle.index]->key : 0;
+}
+
+void ShaderCache::Wait(ShaderHandle handle)
+{
+    while (GetStatus(handle) == ShaderStatus::Pending)
+    {
+        if (!m_JobSystem.TryRunOne())
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void ShaderCache::WaitAll()
+{
+    while (m_PendingCount.load(std::memory_order_acquire) != 0)
+    {
+        if (!m_JobSystem.TryRunOne())
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+std::string ShaderCache::GetCompilerVersion() const
+{
+    return m_Compiler ? m_Compiler->GetVersion() : std::string("none");
+}
+
+ShaderCacheStats ShaderCache::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Stats;
+}
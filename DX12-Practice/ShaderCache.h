@@ -0,0 +1,105 @@
+#pragma once
+#include "ShaderCompiler.h"
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class JobSystem;
+
+struct ShaderHandle
+{
+    uint32_t index = UINT32_MAX;
+
+    bool IsValid() const { return index != UINT32_MAX; }
+};
+
+enum class ShaderStatus : uint32_t
+{
+    Pending,
+    Ready,
+    Failed,
+};
+
+struct ShaderCacheStats
+{
+    uint64_t requests = 0;
+    uint64_t duplicates = 0;
+    uint64_t diskHits = 0;
+    uint64_t compiled = 0;
+    uint64_t failed = 0;
+    double compileMilliseconds = 0.0;
+};
+
+// Content-addressed shader build service. A shader's key hashes its source,
+// every file it (transitively) includes, the sorted defines, entry point,
+// target, flags and the compiler version. Keys are looked up in an on-disk
+// blob cache; misses are compiled on the job system, so a batch of Request()
+// calls compiles in parallel. Nothing here depends on D3D12, so the key and
+// cache-file code behaves the same on Linux.
+class ShaderCache
+{
+public:
+    ShaderCache(std::unique_ptr<ShaderCompiler> compiler, JobSystem& jobSystem, const std::filesystem::path& cacheDir);
+    ~ShaderCache();
+
+    ShaderCache(const ShaderCache&) = delete;
+    ShaderCache& operator=(const ShaderCache&) = delete;
+
+    // Requests with the same description return the same handle.
+    ShaderHandle Request(const ShaderDesc& desc);
+
+    ShaderStatus GetStatus(ShaderHandle handle) const;
+
+    // Returns nullptr until the shader is Ready.
+    const std::vector<uint8_t>* GetBytecode(ShaderHandle handle) const;
+    std::string GetErrors(ShaderHandle handle) const;
+
+    // Content key of a finished shader (0 while pending or if the source is missing).
+    uint64_t GetKey(ShaderHandle handle) const;
+
+    // Builds desc on the calling thread, through the disk cache but outside
+    // the request table, so the same description yields new bytecode after
+    // its files change (hot reload). dependencies receives the main file and
+    // every include that was found.
+    bool Compile(const ShaderDesc& desc, std::vector<uint8_t>& bytecode, std::string& errors,
+        std::vector<std::filesystem::path>* dependencies = nullptr, uint64_t* key = nullptr);
+
+    void Wait(ShaderHandle handle);
+    void WaitAll();
+
+    const std::filesystem::path& GetCacheDir() const { return m_CacheDir; }
+    std::string GetCompilerVersion() const;
+    ShaderCacheStats GetStats() const;
+
+    // Reads desc.path and its includes; returns 0 if the main file is missing.
+    static uint64_t ComputeKey(const ShaderDesc& desc, const std::string& compilerVersion, std::string* source = nullptr,
+        std::vector<std::filesystem::path>* dependencies = nullptr);
+
+    // Cache files are "<key>.<extension>" under cacheDir, each with a small
+    // header (magic, format version, key, payload size and hash). Anything
+    // that fails validation is treated as a miss.
+    static bool ReadCacheFile(const std::filesystem::path& cacheDir, uint64_t key, const char* extension, std::vector<uint8_t>& payload);
+    static bool WriteCacheFile(const std::filesystem::path& cacheDir, uint64_t key, const char* extension, const std::vector<uint8_t>& payload);
+
+private:
+    struct Entry;
+
+    void Build(Entry& entry);
+
+    std::unique_ptr<ShaderCompiler> m_Compiler;
+    JobSystem& m_JobSystem;
+    std::filesystem::path m_CacheDir;
+
+    mutable std::mutex m_Mutex;
+    std::deque<std::unique_ptr<Entry>> m_Entries;
+    std::unordered_map<uint64_t, uint32_t> m_Lookup;
+    std::atomic<uint32_t> m_PendingCount{ 0 };
+    ShaderCacheStats m_Stats;
+};
@@ -0,0 +1,285 @@
+#include "ShaderCompiler.h"
+
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+#if defined(DX12_PRACTICE_USE_DXC)
+
+#if defined(_WIN32)
+#include "Win.h"
+#endif
+#include <dxc/dxcapi.h>
+
+namespace
+{
+    // Minimal owning pointer; WRL is not available with DXC's Linux headers.
+    template<typename T>
+    class DxcRef
+    {
+    public:
+        DxcRef() = default;
+        ~DxcRef() { if (m_Ptr) m_Ptr->Release(); }
+        DxcRef(const DxcRef&) = delete;
+        DxcRef& operator=(const DxcRef&) = delete;
+
+        T** operator&() { return &m_Ptr; }
+        T* operator->() const { return m_Ptr; }
+        T* Get() const { return m_Ptr; }
+        explicit operator bool() const { return m_Ptr != nullptr; }
+
+    private:
+        T* m_Ptr = nullptr;
+    };
+
+    std::wstring Widen(const std::string& text)
+    {
+        // Arguments are expected to be ASCII (entry points, targets, macros, paths).
+        return std::wstring(text.begin(), text.end());
+    }
+
+    // DXC starts at shader model 6.0; "vs_5_1" and the like become "vs_6_0".
+    std::string GetDxcTarget(const std::string& target)
+    {
+        size_t model = target.find('_');
+        if (model != std::string::npos && target.compare(model, 3, "_5_") == 0)
+        {
+            return target.substr(0, model) + "_6_0";
+        }
+        return target;
+    }
+
+    class DxcShaderCompiler : public ShaderCompiler
+    {
+    public:
+        bool Init()
+        {
+            DxcRef<IDxcCompiler3> compiler;
+            if (FAILED(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&compiler))))
+            {
+                return false;
+            }
+
+            UINT32 major = 0, minor = 0;
+            DxcRef<IDxcVersionInfo> versionInfo;
+            if (SUCCEEDED(compiler->QueryInterface(IID_PPV_ARGS(&versionInfo))))
+            {
+                versionInfo->GetVersion(&major, &minor);
+            }
+            m_Version = "dxc-" + std::to_string(major) + "." + std::to_string(minor);
+
+            DxcRef<IDxcVersionInfo2> versionInfo2;
+            if (SUCCEEDED(compiler->QueryInterface(IID_PPV_ARGS(&versionInfo2))))
+            {
+                UINT32 commitCount = 0;
+                char* commitHash = nullptr;
+                if (SUCCEEDED(versionInfo2->GetCommitInfo(&commitCount, &commitHash)) && commitHash)
+                {
+                    m_Version += std::string("-") + commitHash;
+                    CoTaskMemFree(commitHash);
+                }
+            }
+            return true;
+        }
+
+        std::string GetVersion() const override { return m_Version; }
+
+        bool Compile(const ShaderDesc& desc, const std::string& source, std::vector<uint8_t>& bytecode, std::string& errors) override
+        {
+            // DXC objects are not free-threaded; create them per call.
+            DxcRef<IDxcUtils> utils;
+            DxcRef<IDxcCompiler3> compiler;
+            DxcRef<IDxcIncludeHandler> includeHandler;
+            if (FAILED(DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&utils))) ||
+                FAILED(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&compiler))) ||
+                FAILED(utils->CreateDefaultIncludeHandler(&includeHandler)))
+            {
+                errors = "Failed to create DXC instance";
+                return false;
+            }
+
+            std::vector<std::wstring> storage;
+            storage.push_back(Widen(desc.path.generic_string()));
+            storage.push_back(L"-E");
+            storage.push_back(Widen(desc.entryPoint));
+            storage.push_back(L"-T");
+            storage.push_back(Widen(GetDxcTarget(desc.target)));
+            storage.push_back(L"-I");
+            storage.push_back(Widen(desc.path.parent_path().generic_string()));
+            for (const auto& dir : desc.includeDirs)
+            {
+                storage.push_back(L"-I");
+                storage.push_back(Widen(dir.generic_string()));
+            }
+            for (const auto& define : desc.defines)
+            {
+                storage.push_back(L"-D");
+                storage.push_back(Widen(define.value.empty() ? define.name : define.name + "=" + define.value));
+            }
+            storage.push_back(desc.debug ? L"-Zi" : L"-O3");
+            if (desc.debug)
+            {
+                storage.push_back(L"-Qembed_debug");
+            }
+
+            std::vector<LPCWSTR> arguments;
+            for (const auto& argument : storage)
+            {
+                arguments.push_back(argument.c_str());
+            }
+
+            DxcBuffer sourceBuffer = { source.data(), source.size(), DXC_CP_UTF8 };
+            DxcRef<IDxcResult> result;
+            if (FAILED(compiler->Compile(&sourceBuffer, arguments.data(), static_cast<UINT32>(arguments.size()), includeHandler.Get(), IID_PPV_ARGS(&result))))
+            {
+                errors = "DXC invocation failed";
+                return false;
+            }
+
+            DxcRef<IDxcBlobUtf8> errorBlob;
+            if (SUCCEEDED(result->GetOutput(DXC_OUT_ERRORS, IID_PPV_ARGS(&errorBlob), nullptr)) && errorBlob && errorBlob->GetStringLength() > 0)
+            {
+                errors.assign(errorBlob->GetStringPointer(), errorBlob->GetStringLength());
+            }
+
+            HRESULT status = E_FAIL;
+            result->GetStatus(&status);
+            DxcRef<IDxcBlob> object;
+            if (FAILED(status) || FAILED(result->GetOutput(DXC_OUT_OBJECT, IID_PPV_ARGS(&object), nullptr)) || !object)
+            {
+                return false;
+            }
+
+            auto data = static_cast<const uint8_t*>(object->GetBufferPointer());
+            bytecode.assign(data, data + object->GetBufferSize());
+            return true;
+        }
+
+    private:
+        std::string m_Version;
+    };
+}
+
+std::unique_ptr<ShaderCompiler> CreateShaderCompiler()
+{
+    auto compiler = std::make_unique<DxcShaderCompiler>();
+    return compiler->Init() ? std::move(compiler) : nullptr;
+}
+
+#elif defined(_WIN32)
+
+#include "Win.h"
+#include <wrl/client.h>
+#include <d3dcompiler.h>
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    // Resolves #include relative to the including file, then the include directories.
+    class IncludeHandler : public ID3DInclude
+    {
+    public:
+        IncludeHandler(const std::filesystem::path& root, const std::vector<std::filesystem::path>& includeDirs)
+            : m_Root(root.parent_path())
+            , m_IncludeDirs(includeDirs)
+        {
+        }
+
+        HRESULT __stdcall Open(D3D_INCLUDE_TYPE, LPCSTR fileName, LPCVOID parentData, LPCVOID* data, UINT* bytes) override
+        {
+            auto parent = m_Directories.find(parentData);
+            std::vector<std::filesystem::path> searchDirs;
+            searchDirs.push_back(parent != m_Directories.end() ? parent->second : m_Root);
+            searchDirs.insert(searchDirs.end(), m_IncludeDirs.begin(), m_IncludeDirs.end());
+
+            for (const auto& dir : searchDirs)
+            {
+                auto path = dir / fileName;
+                std::ifstream file(path, std::ios::binary);
+                if (!file)
+                {
+                    continue;
+                }
+
+                std::ostringstream contents;
+                contents << file.rdbuf();
+                auto text = std::make_unique<std::string>(contents.str());
+                *data = text->data();
+                *bytes = static_cast<UINT>(text->size());
+                m_Directories[*data] = path.parent_path();
+                m_Files.push_back(std::move(text));
+                return S_OK;
+            }
+            return E_FAIL;
+        }
+
+        HRESULT __stdcall Close(LPCVOID) override
+        {
+            // Buffers are released with the handler.
+            return S_OK;
+        }
+
+    private:
+        std::filesystem::path m_Root;
+        const std::vector<std::filesystem::path>& m_IncludeDirs;
+        std::unordered_map<LPCVOID, std::filesystem::path> m_Directories;
+        std::vector<std::unique_ptr<std::string>> m_Files;
+    };
+
+    class D3DShaderCompiler : public ShaderCompiler
+    {
+    public:
+        std::string GetVersion() const override
+        {
+            return "d3dcompiler-" + std::to_string(D3D_COMPILER_VERSION);
+        }
+
+        bool Compile(const ShaderDesc& desc, const std::string& source, std::vector<uint8_t>& bytecode, std::string& errors) override
+        {
+            std::vector<D3D_SHADER_MACRO> macros;
+            for (const auto& define : desc.defines)
+            {
+                macros.push_back({ define.name.c_str(), define.value.empty() ? "1" : define.value.c_str() });
+            }
+            macros.push_back({ nullptr, nullptr });
+
+            UINT flags = D3DCOMPILE_ENABLE_STRICTNESS;
+            flags |= desc.debug ? (D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION) : D3DCOMPILE_OPTIMIZATION_LEVEL3;
+
+            IncludeHandler includeHandler(desc.path, desc.includeDirs);
+            std::string sourceName = desc.path.string();
+            ComPtr<ID3DBlob> code;
+            ComPtr<ID3DBlob> errorBlob;
+            HRESULT hr = D3DCompile(source.data(), source.size(), sourceName.c_str(), macros.data(), &includeHandler,
+                desc.entryPoint.c_str(), desc.target.c_str(), flags, 0, &code, &errorBlob);
+
+            if (errorBlob)
+            {
+                errors.assign(static_cast<const char*>(errorBlob->GetBufferPointer()), errorBlob->GetBufferSize());
+            }
+            if (FAILED(hr))
+            {
+                return false;
+            }
+
+            auto data = static_cast<const uint8_t*>(code->GetBufferPointer());
+            bytecode.assign(data, data + code->GetBufferSize());
+            return true;
+        }
+    };
+}
+
+std::unique_ptr<ShaderCompiler> CreateShaderCompiler()
+{
+    return std::make_unique<D3DShaderCompiler>();
+}
+
+#else
+
+std::unique_ptr<ShaderCompiler> CreateShaderCompiler()
+{
+    return nullptr;
+}
+
+#endif
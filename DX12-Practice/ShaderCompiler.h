@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct ShaderDefine
+{
+    std::string name;
+    std::string value;
+};
+
+struct ShaderDesc
+{
+    std::filesystem::path path;
+    std::string entryPoint = "main";
+    std::string target;                 // e.g. "vs_5_1", "ps_6_5"
+    std::vector<ShaderDefine> defines;
+    std::vector<std::filesystem::path> includeDirs;
+    bool debug = false;
+};
+
+// Compiler backend used by ShaderCache. D3DCompile is used on Windows; with
+// DX12_PRACTICE_USE_DXC defined, DXC (dxcompiler) is used instead, which is
+// also the backend for the Linux build. DXC has no shader model 5 profiles,
+// so it compiles 5.x targets as 6.0 and the same descriptions work with both.
+class ShaderCompiler
+{
+public:
+    virtual ~ShaderCompiler() = default;
+
+    // Identifies the compiler build; part of every cache key.
+    virtual std::string GetVersion() const = 0;
+
+    // Must be safe to call from several threads at once.
+    virtual bool Compile(const ShaderDesc& desc, const std::string& source, std::vector<uint8_t>& bytecode, std::string& errors) = 0;
+};
+
+// Returns nullptr if no compiler backend is available in this build.
+std::unique_ptr<ShaderCompiler> CreateShaderCompiler();
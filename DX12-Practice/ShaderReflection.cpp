@@ -0,0 +1,291 @@
+#include "ShaderReflection.h"
+#include "Hash.h"
+#include "RootSignatureCache.h"
+
+#include <wrl/client.h>
+#include <d3dcompiler.h>
+#include "directx/d3d12shader.h"
+
+#if defined(DX12_PRACTICE_USE_DXC)
+#include <dxc/dxcapi.h>
+#endif
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    ComPtr<ID3D12ShaderReflection> CreateReflection(const std::vector<uint8_t>& bytecode)
+    {
+        ComPtr<ID3D12ShaderReflection> reflection;
+#if defined(DX12_PRACTICE_USE_DXC)
+        // DXIL containers are reflected through DXC; D3DReflect only understands DXBC.
+        ComPtr<IDxcUtils> utils;
+        if (SUCCEEDED(DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&utils))))
+        {
+            DxcBuffer buffer = { bytecode.data(), bytecode.size(), 0 };
+            if (SUCCEEDED(utils->CreateReflection(&buffer, IID_PPV_ARGS(&reflection))))
+            {
+                return reflection;
+            }
+        }
+#endif
+        D3DReflect(bytecode.data(), bytecode.size(), IID_PPV_ARGS(&reflection));
+        return reflection;
+    }
+
+    D3D12_SHADER_VISIBILITY GetVisibility(uint8_t stages)
+    {
+        switch (stages)
+        {
+        case ShaderStageVertex: return D3D12_SHADER_VISIBILITY_VERTEX;
+        case ShaderStagePixel: return D3D12_SHADER_VISIBILITY_PIXEL;
+        case ShaderStageAmplification: return D3D12_SHADER_VISIBILITY_AMPLIFICATION;
+        case ShaderStageMesh: return D3D12_SHADER_VISIBILITY_MESH;
+        default: return D3D12_SHADER_VISIBILITY_ALL;
+        }
+    }
+
+    D3D12_DESCRIPTOR_RANGE_TYPE GetRangeType(ShaderBindingType type)
+    {
+        switch (type)
+        {
+        case ShaderBindingType::ConstantBuffer: return D3D12_DESCRIPTOR_RANGE_TYPE_CBV;
+        case ShaderBindingType::ShaderResource: return D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+        case ShaderBindingType::UnorderedAccess: return D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+        default: return D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER;
+        }
+    }
+
+    // Version 1.1 description of a layout, with the storage it points to.
+    class RootSignatureDesc
+    {
+    public:
+        explicit RootSignatureDesc(const ShaderBindingLayout& layout)
+        {
+            const auto& parameters = layout.GetParameters();
+            m_Parameters.resize(parameters.size());
+            m_Ranges.resize(parameters.size());
+
+            for (size_t i = 0; i < parameters.size(); ++i)
+            {
+                const auto& parameter = parameters[i];
+                auto visibility = GetVisibility(parameter.stages);
+
+                if (parameter.kind == ShaderRootParameter::Kind::Constants)
+                {
+                    m_Parameters[i].InitAsConstants(parameter.num32BitValues, parameter.shaderRegister, parameter.space, visibility);
+                    continue;
+                }
+
+                if (parameter.kind == ShaderRootParameter::Kind::Descriptor)
+                {
+                    auto flags = D3D12_ROOT_DESCRIPTOR_FLAG_NONE;
+                    switch (parameter.descriptorType)
+                    {
+                    case ShaderBindingType::ConstantBuffer:
+                        m_Parameters[i].InitAsConstantBufferView(parameter.shaderRegister, parameter.space, flags, visibility);
+                        break;
+                    case ShaderBindingType::ShaderResource:
+                        m_Parameters[i].InitAsShaderResourceView(parameter.shaderRegister, parameter.space, flags, visibility);
+                        break;
+                    default:
+                        m_Parameters[i].InitAsUnorderedAccessView(parameter.shaderRegister, parameter.space, flags, visibility);
+                        break;
+                    }
+                    continue;
+                }
+
+                for (const auto& range : parameter.ranges)
+                {
+                    m_Ranges[i].emplace_back();
+                    m_Ranges[i].back().Init(GetRangeType(range.type), range.count, range.baseRegister, range.space,
+                        D3D12_DESCRIPTOR_RANGE_FLAG_NONE, range.tableOffset);
+                }
+                m_Parameters[i].InitAsDescriptorTable(static_cast<UINT>(m_Ranges[i].size()), m_Ranges[i].data(), visibility);
+            }
+
+            uint8_t stages = layout.GetStages();
+            D3D12_ROOT_SIGNATURE_FLAGS flags =
+                D3D12_ROOT_SIGNATURE_FLAG_DENY_HULL_SHADER_ROOT_ACCESS |
+                D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS |
+                D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS;
+            if (stages & ShaderStageVertex)
+            {
+                flags |= D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+            }
+            if ((stages & ShaderStageCompute) == 0)
+            {
+                if ((stages & ShaderStageVertex) == 0)
+                {
+                    flags |= D3D12_ROOT_SIGNATURE_FLAG_DENY_VERTEX_SHADER_ROOT_ACCESS;
+                }
+                if ((stages & ShaderStagePixel) == 0)
+                {
+                    flags |= D3D12_ROOT_SIGNATURE_FLAG_DENY_PIXEL_SHADER_ROOT_ACCESS;
+                }
+                // Older runtimes reject the mesh deny flags; only mesh pipelines set them.
+                if ((stages & (ShaderStageAmplification | ShaderStageMesh)) == ShaderStageMesh)
+                {
+                    flags |= D3D12_ROOT_SIGNATURE_FLAG_DENY_AMPLIFICATION_SHADER_ROOT_ACCESS;
+                }
+            }
+
+            m_Desc.Init_1_1(static_cast<UINT>(m_Parameters.size()), m_Parameters.data(), 0, nullptr, flags);
+        }
+
+        RootSignatureDesc(const RootSignatureDesc&) = delete;
+        RootSignatureDesc& operator=(const RootSignatureDesc&) = delete;
+
+        const D3D12_VERSIONED_ROOT_SIGNATURE_DESC& Get() const { return m_Desc; }
+
+    private:
+        std::vector<CD3DX12_ROOT_PARAMETER1> m_Parameters;
+        std::vector<std::vector<CD3DX12_DESCRIPTOR_RANGE1>> m_Ranges;
+        CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC m_Desc;
+    };
+}
+
+bool ReflectShaderBindings(const std::vector<uint8_t>& bytecode, uint8_t stage, std::vector<ShaderBinding>& bindings)
+{
+    auto reflection = CreateReflection(bytecode);
+    if (!reflection)
+    {
+        return false;
+    }
+
+    D3D12_SHADER_DESC shaderDesc = {};
+    reflection->GetDesc(&shaderDesc);
+
+    for (UINT i = 0; i < shaderDesc.BoundResources; ++i)
+    {
+        D3D12_SHADER_INPUT_BIND_DESC bindDesc = {};
+        reflection->GetResourceBindingDesc(i, &bindDesc);
+
+        ShaderBinding binding;
+        binding.name = bindDesc.Name;
+        binding.bindPoint = bindDesc.BindPoint;
+        // FXC reports unbounded arrays as 0, DXC as UINT_MAX.
+        binding.bindCount = bindDesc.BindCount == 0 || bindDesc.BindCount == UINT_MAX
+            ? c_ShaderBindingUnbounded : bindDesc.BindCount;
+        binding.space = bindDesc.Space;
+        binding.stages = stage;
+
+        switch (bindDesc.Type)
+        {
+        case D3D_SIT_CBUFFER:
+        {
+            binding.type = ShaderBindingType::ConstantBuffer;
+            D3D12_SHADER_BUFFER_DESC bufferDesc = {};
+            if (auto buffer = reflection->GetConstantBufferByName(bindDesc.Name))
+            {
+                buffer->GetDesc(&bufferDesc);
+            }
+            binding.size = bufferDesc.Size;
+            binding.buffer = true;
+            break;
+        }
+        case D3D_SIT_STRUCTURED:
+        case D3D_SIT_BYTEADDRESS:
+            binding.type = ShaderBindingType::ShaderResource;
+            binding.buffer = true;
+            break;
+        case D3D_SIT_TBUFFER:
+        case D3D_SIT_TEXTURE:
+        case D3D_SIT_RTACCELERATIONSTRUCTURE:
+            binding.type = ShaderBindingType::ShaderResource;
+            break;
+        case D3D_SIT_SAMPLER:
+            binding.type = ShaderBindingType::Sampler;
+            break;
+        case D3D_SIT_UAV_RWSTRUCTURED:
+        case D3D_SIT_UAV_RWBYTEADDRESS:
+            binding.type = ShaderBindingType::UnorderedAccess;
+            binding.buffer = true;
+            break;
+        default:
+            // Typed UAVs, and append/consume buffers whose counter needs a descriptor.
+            binding.type = ShaderBindingType::UnorderedAccess;
+            break;
+        }
+
+        bindings.push_back(std::move(binding));
+    }
+    return true;
+}
+
+bool GetShaderBindingLayout(ShaderCache& shaderCache, const std::vector<std::pair<ShaderHandle, uint8_t>>& stages,
+    ShaderBindingLayout& layout, const ShaderLayoutPolicy& policy)
+{
+    std::vector<ShaderStageBytecode> compiled;
+    for (const auto& stage : stages)
+    {
+        uint64_t key = shaderCache.GetKey(stage.first);
+        if (shaderCache.GetStatus(stage.first) != ShaderStatus::Ready || key == 0)
+        {
+            return false;
+        }
+        compiled.push_back({ shaderCache.GetBytecode(stage.first), key, stage.second });
+    }
+    return GetShaderBindingLayout(shaderCache.GetCacheDir(), compiled, layout, policy);
+}
+
+bool GetShaderBindingLayout(const std::filesystem::path& cacheDir, const std::vector<ShaderStageBytecode>& stages,
+    ShaderBindingLayout& layout, const ShaderLayoutPolicy& policy)
+{
+    // Field by field; the policy struct has padding.
+    uint64_t key = HashValue(policy.maxRootConstantBytes);
+    key = HashValue(policy.rootSignatureDwords, key);
+    key = HashValue(policy.rootDescriptors, key);
+    for (const auto& stage : stages)
+    {
+        if (!stage.bytecode || stage.key == 0)
+        {
+            return false;
+        }
+        key = HashValue(stage.key, HashValue(stage.stage, key));
+    }
+
+    std::vector<uint8_t> payload;
+    if (ShaderCache::ReadCacheFile(cacheDir, key, "layout", payload) && layout.Deserialize(payload))
+    {
+        return true;
+    }
+
+    std::vector<std::vector<ShaderBinding>> stageBindings(stages.size());
+    for (size_t i = 0; i < stages.size(); ++i)
+    {
+        if (!ReflectShaderBindings(*stages[i].bytecode, stages[i].stage, stageBindings[i]))
+        {
+            return false;
+        }
+    }
+
+    layout = ShaderBindingLayout::Build(ShaderBindingLayout::MergeStages(stageBindings), policy);
+    ShaderCache::WriteCacheFile(cacheDir, key, "layout", layout.Serialize());
+    return true;
+}
+
+ID3D12RootSignature* CreateRootSignature(RootSignatureCache& rootSignatureCache, const ShaderBindingLayout& layout)
+{
+    RootSignatureDesc desc(layout);
+    return rootSignatureCache.Get(desc.Get());
+}
+
+bool SerializeRootSignature(const ShaderBindingLayout& layout, D3D_ROOT_SIGNATURE_VERSION version, std::vector<uint8_t>& blob,
+    std::string* error)
+{
+    RootSignatureDesc desc(layout);
+    ComPtr<ID3DBlob> serialized;
+    ComPtr<ID3DBlob> errors;
+    if (FAILED(D3DX12SerializeVersionedRootSignature(&desc.Get(), version, &serialized, &errors)))
+    {
+        if (error && errors)
+        {
+            error->assign(static_cast<const char*>(errors->GetBufferPointer()), errors->GetBufferSize());
+        }
+        return false;
+    }
+    auto bytes = static_cast<const uint8_t*>(serialized->GetBufferPointer());
+    blob.assign(bytes, bytes + serialized->GetBufferSize());
+    return true;
+}
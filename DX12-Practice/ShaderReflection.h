@@ -0,0 +1,45 @@
+#pragma once
+#include "Win.h"
+
+#include "directx/d3dx12.h"
+
+#include "ShaderBindingLayout.h"
+#include "ShaderCache.h"
+
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+class RootSignatureCache;
+
+// Reads the bound resources of a compiled shader with ID3D12ShaderReflection.
+// stage is a ShaderStageMask bit recorded on every binding.
+bool ReflectShaderBindings(const std::vector<uint8_t>& bytecode, uint8_t stage, std::vector<ShaderBinding>& bindings);
+
+// Reflects every stage of a pipeline, merges the bindings and generates the
+// layout. Layouts are stored in the shader cache directory next to the blobs,
+// keyed by the stages' content keys, so unchanged pipelines skip reflection.
+bool GetShaderBindingLayout(ShaderCache& shaderCache, const std::vector<std::pair<ShaderHandle, uint8_t>>& stages,
+    ShaderBindingLayout& layout, const ShaderLayoutPolicy& policy = {});
+
+// A stage built with ShaderCache::Compile, outside the request table.
+struct ShaderStageBytecode
+{
+    const std::vector<uint8_t>* bytecode;
+    uint64_t key;       // content key from Compile
+    uint8_t stage;      // ShaderStageMask bit
+};
+
+// The same for compiled stages; cacheDir is the shader cache directory.
+bool GetShaderBindingLayout(const std::filesystem::path& cacheDir, const std::vector<ShaderStageBytecode>& stages,
+    ShaderBindingLayout& layout, const ShaderLayoutPolicy& policy = {});
+
+// Builds a version 1.1 root signature for the layout through the cache.
+ID3D12RootSignature* CreateRootSignature(RootSignatureCache& rootSignatureCache, const ShaderBindingLayout& layout);
+
+// Serializes the layout's root signature for ID3D12Device::CreateRootSignature
+// or RenderInterface::CreateRootSignature. version is the highest the device
+// supports (RootSignatureCache::GetHighestVersion).
+bool SerializeRootSignature(const ShaderBindingLayout& layout, D3D_ROOT_SIGNATURE_VERSION version, std::vector<uint8_t>& blob,
+    std::string* error = nullptr);
@@ -0,0 +1,405 @@
+#include "TextureFile.h"
+#include "DdsFormat.h"
+#include "FormatInfo.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    bool Fail(std::string* error, const char* message)
+    {
+        if (error)
+        {
+            *error = message;
+        }
+        return false;
+    }
+
+    // Texture files hold single-plane formats laid out in whole blocks.
+    bool IsSupportedFormat(DXGI_FORMAT format)
+    {
+        return GetFormatInfo(format).bytesPerBlock != 0 && GetFormatPlaneCount(format) == 1;
+    }
+
+    uint32_t GetMipSize(uint32_t size, uint32_t mip)
+    {
+        return mip < 32 ? std::max(1u, size >> mip) : 1u;
+    }
+
+    // Levels down to 1x1x1: floor(log2(largest size)) + 1, at most 32.
+    uint32_t GetMaxMipCount(const TextureDesc& desc)
+    {
+        uint32_t size = std::max({ desc.width, desc.height, desc.depth });
+        uint32_t count = 1;
+        while (count < 32 && (size >> count) != 0)
+        {
+            ++count;
+        }
+        return count;
+    }
+
+    // Layers as stored in the file, before cube maps multiply them by six.
+    bool IsValidArraySize(uint32_t layers, bool cube)
+    {
+        return layers <= c_TextureMaxArraySize / (cube ? 6 : 1);
+    }
+
+    uint64_t AlignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    // Legacy (pre-DX10 header) DDS pixel formats.
+    DXGI_FORMAT GetLegacyDdsFormat(const DdsPixelFormat& format)
+    {
+        if (format.flags & c_DdsPixelFourCC)
+        {
+            switch (format.fourCC)
+            {
+            case MakeDdsFourCC('D', 'X', 'T', '1'): return DXGI_FORMAT_BC1_UNORM;
+            case MakeDdsFourCC('D', 'X', 'T', '3'): return DXGI_FORMAT_BC2_UNORM;
+            case MakeDdsFourCC('D', 'X', 'T', '5'): return DXGI_FORMAT_BC3_UNORM;
+            case MakeDdsFourCC('A', 'T', 'I', '1'): return DXGI_FORMAT_BC4_UNORM;
+            case MakeDdsFourCC('B', 'C', '4', 'U'): return DXGI_FORMAT_BC4_UNORM;
+            case MakeDdsFourCC('B', 'C', '4', 'S'): return DXGI_FORMAT_BC4_SNORM;
+            case MakeDdsFourCC('A', 'T', 'I', '2'): return DXGI_FORMAT_BC5_UNORM;
+            case MakeDdsFourCC('B', 'C', '5', 'U'): return DXGI_FORMAT_BC5_UNORM;
+            case MakeDdsFourCC('B', 'C', '5', 'S'): return DXGI_FORMAT_BC5_SNORM;
+            case 111: return DXGI_FORMAT_R16_FLOAT;             // D3DFMT_R16F
+            case 113: return DXGI_FORMAT_R16G16B16A16_FLOAT;    // D3DFMT_A16B16G16R16F
+            case 114: return DXGI_FORMAT_R32_FLOAT;             // D3DFMT_R32F
+            case 116: return DXGI_FORMAT_R32G32B32A32_FLOAT;    // D3DFMT_A32B32G32R32F
+            default: return DXGI_FORMAT_UNKNOWN;
+            }
+        }
+
+        if ((format.flags & c_DdsPixelRGB) && format.rgbBitCount == 32)
+        {
+            if (format.rBitMask == 0xff && format.gBitMask == 0xff00 && format.bBitMask == 0xff0000)
+            {
+                return DXGI_FORMAT_R8G8B8A8_UNORM;
+            }
+            if (format.rBitMask == 0xff0000 && format.gBitMask == 0xff00 && format.bBitMask == 0xff)
+            {
+                return (format.flags & c_DdsPixelAlpha) ? DXGI_FORMAT_B8G8R8A8_UNORM : DXGI_FORMAT_B8G8R8X8_UNORM;
+            }
+        }
+        if ((format.flags & c_DdsPixelLuminance) && format.rgbBitCount == 8)
+        {
+            return DXGI_FORMAT_R8_UNORM;
+        }
+        return DXGI_FORMAT_UNKNOWN;
+    }
+
+    const uint8_t c_Ktx2Identifier[12] = { 0xab, 'K', 'T', 'X', ' ', '2', '0', 0xbb, '\r', '\n', 0x1a, '\n' };
+
+    struct Ktx2Header
+    {
+        uint8_t identifier[12];
+        uint32_t vkFormat;
+        uint32_t typeSize;
+        uint32_t pixelWidth;
+        uint32_t pixelHeight;
+        uint32_t pixelDepth;
+        uint32_t layerCount;
+        uint32_t faceCount;
+        uint32_t levelCount;
+        uint32_t supercompressionScheme;
+        uint32_t dfdByteOffset;
+        uint32_t dfdByteLength;
+        uint32_t kvdByteOffset;
+        uint32_t kvdByteLength;
+        uint64_t sgdByteOffset;
+        uint64_t sgdByteLength;
+    };
+
+    struct Ktx2Level
+    {
+        uint64_t byteOffset;
+        uint64_t byteLength;
+        uint64_t uncompressedByteLength;
+    };
+
+    static_assert(sizeof(Ktx2Header) == 80, "KTX2 header layout");
+
+    DXGI_FORMAT GetKtx2Format(uint32_t vkFormat)
+    {
+        switch (vkFormat)
+        {
+        case 9: return DXGI_FORMAT_R8_UNORM;                    // VK_FORMAT_R8_UNORM
+        case 16: return DXGI_FORMAT_R8G8_UNORM;                 // VK_FORMAT_R8G8_UNORM
+        case 37: return DXGI_FORMAT_R8G8B8A8_UNORM;             // VK_FORMAT_R8G8B8A8_UNORM
+        case 43: return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;        // VK_FORMAT_R8G8B8A8_SRGB
+        case 44: return DXGI_FORMAT_B8G8R8A8_UNORM;             // VK_FORMAT_B8G8R8A8_UNORM
+        case 50: return DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;        // VK_FORMAT_B8G8R8A8_SRGB
+        case 64: return DXGI_FORMAT_R10G10B10A2_UNORM;          // VK_FORMAT_A2B10G10R10_UNORM_PACK32
+        case 76: return DXGI_FORMAT_R16_FLOAT;                  // VK_FORMAT_R16_SFLOAT
+        case 83: return DXGI_FORMAT_R16G16_FLOAT;               // VK_FORMAT_R16G16_SFLOAT
+        case 97: return DXGI_FORMAT_R16G16B16A16_FLOAT;         // VK_FORMAT_R16G16B16A16_SFLOAT
+        case 100: return DXGI_FORMAT_R32_FLOAT;                 // VK_FORMAT_R32_SFLOAT
+        case 109: return DXGI_FORMAT_R32G32B32A32_FLOAT;        // VK_FORMAT_R32G32B32A32_SFLOAT
+        case 122: return DXGI_FORMAT_R11G11B10_FLOAT;           // VK_FORMAT_B10G11R11_UFLOAT_PACK32
+        case 123: return DXGI_FORMAT_R9G9B9E5_SHAREDEXP;        // VK_FORMAT_E5B9G9R9_UFLOAT_PACK32
+        case 131: case 133: return DXGI_FORMAT_BC1_UNORM;       // VK_FORMAT_BC1_RGB(A)_UNORM_BLOCK
+        case 132: case 134: return DXGI_FORMAT_BC1_UNORM_SRGB;  // VK_FORMAT_BC1_RGB(A)_SRGB_BLOCK
+        case 135: return DXGI_FORMAT_BC2_UNORM;
+        case 136: return DXGI_FORMAT_BC2_UNORM_SRGB;
+        case 137: return DXGI_FORMAT_BC3_UNORM;
+        case 138: return DXGI_FORMAT_BC3_UNORM_SRGB;
+        case 139: return DXGI_FORMAT_BC4_UNORM;
+        case 140: return DXGI_FORMAT_BC4_SNORM;
+        case 141: return DXGI_FORMAT_BC5_UNORM;
+        case 142: return DXGI_FORMAT_BC5_SNORM;
+        case 143: return DXGI_FORMAT_BC6H_UF16;
+        case 144: return DXGI_FORMAT_BC6H_SF16;
+        case 145: return DXGI_FORMAT_BC7_UNORM;
+        case 146: return DXGI_FORMAT_BC7_UNORM_SRGB;
+        default: return DXGI_FORMAT_UNKNOWN;
+        }
+    }
+}
+
+uint64_t ComputeTextureFootprints(const TextureDesc& desc, uint32_t firstSubresource, uint32_t count, uint64_t baseOffset,
+    TextureFootprint* footprints)
+{
+    if (!IsSupportedFormat(desc.format) || desc.mipCount == 0)
+    {
+        return 0;
+    }
+    const FormatInfo& block = GetFormatInfo(desc.format);
+
+    uint64_t offset = baseOffset;
+    uint64_t end = baseOffset;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uint32_t mip = (firstSubresource + i) % desc.mipCount;
+        uint32_t blocksWide = (GetMipSize(desc.width, mip) + block.blockWidth - 1) / block.blockWidth;
+        uint32_t blocksHigh = (GetMipSize(desc.height, mip) + block.blockHeight - 1) / block.blockHeight;
+
+        TextureFootprint& footprint = footprints[i];
+        footprint.offset = AlignUp(offset, c_TexturePlacementAlignment);
+        footprint.width = blocksWide * block.blockWidth;
+        footprint.height = blocksHigh * block.blockHeight;
+        footprint.depth = desc.dimension == TextureDimension::Texture3D ? GetMipSize(desc.depth, mip) : 1;
+        footprint.rowSize = uint64_t(blocksWide) * block.bytesPerBlock;
+        footprint.rowPitch = static_cast<uint32_t>(AlignUp(footprint.rowSize, c_TexturePitchAlignment));
+        footprint.rowCount = blocksHigh;
+
+        // The last row of the last slice does not need its padding.
+        uint64_t rows = uint64_t(footprint.rowCount) * footprint.depth;
+        end = footprint.offset + footprint.rowPitch * (rows - 1) + footprint.rowSize;
+        offset = footprint.offset + footprint.rowPitch * rows;
+    }
+    return end - baseOffset;
+}
+
+bool TextureFile::Open(const std::filesystem::path& path, std::string* error)
+{
+    Close();
+    if (!m_File.Open(path))
+    {
+        return Fail(error, "cannot open texture file");
+    }
+
+    bool valid;
+    if (m_File.GetSize() >= sizeof(c_Ktx2Identifier) && memcmp(m_File.GetData(), c_Ktx2Identifier, sizeof(c_Ktx2Identifier)) == 0)
+    {
+        valid = ParseKtx2(error);
+    }
+    else
+    {
+        valid = ParseDds(error);
+    }
+
+    if (!valid)
+    {
+        Close();
+    }
+    return valid;
+}
+
+void TextureFile::Close()
+{
+    m_File.Close();
+    m_Desc = TextureDesc();
+    m_Subresources.clear();
+}
+
+bool TextureFile::ParseDds(std::string* error)
+{
+    const uint8_t* data = m_File.GetData();
+    size_t size = m_File.GetSize();
+    uint32_t magic = 0;
+    if (size < sizeof(magic) + sizeof(DdsHeader) || (memcpy(&magic, data, sizeof(magic)), magic != c_DdsMagic))
+    {
+        return Fail(error, "not a texture file");
+    }
+
+    DdsHeader header;
+    memcpy(&header, data + sizeof(magic), sizeof(header));
+    if (header.size != sizeof(DdsHeader) || header.pixelFormat.size != sizeof(DdsPixelFormat))
+    {
+        return Fail(error, "invalid DDS header");
+    }
+
+    uint64_t dataOffset = sizeof(magic) + sizeof(DdsHeader);
+    m_Desc.width = std::max(1u, header.width);
+    m_Desc.height = std::max(1u, header.height);
+    m_Desc.mipCount = std::max(1u, header.mipMapCount);
+
+    if ((header.pixelFormat.flags & c_DdsPixelFourCC) && header.pixelFormat.fourCC == MakeDdsFourCC('D', 'X', '1', '0'))
+    {
+        if (size < dataOffset + sizeof(DdsHeaderDxt10))
+        {
+            return Fail(error, "DDS file is truncated");
+        }
+        DdsHeaderDxt10 dxt10;
+        memcpy(&dxt10, data + dataOffset, sizeof(dxt10));
+        dataOffset += sizeof(dxt10);
+
+        m_Desc.format = dxt10.dxgiFormat;
+        m_Desc.arraySize = std::max(1u, dxt10.arraySize);
+        switch (dxt10.resourceDimension)
+        {
+        case c_DdsDimensionTexture1D:
+            m_Desc.dimension = TextureDimension::Texture1D;
+            m_Desc.height = 1;
+            if (!IsValidArraySize(m_Desc.arraySize, false))
+            {
+                return Fail(error, "invalid DDS array size");
+            }
+            break;
+        case c_DdsDimensionTexture2D:
+            m_Desc.cube = (dxt10.miscFlag & c_DdsMiscTextureCube) != 0;
+            if (!IsValidArraySize(m_Desc.arraySize, m_Desc.cube))
+            {
+                return Fail(error, "invalid DDS array size");
+            }
+            m_Desc.arraySize *= m_Desc.cube ? 6 : 1;
+            break;
+        case c_DdsDimensionTexture3D:
+            m_Desc.dimension = TextureDimension::Texture3D;
+            m_Desc.depth = std::max(1u, header.depth);
+            m_Desc.arraySize = 1;
+            break;
+        default:
+            return Fail(error, "unsupported DDS resource dimension");
+        }
+    }
+    else
+    {
+        m_Desc.format = GetLegacyDdsFormat(header.pixelFormat);
+        if (header.caps2 & c_DdsCaps2Volume)
+        {
+            m_Desc.dimension = TextureDimension::Texture3D;
+            m_Desc.depth = std::max(1u, header.depth);
+        }
+        else if (header.caps2 & c_DdsCaps2Cubemap)
+        {
+            if ((header.caps2 & c_DdsCaps2CubemapAllFaces) != c_DdsCaps2CubemapAllFaces)
+            {
+                return Fail(error, "partial DDS cube maps are not supported");
+            }
+            m_Desc.cube = true;
+            m_Desc.arraySize = 6;
+        }
+    }
+
+    if (!IsSupportedFormat(m_Desc.format))
+    {
+        return Fail(error, "unsupported texture format");
+    }
+    if (m_Desc.mipCount > GetMaxMipCount(m_Desc))
+    {
+        return Fail(error, "invalid DDS mip count");
+    }
+    return AddSubresources({}, dataOffset, error);
+}
+
+bool TextureFile::ParseKtx2(std::string* error)
+{
+    const uint8_t* data = m_File.GetData();
+    size_t size = m_File.GetSize();
+    if (size < sizeof(Ktx2Header))
+    {
+        return Fail(error, "KTX2 file is truncated");
+    }
+
+    Ktx2Header header;
+    memcpy(&header, data, sizeof(header));
+    if (header.supercompressionScheme != 0)
+    {
+        return Fail(error, "supercompressed KTX2 files are not supported");
+    }
+    m_Desc.format = GetKtx2Format(header.vkFormat);
+    if (!IsSupportedFormat(m_Desc.format))
+    {
+        return Fail(error, "unsupported texture format");
+    }
+
+    m_Desc.width = std::max(1u, header.pixelWidth);
+    m_Desc.height = std::max(1u, header.pixelHeight);
+    m_Desc.depth = std::max(1u, header.pixelDepth);
+    m_Desc.mipCount = std::max(1u, header.levelCount);
+    m_Desc.dimension = header.pixelDepth ? TextureDimension::Texture3D :
+        header.pixelHeight ? TextureDimension::Texture2D : TextureDimension::Texture1D;
+    m_Desc.cube = header.faceCount == 6;
+    if (header.faceCount != 1 && !m_Desc.cube)
+    {
+        return Fail(error, "invalid KTX2 face count");
+    }
+    if (!IsValidArraySize(std::max(1u, header.layerCount), m_Desc.cube))
+    {
+        return Fail(error, "invalid KTX2 layer count");
+    }
+    m_Desc.arraySize = std::max(1u, header.layerCount) * (m_Desc.cube ? 6 : 1);
+    if (m_Desc.mipCount > GetMaxMipCount(m_Desc))
+    {
+        return Fail(error, "invalid KTX2 level count");
+    }
+
+    if (size < sizeof(Ktx2Header) + sizeof(Ktx2Level) * uint64_t(m_Desc.mipCount))
+    {
+        return Fail(error, "KTX2 file is truncated");
+    }
+    std::vector<uint64_t> levelOffsets(m_Desc.mipCount);
+    for (uint32_t mip = 0; mip < m_Desc.mipCount; ++mip)
+    {
+        Ktx2Level level;
+        memcpy(&level, data + sizeof(Ktx2Header) + sizeof(Ktx2Level) * mip, sizeof(level));
+        levelOffsets[mip] = level.byteOffset;
+    }
+    return AddSubresources(levelOffsets, 0, error);
+}
+
+bool TextureFile::AddSubresources(const std::vector<uint64_t>& levelOffsets, uint64_t dataOffset, std::string* error)
+{
+    const FormatInfo& block = GetFormatInfo(m_Desc.format);
+    uint32_t slices = m_Desc.dimension == TextureDimension::Texture3D ? 1 : m_Desc.arraySize;
+    m_Subresources.resize(GetTextureSubresourceCount(m_Desc));
+
+    // DDS stores each array slice's mip chain in turn; KTX2 stores each mip
+    // level's slices in turn, starting at the level's offset.
+    uint64_t offset = dataOffset;
+    for (uint32_t slice = 0; slice < slices; ++slice)
+    {
+        for (uint32_t mip = 0; mip < m_Desc.mipCount; ++mip)
+        {
+            uint64_t blocksWide = (GetMipSize(m_Desc.width, mip) + block.blockWidth - 1) / block.blockWidth;
+            uint64_t rowPitch = blocksWide * block.bytesPerBlock;
+            uint64_t slicePitch = rowPitch * ((GetMipSize(m_Desc.height, mip) + block.blockHeight - 1) / block.blockHeight);
+            uint64_t depth = m_Desc.dimension == TextureDimension::Texture3D ? GetMipSize(m_Desc.depth, mip) : 1;
+            uint64_t subresourceSize = slicePitch * depth;
+
+            uint64_t start = levelOffsets.empty() ? offset : levelOffsets[mip] + slice * subresourceSize;
+            if (start > m_File.GetSize() || subresourceSize > m_File.GetSize() - start)
+            {
+                return Fail(error, "texture data out of range");
+            }
+            m_Subresources[mip + slice * m_Desc.mipCount] = { m_File.GetData() + start, rowPitch, slicePitch };
+            offset += subresourceSize;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include "MappedFile.h"
+#include "directx/dxgiformat.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Copy-engine placement rules (D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT and
+// D3D12_TEXTURE_DATA_PITCH_ALIGNMENT), repeated so footprints can be
+// computed without d3d12.h.
+constexpr uint64_t c_TexturePlacementAlignment = 512;
+constexpr uint32_t c_TexturePitchAlignment = 256;
+// D3D12_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION; counts the faces of cube maps.
+constexpr uint32_t c_TextureMaxArraySize = 2048;
+
+enum class TextureDimension : uint8_t
+{
+    Texture1D,
+    Texture2D,
+    Texture3D,
+};
+
+struct TextureDesc
+{
+    TextureDimension dimension = TextureDimension::Texture2D;
+    DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+    uint32_t width = 1;
+    uint32_t height = 1;
+    uint32_t depth = 1;         // 3D textures only
+    uint32_t arraySize = 1;     // six per cube for cube maps
+    uint32_t mipCount = 1;
+    bool cube = false;
+};
+
+// What GetCopyableFootprints reports for one subresource: a placed
+// footprint in an upload buffer plus the unpadded row layout.
+struct TextureFootprint
+{
+    uint64_t offset;
+    uint32_t width;             // padded to whole blocks
+    uint32_t height;
+    uint32_t depth;
+    uint32_t rowPitch;          // multiple of c_TexturePitchAlignment
+    uint32_t rowCount;          // rows of blocks per slice
+    uint64_t rowSize;           // bytes of data per row
+};
+
+// Subresources are in D3D12 order (mip + arraySlice * mipCount).
+inline uint32_t GetTextureSubresourceCount(const TextureDesc& desc)
+{
+    return desc.mipCount * (desc.dimension == TextureDimension::Texture3D ? 1 : desc.arraySize);
+}
+
+// CPU equivalent of ID3D12Device::GetCopyableFootprints for single-plane
+// formats. Returns the total size in bytes, or 0 for unsupported formats.
+uint64_t ComputeTextureFootprints(const TextureDesc& desc, uint32_t firstSubresource, uint32_t count, uint64_t baseOffset,
+    TextureFootprint* footprints);
+
+// Tightly packed subresource data inside a texture file.
+struct TextureSubresourceData
+{
+    const uint8_t* data;
+    uint64_t rowPitch;
+    uint64_t slicePitch;
+};
+
+// Read-only, memory-mapped DDS or KTX2 (no supercompression) texture.
+// Subresource pointers refer into the mapping, so the file has to stay open
+// until their upload has been recorded.
+class TextureFile
+{
+public:
+    bool Open(const std::filesystem::path& path, std::string* error = nullptr);
+    void Close();
+
+    bool IsOpen() const { return m_File.IsOpen(); }
+    const TextureDesc& GetDesc() const { return m_Desc; }
+    uint32_t GetSubresourceCount() const { return static_cast<uint32_t>(m_Subresources.size()); }
+    const TextureSubresourceData& GetSubresource(uint32_t index) const { return m_Subresources[index]; }
+    const TextureSubresourceData* GetSubresources() const { return m_Subresources.data(); }
+
+private:
+    bool ParseDds(std::string* error);
+    bool ParseKtx2(std::string* error);
+    // Fills m_Subresources for levels stored as m_Desc describes; levelOffsets
+    // holds each mip's file offset (KTX2) or is empty for DDS order.
+    bool AddSubresources(const std::vector<uint64_t>& levelOffsets, uint64_t dataOffset, std::string* error);
+
+    MappedFile m_File;
+    TextureDesc m_Desc;
+    std::vector<TextureSubresourceData> m_Subresources;
+};
@@ -0,0 +1,341 @@
+#include "TransformHierarchy.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TRANSFORM_SSE2 1
+#endif
+
+namespace
+{
+    const uint32_t c_NodesPerJob = 1024;
+
+    // local = scale * rotation * translation, as XMMatrixAffineTransformation
+    // builds it without a rotation origin.
+    void ComposeLocal(const float position[3], const float rotation[4], const float scale[3], TransformMatrix& out)
+    {
+        float x = rotation[0], y = rotation[1], z = rotation[2], w = rotation[3];
+        const float rows[3][3] = {
+            { 1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + z * w), 2.0f * (x * z - y * w) },
+            { 2.0f * (x * y - z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + x * w) },
+            { 2.0f * (x * z + y * w), 2.0f * (y * z - x * w), 1.0f - 2.0f * (x * x + y * y) },
+        };
+        for (int row = 0; row < 3; ++row)
+        {
+            out.m[row][0] = rows[row][0] * scale[row];
+            out.m[row][1] = rows[row][1] * scale[row];
+            out.m[row][2] = rows[row][2] * scale[row];
+            out.m[row][3] = 0.0f;
+        }
+        out.m[3][0] = position[0];
+        out.m[3][1] = position[1];
+        out.m[3][2] = position[2];
+        out.m[3][3] = 1.0f;
+    }
+
+    // out = a * b; out may not alias b. Each row of the result is a linear
+    // combination of the rows of b, four lanes at a time like XMMatrixMultiply.
+    void Multiply(const TransformMatrix& a, const TransformMatrix& b, TransformMatrix& out)
+    {
+#if defined(TRANSFORM_SSE2)
+        __m128 b0 = _mm_load_ps(b.m[0]);
+        __m128 b1 = _mm_load_ps(b.m[1]);
+        __m128 b2 = _mm_load_ps(b.m[2]);
+        __m128 b3 = _mm_load_ps(b.m[3]);
+        for (int row = 0; row < 4; ++row)
+        {
+            __m128 result = _mm_mul_ps(_mm_set1_ps(a.m[row][0]), b0);
+            result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(a.m[row][1]), b1));
+            result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(a.m[row][2]), b2));
+            result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(a.m[row][3]), b3));
+            _mm_store_ps(out.m[row], result);
+        }
+#else
+        for (int row = 0; row < 4; ++row)
+        {
+            float r[4] = { a.m[row][0], a.m[row][1], a.m[row][2], a.m[row][3] };
+            for (int column = 0; column < 4; ++column)
+            {
+                out.m[row][column] = r[0] * b.m[0][column] + r[1] * b.m[1][column] +
+                    r[2] * b.m[2][column] + r[3] * b.m[3][column];
+            }
+        }
+#endif
+    }
+
+    template<typename T>
+    void Permute(std::vector<T>& values, const std::vector<uint32_t>& order)
+    {
+        std::vector<T> sorted;
+        sorted.reserve(order.size());
+        for (uint32_t index : order)
+        {
+            sorted.push_back(values[index]);
+        }
+        values.swap(sorted);
+    }
+}
+
+uint32_t TransformHierarchy::AllocateHandle(uint32_t index)
+{
+    if (!m_FreeHandles.empty())
+    {
+        uint32_t id = m_FreeHandles.back();
+        m_FreeHandles.pop_back();
+        m_HandleToIndex[id] = index;
+        return id;
+    }
+
+    m_HandleToIndex.push_back(index);
+    return static_cast<uint32_t>(m_HandleToIndex.size() - 1);
+}
+
+TransformHandle TransformHierarchy::Create(TransformHandle parent)
+{
+    // Appended out of order; Rebuild() restores depth order.
+    uint32_t index = GetCount();
+    uint32_t parentIndex = parent.IsValid() ? GetIndex(parent) : c_NoParent;
+
+    TransformHandle handle;
+    handle.id = AllocateHandle(index);
+
+    m_Parent.push_back(parentIndex);
+    m_Depth.push_back(0);   // set in Rebuild()
+    m_Handle.push_back(handle.id);
+    m_Position.push_back({ 0.0f, 0.0f, 0.0f });
+    m_Rotation.push_back({ 0.0f, 0.0f, 0.0f, 1.0f });
+    m_Scale.push_back({ 1.0f, 1.0f, 1.0f });
+    m_World.push_back({ { { 1.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f, 0.0f },
+        { 0.0f, 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 1.0f } } });
+    m_Dirty.push_back(1);
+    m_WorldChanged.push_back(0);
+    m_Destroyed.push_back(0);
+
+    m_NeedsRebuild = true;
+    return handle;
+}
+
+void TransformHierarchy::Destroy(TransformHandle handle)
+{
+    // Descendants are removed in Rebuild().
+    assert(GetIndex(handle) != UINT32_MAX);
+    m_Destroyed[GetIndex(handle)] = 1;
+    m_NeedsRebuild = true;
+}
+
+bool TransformHierarchy::SetParent(TransformHandle handle, TransformHandle parent)
+{
+    uint32_t index = GetIndex(handle);
+    uint32_t parentIndex = parent.IsValid() ? GetIndex(parent) : c_NoParent;
+    for (uint32_t ancestor = parentIndex; ancestor != c_NoParent; ancestor = m_Parent[ancestor])
+    {
+        if (ancestor == index)
+        {
+            return false;
+        }
+    }
+
+    m_Parent[index] = parentIndex;
+    m_Dirty[index] = 1;
+    m_NeedsRebuild = true;
+    return true;
+}
+
+void TransformHierarchy::SetLocal(TransformHandle handle, const float position[3], const float rotation[4], const float scale[3])
+{
+    uint32_t index = GetIndex(handle);
+    std::copy(position, position + 3, m_Position[index].begin());
+    std::copy(rotation, rotation + 4, m_Rotation[index].begin());
+    std::copy(scale, scale + 3, m_Scale[index].begin());
+    m_Dirty[index] = 1;
+}
+
+void TransformHierarchy::SetPosition(TransformHandle handle, const float position[3])
+{
+    uint32_t index = GetIndex(handle);
+    std::copy(position, position + 3, m_Position[index].begin());
+    m_Dirty[index] = 1;
+}
+
+void TransformHierarchy::Rebuild()
+{
+    uint32_t count = GetCount();
+
+    // SetParent moves whole subtrees, so depths are recomputed from the
+    // parents: walk up to the first node with a known depth, then back down.
+    const uint32_t unknownDepth = UINT32_MAX;
+    m_Depth.assign(count, unknownDepth);
+    std::vector<uint32_t> path;
+    uint32_t maxDepth = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uint32_t node = i;
+        while (node != c_NoParent && m_Depth[node] == unknownDepth)
+        {
+            path.push_back(node);
+            node = m_Parent[node];
+        }
+
+        uint32_t depth = node == c_NoParent ? 0 : m_Depth[node] + 1;
+        for (auto it = path.rbegin(); it != path.rend(); ++it, ++depth)
+        {
+            m_Depth[*it] = depth;
+        }
+        path.clear();
+        maxDepth = std::max(maxDepth, m_Depth[i]);
+    }
+
+    // Stable counting sort by depth.
+    std::vector<uint32_t> levelBegin(maxDepth + 2, 0);
+    for (uint32_t depth : m_Depth)
+    {
+        ++levelBegin[depth + 1];
+    }
+    for (uint32_t depth = 0; depth <= maxDepth; ++depth)
+    {
+        levelBegin[depth + 1] += levelBegin[depth];
+    }
+
+    std::vector<uint32_t> byDepth(count);
+    {
+        std::vector<uint32_t> cursor(levelBegin.begin(), levelBegin.end() - 1);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            byDepth[cursor[m_Depth[i]]++] = i;
+        }
+    }
+
+    // Walking in depth order sees every parent before its children, so
+    // destruction propagates down in the same pass.
+    std::vector<uint32_t> order;
+    order.reserve(count);
+    for (uint32_t i : byDepth)
+    {
+        uint32_t parent = m_Parent[i];
+        if (parent != c_NoParent && m_Destroyed[parent])
+        {
+            m_Destroyed[i] = 1;
+        }
+
+        if (m_Destroyed[i])
+        {
+            m_FreeHandles.push_back(m_Handle[i]);
+            m_HandleToIndex[m_Handle[i]] = UINT32_MAX;
+        }
+        else
+        {
+            order.push_back(i);
+        }
+    }
+
+    std::vector<uint32_t> oldToNew(count, c_NoParent);
+    for (uint32_t newIndex = 0; newIndex < order.size(); ++newIndex)
+    {
+        oldToNew[order[newIndex]] = newIndex;
+    }
+
+    Permute(m_Parent, order);
+    Permute(m_Depth, order);
+    Permute(m_Handle, order);
+    Permute(m_Position, order);
+    Permute(m_Rotation, order);
+    Permute(m_Scale, order);
+    Permute(m_World, order);
+    Permute(m_Dirty, order);
+    Permute(m_Destroyed, order);
+    m_WorldChanged.assign(order.size(), 0);
+
+    m_LevelBegin.assign(1, 0);
+    for (uint32_t i = 0; i < order.size(); ++i)
+    {
+        if (m_Parent[i] != c_NoParent)
+        {
+            m_Parent[i] = oldToNew[m_Parent[i]];
+        }
+        m_HandleToIndex[m_Handle[i]] = i;
+
+        while (m_LevelBegin.size() <= m_Depth[i])
+        {
+            m_LevelBegin.push_back(i);
+        }
+    }
+    m_LevelBegin.push_back(static_cast<uint32_t>(order.size()));
+
+    m_NeedsRebuild = false;
+}
+
+void TransformHierarchy::UpdateRange(uint32_t begin, uint32_t end)
+{
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        uint32_t parent = m_Parent[i];
+        bool parentChanged = parent != c_NoParent && m_WorldChanged[parent];
+        if (!m_Dirty[i] && !parentChanged)
+        {
+            m_WorldChanged[i] = 0;
+            continue;
+        }
+
+        if (parent == c_NoParent)
+        {
+            ComposeLocal(m_Position[i].data(), m_Rotation[i].data(), m_Scale[i].data(), m_World[i]);
+        }
+        else
+        {
+            TransformMatrix local;
+            ComposeLocal(m_Position[i].data(), m_Rotation[i].data(), m_Scale[i].data(), local);
+            Multiply(local, m_World[parent], m_World[i]);
+        }
+
+        m_Dirty[i] = 0;
+        m_WorldChanged[i] = 1;
+    }
+}
+
+void TransformHierarchy::Update(JobSystem* jobSystem)
+{
+    m_Rebuilt = m_NeedsRebuild;
+    if (m_NeedsRebuild)
+    {
+        Rebuild();
+    }
+
+    // Levels run in order: a level only reads its parents' results.
+    for (size_t level = 0; level + 1 < m_LevelBegin.size(); ++level)
+    {
+        uint32_t begin = m_LevelBegin[level];
+        uint32_t count = m_LevelBegin[level + 1] - begin;
+        if (jobSystem)
+        {
+            jobSystem->ParallelFor(count, c_NodesPerJob, [this, begin](uint32_t first, uint32_t last)
+            {
+                UpdateRange(begin + first, begin + last);
+            });
+        }
+        else
+        {
+            UpdateRange(begin, begin + count);
+        }
+    }
+
+    // Renumbered nodes hold different data than last frame at the same index.
+    if (m_Rebuilt)
+    {
+        m_Changed.resize(GetCount());
+        std::iota(m_Changed.begin(), m_Changed.end(), 0u);
+        return;
+    }
+
+    m_Changed.clear();
+    for (uint32_t i = 0; i < GetCount(); ++i)
+    {
+        if (m_WorldChanged[i])
+        {
+            m_Changed.push_back(i);
+        }
+    }
+}
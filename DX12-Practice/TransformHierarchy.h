@@ -0,0 +1,93 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+struct TransformHandle
+{
+    uint32_t id = UINT32_MAX;
+
+    bool IsValid() const { return id != UINT32_MAX; }
+};
+
+// Row-major 4x4 matrix in the DirectXMath row-vector convention, laid out
+// like XMFLOAT4X4A so it can be loaded or uploaded as is.
+struct alignas(16) TransformMatrix
+{
+    float m[4][4];
+};
+
+// Scene transform hierarchy stored as flat arrays sorted by depth, so every
+// parent precedes its children and each depth level is a contiguous range.
+// Update() walks the levels in order and recomputes local-to-world matrices
+// only for nodes whose local transform or any ancestor changed; the nodes
+// of one level are independent and are split across the job system.
+//
+// Matrices use the row-vector convention (world = local * parent).
+// Structural changes (Create/Destroy/SetParent) re-sort the arrays on the
+// next Update, which changes node indices; handles stay valid.
+class TransformHierarchy
+{
+public:
+    TransformHandle Create(TransformHandle parent = {});
+
+    // Destroys the node and all of its descendants.
+    void Destroy(TransformHandle handle);
+
+    // Moves the node and its subtree under parent (or to the root). Fails if
+    // parent is the node itself or one of its descendants.
+    bool SetParent(TransformHandle handle, TransformHandle parent);
+
+    // rotation is a quaternion (x, y, z, w).
+    void SetLocal(TransformHandle handle, const float position[3], const float rotation[4], const float scale[3]);
+    void SetPosition(TransformHandle handle, const float position[3]);
+
+    void Update(JobSystem* jobSystem);
+
+    uint32_t GetCount() const { return static_cast<uint32_t>(m_Parent.size()); }
+
+    // Index into GetWorldMatrices(); valid until the next structural change.
+    uint32_t GetIndex(TransformHandle handle) const { return m_HandleToIndex[handle.id]; }
+    const TransformMatrix& GetWorld(TransformHandle handle) const { return m_World[GetIndex(handle)]; }
+
+    // World matrices in depth order, plus the indices that changed in the
+    // last Update (ascending), so instance data can be uploaded directly and
+    // only where it changed. After a structural change every index moved,
+    // so GetChanged() then lists all of them.
+    const TransformMatrix* GetWorldMatrices() const { return m_World.data(); }
+    const std::vector<uint32_t>& GetChanged() const { return m_Changed; }
+
+    // True if the last Update re-sorted the nodes; indices from before it,
+    // e.g. cached per handle, must be looked up again.
+    bool WasRebuilt() const { return m_Rebuilt; }
+
+private:
+    static constexpr uint32_t c_NoParent = UINT32_MAX;
+
+    uint32_t AllocateHandle(uint32_t index);
+    void Rebuild();
+    void UpdateRange(uint32_t begin, uint32_t end);
+
+    // Per node, in depth order.
+    std::vector<uint32_t> m_Parent;             // index, or c_NoParent
+    std::vector<uint32_t> m_Depth;
+    std::vector<uint32_t> m_Handle;
+    std::vector<std::array<float, 3>> m_Position;
+    std::vector<std::array<float, 4>> m_Rotation;
+    std::vector<std::array<float, 3>> m_Scale;
+    std::vector<TransformMatrix> m_World;
+    std::vector<uint8_t> m_Dirty;               // local transform or parent changed
+    std::vector<uint8_t> m_WorldChanged;        // recomputed this update
+    std::vector<uint8_t> m_Destroyed;
+
+    // Node i of depth d lies in [m_LevelBegin[d], m_LevelBegin[d + 1]).
+    std::vector<uint32_t> m_LevelBegin;
+    std::vector<uint32_t> m_Changed;
+
+    std::vector<uint32_t> m_HandleToIndex;
+    std::vector<uint32_t> m_FreeHandles;
+    bool m_NeedsRebuild = false;
+    bool m_Rebuilt = false;
+};
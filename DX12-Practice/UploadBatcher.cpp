@@ -0,0 +1,274 @@
+#include "UploadBatcher.h"
+#include "TextureFile.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+using Microsoft::WRL::ComPtr;
+
+static_assert(c_TexturePlacementAlignment == D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, "placement alignment");
+static_assert(c_TexturePitchAlignment == D3D12_TEXTURE_DATA_PITCH_ALIGNMENT, "pitch alignment");
+
+namespace
+{
+    TextureDesc GetTextureDesc(const D3D12_RESOURCE_DESC& resourceDesc)
+    {
+        TextureDesc desc;
+        desc.format = resourceDesc.Format;
+        desc.width = static_cast<uint32_t>(resourceDesc.Width);
+        desc.height = resourceDesc.Height;
+        desc.mipCount = resourceDesc.MipLevels;
+        if (resourceDesc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D)
+        {
+            desc.dimension = TextureDimension::Texture3D;
+            desc.depth = resourceDesc.DepthOrArraySize;
+        }
+        else
+        {
+            desc.dimension = resourceDesc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE1D ?
+                TextureDimension::Texture1D : TextureDimension::Texture2D;
+            desc.arraySize = resourceDesc.DepthOrArraySize;
+        }
+        return desc;
+    }
+}
+
+UploadBatcher::UploadBatcher(ComPtr<ID3D12Device2> device, UINT64 pageSize)
+    : m_Device(device)
+    , m_PageSize(pageSize)
+{
+    D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+    queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+    m_Device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_Queue));
+    m_Device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_Fence));
+}
+
+UploadBatcher::~UploadBatcher()
+{
+    WaitForCompletion(Submit());
+}
+
+UploadBatcher::Page UploadBatcher::CreatePage(UINT64 size)
+{
+    Page page;
+    page.size = size;
+    CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_UPLOAD);
+    CD3DX12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(size);
+    m_Device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &desc,
+        D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&page.buffer));
+
+    // Upload pages stay mapped for their whole lifetime.
+    CD3DX12_RANGE readRange(0, 0);
+    page.buffer->Map(0, &readRange, reinterpret_cast<void**>(&page.data));
+    return page;
+}
+
+void UploadBatcher::Retire()
+{
+    uint64_t completed = m_Fence->GetCompletedValue();
+    while (!m_InFlight.empty() && m_InFlight.front().fenceValue <= completed)
+    {
+        auto& submission = m_InFlight.front();
+        for (auto& page : submission.pages)
+        {
+            m_FreePages.push_back(std::move(page));
+        }
+        m_FreeAllocators.push_back(submission.allocator);
+        m_InFlight.pop_front();
+    }
+}
+
+void UploadBatcher::BeginRecording()
+{
+    if (m_Recording)
+    {
+        return;
+    }
+
+    Retire();
+    if (m_FreeAllocators.empty())
+    {
+        ComPtr<ID3D12CommandAllocator> allocator;
+        m_Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&allocator));
+        m_FreeAllocators.push_back(allocator);
+    }
+    m_Allocator = m_FreeAllocators.back();
+    m_FreeAllocators.pop_back();
+    m_Allocator->Reset();
+
+    if (!m_CommandList)
+    {
+        m_Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, m_Allocator.Get(), nullptr, IID_PPV_ARGS(&m_CommandList));
+    }
+    else
+    {
+        m_CommandList->Reset(m_Allocator.Get(), nullptr);
+    }
+    m_Recording = true;
+}
+
+uint8_t* UploadBatcher::AllocateStaging(UINT64 size, UINT64 alignment, ID3D12Resource** buffer, UINT64* offset)
+{
+    BeginRecording();
+
+    if (size > m_PageSize)
+    {
+        // Too big for a page: a one-off buffer, released after the copy.
+        m_DedicatedPages.push_back(CreatePage(size));
+        *buffer = m_DedicatedPages.back().buffer.Get();
+        *offset = 0;
+        return m_DedicatedPages.back().data;
+    }
+
+    UINT64 aligned = (m_PageOffset + alignment - 1) / alignment * alignment;
+    if (m_ActivePages.empty() || aligned + size > m_PageSize)
+    {
+        Retire();
+        if (m_FreePages.empty())
+        {
+            m_ActivePages.push_back(CreatePage(m_PageSize));
+        }
+        else
+        {
+            m_ActivePages.push_back(std::move(m_FreePages.back()));
+            m_FreePages.pop_back();
+        }
+        aligned = 0;
+    }
+
+    m_PageOffset = aligned + size;
+    *buffer = m_ActivePages.back().buffer.Get();
+    *offset = aligned;
+    return m_ActivePages.back().data + aligned;
+}
+
+ComPtr<ID3D12Resource> UploadBatcher::CreateBuffer(const void* data, UINT64 size, D3D12_RESOURCE_FLAGS flags)
+{
+    ComPtr<ID3D12Resource> buffer;
+    CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
+    CD3DX12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Buffer(std::max<UINT64>(size, 1), flags);
+    if (FAILED(m_Device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &desc,
+        D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&buffer))))
+    {
+        return nullptr;
+    }
+
+    if (size)
+    {
+        UploadBuffer(buffer.Get(), 0, data, size);
+    }
+    return buffer;
+}
+
+void UploadBatcher::UploadBuffer(ID3D12Resource* destination, UINT64 destinationOffset, const void* data, UINT64 size)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    ID3D12Resource* staging = nullptr;
+    UINT64 stagingOffset = 0;
+    uint8_t* memory = AllocateStaging(size, 16, &staging, &stagingOffset);
+    memcpy(memory, data, static_cast<size_t>(size));
+    m_CommandList->CopyBufferRegion(destination, destinationOffset, staging, stagingOffset, size);
+}
+
+ComPtr<ID3D12Resource> UploadBatcher::CreateTexture(const D3D12_RESOURCE_DESC& desc, const D3D12_SUBRESOURCE_DATA* subresources)
+{
+    ComPtr<ID3D12Resource> texture;
+    CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
+    if (FAILED(m_Device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &desc,
+        D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&texture))))
+    {
+        return nullptr;
+    }
+
+    UploadTexture(texture.Get(), 0, GetTextureSubresourceCount(GetTextureDesc(desc)), subresources);
+    return texture;
+}
+
+void UploadBatcher::UploadTexture(ID3D12Resource* destination, UINT firstSubresource, UINT count, const D3D12_SUBRESOURCE_DATA* data)
+{
+    TextureDesc desc = GetTextureDesc(destination->GetDesc());
+    std::vector<TextureFootprint> footprints(count);
+    UINT64 totalSize = ComputeTextureFootprints(desc, firstSubresource, count, 0, footprints.data());
+    assert(totalSize != 0 && "unsupported texture format");
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    ID3D12Resource* staging = nullptr;
+    UINT64 stagingOffset = 0;
+    uint8_t* memory = AllocateStaging(totalSize, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, &staging, &stagingOffset);
+
+    for (UINT i = 0; i < count; ++i)
+    {
+        // Rows are repacked to the 256-byte aligned pitch the copy engine needs.
+        const TextureFootprint& footprint = footprints[i];
+        for (UINT slice = 0; slice < footprint.depth; ++slice)
+        {
+            for (UINT row = 0; row < footprint.rowCount; ++row)
+            {
+                memcpy(memory + footprint.offset + (UINT64(slice) * footprint.rowCount + row) * footprint.rowPitch,
+                    static_cast<const uint8_t*>(data[i].pData) + slice * data[i].SlicePitch + row * data[i].RowPitch,
+                    static_cast<size_t>(footprint.rowSize));
+            }
+        }
+
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT placed = {};
+        placed.Offset = stagingOffset + footprint.offset;
+        placed.Footprint = { desc.format, footprint.width, footprint.height, footprint.depth, footprint.rowPitch };
+        CD3DX12_TEXTURE_COPY_LOCATION destinationLocation(destination, firstSubresource + i);
+        CD3DX12_TEXTURE_COPY_LOCATION sourceLocation(staging, placed);
+        m_CommandList->CopyTextureRegion(&destinationLocation, 0, 0, 0, &sourceLocation, nullptr);
+    }
+}
+
+void UploadBatcher::UploadTiles(ID3D12Resource* destination, const D3D12_TILED_RESOURCE_COORDINATE& coordinate,
+    const D3D12_TILE_REGION_SIZE& regionSize, const void* data, UINT64 size)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    ID3D12Resource* staging = nullptr;
+    UINT64 stagingOffset = 0;
+    uint8_t* memory = AllocateStaging(size, D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES, &staging, &stagingOffset);
+    memcpy(memory, data, static_cast<size_t>(size));
+    m_CommandList->CopyTiles(destination, &coordinate, &regionSize, staging, stagingOffset,
+        D3D12_TILE_COPY_FLAG_LINEAR_BUFFER_TO_SWIZZLED_TILED_RESOURCE);
+}
+
+uint64_t UploadBatcher::Submit()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (!m_Recording)
+    {
+        return m_FenceValue;
+    }
+
+    m_CommandList->Close();
+    ID3D12CommandList* const commandLists[] = { m_CommandList.Get() };
+    m_Queue->ExecuteCommandLists(_countof(commandLists), commandLists);
+    m_Queue->Signal(m_Fence.Get(), ++m_FenceValue);
+
+    Submission submission;
+    submission.fenceValue = m_FenceValue;
+    submission.allocator = m_Allocator;
+    submission.pages = std::move(m_ActivePages);
+    submission.dedicatedPages = std::move(m_DedicatedPages);
+    m_InFlight.push_back(std::move(submission));
+
+    m_ActivePages.clear();
+    m_DedicatedPages.clear();
+    m_PageOffset = 0;
+    m_Allocator.Reset();
+    m_Recording = false;
+    return m_FenceValue;
+}
+
+void UploadBatcher::WaitForCompletion(uint64_t fenceValue)
+{
+    // A null event blocks until the fence is reached, which is safe to do
+    // from several threads at once.
+    if (m_Fence->GetCompletedValue() < fenceValue)
+    {
+        m_Fence->SetEventOnCompletion(fenceValue, nullptr);
+    }
+}
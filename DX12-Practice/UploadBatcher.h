@@ -0,0 +1,106 @@
+#pragma once
+#include "UploadQueue.h"
+#include "Win.h"
+#include <wrl/client.h>
+
+#include "directx/d3dx12.h"
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// Batches CPU -> GPU copies on a dedicated copy queue. Source data (often a
+// memory-mapped file) is copied once into persistently mapped upload pages
+// and a CopyBufferRegion is recorded; Submit() executes everything recorded
+// so far and returns a fence value. Pages are recycled once their fence
+// completes. Safe to call from loader threads.
+//
+// Destination buffers are created in the COMMON state and decay back to it
+// after the copy queue is done, so other queues can use them without
+// barriers once they have waited for the fence (see WaitOnQueue).
+class UploadBatcher : public UploadQueue
+{
+public:
+    explicit UploadBatcher(Microsoft::WRL::ComPtr<ID3D12Device2> device, UINT64 pageSize = 4 * 1024 * 1024);
+    ~UploadBatcher();
+
+    UploadBatcher(const UploadBatcher&) = delete;
+    UploadBatcher& operator=(const UploadBatcher&) = delete;
+
+    // Creates a default-heap buffer and records a copy of data into it.
+    Microsoft::WRL::ComPtr<ID3D12Resource> CreateBuffer(const void* data, UINT64 size,
+        D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE);
+
+    void UploadBuffer(ID3D12Resource* destination, UINT64 destinationOffset, const void* data, UINT64 size);
+
+    // Creates a default-heap texture and records copies of all its
+    // subresources (in D3D12 order) into it.
+    Microsoft::WRL::ComPtr<ID3D12Resource> CreateTexture(const D3D12_RESOURCE_DESC& desc, const D3D12_SUBRESOURCE_DATA* subresources);
+
+    // Copies subresources of a texture created in the COMMON state. Staging
+    // footprints are computed on the CPU (see ComputeTextureFootprints).
+    void UploadTexture(ID3D12Resource* destination, UINT firstSubresource, UINT count, const D3D12_SUBRESOURCE_DATA* data);
+    void UploadTexture(ID3D12Resource* destination, UINT subresource, const D3D12_SUBRESOURCE_DATA& data)
+    {
+        UploadTexture(destination, subresource, 1, &data);
+    }
+
+    // Copies linear tile data (64 KB per tile) into a mapped region of a
+    // reserved resource. Map the tiles on GetQueue() before submitting.
+    void UploadTiles(ID3D12Resource* destination, const D3D12_TILED_RESOURCE_COORDINATE& coordinate,
+        const D3D12_TILE_REGION_SIZE& regionSize, const void* data, UINT64 size);
+
+    // Executes all recorded copies; the returned value is reached on
+    // GetFence() when they are done.
+    uint64_t Submit() override;
+
+    bool IsComplete(uint64_t fenceValue) const override { return m_Fence->GetCompletedValue() >= fenceValue; }
+    void WaitForCompletion(uint64_t fenceValue);
+
+    // Makes queue wait on the GPU until the uploads up to fenceValue are done.
+    void WaitOnQueue(ID3D12CommandQueue* queue, uint64_t fenceValue) { queue->Wait(m_Fence.Get(), fenceValue); }
+
+    ID3D12Fence* GetFence() const { return m_Fence.Get(); }
+    ID3D12CommandQueue* GetQueue() const { return m_Queue.Get(); }
+
+private:
+    struct Page
+    {
+        Microsoft::WRL::ComPtr<ID3D12Resource> buffer;
+        uint8_t* data = nullptr;
+        UINT64 size = 0;
+    };
+
+    struct Submission
+    {
+        uint64_t fenceValue;
+        Microsoft::WRL::ComPtr<ID3D12CommandAllocator> allocator;
+        std::vector<Page> pages;
+        std::vector<Page> dedicatedPages;
+    };
+
+    // Returns staging memory for size bytes; called with m_Mutex held.
+    uint8_t* AllocateStaging(UINT64 size, UINT64 alignment, ID3D12Resource** buffer, UINT64* offset);
+    Page CreatePage(UINT64 size);
+    void Retire();
+    void BeginRecording();
+
+    Microsoft::WRL::ComPtr<ID3D12Device2> m_Device;
+    Microsoft::WRL::ComPtr<ID3D12CommandQueue> m_Queue;
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> m_CommandList;
+    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> m_Allocator;
+    Microsoft::WRL::ComPtr<ID3D12Fence> m_Fence;
+    uint64_t m_FenceValue = 0;
+
+    UINT64 m_PageSize;
+    std::vector<Page> m_FreePages;
+    std::vector<Page> m_ActivePages;    // recorded into the open command list
+    std::vector<Page> m_DedicatedPages; // larger than m_PageSize
+    UINT64 m_PageOffset = 0;            // into m_ActivePages.back()
+    bool m_Recording = false;
+
+    std::deque<Submission> m_InFlight;
+    std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>> m_FreeAllocators;
+    std::mutex m_Mutex;
+};
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstdint>
+
+// What the asset loader's upload stage needs from a copy queue: Submit()
+// executes the copies recorded so far and returns a fence value, and
+// IsComplete() tells when that value has been reached. UploadBatcher is the
+// D3D12 implementation; tools and benchmarks provide their own.
+class UploadQueue
+{
+public:
+    virtual ~UploadQueue() = default;
+
+    virtual uint64_t Submit() = 0;
+    virtual bool IsComplete(uint64_t fenceValue) const = 0;
+};
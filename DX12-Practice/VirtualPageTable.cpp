@@ -0,0 +1,211 @@
+#include "VirtualPageTable.h"
+
+#include <algorithm>
+#include <cassert>
+
+VirtualPageTable::VirtualPageTable(uint32_t widthInPages, uint32_t heightInPages, uint32_t mipCount, uint32_t physicalSlots)
+    : m_Width(widthInPages)
+    , m_Height(heightInPages)
+    , m_MipCount(mipCount)
+{
+    assert(widthInPages <= 4096 && heightInPages <= 4096 && mipCount <= 255);
+    uint32_t pageCount = 0;
+    for (uint32_t mip = 0; mip < mipCount; ++mip)
+    {
+        m_MipOffsets.push_back(pageCount);
+        pageCount += GetMipWidth(mip) * GetMipHeight(mip);
+    }
+    m_MipOffsets.push_back(pageCount);
+    m_Pages.resize(pageCount);
+
+    for (uint32_t slot = physicalSlots; slot > 0; --slot)
+    {
+        m_FreeSlots.push_back(slot - 1);
+    }
+}
+
+void VirtualPageTable::GetPageCoordinates(uint32_t page, uint32_t& mip, uint32_t& x, uint32_t& y) const
+{
+    mip = static_cast<uint32_t>(std::upper_bound(m_MipOffsets.begin(), m_MipOffsets.end(), page) - m_MipOffsets.begin()) - 1;
+    uint32_t local = page - m_MipOffsets[mip];
+    x = local % GetMipWidth(mip);
+    y = local / GetMipWidth(mip);
+}
+
+void VirtualPageTable::LinkFront(uint32_t page)
+{
+    Page& entry = m_Pages[page];
+    entry.lruPrevious = c_NoPage;
+    entry.lruNext = m_LruHead;
+    if (m_LruHead != c_NoPage)
+    {
+        m_Pages[m_LruHead].lruPrevious = page;
+    }
+    m_LruHead = page;
+    if (m_LruTail == c_NoPage)
+    {
+        m_LruTail = page;
+    }
+}
+
+void VirtualPageTable::Unlink(uint32_t page)
+{
+    Page& entry = m_Pages[page];
+    if (entry.lruPrevious != c_NoPage)
+    {
+        m_Pages[entry.lruPrevious].lruNext = entry.lruNext;
+    }
+    else
+    {
+        m_LruHead = entry.lruNext;
+    }
+    if (entry.lruNext != c_NoPage)
+    {
+        m_Pages[entry.lruNext].lruPrevious = entry.lruPrevious;
+    }
+    else
+    {
+        m_LruTail = entry.lruPrevious;
+    }
+    entry.lruPrevious = entry.lruNext = c_NoPage;
+}
+
+void VirtualPageTable::Request(uint32_t page)
+{
+    uint32_t mip, x, y;
+    GetPageCoordinates(page, mip, x, y);
+    for (; mip < m_MipCount; ++mip, x >>= 1, y >>= 1)
+    {
+        uint32_t current = GetPage(mip, x, y);
+        Page& entry = m_Pages[current];
+        entry.lastRequested = m_Frame;
+        if (entry.state != NotResident)
+        {
+            Unlink(current);
+            LinkFront(current);
+        }
+        else if (!entry.requested)
+        {
+            entry.requested = true;
+            m_Requests.push_back(current);
+        }
+    }
+}
+
+void VirtualPageTable::RequestFeedback(const uint32_t* feedback, size_t count)
+{
+    uint32_t previous = c_NoFeedback;
+    for (size_t i = 0; i < count; ++i)
+    {
+        // Neighbouring texels usually hit the same page.
+        uint32_t value = feedback[i];
+        if (value == c_NoFeedback || value == previous)
+        {
+            continue;
+        }
+        previous = value;
+
+        uint32_t mip = value >> 24;
+        uint32_t x = value & 0xfff;
+        uint32_t y = (value >> 12) & 0xfff;
+        if (mip < m_MipCount && x < GetMipWidth(mip) && y < GetMipHeight(mip))
+        {
+            Request(GetPage(mip, x, y));
+        }
+    }
+}
+
+void VirtualPageTable::Update(uint32_t maxMappings, uint32_t protectFrames, std::vector<VirtualPageMapping>& mappings)
+{
+    mappings.clear();
+
+    // Coarse mips first: they cover the most screen area per page.
+    std::sort(m_Requests.begin(), m_Requests.end(), [this](uint32_t a, uint32_t b) { return a > b; });
+
+    for (uint32_t page : m_Requests)
+    {
+        m_Pages[page].requested = false;
+        if (mappings.size() >= maxMappings)
+        {
+            continue;
+        }
+
+        VirtualPageMapping mapping = { page, c_NoPage, c_NoPage };
+        if (!m_FreeSlots.empty())
+        {
+            mapping.slot = m_FreeSlots.back();
+            m_FreeSlots.pop_back();
+        }
+        else
+        {
+            // The tail is least recently requested; skip pages still loading.
+            uint32_t victim = m_LruTail;
+            while (victim != c_NoPage && m_Pages[victim].state != Resident)
+            {
+                victim = m_Pages[victim].lruPrevious;
+            }
+            if (victim == c_NoPage || m_Pages[victim].lastRequested + protectFrames > m_Frame)
+            {
+                continue;
+            }
+
+            Page& evicted = m_Pages[victim];
+            Unlink(victim);
+            mapping.slot = evicted.slot;
+            mapping.evictedPage = victim;
+            evicted.slot = c_NoPage;
+            evicted.state = NotResident;
+            --m_ResidentCount;
+        }
+
+        Page& entry = m_Pages[page];
+        entry.slot = mapping.slot;
+        entry.state = Loading;
+        LinkFront(page);
+        mappings.push_back(mapping);
+    }
+    m_Requests.clear();
+}
+
+void VirtualPageTable::MarkResident(uint32_t page)
+{
+    Page& entry = m_Pages[page];
+    if (entry.state == Loading)
+    {
+        entry.state = Resident;
+        ++m_ResidentCount;
+    }
+}
+
+void VirtualPageTable::CancelLoad(uint32_t page)
+{
+    Page& entry = m_Pages[page];
+    if (entry.state == Loading)
+    {
+        Unlink(page);
+        m_FreeSlots.push_back(entry.slot);
+        entry.slot = c_NoPage;
+        entry.state = NotResident;
+    }
+}
+
+void VirtualPageTable::BuildMinMipMap(std::vector<uint8_t>& map) const
+{
+    map.assign(m_Width * m_Height, static_cast<uint8_t>(m_MipCount));
+    for (uint32_t mip = m_MipCount; mip-- > 0;)
+    {
+        // Finer mips overwrite coarser ones, but only where the coarser mip
+        // is resident too, so a clamped sample never lands on a hole.
+        for (uint32_t y = 0; y < m_Height; ++y)
+        {
+            for (uint32_t x = 0; x < m_Width; ++x)
+            {
+                uint8_t& value = map[y * m_Width + x];
+                if (value == mip + 1 && IsResident(GetPage(mip, x >> mip, y >> mip)))
+                {
+                    value = static_cast<uint8_t>(mip);
+                }
+            }
+        }
+    }
+}
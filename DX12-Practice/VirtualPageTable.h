@@ -0,0 +1,99 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Platform-neutral page bookkeeping for a virtual (tiled) texture: which
+// virtual pages are backed by which physical slot of the tile pool, LRU
+// eviction, and decoding of the GPU feedback buffer.
+//
+// Pages move NotResident -> Loading (slot assigned, data in flight) ->
+// Resident (MarkResident once the upload fence completed). Only resident
+// pages that have not been requested for a few frames are evicted, and the
+// min-mip map handed to shaders only ever points at resident pages.
+struct VirtualPageMapping
+{
+    uint32_t page;          // page to map
+    uint32_t slot;          // physical slot in the tile pool
+    uint32_t evictedPage;   // page that owned the slot before, or c_NoPage
+};
+
+class VirtualPageTable
+{
+public:
+    static constexpr uint32_t c_NoPage = UINT32_MAX;
+    // Feedback texels hold mip << 24 | y << 12 | x, or c_NoFeedback.
+    static constexpr uint32_t c_NoFeedback = UINT32_MAX;
+
+    // widthInPages/heightInPages describe mip 0; mipCount counts the
+    // individually mapped mips (packed tail mips are managed by the caller).
+    VirtualPageTable(uint32_t widthInPages, uint32_t heightInPages, uint32_t mipCount, uint32_t physicalSlots);
+
+    static uint32_t EncodeFeedback(uint32_t mip, uint32_t x, uint32_t y) { return (mip << 24) | (y << 12) | x; }
+
+    uint32_t GetPage(uint32_t mip, uint32_t x, uint32_t y) const { return m_MipOffsets[mip] + y * GetMipWidth(mip) + x; }
+    void GetPageCoordinates(uint32_t page, uint32_t& mip, uint32_t& x, uint32_t& y) const;
+    // Page counts round up per mip, so the page above (x >> 1, y >> 1) always
+    // exists, also when the page grid is not a power of two.
+    uint32_t GetMipWidth(uint32_t mip) const { return (m_Width + (1u << mip) - 1) >> mip; }
+    uint32_t GetMipHeight(uint32_t mip) const { return (m_Height + (1u << mip) - 1) >> mip; }
+    uint32_t GetMipCount() const { return m_MipCount; }
+
+    void BeginFrame(uint64_t frame) { m_Frame = frame; }
+
+    // Marks a page as wanted this frame. Missing coarser mips of the same
+    // area are requested too, so there is always something to fall back to.
+    void Request(uint32_t page);
+    // Decodes feedback texels and requests each distinct page once.
+    void RequestFeedback(const uint32_t* feedback, size_t count);
+
+    // Assigns slots to up to maxMappings requested, non-resident pages,
+    // coarsest mips first, evicting least recently used pages not requested
+    // within protectFrames frames.
+    void Update(uint32_t maxMappings, uint32_t protectFrames, std::vector<VirtualPageMapping>& mappings);
+
+    void MarkResident(uint32_t page);
+    // Gives up on a loading page (its data was not available); the slot is
+    // freed and the page can be requested again.
+    void CancelLoad(uint32_t page);
+    bool IsResident(uint32_t page) const { return m_Pages[page].state == Resident; }
+    uint32_t GetSlot(uint32_t page) const { return m_Pages[page].slot; }
+    uint32_t GetResidentCount() const { return m_ResidentCount; }
+
+    // Per mip-0 page: the finest mip resident there (m_MipCount when only the
+    // packed tail is), for clamping the sampled LOD in the shader.
+    void BuildMinMipMap(std::vector<uint8_t>& map) const;
+
+private:
+    enum State : uint8_t
+    {
+        NotResident,
+        Loading,
+        Resident
+    };
+
+    struct Page
+    {
+        uint64_t lastRequested = 0;
+        uint32_t slot = c_NoPage;
+        uint32_t lruPrevious = c_NoPage;
+        uint32_t lruNext = c_NoPage;
+        State state = NotResident;
+        bool requested = false;
+    };
+
+    void LinkFront(uint32_t page);
+    void Unlink(uint32_t page);
+
+    uint32_t m_Width;
+    uint32_t m_Height;
+    uint32_t m_MipCount;
+    std::vector<uint32_t> m_MipOffsets;
+    std::vector<Page> m_Pages;
+    std::vector<uint32_t> m_FreeSlots;
+    std::vector<uint32_t> m_Requests;   // this frame, deduplicated via Page::requested
+    uint32_t m_LruHead = c_NoPage;      // most recently requested
+    uint32_t m_LruTail = c_NoPage;
+    uint32_t m_ResidentCount = 0;
+    uint64_t m_Frame = 0;
+};
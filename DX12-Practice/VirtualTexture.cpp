@@ -0,0 +1,265 @@
+#include "VirtualTexture.h"
+
+#include "UploadBatcher.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+using Microsoft::WRL::ComPtr;
+
+bool VirtualTexture::IsSupported(ID3D12Device2* device)
+{
+    // Tier 2 is needed for the LOD clamp on Sample and for unmapped tiles
+    // reading as zero.
+    D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+    return SUCCEEDED(device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options)))
+        && options.TiledResourcesTier >= D3D12_TILED_RESOURCES_TIER_2;
+}
+
+bool VirtualTexture::Init(ComPtr<ID3D12Device2> device, UploadBatcher& batcher, const D3D12_RESOURCE_DESC& desc,
+    uint32_t physicalPages, uint32_t feedbackWidth, uint32_t feedbackHeight, uint32_t frameCount,
+    VirtualTileLoader tileLoader, const VirtualPackedMipLoader& packedMipLoader)
+{
+    assert(desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE2D && desc.DepthOrArraySize == 1);
+    m_Device = device;
+    m_Batcher = &batcher;
+    m_TileLoader = std::move(tileLoader);
+    m_PhysicalPages = physicalPages;
+
+    D3D12_RESOURCE_DESC reservedDesc = desc;
+    reservedDesc.Layout = D3D12_TEXTURE_LAYOUT_64KB_UNDEFINED_SWIZZLE;
+    if (FAILED(m_Device->CreateReservedResource(&reservedDesc, D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&m_Resource))))
+    {
+        return false;
+    }
+
+    UINT tileCount = 0;
+    UINT subresourceCount = 1;
+    D3D12_SUBRESOURCE_TILING mip0Tiling = {};
+    m_Device->GetResourceTiling(m_Resource.Get(), &tileCount, &m_PackedMipInfo, &m_TileShape, &subresourceCount, 0, &mip0Tiling);
+
+    // The page table halves the page grid per mip, rounding up like the
+    // tiling of each standard mip does.
+    uint32_t mipCount = m_PackedMipInfo.NumStandardMips;
+    m_PageTable = std::make_unique<VirtualPageTable>(mip0Tiling.WidthInTiles, mip0Tiling.HeightInTiles, mipCount, physicalPages);
+
+    // Packed mips get their own tiles after the streamed pool.
+    CD3DX12_HEAP_DESC heapDesc(UINT64(physicalPages + m_PackedMipInfo.NumTilesForPackedMips) * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES,
+        D3D12_HEAP_TYPE_DEFAULT, 0, D3D12_HEAP_FLAG_DENY_BUFFERS | D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES);
+    if (FAILED(m_Device->CreateHeap(&heapDesc, IID_PPV_ARGS(&m_TilePool))))
+    {
+        return false;
+    }
+    MapPackedMips();
+
+    for (UINT mip = 0; mip < m_PackedMipInfo.NumPackedMips; ++mip)
+    {
+        D3D12_SUBRESOURCE_DATA data = {};
+        packedMipLoader(mipCount + mip, data);
+        batcher.UploadTexture(m_Resource.Get(), mipCount + mip, data);
+    }
+
+    // Feedback: one uint per texel, cleared to c_NoFeedback by copying from
+    // an upload buffer, read back once per frame slot.
+    m_FeedbackSize = UINT64(feedbackWidth) * feedbackHeight * sizeof(uint32_t);
+    CD3DX12_RESOURCE_DESC feedbackDesc = CD3DX12_RESOURCE_DESC::Buffer(m_FeedbackSize, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+    CD3DX12_HEAP_PROPERTIES defaultHeap(D3D12_HEAP_TYPE_DEFAULT);
+    if (FAILED(m_Device->CreateCommittedResource(&defaultHeap, D3D12_HEAP_FLAG_NONE, &feedbackDesc,
+        D3D12_RESOURCE_STATE_UNORDERED_ACCESS, nullptr, IID_PPV_ARGS(&m_Feedback))))
+    {
+        return false;
+    }
+
+    CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(m_FeedbackSize);
+    CD3DX12_HEAP_PROPERTIES uploadHeap(D3D12_HEAP_TYPE_UPLOAD);
+    if (FAILED(m_Device->CreateCommittedResource(&uploadHeap, D3D12_HEAP_FLAG_NONE, &bufferDesc,
+        D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&m_FeedbackClear))))
+    {
+        return false;
+    }
+    void* clear = nullptr;
+    CD3DX12_RANGE readRange(0, 0);
+    m_FeedbackClear->Map(0, &readRange, &clear);
+    memset(clear, 0xff, static_cast<size_t>(m_FeedbackSize));
+    m_FeedbackClear->Unmap(0, nullptr);
+
+    CD3DX12_HEAP_PROPERTIES readbackHeap(D3D12_HEAP_TYPE_READBACK);
+    m_FeedbackReadback.resize(frameCount);
+    m_FeedbackValid.assign(frameCount, false);
+    m_FeedbackCleared = false;
+    for (auto& readback : m_FeedbackReadback)
+    {
+        if (FAILED(m_Device->CreateCommittedResource(&readbackHeap, D3D12_HEAP_FLAG_NONE, &bufferDesc,
+            D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&readback))))
+        {
+            return false;
+        }
+    }
+
+    CD3DX12_RESOURCE_DESC minMipDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8_UINT,
+        mip0Tiling.WidthInTiles, mip0Tiling.HeightInTiles, 1, 1);
+    if (FAILED(m_Device->CreateCommittedResource(&defaultHeap, D3D12_HEAP_FLAG_NONE, &minMipDesc,
+        D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&m_MinMipTexture))))
+    {
+        return false;
+    }
+    m_UploadedMinMipMap.clear();
+    m_TileData.resize(D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES);
+    return true;
+}
+
+void VirtualTexture::MapPackedMips()
+{
+    if (m_PackedMipInfo.NumPackedMips == 0)
+    {
+        return;
+    }
+
+    // The packed tail is addressed through its first subresource with a
+    // tile count and no box.
+    CD3DX12_TILED_RESOURCE_COORDINATE coordinate(0, 0, 0, m_PackedMipInfo.NumStandardMips);
+    CD3DX12_TILE_REGION_SIZE regionSize(m_PackedMipInfo.NumTilesForPackedMips, FALSE, 0, 0, 0);
+    D3D12_TILE_RANGE_FLAGS rangeFlags = D3D12_TILE_RANGE_FLAG_NONE;
+    UINT heapOffset = m_PhysicalPages;
+    UINT rangeTileCount = m_PackedMipInfo.NumTilesForPackedMips;
+    m_Batcher->GetQueue()->UpdateTileMappings(m_Resource.Get(), 1, &coordinate, &regionSize, m_TilePool.Get(),
+        1, &rangeFlags, &heapOffset, &rangeTileCount, D3D12_TILE_MAPPING_FLAG_NONE);
+}
+
+void VirtualTexture::MapTile(uint32_t page, uint32_t slot)
+{
+    uint32_t mip, x, y;
+    m_PageTable->GetPageCoordinates(page, mip, x, y);
+    CD3DX12_TILED_RESOURCE_COORDINATE coordinate(x, y, 0, mip);
+    CD3DX12_TILE_REGION_SIZE regionSize(1, FALSE, 0, 0, 0);
+    D3D12_TILE_RANGE_FLAGS rangeFlags = D3D12_TILE_RANGE_FLAG_NONE;
+    UINT heapOffset = slot;
+    UINT rangeTileCount = 1;
+    m_Batcher->GetQueue()->UpdateTileMappings(m_Resource.Get(), 1, &coordinate, &regionSize, m_TilePool.Get(),
+        1, &rangeFlags, &heapOffset, &rangeTileCount, D3D12_TILE_MAPPING_FLAG_NONE);
+}
+
+void VirtualTexture::UnmapTile(uint32_t page)
+{
+    uint32_t mip, x, y;
+    m_PageTable->GetPageCoordinates(page, mip, x, y);
+    CD3DX12_TILED_RESOURCE_COORDINATE coordinate(x, y, 0, mip);
+    CD3DX12_TILE_REGION_SIZE regionSize(1, FALSE, 0, 0, 0);
+    D3D12_TILE_RANGE_FLAGS rangeFlags = D3D12_TILE_RANGE_FLAG_NULL;
+    UINT rangeTileCount = 1;
+    m_Batcher->GetQueue()->UpdateTileMappings(m_Resource.Get(), 1, &coordinate, &regionSize, nullptr,
+        1, &rangeFlags, nullptr, &rangeTileCount, D3D12_TILE_MAPPING_FLAG_NONE);
+}
+
+uint64_t VirtualTexture::Update(uint64_t frame, uint32_t frameIndex, ID3D12Fence* graphicsFence, uint64_t previousFrameFenceValue,
+    uint32_t maxMappings)
+{
+    // Pages whose copies finished become visible through the min-mip map.
+    m_Pending.erase(std::remove_if(m_Pending.begin(), m_Pending.end(), [this](const PendingUpload& pending)
+    {
+        if (!m_Batcher->IsComplete(pending.fenceValue))
+        {
+            return false;
+        }
+        for (uint32_t page : pending.pages)
+        {
+            m_PageTable->MarkResident(page);
+        }
+        return true;
+    }), m_Pending.end());
+
+    m_PageTable->BeginFrame(frame);
+    if (m_FeedbackValid[frameIndex])
+    {
+        void* feedback = nullptr;
+        CD3DX12_RANGE readRange(0, static_cast<SIZE_T>(m_FeedbackSize));
+        if (SUCCEEDED(m_FeedbackReadback[frameIndex]->Map(0, &readRange, &feedback)))
+        {
+            m_PageTable->RequestFeedback(static_cast<const uint32_t*>(feedback), static_cast<size_t>(m_FeedbackSize / sizeof(uint32_t)));
+            CD3DX12_RANGE writeRange(0, 0);
+            m_FeedbackReadback[frameIndex]->Unmap(0, &writeRange);
+        }
+        m_FeedbackValid[frameIndex] = false;
+    }
+
+    // Frames still in flight may sample a page evicted here, so keep it for
+    // as many frames as can be queued.
+    m_PageTable->Update(maxMappings, static_cast<uint32_t>(m_FeedbackReadback.size()) + 1, m_Mappings);
+    m_PageTable->BuildMinMipMap(m_MinMipMap);
+    if (m_Mappings.empty() && m_MinMipMap == m_UploadedMinMipMap)
+    {
+        return m_UploadFenceValue;
+    }
+
+    // Remapping and overwriting the min-mip map must wait until the previous
+    // frame stopped sampling. The min-mip map recorded now never points at
+    // evicted or still loading pages.
+    if (graphicsFence)
+    {
+        m_Batcher->GetQueue()->Wait(graphicsFence, previousFrameFenceValue);
+    }
+
+    PendingUpload pending;
+    for (const VirtualPageMapping& mapping : m_Mappings)
+    {
+        if (mapping.evictedPage != VirtualPageTable::c_NoPage)
+        {
+            UnmapTile(mapping.evictedPage);
+        }
+
+        uint32_t mip, x, y;
+        m_PageTable->GetPageCoordinates(mapping.page, mip, x, y);
+        if (!m_TileLoader(mip, x, y, m_TileData.data()))
+        {
+            m_PageTable->CancelLoad(mapping.page);
+            continue;
+        }
+
+        MapTile(mapping.page, mapping.slot);
+        CD3DX12_TILED_RESOURCE_COORDINATE coordinate(x, y, 0, mip);
+        CD3DX12_TILE_REGION_SIZE regionSize(1, FALSE, 0, 0, 0);
+        m_Batcher->UploadTiles(m_Resource.Get(), coordinate, regionSize, m_TileData.data(), m_TileData.size());
+        pending.pages.push_back(mapping.page);
+    }
+
+    if (m_MinMipMap != m_UploadedMinMipMap)
+    {
+        D3D12_SUBRESOURCE_DATA data = {};
+        data.pData = m_MinMipMap.data();
+        data.RowPitch = m_PageTable->GetMipWidth(0);
+        data.SlicePitch = m_MinMipMap.size();
+        m_Batcher->UploadTexture(m_MinMipTexture.Get(), 0, data);
+        m_UploadedMinMipMap = m_MinMipMap;
+    }
+
+    m_UploadFenceValue = m_Batcher->Submit();
+    if (!pending.pages.empty())
+    {
+        pending.fenceValue = m_UploadFenceValue;
+        m_Pending.push_back(std::move(pending));
+    }
+    return m_UploadFenceValue;
+}
+
+void VirtualTexture::ResolveFeedback(ID3D12GraphicsCommandList* commandList, uint32_t frameIndex)
+{
+    CD3DX12_RESOURCE_BARRIER toCopySource = CD3DX12_RESOURCE_BARRIER::Transition(m_Feedback.Get(),
+        D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE);
+    commandList->ResourceBarrier(1, &toCopySource);
+    commandList->CopyBufferRegion(m_FeedbackReadback[frameIndex].Get(), 0, m_Feedback.Get(), 0, m_FeedbackSize);
+
+    CD3DX12_RESOURCE_BARRIER toCopyDest = CD3DX12_RESOURCE_BARRIER::Transition(m_Feedback.Get(),
+        D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
+    commandList->ResourceBarrier(1, &toCopyDest);
+    commandList->CopyBufferRegion(m_Feedback.Get(), 0, m_FeedbackClear.Get(), 0, m_FeedbackSize);
+
+    CD3DX12_RESOURCE_BARRIER toUnorderedAccess = CD3DX12_RESOURCE_BARRIER::Transition(m_Feedback.Get(),
+        D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    commandList->ResourceBarrier(1, &toUnorderedAccess);
+
+    // The buffer starts out zeroed rather than cleared, so the first copy is
+    // not worth reading.
+    m_FeedbackValid[frameIndex] = m_FeedbackCleared;
+    m_FeedbackCleared = true;
+}
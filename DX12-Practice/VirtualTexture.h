@@ -0,0 +1,102 @@
+#pragma once
+#include "Win.h"
+#include <wrl/client.h>
+
+#include "directx/d3dx12.h"
+
+#include "VirtualPageTable.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class UploadBatcher;
+
+// Fills one 64 KB tile of (mip, x, y) in the resource's tile shape; returns
+// false if the data is not available (the page is retried next frame).
+using VirtualTileLoader = std::function<bool(uint32_t mip, uint32_t x, uint32_t y, void* tile)>;
+// Fills one packed tail mip as linear rows; called once from Init.
+using VirtualPackedMipLoader = std::function<void(uint32_t mip, D3D12_SUBRESOURCE_DATA& data)>;
+
+// Streams a large 2D texture through a reserved resource. Shaders write the
+// pages they want into a feedback buffer (shaders/VirtualTexture.hlsli);
+// the CPU reads it back a few frames later, lets VirtualPageTable pick
+// pages to map and evict, and remaps tiles of a fixed-size pool heap with
+// UpdateTileMappings on the upload queue. Sampling is clamped to resident
+// mips through a per-page min-mip map.
+//
+// Per frame, on the graphics thread:
+//     Update(frame, frameIndex, graphicsFence, lastCompletedValue) before recording,
+//     the graphics queue waits for the returned upload fence value,
+//     draws write feedback, then ResolveFeedback(commandList, frameIndex).
+class VirtualTexture
+{
+public:
+    static bool IsSupported(ID3D12Device2* device);
+
+    // desc: a 2D texture with its full mip chain; physicalPages: size of the
+    // tile pool in 64 KB tiles; feedbackWidth/Height: the feedback buffer
+    // resolution (typically the render target divided by 8).
+    bool Init(Microsoft::WRL::ComPtr<ID3D12Device2> device, UploadBatcher& batcher, const D3D12_RESOURCE_DESC& desc,
+        uint32_t physicalPages, uint32_t feedbackWidth, uint32_t feedbackHeight, uint32_t frameCount,
+        VirtualTileLoader tileLoader, const VirtualPackedMipLoader& packedMipLoader);
+
+    // Reads back the feedback of the frame that last used frameIndex (its
+    // fence must have completed), maps and uploads up to maxMappings pages
+    // and refreshes the min-mip map. Tiles are only remapped after the
+    // graphics queue reached previousFrameFenceValue on graphicsFence.
+    // Returns the upload fence value the graphics queue has to wait for.
+    uint64_t Update(uint64_t frame, uint32_t frameIndex, ID3D12Fence* graphicsFence, uint64_t previousFrameFenceValue,
+        uint32_t maxMappings = 32);
+
+    // Copies the feedback buffer to frameIndex's readback buffer and clears
+    // it for the next frame. The buffer is in the UNORDERED_ACCESS state
+    // outside of this call.
+    void ResolveFeedback(ID3D12GraphicsCommandList* commandList, uint32_t frameIndex);
+
+    ID3D12Resource* GetResource() const { return m_Resource.Get(); }
+    ID3D12Resource* GetFeedbackBuffer() const { return m_Feedback.Get(); }
+    // R8_UINT, one texel per mip 0 page, in the COMMON state.
+    ID3D12Resource* GetMinMipTexture() const { return m_MinMipTexture.Get(); }
+    const D3D12_TILE_SHAPE& GetTileShape() const { return m_TileShape; }
+    const VirtualPageTable& GetPageTable() const { return *m_PageTable; }
+
+private:
+    struct PendingUpload
+    {
+        uint64_t fenceValue;
+        std::vector<uint32_t> pages;
+    };
+
+    void MapTile(uint32_t page, uint32_t slot);
+    void UnmapTile(uint32_t page);
+    void MapPackedMips();
+
+    Microsoft::WRL::ComPtr<ID3D12Device2> m_Device;
+    UploadBatcher* m_Batcher = nullptr;
+    VirtualTileLoader m_TileLoader;
+
+    Microsoft::WRL::ComPtr<ID3D12Resource> m_Resource;
+    Microsoft::WRL::ComPtr<ID3D12Heap> m_TilePool;
+    D3D12_TILE_SHAPE m_TileShape = {};
+    D3D12_PACKED_MIP_INFO m_PackedMipInfo = {};
+    uint32_t m_PhysicalPages = 0;
+
+    Microsoft::WRL::ComPtr<ID3D12Resource> m_Feedback;
+    Microsoft::WRL::ComPtr<ID3D12Resource> m_FeedbackClear;
+    std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> m_FeedbackReadback;
+    std::vector<bool> m_FeedbackValid;
+    bool m_FeedbackCleared = false;
+    UINT64 m_FeedbackSize = 0;
+
+    Microsoft::WRL::ComPtr<ID3D12Resource> m_MinMipTexture;
+    std::vector<uint8_t> m_MinMipMap;
+    std::vector<uint8_t> m_UploadedMinMipMap;
+
+    std::unique_ptr<VirtualPageTable> m_PageTable;
+    std::vector<VirtualPageMapping> m_Mappings;
+    std::vector<PendingUpload> m_Pending;
+    std::vector<uint8_t> m_TileData;
+    uint64_t m_UploadFenceValue = 0;
+};
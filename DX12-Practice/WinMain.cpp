@@ -7,10 +7,39 @@ using namespace Microsoft::WRL;
 #include <dxgi1_6.h>
 #include <d3dcompiler.h>
 #include <DirectXMath.h>
+#include <psapi.h>
 
 #include <algorithm>
 #include <cassert> // assert macro
 #include <chrono>  // clock
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BackgroundPass.h"
+#include "Benchmark.h"
+#include "ConstantBufferManager.h"
+#include "D3D12RenderInterface.h"
+#include "FrustumCulling.h"
+#include "GpuFrameTimer.h"
+#include "GpuMesh.h"
+#include "HotReload.h"
+#include "IndirectDrawPass.h"
+#include "JobSystem.h"
+#include "MeshFile.h"
+#include "MeshletBuilder.h"
+#include "MeshletPass.h"
+#include "PipelineLibrary.h"
+#include "PipelineStateCache.h"
+#include "RenderCapture.h"
+#include "RootSignatureCache.h"
+#include "ShaderCache.h"
+#include "ShaderReflection.h"
+#include "UploadBatcher.h"
 
 const uint8_t g_NumFrames = 3;
 uint32_t g_ClientWidth = 1280;
@@ -24,6 +53,7 @@ HWND g_hWnd;
 RECT g_WindowRect;
 
 // DirectX 12 Objects
+ComPtr<IDXGIAdapter4> g_Adapter;
 ComPtr<ID3D12Device2> g_Device;
 ComPtr<ID3D12CommandQueue> g_CommandQueue;
 ComPtr<IDXGISwapChain4> g_SwapChain;
@@ -40,6 +70,80 @@ uint64_t g_FenceValue = 0;
 uint64_t g_FrameFenceValues[g_NumFrames] = {};
 HANDLE g_FenceEvent;
 
+// Engine Systems
+std::unique_ptr<JobSystem> g_JobSystem;
+std::unique_ptr<PipelineLibrary> g_PipelineLibrary;
+std::unique_ptr<PipelineStateCache> g_PipelineStateCache;
+std::unique_ptr<RootSignatureCache> g_RootSignatureCache;
+std::unique_ptr<ShaderCache> g_ShaderCache;
+std::unique_ptr<ConstantBufferManager> g_ConstantBufferManager;
+std::unique_ptr<HotReloader> g_HotReloader;
+std::unique_ptr<D3D12RenderInterface> g_RenderDevice;
+std::unique_ptr<RenderCapture> g_RenderCapture;   // wraps g_RenderDevice; record through this
+std::unique_ptr<UploadBatcher> g_UploadBatcher;
+const wchar_t* g_PipelineLibraryPath = L"PipelineLibrary.bin";
+const wchar_t* g_ShaderCacheDir = L"ShaderCache";
+const wchar_t* g_ShaderSourceDir = L"shaders";
+const wchar_t* g_BackgroundShaderPath = L"shaders/Background.hlsl";
+const wchar_t* g_CapturePath = L"capture.rcap";
+const wchar_t* g_SceneMeshPath = L"scene.mesh";
+const uint32_t g_CaptureFrames = 60;
+// Render interface ids of the back buffers, one per frame, and the depth
+// buffer.
+const uint32_t g_BackBufferIds = 1;
+const uint32_t g_DepthBufferId = g_BackBufferIds + g_NumFrames;
+const uint32_t g_BackgroundRootSignatureId = g_DepthBufferId + 1;
+const uint32_t g_BackgroundPipelineId = g_DepthBufferId + 2;
+std::chrono::high_resolution_clock::time_point g_StartupTime;
+
+// Background pass; the hot reloader rebuilds it when its shaders change. A
+// version holds serialized objects that Render creates through the render
+// interface, which releases the ones they replace once the GPU is done with
+// them.
+struct BackgroundPipeline
+{
+    std::vector<uint8_t> rootSignature;
+    std::vector<uint8_t> pipeline;          // D3D12RenderInterface::SerializePipeline
+    UINT constantsIndex;                    // root parameter of BackgroundConstants
+};
+Reloadable<BackgroundPipeline>* g_BackgroundPipeline = nullptr;
+uint32_t g_BackgroundVersion = 0;           // the version created under the ids above
+
+// The mesh the scene passes draw; empty if it could not be loaded. Its
+// vertices start with a float3 position.
+GpuMesh g_SceneMesh;
+
+// Instanced scene: a grid of scene mesh instances below the origin, culled on
+// the GPU and drawn with ExecuteIndirect (shaders/Scene.hlsl). The root
+// signature is generated from the shaders; the instance spheres never change.
+const uint32_t g_SceneGridSize = 16;
+std::unique_ptr<IndirectDrawPass> g_IndirectDrawPass;
+std::vector<IndirectInstance> g_SceneInstances;
+ComPtr<ID3D12Resource> g_InstanceSpheres;
+ID3D12RootSignature* g_SceneRootSignature = nullptr;  // owned by g_RootSignatureCache
+PipelineStateHandle g_ScenePipeline;
+UINT g_SceneConstantsIndex = 0;
+UINT g_InstanceSpheresIndex = 0;
+
+// The scene mesh at the origin, drawn by mesh shaders on devices that have
+// them; null otherwise.
+std::unique_ptr<MeshletPass> g_MeshletPass;
+
+// Benchmark mode, null for interactive runs
+std::unique_ptr<Benchmark> g_Benchmark;
+std::unique_ptr<GpuFrameTimer> g_GpuFrameTimer;
+std::chrono::high_resolution_clock::time_point g_BenchmarkFrameTime;
+// The view passes render from: the scripted camera path in benchmark mode,
+// its start otherwise. Updated every frame; matrices are row-major in
+// DirectXMath convention.
+DirectX::XMFLOAT4X4 g_ViewMatrix;
+DirectX::XMFLOAT4X4 g_ViewProjection;
+Frustum g_ViewFrustum;
+float g_CameraPosition[3];
+const float g_VerticalFov = DirectX::XM_PIDIV4;
+const float g_NearPlane = 0.1f;
+const float g_FarPlane = 200.0f;
+
 bool g_VSync = true;
 bool g_TearingSupported = false;
 bool g_Fullscreen = false;
@@ -310,6 +414,356 @@ void Flush(ComPtr<ID3D12CommandQueue> commandQueue, ComPtr<ID3D12Fence> fence, u
     WaitForFenceValue(fence, fenceValueForSignal, fenceEvent);
 }
 
+// Runs on the job system: compiles both shaders through the shader cache,
+// which also lists the files they include, generates the root signature from
+// their bindings and serializes it and the pipeline.
+std::shared_ptr<BackgroundPipeline> BuildBackgroundPipeline(ReloadContext& context)
+{
+    const char* entryPoints[2] = { "VSMain", "PSMain" };
+    const char* targets[2] = { "vs_5_1", "ps_5_1" };
+    std::vector<uint8_t> bytecode[2];
+    uint64_t keys[2] = {};
+    for (int i = 0; i < 2; ++i)
+    {
+        ShaderDesc shaderDesc;
+        shaderDesc.path = g_BackgroundShaderPath;
+        shaderDesc.entryPoint = entryPoints[i];
+        shaderDesc.target = targets[i];
+        std::vector<std::filesystem::path> dependencies;
+        std::string errors;
+        bool compiled = g_ShaderCache->Compile(shaderDesc, bytecode[i], errors, &dependencies, &keys[i]);
+        context.dependencies.insert(context.dependencies.end(), dependencies.begin(), dependencies.end());
+        if (!compiled)
+        {
+            context.errors = errors;
+            return nullptr;
+        }
+    }
+
+    ShaderBindingLayout layout;
+    const ShaderBindingLocation* constants = nullptr;
+    if (!GetShaderBindingLayout(g_ShaderCache->GetCacheDir(),
+        { { &bytecode[0], keys[0], ShaderStageVertex }, { &bytecode[1], keys[1], ShaderStagePixel } }, layout) ||
+        !(constants = layout.Find("BackgroundConstants")))
+    {
+        context.errors = "Cannot reflect the background shaders\n";
+        return nullptr;
+    }
+
+    auto pipeline = std::make_shared<BackgroundPipeline>();
+    pipeline->constantsIndex = constants->rootIndex;
+    if (!SerializeRootSignature(layout, g_RootSignatureCache->GetHighestVersion(), pipeline->rootSignature))
+    {
+        context.errors = "Cannot serialize the background root signature\n";
+        return nullptr;
+    }
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC pipelineDesc = {};
+    pipelineDesc.VS = CD3DX12_SHADER_BYTECODE(bytecode[0].data(), bytecode[0].size());
+    pipelineDesc.PS = CD3DX12_SHADER_BYTECODE(bytecode[1].data(), bytecode[1].size());
+    pipelineDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+    pipelineDesc.SampleMask = UINT_MAX;
+    pipelineDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+    CD3DX12_DEPTH_STENCIL_DESC depthStencilDesc(D3D12_DEFAULT);
+    depthStencilDesc.DepthEnable = FALSE;
+    pipelineDesc.DepthStencilState = depthStencilDesc;
+    pipelineDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    pipelineDesc.NumRenderTargets = 1;
+    pipelineDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+    pipelineDesc.SampleDesc = DefaultSampleDesc();
+    pipeline->pipeline = D3D12RenderInterface::SerializePipeline(pipelineDesc);
+    return pipeline;
+}
+
+// Writes a unit sphere with its meshlets, for runs without a cooked scene
+// mesh. Vertices are bare positions; triangles are clockwise seen from
+// outside.
+bool WriteDefaultSceneMesh(const std::filesystem::path& path)
+{
+    const uint32_t rings = 24;
+    const uint32_t segments = 48;
+    std::vector<float> positions;
+    for (uint32_t ring = 0; ring <= rings; ++ring)
+    {
+        float theta = DirectX::XM_PI * ring / rings;
+        for (uint32_t segment = 0; segment <= segments; ++segment)
+        {
+            float phi = DirectX::XM_2PI * segment / segments;
+            positions.push_back(std::sin(theta) * std::cos(phi));
+            positions.push_back(std::cos(theta));
+            positions.push_back(std::sin(theta) * std::sin(phi));
+        }
+    }
+
+    // The triangles that would collapse at the poles are left out.
+    std::vector<uint32_t> indices;
+    for (uint32_t ring = 0; ring < rings; ++ring)
+    {
+        for (uint32_t segment = 0; segment < segments; ++segment)
+        {
+            uint32_t a = ring * (segments + 1) + segment;
+            uint32_t b = a + segments + 1;
+            if (ring != 0)
+            {
+                indices.insert(indices.end(), { a, a + 1, b });
+            }
+            if (ring != rings - 1)
+            {
+                indices.insert(indices.end(), { a + 1, b + 1, b });
+            }
+        }
+    }
+
+    uint32_t vertexCount = static_cast<uint32_t>(positions.size() / 3);
+    uint32_t indexCount = static_cast<uint32_t>(indices.size());
+    MeshletData meshlets;
+    BuildMeshlets(positions.data(), 12, vertexCount, indices.data(), indexCount, meshlets);
+
+    MeshFileData data;
+    data.vertices = positions.data();
+    data.vertexStride = 12;
+    data.vertexCount = vertexCount;
+    data.indices = indices.data();
+    data.indexCount = indexCount;
+    data.bounds.push_back({ { 0.0f, 0.0f, 0.0f, 1.0f }, { -1.0f, -1.0f, -1.0f }, 0, { 1.0f, 1.0f, 1.0f }, indexCount });
+    SetMeshFileMeshlets(data, meshlets);
+    return WriteMeshFile(path, data);
+}
+
+// Uploads the scene mesh, writing the default one first if there is none.
+// The direct queue waits for the copies on the GPU.
+bool LoadSceneMesh()
+{
+    std::string error;
+    if (!std::filesystem::exists(g_SceneMeshPath) && !WriteDefaultSceneMesh(g_SceneMeshPath))
+    {
+        error = "cannot write the default mesh";
+    }
+
+    MeshFile file;
+    if (error.empty() && file.Open(g_SceneMeshPath, &error) && !UploadMeshFile(*g_UploadBatcher, file, g_SceneMesh))
+    {
+        error = "upload failed";
+    }
+    if (!error.empty())
+    {
+        OutputDebugStringA(("Scene mesh: " + error + "\n").c_str());
+        g_SceneMesh = {};
+        return false;
+    }
+
+    g_UploadBatcher->WaitOnQueue(g_CommandQueue.Get(), g_SceneMesh.uploadFenceValue);
+    return true;
+}
+
+// Builds the instanced scene pass. The indirect draws change the instance
+// index of the scene root signature; the app issues no indirect dispatches,
+// so Dispatch and DispatchMesh stay unsupported.
+bool InitScenePass()
+{
+    if (g_SceneMesh.indexCount == 0)
+    {
+        return false;
+    }
+
+    ShaderDesc shaderDescs[2];
+    const char* entryPoints[2] = { "VSMain", "PSMain" };
+    const char* targets[2] = { "vs_5_1", "ps_5_1" };
+    ShaderHandle shaders[2];
+    for (int i = 0; i < 2; ++i)
+    {
+        shaderDescs[i].path = "shaders/Scene.hlsl";
+        shaderDescs[i].entryPoint = entryPoints[i];
+        shaderDescs[i].target = targets[i];
+        shaders[i] = g_ShaderCache->Request(shaderDescs[i]);
+    }
+    const std::vector<uint8_t>* bytecode[2];
+    for (int i = 0; i < 2; ++i)
+    {
+        g_ShaderCache->Wait(shaders[i]);
+        bytecode[i] = g_ShaderCache->GetBytecode(shaders[i]);
+        if (!bytecode[i])
+        {
+            OutputDebugStringA(g_ShaderCache->GetErrors(shaders[i]).c_str());
+            return false;
+        }
+    }
+
+    // The instance spheres are bound by address.
+    ShaderLayoutPolicy policy;
+    policy.rootDescriptors = true;
+    ShaderBindingLayout layout;
+    const ShaderBindingLocation* instanceConstants = nullptr;
+    const ShaderBindingLocation* sceneConstants = nullptr;
+    const ShaderBindingLocation* instanceSpheres = nullptr;
+    if (!GetShaderBindingLayout(*g_ShaderCache, { { shaders[0], ShaderStageVertex }, { shaders[1], ShaderStagePixel } }, layout, policy) ||
+        !(instanceConstants = layout.Find("InstanceConstants")) || !(sceneConstants = layout.Find("SceneConstants")) ||
+        !(instanceSpheres = layout.Find("g_InstanceSpheres")))
+    {
+        OutputDebugStringA("Cannot reflect shaders/Scene.hlsl\n");
+        return false;
+    }
+    g_SceneConstantsIndex = sceneConstants->rootIndex;
+    g_InstanceSpheresIndex = instanceSpheres->rootIndex;
+    g_SceneRootSignature = CreateRootSignature(*g_RootSignatureCache, layout);
+    if (!g_SceneRootSignature)
+    {
+        return false;
+    }
+
+    D3D12_INPUT_ELEMENT_DESC inputElements[] = {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    };
+    struct ScenePipelineStream
+    {
+        CD3DX12_PIPELINE_STATE_STREAM_ROOT_SIGNATURE rootSignature;
+        CD3DX12_PIPELINE_STATE_STREAM_INPUT_LAYOUT inputLayout;
+        CD3DX12_PIPELINE_STATE_STREAM_PRIMITIVE_TOPOLOGY primitiveTopology;
+        CD3DX12_PIPELINE_STATE_STREAM_VS vs;
+        CD3DX12_PIPELINE_STATE_STREAM_PS ps;
+        CD3DX12_PIPELINE_STATE_STREAM_DEPTH_STENCIL_FORMAT depthStencilFormat;
+        CD3DX12_PIPELINE_STATE_STREAM_RENDER_TARGET_FORMATS renderTargetFormats;
+    } stream;
+    stream.rootSignature = g_SceneRootSignature;
+    stream.inputLayout = { inputElements, _countof(inputElements) };
+    stream.primitiveTopology = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    stream.vs = CD3DX12_SHADER_BYTECODE(bytecode[0]->data(), bytecode[0]->size());
+    stream.ps = CD3DX12_SHADER_BYTECODE(bytecode[1]->data(), bytecode[1]->size());
+    stream.depthStencilFormat = DXGI_FORMAT_D32_FLOAT;
+    D3D12_RT_FORMAT_ARRAY renderTargetFormats = {};
+    renderTargetFormats.NumRenderTargets = 1;
+    renderTargetFormats.RTFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+    stream.renderTargetFormats = renderTargetFormats;
+    g_ScenePipeline = g_PipelineStateCache->Request(stream);
+
+    std::vector<float> sphereData;
+    for (uint32_t z = 0; z < g_SceneGridSize; ++z)
+    {
+        for (uint32_t x = 0; x < g_SceneGridSize; ++x)
+        {
+            IndirectInstance instance = {};
+            instance.sphere[0] = (x - (g_SceneGridSize - 1) * 0.5f) * 1.25f;
+            instance.sphere[1] = -1.5f;
+            instance.sphere[2] = (z - (g_SceneGridSize - 1) * 0.5f) * 1.25f;
+            instance.sphere[3] = 0.4f;
+            instance.indexCount = g_SceneMesh.indexCount;
+            g_SceneInstances.push_back(instance);
+            sphereData.insert(sphereData.end(), instance.sphere, instance.sphere + 4);
+        }
+    }
+    g_InstanceSpheres = g_UploadBatcher->CreateBuffer(sphereData.data(), sphereData.size() * sizeof(float));
+    g_UploadBatcher->WaitOnQueue(g_CommandQueue.Get(), g_UploadBatcher->Submit());
+
+    ID3D12RootSignature* rootSignatures[c_IndirectDrawTypeCount] = {};
+    rootSignatures[static_cast<uint32_t>(IndirectDrawType::Draw)] = g_SceneRootSignature;
+    rootSignatures[static_cast<uint32_t>(IndirectDrawType::DrawIndexed)] = g_SceneRootSignature;
+    g_IndirectDrawPass = std::make_unique<IndirectDrawPass>();
+    if (!g_IndirectDrawPass->Init(g_Device, *g_ShaderCache, *g_PipelineStateCache, *g_RootSignatureCache, rootSignatures,
+        instanceConstants->rootIndex, static_cast<uint32_t>(g_SceneInstances.size()), g_NumFrames))
+    {
+        g_IndirectDrawPass.reset();
+        return false;
+    }
+    return true;
+}
+
+// Reports how long it took until the first frame was rendered with every
+// pipeline requested during startup ready, and how many came from the on-disk
+// library. Called after each frame; the background pipeline builds
+// asynchronously, so the report waits for its first version too.
+void ReportPipelineStartup()
+{
+    static bool reported = false;
+    if (reported || g_BackgroundPipeline->GetVersion() == 0 || g_PipelineStateCache->GetPendingCount() != 0)
+    {
+        return;
+    }
+    reported = true;
+
+    auto startupMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - g_StartupTime).count();
+    auto stats = g_PipelineLibrary->GetStats();
+    uint64_t lookups = stats.hits + stats.misses;
+    double hitRate = lookups ? 100.0 * stats.hits / lookups : 0.0;
+
+    wchar_t text_buffer[256];
+    swprintf(text_buffer, _countof(text_buffer), L"PSO startup (%s): %.2f ms, library open %.2f ms, hit rate %.1f%% (%llu/%llu)\n",
+        stats.warmStart ? L"warm" : L"cold", startupMs, stats.openMilliseconds, hitRate, stats.hits, lookups);
+    OutputDebugString(text_buffer);
+}
+
+// Process-wide peaks: the local video memory of this process and its working
+// set and private bytes.
+void SampleBenchmarkMemory()
+{
+    Benchmark::MemorySample sample;
+    DXGI_QUERY_VIDEO_MEMORY_INFO videoMemory = {};
+    if (SUCCEEDED(g_Adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &videoMemory)))
+    {
+        sample.videoMemory = videoMemory.CurrentUsage;
+        sample.videoBudget = videoMemory.Budget;
+    }
+
+    PROCESS_MEMORY_COUNTERS_EX counters = {};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters), sizeof(counters)))
+    {
+        sample.workingSet = counters.PeakWorkingSetSize;
+        sample.privateBytes = counters.PrivateUsage;
+    }
+    g_Benchmark->SampleMemory(sample);
+}
+
+void ReadGpuFrameTime(uint32_t slot)
+{
+    uint32_t frame = 0;
+    double milliseconds = 0.0;
+    if (g_GpuFrameTimer->Read(slot, &frame, &milliseconds))
+    {
+        g_Benchmark->AddGpuTime(frame, milliseconds);
+    }
+}
+
+// Called after every presented frame; false once the run is complete.
+bool UpdateBenchmark()
+{
+    auto now = std::chrono::high_resolution_clock::now();
+    g_Benchmark->EndFrame(std::chrono::duration<double, std::milli>(now - g_BenchmarkFrameTime).count());
+    g_BenchmarkFrameTime = now;
+    SampleBenchmarkMemory();
+    return !g_Benchmark->IsDone();
+}
+
+// Collects the outstanding GPU times and writes the report.
+bool FinishBenchmark()
+{
+    if (!g_Benchmark->IsDone())
+    {
+        OutputDebugStringA("Benchmark interrupted, no report written\n");
+        return false;
+    }
+
+    Flush(g_CommandQueue, g_Fence, g_FenceValue, g_FenceEvent);
+    for (uint32_t i = 0; i < g_NumFrames; ++i)
+    {
+        ReadGpuFrameTime(i);
+    }
+    SampleBenchmarkMemory();
+
+    DXGI_ADAPTER_DESC1 adapterDesc = {};
+    g_Adapter->GetDesc1(&adapterDesc);
+    char adapterName[256] = {};
+    WideCharToMultiByte(CP_UTF8, 0, adapterDesc.Description, -1, adapterName, sizeof(adapterName), nullptr, nullptr);
+    g_Benchmark->SetInfo("adapter", adapterName);
+    g_Benchmark->SetInfo("tearing", g_TearingSupported ? "supported" : "unsupported");
+
+    std::string error;
+    if (!g_Benchmark->WriteReport(&error))
+    {
+        OutputDebugStringA(("Benchmark: " + error + "\n").c_str());
+        return false;
+    }
+    return true;
+}
+
 void Update()
 {
     static uint64_t frameCounter = 0;
@@ -317,6 +771,27 @@ void Update()
     static std::chrono::high_resolution_clock clock;
     static auto t0 = clock.now();
 
+    {
+        uint32_t frame = 0;
+        uint32_t frameCount = 1;
+        if (g_Benchmark && !g_Benchmark->IsWarmingUp())
+        {
+            frame = g_Benchmark->GetFrame() - g_Benchmark->GetOptions().warmup;
+            frameCount = g_Benchmark->GetOptions().frames;
+        }
+        CameraPose pose = GetBenchmarkCamera(frame, frameCount);
+        DirectX::XMMATRIX view = DirectX::XMMatrixLookAtLH(
+            DirectX::XMVectorSet(pose.position[0], pose.position[1], pose.position[2], 1.0f),
+            DirectX::XMVectorSet(pose.target[0], pose.target[1], pose.target[2], 1.0f),
+            DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        DirectX::XMMATRIX projection = DirectX::XMMatrixPerspectiveFovLH(g_VerticalFov,
+            static_cast<float>(g_ClientWidth) / g_ClientHeight, g_NearPlane, g_FarPlane);
+        DirectX::XMStoreFloat4x4(&g_ViewMatrix, view);
+        DirectX::XMStoreFloat4x4(&g_ViewProjection, DirectX::XMMatrixMultiply(view, projection));
+        g_ViewFrustum = Frustum::FromViewProjection(g_ViewProjection.m);
+        std::copy(pose.position, pose.position + 3, g_CameraPosition);
+    }
+
     frameCounter++;
     auto t1 = clock.now();
     auto deltaTime = t1 - t0;
@@ -338,34 +813,102 @@ void Update()
 void Render()
 {
     auto commandAllocator = g_CommandAllocators[g_CurrentBackBufferIndex];
-    auto backBuffer = g_BackBuffers[g_CurrentBackBufferIndex];
 
     commandAllocator->Reset();
     g_CommandList->Reset(commandAllocator.Get(), nullptr);
-
-    // Clear the render target.
+    if (g_GpuFrameTimer)
     {
-        CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
-            backBuffer.Get(),
-            D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET
-        );
+        g_GpuFrameTimer->Begin(g_CommandList.Get(), g_CurrentBackBufferIndex, g_Benchmark->GetFrame());
+    }
+    g_ConstantBufferManager->BeginFrame(g_FenceValue + 1, g_Fence->GetCompletedValue());
+    g_HotReloader->BeginFrame(g_FenceValue + 1, g_Fence->GetCompletedValue());
+    g_RenderDevice->SetFrame(g_CommandList.Get(), g_FenceValue + 1, g_Fence->GetCompletedValue());
+
+    RenderInterface& render = *g_RenderCapture;
+    bool capturing = g_RenderCapture->IsCapturing();
+    uint32_t backBufferId = g_BackBufferIds + g_CurrentBackBufferIndex;
+    render.BeginFrame();
 
-        g_CommandList->ResourceBarrier(1, &barrier);
+    // Clear the render target and the depth buffer.
+    {
+        render.Barrier(backBufferId, c_RenderStatePresent, c_RenderStateRenderTarget);
+        render.Barrier(g_DepthBufferId, c_RenderStateCommon, c_RenderStateDepthWrite);
 
         FLOAT clearColor[] = { 0.2f, 0.8f, 0.8f, 1.0f };
-        CD3DX12_CPU_DESCRIPTOR_HANDLE rtv(g_RTVDescriptorHeap->GetCPUDescriptorHandleForHeapStart(),
-            g_CurrentBackBufferIndex, g_RTVDescriptorSize);
+        render.ClearRenderTarget(backBufferId, clearColor);
+        render.ClearDepthStencil(g_DepthBufferId, 1.0f, 0);
+    }
+
+    // Background, with whichever version of its pipeline is installed.
+    if (const BackgroundPipeline* background = g_BackgroundPipeline->Get())
+    {
+        if (g_BackgroundVersion != g_BackgroundPipeline->GetVersion())
+        {
+            render.CreateRootSignature(g_BackgroundRootSignatureId, background->rootSignature.data(), background->rootSignature.size());
+            render.CreatePipeline(g_BackgroundPipelineId, g_BackgroundRootSignatureId, background->pipeline.data(),
+                background->pipeline.size());
+            g_BackgroundVersion = g_BackgroundPipeline->GetVersion();
+        }
+        RecordBackgroundPass(render, g_BackgroundPipelineId, backBufferId, g_ClientWidth, g_ClientHeight, background->constantsIndex,
+            GetBackgroundConstants(g_ViewMatrix.m, g_VerticalFov, g_ClientWidth, g_ClientHeight));
+    }
+
+    // The scene passes draw with depth.
+    render.SetRenderTargets(1, &backBufferId, g_DepthBufferId);
+    render.SetViewport(0.0f, 0.0f, static_cast<float>(g_ClientWidth), static_cast<float>(g_ClientHeight), 0.0f, 1.0f);
+
+    // Instanced scene: culled on the GPU, then one ExecuteIndirect draws the
+    // visible instances.
+    ID3D12PipelineState* scenePipeline = g_IndirectDrawPass ? g_PipelineStateCache->Get(g_ScenePipeline) : nullptr;
+    if (scenePipeline)
+    {
+        g_IndirectDrawPass->UpdateInstances(g_CommandList.Get(), g_CurrentBackBufferIndex, g_SceneInstances.data(),
+            static_cast<uint32_t>(g_SceneInstances.size()));
+        g_IndirectDrawPass->Cull(g_CommandList.Get(), g_ViewFrustum.planes);
+
+        g_CommandList->SetPipelineState(scenePipeline);
+        g_CommandList->SetGraphicsRootSignature(g_SceneRootSignature);
+        g_CommandList->SetGraphicsRoot32BitConstants(g_SceneConstantsIndex, 16, g_ViewProjection.m, 0);
+        g_CommandList->SetGraphicsRootShaderResourceView(g_InstanceSpheresIndex, g_InstanceSpheres->GetGPUVirtualAddress());
+        g_CommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+        g_CommandList->IASetVertexBuffers(0, 1, &g_SceneMesh.vertexBufferView);
+        g_CommandList->IASetIndexBuffer(&g_SceneMesh.indexBufferView);
+        g_IndirectDrawPass->Execute(g_CommandList.Get(), IndirectDrawType::DrawIndexed);
+    }
 
-        g_CommandList->ClearRenderTargetView(rtv, clearColor, 0, nullptr);
+    // Scene mesh, culled per meshlet by the amplification shader.
+    if (g_MeshletPass && g_MeshletPass->IsReady())
+    {
+        uint64_t offset = g_ConstantBufferManager->AllocateTransient(sizeof(MeshletViewConstants));
+        MeshletViewConstants view = {};
+        memcpy(view.viewProjection, g_ViewProjection.m, sizeof(view.viewProjection));
+        memcpy(view.planes, g_ViewFrustum.planes, sizeof(view.planes));
+        memcpy(view.cameraPosition, g_CameraPosition, sizeof(view.cameraPosition));
+        memcpy(g_ConstantBufferManager->GetCpuAddress(offset), &view, sizeof(view));
+
+        ComPtr<ID3D12GraphicsCommandList6> commandList6;
+        if (SUCCEEDED(g_CommandList.As(&commandList6)))
+        {
+            g_MeshletPass->Draw(commandList6.Get(), g_SceneMesh, g_SceneMesh.vertexBufferView.StrideInBytes,
+                g_ConstantBufferManager->GetGpuAddress(offset));
+        }
     }
 
     // Present
     {
-        CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(
-            backBuffer.Get(),
-            D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
-        
-        g_CommandList->ResourceBarrier(1, &barrier);
+        render.Barrier(g_DepthBufferId, c_RenderStateDepthWrite, c_RenderStateCommon);
+        render.Barrier(backBufferId, c_RenderStateRenderTarget, c_RenderStatePresent);
+        render.EndFrame();
+        if (capturing && !g_RenderCapture->IsCapturing())
+        {
+            std::string text = g_RenderCapture->GetLastError().empty() ? "Capture written\n" : "Capture failed: " + g_RenderCapture->GetLastError() + "\n";
+            OutputDebugStringA(text.c_str());
+        }
+
+        if (g_GpuFrameTimer)
+        {
+            g_GpuFrameTimer->End(g_CommandList.Get(), g_CurrentBackBufferIndex);
+        }
         g_CommandList->Close();
 
         ID3D12CommandList* const commandLists[] = {
@@ -380,6 +923,10 @@ void Render()
         g_FrameFenceValues[g_CurrentBackBufferIndex] = Signal(g_CommandQueue, g_Fence, g_FenceValue);
         g_CurrentBackBufferIndex = g_SwapChain->GetCurrentBackBufferIndex();
         WaitForFenceValue(g_Fence, g_FrameFenceValues[g_CurrentBackBufferIndex], g_FenceEvent);
+        if (g_GpuFrameTimer)
+        {
+            ReadGpuFrameTime(g_CurrentBackBufferIndex);
+        }
     }
 }
 
@@ -392,6 +939,30 @@ int CALLBACK WinMain(
     const wchar_t* windowClassName = L"DX12WindowClass";
     const wchar_t* windowTitle = L"Learning DirectX 12";
 
+    // parse command line
+    {
+        BenchmarkOptions options;
+        std::string error;
+        if (!ParseBenchmarkOptions(lpCmdLine, options, &error))
+        {
+            OutputDebugStringA(("Command line: " + error + "\n").c_str());
+            return 1;
+        }
+        if (options.enabled)
+        {
+            g_UseWarp = options.backend == "warp";
+            g_VSync = options.vsync;
+            if (options.width)
+            {
+                g_ClientWidth = options.width;
+                g_ClientHeight = options.height;
+            }
+            options.width = g_ClientWidth;
+            options.height = g_ClientHeight;
+            g_Benchmark = std::make_unique<Benchmark>(options);
+        }
+    }
+
     // create window
     {
         RegisterWindowClass(hInstance, windowClassName);
@@ -401,8 +972,10 @@ int CALLBACK WinMain(
     
     // init graphic
     {
+        g_StartupTime = std::chrono::high_resolution_clock::now();
         g_TearingSupported = CheckTearingSupport();
         ComPtr<IDXGIAdapter4> dxgiAdapter4 = GetAdapter(g_UseWarp);
+        g_Adapter = dxgiAdapter4;
 
         g_Device = CreateDevice(dxgiAdapter4);
         g_CommandQueue = CreateCommandQueue(g_Device, D3D12_COMMAND_LIST_TYPE_DIRECT);
@@ -420,12 +993,59 @@ int CALLBACK WinMain(
         g_CommandList = CreateCommandList(g_Device, g_CommandAllocators[g_CurrentBackBufferIndex], D3D12_COMMAND_LIST_TYPE_DIRECT);
         g_Fence = CreateFence(g_Device);
         g_FenceEvent = CreateEventHandle();
+
+        g_JobSystem = std::make_unique<JobSystem>();
+        g_PipelineLibrary = std::make_unique<PipelineLibrary>();
+        g_PipelineLibrary->Open(g_Device, dxgiAdapter4, g_PipelineLibraryPath);
+        g_PipelineStateCache = std::make_unique<PipelineStateCache>(g_Device, *g_JobSystem, g_PipelineLibrary.get());
+        g_RootSignatureCache = std::make_unique<RootSignatureCache>(g_Device);
+        g_ShaderCache = std::make_unique<ShaderCache>(CreateShaderCompiler(), *g_JobSystem, g_ShaderCacheDir);
+        // One spare version so a buffer may change every frame without waiting.
+        g_ConstantBufferManager = std::make_unique<ConstantBufferManager>(g_Device, g_NumFrames + 1);
+        g_HotReloader = std::make_unique<HotReloader>(*g_JobSystem);
+        g_HotReloader->Watch(g_ShaderSourceDir);
+        g_HotReloader->SetCallback([](const ReloadableObject& object, bool succeeded)
+        {
+            std::string text = (succeeded ? "Reloaded " : "Reload failed: ") + object.GetName() + "\n" + object.GetErrors();
+            OutputDebugStringA(text.c_str());
+        });
+        g_BackgroundPipeline = g_HotReloader->Add<BackgroundPipeline>("background", BuildBackgroundPipeline);
+
+        g_UploadBatcher = std::make_unique<UploadBatcher>(g_Device);
+        if (LoadSceneMesh())
+        {
+            InitScenePass();
+            if (g_SceneMesh.meshletCount && MeshletPass::IsSupported(g_Device.Get()))
+            {
+                g_MeshletPass = std::make_unique<MeshletPass>();
+                if (!g_MeshletPass->Init(*g_ShaderCache, *g_PipelineStateCache, *g_RootSignatureCache,
+                    DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_D32_FLOAT))
+                {
+                    g_MeshletPass.reset();
+                }
+            }
+        }
+
+        g_RenderDevice = std::make_unique<D3D12RenderInterface>(g_Device);
+        g_RenderCapture = std::make_unique<RenderCapture>(*g_RenderDevice);
+        for (int i = 0; i < g_NumFrames; ++i)
+        {
+            RenderTextureDesc desc = { g_ClientWidth, g_ClientHeight, 1, 1, DXGI_FORMAT_R8G8B8A8_UNORM, c_RenderResourceRenderTarget };
+            g_RenderCapture->ImportTexture(g_BackBufferIds + i, desc, g_BackBuffers[i].Get());
+        }
+        RenderTextureDesc depthDesc = { g_ClientWidth, g_ClientHeight, 1, 1, DXGI_FORMAT_D32_FLOAT, c_RenderResourceDepthStencil };
+        g_RenderCapture->CreateTexture(g_DepthBufferId, depthDesc);
+        if (g_Benchmark)
+        {
+            g_GpuFrameTimer = std::make_unique<GpuFrameTimer>(g_Device, g_CommandQueue.Get(), g_NumFrames);
+        }
         g_IsInitialized = true;
     }
 
     // handle window message
     MSG msg = {};
     bool quit = false;
+    g_BenchmarkFrameTime = std::chrono::high_resolution_clock::now();
     while (true)
     {
         while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
@@ -446,13 +1066,42 @@ int CALLBACK WinMain(
 
         Update();
         Render();
+        ReportPipelineStartup();
+        if (g_Benchmark && !UpdateBenchmark())
+        {
+            break;
+        }
+    }
+
+    int exitCode = 0;
+    if (g_Benchmark && !FinishBenchmark())
+    {
+        exitCode = 1;
     }
 
     // check finish and release resource before closing
     Flush(g_CommandQueue, g_Fence, g_FenceValue, g_FenceEvent);
     CloseHandle(g_FenceEvent);
 
-	return 0;
+    g_GpuFrameTimer.reset();
+    g_RenderCapture.reset();
+    g_RenderDevice.reset();
+    g_MeshletPass.reset();
+    g_IndirectDrawPass.reset();
+    g_InstanceSpheres.Reset();
+    g_SceneMesh = {};
+    g_UploadBatcher.reset();
+    g_BackgroundPipeline = nullptr;
+    g_HotReloader.reset();
+    g_ConstantBufferManager.reset();
+    g_ShaderCache.reset();
+    g_PipelineStateCache.reset();
+    g_RootSignatureCache.reset();
+    g_PipelineLibrary->Save();
+    g_PipelineLibrary.reset();
+    g_JobSystem.reset();
+
+	return exitCode;
 }
 
 LRESULT CALLBACK WindowProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
@@ -470,6 +1119,10 @@ LRESULT CALLBACK WindowProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             {
                 g_VSync = !g_VSync;
             }
+            else if (c == 'C' && g_RenderCapture)
+            {
+                g_RenderCapture->Start(g_CapturePath, g_CaptureFrames);
+            }
         }
         break;
     }
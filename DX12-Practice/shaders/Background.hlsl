@@ -0,0 +1,34 @@
+// Sky gradient seen from the frame's camera, drawn as one fullscreen
+// triangle that covers the viewport before anything else. Reloaded when this
+// file is saved.
+
+cbuffer BackgroundConstants : register(b0)
+{
+    float3 g_CameraRight;       // scaled by tan(horizontal fov / 2)
+    float g_InverseViewportWidth;
+    float3 g_CameraUp;          // scaled by tan(vertical fov / 2)
+    float g_InverseViewportHeight;
+    float3 g_CameraForward;
+};
+
+struct VertexOutput
+{
+    float4 position : SV_Position;
+};
+
+VertexOutput VSMain(uint vertexId : SV_VertexID)
+{
+    // uv (0, 0), (2, 0), (0, 2): the part with uv below 1 is the viewport.
+    float2 uv = float2((vertexId << 1) & 2, vertexId & 2);
+    VertexOutput output;
+    output.position = float4(uv * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
+    return output;
+}
+
+float4 PSMain(VertexOutput input) : SV_Target
+{
+    float2 ndc = input.position.xy * float2(g_InverseViewportWidth, g_InverseViewportHeight) * float2(2.0, -2.0) + float2(-1.0, 1.0);
+    float3 direction = normalize(g_CameraForward + ndc.x * g_CameraRight + ndc.y * g_CameraUp);
+    float t = direction.y * 0.5 + 0.5;
+    return float4(lerp(float3(0.05, 0.25, 0.35), float3(0.2, 0.8, 0.8), t), 1.0);
+}
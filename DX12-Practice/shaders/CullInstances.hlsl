@@ -0,0 +1,88 @@
+// Frustum-culls instances and appends one indirect command per visible
+// instance to the region of its draw type. Layout must match
+// IndirectDrawPass and IndirectDrawCommand.
+
+struct Instance
+{
+    float4 sphere;          // world-space center, radius
+    uint indexCount;        // vertex count for draws, thread groups (x) for dispatches
+    uint startIndex;
+    int baseVertex;
+    uint drawType;          // IndirectDrawType
+};
+
+static const uint c_Draw = 0;
+static const uint c_DrawIndexed = 1;
+
+// Arguments of every draw type packed into 5 values; the command signature
+// of the type reads only the ones it needs.
+struct DrawCommand
+{
+    uint instanceIndex;     // root constant read by the shaders
+    uint arguments[5];
+};
+
+cbuffer CullConstants : register(b0)
+{
+    float4 g_Planes[6];     // normals point inwards
+    uint g_InstanceCount;
+    uint g_MaxInstances;    // commands per draw type region
+};
+
+StructuredBuffer<Instance> g_Instances : register(t0);
+RWStructuredBuffer<DrawCommand> g_Commands : register(u0);
+RWByteAddressBuffer g_CommandCount : register(u1);
+
+[numthreads(64, 1, 1)]
+void main(uint3 id : SV_DispatchThreadID)
+{
+    uint index = id.x;
+    if (index >= g_InstanceCount)
+    {
+        return;
+    }
+
+    Instance instance = g_Instances[index];
+    [unroll]
+    for (uint i = 0; i < 6; ++i)
+    {
+        if (dot(g_Planes[i].xyz, instance.sphere.xyz) + g_Planes[i].w < -instance.sphere.w)
+        {
+            return;
+        }
+    }
+
+    uint slot;
+    g_CommandCount.InterlockedAdd(instance.drawType * 4, 1, slot);
+
+    DrawCommand command;
+    command.instanceIndex = index;
+    if (instance.drawType == c_Draw)
+    {
+        // vertexCount, instanceCount, startVertex, startInstance
+        command.arguments[0] = instance.indexCount;
+        command.arguments[1] = 1;
+        command.arguments[2] = instance.startIndex;
+        command.arguments[3] = 0;
+        command.arguments[4] = 0;
+    }
+    else if (instance.drawType == c_DrawIndexed)
+    {
+        // indexCount, instanceCount, startIndex, baseVertex, startInstance
+        command.arguments[0] = instance.indexCount;
+        command.arguments[1] = 1;
+        command.arguments[2] = instance.startIndex;
+        command.arguments[3] = asuint(instance.baseVertex);
+        command.arguments[4] = 0;
+    }
+    else
+    {
+        // Dispatch and DispatchMesh: thread group counts
+        command.arguments[0] = instance.indexCount;
+        command.arguments[1] = 1;
+        command.arguments[2] = 1;
+        command.arguments[3] = 0;
+        command.arguments[4] = 0;
+    }
+    g_Commands[instance.drawType * g_MaxInstances + slot] = command;
+}
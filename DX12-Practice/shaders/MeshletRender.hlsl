@@ -0,0 +1,118 @@
+// Meshlet rendering: the amplification shader culls meshlets (frustum and
+// normal cone) 32 at a time, the mesh shader expands the survivors. Layout
+// must match MeshletPass.
+
+struct Meshlet
+{
+    uint vertexOffset;
+    uint vertexCount;
+    uint primitiveOffset;
+    uint primitiveCount;
+    float4 sphere;
+    float3 coneAxis;
+    float coneCutoff;
+};
+
+cbuffer ViewConstants : register(b0)
+{
+    row_major float4x4 g_ViewProjection;
+    float4 g_Planes[6];
+    float3 g_CameraPosition;
+};
+
+cbuffer DrawConstants : register(b1)
+{
+    uint g_MeshletCount;
+    uint g_VertexStride;
+};
+
+ByteAddressBuffer g_Vertices : register(t0);
+StructuredBuffer<Meshlet> g_Meshlets : register(t1);
+StructuredBuffer<uint> g_MeshletVertices : register(t2);
+StructuredBuffer<uint> g_MeshletPrimitives : register(t3);
+
+struct Payload
+{
+    uint meshletIndices[32];
+};
+
+groupshared Payload s_Payload;
+groupshared uint s_VisibleCount;
+
+bool IsVisible(Meshlet meshlet)
+{
+    [unroll]
+    for (uint i = 0; i < 6; ++i)
+    {
+        if (dot(g_Planes[i].xyz, meshlet.sphere.xyz) + g_Planes[i].w < -meshlet.sphere.w)
+        {
+            return false;
+        }
+    }
+
+    float3 view = meshlet.sphere.xyz - g_CameraPosition;
+    return dot(view, meshlet.coneAxis) < meshlet.coneCutoff * length(view) + meshlet.sphere.w;
+}
+
+// Survivors are compacted with a groupshared counter, not wave intrinsics:
+// on wave16 hardware the 32 threads of a group span two waves.
+[numthreads(32, 1, 1)]
+void ASMain(uint id : SV_DispatchThreadID, uint thread : SV_GroupIndex)
+{
+    if (thread == 0)
+    {
+        s_VisibleCount = 0;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    if (id < g_MeshletCount && IsVisible(g_Meshlets[id]))
+    {
+        uint slot;
+        InterlockedAdd(s_VisibleCount, 1, slot);
+        s_Payload.meshletIndices[slot] = id;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    DispatchMesh(s_VisibleCount, 1, 1, s_Payload);
+}
+
+struct VertexOut
+{
+    float4 position : SV_Position;
+    float3 color : COLOR;
+};
+
+float3 MeshletColor(uint index)
+{
+    uint hash = index * 2654435761u;
+    return float3(hash & 255, (hash >> 8) & 255, (hash >> 16) & 255) / 255.0;
+}
+
+[outputtopology("triangle")]
+[numthreads(128, 1, 1)]
+void MSMain(uint thread : SV_GroupThreadID, uint group : SV_GroupID, in payload Payload payload,
+    out vertices VertexOut vertices[64], out indices uint3 triangles[124])
+{
+    uint meshletIndex = payload.meshletIndices[group];
+    Meshlet meshlet = g_Meshlets[meshletIndex];
+    SetMeshOutputCounts(meshlet.vertexCount, meshlet.primitiveCount);
+
+    if (thread < meshlet.primitiveCount)
+    {
+        uint packed = g_MeshletPrimitives[meshlet.primitiveOffset + thread];
+        triangles[thread] = uint3(packed & 0x3ff, (packed >> 10) & 0x3ff, (packed >> 20) & 0x3ff);
+    }
+
+    if (thread < meshlet.vertexCount)
+    {
+        uint vertex = g_MeshletVertices[meshlet.vertexOffset + thread];
+        float3 position = asfloat(g_Vertices.Load3(vertex * g_VertexStride));
+        vertices[thread].position = mul(float4(position, 1.0), g_ViewProjection);
+        vertices[thread].color = MeshletColor(meshletIndex);
+    }
+}
+
+float4 PSMain(VertexOut input) : SV_Target
+{
+    return float4(input.color, 1.0);
+}
@@ -0,0 +1,38 @@
+// Instanced scene geometry drawn by IndirectDrawPass: every instance is the
+// scene mesh (a unit sphere) placed and scaled by its bounding sphere.
+// Bindings are reflected; the instance index is set by the indirect
+// commands.
+
+cbuffer InstanceConstants : register(b0)
+{
+    uint g_InstanceIndex;
+};
+
+cbuffer SceneConstants : register(b1)
+{
+    row_major float4x4 g_ViewProjection;
+};
+
+StructuredBuffer<float4> g_InstanceSpheres : register(t0);    // center, radius
+
+struct VertexOutput
+{
+    float4 position : SV_Position;
+    float3 normal : NORMAL;
+};
+
+VertexOutput VSMain(float3 position : POSITION)
+{
+    float4 sphere = g_InstanceSpheres[g_InstanceIndex];
+    VertexOutput output;
+    output.position = mul(float4(sphere.xyz + position * sphere.w, 1.0), g_ViewProjection);
+    output.normal = position;
+    return output;
+}
+
+float4 PSMain(VertexOutput input) : SV_Target
+{
+    float3 lightDirection = normalize(float3(0.4, 1.0, -0.3));
+    float diffuse = saturate(dot(normalize(input.normal), lightDirection));
+    return float4(float3(0.8, 0.55, 0.3) * (0.25 + 0.75 * diffuse), 1.0);
+}
@@ -0,0 +1,37 @@
+// Sampling helpers for VirtualTexture. The feedback buffer and min-mip map
+// are bound by the including shader; layout must match VirtualPageTable
+// (feedback texels hold mip << 24 | y << 12 | x).
+
+struct VirtualTextureInfo
+{
+    uint2 pagesInMip0;      // page grid of mip 0
+    uint standardMipCount;  // mips streamed page by page
+    uint feedbackWidth;     // feedback buffer texels per row
+};
+
+// Records the page this pixel wants. Only one pixel per 8x8 block writes,
+// and which one rotates with the frame so every pixel is seen eventually.
+void WriteVirtualFeedback(RWByteAddressBuffer feedback, VirtualTextureInfo info, Texture2D texture, SamplerState samplerState,
+    float2 uv, uint2 pixel, uint frame)
+{
+    uint2 block = pixel >> 3;
+    uint2 rotation = uint2(frame & 7, (frame >> 3) & 7);
+    if (any((pixel & 7) != rotation))
+    {
+        return;
+    }
+
+    float lod = texture.CalculateLevelOfDetailUnclamped(samplerState, uv);
+    uint mip = min(uint(max(lod, 0.0f)), info.standardMipCount - 1);
+    uint2 mipPages = max(info.pagesInMip0 >> mip, uint2(1, 1));
+    uint2 page = min(uint2(frac(uv) * mipPages), mipPages - 1);
+    feedback.Store((block.y * info.feedbackWidth + block.x) * 4, (mip << 24) | (page.y << 12) | page.x);
+}
+
+// Samples with the LOD clamped to the finest resident mip of the page.
+float4 SampleVirtual(Texture2D texture, SamplerState samplerState, Texture2D<uint> minMip, VirtualTextureInfo info, float2 uv)
+{
+    uint2 page = min(uint2(frac(uv) * info.pagesInMip0), info.pagesInMip0 - 1);
+    float clampLod = float(minMip.Load(int3(page, 0)));
+    return texture.Sample(samplerState, uv, int2(0, 0), clampLod);
+}
@@ -0,0 +1,219 @@
+#include "Check.h"
+
+#include "AssetArchive.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace
+{
+    std::vector<uint8_t> ReadFile(const std::filesystem::path& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    void WriteFile(const std::filesystem::path& path, const std::vector<uint8_t>& data)
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    }
+
+    // Writes data to a file and returns Open's error, or "" if it opened.
+    std::string OpenError(const std::filesystem::path& path, const std::vector<uint8_t>& data)
+    {
+        WriteFile(path, data);
+        AssetArchive archive;
+        std::string error;
+        if (archive.Open(path, &error))
+        {
+            return "";
+        }
+        CHECK(!archive.IsOpen() && archive.GetEntryCount() == 0);
+        CHECK(!error.empty());
+        return error;
+    }
+
+    AssetArchiveHeader GetHeader(const std::vector<uint8_t>& file)
+    {
+        AssetArchiveHeader header;
+        memcpy(&header, file.data(), sizeof(header));
+        return header;
+    }
+
+    std::vector<uint8_t> WithHeader(std::vector<uint8_t> file, const AssetArchiveHeader& header)
+    {
+        memcpy(file.data(), &header, sizeof(header));
+        return file;
+    }
+
+    AssetArchiveEntry* GetEntries(std::vector<uint8_t>& file)
+    {
+        return reinterpret_cast<AssetArchiveEntry*>(file.data() + GetHeader(file).tableOffset);
+    }
+
+    std::map<std::string, std::vector<uint8_t>> MakeAssets()
+    {
+        std::mt19937 random(5);
+        std::map<std::string, std::vector<uint8_t>> assets;
+        assets["empty"] = {};
+        assets["tiny"] = { 1, 2, 3 };
+        std::vector<uint8_t>& text = assets["shaders/text.hlsl"];
+        while (text.size() < 30000)
+        {
+            const char* line = "float4 main(float4 position : SV_Position) : SV_Target { return position; }\n";
+            text.insert(text.end(), line, line + strlen(line));
+        }
+        std::vector<uint8_t>& noise = assets["textures/noise.bin"];
+        for (int i = 0; i < 10000; ++i)
+        {
+            noise.push_back(static_cast<uint8_t>(random()));
+        }
+        assets["shaders/copy.hlsl"] = text;
+        return assets;
+    }
+
+    void TestRoundTrip(const std::filesystem::path& path)
+    {
+        auto assets = MakeAssets();
+        AssetArchiveWriter writer;
+        for (const auto& [name, data] : assets)
+        {
+            CHECK(writer.Add(name, data.data(), data.size()));
+        }
+        CHECK(!writer.Add("tiny", "x", 1));
+        CHECK(writer.GetEntryCount() == assets.size());
+        CHECK(writer.GetDuplicateCount() == 1);
+        CHECK(writer.GetStoredSize() < writer.GetSize());
+        std::string error;
+        CHECK(writer.Write(path, &error));
+
+        // A small queue forces reads to wait for slots.
+        AssetArchive archive(2);
+        CHECK(archive.Open(path, &error));
+        CHECK(archive.GetEntryCount() == assets.size());
+        CHECK(archive.Find("missing") == nullptr);
+
+        std::vector<AlignedBuffer> buffers;
+        std::vector<const AssetArchiveEntry*> entries;
+        for (const auto& [name, data] : assets)
+        {
+            const AssetArchiveEntry* entry = archive.Find(name.c_str());
+            CHECK(entry && entry->size == data.size());
+            if (!entry)
+            {
+                return;
+            }
+            CHECK(entry->offset % c_AssetArchiveAlignment == 0);
+            buffers.push_back(AllocateAlignedBuffer(AssetArchive::GetReadSize(*entry)));
+            archive.Read(*entry, buffers.back().get(), entries.size());
+            entries.push_back(entry);
+        }
+        CHECK((archive.Find("shaders/text.hlsl")->flags & c_AssetEntryCompressed) != 0);
+        CHECK((archive.Find("textures/noise.bin")->flags & c_AssetEntryCompressed) == 0);
+        CHECK(archive.Find("shaders/text.hlsl")->offset == archive.Find("shaders/copy.hlsl")->offset);
+
+        archive.GetReader().Submit();
+        std::vector<bool> done(entries.size(), false);
+        AsyncReadResult results[8];
+        while (archive.GetReader().GetOutstandingCount())
+        {
+            uint32_t count = archive.GetReader().Poll(results, 8, true);
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                const AssetArchiveEntry& entry = *entries[results[i].userData];
+                CHECK(results[i].ok && results[i].bytesRead >= entry.storedSize);
+                std::vector<uint8_t> unpacked(entry.size);
+                CHECK(AssetArchive::Unpack(entry, buffers[results[i].userData].get(), unpacked.data()));
+                CHECK(entry.contentHash == HashBytes(unpacked.data(), unpacked.size()));
+                done[results[i].userData] = true;
+            }
+        }
+        CHECK(std::find(done.begin(), done.end(), false) == done.end());
+
+        // Damaged stored data fails to unpack instead of overrunning.
+        const AssetArchiveEntry& text = *archive.Find("shaders/text.hlsl");
+        std::vector<uint8_t> output(text.size);
+        std::vector<uint8_t> truncated(text.storedSize / 2, 0);
+        AssetArchiveEntry shorter = text;
+        shorter.storedSize = static_cast<uint32_t>(truncated.size());
+        CHECK(!AssetArchive::Unpack(shorter, truncated.data(), output.data()));
+    }
+
+    void TestRejected(const std::filesystem::path& path)
+    {
+        const std::vector<uint8_t> good = ReadFile(path);
+        const std::filesystem::path bad = path.parent_path() / "bad.pak";
+        CHECK(OpenError(bad, good).empty());
+
+        AssetArchive missing;
+        std::string error;
+        CHECK(!missing.Open(path.parent_path() / "missing.pak", &error) && error == "cannot open asset archive");
+
+        CHECK(OpenError(bad, {}) == "asset archive is truncated");
+        CHECK(OpenError(bad, std::vector<uint8_t>(good.begin(), good.begin() + sizeof(AssetArchiveHeader) - 1)) ==
+            "asset archive is truncated");
+
+        AssetArchiveHeader header = GetHeader(good);
+        header.magic ^= 1;
+        CHECK(OpenError(bad, WithHeader(good, header)) == "not an asset archive");
+        header = GetHeader(good);
+        header.version = c_AssetArchiveVersion + 1;
+        CHECK(OpenError(bad, WithHeader(good, header)) == "not an asset archive");
+
+        // The table must lie inside the file and match the entry count.
+        CHECK(OpenError(bad, std::vector<uint8_t>(good.begin(), good.begin() + GetHeader(good).tableOffset)) ==
+            "asset archive table out of range");
+        header = GetHeader(good);
+        header.entryCount += 1;
+        CHECK(OpenError(bad, WithHeader(good, header)) == "asset archive table out of range");
+        header = GetHeader(good);
+        header.tableOffset += 8;
+        CHECK(OpenError(bad, WithHeader(good, header)) == "asset archive table out of range");
+        header = GetHeader(good);
+        header.tableOffset = ~uint64_t(0) - c_AssetArchiveAlignment + 1;
+        CHECK(OpenError(bad, WithHeader(good, header)) == "asset archive table out of range");
+
+        // Entries: data inside the file, aligned, sorted by name hash.
+        std::vector<uint8_t> file = good;
+        GetEntries(file)[0].offset += 16;
+        CHECK(OpenError(bad, file) == "invalid asset archive entry");
+
+        file = good;
+        GetEntries(file)[1].offset = GetHeader(good).tableOffset + c_AssetArchiveAlignment;
+        CHECK(OpenError(bad, file) == "invalid asset archive entry");
+
+        file = good;
+        GetEntries(file)[1].storedSize = UINT32_MAX;
+        CHECK(OpenError(bad, file) == "invalid asset archive entry");
+
+        file = good;
+        std::swap(GetEntries(file)[0], GetEntries(file)[1]);
+        CHECK(OpenError(bad, file) == "invalid asset archive entry");
+
+        file = good;
+        for (uint32_t i = 0; i < GetHeader(good).entryCount; ++i)
+        {
+            AssetArchiveEntry& entry = GetEntries(file)[i];
+            if (!(entry.flags & c_AssetEntryCompressed) && entry.size)
+            {
+                entry.size += 1;
+                break;
+            }
+        }
+        CHECK(OpenError(bad, file) == "invalid asset archive entry");
+    }
+}
+
+int main()
+{
+    std::filesystem::path dir = MakeTestDirectory("AssetArchive");
+    TestRoundTrip(dir / "assets.pak");
+    TestRejected(dir / "assets.pak");
+    return GetTestResult();
+}
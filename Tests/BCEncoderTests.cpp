@@ -0,0 +1,366 @@
+#include "Check.h"
+
+#include "BCEncoder.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+    struct Image
+    {
+        uint32_t width;
+        uint32_t height;
+        std::vector<uint8_t> pixels;    // RGBA
+
+        BCImage GetView() const { return { pixels.data(), width, height, width * 4u }; }
+    };
+
+    // Smooth gradients in every channel, the content BC formats are built for.
+    Image MakeGradient(uint32_t width, uint32_t height)
+    {
+        Image image = { width, height, std::vector<uint8_t>(width * height * 4) };
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                uint8_t* pixel = &image.pixels[(y * width + x) * 4];
+                pixel[0] = static_cast<uint8_t>(x * 255 / (width - 1));
+                pixel[1] = static_cast<uint8_t>(y * 255 / (height - 1));
+                pixel[2] = static_cast<uint8_t>(127.5f + 127.5f * std::sin(0.2f * (x + y)));
+                pixel[3] = static_cast<uint8_t>(255 - (x + y) * 255 / (width + height - 2));
+            }
+        }
+        return image;
+    }
+
+    Image MakeNoise(uint32_t width, uint32_t height)
+    {
+        std::mt19937 random(11);
+        Image image = { width, height, std::vector<uint8_t>(width * height * 4) };
+        for (uint8_t& value : image.pixels)
+        {
+            value = static_cast<uint8_t>(random());
+        }
+        return image;
+    }
+
+    // Reference decoders, written from the format specifications rather than
+    // from the encoder.
+    uint64_t ReadBits(const uint8_t* block, uint32_t first, uint32_t count)
+    {
+        uint64_t value = 0;
+        for (uint32_t bit = 0; bit < count; ++bit)
+        {
+            uint32_t position = first + bit;
+            value |= uint64_t((block[position / 8] >> (position % 8)) & 1) << bit;
+        }
+        return value;
+    }
+
+    void DecodeBC1(const uint8_t* block, uint8_t out[16][4])
+    {
+        uint32_t colors[2] = { uint32_t(ReadBits(block, 0, 16)), uint32_t(ReadBits(block, 16, 16)) };
+        int palette[4][3];
+        for (uint32_t i = 0; i < 2; ++i)
+        {
+            uint32_t r = colors[i] >> 11, g = (colors[i] >> 5) & 63, b = colors[i] & 31;
+            palette[i][0] = (r << 3) | (r >> 2);
+            palette[i][1] = (g << 2) | (g >> 4);
+            palette[i][2] = (b << 3) | (b >> 2);
+        }
+        for (int c = 0; c < 3; ++c)
+        {
+            if (colors[0] > colors[1])
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+            else
+            {
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                palette[3][c] = 0;
+            }
+        }
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            uint32_t index = uint32_t(ReadBits(block, 32 + i * 2, 2));
+            for (int c = 0; c < 3; ++c)
+            {
+                out[i][c] = static_cast<uint8_t>(palette[index][c]);
+            }
+            out[i][3] = colors[0] <= colors[1] && index == 3 ? 0 : 255;
+        }
+    }
+
+    void DecodeBC4(const uint8_t* block, uint8_t out[16][4], uint32_t channel)
+    {
+        float palette[8];
+        palette[0] = float(block[0]);
+        palette[1] = float(block[1]);
+        if (block[0] > block[1])
+        {
+            for (uint32_t i = 2; i < 8; ++i)
+            {
+                palette[i] = ((8 - i) * palette[0] + (i - 1) * palette[1]) / 7.0f;
+            }
+        }
+        else
+        {
+            for (uint32_t i = 2; i < 6; ++i)
+            {
+                palette[i] = ((6 - i) * palette[0] + (i - 1) * palette[1]) / 5.0f;
+            }
+            palette[6] = 0.0f;
+            palette[7] = 255.0f;
+        }
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            out[i][channel] = static_cast<uint8_t>(palette[ReadBits(block, 16 + i * 3, 3)] + 0.5f);
+        }
+    }
+
+    // Mode 6 only, the mode the encoder writes; other modes decode to magenta
+    // so that they fail the error bound.
+    void DecodeBC7(const uint8_t* block, uint8_t out[16][4])
+    {
+        if (ReadBits(block, 0, 7) != 1u << 6)
+        {
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                out[i][0] = out[i][2] = out[i][3] = 255;
+                out[i][1] = 0;
+            }
+            return;
+        }
+        const uint32_t weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+        uint32_t endpoints[2][4];
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            for (uint32_t e = 0; e < 2; ++e)
+            {
+                uint32_t pBit = uint32_t(ReadBits(block, 63 + e, 1));
+                endpoints[e][c] = (uint32_t(ReadBits(block, 7 + c * 14 + e * 7, 7)) << 1) | pBit;
+            }
+        }
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            uint32_t index = i == 0 ? uint32_t(ReadBits(block, 65, 3)) : uint32_t(ReadBits(block, 68 + (i - 1) * 4, 4));
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                uint32_t w = weights[index];
+                out[i][c] = static_cast<uint8_t>(((64 - w) * endpoints[0][c] + w * endpoints[1][c] + 32) >> 6);
+            }
+        }
+    }
+
+    // Decodes a block to RGBA; channels a format does not store come out
+    // as 0 (colour) or 255 (alpha).
+    void DecodeBlock(BCFormat format, const uint8_t* block, uint8_t out[16][4])
+    {
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            out[i][0] = out[i][1] = out[i][2] = 0;
+            out[i][3] = 255;
+        }
+        switch (format)
+        {
+        case BCFormat::BC1:
+            DecodeBC1(block, out);
+            break;
+        case BCFormat::BC3:
+            DecodeBC1(block + 8, out);
+            DecodeBC4(block, out, 3);
+            break;
+        case BCFormat::BC4:
+            DecodeBC4(block, out, 0);
+            break;
+        case BCFormat::BC5:
+            DecodeBC4(block, out, 0);
+            DecodeBC4(block + 8, out, 1);
+            break;
+        case BCFormat::BC7:
+            DecodeBC7(block, out);
+            break;
+        }
+    }
+
+    uint32_t GetChannelCount(BCFormat format)
+    {
+        return format == BCFormat::BC1 ? 3 : format == BCFormat::BC4 ? 1 : format == BCFormat::BC5 ? 2 : 4;
+    }
+
+    // Root mean square error per stored channel over the whole image.
+    float GetRmse(const Image& image, BCFormat format, const std::vector<uint8_t>& compressed)
+    {
+        uint32_t blocksX = (image.width + 3) / 4;
+        uint32_t blockSize = GetBCBlockSize(format);
+        uint32_t channels = GetChannelCount(format);
+        double sum = 0.0;
+        for (uint32_t y = 0; y < image.height; ++y)
+        {
+            for (uint32_t x = 0; x < image.width; ++x)
+            {
+                uint8_t decoded[16][4];
+                DecodeBlock(format, &compressed[((y / 4) * blocksX + x / 4) * blockSize], decoded);
+                const uint8_t* original = &image.pixels[(y * image.width + x) * 4];
+                const uint8_t* pixel = decoded[(y % 4) * 4 + x % 4];
+                for (uint32_t c = 0; c < channels; ++c)
+                {
+                    double delta = double(pixel[c]) - double(original[c]);
+                    sum += delta * delta;
+                }
+            }
+        }
+        return float(std::sqrt(sum / (double(image.width) * image.height * channels)));
+    }
+
+    std::vector<uint8_t> Compress(const Image& image, BCFormat format, BCQuality quality, JobSystem* jobs = nullptr)
+    {
+        std::vector<uint8_t> output(GetBCCompressedSize(format, image.width, image.height));
+        CompressImage(image.GetView(), format, quality, jobs, output.data());
+        return output;
+    }
+
+    const BCFormat c_Formats[] = { BCFormat::BC1, BCFormat::BC3, BCFormat::BC4, BCFormat::BC5, BCFormat::BC7 };
+    const BCQuality c_Qualities[] = { BCQuality::Fast, BCQuality::Normal, BCQuality::High };
+
+    void TestSizes()
+    {
+        CHECK(GetBCBlockSize(BCFormat::BC1) == 8 && GetBCBlockSize(BCFormat::BC4) == 8);
+        CHECK(GetBCBlockSize(BCFormat::BC3) == 16 && GetBCBlockSize(BCFormat::BC5) == 16 && GetBCBlockSize(BCFormat::BC7) == 16);
+        CHECK(GetBCCompressedSize(BCFormat::BC1, 16, 16) == 16 * 8);
+        CHECK(GetBCCompressedSize(BCFormat::BC7, 5, 9) == 2 * 3 * 16);
+        CHECK(GetBCCompressedSize(BCFormat::BC4, 1, 1) == 8);
+    }
+
+    // Solid blocks are exact wherever the format can store the colour.
+    void TestSolid()
+    {
+        uint8_t block[64];
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            block[i * 4 + 0] = 255;
+            block[i * 4 + 1] = 0;
+            block[i * 4 + 2] = 255;     // representable in RGB565
+            block[i * 4 + 3] = 77;
+        }
+        for (BCFormat format : c_Formats)
+        {
+            for (BCQuality quality : c_Qualities)
+            {
+                uint8_t compressed[16];
+                CompressBlock(format, quality, block, compressed);
+                uint8_t decoded[16][4];
+                DecodeBlock(format, compressed, decoded);
+                bool exact = true;
+                for (uint32_t i = 0; i < 16; ++i)
+                {
+                    for (uint32_t c = 0; c < GetChannelCount(format); ++c)
+                    {
+                        // BC7 stores 77 as 76 or 77 (7 bits + p-bit).
+                        int tolerance = format == BCFormat::BC7 ? 1 : 0;
+                        exact &= std::abs(int(decoded[i][c]) - int(block[i * 4 + c])) <= tolerance;
+                    }
+                }
+                CHECK(exact);
+            }
+        }
+    }
+
+    void TestRoundTrip()
+    {
+        // Bounds sit a little above what the encoder reaches; a broken
+        // block layout lands far above them.
+        struct Bound
+        {
+            BCFormat format;
+            float gradient;
+            float noise;
+        };
+        const Bound c_Bounds[] = {
+            { BCFormat::BC1, 12.0f, 70.0f },
+            { BCFormat::BC3, 10.5f, 62.0f },
+            { BCFormat::BC4, 1.5f, 10.0f },
+            { BCFormat::BC5, 1.5f, 10.0f },
+            { BCFormat::BC7, 10.0f, 70.0f },
+        };
+
+        Image gradient = MakeGradient(32, 32);
+        Image noise = MakeNoise(16, 16);
+        for (const Bound& bound : c_Bounds)
+        {
+            float previous = FLT_MAX;
+            for (BCQuality quality : c_Qualities)
+            {
+                float gradientError = GetRmse(gradient, bound.format, Compress(gradient, bound.format, quality));
+                float noiseError = GetRmse(noise, bound.format, Compress(noise, bound.format, quality));
+                CHECK(gradientError < bound.gradient);
+                CHECK(noiseError < bound.noise);
+
+                // Higher quality never does worse on the smooth image.
+                CHECK(gradientError <= previous + 0.01f);
+                previous = gradientError;
+            }
+        }
+    }
+
+    // Partial edge blocks replicate the last row and column, so the decoded
+    // pixels inside the image are as good as in full blocks.
+    void TestEdgeBlocks()
+    {
+        Image full = MakeGradient(32, 32);
+        Image partial = { 30, 29, std::vector<uint8_t>(30 * 29 * 4) };
+        for (uint32_t y = 0; y < partial.height; ++y)
+        {
+            std::memcpy(&partial.pixels[y * partial.width * 4], &full.pixels[y * full.width * 4], partial.width * 4);
+        }
+        for (BCFormat format : c_Formats)
+        {
+            std::vector<uint8_t> compressed = Compress(partial, format, BCQuality::Normal);
+            CHECK(compressed.size() == GetBCCompressedSize(format, 30, 29));
+            float fullError = GetRmse(full, format, Compress(full, format, BCQuality::Normal));
+            CHECK(GetRmse(partial, format, compressed) < fullError + 1.0f);
+        }
+    }
+
+    // Every instruction set, and the job system, produce the same bytes.
+    void TestDeterminism()
+    {
+        Image image = MakeNoise(24, 20);
+        JobSystem jobs(3);
+        for (BCFormat format : c_Formats)
+        {
+            for (BCQuality quality : c_Qualities)
+            {
+                SetBCSimd(BCSimd::None);
+                CHECK(GetBCSimd() == BCSimd::None);
+                std::vector<uint8_t> reference = Compress(image, format, quality);
+                for (BCSimd simd : { BCSimd::Sse2, BCSimd::Avx2 })
+                {
+                    SetBCSimd(simd);
+                    CHECK(GetBCSimd() <= simd);
+                    CHECK(Compress(image, format, quality) == reference);
+                }
+                CHECK(Compress(image, format, quality, &jobs) == reference);
+            }
+        }
+        SetBCSimd(BCSimd::Best);
+        CHECK(GetBCSimd() != BCSimd::Best);
+    }
+}
+
+int main()
+{
+    TestSizes();
+    TestSolid();
+    TestRoundTrip();
+    TestEdgeBlocks();
+    TestDeterminism();
+    return GetTestResult();
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+// Just enough to write tests without a framework: CHECK prints the failed
+// expression and carries on, main returns GetTestResult().
+inline int& GetFailedCheckCount()
+{
+    static int s_Count = 0;
+    return s_Count;
+}
+
+#define CHECK(expression) \
+    ((expression) ? (void)0 \
+        : (std::fprintf(stderr, "%s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #expression), \
+            (void)++GetFailedCheckCount()))
+
+inline int GetTestResult()
+{
+    int count = GetFailedCheckCount();
+    if (count)
+    {
+        std::fprintf(stderr, "%d check(s) failed\n", count);
+    }
+    return count ? 1 : 0;
+}
+
+// An empty directory under the system temp directory, removed first if a
+// previous run left it behind.
+inline std::filesystem::path MakeTestDirectory(const std::string& name)
+{
+    std::error_code error;
+    std::filesystem::path dir = std::filesystem::temp_directory_path(error) / ("DX12PracticeTests-" + name);
+    std::filesystem::remove_all(dir, error);
+    std::filesystem::create_directories(dir, error);
+    return dir;
+}
+
+inline bool WriteTextFile(const std::filesystem::path& path, const std::string& text)
+{
+    FILE* file = std::fopen(path.string().c_str(), "wb");
+    if (!file)
+    {
+        return false;
+    }
+    bool ok = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+    return std::fclose(file) == 0 && ok;
+}
@@ -0,0 +1,185 @@
+#include "Check.h"
+
+#include "EntityStore.h"
+#include "JobSystem.h"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+    struct Position
+    {
+        float x, y, z;
+    };
+
+    struct Velocity
+    {
+        float x, y, z;
+    };
+
+    struct alignas(16) Bounds
+    {
+        float min[4];
+        float max[4];
+    };
+
+    struct Tag
+    {
+        uint32_t value;
+    };
+
+    void TestLifetime()
+    {
+        EntityStore store;
+        Entity a = store.Create(Position{ 1, 2, 3 });
+        Entity b = store.Create(Position{ 4, 5, 6 }, Velocity{ 1, 0, 0 });
+        CHECK(store.IsAlive(a) && store.IsAlive(b));
+        CHECK(store.GetEntityCount() == 2);
+        CHECK(store.Has<Position>(b) && store.Has<Velocity>(b) && !store.Has<Velocity>(a));
+        CHECK(store.Get<Position>(a)->y == 2.0f);
+
+        store.Destroy(a);
+        CHECK(!store.IsAlive(a));
+        CHECK(store.GetEntityCount() == 1);
+        CHECK(store.Get<Position>(b)->x == 4.0f);
+
+        // The slot is reused with a new generation; the stale handle stays dead.
+        Entity c = store.Create(Position{ 7, 8, 9 });
+        CHECK(store.IsAlive(c) && !store.IsAlive(a));
+        CHECK(!(c == a));
+        CHECK(store.Get<Position>(c)->z == 9.0f);
+    }
+
+    void TestAddRemove()
+    {
+        EntityStore store;
+        std::vector<Entity> entities;
+        for (uint32_t i = 0; i < 10; ++i)
+        {
+            entities.push_back(store.Create(Position{ float(i), 0, 0 }, Tag{ i }));
+        }
+
+        // Moving an entity to another archetype keeps its other components and
+        // leaves the entities swapped into its old row intact.
+        store.Add(entities[3], Velocity{ 3, 3, 3 });
+        store.Remove<Tag>(entities[5]);
+        CHECK(store.Has<Velocity>(entities[3]) && store.Get<Velocity>(entities[3])->y == 3.0f);
+        CHECK(!store.Has<Tag>(entities[5]));
+        for (uint32_t i = 0; i < 10; ++i)
+        {
+            CHECK(store.Get<Position>(entities[i])->x == float(i));
+            CHECK(i == 5 || store.Get<Tag>(entities[i])->value == i);
+        }
+        CHECK(store.Get<Tag>(entities[5]) == nullptr);
+
+        store.Remove<Position>(entities[3]);
+        CHECK(!store.Has<Position>(entities[3]) && store.Get<Velocity>(entities[3])->z == 3.0f);
+    }
+
+    void TestForEach(JobSystem* jobs)
+    {
+        EntityStore store;
+        const uint32_t count = 20000;   // many chunks
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (i % 3 == 0)
+            {
+                store.Create(Position{ float(i), 0, 0 });
+            }
+            else if (i % 3 == 1)
+            {
+                store.Create(Position{ float(i), 0, 0 }, Velocity{ 1, 2, 3 });
+            }
+            else
+            {
+                store.Create(Position{ float(i), 0, 0 }, Velocity{ 1, 2, 3 }, Bounds{});
+            }
+        }
+        CHECK(store.GetChunkCount() > 2);
+
+        std::atomic<uint32_t> visited{ 0 };
+        std::atomic<uint32_t> misaligned{ 0 };
+        std::atomic<uint32_t> withBounds{ 0 };
+        std::atomic<uint32_t> missingWrong{ 0 };
+        store.ForEach<Position, Velocity>(jobs, [&](ChunkView& chunk)
+        {
+            Position* positions = chunk.GetMutable<Position>();
+            const Velocity* velocities = chunk.Get<Velocity>();
+            const Bounds* bounds = chunk.Get<Bounds>();
+            misaligned += (reinterpret_cast<uintptr_t>(positions) % 64) || (reinterpret_cast<uintptr_t>(bounds) % 64) ? 1 : 0;
+            // Bounds is optional here; Tag is in none of the chunks.
+            withBounds += bounds ? chunk.GetCount() : 0;
+            missingWrong += chunk.Get<Tag>() || chunk.GetMutable<Tag>() || chunk.HasChanged<Tag>(0) ? 1 : 0;
+            for (uint32_t i = 0; i < chunk.GetCount(); ++i)
+            {
+                positions[i].y += velocities[i].y;
+            }
+            visited += chunk.GetCount();
+        });
+        CHECK(visited == count - (count + 2) / 3);
+        CHECK(misaligned == 0);
+        CHECK(withBounds > 0 && withBounds < visited);
+        CHECK(missingWrong == 0);
+
+        uint32_t moved = 0;
+        uint32_t total = 0;
+        store.ForEach<Position>(nullptr, [&](ChunkView& chunk)
+        {
+            const Position* positions = chunk.Get<Position>();
+            const Entity* entities = chunk.GetEntities();
+            for (uint32_t i = 0; i < chunk.GetCount(); ++i)
+            {
+                moved += positions[i].y == 2.0f ? 1 : 0;
+                total += store.IsAlive(entities[i]) ? 1 : 0;
+            }
+        });
+        CHECK(moved == visited);
+        CHECK(total == count);
+    }
+
+    void TestVersions()
+    {
+        EntityStore store;
+        Entity a = store.Create(Position{}, Velocity{});
+        uint32_t seen = store.GetVersion();
+        store.AdvanceVersion();
+
+        auto changed = [&](bool position)
+        {
+            bool result = false;
+            store.ForEach<Position, Velocity>(nullptr, [&](ChunkView& chunk)
+            {
+                result = result || (position ? chunk.HasChanged<Position>(seen) : chunk.HasChanged<Velocity>(seen));
+            });
+            return result;
+        };
+        CHECK(!changed(true) && !changed(false));
+
+        store.GetMutable<Velocity>(a)->x = 1.0f;
+        CHECK(!changed(true) && changed(false));
+        CHECK(store.Get<Velocity>(a)->x == 1.0f);
+
+        // Reads through Get() do not stamp.
+        seen = store.GetVersion();
+        store.AdvanceVersion();
+        CHECK(store.Get<Position>(a) != nullptr);
+        CHECK(!changed(true) && !changed(false));
+
+        // Structural changes stamp every column of the chunk.
+        store.Create(Position{}, Velocity{});
+        CHECK(changed(true) && changed(false));
+    }
+}
+
+int main()
+{
+    JobSystem jobs(3);
+    TestLifetime();
+    TestAddRemove();
+    TestForEach(nullptr);
+    TestForEach(&jobs);
+    TestVersions();
+    return GetTestResult();
+}
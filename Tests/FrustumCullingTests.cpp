@@ -0,0 +1,121 @@
+#include "Check.h"
+
+#include "FrustumCulling.h"
+#include "JobSystem.h"
+
+#include <random>
+#include <vector>
+
+namespace
+{
+    // Orthographic box [-1, 1] x [-1, 1] x [0, 1] as a view-projection.
+    Frustum MakeUnitFrustum()
+    {
+        const float identity[4][4] = { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 }, { 0, 0, 0, 1 } };
+        return Frustum::FromViewProjection(identity);
+    }
+
+    void AddBox(CullingScene& scene, float x, float y, float z, float halfSize)
+    {
+        const float center[3] = { x, y, z };
+        const float boxMin[3] = { x - halfSize, y - halfSize, z - halfSize };
+        const float boxMax[3] = { x + halfSize, y + halfSize, z + halfSize };
+        scene.Add(center, halfSize * 1.7320508f, boxMin, boxMax);
+    }
+
+    void TestFrustumPlanes()
+    {
+        Frustum frustum = MakeUnitFrustum();
+        const float inside[3] = { 0.5f, -0.5f, 0.5f };
+        const float outside[3] = { 0.0f, 0.0f, 1.5f };
+        for (const auto& plane : frustum.planes)
+        {
+            float length = plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2];
+            CHECK(length > 0.999f && length < 1.001f);
+            CHECK(plane[0] * inside[0] + plane[1] * inside[1] + plane[2] * inside[2] + plane[3] >= 0.0f);
+        }
+        bool rejected = false;
+        for (const auto& plane : frustum.planes)
+        {
+            rejected = rejected || plane[0] * outside[0] + plane[1] * outside[1] + plane[2] * outside[2] + plane[3] < 0.0f;
+        }
+        CHECK(rejected);
+    }
+
+    void TestKnownObjects()
+    {
+        CullingScene scene;
+        AddBox(scene, 0.0f, 0.0f, 0.5f, 0.1f);      // inside
+        AddBox(scene, 3.0f, 0.0f, 0.5f, 0.1f);      // right of the frustum
+        AddBox(scene, 1.05f, 0.0f, 0.5f, 0.1f);     // straddles the right plane
+        AddBox(scene, 0.0f, 0.0f, -0.5f, 0.1f);     // behind the near plane
+        AddBox(scene, 0.0f, 0.0f, 0.5f, 10.0f);     // contains the frustum
+
+        std::vector<uint32_t> visible;
+        scene.Cull(MakeUnitFrustum(), nullptr, visible);
+        CHECK(visible == std::vector<uint32_t>({ 0, 2, 4 }));
+
+        float boxMin[3];
+        float boxMax[3];
+        scene.GetBox(2, boxMin, boxMax);
+        CHECK(boxMin[0] > 0.949f && boxMin[0] < 0.951f && boxMax[2] > 0.599f && boxMax[2] < 0.601f);
+
+        scene.Clear();
+        scene.Cull(MakeUnitFrustum(), nullptr, visible);
+        CHECK(scene.GetCount() == 0 && visible.empty());
+    }
+
+    // Every instruction set, with and without jobs, matches the scalar loop,
+    // including counts that are not a multiple of the SIMD width or of 64.
+    void TestSimdMatchesScalar(JobSystem& jobs)
+    {
+        std::mt19937 random(42);
+        std::uniform_real_distribution<float> position(-2.0f, 2.0f);
+        std::uniform_real_distribution<float> size(0.0f, 0.3f);
+        Frustum frustum = MakeUnitFrustum();
+
+        for (uint32_t count : { 1u, 7u, 63u, 65u, 1000u, 20000u })
+        {
+            CullingScene scene;
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                AddBox(scene, position(random), position(random), position(random), size(random));
+            }
+
+            std::vector<uint32_t> expected;
+            scene.CullScalar(frustum, expected);
+            for (CullingSimd simd : { CullingSimd::None, CullingSimd::Sse2, CullingSimd::Avx2 })
+            {
+                SetCullingSimd(simd);
+                CHECK(GetCullingSimd() <= simd);
+
+                std::vector<uint32_t> visible;
+                std::vector<uint64_t> bits;
+                scene.Cull(frustum, nullptr, visible, &bits);
+                CHECK(visible == expected);
+                CHECK(bits.size() == (count + 63) / 64);
+
+                uint32_t bitCount = 0;
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    bitCount += (bits[i / 64] >> (i % 64)) & 1;
+                }
+                CHECK(bitCount == expected.size());
+
+                scene.Cull(frustum, &jobs, visible);
+                CHECK(visible == expected);
+            }
+        }
+        SetCullingSimd(CullingSimd::Best);
+        CHECK(GetCullingSimd() != CullingSimd::Best);
+    }
+}
+
+int main()
+{
+    JobSystem jobs(3);
+    TestFrustumPlanes();
+    TestKnownObjects();
+    TestSimdMatchesScalar(jobs);
+    return GetTestResult();
+}
@@ -0,0 +1,160 @@
+#include "Check.h"
+
+#include "HlslLayout.h"
+
+namespace
+{
+    // The examples from the HLSL constant packing rules. Most of the checks
+    // are static_asserts, so a regression fails the build; the runtime checks
+    // below repeat them to report which one broke.
+    constexpr HlslField c_Vectors[] = { HlslFloat4, HlslFloat2, HlslFloat2 };
+    static_assert(ComputeHlslLayout(c_Vectors).offsets[2] == 24, "float2 packs behind float2");
+
+    constexpr HlslField c_Straddle[] = { HlslFloat2, HlslFloat4, HlslFloat2 };
+    static_assert(ComputeHlslLayout(c_Straddle).offsets[1] == 16, "float4 may not straddle a register");
+
+    constexpr HlslField c_Matrix[] = { HlslFloat, HlslFloat4x4, HlslFloat };
+    static_assert(ComputeHlslLayout(c_Matrix).offsets[2] == 80, "float follows a matrix");
+
+    struct PerDraw
+    {
+        float world[4][4];
+        float tint[3];
+        float alpha;
+    };
+    constexpr HlslField c_PerDrawFields[] = { HlslFloat4x4, HlslFloat3, HlslFloat };
+    static_assert(VerifyHlslLayout<PerDraw>(c_PerDrawFields,
+        { HLSL_MEMBER(PerDraw, world), HLSL_MEMBER(PerDraw, tint), HLSL_MEMBER(PerDraw, alpha) }), "PerDraw");
+
+    void TestPacking()
+    {
+        auto vectors = ComputeHlslLayout(c_Vectors);
+        CHECK(vectors.offsets[1] == 16 && vectors.offsets[2] == 24);
+        CHECK(vectors.size == 32 && vectors.paddedSize == 32);
+
+        auto straddle = ComputeHlslLayout(c_Straddle);
+        CHECK(straddle.offsets[1] == 16 && straddle.offsets[2] == 32);
+        CHECK(straddle.size == 40 && straddle.paddedSize == 48);
+
+        // float3 fits behind one float, not behind a float2.
+        constexpr HlslField floatFloat3[] = { HlslFloat, HlslFloat3 };
+        CHECK(ComputeHlslLayout(floatFloat3).offsets[1] == 4);
+        constexpr HlslField float2Float3[] = { HlslFloat2, HlslFloat3 };
+        auto float2Float3Layout = ComputeHlslLayout(float2Float3);
+        CHECK(float2Float3Layout.offsets[1] == 16);
+        CHECK(float2Float3Layout.size == 28 && float2Float3Layout.paddedSize == 32);
+
+        // Integer types pack like floats.
+        constexpr HlslField integers[] = { HlslUint, HlslInt2, HlslUint };
+        auto integerLayout = ComputeHlslLayout(integers);
+        CHECK(integerLayout.offsets[1] == 4 && integerLayout.offsets[2] == 12 && integerLayout.size == 16);
+    }
+
+    void TestMatricesAndArrays()
+    {
+        auto matrix = ComputeHlslLayout(c_Matrix);
+        CHECK(matrix.offsets[1] == 16 && matrix.offsets[2] == 80 && matrix.paddedSize == 96);
+
+        // Column-major float3x3: three columns of three, the last one short.
+        constexpr HlslField float3x3[] = { HlslFloat3x3, HlslFloat };
+        CHECK(HlslFieldSize(HlslFloat3x3) == 44);
+        CHECK(ComputeHlslLayout(float3x3).offsets[1] == 44);
+        CHECK(HlslFieldSize(HlslFloat4x3) == 48);
+        CHECK(HlslFieldSize(HlslFloat3x4) == 60);
+
+        // Every array element starts a register; the next field may use the
+        // rest of the last one.
+        constexpr HlslField floats[] = { HlslFloat, HlslArray(HlslFloat, 4), HlslFloat };
+        auto floatArray = ComputeHlslLayout(floats);
+        CHECK(floatArray.offsets[1] == 16);
+        CHECK(HlslFieldSize(HlslArray(HlslFloat, 4)) == 52);
+        CHECK(floatArray.offsets[2] == 68);
+
+        constexpr HlslField float3s[] = { HlslArray(HlslFloat3, 2), HlslFloat };
+        CHECK(ComputeHlslLayout(float3s).offsets[1] == 28);
+
+        constexpr HlslField matrices[] = { HlslArray(HlslFloat4x4, 2), HlslFloat2 };
+        CHECK(ComputeHlslLayout(matrices).offsets[1] == 128);
+    }
+
+    void TestVerify()
+    {
+        // Tightly packed C++ puts the float4 at 8; HLSL puts it at 16.
+        struct Tight
+        {
+            float a[2];
+            float b[4];
+        };
+        constexpr HlslField fields[] = { HlslFloat2, HlslFloat4 };
+        CHECK(!VerifyHlslLayout<Tight>(fields, { HLSL_MEMBER(Tight, a), HLSL_MEMBER(Tight, b) }));
+
+        struct Padded
+        {
+            float a[2];
+            float padding[2];
+            float b[4];
+        };
+        CHECK(VerifyHlslLayout<Padded>(fields, { HLSL_MEMBER(Padded, a), HLSL_MEMBER(Padded, b) }));
+
+        // A C++ array may cover whole registers or stop at the last used byte.
+        struct Planes
+        {
+            float planes[6][4];
+            float count;
+        };
+        constexpr HlslField planeFields[] = { HlslArray(HlslFloat4, 6), HlslFloat };
+        CHECK(VerifyHlslLayout<Planes>(planeFields, { HLSL_MEMBER(Planes, planes), HLSL_MEMBER(Planes, count) }));
+
+        struct Weights
+        {
+            float weights[2][4];    // float weights[2] in HLSL: a short last element
+            float bias;
+        };
+        constexpr HlslField weightFields[] = { HlslArray(HlslFloat, 2), HlslFloat };
+        CHECK(!VerifyHlslLayout<Weights>(weightFields, { HLSL_MEMBER(Weights, weights), HLSL_MEMBER(Weights, bias) }));
+        struct ShortWeights
+        {
+            float weights[2][4];
+            float bias[4];
+        };
+        constexpr HlslField shortFields[] = { HlslArray(HlslFloat, 2), HlslFloat4 };
+        CHECK(VerifyHlslLayout<ShortWeights>(shortFields,
+            { HLSL_MEMBER(ShortWeights, weights), HLSL_MEMBER(ShortWeights, bias) }));
+
+        // A struct larger than the padded buffer does not match either.
+        struct TooLarge
+        {
+            float a[2];
+            float padding[2];
+            float b[4];
+            float extra[4];
+        };
+        CHECK(!VerifyHlslLayout<TooLarge>(fields, { HLSL_MEMBER(TooLarge, a), HLSL_MEMBER(TooLarge, b) }));
+    }
+
+    void TestRootConstants()
+    {
+        // Root constants stop at the last used DWORD.
+        constexpr HlslField background[] = { HlslFloat2 };
+        CHECK(HlslRootConstantCount(background) == 2);
+        CHECK(HlslRootConstantCount(c_Straddle) == 10);
+        CHECK(HlslRootConstantCount(c_PerDrawFields) == 20);
+
+        struct DrawConstants
+        {
+            uint32_t meshletCount;
+            uint32_t vertexStride;
+        };
+        CHECK(RootConstantBlock<DrawConstants>::c_Num32BitValues == 2);
+        CHECK((RootConstantBlock<PerDraw, HlslRootConstantCount(c_PerDrawFields)>::c_Num32BitValues == 20));
+    }
+}
+
+int main()
+{
+    TestPacking();
+    TestMatricesAndArrays();
+    TestVerify();
+    TestRootConstants();
+    return GetTestResult();
+}
@@ -0,0 +1,150 @@
+#include "Check.h"
+
+#include "FileWatcher.h"
+#include "HotReload.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+    const auto c_SettleTime = std::chrono::milliseconds(20);
+
+    std::string Normalize(const std::filesystem::path& path)
+    {
+        return std::filesystem::absolute(path).lexically_normal().generic_string();
+    }
+
+    bool Contains(const std::vector<std::filesystem::path>& paths, const std::filesystem::path& path)
+    {
+        return std::any_of(paths.begin(), paths.end(),
+            [&](const std::filesystem::path& changed) { return changed.generic_string() == Normalize(path); });
+    }
+
+    // Polls until something settles or a second has passed.
+    std::vector<std::filesystem::path> PollSettled(FileWatcher& watcher)
+    {
+        std::vector<std::filesystem::path> changed;
+        for (int i = 0; i < 100 && changed.empty(); ++i)
+        {
+            std::this_thread::sleep_for(c_SettleTime);
+            watcher.Poll(changed);
+        }
+        return changed;
+    }
+
+    void TestFileWatcher()
+    {
+        std::filesystem::path dir = MakeTestDirectory("FileWatcher");
+        FileWatcher watcher(c_SettleTime);
+        CHECK(watcher.Watch(dir));
+        CHECK(!watcher.Watch(dir / "missing"));
+
+        // A temporary file that is gone before it settles is not reported.
+        WriteTextFile(dir / "kept.txt", "kept");
+        WriteTextFile(dir / "kept.txt.tmp", "temporary");
+        std::filesystem::remove(dir / "kept.txt.tmp");
+        std::vector<std::filesystem::path> changed = PollSettled(watcher);
+        CHECK(changed.size() == 1 && Contains(changed, dir / "kept.txt"));
+
+        // Nothing more until the next write.
+        changed.clear();
+        std::this_thread::sleep_for(2 * c_SettleTime);
+        CHECK(watcher.Poll(changed) == 0);
+
+        // Directories created later are watched too, and files written into
+        // them before their watch existed are still reported.
+        std::filesystem::create_directories(dir / "sub" / "deeper");
+        WriteTextFile(dir / "sub" / "deeper" / "new.txt", "new");
+        changed = PollSettled(watcher);
+        CHECK(Contains(changed, dir / "sub" / "deeper" / "new.txt"));
+        WriteTextFile(dir / "sub" / "later.txt", "later");
+        changed = PollSettled(watcher);
+        CHECK(changed.size() == 1 && Contains(changed, dir / "sub" / "later.txt"));
+
+        // Written, then renamed over the original: only the original remains.
+        WriteTextFile(dir / "kept.txt.new", "replaced");
+        std::filesystem::rename(dir / "kept.txt.new", dir / "kept.txt");
+        changed = PollSettled(watcher);
+        CHECK(changed.size() == 1 && Contains(changed, dir / "kept.txt"));
+    }
+
+    std::shared_ptr<std::string> BuildText(const std::filesystem::path& path, ReloadContext& context)
+    {
+        context.dependencies.push_back(path);
+        std::ifstream file(path);
+        std::stringstream text;
+        text << file.rdbuf();
+        if (!file || text.str() == "broken")
+        {
+            context.errors = "cannot build " + path.string();
+            return nullptr;
+        }
+        return std::make_shared<std::string>(text.str());
+    }
+
+    // Runs frames until object reaches version or, given failures, a build
+    // fails; gives up after two seconds. Returns the next frame number.
+    template<typename T>
+    uint64_t RunFramesUntil(HotReloader& reloader, const Reloadable<T>& object, uint32_t version, uint64_t frame,
+        uint32_t* failures)
+    {
+        for (int i = 0; i < 200 && object.GetVersion() < version && (!failures || *failures == 0); ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            reloader.BeginFrame(frame + 1, frame - 1);
+            ++frame;
+        }
+        return frame;
+    }
+
+    void TestHotReloader()
+    {
+        std::filesystem::path dir = MakeTestDirectory("HotReloader");
+        std::filesystem::path path = dir / "text.txt";
+        WriteTextFile(path, "first");
+
+        JobSystem jobs(2);
+        HotReloader reloader(jobs);
+        CHECK(reloader.Watch(dir));
+        uint32_t failures = 0;
+        reloader.SetCallback([&](const ReloadableObject&, bool succeeded) { failures += succeeded ? 0 : 1; });
+
+        Reloadable<std::string>* text = reloader.Add<std::string>("text",
+            [path](ReloadContext& context) { return BuildText(path, context); });
+        CHECK(text->Get() == nullptr);
+        uint64_t frame = RunFramesUntil(reloader, *text, 1, 1, nullptr);
+        CHECK(text->GetVersion() == 1 && text->Get() && *text->Get() == "first");
+
+        // Saving the file builds and installs a new version; the old one is
+        // kept until its frame has completed.
+        WriteTextFile(path, "second");
+        frame = RunFramesUntil(reloader, *text, 2, frame, nullptr);
+        CHECK(text->GetVersion() == 2 && *text->Get() == "second");
+        CHECK(reloader.GetRetiredCount() == 1);
+        reloader.BeginFrame(frame + 1, frame);
+        CHECK(reloader.GetRetiredCount() == 0);
+
+        // A failed build keeps the current version and reports its errors.
+        WriteTextFile(path, "broken");
+        frame = RunFramesUntil(reloader, *text, 3, frame, &failures);
+        CHECK(failures == 1 && text->GetVersion() == 2 && *text->Get() == "second");
+        CHECK(!text->GetErrors().empty());
+
+        WriteTextFile(path, "third");
+        RunFramesUntil(reloader, *text, 3, frame, nullptr);
+        CHECK(text->GetVersion() == 3 && *text->Get() == "third" && text->GetErrors().empty());
+        CHECK(reloader.GetBuildingCount() == 0);
+    }
+}
+
+int main()
+{
+    TestFileWatcher();
+    TestHotReloader();
+    return GetTestResult();
+}
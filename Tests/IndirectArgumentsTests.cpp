@@ -0,0 +1,82 @@
+#include "Check.h"
+
+#include "IndirectArguments.h"
+
+#include <string>
+#include <vector>
+
+namespace
+{
+    void TestDrawCommandLayouts()
+    {
+        CHECK(sizeof(IndirectDrawCommand) == 24);
+        const IndirectArgumentType expected[c_IndirectDrawTypeCount] = {
+            IndirectArgumentType::Draw,
+            IndirectArgumentType::DrawIndexed,
+            IndirectArgumentType::Dispatch,
+            IndirectArgumentType::DispatchMesh,
+        };
+        for (uint32_t i = 0; i < c_IndirectDrawTypeCount; ++i)
+        {
+            auto type = static_cast<IndirectDrawType>(i);
+            auto arguments = GetIndirectDrawArguments(type, 2);
+            CHECK(arguments.size() == 2);
+            CHECK(arguments[0].type == IndirectArgumentType::Constant && arguments[0].slot == 2);
+            CHECK(arguments[1].type == expected[i]);
+
+            std::string error;
+            CHECK(ValidateIndirectDrawCommand(type, 2, &error));
+            CHECK(error.empty());
+            CHECK(ComputeIndirectLayout(arguments).packedSize <= sizeof(IndirectDrawCommand));
+        }
+    }
+
+    void TestLayout()
+    {
+        std::vector<IndirectArgument> arguments = {
+            { IndirectArgumentType::Constant, 0, 0, 3 },
+            { IndirectArgumentType::VertexBufferView, 1 },
+            { IndirectArgumentType::IndexBufferView },
+            { IndirectArgumentType::ShaderResourceView, 1 },
+            { IndirectArgumentType::DrawIndexed },
+        };
+        IndirectLayout layout = ComputeIndirectLayout(arguments);
+        CHECK(layout.offsets == std::vector<uint32_t>({ 0, 12, 28, 44, 52 }));
+        CHECK(layout.packedSize == 72);
+        CHECK(ValidateIndirectArguments(arguments, 72, true));
+        CHECK(ValidateIndirectArguments(arguments, 80, true));
+        CHECK(!ValidateIndirectArguments(arguments, 68, true));
+        CHECK(!ValidateIndirectArguments(arguments, 74, true));
+        CHECK(!ValidateIndirectArguments(arguments, 72, false));
+    }
+
+    void TestRules()
+    {
+        using Type = IndirectArgumentType;
+        std::string error;
+        CHECK(!ValidateIndirectArguments({}, 16, true, &error) && !error.empty());
+        // The draw or dispatch comes last, and only once.
+        CHECK(!ValidateIndirectArguments({ { Type::Draw }, { Type::Constant, 0, 0, 1 } }, 20, true));
+        CHECK(!ValidateIndirectArguments({ { Type::Draw }, { Type::Draw } }, 32, true));
+        // Each root parameter and vertex slot is changed once.
+        CHECK(!ValidateIndirectArguments({ { Type::Constant, 0, 0, 1 }, { Type::ShaderResourceView, 0 }, { Type::Draw } }, 32, true));
+        CHECK(!ValidateIndirectArguments({ { Type::VertexBufferView, 0 }, { Type::VertexBufferView, 0 }, { Type::Draw } }, 48, true));
+        CHECK(!ValidateIndirectArguments({ { Type::Constant, 0, 0, 0 }, { Type::Draw } }, 16, true));
+        // Buffer views only with draws; index buffers only with indexed draws.
+        CHECK(!ValidateIndirectArguments({ { Type::VertexBufferView, 0 }, { Type::Dispatch } }, 28, true));
+        CHECK(!ValidateIndirectArguments({ { Type::IndexBufferView }, { Type::Draw } }, 32, true));
+        CHECK(ValidateIndirectArguments({ { Type::Dispatch } }, 12, false));
+
+        // A C++ struct whose members are not where the signature expects them.
+        CHECK(!ValidateIndirectCommandStruct({ { Type::Constant, 0, 0, 1 }, { Type::DrawIndexed } }, { 0, 8 }, 28, &error));
+        CHECK(ValidateIndirectCommandStruct({ { Type::Constant, 0, 0, 1 }, { Type::DrawIndexed } }, { 0, 4 }, 24, &error));
+    }
+}
+
+int main()
+{
+    TestDrawCommandLayouts();
+    TestLayout();
+    TestRules();
+    return GetTestResult();
+}
@@ -0,0 +1,160 @@
+#include "Check.h"
+
+#include "LzCodec.h"
+
+#include <random>
+#include <vector>
+
+namespace
+{
+    std::vector<uint8_t> Compress(const std::vector<uint8_t>& data)
+    {
+        std::vector<uint8_t> compressed(GetLzCompressBound(data.size()));
+        size_t size = LzCompress(data.data(), data.size(), compressed.data(), compressed.size());
+        CHECK(size > 0);
+        compressed.resize(size);
+        return compressed;
+    }
+
+    bool Decompress(const std::vector<uint8_t>& compressed, size_t size, std::vector<uint8_t>& output)
+    {
+        output.assign(size, 0xcd);
+        return LzDecompress(compressed.data(), compressed.size(), output.data(), size);
+    }
+
+    bool RoundTrips(const std::vector<uint8_t>& data)
+    {
+        std::vector<uint8_t> output;
+        return Decompress(Compress(data), data.size(), output) && output == data;
+    }
+
+    // Text-like data: words from a small vocabulary, so matches of every
+    // length and offset turn up.
+    std::vector<uint8_t> MakeText(size_t size, uint32_t seed)
+    {
+        const char* c_Words[] = { "vertex ", "index ", "buffer ", "shader ", "texture ", "root ", "signature ", "\n" };
+        std::mt19937 random(seed);
+        std::vector<uint8_t> data;
+        while (data.size() < size)
+        {
+            const char* word = c_Words[random() % 8];
+            while (*word && data.size() < size)
+            {
+                data.push_back(static_cast<uint8_t>(*word++));
+            }
+        }
+        return data;
+    }
+
+    std::vector<uint8_t> MakeNoise(size_t size, uint32_t seed)
+    {
+        std::mt19937 random(seed);
+        std::vector<uint8_t> data(size);
+        for (uint8_t& value : data)
+        {
+            value = static_cast<uint8_t>(random());
+        }
+        return data;
+    }
+
+    void TestRoundTrip()
+    {
+        CHECK(RoundTrips({}));
+        CHECK(RoundTrips({ 42 }));
+        CHECK(RoundTrips({ 1, 2, 3, 4, 1, 2, 3, 4 }));
+
+        // Runs use overlapping matches (offset 1, and offsets below 8).
+        CHECK(RoundTrips(std::vector<uint8_t>(100000, 7)));
+        std::vector<uint8_t> pattern;
+        for (size_t i = 0; i < 5000; ++i)
+        {
+            pattern.push_back(static_cast<uint8_t>(i % 5));
+        }
+        CHECK(RoundTrips(pattern));
+
+        // Long literal runs need length continuation bytes; matches further
+        // back than 65535 bytes cannot be used.
+        CHECK(RoundTrips(MakeNoise(70000, 1)));
+        std::vector<uint8_t> far = MakeNoise(1000, 2);
+        std::vector<uint8_t> gap = MakeNoise(70000, 3);
+        far.insert(far.end(), gap.begin(), gap.end());
+        far.insert(far.end(), far.begin(), far.begin() + 1000);
+        CHECK(RoundTrips(far));
+
+        std::vector<uint8_t> text = MakeText(200000, 4);
+        std::vector<uint8_t> compressed = Compress(text);
+        CHECK(compressed.size() < text.size() / 2);
+        CHECK(RoundTrips(text));
+        for (size_t size = 0; size < 64; ++size)
+        {
+            CHECK(RoundTrips(MakeText(size, uint32_t(size))));
+        }
+
+        // Incompressible data stays within the bound.
+        std::vector<uint8_t> noise = MakeNoise(100000, 5);
+        CHECK(Compress(noise).size() <= GetLzCompressBound(noise.size()));
+    }
+
+    void TestCapacity()
+    {
+        std::vector<uint8_t> noise = MakeNoise(4096, 6);
+        std::vector<uint8_t> output(noise.size());
+        CHECK(LzCompress(noise.data(), noise.size(), output.data(), output.size() - output.size() / 16) == 0);
+        CHECK(LzCompress(noise.data(), noise.size(), output.data(), 0) == 0);
+
+        // Too small by even one byte fails rather than writing past the end.
+        std::vector<uint8_t> text = MakeText(4096, 7);
+        size_t size = Compress(text).size();
+        CHECK(LzCompress(text.data(), text.size(), output.data(), size - 1) == 0);
+        CHECK(LzCompress(text.data(), text.size(), output.data(), size / 2) == 0);
+    }
+
+    void TestCorrupt()
+    {
+        std::vector<uint8_t> text = MakeText(20000, 8);
+        std::vector<uint8_t> compressed = Compress(text);
+        std::vector<uint8_t> output;
+        CHECK(Decompress(compressed, text.size(), output));
+
+        // The decoded size must match exactly.
+        CHECK(!Decompress(compressed, text.size() - 1, output));
+        CHECK(!Decompress(compressed, text.size() + 1, output));
+        CHECK(!Decompress({}, 0, output));
+
+        // Every truncation fails.
+        bool rejected = true;
+        for (size_t size = 0; size < compressed.size(); ++size)
+        {
+            std::vector<uint8_t> truncated(compressed.begin(), compressed.begin() + size);
+            rejected &= !Decompress(truncated, text.size(), output);
+        }
+        CHECK(rejected);
+
+        // Offsets of zero and before the start of the output.
+        CHECK(!Decompress({ 0x10, 'a', 0x00, 0x00, 0x00 }, 5, output));
+        CHECK(!Decompress({ 0x10, 'a', 0x02, 0x00, 0x00 }, 5, output));
+        CHECK(Decompress({ 0x10, 'a', 0x01, 0x00, 0x00 }, 5, output) && output == std::vector<uint8_t>(5, 'a'));
+
+        // Random damage either decodes to something or fails; it must not
+        // crash.
+        std::mt19937 random(9);
+        for (int i = 0; i < 2000; ++i)
+        {
+            std::vector<uint8_t> damaged = compressed;
+            for (int flips = 0; flips < 4; ++flips)
+            {
+                damaged[random() % damaged.size()] ^= static_cast<uint8_t>(1 + random() % 255);
+            }
+            Decompress(damaged, text.size(), output);
+        }
+        Decompress(MakeNoise(1000, 10), 100000, output);
+    }
+}
+
+int main()
+{
+    TestRoundTrip();
+    TestCapacity();
+    TestCorrupt();
+    return GetTestResult();
+}
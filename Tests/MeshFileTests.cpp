@@ -0,0 +1,183 @@
+#include "Check.h"
+#include "TestMeshes.h"
+
+#include "Hash.h"
+#include "MeshFile.h"
+#include "MeshletBuilder.h"
+
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace
+{
+    std::vector<uint8_t> ReadFile(const std::filesystem::path& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    void WriteFile(const std::filesystem::path& path, const std::vector<uint8_t>& data)
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    }
+
+    MeshFileHeader GetHeader(const std::vector<uint8_t>& file)
+    {
+        MeshFileHeader header;
+        std::memcpy(&header, file.data(), sizeof(header));
+        return header;
+    }
+
+    // A modified header with a matching hash, as a buggy or malicious
+    // cooker would write it.
+    MeshFileHeader Rehash(MeshFileHeader header)
+    {
+        header.headerHash = 0;
+        header.headerHash = HashValue(header);
+        return header;
+    }
+
+    void SetHeader(std::vector<uint8_t>& file, const MeshFileHeader& header)
+    {
+        MeshFileHeader rehashed = Rehash(header);
+        std::memcpy(file.data(), &rehashed, sizeof(rehashed));
+    }
+
+    // Writes data to a file and returns Open's error, or "" if it opened.
+    std::string OpenError(const std::filesystem::path& path, const std::vector<uint8_t>& data)
+    {
+        WriteFile(path, data);
+        MeshFile mesh;
+        std::string error;
+        if (mesh.Open(path, &error))
+        {
+            return "";
+        }
+        CHECK(!mesh.IsOpen());
+        CHECK(!error.empty());
+        return error;
+    }
+
+    void TestRoundTrip(const std::filesystem::path& path)
+    {
+        TestMesh grid = MakeGridMesh(16, 0.2f);
+        MeshletData meshlets;
+        BuildMeshlets(grid.positions.data(), 12, grid.GetVertexCount(), grid.indices.data(),
+            static_cast<uint32_t>(grid.indices.size()), meshlets);
+
+        MeshFileData data;
+        data.vertices = grid.positions.data();
+        data.vertexStride = 12;
+        data.vertexCount = grid.GetVertexCount();
+        data.indices = grid.indices.data();
+        data.indexSize = 4;
+        data.indexCount = static_cast<uint32_t>(grid.indices.size());
+        MeshBounds bounds = { { 0.5f, 0.0f, 0.5f, 0.75f }, { 0.0f, -0.2f, 0.0f }, 0, { 1.0f, 0.2f, 1.0f }, data.indexCount };
+        data.bounds.push_back(bounds);
+        SetMeshFileMeshlets(data, meshlets);
+        CHECK(WriteMeshFile(path, data));
+
+        MeshFile mesh;
+        std::string error;
+        CHECK(mesh.Open(path, &error));
+        if (!mesh.IsOpen())
+        {
+            return;
+        }
+        const MeshFileHeader& header = mesh.GetHeader();
+        CHECK(header.vertexCount == data.vertexCount && header.indexCount == data.indexCount);
+        CHECK(header.meshletCount == meshlets.meshlets.size());
+        for (int section = 0; section < NumMeshSections; ++section)
+        {
+            CHECK(header.sectionOffsets[section] % c_MeshSectionAlignment == 0);
+        }
+        CHECK(std::memcmp(mesh.GetSection(MeshSectionVertices), grid.positions.data(), grid.positions.size() * 4) == 0);
+        CHECK(std::memcmp(mesh.GetSection(MeshSectionIndices), grid.indices.data(), grid.indices.size() * 4) == 0);
+        CHECK(mesh.GetBounds()[0].indexCount == data.indexCount);
+        CHECK(std::memcmp(mesh.GetMeshlets(), meshlets.meshlets.data(), meshlets.meshlets.size() * sizeof(Meshlet)) == 0);
+        CHECK(mesh.GetSectionSize(MeshSectionMeshletPrimitives) == meshlets.primitives.size() * 4);
+    }
+
+    void TestRejected(const std::filesystem::path& path)
+    {
+        const std::vector<uint8_t> good = ReadFile(path);
+        const std::filesystem::path bad = path.parent_path() / "bad.mesh";
+        CHECK(OpenError(bad, good).empty());
+
+        // Truncated anywhere, including inside the header, or grown.
+        CHECK(OpenError(bad, std::vector<uint8_t>(good.begin(), good.end() - 1)) == "mesh file is truncated");
+        CHECK(OpenError(bad, std::vector<uint8_t>(good.begin(), good.begin() + sizeof(MeshFileHeader) / 2)) ==
+            "mesh file is truncated");
+        CHECK(!OpenError(bad, {}).empty());
+        std::vector<uint8_t> grown = good;
+        grown.push_back(0);
+        CHECK(OpenError(bad, grown) == "mesh file is truncated");
+
+        // Not a mesh file at all.
+        std::vector<uint8_t> text(good.size(), 'x');
+        CHECK(OpenError(bad, text) == "not a mesh file");
+
+        // A flipped bit in the header fails the hash.
+        std::vector<uint8_t> corrupt = good;
+        corrupt[offsetof(MeshFileHeader, vertexCount)] ^= 1;
+        CHECK(OpenError(bad, corrupt) == "mesh file header is corrupt");
+
+        // Another version, even with a valid hash.
+        MeshFileHeader header = GetHeader(good);
+        std::vector<uint8_t> newer = good;
+        header.version = MeshFileHeader::c_Version + 1;
+        SetHeader(newer, header);
+        CHECK(OpenError(bad, newer) == "unsupported mesh file version");
+
+        // Consistent hash, inconsistent contents.
+        header = GetHeader(good);
+        header.indexSize = 3;
+        std::vector<uint8_t> indexSize = good;
+        SetHeader(indexSize, header);
+        CHECK(OpenError(bad, indexSize) == "invalid index size");
+
+        header = GetHeader(good);
+        header.sectionOffsets[MeshSectionMeshlets] = header.fileSize;
+        std::vector<uint8_t> outside = good;
+        SetHeader(outside, header);
+        CHECK(OpenError(bad, outside) == "mesh file section out of range");
+
+        header = GetHeader(good);
+        header.sectionOffsets[MeshSectionIndices] += 4;
+        std::vector<uint8_t> misaligned = good;
+        SetHeader(misaligned, header);
+        CHECK(OpenError(bad, misaligned) == "mesh file section out of range");
+
+        header = GetHeader(good);
+        header.vertexCount += 1;
+        std::vector<uint8_t> count = good;
+        SetHeader(count, header);
+        CHECK(OpenError(bad, count) == "mesh file section out of range");
+
+        std::string error;
+
+        // Offsets near 2^64 must not wrap around the size check.
+        header = GetHeader(good);
+        header.sectionOffsets[MeshSectionBounds] = ~uint64_t(0) - c_MeshSectionAlignment + 1;
+        error.clear();
+        CHECK(!ValidateMeshFileHeader(Rehash(header), header.fileSize, &error));
+        CHECK(error == "mesh file section out of range");
+        header = GetHeader(good);
+        CHECK(ValidateMeshFileHeader(header, header.fileSize, nullptr));
+
+        MeshFile missing;
+        CHECK(!missing.Open(path.parent_path() / "missing.mesh", &error) && error == "cannot open mesh file");
+    }
+}
+
+int main()
+{
+    std::filesystem::path dir = MakeTestDirectory("MeshFile");
+    TestRoundTrip(dir / "grid.mesh");
+    TestRejected(dir / "grid.mesh");
+    return GetTestResult();
+}
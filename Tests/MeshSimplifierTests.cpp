@@ -0,0 +1,190 @@
+#include "Check.h"
+#include "TestMeshes.h"
+
+#include "JobSystem.h"
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    SimplifyInput GetInput(const TestMesh& mesh)
+    {
+        SimplifyInput input;
+        input.vertices = mesh.positions.data();
+        input.vertexStride = 12;
+        input.vertexCount = mesh.GetVertexCount();
+        return input;
+    }
+
+    // Valid indices, no degenerate triangles, and on a sphere around the
+    // origin every triangle still faces outwards.
+    void CheckTriangles(const TestMesh& mesh, const std::vector<uint32_t>& indices, bool sphere)
+    {
+        CHECK(indices.size() % 3 == 0);
+        uint32_t invalid = 0;
+        uint32_t flipped = 0;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+            if (a >= mesh.GetVertexCount() || b >= mesh.GetVertexCount() || c >= mesh.GetVertexCount() || a == b || b == c || a == c)
+            {
+                ++invalid;
+                continue;
+            }
+            const float* pa = &mesh.positions[3 * a];
+            const float* pb = &mesh.positions[3 * b];
+            const float* pc = &mesh.positions[3 * c];
+            float e1[3] = { pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2] };
+            float e2[3] = { pc[0] - pa[0], pc[1] - pa[1], pc[2] - pa[2] };
+            float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+            float outward = sphere ? n[0] * (pa[0] + pb[0] + pc[0]) + n[1] * (pa[1] + pb[1] + pc[1]) + n[2] * (pa[2] + pb[2] + pc[2]) : n[1];
+            flipped += outward <= 0.0f ? 1 : 0;
+        }
+        CHECK(invalid == 0);
+        CHECK(flipped == 0);
+    }
+
+    void TestFlatGrid()
+    {
+        // A plane simplifies down without geometric error, and its border
+        // (the silhouette) keeps all four corners.
+        TestMesh mesh = MakeGridMesh(32);
+        std::vector<uint32_t> result;
+        float error = -1.0f;
+        uint32_t target = static_cast<uint32_t>(mesh.indices.size() / 10) / 3 * 3;
+        uint32_t count = SimplifyMesh(GetInput(mesh), mesh.indices, target, 1e-3f, nullptr, result, &error);
+        CHECK(count == result.size());
+        CHECK(count <= target);
+        CHECK(error >= 0.0f && error < 1e-4f);
+        CheckTriangles(mesh, result, false);
+
+        const uint32_t corners[4] = { 0, 32, 33 * 32, 33 * 33 - 1 };
+        for (uint32_t corner : corners)
+        {
+            CHECK(std::find(result.begin(), result.end(), corner) != result.end());
+        }
+    }
+
+    void TestSphere(JobSystem* jobs)
+    {
+        TestMesh mesh = MakeSphereMesh(24, 48);
+        std::vector<uint32_t> result;
+        float error = 0.0f;
+        uint32_t target = static_cast<uint32_t>(mesh.indices.size() / 4) / 3 * 3;
+        SimplifyMesh(GetInput(mesh), mesh.indices, target, FLT_MAX, jobs, result, &error);
+        CHECK(result.size() <= target);
+        CHECK(error > 0.0f && error < 0.1f);
+        CheckTriangles(mesh, result, true);
+
+        // Both copies of every seam vertex stay, so the UV seam does not tear.
+        uint32_t missing = 0;
+        for (uint32_t ring = 1; ring < 24; ++ring)
+        {
+            for (uint32_t v : { ring * 49, ring * 49 + 48 })
+            {
+                missing += std::find(result.begin(), result.end(), v) == result.end() ? 1 : 0;
+            }
+        }
+        CHECK(missing == 0);
+
+        // A tight error bound stops collapses that would bend the surface.
+        std::vector<uint32_t> bounded;
+        SimplifyMesh(GetInput(mesh), mesh.indices, target, 1e-6f, jobs, bounded, &error);
+        CHECK(bounded.size() > result.size());
+        CHECK(error <= 1e-6f);
+    }
+
+    void TestLargeMeshWithJobs(JobSystem& jobs)
+    {
+        // Enough triangles for the chunked path.
+        TestMesh mesh = MakeSphereMesh(128, 256);
+        std::vector<uint32_t> single;
+        std::vector<uint32_t> parallel;
+        uint32_t target = static_cast<uint32_t>(mesh.indices.size() / 8) / 3 * 3;
+        SimplifyMesh(GetInput(mesh), mesh.indices, target, FLT_MAX, nullptr, single, nullptr);
+        SimplifyMesh(GetInput(mesh), mesh.indices, target, FLT_MAX, &jobs, parallel, nullptr);
+        CHECK(single.size() <= target && parallel.size() <= target);
+        CheckTriangles(mesh, parallel, true);
+    }
+
+    void TestAttributes()
+    {
+        // A hard attribute edge across the grid: high weight keeps more of it.
+        TestMesh mesh = MakeGridMesh(24);
+        std::vector<float> vertices;
+        for (uint32_t i = 0; i < mesh.GetVertexCount(); ++i)
+        {
+            float u = mesh.positions[3 * i];
+            vertices.insert(vertices.end(), { mesh.positions[3 * i], mesh.positions[3 * i + 1], mesh.positions[3 * i + 2], u < 0.5f ? 0.0f : 1.0f });
+        }
+        SimplifyInput input;
+        input.vertices = vertices.data();
+        input.vertexStride = 16;
+        input.vertexCount = mesh.GetVertexCount();
+        input.attributeOffset = 12;
+        input.attributeCount = 1;
+
+        float weight = 100.0f;
+        input.attributeWeights = &weight;
+        std::vector<uint32_t> weighted;
+        SimplifyMesh(input, mesh.indices, 0, 1e-3f, nullptr, weighted, nullptr);
+
+        weight = 0.0f;
+        std::vector<uint32_t> ignored;
+        SimplifyMesh(input, mesh.indices, 0, 1e-3f, nullptr, ignored, nullptr);
+        CHECK(weighted.size() > ignored.size());
+    }
+
+    void TestLodChain(JobSystem* jobs)
+    {
+        TestMesh mesh = MakeSphereMesh(32, 64);
+        std::vector<MeshLod> lods;
+        BuildLodChain(GetInput(mesh), mesh.indices, 5, 0.5f, jobs, lods);
+        CHECK(lods.size() >= 3 && lods.size() <= 5);
+        CHECK(lods[0].indices == mesh.indices && lods[0].error == 0.0f);
+        std::vector<float> errors;
+        for (size_t i = 0; i < lods.size(); ++i)
+        {
+            errors.push_back(lods[i].error);
+            if (i > 0)
+            {
+                CHECK(lods[i].indices.size() < lods[i - 1].indices.size());
+                CHECK(lods[i].error >= lods[i - 1].error);
+            }
+        }
+
+        // Farther instances never get a finer level.
+        float scale = GetLodProjectionScale(1.0f, 1080.0f);
+        CHECK(SelectLod(errors.data(), static_cast<uint32_t>(errors.size()), 0.0f, scale) == 0);
+        CHECK(SelectLod(errors.data(), static_cast<uint32_t>(errors.size()), 1e9f, scale) == errors.size() - 1);
+        std::vector<float> distances;
+        for (float distance = 0.5f; distance < 5000.0f; distance *= 1.5f)
+        {
+            distances.push_back(distance);
+        }
+        std::vector<uint8_t> selected(distances.size());
+        SelectLods(errors.data(), static_cast<uint32_t>(errors.size()), distances.data(), static_cast<uint32_t>(distances.size()),
+            scale, 1.0f, selected.data());
+        CHECK(std::is_sorted(selected.begin(), selected.end()));
+        // A looser pixel budget picks coarser levels.
+        CHECK(SelectLod(errors.data(), static_cast<uint32_t>(errors.size()), 50.0f, scale, 8.0f) >=
+            SelectLod(errors.data(), static_cast<uint32_t>(errors.size()), 50.0f, scale, 1.0f));
+    }
+}
+
+int main()
+{
+    JobSystem jobs(3);
+    TestFlatGrid();
+    TestSphere(nullptr);
+    TestSphere(&jobs);
+    TestLargeMeshWithJobs(jobs);
+    TestAttributes();
+    TestLodChain(nullptr);
+    TestLodChain(&jobs);
+    return GetTestResult();
+}
@@ -0,0 +1,182 @@
+#include "Check.h"
+#include "TestMeshes.h"
+
+#include "MeshletBuilder.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+    using Triangle = std::array<uint32_t, 3>;
+
+    // Rotated so the smallest index comes first; keeps the winding.
+    Triangle Canonical(uint32_t a, uint32_t b, uint32_t c)
+    {
+        if (b < a && b < c)
+        {
+            return { b, c, a };
+        }
+        if (c < a && c < b)
+        {
+            return { c, a, b };
+        }
+        return { a, b, c };
+    }
+
+    const float* GetPosition(const TestMesh& mesh, uint32_t index)
+    {
+        return &mesh.positions[3 * index];
+    }
+
+    // Structure, limits and coverage: every input triangle in exactly one
+    // meshlet, with its winding.
+    void CheckMeshlets(const TestMesh& mesh, const MeshletData& data, uint32_t maxVertices, uint32_t maxTriangles)
+    {
+        std::vector<Triangle> expected;
+        for (uint32_t t = 0; t < mesh.GetTriangleCount(); ++t)
+        {
+            expected.push_back(Canonical(mesh.indices[3 * t], mesh.indices[3 * t + 1], mesh.indices[3 * t + 2]));
+        }
+
+        std::vector<Triangle> found;
+        uint32_t vertexOffset = 0;
+        uint32_t primitiveOffset = 0;
+        uint32_t outsideSphere = 0;
+        for (const Meshlet& meshlet : data.meshlets)
+        {
+            CHECK(meshlet.vertexCount > 0 && meshlet.vertexCount <= maxVertices);
+            CHECK(meshlet.primitiveCount > 0 && meshlet.primitiveCount <= maxTriangles);
+            CHECK(meshlet.vertexOffset == vertexOffset && meshlet.primitiveOffset == primitiveOffset);
+            vertexOffset += meshlet.vertexCount;
+            primitiveOffset += meshlet.primitiveCount;
+            if (vertexOffset > data.vertices.size() || primitiveOffset > data.primitives.size())
+            {
+                CHECK(false);
+                return;
+            }
+
+            for (uint32_t p = 0; p < meshlet.primitiveCount; ++p)
+            {
+                uint32_t packed = data.primitives[meshlet.primitiveOffset + p];
+                uint32_t local[3] = { packed & 0x3ff, (packed >> 10) & 0x3ff, (packed >> 20) & 0x3ff };
+                bool inRange = local[0] < meshlet.vertexCount && local[1] < meshlet.vertexCount && local[2] < meshlet.vertexCount;
+                CHECK(inRange);
+                if (inRange)
+                {
+                    const uint32_t* vertices = &data.vertices[meshlet.vertexOffset];
+                    found.push_back(Canonical(vertices[local[0]], vertices[local[1]], vertices[local[2]]));
+                }
+            }
+
+            for (uint32_t v = 0; v < meshlet.vertexCount; ++v)
+            {
+                const float* p = GetPosition(mesh, data.vertices[meshlet.vertexOffset + v]);
+                float dx = p[0] - meshlet.sphere[0], dy = p[1] - meshlet.sphere[1], dz = p[2] - meshlet.sphere[2];
+                outsideSphere += std::sqrt(dx * dx + dy * dy + dz * dz) > meshlet.sphere[3] * 1.0001f + 1e-5f ? 1 : 0;
+            }
+        }
+        CHECK(vertexOffset == data.vertices.size() && primitiveOffset == data.primitives.size());
+        CHECK(outsideSphere == 0);
+
+        std::sort(expected.begin(), expected.end());
+        std::sort(found.begin(), found.end());
+        CHECK(found == expected);
+    }
+
+    // A camera the cone test calls back-facing must not see any triangle of
+    // the meshlet from the front.
+    void CheckCones(const TestMesh& mesh, const MeshletData& data)
+    {
+        std::mt19937 random(11);
+        std::uniform_real_distribution<float> coordinate(-4.0f, 4.0f);
+        uint32_t culled = 0;
+        uint32_t wrong = 0;
+        for (uint32_t sample = 0; sample < 200; ++sample)
+        {
+            float camera[3] = { coordinate(random), coordinate(random), coordinate(random) };
+            for (const Meshlet& meshlet : data.meshlets)
+            {
+                float v[3] = { meshlet.sphere[0] - camera[0], meshlet.sphere[1] - camera[1], meshlet.sphere[2] - camera[2] };
+                float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+                float along = v[0] * meshlet.coneAxis[0] + v[1] * meshlet.coneAxis[1] + v[2] * meshlet.coneAxis[2];
+                if (along < meshlet.coneCutoff * length + meshlet.sphere[3])
+                {
+                    continue;
+                }
+                ++culled;
+
+                for (uint32_t p = 0; p < meshlet.primitiveCount; ++p)
+                {
+                    uint32_t packed = data.primitives[meshlet.primitiveOffset + p];
+                    const uint32_t* vertices = &data.vertices[meshlet.vertexOffset];
+                    const float* a = GetPosition(mesh, vertices[packed & 0x3ff]);
+                    const float* b = GetPosition(mesh, vertices[(packed >> 10) & 0x3ff]);
+                    const float* c = GetPosition(mesh, vertices[(packed >> 20) & 0x3ff]);
+                    float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+                    float e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+                    float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+                    float facing = n[0] * (camera[0] - a[0]) + n[1] * (camera[1] - a[1]) + n[2] * (camera[2] - a[2]);
+                    wrong += facing > 1e-6f ? 1 : 0;
+                }
+            }
+        }
+        CHECK(culled > 0);
+        CHECK(wrong == 0);
+    }
+
+    void TestSphere()
+    {
+        TestMesh mesh = MakeSphereMesh(40, 80);
+        MeshletData data;
+        BuildMeshlets(mesh.positions.data(), 12, mesh.GetVertexCount(), mesh.indices.data(),
+            static_cast<uint32_t>(mesh.indices.size()), data);
+        CHECK(!data.meshlets.empty());
+        CheckMeshlets(mesh, data, c_MeshletMaxVertices, c_MeshletMaxTriangles);
+        CheckCones(mesh, data);
+
+        // Compact meshlets: on a regular grid each vertex is shared by about
+        // six triangles, so a full meshlet needs far fewer than 3 vertices per
+        // triangle.
+        float vertexPerTriangle = static_cast<float>(data.vertices.size()) / data.primitives.size();
+        CHECK(vertexPerTriangle < 1.0f);
+    }
+
+    void TestSmallLimits()
+    {
+        TestMesh mesh = MakeGridMesh(30, 0.2f);
+        MeshletData data;
+        BuildMeshlets(mesh.positions.data(), 12, mesh.GetVertexCount(), mesh.indices.data(),
+            static_cast<uint32_t>(mesh.indices.size()), data, 16, 10);
+        CheckMeshlets(mesh, data, 16, 10);
+    }
+
+    void TestStrideAndEmpty()
+    {
+        // Positions inside a larger vertex.
+        TestMesh mesh = MakeGridMesh(8);
+        std::vector<float> vertices;
+        for (uint32_t i = 0; i < mesh.GetVertexCount(); ++i)
+        {
+            vertices.insert(vertices.end(), { mesh.positions[3 * i], mesh.positions[3 * i + 1], mesh.positions[3 * i + 2], 0.0f, 1.0f });
+        }
+        MeshletData data;
+        BuildMeshlets(vertices.data(), 20, mesh.GetVertexCount(), mesh.indices.data(), static_cast<uint32_t>(mesh.indices.size()), data);
+        CheckMeshlets(mesh, data, c_MeshletMaxVertices, c_MeshletMaxTriangles);
+
+        MeshletData empty;
+        BuildMeshlets(vertices.data(), 20, mesh.GetVertexCount(), nullptr, 0, empty);
+        CHECK(empty.meshlets.empty() && empty.vertices.empty() && empty.primitives.empty());
+    }
+}
+
+int main()
+{
+    TestSphere();
+    TestSmallLimits();
+    TestStrideAndEmpty();
+    return GetTestResult();
+}
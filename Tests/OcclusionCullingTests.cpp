@@ -0,0 +1,141 @@
+#include "Check.h"
+
+#include "FrustumCulling.h"
+#include "JobSystem.h"
+#include "OcclusionCulling.h"
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    // Looking down +z from the origin, 90 degree field of view, near 1,
+    // far 1000 (DirectXMath row-vector convention).
+    void MakeCamera(float viewProjection[4][4])
+    {
+        const float n = 1.0f;
+        const float f = 1000.0f;
+        const float matrix[4][4] = {
+            { 1, 0, 0, 0 },
+            { 0, 1, 0, 0 },
+            { 0, 0, f / (f - n), 1 },
+            { 0, 0, -n * f / (f - n), 0 },
+        };
+        memcpy(viewProjection, matrix, sizeof(matrix));
+    }
+
+    // A square in the plane z = depth.
+    void AddWall(OcclusionBuffer& buffer, float depth, float minX, float minY, float maxX, float maxY)
+    {
+        const float positions[4][3] = {
+            { minX, minY, depth }, { maxX, minY, depth }, { maxX, maxY, depth }, { minX, maxY, depth },
+        };
+        const uint32_t indices[6] = { 0, 1, 2, 0, 2, 3 };
+        buffer.AddOccluder(positions, sizeof(positions[0]), indices, 6);
+    }
+
+    bool IsVisible(const OcclusionBuffer& buffer, float x, float y, float z, float halfSize)
+    {
+        const float boxMin[3] = { x - halfSize, y - halfSize, z - halfSize };
+        const float boxMax[3] = { x + halfSize, y + halfSize, z + halfSize };
+        return buffer.IsBoxVisible(boxMin, boxMax);
+    }
+
+    void TestEmptyBuffer()
+    {
+        float viewProjection[4][4];
+        MakeCamera(viewProjection);
+        OcclusionBuffer buffer(100, 50);
+        CHECK(buffer.GetWidth() == 128 && buffer.GetHeight() == 64);
+
+        buffer.Begin(viewProjection);
+        buffer.Rasterize(nullptr);
+        CHECK(IsVisible(buffer, 0.0f, 0.0f, 100.0f, 1.0f));
+        // Off screen, beyond the far plane, or crossing the near plane.
+        CHECK(!IsVisible(buffer, 500.0f, 0.0f, 100.0f, 1.0f));
+        CHECK(!IsVisible(buffer, 0.0f, 0.0f, 2000.0f, 1.0f));
+        CHECK(IsVisible(buffer, 0.0f, 0.0f, 0.0f, 2.0f));
+    }
+
+    void TestWall(JobSystem* jobs)
+    {
+        float viewProjection[4][4];
+        MakeCamera(viewProjection);
+        OcclusionBuffer buffer;
+        buffer.Begin(viewProjection);
+        // Covers the left half of the screen at z = 10.
+        AddWall(buffer, 10.0f, -20.0f, -20.0f, 0.0f, 20.0f);
+        buffer.Rasterize(jobs);
+
+        CHECK(!IsVisible(buffer, -5.0f, 0.0f, 50.0f, 1.0f));      // behind the wall
+        CHECK(IsVisible(buffer, -2.0f, 0.0f, 5.0f, 1.0f));        // in front of it
+        CHECK(IsVisible(buffer, 5.0f, 0.0f, 50.0f, 1.0f));        // behind, but in the open half
+        CHECK(IsVisible(buffer, 0.0f, 0.0f, 50.0f, 2.0f));        // straddles the wall's edge
+        CHECK(IsVisible(buffer, -5.0f, 0.0f, 10.0f, 1.0f));       // intersects the wall
+
+        // A second frame starts from an empty buffer.
+        buffer.Begin(viewProjection);
+        buffer.Rasterize(jobs);
+        CHECK(IsVisible(buffer, -5.0f, 0.0f, 50.0f, 1.0f));
+    }
+
+    void TestRasterizeWithJobsMatches(JobSystem& jobs)
+    {
+        float viewProjection[4][4];
+        MakeCamera(viewProjection);
+        OcclusionBuffer single;
+        OcclusionBuffer parallel;
+        for (OcclusionBuffer* buffer : { &single, &parallel })
+        {
+            buffer->Begin(viewProjection);
+            AddWall(*buffer, 10.0f, -20.0f, -20.0f, 0.0f, 20.0f);
+            AddWall(*buffer, 30.0f, -5.0f, -30.0f, 40.0f, 3.0f);
+            AddWall(*buffer, 12.0f, 2.0f, 2.0f, 6.0f, 7.0f);
+        }
+        single.Rasterize(nullptr);
+        parallel.Rasterize(&jobs);
+        CHECK(memcmp(single.GetDepth(), parallel.GetDepth(), sizeof(float) * single.GetWidth() * single.GetHeight()) == 0);
+    }
+
+    void TestFilterVisible(JobSystem* jobs)
+    {
+        float viewProjection[4][4];
+        MakeCamera(viewProjection);
+        OcclusionBuffer buffer;
+        buffer.Begin(viewProjection);
+        AddWall(buffer, 10.0f, -20.0f, -20.0f, 0.0f, 20.0f);
+        buffer.Rasterize(jobs);
+
+        // Alternating hidden and visible boxes, many enough for several jobs.
+        CullingScene scene;
+        std::vector<uint32_t> visible;
+        std::vector<uint32_t> expected;
+        for (uint32_t i = 0; i < 5000; ++i)
+        {
+            float x = (i % 2) ? 5.0f : -5.0f;
+            float center[3] = { x, 0.0f, 50.0f + (i % 100) };
+            float boxMin[3] = { x - 1.0f, -1.0f, center[2] - 1.0f };
+            float boxMax[3] = { x + 1.0f, 1.0f, center[2] + 1.0f };
+            scene.Add(center, 1.8f, boxMin, boxMax);
+            visible.push_back(i);
+            if (i % 2)
+            {
+                expected.push_back(i);
+            }
+        }
+        buffer.FilterVisible(scene, visible, jobs);
+        CHECK(visible == expected);
+    }
+}
+
+int main()
+{
+    JobSystem jobs(3);
+    TestEmptyBuffer();
+    TestWall(nullptr);
+    TestWall(&jobs);
+    TestRasterizeWithJobsMatches(jobs);
+    TestFilterVisible(nullptr);
+    TestFilterVisible(&jobs);
+    return GetTestResult();
+}
@@ -0,0 +1,109 @@
+#include "Check.h"
+
+#include "BackgroundPass.h"
+#include "RenderCapture.h"
+#include "RenderInterface.h"
+
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    const uint32_t c_RenderTarget = 1;
+    const uint32_t c_RootSignature = 2;
+    const uint32_t c_Pipeline = 3;
+    const uint32_t c_ConstantsIndex = 0;
+    const uint32_t c_Width = 320;
+    const uint32_t c_Height = 180;
+    const uint32_t c_FormatR8G8B8A8Unorm = 28;     // DXGI_FORMAT_R8G8B8A8_UNORM
+
+    // NullRenderInterface only checks that blobs are not empty.
+    const std::vector<uint8_t> c_Blob = { 1, 2, 3, 4 };
+
+    void CreatePipeline(RenderInterface& render)
+    {
+        render.CreateRootSignature(c_RootSignature, c_Blob.data(), c_Blob.size());
+        render.CreatePipeline(c_Pipeline, c_RootSignature, c_Blob.data(), c_Blob.size());
+    }
+
+    // One frame the way WinMain records it.
+    void RecordFrame(RenderInterface& render)
+    {
+        const float view[4][4] = { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 }, { 0, 0, 0, 1 } };
+        const float clearColor[4] = { 0.2f, 0.8f, 0.8f, 1.0f };
+        render.BeginFrame();
+        render.Barrier(c_RenderTarget, c_RenderStatePresent, c_RenderStateRenderTarget);
+        render.ClearRenderTarget(c_RenderTarget, clearColor);
+        RecordBackgroundPass(render, c_Pipeline, c_RenderTarget, c_Width, c_Height, c_ConstantsIndex,
+            GetBackgroundConstants(view, 1.0f, c_Width, c_Height));
+        render.Barrier(c_RenderTarget, c_RenderStateRenderTarget, c_RenderStatePresent);
+        render.EndFrame();
+    }
+
+    void TestBackgroundConstants()
+    {
+        // Looking down +z with a 90 degree vertical field of view.
+        const float view[4][4] = { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 }, { 0, 0, 0, 1 } };
+        BackgroundConstants constants = GetBackgroundConstants(view, 2.0f * std::atan(1.0f), 200, 100);
+        CHECK(std::fabs(constants.cameraRight[0] - 2.0f) < 1e-5f && constants.cameraRight[1] == 0.0f && constants.cameraRight[2] == 0.0f);
+        CHECK(std::fabs(constants.cameraUp[1] - 1.0f) < 1e-5f && constants.cameraUp[0] == 0.0f && constants.cameraUp[2] == 0.0f);
+        CHECK(constants.cameraForward[0] == 0.0f && constants.cameraForward[1] == 0.0f && constants.cameraForward[2] == 1.0f);
+        CHECK(constants.inverseViewportWidth == 1.0f / 200 && constants.inverseViewportHeight == 1.0f / 100);
+
+        // The axes are the columns of the view matrix: a camera turned 90
+        // degrees to the right looks down +x.
+        const float turned[4][4] = { { 0, 0, 1, 0 }, { 0, 1, 0, 0 }, { -1, 0, 0, 0 }, { 0, 0, 0, 1 } };
+        constants = GetBackgroundConstants(turned, 2.0f * std::atan(1.0f), 100, 100);
+        CHECK(constants.cameraForward[0] == 1.0f && constants.cameraForward[2] == 0.0f);
+        CHECK(std::fabs(constants.cameraRight[2] + 1.0f) < 1e-5f && constants.cameraRight[0] == 0.0f);
+    }
+
+    void TestReplay(const std::filesystem::path& path)
+    {
+        NullRenderInterface device;
+        RenderCapture capture(device);
+        RenderTextureDesc desc = { c_Width, c_Height, 1, 1, c_FormatR8G8B8A8Unorm, c_RenderResourceRenderTarget };
+        capture.ImportTexture(c_RenderTarget, desc, nullptr);
+        CreatePipeline(capture);
+
+        // The first frame uses objects created before the capture started;
+        // the second recreates the pipeline the way a hot reload does.
+        CHECK(capture.Start(path, 2));
+        CHECK(capture.IsCapturing());
+        RecordFrame(capture);
+        CreatePipeline(capture);
+        RecordFrame(capture);
+        CHECK(!capture.IsCapturing());
+        CHECK(capture.GetLastError().empty());
+        CHECK(device.GetStats().errors == 0 && device.GetStats().draws == 2);
+
+        RenderCaptureReplayer replayer;
+        std::string error;
+        CHECK(replayer.Open(path, &error));
+        CHECK(replayer.GetFrameCount() == 2);
+
+        NullRenderInterface replay;
+        CHECK(replayer.ReplaySetup(replay, &error));
+        for (uint32_t frame = 0; frame < replayer.GetFrameCount(); ++frame)
+        {
+            CHECK(replayer.ReplayFrame(frame, replay, &error));
+        }
+        CHECK(replay.GetStats().errors == 0);
+        CHECK(replay.GetFirstError().empty());
+        CHECK(replay.GetStats().frames == 2 + 1);
+        CHECK(replay.GetStats().draws == 2);
+
+        // Without the setup the frame refers to objects that do not exist.
+        NullRenderInterface empty;
+        replayer.ReplayFrame(0, empty, &error);
+        CHECK(empty.GetStats().errors != 0);
+    }
+}
+
+int main()
+{
+    std::filesystem::path dir = MakeTestDirectory("RenderCapture");
+    TestBackgroundConstants();
+    TestReplay(dir / "background.rcap");
+    return GetTestResult();
+}
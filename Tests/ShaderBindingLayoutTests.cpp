@@ -0,0 +1,312 @@
+#include "Check.h"
+
+#include "ShaderBindingLayout.h"
+
+#include <vector>
+
+namespace
+{
+    ShaderBinding MakeBinding(const char* name, ShaderBindingType type, uint32_t bindPoint, uint8_t stages,
+        uint32_t bindCount = 1, uint32_t size = 0)
+    {
+        ShaderBinding binding;
+        binding.name = name;
+        binding.type = type;
+        binding.bindPoint = bindPoint;
+        binding.bindCount = bindCount;
+        binding.size = size;
+        binding.stages = stages;
+        return binding;
+    }
+
+    const ShaderRootParameter* FindTable(const ShaderBindingLayout& layout, uint8_t stages, bool samplers)
+    {
+        for (const auto& parameter : layout.GetParameters())
+        {
+            if (parameter.kind == ShaderRootParameter::Kind::DescriptorTable && parameter.stages == stages &&
+                !parameter.ranges.empty() && (parameter.ranges[0].type == ShaderBindingType::Sampler) == samplers)
+            {
+                return &parameter;
+            }
+        }
+        return nullptr;
+    }
+
+    void TestMergeStages()
+    {
+        using Type = ShaderBindingType;
+        std::vector<ShaderBinding> vertex = {
+            MakeBinding("Frame", Type::ConstantBuffer, 0, ShaderStageVertex, 1, 64),
+            MakeBinding("Instances", Type::ShaderResource, 0, ShaderStageVertex),
+        };
+        std::vector<ShaderBinding> pixel = {
+            MakeBinding("Frame", Type::ConstantBuffer, 0, ShaderStagePixel, 1, 80),
+            MakeBinding("Albedo", Type::ShaderResource, 1, ShaderStagePixel, 4),
+            MakeBinding("Linear", Type::Sampler, 0, ShaderStagePixel),
+        };
+        // Same register in another space is a different binding.
+        pixel.push_back(MakeBinding("Other", Type::ShaderResource, 0, ShaderStagePixel));
+        pixel.back().space = 1;
+
+        auto merged = ShaderBindingLayout::MergeStages({ vertex, pixel });
+        CHECK(merged.size() == 5);
+        CHECK(merged[0].name == "Frame");
+        CHECK(merged[0].stages == (ShaderStageVertex | ShaderStagePixel));
+        CHECK(merged[0].size == 80);
+        CHECK(merged[1].stages == ShaderStageVertex);
+        CHECK(merged[2].bindCount == 4 && merged[2].stages == ShaderStagePixel);
+        CHECK(merged[4].space == 1 && merged[4].stages == ShaderStagePixel);
+
+        // The larger array size wins, unbounded included.
+        auto arrays = ShaderBindingLayout::MergeStages({
+            { MakeBinding("Textures", Type::ShaderResource, 0, ShaderStageVertex, 2) },
+            { MakeBinding("Textures", Type::ShaderResource, 0, ShaderStagePixel, c_ShaderBindingUnbounded) },
+        });
+        CHECK(arrays.size() == 1 && arrays[0].bindCount == c_ShaderBindingUnbounded);
+    }
+
+    void TestVisibility()
+    {
+        using Type = ShaderBindingType;
+        const uint8_t both = ShaderStageVertex | ShaderStagePixel;
+        std::vector<ShaderBinding> bindings = {
+            MakeBinding("Instances", Type::ShaderResource, 0, ShaderStageVertex),
+            MakeBinding("Shadow", Type::ShaderResource, 3, both),
+            MakeBinding("Albedo", Type::ShaderResource, 1, ShaderStagePixel),
+            MakeBinding("Normal", Type::ShaderResource, 2, ShaderStagePixel),
+            MakeBinding("Linear", Type::Sampler, 0, ShaderStagePixel),
+            MakeBinding("Point", Type::Sampler, 1, ShaderStagePixel),
+        };
+        auto layout = ShaderBindingLayout::Build(bindings);
+        CHECK(layout.GetStages() == both);
+        CHECK(layout.GetParameters().size() == 4);
+        CHECK(layout.GetCostInDwords() == 4);
+
+        // One table per visibility, samplers apart from resources.
+        const auto* vertex = FindTable(layout, ShaderStageVertex, false);
+        const auto* pixel = FindTable(layout, ShaderStagePixel, false);
+        const auto* shared = FindTable(layout, both, false);
+        const auto* samplers = FindTable(layout, ShaderStagePixel, true);
+        CHECK(vertex && pixel && shared && samplers);
+        if (!vertex || !pixel || !shared || !samplers)
+        {
+            return;
+        }
+        CHECK(vertex->ranges.size() == 1 && vertex->tableSize == 1);
+        CHECK(shared->ranges.size() == 1 && shared->ranges[0].baseRegister == 3);
+
+        // Neighbouring registers collapse into one range.
+        CHECK(pixel->ranges.size() == 1);
+        CHECK(pixel->ranges[0].baseRegister == 1 && pixel->ranges[0].count == 2);
+        CHECK(pixel->tableSize == 2);
+        CHECK(samplers->ranges.size() == 1 && samplers->ranges[0].count == 2);
+
+        const auto* normal = layout.Find("Normal");
+        CHECK(normal && normal->tableOffset == 1);
+        CHECK(normal && &layout.GetParameters()[normal->rootIndex] == pixel);
+        CHECK(!layout.Find("Missing"));
+    }
+
+    void TestRanges()
+    {
+        using Type = ShaderBindingType;
+        std::vector<ShaderBinding> bindings = {
+            MakeBinding("A", Type::ShaderResource, 0, ShaderStageCompute, 2),
+            MakeBinding("Output", Type::UnorderedAccess, 0, ShaderStageCompute),
+            MakeBinding("B", Type::ShaderResource, 5, ShaderStageCompute),
+            MakeBinding("C", Type::ShaderResource, 2, ShaderStageCompute),
+        };
+        auto layout = ShaderBindingLayout::Build(bindings);
+        CHECK(layout.GetParameters().size() == 1);
+        const auto& table = layout.GetParameters()[0];
+
+        // t0-t2 are one range, t5 a second one, u0 a third.
+        CHECK(table.ranges.size() == 3);
+        CHECK(table.ranges[0].type == Type::ShaderResource && table.ranges[0].count == 3);
+        CHECK(table.ranges[1].baseRegister == 5 && table.ranges[1].tableOffset == 3);
+        CHECK(table.ranges[2].type == Type::UnorderedAccess && table.ranges[2].tableOffset == 4);
+        CHECK(table.tableSize == 5);
+        CHECK(layout.Find("C")->tableOffset == 2);
+        CHECK(layout.Find("Output")->tableOffset == 4);
+    }
+
+    void TestRootConstants()
+    {
+        using Type = ShaderBindingType;
+        std::vector<ShaderBinding> bindings = {
+            MakeBinding("Large", Type::ConstantBuffer, 0, ShaderStageVertex, 1, 256),
+            MakeBinding("Draw", Type::ConstantBuffer, 1, ShaderStageVertex, 1, 8),
+            MakeBinding("Material", Type::ConstantBuffer, 2, ShaderStagePixel, 1, 48),
+        };
+        auto layout = ShaderBindingLayout::Build(bindings);
+        const auto& parameters = layout.GetParameters();
+        CHECK(parameters.size() == 3);
+
+        // Smallest first; a buffer over the size limit goes in a table.
+        CHECK(parameters[0].kind == ShaderRootParameter::Kind::Constants);
+        CHECK(parameters[0].shaderRegister == 1 && parameters[0].num32BitValues == 2);
+        CHECK(parameters[1].kind == ShaderRootParameter::Kind::Constants);
+        CHECK(parameters[1].shaderRegister == 2 && parameters[1].stages == ShaderStagePixel);
+        CHECK(parameters[2].kind == ShaderRootParameter::Kind::DescriptorTable);
+        CHECK(parameters[2].ranges[0].type == Type::ConstantBuffer);
+        CHECK(layout.Find("Draw")->rootIndex == 0);
+        CHECK(layout.GetCostInDwords() == 2 + 12 + 1);
+
+        // Over budget the rest fall back to tables, leaving room for them.
+        ShaderLayoutPolicy policy;
+        policy.rootSignatureDwords = 12;
+        auto tight = ShaderBindingLayout::Build(bindings, policy);
+        CHECK(tight.GetParameters()[0].kind == ShaderRootParameter::Kind::Constants);
+        CHECK(tight.GetParameters()[1].kind == ShaderRootParameter::Kind::DescriptorTable);
+        CHECK(tight.GetCostInDwords() <= policy.rootSignatureDwords);
+    }
+
+    void TestRootDescriptors()
+    {
+        using Type = ShaderBindingType;
+        std::vector<ShaderBinding> bindings = {
+            MakeBinding("View", Type::ConstantBuffer, 0, ShaderStageMesh, 1, 176),
+            MakeBinding("Draw", Type::ConstantBuffer, 1, ShaderStageMesh, 1, 8),
+            MakeBinding("Meshlets", Type::ShaderResource, 1, ShaderStageMesh),
+            MakeBinding("Vertices", Type::ShaderResource, 0, ShaderStageMesh),
+            MakeBinding("Output", Type::UnorderedAccess, 0, ShaderStageMesh),
+            MakeBinding("Albedo", Type::ShaderResource, 2, ShaderStagePixel),
+            MakeBinding("Linear", Type::Sampler, 0, ShaderStagePixel),
+        };
+        for (int i = 0; i < 5; ++i)
+        {
+            bindings[i].buffer = true;
+        }
+
+        // Off by default.
+        auto tables = ShaderBindingLayout::Build(bindings);
+        for (const auto& parameter : tables.GetParameters())
+        {
+            CHECK(parameter.kind != ShaderRootParameter::Kind::Descriptor);
+        }
+
+        // Constants first, then the buffers in type and register order; the
+        // texture and the sampler stay in tables.
+        ShaderLayoutPolicy policy;
+        policy.rootDescriptors = true;
+        auto layout = ShaderBindingLayout::Build(bindings, policy);
+        const auto& parameters = layout.GetParameters();
+        CHECK(parameters.size() == 7);
+        CHECK(parameters[0].kind == ShaderRootParameter::Kind::Constants && parameters[0].shaderRegister == 1);
+        const char* descriptors[] = { "View", "Vertices", "Meshlets", "Output" };
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            const auto* location = layout.Find(descriptors[i]);
+            CHECK(location && location->rootIndex == i + 1);
+            CHECK(parameters[i + 1].kind == ShaderRootParameter::Kind::Descriptor);
+        }
+        CHECK(parameters[1].descriptorType == Type::ConstantBuffer && parameters[1].shaderRegister == 0);
+        CHECK(parameters[3].descriptorType == Type::ShaderResource && parameters[3].shaderRegister == 1);
+        CHECK(parameters[4].descriptorType == Type::UnorderedAccess && parameters[4].stages == ShaderStageMesh);
+        CHECK(FindTable(layout, ShaderStagePixel, false) && FindTable(layout, ShaderStagePixel, true));
+        CHECK(layout.GetCostInDwords() == 2 + 4 * 2 + 2);
+
+        // The rest go to tables when the budget runs out.
+        policy.rootSignatureDwords = 8;
+        auto tight = ShaderBindingLayout::Build(bindings, policy);
+        CHECK(tight.GetCostInDwords() <= policy.rootSignatureDwords);
+        CHECK(tight.GetParameters()[1].kind == ShaderRootParameter::Kind::Descriptor);
+        CHECK(tight.GetParameters()[2].kind == ShaderRootParameter::Kind::DescriptorTable);
+    }
+
+    void TestUnbounded()
+    {
+        using Type = ShaderBindingType;
+        std::vector<ShaderBinding> bindings = {
+            MakeBinding("Textures", Type::ShaderResource, 0, ShaderStagePixel, c_ShaderBindingUnbounded),
+            MakeBinding("Cubes", Type::ShaderResource, 0, ShaderStagePixel, c_ShaderBindingUnbounded),
+            MakeBinding("Albedo", Type::ShaderResource, 0, ShaderStagePixel),
+            MakeBinding("Large", Type::ConstantBuffer, 0, ShaderStagePixel, 1, 256),
+        };
+        bindings[1].space = 1;
+        bindings[2].space = 2;
+
+        // Each unbounded array gets a table of its own; the bounded bindings
+        // share one.
+        auto layout = ShaderBindingLayout::Build(bindings);
+        const auto& parameters = layout.GetParameters();
+        CHECK(parameters.size() == 3);
+        uint32_t unbounded = 0;
+        for (const auto& parameter : parameters)
+        {
+            CHECK(parameter.kind == ShaderRootParameter::Kind::DescriptorTable);
+            if (parameter.tableSize == c_ShaderBindingUnbounded)
+            {
+                ++unbounded;
+                CHECK(parameter.ranges.size() == 1);
+                CHECK(parameter.ranges[0].count == c_ShaderBindingUnbounded);
+                CHECK(parameter.ranges[0].tableOffset == 0);
+            }
+            else
+            {
+                CHECK(parameter.ranges.size() == 2 && parameter.tableSize == 2);
+            }
+        }
+        CHECK(unbounded == 2);
+        CHECK(layout.Find("Textures")->rootIndex != layout.Find("Cubes")->rootIndex);
+        CHECK(layout.Find("Textures")->tableOffset == 0);
+
+        // An unbounded constant buffer array never becomes root constants.
+        auto constants = ShaderBindingLayout::Build({
+            MakeBinding("Buffers", Type::ConstantBuffer, 0, ShaderStagePixel, c_ShaderBindingUnbounded, 16) });
+        CHECK(constants.GetParameters().size() == 1);
+        CHECK(constants.GetParameters()[0].kind == ShaderRootParameter::Kind::DescriptorTable);
+    }
+
+    void TestSerialize()
+    {
+        using Type = ShaderBindingType;
+        std::vector<ShaderBinding> bindings = {
+            MakeBinding("Draw", Type::ConstantBuffer, 1, ShaderStageVertex | ShaderStagePixel, 1, 16),
+            MakeBinding("Albedo", Type::ShaderResource, 1, ShaderStagePixel, 2),
+            MakeBinding("Textures", Type::ShaderResource, 8, ShaderStagePixel, c_ShaderBindingUnbounded),
+            MakeBinding("Linear", Type::Sampler, 0, ShaderStagePixel),
+            MakeBinding("Instances", Type::ShaderResource, 0, ShaderStageVertex),
+        };
+        bindings.back().buffer = true;
+        ShaderLayoutPolicy policy;
+        policy.rootDescriptors = true;
+        auto layout = ShaderBindingLayout::Build(bindings, policy);
+        auto data = layout.Serialize();
+
+        ShaderBindingLayout loaded;
+        CHECK(loaded.Deserialize(data));
+        CHECK(loaded.Serialize() == data);
+        CHECK(loaded.GetStages() == layout.GetStages());
+        CHECK(loaded.GetParameters().size() == layout.GetParameters().size());
+        CHECK(loaded.Find("Textures") && loaded.Find("Textures")->rootIndex == layout.Find("Textures")->rootIndex);
+        const auto* instances = loaded.Find("Instances");
+        CHECK(instances && loaded.GetParameters()[instances->rootIndex].descriptorType == Type::ShaderResource);
+
+        // Truncated, extended or from another version: rejected, and the
+        // layout is left as it was.
+        auto truncated = data;
+        truncated.pop_back();
+        CHECK(!loaded.Deserialize(truncated));
+        auto extended = data;
+        extended.push_back(0);
+        CHECK(!loaded.Deserialize(extended));
+        auto otherVersion = data;
+        otherVersion[0] ^= 0xff;
+        CHECK(!loaded.Deserialize(otherVersion));
+        CHECK(!loaded.Deserialize({}));
+        CHECK(loaded.Serialize() == data);
+    }
+}
+
+int main()
+{
+    TestMergeStages();
+    TestVisibility();
+    TestRanges();
+    TestRootConstants();
+    TestRootDescriptors();
+    TestUnbounded();
+    TestSerialize();
+    return GetTestResult();
+}
@@ -0,0 +1,231 @@
+#include "Check.h"
+
+#include "Hash.h"
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include "ShaderCache.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Returns the source as bytecode, so cached results can be told apart.
+    class EchoCompiler : public ShaderCompiler
+    {
+    public:
+        std::string GetVersion() const override { return "echo 1"; }
+
+        bool Compile(const ShaderDesc&, const std::string& source, std::vector<uint8_t>& bytecode, std::string&) override
+        {
+            bytecode.assign(source.begin(), source.end());
+            return true;
+        }
+    };
+
+    std::vector<uint8_t> ReadBytes(const std::filesystem::path& path)
+    {
+        MappedFile file;
+        if (!file.Open(path))
+        {
+            return {};
+        }
+        return std::vector<uint8_t>(file.GetData(), file.GetData() + file.GetSize());
+    }
+
+    void TestComputeKey()
+    {
+        std::filesystem::path dir = MakeTestDirectory("ShaderCacheKey");
+        std::filesystem::create_directories(dir / "include");
+        WriteTextFile(dir / "main.hlsl", "#include \"common.hlsli\"\n#include <shared.hlsli>\nfloat4 main() : SV_Target { return 0; }\n");
+        WriteTextFile(dir / "common.hlsli", "#define COMMON 1\n");
+        WriteTextFile(dir / "include" / "shared.hlsli", "#define SHARED 1\n");
+
+        ShaderDesc desc;
+        desc.path = dir / "main.hlsl";
+        desc.target = "ps_5_1";
+        desc.includeDirs = { dir / "include" };
+        desc.defines = { { "A", "1" }, { "B", "2" } };
+
+        std::vector<std::filesystem::path> dependencies;
+        uint64_t key = ShaderCache::ComputeKey(desc, "v1", nullptr, &dependencies);
+        CHECK(key != 0);
+        CHECK(ShaderCache::ComputeKey(desc, "v1") == key);
+        CHECK(dependencies.size() == 3);
+
+        // Define order does not matter, everything else does.
+        ShaderDesc reordered = desc;
+        reordered.defines = { { "B", "2" }, { "A", "1" } };
+        CHECK(ShaderCache::ComputeKey(reordered, "v1") == key);
+
+        ShaderDesc changed = desc;
+        changed.defines[1].value = "3";
+        CHECK(ShaderCache::ComputeKey(changed, "v1") != key);
+        changed = desc;
+        changed.entryPoint = "other";
+        CHECK(ShaderCache::ComputeKey(changed, "v1") != key);
+        changed = desc;
+        changed.target = "ps_6_0";
+        CHECK(ShaderCache::ComputeKey(changed, "v1") != key);
+        changed = desc;
+        changed.debug = true;
+        CHECK(ShaderCache::ComputeKey(changed, "v1") != key);
+        CHECK(ShaderCache::ComputeKey(desc, "v2") != key);
+
+        // Editing the main file or any include changes the key.
+        WriteTextFile(dir / "include" / "shared.hlsli", "#define SHARED 2\n");
+        uint64_t includeKey = ShaderCache::ComputeKey(desc, "v1");
+        CHECK(includeKey != key);
+        WriteTextFile(dir / "common.hlsli", "#define COMMON 2\n");
+        uint64_t commonKey = ShaderCache::ComputeKey(desc, "v1");
+        CHECK(commonKey != includeKey && commonKey != key);
+        WriteTextFile(dir / "main.hlsl", "float4 main() : SV_Target { return 1; }\n");
+        CHECK(ShaderCache::ComputeKey(desc, "v1") != commonKey);
+
+        ShaderDesc missing = desc;
+        missing.path = dir / "missing.hlsl";
+        CHECK(ShaderCache::ComputeKey(missing, "v1") == 0);
+    }
+
+    void TestCacheFile()
+    {
+        std::filesystem::path dir = MakeTestDirectory("ShaderCacheFile");
+        const uint64_t key = 0x0123456789abcdefull;
+        std::vector<uint8_t> payload = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+        std::vector<uint8_t> read;
+        CHECK(!ShaderCache::ReadCacheFile(dir, key, "cso", read));
+        CHECK(ShaderCache::WriteCacheFile(dir, key, "cso", payload));
+        CHECK(ShaderCache::ReadCacheFile(dir, key, "cso", read));
+        CHECK(read == payload);
+        CHECK(!ShaderCache::ReadCacheFile(dir, key, "pso", read));
+
+        std::filesystem::path path = dir / (HashToString(key) + ".cso");
+        std::vector<uint8_t> file = ReadBytes(path);
+        CHECK(file.size() > payload.size());
+
+        // A file copied under another key is rejected.
+        const uint64_t otherKey = key + 1;
+        WriteFileAtomic(dir / (HashToString(otherKey) + ".cso"), file.data(), file.size());
+        CHECK(!ShaderCache::ReadCacheFile(dir, otherKey, "cso", read));
+
+        std::vector<uint8_t> corrupt = file;
+        corrupt.back() ^= 0xff;
+        WriteFileAtomic(path, corrupt.data(), corrupt.size());
+        CHECK(!ShaderCache::ReadCacheFile(dir, key, "cso", read));
+
+        WriteFileAtomic(path, file.data(), file.size() - 1);
+        CHECK(!ShaderCache::ReadCacheFile(dir, key, "cso", read));
+
+        WriteFileAtomic(path, file.data(), 8);
+        CHECK(!ShaderCache::ReadCacheFile(dir, key, "cso", read));
+
+        std::vector<uint8_t> badMagic = file;
+        badMagic[0] ^= 0xff;
+        WriteFileAtomic(path, badMagic.data(), badMagic.size());
+        CHECK(!ShaderCache::ReadCacheFile(dir, key, "cso", read));
+
+        CHECK(ShaderCache::WriteCacheFile(dir, key, "cso", {}));
+        CHECK(ShaderCache::ReadCacheFile(dir, key, "cso", read));
+        CHECK(read.empty());
+    }
+
+    void TestConcurrentWrites()
+    {
+        std::filesystem::path dir = MakeTestDirectory("ShaderCacheConcurrent");
+        std::filesystem::path path = dir / "shared.bin";
+
+        // Every writer uses its own temporary file, so each rename publishes
+        // one complete payload and every write succeeds.
+        const uint32_t c_ThreadCount = 8;
+        const uint32_t c_WriteCount = 50;
+        std::vector<std::thread> threads;
+        std::vector<uint32_t> failures(c_ThreadCount, 0);
+        for (uint32_t t = 0; t < c_ThreadCount; ++t)
+        {
+            threads.emplace_back([&, t]()
+            {
+                std::vector<uint8_t> data(64 << 10, static_cast<uint8_t>(t + 1));
+                for (uint32_t i = 0; i < c_WriteCount; ++i)
+                {
+                    failures[t] += WriteFileAtomic(path, data.data(), data.size()) ? 0 : 1;
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        for (uint32_t count : failures)
+        {
+            CHECK(count == 0);
+        }
+        std::vector<uint8_t> file = ReadBytes(path);
+        CHECK(file.size() == 64 << 10);
+        bool uniform = !file.empty();
+        for (uint8_t byte : file)
+        {
+            uniform = uniform && byte == file[0];
+        }
+        CHECK(uniform);
+
+        uint32_t leftovers = 0;
+        for (const auto& entry : std::filesystem::directory_iterator(dir))
+        {
+            leftovers += entry.path().filename() != "shared.bin" ? 1 : 0;
+        }
+        CHECK(leftovers == 0);
+    }
+
+    void TestCompileThroughCache()
+    {
+        std::filesystem::path dir = MakeTestDirectory("ShaderCacheCompile");
+        WriteTextFile(dir / "main.hlsl", "first");
+
+        ShaderDesc desc;
+        desc.path = dir / "main.hlsl";
+        desc.target = "ps_5_1";
+
+        JobSystem jobs(2);
+        std::vector<uint8_t> bytecode;
+        std::string errors;
+        {
+            ShaderCache cache(std::make_unique<EchoCompiler>(), jobs, dir / "cache");
+            ShaderHandle handle = cache.Request(desc);
+            CHECK(cache.Request(desc).index == handle.index);
+            cache.WaitAll();
+            CHECK(cache.GetStatus(handle) == ShaderStatus::Ready);
+            const std::vector<uint8_t>* result = cache.GetBytecode(handle);
+            CHECK(result && std::string(result->begin(), result->end()) == "first");
+            CHECK(cache.GetStats().compiled == 1);
+            CHECK(cache.GetStats().duplicates == 1);
+
+            WriteTextFile(dir / "main.hlsl", "second");
+            CHECK(cache.Compile(desc, bytecode, errors));
+            CHECK(std::string(bytecode.begin(), bytecode.end()) == "second");
+        }
+
+        // A new cache finds both results on disk and never compiles.
+        ShaderCache cache(std::make_unique<EchoCompiler>(), jobs, dir / "cache");
+        CHECK(cache.Compile(desc, bytecode, errors));
+        CHECK(std::string(bytecode.begin(), bytecode.end()) == "second");
+        WriteTextFile(dir / "main.hlsl", "first");
+        ShaderHandle handle = cache.Request(desc);
+        cache.Wait(handle);
+        const std::vector<uint8_t>* result = cache.GetBytecode(handle);
+        CHECK(result && std::string(result->begin(), result->end()) == "first");
+        CHECK(cache.GetStats().diskHits == 2);
+        CHECK(cache.GetStats().compiled == 0);
+    }
+}
+
+int main()
+{
+    TestComputeKey();
+    TestCacheFile();
+    TestConcurrentWrites();
+    TestCompileThroughCache();
+    return GetTestResult();
+}
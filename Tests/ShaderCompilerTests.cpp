@@ -0,0 +1,136 @@
+#include "Check.h"
+
+#include "ShaderCompiler.h"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+    struct ShaderCase
+    {
+        const char* file;
+        const char* entryPoint;
+        const char* target;
+    };
+
+    // Every shader the renderer builds. Shader model 5 targets are what the
+    // renderer asks for; DXC compiles them as 6.0.
+    const ShaderCase c_RendererShaders[] = {
+        { "Background.hlsl", "VSMain", "vs_5_1" },
+        { "Background.hlsl", "PSMain", "ps_5_1" },
+        { "CullInstances.hlsl", "main", "cs_5_1" },
+#if defined(DX12_PRACTICE_USE_DXC)
+        { "MeshletRender.hlsl", "ASMain", "as_6_5" },
+        { "MeshletRender.hlsl", "MSMain", "ms_6_5" },
+        { "MeshletRender.hlsl", "PSMain", "ps_6_5" },
+#endif
+    };
+
+    std::string ReadText(const std::filesystem::path& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        std::stringstream text;
+        text << file.rdbuf();
+        return text.str();
+    }
+
+    // DXBC and DXIL both come in a "DXBC" container.
+    bool IsShaderContainer(const std::vector<uint8_t>& bytecode)
+    {
+        return bytecode.size() > 32 && memcmp(bytecode.data(), "DXBC", 4) == 0;
+    }
+
+    void TestRendererShaders(ShaderCompiler& compiler)
+    {
+        const std::filesystem::path dir = DX12_PRACTICE_SHADER_DIR;
+        for (const ShaderCase& shader : c_RendererShaders)
+        {
+            ShaderDesc desc;
+            desc.path = dir / shader.file;
+            desc.entryPoint = shader.entryPoint;
+            desc.target = shader.target;
+            std::vector<uint8_t> bytecode;
+            std::string errors;
+            bool compiled = compiler.Compile(desc, ReadText(desc.path), bytecode, errors);
+            if (!compiled)
+            {
+                std::fprintf(stderr, "%s %s %s:\n%s\n", shader.file, shader.entryPoint, shader.target, errors.c_str());
+            }
+            CHECK(compiled && IsShaderContainer(bytecode));
+        }
+    }
+
+#if defined(DX12_PRACTICE_USE_DXC)
+    // Shader model 6 targets only exist in DXC.
+    void TestDefinesAndIncludes(ShaderCompiler& compiler)
+    {
+        std::filesystem::path dir = MakeTestDirectory("ShaderCompiler");
+        std::filesystem::create_directories(dir / "include");
+        WriteTextFile(dir / "include" / "color.hlsli", "float4 Color() { return float4(COLOR_VALUE, 0, 0, 1); }\n");
+        std::string source = "#include \"color.hlsli\"\nfloat4 main() : SV_Target { return Color(); }\n";
+
+        ShaderDesc desc;
+        desc.path = dir / "main.hlsl";
+        desc.target = "ps_6_0";
+        desc.includeDirs = { dir / "include" };
+        std::vector<uint8_t> bytecode;
+        std::string errors;
+
+        // The define is required by the include.
+        CHECK(!compiler.Compile(desc, source, bytecode, errors));
+        CHECK(!errors.empty());
+
+        desc.defines = { { "COLOR_VALUE", "0.5" } };
+        errors.clear();
+        CHECK(compiler.Compile(desc, source, bytecode, errors));
+        CHECK(IsShaderContainer(bytecode));
+        std::vector<uint8_t> release = bytecode;
+
+        // Debug builds embed their debug information.
+        desc.debug = true;
+        CHECK(compiler.Compile(desc, source, bytecode, errors));
+        CHECK(IsShaderContainer(bytecode) && bytecode.size() > release.size());
+    }
+
+    void TestErrors(ShaderCompiler& compiler)
+    {
+        ShaderDesc desc;
+        desc.path = "broken.hlsl";
+        desc.target = "ps_6_0";
+        std::vector<uint8_t> bytecode;
+        std::string errors;
+        CHECK(!compiler.Compile(desc, "float4 main() : SV_Target { return undefined; }\n", bytecode, errors));
+        CHECK(errors.find("undefined") != std::string::npos);
+
+        desc.entryPoint = "missing";
+        errors.clear();
+        CHECK(!compiler.Compile(desc, "float4 main() : SV_Target { return 0; }\n", bytecode, errors));
+        CHECK(!errors.empty());
+    }
+#endif
+}
+
+int main()
+{
+    std::unique_ptr<ShaderCompiler> compiler = CreateShaderCompiler();
+#if defined(DX12_PRACTICE_USE_DXC)
+    CHECK(compiler && compiler->GetVersion().compare(0, 4, "dxc-") == 0);
+#elif !defined(_WIN32)
+    // Nothing to compile with; the shader cache still serves cached blobs.
+    CHECK(!compiler);
+#endif
+    if (!compiler)
+    {
+        std::printf("No shader compiler in this build; compile checks skipped\n");
+        return GetTestResult();
+    }
+
+    TestRendererShaders(*compiler);
+#if defined(DX12_PRACTICE_USE_DXC)
+    TestDefinesAndIncludes(*compiler);
+    TestErrors(*compiler);
+#endif
+    return GetTestResult();
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Procedural meshes shared by the tests and benchmarks: float3 positions,
+// counter-clockwise triangles seen from outside (normal = cross(b - a, c - a)).
+struct TestMesh
+{
+    std::vector<float> positions;
+    std::vector<uint32_t> indices;
+
+    uint32_t GetVertexCount() const { return static_cast<uint32_t>(positions.size() / 3); }
+    uint32_t GetTriangleCount() const { return static_cast<uint32_t>(indices.size() / 3); }
+};
+
+// (cells + 1)^2 vertices on the unit square in xz, facing +y, with an open
+// border; bump adds a smooth height field.
+inline TestMesh MakeGridMesh(uint32_t cells, float bump = 0.0f)
+{
+    TestMesh mesh;
+    for (uint32_t z = 0; z <= cells; ++z)
+    {
+        for (uint32_t x = 0; x <= cells; ++x)
+        {
+            float u = static_cast<float>(x) / cells;
+            float v = static_cast<float>(z) / cells;
+            mesh.positions.insert(mesh.positions.end(), { u, bump * std::sin(u * 6.0f) * std::cos(v * 5.0f), v });
+        }
+    }
+    for (uint32_t z = 0; z < cells; ++z)
+    {
+        for (uint32_t x = 0; x < cells; ++x)
+        {
+            uint32_t i = z * (cells + 1) + x;
+            uint32_t right = i + 1;
+            uint32_t up = i + cells + 1;
+            mesh.indices.insert(mesh.indices.end(), { i, up, right, right, up, up + 1 });
+        }
+    }
+    return mesh;
+}
+
+// Unit sphere from rings x segments quads. The first and last column share
+// positions but are separate vertices, like a UV seam.
+inline TestMesh MakeSphereMesh(uint32_t rings, uint32_t segments)
+{
+    const float pi = 3.14159265f;
+    TestMesh mesh;
+    for (uint32_t ring = 0; ring <= rings; ++ring)
+    {
+        float theta = pi * ring / rings;
+        for (uint32_t segment = 0; segment <= segments; ++segment)
+        {
+            float phi = segment == segments ? 0.0f : 2.0f * pi * segment / segments;
+            mesh.positions.insert(mesh.positions.end(),
+                { std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) });
+        }
+    }
+    for (uint32_t ring = 0; ring < rings; ++ring)
+    {
+        for (uint32_t segment = 0; segment < segments; ++segment)
+        {
+            uint32_t i = ring * (segments + 1) + segment;
+            uint32_t below = i + segments + 1;
+            // Rings at the poles collapse to points; skip their degenerate halves.
+            if (ring != 0)
+            {
+                mesh.indices.insert(mesh.indices.end(), { i, i + 1, below });
+            }
+            if (ring != rings - 1)
+            {
+                mesh.indices.insert(mesh.indices.end(), { i + 1, below + 1, below });
+            }
+        }
+    }
+    return mesh;
+}
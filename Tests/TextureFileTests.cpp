@@ -0,0 +1,325 @@
+#include "Check.h"
+
+#include "DdsFormat.h"
+#include "TextureFile.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+    template<typename T>
+    void Append(std::string& bytes, const T& value)
+    {
+        bytes.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    // Data bytes count up so that subresources can be told apart.
+    void AppendData(std::string& bytes, uint64_t size)
+    {
+        for (uint64_t i = 0; i < size; ++i)
+        {
+            bytes += static_cast<char>(i * 7);
+        }
+    }
+
+    DdsHeader MakeDdsHeader(uint32_t width, uint32_t height, uint32_t depth, uint32_t mipCount)
+    {
+        DdsHeader header = {};
+        header.size = sizeof(DdsHeader);
+        header.flags = c_DdsFlagCaps | c_DdsFlagHeight | c_DdsFlagWidth | c_DdsFlagPixelFormat | c_DdsFlagMipMapCount;
+        header.width = width;
+        header.height = height;
+        header.depth = depth;
+        header.mipMapCount = mipCount;
+        header.pixelFormat.size = sizeof(DdsPixelFormat);
+        header.caps = c_DdsCapsTexture | (mipCount > 1 ? c_DdsCapsMipMap | c_DdsCapsComplex : 0);
+        return header;
+    }
+
+    DdsHeader MakeRgbaDdsHeader(uint32_t width, uint32_t height, uint32_t depth, uint32_t mipCount)
+    {
+        DdsHeader header = MakeDdsHeader(width, height, depth, mipCount);
+        header.pixelFormat.flags = c_DdsPixelRGB | c_DdsPixelAlpha;
+        header.pixelFormat.rgbBitCount = 32;
+        header.pixelFormat.rBitMask = 0xff;
+        header.pixelFormat.gBitMask = 0xff00;
+        header.pixelFormat.bBitMask = 0xff0000;
+        header.pixelFormat.aBitMask = 0xff000000;
+        return header;
+    }
+
+    std::string MakeDds(const DdsHeader& header, const DdsHeaderDxt10* dxt10, uint64_t dataSize)
+    {
+        std::string bytes;
+        Append(bytes, c_DdsMagic);
+        DdsHeader copy = header;
+        if (dxt10)
+        {
+            copy.pixelFormat.flags = c_DdsPixelFourCC;
+            copy.pixelFormat.fourCC = MakeDdsFourCC('D', 'X', '1', '0');
+        }
+        Append(bytes, copy);
+        if (dxt10)
+        {
+            Append(bytes, *dxt10);
+        }
+        AppendData(bytes, dataSize);
+        return bytes;
+    }
+
+    struct Ktx2Header
+    {
+        uint8_t identifier[12] = { 0xab, 'K', 'T', 'X', ' ', '2', '0', 0xbb, '\r', '\n', 0x1a, '\n' };
+        uint32_t vkFormat = 37;     // VK_FORMAT_R8G8B8A8_UNORM
+        uint32_t typeSize = 1;
+        uint32_t pixelWidth = 0;
+        uint32_t pixelHeight = 0;
+        uint32_t pixelDepth = 0;
+        uint32_t layerCount = 0;
+        uint32_t faceCount = 1;
+        uint32_t levelCount = 1;
+        uint32_t supercompressionScheme = 0;
+        uint32_t dfdByteOffset = 0;
+        uint32_t dfdByteLength = 0;
+        uint32_t kvdByteOffset = 0;
+        uint32_t kvdByteLength = 0;
+        uint64_t sgdByteOffset = 0;
+        uint64_t sgdByteLength = 0;
+    };
+
+    // Levels are stored smallest first, as KTX2 recommends; levelSizes holds
+    // the bytes of every level (all layers and faces).
+    std::string MakeKtx2(const Ktx2Header& header, const std::vector<uint64_t>& levelSizes)
+    {
+        std::string bytes;
+        Append(bytes, header);
+        uint64_t offset = sizeof(Ktx2Header) + 24 * levelSizes.size();
+        std::vector<uint64_t> offsets(levelSizes.size());
+        for (size_t level = levelSizes.size(); level-- > 0;)
+        {
+            offsets[level] = offset;
+            offset += levelSizes[level];
+        }
+        for (size_t level = 0; level < levelSizes.size(); ++level)
+        {
+            Append(bytes, offsets[level]);
+            Append(bytes, levelSizes[level]);
+            Append(bytes, levelSizes[level]);
+        }
+        for (size_t level = levelSizes.size(); level-- > 0;)
+        {
+            AppendData(bytes, levelSizes[level]);
+        }
+        return bytes;
+    }
+
+    bool OpenBytes(TextureFile& texture, const std::filesystem::path& path, const std::string& bytes, std::string* error = nullptr)
+    {
+        return WriteTextFile(path, bytes) && texture.Open(path, error);
+    }
+
+    // Offset of a subresource's data from the first one.
+    ptrdiff_t GetOffset(const TextureFile& texture, uint32_t subresource)
+    {
+        return texture.GetSubresource(subresource).data - texture.GetSubresource(0).data;
+    }
+
+    void TestFootprints()
+    {
+        TextureDesc desc;
+        desc.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        desc.width = 100;
+        desc.height = 60;
+        desc.mipCount = 2;
+        desc.arraySize = 2;
+
+        TextureFootprint footprints[4];
+        uint64_t size = ComputeTextureFootprints(desc, 0, 4, 0, footprints);
+        CHECK(footprints[0].offset == 0 && footprints[0].width == 100 && footprints[0].height == 60);
+        CHECK(footprints[0].rowSize == 400 && footprints[0].rowPitch == 512 && footprints[0].rowCount == 60);
+        CHECK(footprints[1].offset == 512 * 60 && footprints[1].width == 50 && footprints[1].rowPitch == 256);
+        // The next slice starts at the next placement boundary.
+        CHECK(footprints[2].offset == 38400 && footprints[2].width == 100);
+        CHECK(footprints[3].offset == 38400 + 30720 && footprints[3].rowCount == 30);
+        CHECK(size == 38400 + 30720 + 256 * 29 + 200);
+
+        // A base offset is aligned up before the first subresource.
+        CHECK(ComputeTextureFootprints(desc, 1, 1, 100, footprints) == 412 + 256 * 29 + 200);
+        CHECK(footprints[0].offset == 512);
+
+        // Block formats round up to whole blocks, down to one block per mip.
+        desc.format = DXGI_FORMAT_BC1_UNORM;
+        desc.width = 10;
+        desc.height = 10;
+        desc.mipCount = 4;
+        desc.arraySize = 1;
+        ComputeTextureFootprints(desc, 0, 4, 0, footprints);
+        CHECK(footprints[0].width == 12 && footprints[0].height == 12 && footprints[0].rowSize == 24 && footprints[0].rowCount == 3);
+        CHECK(footprints[3].width == 4 && footprints[3].height == 4 && footprints[3].rowSize == 8 && footprints[3].rowCount == 1);
+
+        // Volumes halve their depth as well and keep every slice's rows.
+        desc.dimension = TextureDimension::Texture3D;
+        desc.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        desc.width = 16;
+        desc.height = 8;
+        desc.depth = 4;
+        desc.mipCount = 3;
+        size = ComputeTextureFootprints(desc, 0, 3, 0, footprints);
+        CHECK(footprints[0].depth == 4 && footprints[1].depth == 2 && footprints[2].depth == 1);
+        CHECK(footprints[1].offset == 256 * 8 * 4);
+        CHECK(size == 8192 + 2048 + 256 + 16);
+
+        // Mips past 31 are 1x1, not an oversized shift.
+        desc.dimension = TextureDimension::Texture2D;
+        desc.width = 1;
+        desc.height = 1;
+        desc.depth = 1;
+        desc.mipCount = 40;
+        ComputeTextureFootprints(desc, 35, 1, 0, footprints);
+        CHECK(footprints[0].width == 1 && footprints[0].height == 1 && footprints[0].rowSize == 4);
+        desc.mipCount = 0;
+        CHECK(ComputeTextureFootprints(desc, 0, 1, 0, footprints) == 0);
+    }
+
+    void TestDdsLayouts()
+    {
+        std::filesystem::path dir = MakeTestDirectory("TextureFileDds");
+        TextureFile texture;
+        std::string error;
+
+        // Legacy header, full mip chain: 8x4, 4x2, 2x1, 1x1.
+        CHECK(OpenBytes(texture, dir / "rgba.dds", MakeDds(MakeRgbaDdsHeader(8, 4, 0, 4), nullptr, 128 + 32 + 8 + 4), &error));
+        CHECK(texture.GetDesc().format == DXGI_FORMAT_R8G8B8A8_UNORM && texture.GetSubresourceCount() == 4);
+        CHECK(texture.GetSubresource(0).rowPitch == 32 && texture.GetSubresource(0).slicePitch == 128);
+        CHECK(texture.GetSubresource(3).rowPitch == 4 && texture.GetSubresource(3).slicePitch == 4);
+        CHECK(GetOffset(texture, 1) == 128 && GetOffset(texture, 2) == 160 && GetOffset(texture, 3) == 168);
+        CHECK(texture.GetSubresource(1).data[0] == static_cast<uint8_t>(128 * 7));
+
+        // DX10 cube map: each face stores its whole mip chain in turn.
+        DdsHeaderDxt10 dxt10 = {};
+        dxt10.dxgiFormat = DXGI_FORMAT_BC1_UNORM;
+        dxt10.resourceDimension = c_DdsDimensionTexture2D;
+        dxt10.miscFlag = c_DdsMiscTextureCube;
+        dxt10.arraySize = 1;
+        CHECK(OpenBytes(texture, dir / "cube.dds", MakeDds(MakeDdsHeader(8, 8, 0, 2), &dxt10, 6 * (32 + 8)), &error));
+        CHECK(texture.GetDesc().cube && texture.GetDesc().arraySize == 6 && texture.GetSubresourceCount() == 12);
+        CHECK(texture.GetSubresource(0).rowPitch == 16 && texture.GetSubresource(0).slicePitch == 32);
+        CHECK(texture.GetSubresource(1).slicePitch == 8);
+        CHECK(GetOffset(texture, 1) == 32 && GetOffset(texture, 2) == 40 && GetOffset(texture, 11) == 5 * 40 + 32);
+
+        // Legacy volume: depth halves with the mips, up to the largest size.
+        DdsHeader volume = MakeRgbaDdsHeader(2, 2, 16, 5);
+        volume.caps2 = c_DdsCaps2Volume;
+        CHECK(OpenBytes(texture, dir / "volume.dds", MakeDds(volume, nullptr, 256 + 32 + 16 + 8 + 4), &error));
+        CHECK(texture.GetDesc().dimension == TextureDimension::Texture3D && texture.GetSubresourceCount() == 5);
+        CHECK(GetOffset(texture, 1) == 256 && GetOffset(texture, 2) == 288 && GetOffset(texture, 4) == 312);
+
+        // One byte short.
+        CHECK(!OpenBytes(texture, dir / "short.dds", MakeDds(MakeRgbaDdsHeader(8, 4, 0, 4), nullptr, 171), &error));
+        CHECK(!texture.IsOpen() && texture.GetSubresourceCount() == 0);
+    }
+
+    void TestKtx2Layouts()
+    {
+        std::filesystem::path dir = MakeTestDirectory("TextureFileKtx2");
+        TextureFile texture;
+        std::string error;
+
+        // 2D array: each level holds every layer, levels stored smallest first.
+        Ktx2Header header;
+        header.pixelWidth = 4;
+        header.pixelHeight = 4;
+        header.layerCount = 2;
+        header.levelCount = 3;
+        CHECK(OpenBytes(texture, dir / "array.ktx2", MakeKtx2(header, { 2 * 64, 2 * 16, 2 * 4 }), &error));
+        CHECK(texture.GetDesc().arraySize == 2 && texture.GetSubresourceCount() == 6);
+        CHECK(texture.GetSubresource(0).rowPitch == 16 && texture.GetSubresource(4).slicePitch == 16);
+        // Subresource mip + layer * 3; level 2 comes first in the file.
+        CHECK(GetOffset(texture, 2) == -(2 * 4 + 2 * 16));
+        CHECK(GetOffset(texture, 5) == -(2 * 4 + 2 * 16) + 4);
+        CHECK(GetOffset(texture, 1) == -(2 * 16) && GetOffset(texture, 4) == -(2 * 16) + 16);
+        CHECK(GetOffset(texture, 3) == 64);
+
+        Ktx2Header cube;
+        cube.vkFormat = 131;        // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+        cube.pixelWidth = 4;
+        cube.pixelHeight = 4;
+        cube.faceCount = 6;
+        CHECK(OpenBytes(texture, dir / "cube.ktx2", MakeKtx2(cube, { 6 * 8 }), &error));
+        CHECK(texture.GetDesc().cube && texture.GetDesc().arraySize == 6 && GetOffset(texture, 5) == 40);
+
+        Ktx2Header volume;
+        volume.pixelWidth = 4;
+        volume.pixelHeight = 2;
+        volume.pixelDepth = 2;
+        volume.levelCount = 3;
+        CHECK(OpenBytes(texture, dir / "volume.ktx2", MakeKtx2(volume, { 64, 8, 4 }), &error));
+        CHECK(texture.GetDesc().dimension == TextureDimension::Texture3D && texture.GetSubresource(0).slicePitch == 32);
+    }
+
+    void TestInvalidHeaders()
+    {
+        std::filesystem::path dir = MakeTestDirectory("TextureFileInvalid");
+        TextureFile texture;
+        std::string error;
+
+        // More mips than an 8x8 chain has, or than 32-bit sizes allow.
+        for (uint32_t mipCount : { 5u, 33u, 0xffffffffu })
+        {
+            error.clear();
+            CHECK(!OpenBytes(texture, dir / "mips.dds", MakeDds(MakeRgbaDdsHeader(8, 8, 0, mipCount), nullptr, 1 << 16), &error));
+            CHECK(!error.empty());
+        }
+        CHECK(!OpenBytes(texture, dir / "huge.dds", MakeDds(MakeRgbaDdsHeader(0xffffffffu, 1, 0, 33), nullptr, 64), &error));
+
+        DdsHeaderDxt10 dxt10 = {};
+        dxt10.dxgiFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+        dxt10.resourceDimension = c_DdsDimensionTexture2D;
+        dxt10.arraySize = 0xffffffffu;
+        CHECK(!OpenBytes(texture, dir / "array.dds", MakeDds(MakeDdsHeader(1, 1, 0, 1), &dxt10, 64), &error));
+        dxt10.arraySize = c_TextureMaxArraySize + 1;
+        CHECK(!OpenBytes(texture, dir / "array.dds", MakeDds(MakeDdsHeader(1, 1, 0, 1), &dxt10, 4 * dxt10.arraySize), &error));
+        dxt10.resourceDimension = c_DdsDimensionTexture1D;
+        CHECK(!OpenBytes(texture, dir / "array.dds", MakeDds(MakeDdsHeader(1, 1, 0, 1), &dxt10, 4 * dxt10.arraySize), &error));
+
+        // Cube maps count six faces per layer: 341 cubes fit, 342 do not,
+        // and the multiplication cannot wrap around.
+        dxt10.resourceDimension = c_DdsDimensionTexture2D;
+        dxt10.miscFlag = c_DdsMiscTextureCube;
+        dxt10.arraySize = c_TextureMaxArraySize / 6;
+        CHECK(OpenBytes(texture, dir / "cubes.dds", MakeDds(MakeDdsHeader(1, 1, 0, 1), &dxt10, 4 * 6 * dxt10.arraySize), &error));
+        CHECK(texture.GetSubresourceCount() == 6 * 341);
+        dxt10.arraySize += 1;
+        CHECK(!OpenBytes(texture, dir / "cubes.dds", MakeDds(MakeDdsHeader(1, 1, 0, 1), &dxt10, 4 * 6 * dxt10.arraySize), &error));
+        dxt10.arraySize = 0x2aaaaaab;   // times six wraps to 2
+        CHECK(!OpenBytes(texture, dir / "cubes.dds", MakeDds(MakeDdsHeader(1, 1, 0, 1), &dxt10, 64), &error));
+
+        Ktx2Header header;
+        header.pixelWidth = 16;
+        header.pixelHeight = 16;
+        header.levelCount = 6;
+        CHECK(!OpenBytes(texture, dir / "levels.ktx2", MakeKtx2(header, { 1024, 256, 64, 16, 4, 4 }), &error));
+        header.levelCount = 40;
+        CHECK(!OpenBytes(texture, dir / "levels.ktx2", MakeKtx2(header, std::vector<uint64_t>(40, 4)), &error));
+
+        header.levelCount = 1;
+        header.faceCount = 6;
+        header.layerCount = 0x2aaaaaab;
+        CHECK(!OpenBytes(texture, dir / "layers.ktx2", MakeKtx2(header, { 1024 }), &error));
+        header.faceCount = 3;
+        header.layerCount = 0;
+        CHECK(!OpenBytes(texture, dir / "faces.ktx2", MakeKtx2(header, { 1024 }), &error));
+        CHECK(!texture.IsOpen());
+    }
+}
+
+int main()
+{
+    TestFootprints();
+    TestDdsLayouts();
+    TestKtx2Layouts();
+    TestInvalidHeaders();
+    return GetTestResult();
+}
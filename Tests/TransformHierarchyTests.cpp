@@ -0,0 +1,215 @@
+#include "Check.h"
+
+#include "JobSystem.h"
+#include "TransformHierarchy.h"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+    const float c_Identity[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    const float c_One[3] = { 1.0f, 1.0f, 1.0f };
+
+    bool HasTranslation(const TransformMatrix& world, float x, float y, float z)
+    {
+        const float epsilon = 1e-5f;
+        return std::fabs(world.m[3][0] - x) < epsilon && std::fabs(world.m[3][1] - y) < epsilon &&
+            std::fabs(world.m[3][2] - z) < epsilon;
+    }
+
+    void SetPosition(TransformHierarchy& hierarchy, TransformHandle handle, float x, float y, float z)
+    {
+        const float position[3] = { x, y, z };
+        hierarchy.SetPosition(handle, position);
+    }
+
+    void TestPropagation()
+    {
+        TransformHierarchy hierarchy;
+        TransformHandle root = hierarchy.Create();
+        TransformHandle child = hierarchy.Create(root);
+        TransformHandle grandchild = hierarchy.Create(child);
+        TransformHandle sibling = hierarchy.Create(root);
+
+        SetPosition(hierarchy, root, 1.0f, 2.0f, 3.0f);
+        SetPosition(hierarchy, child, 1.0f, 0.0f, 0.0f);
+        SetPosition(hierarchy, grandchild, 0.0f, 0.0f, 1.0f);
+        hierarchy.Update(nullptr);
+
+        CHECK(hierarchy.WasRebuilt());
+        CHECK(hierarchy.GetChanged().size() == 4);
+        CHECK(HasTranslation(hierarchy.GetWorld(root), 1.0f, 2.0f, 3.0f));
+        CHECK(HasTranslation(hierarchy.GetWorld(child), 2.0f, 2.0f, 3.0f));
+        CHECK(HasTranslation(hierarchy.GetWorld(grandchild), 2.0f, 2.0f, 4.0f));
+        CHECK(HasTranslation(hierarchy.GetWorld(sibling), 1.0f, 2.0f, 3.0f));
+
+        // Parents precede their children.
+        CHECK(hierarchy.GetIndex(root) < hierarchy.GetIndex(child));
+        CHECK(hierarchy.GetIndex(child) < hierarchy.GetIndex(grandchild));
+
+        // Nothing changed, nothing recomputed.
+        hierarchy.Update(nullptr);
+        CHECK(!hierarchy.WasRebuilt());
+        CHECK(hierarchy.GetChanged().empty());
+
+        // A moved node recomputes its subtree only.
+        SetPosition(hierarchy, child, 0.0f, 1.0f, 0.0f);
+        hierarchy.Update(nullptr);
+        std::vector<uint32_t> expected = { hierarchy.GetIndex(child), hierarchy.GetIndex(grandchild) };
+        CHECK(hierarchy.GetChanged() == expected);
+        CHECK(HasTranslation(hierarchy.GetWorld(grandchild), 1.0f, 3.0f, 4.0f));
+
+        // Rotating the root by 90 degrees about y turns +x into -z (row
+        // vectors, as XMMatrixRotationY); scale applies before rotation.
+        const float half = std::sqrt(0.5f);
+        const float rotation[4] = { 0.0f, half, 0.0f, half };
+        const float position[3] = { 1.0f, 2.0f, 3.0f };
+        const float scale[3] = { 2.0f, 2.0f, 2.0f };
+        hierarchy.SetLocal(root, position, rotation, scale);
+        SetPosition(hierarchy, child, 1.0f, 0.0f, 0.0f);
+        hierarchy.Update(nullptr);
+        CHECK(hierarchy.GetChanged().size() == 4);
+        CHECK(HasTranslation(hierarchy.GetWorld(child), 1.0f, 2.0f, 1.0f));
+        // Grandchild +z becomes +x.
+        CHECK(HasTranslation(hierarchy.GetWorld(grandchild), 3.0f, 2.0f, 1.0f));
+        CHECK(std::fabs(hierarchy.GetWorld(child).m[0][2] + 2.0f) < 1e-5f);
+    }
+
+    void TestReparent()
+    {
+        TransformHierarchy hierarchy;
+        TransformHandle a = hierarchy.Create();
+        TransformHandle b = hierarchy.Create();
+        TransformHandle child = hierarchy.Create(a);
+        TransformHandle grandchild = hierarchy.Create(child);
+        SetPosition(hierarchy, a, 10.0f, 0.0f, 0.0f);
+        SetPosition(hierarchy, b, 0.0f, 10.0f, 0.0f);
+        SetPosition(hierarchy, child, 1.0f, 0.0f, 0.0f);
+        SetPosition(hierarchy, grandchild, 0.0f, 0.0f, 1.0f);
+        hierarchy.Update(nullptr);
+        CHECK(HasTranslation(hierarchy.GetWorld(grandchild), 11.0f, 0.0f, 1.0f));
+
+        // The subtree follows its new parent.
+        CHECK(hierarchy.SetParent(child, b));
+        hierarchy.Update(nullptr);
+        CHECK(hierarchy.WasRebuilt());
+        CHECK(HasTranslation(hierarchy.GetWorld(child), 1.0f, 10.0f, 0.0f));
+        CHECK(HasTranslation(hierarchy.GetWorld(grandchild), 1.0f, 10.0f, 1.0f));
+        SetPosition(hierarchy, a, 20.0f, 0.0f, 0.0f);
+        hierarchy.Update(nullptr);
+        CHECK(hierarchy.GetChanged().size() == 1);
+
+        // No cycles.
+        CHECK(!hierarchy.SetParent(b, grandchild));
+        CHECK(!hierarchy.SetParent(child, child));
+
+        // Deeper under a chain, then back to the root: depths follow.
+        CHECK(hierarchy.SetParent(b, a));
+        hierarchy.Update(nullptr);
+        CHECK(HasTranslation(hierarchy.GetWorld(grandchild), 21.0f, 10.0f, 1.0f));
+        CHECK(hierarchy.GetIndex(a) < hierarchy.GetIndex(b));
+        CHECK(hierarchy.GetIndex(b) < hierarchy.GetIndex(child));
+        CHECK(hierarchy.GetIndex(child) < hierarchy.GetIndex(grandchild));
+
+        CHECK(hierarchy.SetParent(child, {}));
+        hierarchy.Update(nullptr);
+        CHECK(HasTranslation(hierarchy.GetWorld(child), 1.0f, 0.0f, 0.0f));
+        CHECK(HasTranslation(hierarchy.GetWorld(grandchild), 1.0f, 0.0f, 1.0f));
+    }
+
+    void TestDestroy()
+    {
+        TransformHierarchy hierarchy;
+        TransformHandle root = hierarchy.Create();
+        TransformHandle child = hierarchy.Create(root);
+        TransformHandle grandchild = hierarchy.Create(child);
+        TransformHandle other = hierarchy.Create();
+        SetPosition(hierarchy, other, 5.0f, 0.0f, 0.0f);
+        hierarchy.Update(nullptr);
+
+        hierarchy.Destroy(child);
+        hierarchy.Update(nullptr);
+        CHECK(hierarchy.GetCount() == 2);
+        CHECK(hierarchy.GetIndex(child) == UINT32_MAX);
+        CHECK(hierarchy.GetIndex(grandchild) == UINT32_MAX);
+        CHECK(HasTranslation(hierarchy.GetWorld(other), 5.0f, 0.0f, 0.0f));
+
+        // Freed handles are reused.
+        TransformHandle reused = hierarchy.Create(other);
+        CHECK(reused.id == child.id || reused.id == grandchild.id);
+        hierarchy.Update(nullptr);
+        CHECK(HasTranslation(hierarchy.GetWorld(reused), 5.0f, 0.0f, 0.0f));
+        CHECK(hierarchy.GetCount() == 3);
+    }
+
+    // The job system splits levels into ranges; the result must not depend
+    // on it.
+    void TestJobs()
+    {
+        std::mt19937 random(3);
+        std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+
+        TransformHierarchy serial;
+        TransformHierarchy parallel;
+        std::vector<TransformHandle> handles;
+        for (uint32_t i = 0; i < 20000; ++i)
+        {
+            TransformHandle parent;
+            if (i >= 16)
+            {
+                parent = handles[std::uniform_int_distribution<uint32_t>(0, i - 1)(random)];
+            }
+            TransformHandle handle = serial.Create(parent);
+            CHECK(parallel.Create(parent).id == handle.id);
+            handles.push_back(handle);
+
+            const float position[3] = { value(random), value(random), value(random) };
+            float rotation[4] = { value(random), value(random), value(random), value(random) };
+            float length = std::sqrt(rotation[0] * rotation[0] + rotation[1] * rotation[1] +
+                rotation[2] * rotation[2] + rotation[3] * rotation[3]);
+            for (float& component : rotation)
+            {
+                component /= length;
+            }
+            serial.SetLocal(handle, position, rotation, c_One);
+            parallel.SetLocal(handle, position, rotation, c_One);
+        }
+
+        JobSystem jobs(3);
+        serial.Update(nullptr);
+        parallel.Update(&jobs);
+        for (int frame = 0; frame < 2; ++frame)
+        {
+            for (uint32_t i = 0; i < 100; ++i)
+            {
+                TransformHandle handle = handles[random() % handles.size()];
+                const float position[3] = { value(random), value(random), value(random) };
+                serial.SetLocal(handle, position, c_Identity, c_One);
+                parallel.SetLocal(handle, position, c_Identity, c_One);
+            }
+            serial.Update(nullptr);
+            parallel.Update(&jobs);
+            CHECK(serial.GetChanged() == parallel.GetChanged());
+            CHECK(serial.GetChanged().size() >= 100 && serial.GetChanged().size() < handles.size());
+        }
+
+        bool same = true;
+        for (TransformHandle handle : handles)
+        {
+            same &= std::memcmp(&serial.GetWorld(handle), &parallel.GetWorld(handle), sizeof(TransformMatrix)) == 0;
+        }
+        CHECK(same);
+    }
+}
+
+int main()
+{
+    TestPropagation();
+    TestReparent();
+    TestDestroy();
+    TestJobs();
+    return GetTestResult();
+}
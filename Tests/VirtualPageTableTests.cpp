@@ -0,0 +1,256 @@
+#include "Check.h"
+
+#include "VirtualPageTable.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    // Maps everything requested this frame and marks it resident.
+    std::vector<VirtualPageMapping> Load(VirtualPageTable& table, uint32_t maxMappings = 64, uint32_t protectFrames = 1)
+    {
+        std::vector<VirtualPageMapping> mappings;
+        table.Update(maxMappings, protectFrames, mappings);
+        for (const auto& mapping : mappings)
+        {
+            table.MarkResident(mapping.page);
+        }
+        return mappings;
+    }
+
+    void TestCoordinates()
+    {
+        // 6x3 pages: the mips are 6x3, 3x2, 2x1 and 1x1 pages.
+        VirtualPageTable table(6, 3, 4, 8);
+        CHECK(table.GetMipWidth(1) == 3 && table.GetMipHeight(1) == 2);
+        CHECK(table.GetMipWidth(2) == 2 && table.GetMipHeight(2) == 1);
+        CHECK(table.GetMipWidth(3) == 1 && table.GetMipHeight(3) == 1);
+
+        uint32_t page = 0;
+        for (uint32_t mip = 0; mip < table.GetMipCount(); ++mip)
+        {
+            for (uint32_t y = 0; y < table.GetMipHeight(mip); ++y)
+            {
+                for (uint32_t x = 0; x < table.GetMipWidth(mip); ++x, ++page)
+                {
+                    uint32_t pageMip, pageX, pageY;
+                    CHECK(table.GetPage(mip, x, y) == page);
+                    table.GetPageCoordinates(page, pageMip, pageX, pageY);
+                    CHECK(pageMip == mip && pageX == x && pageY == y);
+                }
+            }
+        }
+        CHECK(page == 18 + 6 + 2 + 1);
+    }
+
+    void TestRequests()
+    {
+        VirtualPageTable table(6, 3, 4, 8);
+        table.BeginFrame(1);
+
+        // The corner page pulls in the pages above it in every coarser mip,
+        // each once.
+        table.Request(table.GetPage(0, 5, 2));
+        table.Request(table.GetPage(0, 5, 2));
+        table.Request(table.GetPage(1, 2, 1));
+        std::vector<VirtualPageMapping> mappings;
+        table.Update(2, 1, mappings);
+
+        // Coarsest first, limited to maxMappings; slots come from the pool.
+        CHECK(mappings.size() == 2);
+        CHECK(mappings[0].page == table.GetPage(3, 0, 0) && mappings[1].page == table.GetPage(2, 1, 0));
+        CHECK(mappings[0].slot != mappings[1].slot && mappings[0].slot < 8 && mappings[1].slot < 8);
+        CHECK(mappings[0].evictedPage == VirtualPageTable::c_NoPage);
+        CHECK(table.GetSlot(mappings[0].page) == mappings[0].slot);
+
+        // Loading pages are not resident and are not requested again.
+        CHECK(!table.IsResident(mappings[0].page) && table.GetResidentCount() == 0);
+        for (const auto& mapping : mappings)
+        {
+            table.MarkResident(mapping.page);
+        }
+        CHECK(table.GetResidentCount() == 2);
+
+        // Pages over the limit were dropped; the next request maps them.
+        table.BeginFrame(2);
+        table.Request(table.GetPage(0, 5, 2));
+        mappings = Load(table);
+        CHECK(mappings.size() == 2);
+        CHECK(mappings[0].page == table.GetPage(1, 2, 1) && mappings[1].page == table.GetPage(0, 5, 2));
+        CHECK(table.GetResidentCount() == 4);
+
+        table.BeginFrame(3);
+        table.Request(table.GetPage(0, 5, 2));
+        CHECK(Load(table).empty());
+    }
+
+    void TestFeedback()
+    {
+        VirtualPageTable table(8, 8, 1, 16);
+        table.BeginFrame(1);
+        const uint32_t none = VirtualPageTable::c_NoFeedback;
+        std::vector<uint32_t> feedback = {
+            none, none,
+            VirtualPageTable::EncodeFeedback(0, 1, 2),
+            VirtualPageTable::EncodeFeedback(0, 1, 2),
+            none,
+            VirtualPageTable::EncodeFeedback(0, 7, 7),
+            VirtualPageTable::EncodeFeedback(0, 1, 2),     // again after another page
+            VirtualPageTable::EncodeFeedback(1, 0, 0),     // mip out of range
+            VirtualPageTable::EncodeFeedback(0, 8, 0),     // x out of range
+            VirtualPageTable::EncodeFeedback(0, 0, 8),     // y out of range
+        };
+        table.RequestFeedback(feedback.data(), feedback.size());
+
+        auto mappings = Load(table);
+        std::vector<uint32_t> pages;
+        for (const auto& mapping : mappings)
+        {
+            pages.push_back(mapping.page);
+        }
+        CHECK(pages == std::vector<uint32_t>({ table.GetPage(0, 7, 7), table.GetPage(0, 1, 2) }));
+
+        // Coordinates use 12 bits each.
+        CHECK(VirtualPageTable::EncodeFeedback(3, 4095, 17) == (3u << 24 | 17u << 12 | 4095u));
+    }
+
+    void TestEviction()
+    {
+        // One mip of 8 pages, 4 slots.
+        VirtualPageTable table(8, 1, 1, 4);
+        table.BeginFrame(1);
+        for (uint32_t page = 0; page < 4; ++page)
+        {
+            table.Request(page);
+        }
+        CHECK(Load(table).size() == 4);
+        uint32_t slot0 = table.GetSlot(0);
+
+        // Page 0 becomes the least recently used.
+        table.BeginFrame(2);
+        table.Request(3);
+        table.Request(1);
+        table.Request(2);
+        CHECK(Load(table).empty());
+
+        // Requested within protectFrames: nothing is evicted, page 4 waits.
+        table.BeginFrame(3);
+        table.Request(4);
+        std::vector<VirtualPageMapping> mappings;
+        table.Update(8, 3, mappings);
+        CHECK(mappings.empty());
+        CHECK(table.IsResident(0));
+
+        // Old enough: page 0 gives up its slot.
+        table.Request(4);
+        table.Update(8, 2, mappings);
+        CHECK(mappings.size() == 1);
+        CHECK(mappings[0].page == 4 && mappings[0].evictedPage == 0 && mappings[0].slot == slot0);
+        CHECK(!table.IsResident(0) && table.GetSlot(0) == VirtualPageTable::c_NoPage);
+        CHECK(table.GetResidentCount() == 3);
+
+        // Page 4 is loading and the most recent; the next victim is page 3,
+        // the least recently requested of the resident ones. A loading page
+        // is never evicted.
+        table.BeginFrame(10);
+        table.Request(5);
+        table.Request(6);
+        table.Request(7);
+        table.Request(0);
+        table.Update(8, 1, mappings);
+        CHECK(mappings.size() == 3);
+        CHECK(mappings[0].evictedPage == 3 && mappings[1].evictedPage == 1 && mappings[2].evictedPage == 2);
+        for (const auto& mapping : mappings)
+        {
+            CHECK(mapping.evictedPage != 4);
+        }
+        CHECK(table.GetSlot(4) != VirtualPageTable::c_NoPage);
+        CHECK(table.GetResidentCount() == 0);
+    }
+
+    void TestCancelLoad()
+    {
+        VirtualPageTable table(4, 1, 1, 1);
+        table.BeginFrame(1);
+        table.Request(2);
+        std::vector<VirtualPageMapping> mappings;
+        table.Update(4, 1, mappings);
+        CHECK(mappings.size() == 1);
+
+        // The slot goes back to the pool and the page can be requested again.
+        table.CancelLoad(2);
+        CHECK(table.GetSlot(2) == VirtualPageTable::c_NoPage && !table.IsResident(2));
+        table.MarkResident(2);
+        CHECK(table.GetResidentCount() == 0);
+
+        table.BeginFrame(2);
+        table.Request(1);
+        table.Update(4, 1, mappings);
+        CHECK(mappings.size() == 1 && mappings[0].page == 1 && mappings[0].evictedPage == VirtualPageTable::c_NoPage);
+
+        table.Request(2);
+        table.Update(4, 0, mappings);
+        CHECK(mappings.empty());
+    }
+
+    void TestMinMipMap()
+    {
+        VirtualPageTable table(4, 4, 3, 16);
+        std::vector<uint8_t> map;
+        table.BuildMinMipMap(map);
+        CHECK(map == std::vector<uint8_t>(16, 3));
+
+        // Requesting a mip 0 page loads its whole chain.
+        table.BeginFrame(1);
+        table.Request(table.GetPage(0, 0, 0));
+        Load(table);
+        table.BuildMinMipMap(map);
+        CHECK(map[0] == 0);
+        CHECK(map[1] == 1 && map[4] == 1 && map[5] == 1);
+        CHECK(map[2] == 2 && map[15] == 2);
+
+        // A mip 0 page without its mip 1 parent stays at the coarser mip.
+        table.Request(table.GetPage(1, 1, 1));
+        Load(table);
+        table.Request(table.GetPage(0, 3, 0));
+        std::vector<VirtualPageMapping> mappings;
+        table.Update(16, 1, mappings);
+        for (const auto& mapping : mappings)
+        {
+            if (mapping.page != table.GetPage(1, 1, 0))
+            {
+                table.MarkResident(mapping.page);
+            }
+        }
+        CHECK(table.IsResident(table.GetPage(0, 3, 0)) && !table.IsResident(table.GetPage(1, 1, 0)));
+        table.BuildMinMipMap(map);
+        CHECK(map[3] == 2);
+        CHECK(map[15] == 1 && map[10] == 1);
+
+        // Odd page grids: every page has a parent.
+        VirtualPageTable odd(6, 3, 3, 64);
+        odd.BeginFrame(1);
+        for (uint32_t y = 0; y < 3; ++y)
+        {
+            for (uint32_t x = 0; x < 6; ++x)
+            {
+                odd.Request(odd.GetPage(0, x, y));
+            }
+        }
+        CHECK(Load(odd).size() == 18 + 6 + 2);
+        odd.BuildMinMipMap(map);
+        CHECK(map == std::vector<uint8_t>(18, 0));
+    }
+}
+
+int main()
+{
+    TestCoordinates();
+    TestRequests();
+    TestFeedback();
+    TestEviction();
+    TestCancelLoad();
+    TestMinMipMap();
+    return GetTestResult();
+}